@@ -0,0 +1,10 @@
+include ( acquamanCommon.pri )
+
+QT += testlib
+TARGET = AcquamanBenchmark
+
+HEADERS += \
+	source/tests/BenchmarkDataman.h
+
+SOURCES += \
+	source/tests/benchmarkMain.cpp
@@ -683,7 +683,32 @@ HEADERS += source/acquaman/AMAcqScanOutput.h \
     source/analysis/AM4DBinningAB.h \
     source/analysis/AM4DBinningABEditor.h \
     source/analysis/AMOrderReductionAB.h \
-    source/analysis/AMOrderReductionABEditor.h
+    source/analysis/AMOrderReductionABEditor.h \
+	source/actions3/AMActionLogQueue3.h \
+	source/actions3/actions/AMContinuousRegionActionInfo.h \
+	source/acquaman/AMContinuousMoveScanOptimizer.h \
+	source/util/AMBufferedTextWriter.h \
+	source/dataman/export/AMExporterBinary.h \
+	source/dataman/export/AMExporterOptionBinary.h \
+	source/util/AMSlidingWindow.h \
+	source/dataman/datasource/AMDataSourceThumbnailRenderer.h \
+	source/dataman/database/AMDbSearchIndex.h \
+	source/ui/beamline/AMBeamlineConnectionView.h \
+	source/analysis/AMExternalScanDataCache.h \
+	source/acquaman/AMAcqPointRecord.h \
+	source/dataman/database/AMDbMigration.h \
+	source/analysis/AMRegionOfInterestEngine.h \
+	source/analysis/AMRegionOfInterestAB.h \
+	source/util/AMLockFreeRing.h \
+	source/dataman/datastore/AMCompressedSpectrumDataStore.h \
+	source/dataman/AMScanJournal.h \
+	source/beamline/AMReplayControl.h \
+	source/beamline/AMReplayDetector.h \
+	source/acquaman/AMScanReplay.h \
+	source/dataman/datasource/AMDataSourceSnapshot.h \
+	source/analysis/AMThreadedAnalysisBlock.h \
+	source/actions3/actions/AMContinuousRegionReadAction.h \
+	source/acquaman/CLS/CLSMAXvMotorContinuousMoveScanOptimizer.h
 
 # OS-specific files:
 linux-g++|linux-g++-32|linux-g++-64 {
@@ -1151,7 +1176,31 @@ SOURCES += source/acquaman/AMAcqScanOutput.cpp \
     source/analysis/AM4DBinningAB.cpp \
     source/analysis/AM4DBinningABEditor.cpp \
     source/analysis/AMOrderReductionAB.cpp \
-    source/analysis/AMOrderReductionABEditor.cpp
+    source/analysis/AMOrderReductionABEditor.cpp \
+	source/actions3/AMActionLogQueue3.cpp \
+	source/actions3/actions/AMContinuousRegionActionInfo.cpp \
+	source/acquaman/AMContinuousMoveScanOptimizer.cpp \
+	source/util/AMBufferedTextWriter.cpp \
+	source/dataman/export/AMExporterBinary.cpp \
+	source/dataman/export/AMExporterOptionBinary.cpp \
+	source/util/AMSlidingWindow.cpp \
+	source/dataman/datasource/AMDataSourceThumbnailRenderer.cpp \
+	source/dataman/database/AMDbSearchIndex.cpp \
+	source/ui/beamline/AMBeamlineConnectionView.cpp \
+	source/analysis/AMExternalScanDataCache.cpp \
+	source/acquaman/AMAcqPointRecord.cpp \
+	source/dataman/database/AMDbMigration.cpp \
+	source/analysis/AMRegionOfInterestEngine.cpp \
+	source/analysis/AMRegionOfInterestAB.cpp \
+	source/dataman/datastore/AMCompressedSpectrumDataStore.cpp \
+	source/dataman/AMScanJournal.cpp \
+	source/beamline/AMReplayControl.cpp \
+	source/beamline/AMReplayDetector.cpp \
+	source/acquaman/AMScanReplay.cpp \
+	source/dataman/datasource/AMDataSourceSnapshot.cpp \
+	source/analysis/AMThreadedAnalysisBlock.cpp \
+	source/actions3/actions/AMContinuousRegionReadAction.cpp \
+	source/acquaman/CLS/CLSMAXvMotorContinuousMoveScanOptimizer.cpp
 
 # OS-specific files
 linux-g++|linux-g++-32|linux-g++-64 {
@@ -10,6 +10,7 @@ SUBDIRS +=	pluginProjects/FileLoaders/AMFileLoaderPlugins.pro \
 	SGMAcquaman.pro \
 	BareBonesAcquaman.pro \
 	acquamanTest.pro \
+	acquamanBenchmark.pro \
 	VESPERSAcquaman.pro \
 	# VESPERSDataman.pro \
 	# AcquaCam.pro \
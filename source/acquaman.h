@@ -27,6 +27,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QEvent>
 #include <QDateTime>
 
+#include "acquaman/AMAcqPointRecord.h"
+
 /// This namespace contains global definitions for the Acquaman / Dataman framework.
 
 namespace AM {
@@ -52,13 +54,15 @@ namespace AM {
 
 }
 
+/// Posted by the dacq output handler (AMAcqScanSpectrumOutput) to the scan controller for every scan point.
 class AMAcqEvent : public QEvent{
 public:
 	AMAcqEvent() : QEvent( (QEvent::Type)AM::AcqEvent)
 	{}
 
-	QMap<int, double> dataPackage_;
-	QMap<int, QList<double> > spectraPackage_;
+	/// The scalar and spectrum values of the point, by column
+	AMAcqPointRecord record_;
+	/// Values recorded by the second dacq event (ex: the SGM fast scan's encoder start point), by column
 	QMap<int, double> extraPackage_;
 };
 
@@ -134,6 +134,10 @@ bool AM2DDacqScanController::startImplementation()
 			flushToDiskTimer_.start();
 		}
 
+		// Write the .dat and _spectra.dat files from a background thread about once a second, instead of flushing after every point.  Everything is written before the dacq reports that it stopped.
+		abop->setProperty( "Flush Policy", "Time");
+		abop->setProperty( "Spectrum:Flush Policy", "Time");
+
 		((AMAcqScanSpectrumOutput*)abop)->setScan(scan_);
 		((AMAcqScanSpectrumOutput*)abop)->setScanController(this);
 
@@ -151,42 +155,19 @@ bool AM2DDacqScanController::event(QEvent *e)
 	// This makes sure that the data is put in the appropriate location.
 	if(e->type() == (QEvent::Type)AM::AcqEvent){
 
-		QMap<int, double> aeData = ((AMAcqEvent*)e)->dataPackage_;
-		QMap<int, QList<double> > aeSpectra = ((AMAcqEvent*)e)->spectraPackage_;
-		QMap<int, double>::const_iterator i = aeData.constBegin();
-		QMap<int, QList<double> >::const_iterator j = aeSpectra.constBegin();
+		const AMAcqPointRecord &record = ((AMAcqEvent*)e)->record_;
 
-		if(i.key() == 0 && aeData.count() > 1){
+		if(record.hasScalar(0) && record.scalarCount() > 1){
 
-			AMnDIndex insertIndex = toScanIndex(aeData);
+			AMnDIndex insertIndex = toScanIndex(record);
 			// MB: Modified May 13 2012 for changes to AMDataStore. Assumes data store already has sufficient space for scan axes beyond the first axis.
 //			scan_->rawData()->beginInsertRowsAsNecessaryForScanPoint(insertIndex);
 			if(insertIndex.i() >= scan_->rawData()->scanSize(0))
 				scan_->rawData()->beginInsertRows(insertIndex.i()-scan_->rawData()->scanSize(0)+1, -1);
 			////////////////
 
-			// Because this is a 2D specific scan controller, I am forcing the format to be a certain way.
-			scan_->rawData()->setAxisValue(0, insertIndex.i(), i.value());
-			++i;
-			scan_->rawData()->setAxisValue(1, insertIndex.j(), i.value());
-			++i;
-
-			while(i != aeData.constEnd()){
-				scan_->rawData()->setValue(insertIndex, i.key()-2, AMnDIndex(), i.value());
-				++i;
-			}
-
-//			while(j != aeSpectra.constEnd()){
-//				for(int x = 0; x < j.value().count(); x++)
-//					scan_->rawData()->setValue(insertIndex, j.key()-2, AMnDIndex(x), j.value().at(x));
-//				++j;
-//			}
-			while(j != aeSpectra.constEnd()){
-
-				QVector<double> data = j.value().toVector();
-				scan_->rawData()->setValue(insertIndex, j.key()-2, data.constData());
-				++j;
-			}
+			// Because this is a 2D specific scan controller, I am forcing the format to be a certain way: the first two columns are the axis values.
+			record.writeTo(scan_->rawData(), insertIndex, 2);
 
 			scan_->rawData()->endInsertRows();
 
@@ -197,7 +178,7 @@ bool AM2DDacqScanController::event(QEvent *e)
 				advAcq_->Stop();
 			}
 
-			else if (stopAtEndOfLine_ && atEndOfLine(aeData)){
+			else if (stopAtEndOfLine_ && atEndOfLine(record)){
 
 				// Make sure that the AMScanController knows that the scan has NOT been cancelled.  This way the scan will still be auto-exported.
 				dacqCancelled_ = false;
@@ -224,7 +205,7 @@ bool AM2DDacqScanController::event(QEvent *e)
 		return AMScanController::event(e);
 }
 
-AMnDIndex AM2DDacqScanController::toScanIndex(QMap<int, double> aeData)
+AMnDIndex AM2DDacqScanController::toScanIndex(const AMAcqPointRecord &record)
 {
 	// Increment the fast axis.  If the fast axis is at the end of the road, set it to 0 and increment the slow axis.
 	switch(internal2DConfig_->fastAxis()){
@@ -233,11 +214,11 @@ AMnDIndex AM2DDacqScanController::toScanIndex(QMap<int, double> aeData)
 
 			if (xPosition_ == -1 && yPosition_ == 0){
 
-				fastAxisStartPosition_ = aeData.value(0);
+				fastAxisStartPosition_ = record.scalar(0);
 				xPosition_++;
 			}
 
-			else if (fastAxisStartPosition_ == aeData.value(0)){
+			else if (fastAxisStartPosition_ == record.scalar(0)){
 
 				xPosition_ = 0;
 				yPosition_++;
@@ -253,11 +234,11 @@ AMnDIndex AM2DDacqScanController::toScanIndex(QMap<int, double> aeData)
 
 		if (yPosition_ == -1 && xPosition_ == 0){
 
-			fastAxisStartPosition_ = aeData.value(1);
+			fastAxisStartPosition_ = record.scalar(1);
 			yPosition_++;
 		}
 
-		else if (fastAxisStartPosition_ == aeData.value(1)){
+		else if (fastAxisStartPosition_ == record.scalar(1)){
 
 			yPosition_ = 0;
 			xPosition_++;
@@ -273,12 +254,12 @@ AMnDIndex AM2DDacqScanController::toScanIndex(QMap<int, double> aeData)
 	return AMnDIndex(xPosition_, yPosition_);
 }
 
-bool AM2DDacqScanController::atEndOfLine(QMap<int, double> aeData) const
+bool AM2DDacqScanController::atEndOfLine(const AMAcqPointRecord &record) const
 {
-	if (internal2DConfig_->fastAxis() == AM2DScanConfiguration::X && (internal2DConfig_->xEnd() - aeData.value(0) < internal2DConfig_->xStep()/2))
+	if (internal2DConfig_->fastAxis() == AM2DScanConfiguration::X && (internal2DConfig_->xEnd() - record.scalar(0) < internal2DConfig_->xStep()/2))
 		return true;
 
-	else if (internal2DConfig_->fastAxis() == AM2DScanConfiguration::Y && (internal2DConfig_->yEnd() - aeData.value(1) < internal2DConfig_->yStep()/2))
+	else if (internal2DConfig_->fastAxis() == AM2DScanConfiguration::Y && (internal2DConfig_->yEnd() - record.scalar(1) < internal2DConfig_->yStep()/2))
 		return true;
 
 	return false;
@@ -84,12 +84,12 @@ protected:
 	/// Re-implementing the event method to be able to properly put the data where it should be after every data point is collected.
 	virtual bool event(QEvent *e);
 	/// Re-implementing the toScanIndex method to properly add the next point in 2D space.  Handles incrementing xPosition_ and yPosition_ as appropriate.
-	virtual AMnDIndex toScanIndex(QMap<int, double> aeData);
+	virtual AMnDIndex toScanIndex(const AMAcqPointRecord &record);
 	/// Method that fleshes out the scan's raw data store with all of the points it will need.
 	void prefillScanPoints();
 
-	/// Returns whether the controller is at the end of the fast axis.  Requires aeData for up-to-date information.
-	bool atEndOfLine(QMap<int, double> aeData) const;
+	/// Returns whether the controller is at the end of the fast axis.  Requires the latest point record for up-to-date information.
+	bool atEndOfLine(const AMAcqPointRecord &record) const;
 
 	/// Holds the current position in the x axis.
 	int xPosition_;
@@ -142,6 +142,10 @@ bool AM3DDacqScanController::startImplementation()
 			flushToDiskTimer_.start();
 		}
 
+		// Write the .dat and _spectra.dat files from a background thread about once a second, instead of flushing after every point.  Everything is written before the dacq reports that it stopped.
+		abop->setProperty( "Flush Policy", "Time");
+		abop->setProperty( "Spectrum:Flush Policy", "Time");
+
 		((AMAcqScanSpectrumOutput*)abop)->setScan(scan_);
 		((AMAcqScanSpectrumOutput*)abop)->setScanController(this);
 
@@ -159,39 +163,19 @@ bool AM3DDacqScanController::event(QEvent *e)
 	// This makes sure that the data is put in the appropriate location.
 	if(e->type() == (QEvent::Type)AM::AcqEvent){
 
-		QMap<int, double> aeData = ((AMAcqEvent*)e)->dataPackage_;
-		QMap<int, QList<double> > aeSpectra = ((AMAcqEvent*)e)->spectraPackage_;
-		QMap<int, double>::const_iterator i = aeData.constBegin();
-		QMap<int, QList<double> >::const_iterator j = aeSpectra.constBegin();
+		const AMAcqPointRecord &record = ((AMAcqEvent*)e)->record_;
 
-		if(i.key() == 0 && aeData.count() > 1){
+		if(record.hasScalar(0) && record.scalarCount() > 1){
 
-			AMnDIndex insertIndex = toScanIndex(aeData);qDebug() << insertIndex.i() << insertIndex.j() << insertIndex.k();
+			AMnDIndex insertIndex = toScanIndex(record);
 			// MB: Modified May 13 2012 for changes to AMDataStore. Assumes data store already has sufficient space for scan axes beyond the first axis.
 //			scan_->rawData()->beginInsertRowsAsNecessaryForScanPoint(insertIndex);
 			if(insertIndex.i() >= scan_->rawData()->scanSize(0))
 				scan_->rawData()->beginInsertRows(insertIndex.i()-scan_->rawData()->scanSize(0)+1, -1);
 			////////////////
 
-			// Because this is a 3D specific scan controller, I am forcing the format to be a certain way.
-			scan_->rawData()->setAxisValue(0, insertIndex.i(), i.value());
-			++i;
-			scan_->rawData()->setAxisValue(1, insertIndex.j(), i.value());
-			++i;
-			scan_->rawData()->setAxisValue(2, insertIndex.k(), i.value());
-			++i;
-
-			while(i != aeData.constEnd()){
-				scan_->rawData()->setValue(insertIndex, i.key()-3, AMnDIndex(), i.value());
-				++i;
-			}
-
-			while(j != aeSpectra.constEnd()){
-
-				QVector<double> data = j.value().toVector();
-				scan_->rawData()->setValue(insertIndex, j.key()-3, data.constData());
-				++j;
-			}
+			// Because this is a 3D specific scan controller, I am forcing the format to be a certain way: the first three columns are the axis values.
+			record.writeTo(scan_->rawData(), insertIndex, 3);
 
 			scan_->rawData()->endInsertRows();
 
@@ -202,7 +186,7 @@ bool AM3DDacqScanController::event(QEvent *e)
 				advAcq_->Stop();
 			}
 
-			else if (stopAtEndOfAxis_ != -1 && atEndOfAxis(stopAtEndOfAxis_, aeData)){
+			else if (stopAtEndOfAxis_ != -1 && atEndOfAxis(stopAtEndOfAxis_, record)){
 
 				// Make sure that the AMScanController knows that the scan has NOT been cancelled.  This way the scan will still be auto-exported.
 				dacqCancelled_ = false;
@@ -229,7 +213,7 @@ bool AM3DDacqScanController::event(QEvent *e)
 		return AMScanController::event(e);
 }
 
-AMnDIndex AM3DDacqScanController::toScanIndex(QMap<int, double> aeData)
+AMnDIndex AM3DDacqScanController::toScanIndex(const AMAcqPointRecord &record)
 {
 	// Convenience members that hold the axes in priority order for code readability.
 	int first = axisPriorities_.at(0);
@@ -240,17 +224,17 @@ AMnDIndex AM3DDacqScanController::toScanIndex(QMap<int, double> aeData)
 	if (initializeStartPositions_){
 
 		initializeStartPositions_ = false;
-		firstPriorityAxisStartPosition_ = aeData.value(first);
-		secondPriorityAxisStartPosition_ = aeData.value(second);
+		firstPriorityAxisStartPosition_ = record.scalar(first);
+		secondPriorityAxisStartPosition_ = record.scalar(second);
 	}
 
 	// After reaching the end of the fastest axis, we need to reset it's position to zero and increment the second fastest axis.
-	else if (firstPriorityAxisStartPosition_ == aeData.value(first)){
+	else if (firstPriorityAxisStartPosition_ == record.scalar(first)){
 
 		positions_[first] = 0;
 
 		// If we are also at the end of the second fastest axis, then set its position to zero and increment the slowest axis.
-		if (secondPriorityAxisStartPosition_ == aeData.value(second)){
+		if (secondPriorityAxisStartPosition_ == record.scalar(second)){
 
 			positions_[second] = 0;
 			positions_[third]++;
@@ -267,7 +251,7 @@ AMnDIndex AM3DDacqScanController::toScanIndex(QMap<int, double> aeData)
 	return AMnDIndex(positions_.at(0), positions_.at(1), positions_.at(2));
 }
 
-bool AM3DDacqScanController::atEndOfAxis(int axis, const QMap<int, double> &aeData) const
+bool AM3DDacqScanController::atEndOfAxis(int axis, const AMAcqPointRecord &record) const
 {
 	bool retVal = false;
 
@@ -275,15 +259,15 @@ bool AM3DDacqScanController::atEndOfAxis(int axis, const QMap<int, double> &aeDa
 	switch (axisPriorities_.at(axis)){
 
 	case 0:	// X
-		retVal = internal3DConfig_->xEnd() - aeData.value(0) < internal3DConfig_->xStep()/2;
+		retVal = internal3DConfig_->xEnd() - record.scalar(0) < internal3DConfig_->xStep()/2;
 		break;
 
 	case 1:	// Y
-		retVal = internal3DConfig_->yEnd() - aeData.value(1) < internal3DConfig_->yStep()/2;
+		retVal = internal3DConfig_->yEnd() - record.scalar(1) < internal3DConfig_->yStep()/2;
 		break;
 
 	case 2:	// Z
-		retVal = internal3DConfig_->zEnd() - aeData.value(2) < internal3DConfig_->zStep()/2;
+		retVal = internal3DConfig_->zEnd() - record.scalar(2) < internal3DConfig_->zStep()/2;
 		break;
 	}
 
@@ -70,12 +70,12 @@ protected:
 	/// Re-implementing the event method to be able to properly put the data where it should be after every data point is collected.
 	virtual bool event(QEvent *e);
 	/// Re-implementing the toScanIndex method to properly add the next point in 3D space.  Handles incrementing xPosition_ and yPosition_ as appropriate.
-	virtual AMnDIndex toScanIndex(QMap<int, double> aeData);
+	virtual AMnDIndex toScanIndex(const AMAcqPointRecord &record);
 	/// Method that fleshes out the scan's raw data store with all of the points it will need.
 	void prefillScanPoints();
 
-	/// Returns whether the controller is at the end of the given axis.  The axis is based on the priority (ie: if you give 1 for the axis, that will check second fastest axis).  Requires aeData for up-to-date information.
-	bool atEndOfAxis(int axis, const QMap<int, double> &aeData) const;
+	/// Returns whether the controller is at the end of the given axis.  The axis is based on the priority (ie: if you give 1 for the axis, that will check second fastest axis).  Requires the latest point record for up-to-date information.
+	bool atEndOfAxis(int axis, const AMAcqPointRecord &record) const;
 
 	/// List that holds the current position (index) of each axis.  Order is x, y, z.
 	QList<int> positions_;
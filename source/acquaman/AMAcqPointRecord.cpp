@@ -0,0 +1,112 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMAcqPointRecord.h"
+
+#include "dataman/datastore/AMDataStore.h"
+
+void AMAcqPointRecord::clear()
+{
+	scalars_.resize(0);
+	hasScalar_.resize(0);
+	scalarCount_ = 0;
+	spectra_.resize(0);
+	spectrumValues_.resize(0);
+}
+
+void AMAcqPointRecord::reserve(int columnCount, int spectrumValueCount)
+{
+	scalars_.reserve(columnCount);
+	hasScalar_.reserve(columnCount);
+	spectrumValues_.reserve(spectrumValueCount);
+}
+
+void AMAcqPointRecord::setScalar(int column, double value)
+{
+	if(column < 0)
+		return;
+
+	if(column >= scalars_.size()) {
+		scalars_.resize(column+1);
+		hasScalar_.resize(column+1);
+	}
+
+	if(!hasScalar_.at(column)) {
+		hasScalar_[column] = true;
+		scalarCount_++;
+	}
+
+	scalars_[column] = value;
+}
+
+double* AMAcqPointRecord::appendSpectrum(int column, int size)
+{
+	SpectrumBlock block;
+	block.column = column;
+	block.offset = spectrumValues_.size();
+	block.size = qMax(0, size);
+	spectra_.append(block);
+
+	spectrumValues_.resize(block.offset + block.size);
+	return spectrumValues_.data() + block.offset;
+}
+
+bool AMAcqPointRecord::writeTo(AMDataStore *dataStore, const AMnDIndex &scanIndex, int scanAxisCount) const
+{
+	bool success = true;
+
+	for(int axis = 0; axis < scanAxisCount; axis++)
+		success &= dataStore->setAxisValue(axis, scanIndex.at(axis), scalar(axis));
+
+	for(int column = scanAxisCount, count = scalars_.size(); column < count; column++)
+		if(hasScalar_.at(column))
+			success &= dataStore->setValue(scanIndex, column-scanAxisCount, AMnDIndex(), scalars_.at(column));
+
+	for(int i = 0, count = spectra_.size(); i < count; i++)
+		success &= dataStore->setValue(scanIndex, spectra_.at(i).column-scanAxisCount, spectrumData(i));
+
+	return success;
+}
+
+QMap<int, double> AMAcqPointRecord::scalarMap() const
+{
+	QMap<int, double> map;
+
+	for(int column = 0, count = scalars_.size(); column < count; column++)
+		if(hasScalar_.at(column))
+			map.insert(column, scalars_.at(column));
+
+	return map;
+}
+
+QMap<int, QList<double> > AMAcqPointRecord::spectrumMap() const
+{
+	QMap<int, QList<double> > map;
+
+	for(int i = 0, count = spectra_.size(); i < count; i++) {
+		QList<double> values;
+		values.reserve(spectra_.at(i).size);
+		const double *data = spectrumData(i);
+		for(int x = 0, size = spectra_.at(i).size; x < size; x++)
+			values << data[x];
+		map.insert(spectra_.at(i).column, values);
+	}
+
+	return map;
+}
@@ -0,0 +1,100 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMACQPOINTRECORD_H
+#define AMACQPOINTRECORD_H
+
+#include <QVector>
+#include <QMap>
+#include <QList>
+
+class AMDataStore;
+class AMnDIndex;
+
+/// A compact record of one scan point, as produced by the dacq library's output handler (AMAcqScanSpectrumOutput) and consumed by AMDacqScanController.
+/*! Columns are numbered the way the output handler numbers them: column 0 is the first scan axis, and every other PV in the scan gets the next column in the order it was first recorded.  The scalar values are kept in one array indexed by column, and the spectra are appended one after another into a second contiguous array.  A point with many spectra therefore costs two or three allocations in total, instead of one map node per scalar and one list node per spectrum value.
+
+The scalar array has a slot for every column up to the last scalar, including the columns used by spectra; hasScalar() tells which ones were actually filled in.
+*/
+class AMAcqPointRecord
+{
+public:
+	/// Creates an empty record.
+	AMAcqPointRecord() : scalarCount_(0) {}
+
+	/// Removes all values.
+	void clear();
+	/// Allocates space for \c columnCount scalar columns and \c spectrumValueCount spectrum values, so that filling in a point of that size doesn't need to grow the arrays.
+	void reserve(int columnCount, int spectrumValueCount);
+
+	/// Sets the scalar value for \c column.
+	void setScalar(int column, double value);
+	/// Adds a spectrum of \c size values for \c column, and returns where to write them.  The pointer is only valid until the next call to appendSpectrum() or clear().
+	double* appendSpectrum(int column, int size);
+
+	/// The number of columns in the scalar array (one past the highest column with a scalar)
+	int columnCount() const { return scalars_.size(); }
+	/// The number of scalar values that were set
+	int scalarCount() const { return scalarCount_; }
+	/// Returns true if a scalar value was set for \c column
+	bool hasScalar(int column) const { return column >= 0 && column < hasScalar_.size() && hasScalar_.at(column); }
+	/// The scalar value for \c column, or 0 if none was set.
+	double scalar(int column) const { return hasScalar(column) ? scalars_.at(column) : 0; }
+
+	/// The total number of spectrum values in this record
+	int spectrumValueCount() const { return spectrumValues_.size(); }
+	/// The number of spectra in this record
+	int spectrumCount() const { return spectra_.size(); }
+	/// The column of the spectrum at \c index (in the order they were added)
+	int spectrumColumn(int index) const { return spectra_.at(index).column; }
+	/// The number of values in the spectrum at \c index
+	int spectrumSize(int index) const { return spectra_.at(index).size; }
+	/// The values of the spectrum at \c index
+	const double* spectrumData(int index) const { return spectrumValues_.constData() + spectra_.at(index).offset; }
+
+	/// Writes this point into \c dataStore at \c scanIndex.  The first \c scanAxisCount columns are the scan axis values; every column after that is written to the measurement with id (column - \c scanAxisCount), using the data store's block setter for spectra.  Returns false if any value could not be set.
+	/*! The caller is responsible for calling beginInsertRows() and endInsertRows() around this. */
+	bool writeTo(AMDataStore* dataStore, const AMnDIndex& scanIndex, int scanAxisCount) const;
+
+	/// Returns the scalars as a map from column to value.
+	QMap<int, double> scalarMap() const;
+	/// Returns the spectra as a map from column to values.
+	QMap<int, QList<double> > spectrumMap() const;
+
+protected:
+	/// Where one spectrum lives in spectrumValues_
+	struct SpectrumBlock {
+		int column;
+		int offset;
+		int size;
+	};
+
+	/// Scalar values, indexed by column
+	QVector<double> scalars_;
+	/// Whether each entry in scalars_ was set
+	QVector<bool> hasScalar_;
+	/// The number of true entries in hasScalar_
+	int scalarCount_;
+	/// The spectra, in the order they were added
+	QVector<SpectrumBlock> spectra_;
+	/// All the spectrum values, one spectrum after another
+	QVector<double> spectrumValues_;
+};
+
+#endif // AMACQPOINTRECORD_H
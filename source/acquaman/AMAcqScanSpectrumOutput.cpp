@@ -25,6 +25,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <string.h>
 
 static acqOutputHandlerFactoryRegister registerMe( "AMScanSpectrum", AMAcqScanSpectrumOutput::new_AMAcqScanSpectrumOutput);
 
@@ -39,6 +40,8 @@ AMAcqScanSpectrumOutput::AMAcqScanSpectrumOutput() : acqTextSpectrumOutput()
 	lockHash_ = false;
 	colNo_ = 0;
 	specColNo_ = 0;
+	lastColumnCount_ = 0;
+	lastSpectrumValueCount_ = 0;
 }
 
 AMAcqScanSpectrumOutput::~AMAcqScanSpectrumOutput(){
@@ -86,10 +89,9 @@ int AMAcqScanSpectrumOutput::startRecord( acqKey_t key, int eventno)
 	// flag that some output is occuring
 	acqTextOutput::startRecord(key, eventno);
 
-	to->dataPackage_.clear();
-	to->spectraPackage_.clear();
-	to->dataDelayList_.clear();
-	to->spectraDelayList_.clear();
+	// The last record was handed over to the scan controller; points are usually all the same size, so allocate for that right away.
+	to->record_.clear();
+	to->record_.reserve(to->lastColumnCount_, to->lastSpectrumValueCount_);
 	to->dataDelay_ = true;
 
 	to->recordCount++;
@@ -108,21 +110,11 @@ int AMAcqScanSpectrumOutput::endRecord( acqKey_t key, int eventno)
 
 	/// \todo Handle spectrum output like this too, fix up the other (unused right now) output handler
 	AMAcqEvent *ae = new AMAcqEvent();
-	QMap<int, double>::const_iterator i = to->dataPackage_.constBegin();
-	while(i != to->dataPackage_.constEnd()){
-		ae->dataPackage_.insert(i.key(), i.value());
-		i++;
-	}
-	QMap<int, QList<double> >::const_iterator j = to->spectraPackage_.constBegin();
-	while(j != to->spectraPackage_.constEnd()){
-		ae->spectraPackage_.insert(j.key(), j.value());
-		j++;
-	}
-	QMap<int, double>::const_iterator k = to->extraPackage_.constBegin();
-	while(k != to->extraPackage_.constEnd()){
-		ae->extraPackage_.insert(k.key(), k.value());
-		k++;
-	}
+	// Shares the arrays with the event; the next startRecord() lets go of them.
+	ae->record_ = to->record_;
+	ae->extraPackage_ = to->extraPackage_;
+	to->lastColumnCount_ = to->record_.columnCount();
+	to->lastSpectrumValueCount_ = to->record_.spectrumValueCount();
 	QCoreApplication::postEvent(to->scanController_, ae);
 	return acqTextSpectrumOutput::endRecord(key, eventno);
 
@@ -139,9 +131,7 @@ int AMAcqScanSpectrumOutput::putValue( acqKey_t key, int eventno, int pvno, cons
 		if( (eventno == 1) && (pvno != 0) && !to->lockHash_)
 			to->pvnoToColumn_[pvno] = to->colNo_++;
 
-		double dataVal;
-		double specMax = 0;
-		QList<double> spectraVal;
+		double dataVal = 0;
 
 		if(!pvpr->isSpectrum){
 			switch( pvpr->colp->columnType)
@@ -171,67 +161,61 @@ int AMAcqScanSpectrumOutput::putValue( acqKey_t key, int eventno, int pvno, cons
 			default:
 				return -1;
 			}
-		}
-		else{
-			for(int x = 0; x < count; x++){
-				switch( pvpr->colp->columnType)
-				{
-				case DBF_STRING:
-					break;
-				case DBF_ENUM:	// ENUM support is difficult if the value may be passed through multiple
-					// processes before being handled. It is the responsibility of the inheriting class
-					// to determine how to convert enums to strings, probably with support from the
-					// calling program.
-					break;
-				case DBF_SHORT:
-					dataVal = (double)*(short *)value;
-					break;
-				case DBF_FLOAT:
-					dataVal = (double)*(float *)value;
-					break;
-				case DBF_CHAR:
-					dataVal = (double)*(char *)value;
-					break;
-				case DBF_LONG:{
-				/* NTBA May 8th, 2011 David Chevrier
-				There seems to be an issue with the DBF_LONG being saved as int (size 4)
-				rather than as long (size 8). Probably a 64bit problem.
-				*/
-					//dataVal = (double)*(long *)value;
-					dataVal = (double)*(int *)value;
-					break;
-				}
-				case DBF_DOUBLE:
-					dataVal = *(double *)value;
-					break;
-				default:
-					return -1;
-				}
-				spectraVal.append(dataVal);
-				if(dataVal > specMax)
-					specMax = dataVal;
-				/* NTBA May 8th, 2011 David Chevrier
-				There seems to be an issue with the DBF_LONG being saved as int (size 4)
-				rather than as long (size 8). Probably a 64bit problem.
-				*/
-				if(pvpr->colp->columnType == DBF_LONG)
-					value = (char  *)value + 4;
+
+			if(eventno == 1){
+				if(pvno == 0)
+					to->record_.setScalar(0, dataVal);
 				else
-					value = (char  *)value + pvpr->colp->dataSize;
+					to->record_.setScalar(to->pvnoToColumn_[pvno]+1, dataVal);
 			}
+			else if( (eventno == 2) && (pvno == 1) )
+				to->extraPackage_.insert(2, dataVal);
 		}
-		if((eventno == 1) && !pvpr->isSpectrum){
-			if( (pvno == 0) && (eventno == 1) )
-				to->dataPackage_.insert(0, dataVal);
-			else
-				to->dataPackage_.insert(to->pvnoToColumn_[pvno]+1, dataVal);
-		}
-		else if( (eventno == 2) && (pvno == 1) && !pvpr->isSpectrum){
-			to->extraPackage_.insert(2, dataVal);
-		}
-		else if( (eventno == 1) && pvpr->isSpectrum ){
-			to->spectraPackage_.insert(to->pvnoToColumn_[pvno]+1, spectraVal);
+
+		// Spectra are converted straight into the record, without an intermediate list.
+		else if(eventno == 1){
+			if(!spectrumToDoubles(pvpr->colp->columnType, value, count, to->record_.appendSpectrum(to->pvnoToColumn_[pvno]+1, count)))
+				return -1;
 		}
 	}
 	return 0;
 }
+
+bool AMAcqScanSpectrumOutput::spectrumToDoubles(int columnType, const void *value, int count, double *output)
+{
+	switch(columnType)
+	{
+	case DBF_STRING:
+	case DBF_ENUM:	// see putValue()
+		for(int x = 0; x < count; x++)
+			output[x] = 0;
+		break;
+	case DBF_SHORT:
+		for(int x = 0; x < count; x++)
+			output[x] = (double)((const short *)value)[x];
+		break;
+	case DBF_FLOAT:
+		for(int x = 0; x < count; x++)
+			output[x] = (double)((const float *)value)[x];
+		break;
+	case DBF_CHAR:
+		for(int x = 0; x < count; x++)
+			output[x] = (double)((const char *)value)[x];
+		break;
+	case DBF_LONG:
+		/* NTBA May 8th, 2011 David Chevrier
+		There seems to be an issue with the DBF_LONG being saved as int (size 4)
+		rather than as long (size 8). Probably a 64bit problem.
+		*/
+		for(int x = 0; x < count; x++)
+			output[x] = (double)((const int *)value)[x];
+		break;
+	case DBF_DOUBLE:
+		memcpy(output, value, count*sizeof(double));
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
@@ -55,6 +55,9 @@ public:
 	static int endRecord( acqKey_t key, int eventno);
 	static int putValue( acqKey_t key, int eventno, int pvno, const void *value, int count);
 
+	/// Converts \c count spectrum values of the dacq column type \c columnType (DBF_SHORT, DBF_LONG, etc.) starting at \c value into \c output.  String and enum values become 0.  Returns false if the column type isn't supported.
+	static bool spectrumToDoubles(int columnType, const void *value, int count, double *output);
+
 	AMAcqScanSpectrumOutput();
 	virtual ~AMAcqScanSpectrumOutput();
 	static acqBaseOutput *new_AMAcqScanSpectrumOutput();
@@ -68,10 +71,10 @@ private:
 	int outputCol;
 	AMScan *scan_;
 	QObject *scanController_;
-	QMap<int, double> dataDelayList_;
-	QMap<int, QList<double> > spectraDelayList_;
-	QMap<int, double> dataPackage_;
-	QMap<int, QList<double> > spectraPackage_;
+	/// The point being recorded.  Handed over to the scan controller in an AMAcqEvent at the end of each record.
+	AMAcqPointRecord record_;
+	/// The sizes of the last record, used to allocate the next one up front.
+	int lastColumnCount_, lastSpectrumValueCount_;
 	QMap<int, double> extraPackage_;
 	QHash<int, int> pvnoToColumn_;
 	int colNo_, specColNo_;
@@ -0,0 +1,203 @@
+#include "AMContinuousMoveScanOptimizer.h"
+
+#include "actions3/AMListAction3.h"
+#include "actions3/AMLoopAction3.h"
+#include "actions3/actions/AMControlMoveAction3.h"
+#include "actions3/actions/AMDetectorTriggerAction.h"
+#include "actions3/actions/AMDetectorReadAction.h"
+#include "actions3/actions/AMDetectorDwellTimeActionInfo.h"
+#include "actions3/actions/AMContinuousRegionActionInfo.h"
+#include "actions3/actions/AMContinuousRegionReadAction.h"
+#include "beamline/AMControl.h"
+#include "beamline/AMDetector.h"
+#include "beamline/AMDetectorTriggerSource.h"
+
+AMContinuousMoveScanOptimizer::AMContinuousMoveScanOptimizer(AMAction3 *scanActionTree, QObject *parent) :
+	AMScanActionControllerScanOptimizer(scanActionTree, parent)
+{
+}
+
+QList<double> AMContinuousMoveScanOptimizer::regionAxisValues(AMListAction3 *regionList){
+	QList<double> retVal;
+	if(!regionList)
+		return retVal;
+
+	for(int x = 0; x < regionList->subActionCount(); x++){
+		// Already rewritten: the info knows.
+		AMListAction3 *castToListAction = qobject_cast<AMListAction3*>(regionList->subActionAt(x));
+		const AMContinuousRegionActionInfo *continuousInfo = castToListAction ? qobject_cast<const AMContinuousRegionActionInfo*>(castToListAction->info()) : 0;
+		if(continuousInfo)
+			return continuousInfo->axisValues();
+
+		// Step region: start from the region's first move, and step by the loop's relative move once per iteration.
+		AMLoopAction3 *castToLoopAction = qobject_cast<AMLoopAction3*>(regionList->subActionAt(x));
+		AMControlMoveAction3 *startMove = qobject_cast<AMControlMoveAction3*>(regionList->subActionAt(0));
+		if(castToLoopAction && startMove && castToLoopAction->subActionCount() > 0){
+			AMControlMoveAction3 *stepMove = qobject_cast<AMControlMoveAction3*>(castToLoopAction->subActionAt(castToLoopAction->subActionCount()-1));
+			if(!stepMove || !stepMove->controlMoveInfo()->isRelativeMove())
+				return retVal;
+
+			double regionStart = startMove->controlMoveInfo()->controlInfo()->value();
+			double regionStep = stepMove->controlMoveInfo()->controlInfo()->value();
+			for(int y = 0; y < castToLoopAction->loopCount(); y++)
+				retVal.append(regionStart + y*regionStep);
+			return retVal;
+		}
+	}
+
+	return retVal;
+}
+
+void AMContinuousMoveScanOptimizer::optimizeImplementation(AMAction3 *scanActionTree){
+	AMLoopAction3 *templateLoopAction = new AMLoopAction3(new AMLoopActionInfo3(1, "Fake Loop", "Fake Loop"));
+	QList<AMAction3*> allLoopsAsActions = AMScanActionTreeSupport::findActionsOfType(scanActionTree, templateLoopAction);
+
+	for(int x = 0; x < allLoopsAsActions.count(); x++){
+		AMLoopAction3 *castToLoopAction = qobject_cast<AMLoopAction3*>(allLoopsAsActions.at(x));
+		if(castToLoopAction)
+			optimizeLoop(castToLoopAction);
+	}
+
+	delete templateLoopAction;
+}
+
+bool AMContinuousMoveScanOptimizer::canOptimizeDetectors(const QList<AMDetector *> &detectors) const{
+	if(detectors.isEmpty())
+		return false;
+
+	AMDetectorTriggerSource *commonTriggerSource = detectors.at(0)->detectorTriggerSource();
+	if(!commonTriggerSource)
+		return false;
+
+	for(int x = 0; x < detectors.count(); x++)
+		if(!detectors.at(x)->canContinuousAcquire() || detectors.at(x)->rank() != 0 || detectors.at(x)->detectorTriggerSource() != commonTriggerSource)
+			return false;
+
+	return true;
+}
+
+AMAction3* AMContinuousMoveScanOptimizer::createContinuousMoveAction(AMControl *axisControl, const AMContinuousRegionActionInfo *regionInfo) const{
+	Q_UNUSED(axisControl)
+	Q_UNUSED(regionInfo)
+	return 0; //NULL
+}
+
+bool AMContinuousMoveScanOptimizer::isDetectorAcquisition(AMAction3 *action) const{
+	if(qobject_cast<AMDetectorTriggerAction*>(action) || qobject_cast<AMDetectorReadAction*>(action))
+		return true;
+
+	AMListAction3 *castToListAction = qobject_cast<AMListAction3*>(action);
+	if(!castToListAction || castToListAction->subActionCount() == 0)
+		return false;
+
+	for(int x = 0; x < castToListAction->subActionCount(); x++)
+		if(!isDetectorAcquisition(castToListAction->subActionAt(x)))
+			return false;
+
+	return true;
+}
+
+double AMContinuousMoveScanOptimizer::dwellTimeOf(AMAction3 *action) const{
+	AMListAction3 *dwellList = qobject_cast<AMListAction3*>(action);
+	if(!dwellList || dwellList->subActionCount() == 0)
+		return -1;
+
+	double dwellTime = -1;
+	for(int x = 0; x < dwellList->subActionCount(); x++){
+		const AMDetectorDwellTimeActionInfo *dwellInfo = qobject_cast<const AMDetectorDwellTimeActionInfo*>(dwellList->subActionAt(x)->info());
+		if(!dwellInfo)
+			return -1;
+		dwellTime = dwellInfo->dwellSeconds();
+	}
+
+	return dwellTime;
+}
+
+bool AMContinuousMoveScanOptimizer::optimizeLoop(AMLoopAction3 *axisLoop){
+	AMListAction3 *regionList = qobject_cast<AMListAction3*>(axisLoop->parentAction());
+	if(!regionList || regionList->subActionCount() < 2 || axisLoop->subActionCount() != 2)
+		return false;
+
+	// Only the innermost axis qualifies: its loop acquires the detectors directly, then takes one relative step.
+	AMListAction3 *acquisitionList = qobject_cast<AMListAction3*>(axisLoop->subActionAt(0));
+	AMControlMoveAction3 *stepMove = qobject_cast<AMControlMoveAction3*>(axisLoop->subActionAt(1));
+	AMControlMoveAction3 *startMove = qobject_cast<AMControlMoveAction3*>(regionList->subActionAt(0));
+	if(!acquisitionList || !isDetectorAcquisition(acquisitionList))
+		return false;
+	if(!stepMove || !stepMove->control() || !stepMove->controlMoveInfo()->isRelativeMove() || !startMove)
+		return false;
+
+	QList<AMDetector*> detectors = detectorsWithin(acquisitionList);
+	if(!canOptimizeDetectors(detectors))
+		return false;
+
+	// The dwell time comes from the region's list of detector dwell time actions, if there is one.
+	double regionTime = dwellTimeOf(regionList->subActionAt(1));
+
+	AMControl *axisControl = stepMove->control();
+	AMContinuousRegionActionInfo *regionInfo = new AMContinuousRegionActionInfo(axisControl->name(),
+										     startMove->controlMoveInfo()->controlInfo()->value(),
+										     stepMove->controlMoveInfo()->controlInfo()->value(),
+										     regionTime,
+										     axisLoop->loopCount());
+
+	// Without a move that keeps pace with the detectors, the buffered points wouldn't be where the region says they are.
+	AMAction3 *continuousMove = createContinuousMoveAction(axisControl, regionInfo);
+	if(!continuousMove){
+		delete regionInfo;
+		return false;
+	}
+
+	AMListAction3 *continuousRegion = new AMListAction3(regionInfo, AMListAction3::Parallel);
+	continuousRegion->addSubAction(continuousMove);
+
+	// One trigger starts the shared source buffering for all of the detectors.  Once they've all been read, the buffers are posted one point at a time.
+	AMListAction3 *bufferedAcquisition = new AMListAction3(new AMListActionInfo3(QString("Acquire All Detectors Continuously"), QString("Acquire %1 Detectors Continuously").arg(detectors.count())), AMListAction3::Sequential);
+	AMAction3 *triggerAction = detectors.at(0)->createTriggerAction(AMDetectorDefinitions::ContinuousRead);
+	if(triggerAction){
+		AMDetectorTriggerActionInfo *triggerInfo = qobject_cast<AMDetectorTriggerActionInfo*>(triggerAction->info());
+		if(triggerInfo)
+			triggerInfo->setContinuousPointCount(regionInfo->pointCount());
+		bufferedAcquisition->addSubAction(triggerAction);
+	}
+
+	AMListAction3 *bufferedReads = new AMListAction3(new AMListActionInfo3(QString("Read Detectors For %1").arg(detectors.at(0)->detectorTriggerSource()->name()), QString("Read Detectors For %1").arg(detectors.at(0)->detectorTriggerSource()->name())), AMListAction3::Parallel);
+	for(int x = 0; x < detectors.count(); x++)
+		bufferedReads->addSubAction(detectors.at(x)->createReadAction());
+	bufferedAcquisition->addSubAction(bufferedReads);
+
+	AMContinuousRegionReadAction *regionRead = new AMContinuousRegionReadAction(new AMContinuousRegionActionInfo(*regionInfo), detectors, axisLoop->info()->shortDescription());
+	regionRead->setGenerateScanActionMessage(true);
+	bufferedAcquisition->addSubAction(regionRead);
+	continuousRegion->addSubAction(bufferedAcquisition);
+
+	int indexOfLoop = regionList->indexOfSubAction(axisLoop);
+	regionList->insertSubAction(continuousRegion, indexOfLoop);
+	regionList->deleteSubAction(indexOfLoop+1);
+
+	return true;
+}
+
+QList<AMDetector*> AMContinuousMoveScanOptimizer::detectorsWithin(AMAction3 *action) const{
+	QList<AMDetector*> retVal;
+
+	AMDetectorTriggerAction *castToTriggerAction = qobject_cast<AMDetectorTriggerAction*>(action);
+	if(castToTriggerAction && castToTriggerAction->detector() && !retVal.contains(castToTriggerAction->detector()))
+		retVal.append(castToTriggerAction->detector());
+
+	AMDetectorReadAction *castToReadAction = qobject_cast<AMDetectorReadAction*>(action);
+	if(castToReadAction && castToReadAction->detector() && !retVal.contains(castToReadAction->detector()))
+		retVal.append(castToReadAction->detector());
+
+	AMListAction3 *castToListAction = qobject_cast<AMListAction3*>(action);
+	if(castToListAction){
+		for(int x = 0; x < castToListAction->subActionCount(); x++){
+			QList<AMDetector*> subDetectors = detectorsWithin(castToListAction->subActionAt(x));
+			for(int y = 0; y < subDetectors.count(); y++)
+				if(!retVal.contains(subDetectors.at(y)))
+					retVal.append(subDetectors.at(y));
+		}
+	}
+
+	return retVal;
+}
@@ -0,0 +1,57 @@
+#ifndef AMCONTINUOUSMOVESCANOPTIMIZER_H
+#define AMCONTINUOUSMOVESCANOPTIMIZER_H
+
+#include "acquaman/AMScanActionControllerScanOptimizer.h"
+
+class AMListAction3;
+class AMLoopAction3;
+class AMControl;
+class AMDetector;
+class AMContinuousRegionActionInfo;
+
+/// This optimizer rewrites step-axis regions into a single continuous move with buffered detector reads, when the hardware allows it.
+/*! The assembler builds each step region as: move to the start, set the dwell times, then loop { acquire all detectors, move one step }.  Every point therefore costs a round trip through the action system for both the move and the acquisition.
+
+For the innermost axis of a scan, if every detector acquired at each point can continuously acquire (ie: buffer its readings) and they are all triggered by the same AMDetectorTriggerSource (ex: the channels of a CLSSIS3820Scaler in buffered mode), the loop is replaced by a parallel list described by an AMContinuousRegionActionInfo:
+
+- a move of the axis control from the region start to where the loop would have finished, and
+- one ContinuousRead trigger of the shared source (told the region's pointCount()), a read of each detector, and an AMContinuousRegionReadAction.
+
+The info keeps the start, step, dwell time and number of points, so the axis values of the buffered points are exactly those of the original loop (see regionAxisValues()).  The AMContinuousRegionReadAction uses them to post the buffers one point at a time, with the same ControlMoved, DataAvailable and LoopIncremented messages as the step loop, so the scan controllers still record one row per point.  Regions where any detector can't take part are left alone.
+
+The loop, the acquisition and the dwell times are recognized by the types of their actions (a relative AMControlMoveAction3, lists of detector trigger and read actions, and AMDetectorDwellTimeActionInfo), not by their descriptions.
+
+Because the buffered points are recorded at the step loop's axis values, the move has to cross the region at one step per dwell time.  AMControl has no generic way to set velocity, so createContinuousMoveAction() returns 0 here and this class leaves every region alone.  Beamlines opt in by installing a subclass that knows how to synchronize their motors (ex: CLSMAXvMotorContinuousMoveScanOptimizer) from their app controller, ahead of the other principle optimizers, since AMDetectorTriggerSourceScanOptimizer rewrites the same acquisition lists:
+
+\code
+AMAppControllerSupport::prependPrincipleOptimizer(new CLSMAXvMotorContinuousMoveScanOptimizer());
+\endcode
+*/
+class AMContinuousMoveScanOptimizer : public AMScanActionControllerScanOptimizer
+{
+Q_OBJECT
+public:
+	AMContinuousMoveScanOptimizer(AMAction3 *scanActionTree = 0, QObject *parent = 0);
+
+	/// Returns the axis values visited by the points of \c regionList, which can be either a step region (as made by AMScanActionControllerScanAssembler) or a region rewritten by this optimizer.  Returns an empty list if the region isn't recognized.
+	static QList<double> regionAxisValues(AMListAction3 *regionList);
+
+protected:
+	virtual void optimizeImplementation(AMAction3 *scanActionTree);
+
+	/// Returns true if all of the \c detectors can be read out together from one continuous acquisition.  The default requires that each is 0D and can continuously acquire, and that they all share one trigger source.
+	virtual bool canOptimizeDetectors(const QList<AMDetector*> &detectors) const;
+	/// Creates the action that moves \c axisControl across the region described by \c regionInfo, at one step per regionTime().  Returning 0 leaves the region as a step loop; the base class always does.
+	virtual AMAction3* createContinuousMoveAction(AMControl *axisControl, const AMContinuousRegionActionInfo *regionInfo) const;
+
+	/// Rewrites the \c axisLoop (an innermost step loop) within its region into a continuous region. Returns false and does nothing if it can't be optimized.
+	bool optimizeLoop(AMLoopAction3 *axisLoop);
+	/// Finds all the detectors that are triggered or read within \c action (searched recursively).
+	QList<AMDetector*> detectorsWithin(AMAction3 *action) const;
+	/// Returns true if \c action is a detector trigger or read action, or a non-empty list made only of them (searched recursively).
+	bool isDetectorAcquisition(AMAction3 *action) const;
+	/// Returns the dwell time set by \c action if it is a non-empty list of detector dwell time actions, or -1 otherwise.
+	double dwellTimeOf(AMAction3 *action) const;
+};
+
+#endif // AMCONTINUOUSMOVESCANOPTIMIZER_H
@@ -131,6 +131,10 @@ bool AMDacqScanController::startImplementation(){
 				flushToDiskTimer_.start();
 			}
 
+			// Write the .dat and _spectra.dat files from a background thread about once a second, instead of flushing after every point.  Everything is written before the dacq reports that it stopped.
+			abop->setProperty( "Flush Policy", "Time");
+			abop->setProperty( "Spectrum:Flush Policy", "Time");
+
 			((AMAcqScanSpectrumOutput*)abop)->setScan(scan_);
 			((AMAcqScanSpectrumOutput*)abop)->setScanController(this);
 
@@ -186,12 +190,9 @@ int AMDacqScanController::detectorReadMethodToDacqReadMethod(AMOldDetector::Read
 
 bool AMDacqScanController::event(QEvent *e){
 	if(e->type() == (QEvent::Type)AM::AcqEvent){
-		QMap<int, double> aeData = ((AMAcqEvent*)e)->dataPackage_;
-		QMap<int, QList<double> > aeSpectra = ((AMAcqEvent*)e)->spectraPackage_;
-		QMap<int, double>::const_iterator i = aeData.constBegin();
-		QMap<int, QList<double> >::const_iterator j = aeSpectra.constBegin();
-		if(i.key() == 0 && aeData.count() > 1){
-			AMnDIndex insertIndex = toScanIndex(aeData);
+		const AMAcqPointRecord &record = ((AMAcqEvent*)e)->record_;
+		if(record.hasScalar(0) && record.scalarCount() > 1){
+			AMnDIndex insertIndex = toScanIndex(record);
 			// MB: Modified May 13 2012 for changes to AMDataStore. Assumes data store already has sufficient space for scan axes beyond the first axis.
 //			scan_->rawData()->beginInsertRowsAsNecessaryForScanPoint(insertIndex);
 			if(insertIndex.i() >= scan_->rawData()->scanSize(0))
@@ -199,18 +200,7 @@ bool AMDacqScanController::event(QEvent *e){
 			////////////////
 
 			/// \bug CRITICAL: This is ASSUMING ONE AXIS, need to fix that somewhere
-			scan_->rawData()->setAxisValue(0, insertIndex.i(), i.value());
-			++i;
-			while(i != aeData.constEnd()){
-				scan_->rawData()->setValue(insertIndex, i.key()-1, AMnDIndex(), i.value());
-				++i;
-			}
-			while(j != aeSpectra.constEnd()){
-
-				QVector<double> data = j.value().toVector();
-				scan_->rawData()->setValue(insertIndex, j.key()-1, data.constData());
-				++j;
-			}
+			record.writeTo(scan_->rawData(), insertIndex, 1);
 			scan_->rawData()->endInsertRows();
 
 			if (stopImmediately_){
@@ -234,9 +224,9 @@ bool AMDacqScanController::event(QEvent *e){
 		return AMScanController::event(e);
 }
 
-AMnDIndex AMDacqScanController::toScanIndex(QMap<int, double> aeData){
+AMnDIndex AMDacqScanController::toScanIndex(const AMAcqPointRecord &record){
 	//Simple indexer, assumes there is ONLY ONE scan dimension and appends to the end
-	Q_UNUSED(aeData);
+	Q_UNUSED(record);
 	return AMnDIndex(scan_->rawData()->scanSize(0));
 }
 
@@ -249,6 +239,7 @@ void AMDacqScanController::onDacqStart()
 void AMDacqScanController::onDacqStop()
 {
 	flushCDFDataStoreToDisk();
+	reportDeadTime();
 
 	if(dacqCancelled_)
 		setCancelled();
@@ -256,6 +247,53 @@ void AMDacqScanController::onDacqStop()
 		setFinished();
 }
 
+int AMDacqScanController::deadTimePoints() const
+{
+	int points = 0;
+
+	for(acqScan_t *sp = first_acqScan(advAcq_->getMaster()); sp; sp = next_acqScan(sp))
+		points += sp->deadTimePoints;
+
+	return points;
+}
+
+double AMDacqScanController::deadTimeTotal() const
+{
+	double total = 0;
+
+	for(acqScan_t *sp = first_acqScan(advAcq_->getMaster()); sp; sp = next_acqScan(sp))
+		total += sp->deadTimeTotal;
+
+	return total;
+}
+
+double AMDacqScanController::deadTimeMax() const
+{
+	double longest = 0;
+
+	for(acqScan_t *sp = first_acqScan(advAcq_->getMaster()); sp; sp = next_acqScan(sp))
+		longest = qMax(longest, sp->deadTimeMax);
+
+	return longest;
+}
+
+void AMDacqScanController::reportDeadTime()
+{
+	int points = deadTimePoints();
+
+	if(points == 0)
+		return;
+
+	double total = deadTimeTotal();
+	QString deadTime = QString("Dead time: %1 s over %2 points (average %3 ms, longest %4 ms).")
+			.arg(total, 0, 'f', 3)
+			.arg(points)
+			.arg(1000.0*total/points, 0, 'f', 1)
+			.arg(1000.0*deadTimeMax(), 0, 'f', 1);
+
+	AMErrorMon::report(AMErrorReport(this, AMErrorReport::Debug, AMDACQSCANCONTROLLER_DEAD_TIME_SUMMARY, QString("AMDacqScanController: %1").arg(deadTime)));
+}
+
 void AMDacqScanController::onDacqPause(int mode)
 {
 	if(mode == 1)
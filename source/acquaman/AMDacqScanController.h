@@ -42,6 +42,7 @@ class QDir;
 #define AMDACQSCANCONTROLLER_DACQ_INITIALIZATION_FAILED 72002
 #define AMDACQSCANCONTROLLER_NO_X_COLUMN 72003
 #define AMDACQSCANCONTROLLER_NO_SPECTRUM_FILE 72004
+#define AMDACQSCANCONTROLLER_DEAD_TIME_SUMMARY 72005
 
 class AMDacqScanController : public AMScanController
 {
@@ -54,6 +55,13 @@ public:
 	/// Returns whether the controller is going to stop immediately.
 	bool stoppingImmediately() const { return stopImmediately_; }
 
+	/// Returns the number of points the dacq library has measured the dead time for, over all of its scans.  Dead time is the time from the start of a point (after any pause) until its dwell begins.
+	int deadTimePoints() const;
+	/// Returns the total dead time so far, in seconds.
+	double deadTimeTotal() const;
+	/// Returns the longest dead time of a single point, in seconds.
+	double deadTimeMax() const;
+
 public slots:
 	/// Tells the controller to stop.  The controller will finish what it is currently doing and then stop.
 	void stopImmediately() { stopImmediately_ = true; }
@@ -70,7 +78,8 @@ protected:
 	int detectorReadMethodToDacqReadMethod(AMOldDetector::ReadMethod readMethod);
 
 	bool event(QEvent *e);
-	virtual AMnDIndex toScanIndex(QMap<int, double> aeData);
+	/// Returns where the point in \c record goes in the scan.  The base class simply appends to the end of the first scan axis.
+	virtual AMnDIndex toScanIndex(const AMAcqPointRecord &record);
 
 protected slots:
 	virtual void onDacqStart();
@@ -83,6 +92,8 @@ protected slots:
 	virtual void onDwellTimeTriggerChanged(double newValue);
 	/// Helper slot that tells AMCDFDataStore to flush it's contents to disk.  This prevents it from corrupting itself.
 	void flushCDFDataStoreToDisk();
+	/// Reports a summary of the dead time (deadTimePoints(), deadTimeTotal() and deadTimeMax()) as a debug message.  The scan itself is left alone.
+	void reportDeadTime();
 
 protected:
 	QEpicsAdvAcq *advAcq_;
@@ -1,11 +1,19 @@
 #include "AMScanActionController.h"
 
+#include "dataman/AMScanJournal.h"
+
 AMScanActionController::AMScanActionController(AMScanConfiguration *configuration, QObject *parent) :
 	AMScanController(configuration, parent)
 {
+	journal_ = 0;
 	connect(this, SIGNAL(stateChanged(int,int)), this, SLOT(onStateChanged(int,int)));
 }
 
+AMScanActionController::~AMScanActionController()
+{
+	delete journal_;
+}
+
 #include "actions3/AMActionRunner3.h"
 #include "acquaman/AMAgnosticDataAPI.h"
 
@@ -30,6 +38,14 @@ void AMScanActionController::onStateChanged(int oldState, int newState){
 		AMAgnosticDataMessageQEventHandler *scanActionMessager = qobject_cast<AMAgnosticDataMessageQEventHandler*>(dataMessager);
 		if(scanActionMessager)
 			scanActionMessager->removeReceiver(this);
+
+		// The scan is saved normally from here on (even when cancelled or failed), so the journal is no longer needed.
+		if(journal_){
+
+			journal_->finish();
+			delete journal_;
+			journal_ = 0;
+		}
 	}
 }
 
@@ -39,6 +55,9 @@ bool AMScanActionController::startImplementation(){
 	if(scanActionMessager)
 		scanActionMessager->addReceiver(this);
 
+	if(scan_ && !journal_)
+		journal_ = new AMScanJournal(scan_);
+
 	AMActionRunner3::scanActionRunner()->setQueuePaused(false);
 	setStarted();
 	return true;
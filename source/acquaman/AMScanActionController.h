@@ -3,11 +3,15 @@
 
 #include "AMScanController.h"
 
+class AMScanJournal;
+
 class AMScanActionController : public AMScanController
 {
 Q_OBJECT
 public:
 	AMScanActionController(AMScanConfiguration *configuration, QObject *parent = 0);
+	/// Destructor.  Deletes the scan journal, if the scan never reached a final state.
+	virtual ~AMScanActionController();
 
 public slots:
 	void skip(const QString &command);
@@ -23,6 +27,9 @@ protected:
 	virtual void cancelImplementation();
 
 	bool event(QEvent *e);
+
+	/// Journals the scan's raw data while it is running, so that it can be recovered if the program dies before the scan is saved.  Created when the scan starts, and finished once it reaches a final state.
+	AMScanJournal *journal_;
 };
 
 #endif // AMSCANACTIONCONTROLLER_H
@@ -0,0 +1,643 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMScanReplay.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QDataStream>
+
+#include <string.h>
+
+#include "dataman/AMScan.h"
+#include "dataman/datastore/AMDataStore.h"
+#include "beamline/AMDetector.h"
+#include "beamline/AMControl.h"
+#include "beamline/AMReplayDetector.h"
+#include "beamline/AMReplayControl.h"
+#include "util/AMErrorMonitor.h"
+
+/// Identifies a saved recording.
+static const char AMSCANREPLAY_MAGIC[] = "AMREPLAY";
+static const qint32 AMSCANREPLAY_VERSION = 1;
+
+// AMScanReplayEvent
+////////////////////////
+
+AMScanReplayEvent AMScanReplayEvent::fromMessage(qint64 time, const AMAgnosticDataAPIMessage &message)
+{
+	AMScanReplayEvent event;
+	event.time = time;
+	event.kind = Message;
+	event.name = message.uniqueID();
+	event.messageType = message.messageType();
+	event.messageData = message.JSONData();
+
+	return event;
+}
+
+AMScanReplayEvent AMScanReplayEvent::fromDetectorReading(qint64 time, const QString &detectorName, const AMnDIndex &size, const QVector<double> &values)
+{
+	AMScanReplayEvent event;
+	event.time = time;
+	event.kind = DetectorReading;
+	event.name = detectorName;
+	for(int mu = 0; mu < size.rank(); mu++)
+		event.readingSize << int(size.at(mu));
+	event.readingValues = values;
+
+	return event;
+}
+
+AMScanReplayEvent AMScanReplayEvent::fromControlValue(qint64 time, const QString &controlName, double value)
+{
+	AMScanReplayEvent event;
+	event.time = time;
+	event.kind = ControlValue;
+	event.name = controlName;
+	event.controlValue = value;
+
+	return event;
+}
+
+AMAgnosticDataAPIMessage AMScanReplayEvent::toMessage() const
+{
+	AMAgnosticDataAPIMessage message(messageType, name);
+
+	QMapIterator<QString, QVariant> i(messageData);
+	while(i.hasNext()){
+
+		i.next();
+		QVariant value = i.value();
+		message.setValue(i.key(), value);
+	}
+
+	return message;
+}
+
+// AMScanReplayRecording
+////////////////////////////
+
+QStringList AMScanReplayRecording::detectorNames() const
+{
+	QStringList rv;
+
+	foreach(const AMScanReplayEvent &event, events_)
+		if(event.kind == AMScanReplayEvent::DetectorReading && !rv.contains(event.name))
+			rv << event.name;
+
+	return rv;
+}
+
+QStringList AMScanReplayRecording::controlNames() const
+{
+	QStringList rv;
+
+	foreach(const AMScanReplayEvent &event, events_)
+		if(event.kind == AMScanReplayEvent::ControlValue && !rv.contains(event.name))
+			rv << event.name;
+
+	return rv;
+}
+
+QList<QVector<double> > AMScanReplayRecording::detectorReadings(const QString &detectorName) const
+{
+	QList<QVector<double> > rv;
+
+	foreach(const AMScanReplayEvent &event, events_)
+		if(event.kind == AMScanReplayEvent::DetectorReading && event.name == detectorName)
+			rv << event.readingValues;
+
+	return rv;
+}
+
+QList<AMAxisInfo> AMScanReplayRecording::detectorAxes(const QString &detectorName) const
+{
+	QList<AMAxisInfo> rv;
+
+	foreach(const AMScanReplayEvent &event, events_){
+
+		if(event.kind == AMScanReplayEvent::DetectorReading && event.name == detectorName){
+
+			for(int mu = 0; mu < event.readingSize.count(); mu++)
+				rv << AMAxisInfo(QString("axis%1").arg(mu), event.readingSize.at(mu));
+			break;
+		}
+	}
+
+	return rv;
+}
+
+bool AMScanReplayRecording::save(const QString &filePath) const
+{
+	QFile file(filePath);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+
+		AMErrorMon::alert(0, AMSCANREPLAY_CANNOT_OPEN_RECORDING, QString("Could not open the file '%1' to save a scan replay recording.").arg(filePath));
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_6);
+	stream.writeRawData(AMSCANREPLAY_MAGIC, 8);
+	stream << AMSCANREPLAY_VERSION << qint32(events_.count());
+
+	foreach(const AMScanReplayEvent &event, events_){
+
+		stream << event.time << qint32(event.kind) << event.name;
+
+		switch(event.kind){
+
+		case AMScanReplayEvent::Message:
+			stream << qint32(event.messageType) << event.messageData;
+			break;
+
+		case AMScanReplayEvent::DetectorReading:
+			stream << event.readingSize << event.readingValues;
+			break;
+
+		case AMScanReplayEvent::ControlValue:
+			stream << event.controlValue;
+			break;
+		}
+	}
+
+	return stream.status() == QDataStream::Ok;
+}
+
+bool AMScanReplayRecording::load(const QString &filePath)
+{
+	QFile file(filePath);
+	if(!file.open(QIODevice::ReadOnly)){
+
+		AMErrorMon::alert(0, AMSCANREPLAY_CANNOT_OPEN_RECORDING, QString("Could not open the scan replay recording '%1'.").arg(filePath));
+		return false;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	char magic[8];
+	qint32 version, count;
+
+	if(stream.readRawData(magic, 8) != 8 || memcmp(magic, AMSCANREPLAY_MAGIC, 8) != 0){
+
+		AMErrorMon::alert(0, AMSCANREPLAY_CANNOT_READ_RECORDING, QString("The file '%1' is not a scan replay recording.").arg(filePath));
+		return false;
+	}
+
+	stream >> version >> count;
+	if(version > AMSCANREPLAY_VERSION){
+
+		AMErrorMon::alert(0, AMSCANREPLAY_CANNOT_READ_RECORDING, QString("The scan replay recording '%1' was written by a newer version of Acquaman.").arg(filePath));
+		return false;
+	}
+
+	QList<AMScanReplayEvent> events;
+
+	for(int i = 0; i < count && stream.status() == QDataStream::Ok; i++){
+
+		AMScanReplayEvent event;
+		qint32 kind;
+		stream >> event.time >> kind >> event.name;
+		event.kind = AMScanReplayEvent::Kind(kind);
+
+		switch(event.kind){
+
+		case AMScanReplayEvent::Message: {
+
+			qint32 messageType;
+			stream >> messageType >> event.messageData;
+			event.messageType = AMAgnosticDataAPIDefinitions::MessageType(messageType);
+			break;
+		}
+
+		case AMScanReplayEvent::DetectorReading:
+			stream >> event.readingSize >> event.readingValues;
+			break;
+
+		case AMScanReplayEvent::ControlValue:
+			stream >> event.controlValue;
+			break;
+		}
+
+		events << event;
+	}
+
+	if(stream.status() != QDataStream::Ok){
+
+		AMErrorMon::alert(0, AMSCANREPLAY_CANNOT_READ_RECORDING, QString("The scan replay recording '%1' is incomplete or damaged.").arg(filePath));
+		return false;
+	}
+
+	events_ = events;
+	return true;
+}
+
+AMScanReplayRecording AMScanReplayRecording::fromScan(const AMScan *scan, int pointTime)
+{
+	AMScanReplayRecording recording;
+	const AMDataStore *store = scan->rawData();
+
+	int scanRank = store->scanRank();
+	if(scanRank > 0 && store->scanSpaceIsEmpty())
+		return recording;
+
+	QString axisName = scanRank > 0 ? store->scanAxisAt(0).name : QString("ScanAxis");
+	recording.append(AMScanReplayEvent::fromMessage(0, AMAgnosticDataAPIStartAxisMessage(axisName)));
+
+	// The shape and values of each measurement are the same for every scan point.
+	int measurementCount = store->measurementCount();
+	QList<AMMeasurementInfo> measurements;
+	QList<AMnDIndex> measurementStarts, measurementEnds;
+
+	for(int m = 0; m < measurementCount; m++){
+
+		AMMeasurementInfo measurement = store->measurementAt(m);
+		AMnDIndex start = measurement.rank() > 0 ? AMnDIndex(measurement.rank(), AMnDIndex::DoInit, 0) : AMnDIndex();
+		AMnDIndex end = measurement.size();
+		for(int mu = 0; mu < measurement.rank(); mu++)
+			end[mu] = end.at(mu)-1;
+
+		measurements << measurement;
+		measurementStarts << start;
+		measurementEnds << end;
+	}
+
+	AMnDIndex scanSize = store->scanSize();
+	AMnDIndex scanIndex = scanRank > 0 ? AMnDIndex(scanRank, AMnDIndex::DoInit, 0) : AMnDIndex();
+	QVector<double> lastAxisValues(scanRank, 0);
+	qint64 time = 0;
+	int point = 0;
+
+	forever {
+
+		for(int mu = 0; mu < scanRank; mu++){
+
+			double axisValue = store->axisValue(mu, scanIndex.at(mu));
+
+			if(point == 0 || axisValue != lastAxisValues.at(mu)){
+
+				QString controlName = store->scanAxisAt(mu).name;
+				recording.append(AMScanReplayEvent::fromControlValue(time, controlName, axisValue));
+				recording.append(AMScanReplayEvent::fromMessage(time, AMAgnosticDataAPIControlMovedMessage(controlName, "Absolute", axisValue)));
+				lastAxisValues[mu] = axisValue;
+			}
+		}
+
+		// The readings arrive at the end of the dwell.
+		time += pointTime;
+
+		for(int m = 0; m < measurementCount; m++){
+
+			const AMMeasurementInfo &measurement = measurements.at(m);
+			QVector<double> values(int(measurement.size().product()));
+
+			if(!store->values(scanIndex, scanIndex, m, measurementStarts.at(m), measurementEnds.at(m), values.data()))
+				continue;
+
+			recording.append(AMScanReplayEvent::fromDetectorReading(time, measurement.name, measurement.size(), values));
+
+			QList<int> sizes;
+			QStringList names, units;
+			foreach(AMAxisInfo axis, measurement.axes){
+
+				sizes << int(axis.size);
+				names << axis.name;
+				units << axis.units;
+			}
+
+			recording.append(AMScanReplayEvent::fromMessage(time, AMAgnosticDataAPIDataAvailableMessage(measurement.name, values.toList(), sizes, names, units)));
+		}
+
+		point++;
+		recording.append(AMScanReplayEvent::fromMessage(time, AMAgnosticDataAPILoopIncrementMessage(axisName, point)));
+
+		// Next scan point, last axis fastest.
+		int mu = scanRank-1;
+		for(; mu >= 0; mu--){
+
+			if(scanIndex.at(mu) < scanSize.at(mu)-1){
+
+				scanIndex[mu] = scanIndex.at(mu)+1;
+				break;
+			}
+
+			scanIndex[mu] = 0;
+		}
+
+		if(mu < 0)
+			break;
+	}
+
+	recording.append(AMScanReplayEvent::fromMessage(time, AMAgnosticDataAPIFinishAxisMessage(axisName)));
+
+	return recording;
+}
+
+// AMScanReplayRecorder
+///////////////////////////
+
+AMScanReplayRecorder::AMScanReplayRecorder(QObject *parent) :
+	QObject(parent)
+{
+	isRecording_ = false;
+}
+
+AMScanReplayRecorder::~AMScanReplayRecorder()
+{
+	if(handler_)
+		handler_->removeReceiver(this);
+}
+
+bool AMScanReplayRecorder::listenTo(const QString &handlerLookupKey)
+{
+	AMAgnosticDataMessageQEventHandler *handler = qobject_cast<AMAgnosticDataMessageQEventHandler*>(AMAgnosticDataAPISupport::handlerFromLookupKey(handlerLookupKey));
+
+	if(!handler){
+
+		AMErrorMon::alert(this, AMSCANREPLAY_CANNOT_LISTEN_TO_HANDLER, QString("Could not record the scan messages: there is no '%1' message handler to listen to.").arg(handlerLookupKey));
+		return false;
+	}
+
+	if(handler_)
+		handler_->removeReceiver(this);
+
+	handler_ = handler;
+	handler_->addReceiver(this);
+
+	return true;
+}
+
+void AMScanReplayRecorder::addDetector(AMDetector *detector)
+{
+	connect(detector, SIGNAL(newValuesAvailable()), this, SLOT(onDetectorNewValuesAvailable()));
+}
+
+void AMScanReplayRecorder::addControl(AMControl *control)
+{
+	connect(control, SIGNAL(valueChanged(double)), this, SLOT(onControlValueChanged(double)));
+}
+
+void AMScanReplayRecorder::startRecording()
+{
+	recording_.clear();
+	recordingTime_.start();
+	isRecording_ = true;
+}
+
+void AMScanReplayRecorder::onDetectorNewValuesAvailable()
+{
+	AMDetector *detector = qobject_cast<AMDetector*>(sender());
+
+	if(!isRecording_ || !detector || !detector->data())
+		return;
+
+	AMnDIndex size = detector->size();
+	int count = int(size.product());
+	QVector<double> values(count);
+	memcpy(values.data(), detector->data(), count*sizeof(double));
+
+	recording_.append(AMScanReplayEvent::fromDetectorReading(recordingTime_.elapsed(), detector->name(), size, values));
+}
+
+void AMScanReplayRecorder::onControlValueChanged(double value)
+{
+	AMControl *control = qobject_cast<AMControl*>(sender());
+
+	if(!isRecording_ || !control)
+		return;
+
+	recording_.append(AMScanReplayEvent::fromControlValue(recordingTime_.elapsed(), control->name(), value));
+}
+
+bool AMScanReplayRecorder::event(QEvent *e)
+{
+	if(e->type() == (QEvent::Type)AMAgnosticDataAPIDefinitions::MessageEvent){
+
+		if(isRecording_)
+			recording_.append(AMScanReplayEvent::fromMessage(recordingTime_.elapsed(), ((AMAgnositicDataEvent*)e)->message_));
+
+		e->accept();
+		return true;
+	}
+
+	return QObject::event(e);
+}
+
+// AMScanReplayer
+/////////////////////
+
+AMScanReplayer::AMScanReplayer(const AMScanReplayRecording &recording, QObject *parent) :
+	QObject(parent)
+{
+	recording_ = recording;
+	speed_ = 1.0;
+	runningSpeed_ = 1.0;
+	isRunning_ = false;
+	nextEvent_ = 0;
+	elapsedTime_ = 0;
+
+	playTimer_.setSingleShot(true);
+	connect(&playTimer_, SIGNAL(timeout()), this, SLOT(playDueEvents()));
+}
+
+void AMScanReplayer::setRecording(const AMScanReplayRecording &recording)
+{
+	if(isRunning_)
+		return;
+
+	recording_ = recording;
+	nextEvent_ = 0;
+
+	foreach(AMReplayDetector *detector, detectors_)
+		detector->setReadings(recording_.detectorReadings(detector->name()));
+}
+
+void AMScanReplayer::addReceiver(QObject *receiver)
+{
+	if(receiver && !receivers_.contains(receiver))
+		receivers_ << receiver;
+}
+
+void AMScanReplayer::removeReceiver(QObject *receiver)
+{
+	receivers_.removeAll(receiver);
+}
+
+void AMScanReplayer::addDetector(AMReplayDetector *detector)
+{
+	if(!detector || detectors_.contains(detector))
+		return;
+
+	detectors_ << detector;
+	detector->setTimeScale(speed_);
+	detector->setReadings(recording_.detectorReadings(detector->name()));
+}
+
+void AMScanReplayer::addControl(AMReplayControl *control)
+{
+	if(!control || controls_.contains(control))
+		return;
+
+	controls_ << control;
+	control->setTimeScale(speed_);
+}
+
+void AMScanReplayer::createMocks()
+{
+	foreach(QString name, recording_.detectorNames())
+		if(!detectorNamed(name))
+			addDetector(new AMReplayDetector(name, name, recording_.detectorAxes(name), 0, this));
+
+	foreach(QString name, recording_.controlNames())
+		if(!controlNamed(name))
+			addControl(new AMReplayControl(name, "", 0, 0, this));
+}
+
+AMReplayDetector* AMScanReplayer::detectorNamed(const QString &name) const
+{
+	foreach(AMReplayDetector *detector, detectors_)
+		if(detector->name() == name)
+			return detector;
+
+	return 0;
+}
+
+AMReplayControl* AMScanReplayer::controlNamed(const QString &name) const
+{
+	foreach(AMReplayControl *control, controls_)
+		if(control->name() == name)
+			return control;
+
+	return 0;
+}
+
+double AMScanReplayer::eventsPerSecond() const
+{
+	int elapsed = elapsedTime();
+	if(elapsed <= 0)
+		return 0;
+
+	return double(nextEvent_)*1000.0/double(elapsed);
+}
+
+void AMScanReplayer::setSpeed(double speed)
+{
+	speed_ = qMax(0.0, speed);
+
+	foreach(AMReplayDetector *detector, detectors_)
+		detector->setTimeScale(speed_);
+	foreach(AMReplayControl *control, controls_)
+		control->setTimeScale(speed_);
+
+}
+
+bool AMScanReplayer::start()
+{
+	if(isRunning_)
+		return false;
+
+	isRunning_ = true;
+	nextEvent_ = 0;
+	runningSpeed_ = speed_;
+	elapsedTimer_.start();
+
+	playDueEvents();
+	return true;
+}
+
+void AMScanReplayer::stop()
+{
+	if(!isRunning_)
+		return;
+
+	playTimer_.stop();
+	elapsedTime_ = elapsedTimer_.elapsed();
+	isRunning_ = false;
+}
+
+void AMScanReplayer::playDueEvents()
+{
+	playTimer_.stop();
+
+	const QList<AMScanReplayEvent> &events = recording_.events();
+	int eventCount = events.count();
+
+	// At full speed, everything is due right away.
+	if(runningSpeed_ == 0){
+
+		while(nextEvent_ < eventCount)
+			playEvent(events.at(nextEvent_++));
+	}
+
+	else {
+
+		double replayTime = elapsedTimer_.elapsed()*runningSpeed_;
+
+		while(nextEvent_ < eventCount && events.at(nextEvent_).time <= replayTime)
+			playEvent(events.at(nextEvent_++));
+
+		if(nextEvent_ < eventCount){
+
+			playTimer_.start(qMax(0, int((events.at(nextEvent_).time - replayTime)/runningSpeed_)));
+			return;
+		}
+	}
+
+	elapsedTime_ = elapsedTimer_.elapsed();
+	isRunning_ = false;
+	emit finished();
+}
+
+void AMScanReplayer::playEvent(const AMScanReplayEvent &event)
+{
+	switch(event.kind){
+
+	case AMScanReplayEvent::Message: {
+
+		AMAgnosticDataAPIMessage message = event.toMessage();
+
+		foreach(QPointer<QObject> receiver, receivers_){
+
+			if(receiver){
+
+				AMAgnositicDataEvent *dataEvent = new AMAgnositicDataEvent();
+				dataEvent->message_ = message;
+				QCoreApplication::postEvent(receiver, dataEvent);
+			}
+		}
+
+		break;
+	}
+
+	case AMScanReplayEvent::ControlValue: {
+
+		AMReplayControl *control = controlNamed(event.name);
+		if(control)
+			control->setReplayedValue(event.controlValue);
+
+		break;
+	}
+
+	case AMScanReplayEvent::DetectorReading:
+		// Detector readings are queued in the mock detectors, and served when they are triggered.
+		break;
+	}
+}
@@ -0,0 +1,270 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMSCANREPLAY_H
+#define AMSCANREPLAY_H
+
+#include <QObject>
+#include <QVariantMap>
+#include <QVector>
+#include <QStringList>
+#include <QTime>
+#include <QTimer>
+#include <QPointer>
+
+#include "acquaman/AMAgnosticDataAPI.h"
+#include "dataman/AMAxisInfo.h"
+#include "dataman/AMnDIndex.h"
+
+class AMScan;
+class AMDetector;
+class AMControl;
+class AMReplayDetector;
+class AMReplayControl;
+
+#define AMSCANREPLAY_CANNOT_OPEN_RECORDING 291001
+#define AMSCANREPLAY_CANNOT_READ_RECORDING 291002
+#define AMSCANREPLAY_CANNOT_LISTEN_TO_HANDLER 291003
+
+/// One thing that happened during a recorded scan: an AMAgnosticDataAPI message, a detector reading, or a new control value.
+class AMScanReplayEvent
+{
+public:
+	/// The kinds of events in a recording.
+	enum Kind { Message = 0, DetectorReading = 1, ControlValue = 2 };
+
+	/// Constructs an empty message event.
+	AMScanReplayEvent() { time = 0; kind = Message; messageType = AMAgnosticDataAPIDefinitions::InvalidMessage; controlValue = 0; }
+
+	/// Creates a Message event at \c time (ms since the start of the recording) from an AMAgnosticDataAPI \c message.
+	static AMScanReplayEvent fromMessage(qint64 time, const AMAgnosticDataAPIMessage &message);
+	/// Creates a DetectorReading event at \c time for the detector \c detectorName, with the shape \c size (an invalid AMnDIndex for a single point) and \c values.
+	static AMScanReplayEvent fromDetectorReading(qint64 time, const QString &detectorName, const AMnDIndex &size, const QVector<double> &values);
+	/// Creates a ControlValue event at \c time for the control \c controlName.
+	static AMScanReplayEvent fromControlValue(qint64 time, const QString &controlName, double value);
+
+	/// Rebuilds the AMAgnosticDataAPI message of a Message event.
+	AMAgnosticDataAPIMessage toMessage() const;
+
+	/// Time of the event, in ms since the start of the recording.
+	qint64 time;
+	Kind kind;
+	/// The unique ID of the message, or the name of the detector or control.
+	QString name;
+
+	/// Message events: the message type and its JSON data.
+	AMAgnosticDataAPIDefinitions::MessageType messageType;
+	QVariantMap messageData;
+
+	/// DetectorReading events: the size along each detector axis (empty for a single point), and the values in row-major order.
+	QList<int> readingSize;
+	QVector<double> readingValues;
+
+	/// ControlValue events: the new value.
+	double controlValue;
+};
+
+/// A time-ordered list of AMScanReplayEvent, which can be saved, loaded, and played back by an AMScanReplayer.
+/*! Recordings come from two places:
+
+- AMScanReplayRecorder captures them live on the beamline, by listening to the AMAgnosticDataAPI messages sent to the scan controllers, and to the detectors and controls used by a scan.
+- fromScan() synthesizes one from any scan that has already been saved (SGM fast scans, XRF maps, XES images, ...), producing the messages and readings an action-based scan controller would have received while acquiring it.
+*/
+class AMScanReplayRecording
+{
+public:
+	/// Creates an empty recording.
+	AMScanReplayRecording() {}
+
+	/// The events, in time order.
+	const QList<AMScanReplayEvent>& events() const { return events_; }
+	/// The number of events.
+	int eventCount() const { return events_.count(); }
+	/// Returns true if there are no events.
+	bool isEmpty() const { return events_.isEmpty(); }
+	/// The time of the last event, in ms.
+	qint64 duration() const { return events_.isEmpty() ? 0 : events_.last().time; }
+
+	/// Adds an event.  Events must be added in time order.
+	void append(const AMScanReplayEvent &event) { events_ << event; }
+	/// Removes all the events.
+	void clear() { events_.clear(); }
+
+	/// The names of all the detectors with readings in the recording, in the order they first appear.
+	QStringList detectorNames() const;
+	/// The names of all the controls with values in the recording, in the order they first appear.
+	QStringList controlNames() const;
+	/// All the readings for \c detectorName, in order.
+	QList<QVector<double> > detectorReadings(const QString &detectorName) const;
+	/// The shape of the readings for \c detectorName, as a list of axes named "axis0", "axis1", etc.  Empty for a single-point detector.
+	QList<AMAxisInfo> detectorAxes(const QString &detectorName) const;
+
+	/// Writes the recording to \c filePath.  Returns false if the file could not be written.
+	bool save(const QString &filePath) const;
+	/// Replaces this recording with the one in \c filePath.  Returns false if the file could not be read.
+	bool load(const QString &filePath);
+
+	/// Synthesizes the recording of an action-based scan acquiring \c scan, with \c pointTime ms between scan points.
+	/*! For each scan point, in order: a ControlValue event and a ControlMoved message for every scan axis that changed (using the axis name as the control name), then a DetectorReading event and a DataAvailable message for every measurement (using the measurement name), then a LoopIncremented message.  The recording starts with an AxisStarted message and ends with an AxisFinished message, both named after the first scan axis.
+	*/
+	static AMScanReplayRecording fromScan(const AMScan *scan, int pointTime = 100);
+
+protected:
+	QList<AMScanReplayEvent> events_;
+};
+
+/// This class records the AMAgnosticDataAPI messages, detector readings, and control values of a live scan, into an AMScanReplayRecording.
+/*! To record the messages sent to action-based scan controllers, call listenTo() (by default, the "ScanActions" handler they use).  The recorder then receives a copy of every message, just like the scan controllers do.  Detectors and controls are added with addDetector() and addControl(); their readings and values are recorded whenever they change.
+
+Event times are measured from startRecording().
+*/
+class AMScanReplayRecorder : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.
+	AMScanReplayRecorder(QObject *parent = 0);
+	/// Stops listening to the message handler.
+	virtual ~AMScanReplayRecorder();
+
+	/// Starts receiving the messages posted to the AMAgnosticDataMessageQEventHandler registered as \c handlerLookupKey.  Returns false if there is no such handler.
+	bool listenTo(const QString &handlerLookupKey = "ScanActions");
+	/// Records a reading every time \c detector has new values.
+	void addDetector(AMDetector *detector);
+	/// Records a value every time \c control changes.
+	void addControl(AMControl *control);
+
+	/// The recording so far.
+	const AMScanReplayRecording& recording() const { return recording_; }
+	/// Returns true between startRecording() and stopRecording().
+	bool isRecording() const { return isRecording_; }
+
+public slots:
+	/// Clears the recording and starts recording again.
+	void startRecording();
+	/// Stops recording.  Anything that happens afterward is ignored.
+	void stopRecording() { isRecording_ = false; }
+
+protected slots:
+	/// Records the new reading of the detector that sent the signal.
+	void onDetectorNewValuesAvailable();
+	/// Records the new value of the control that sent the signal.
+	void onControlValueChanged(double value);
+
+protected:
+	/// Records AMAgnosticDataAPI messages.
+	bool event(QEvent *e);
+
+	AMScanReplayRecording recording_;
+	bool isRecording_;
+	/// Measures event times.
+	QTime recordingTime_;
+	/// The handler we're listening to.
+	QPointer<AMAgnosticDataMessageQEventHandler> handler_;
+};
+
+/// This class plays an AMScanReplayRecording back into scan controllers, mock detectors and mock controls, with the original timing or faster.
+/*! Nobody can profile or regression-test a scan controller without a beamline, because the data it ingests comes from hardware.  The replayer recreates that data:
+
+- Message events are posted (as AMAgnositicDataEvent, exactly like AMAgnosticDataMessageQEventHandler does) to every receiver added with addReceiver().  Any QObject that ingests AMAgnosticDataAPI messages can be a receiver, including the action-based scan controllers.
+- ControlValue events are played into the AMReplayControl with the same name (see addControl()), so that anything watching the control's feedback sees the recorded values.
+- Detector readings are not played on the timeline: they are queued in the AMReplayDetector with the same name (see addDetector()), which serves them one at a time as the scan controller's actions trigger it.
+
+Events are played at their recorded time divided by the speed(): 1 reproduces the original timing, 10 plays ten times faster, and 0 plays everything as fast as possible.  The speed is also passed on to the mock detectors and controls, so their dwell and move times scale the same way.  When the last event has been played, finished() is emitted, and elapsedTime() tells how long the replay took; with a speed of 0, that is the time the receivers needed to ingest the whole recording.
+*/
+class AMScanReplayer : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.
+	AMScanReplayer(const AMScanReplayRecording &recording = AMScanReplayRecording(), QObject *parent = 0);
+
+	/// The recording being replayed.
+	const AMScanReplayRecording& recording() const { return recording_; }
+	/// Replaces the recording.  Does nothing while a replay is running.
+	void setRecording(const AMScanReplayRecording &recording);
+
+	/// Adds a QObject that receives the recorded messages as AMAgnositicDataEvent events.
+	void addReceiver(QObject *receiver);
+	/// Removes a receiver added with addReceiver().
+	void removeReceiver(QObject *receiver);
+	/// Adds a mock detector.  Its queue of readings is filled with the recorded readings for its name, and its time scale follows the speed().
+	void addDetector(AMReplayDetector *detector);
+	/// Adds a mock control.  It receives the recorded values for its name, and its time scale follows the speed().
+	void addControl(AMReplayControl *control);
+
+	/// Creates an AMReplayDetector for every detector in the recording, and an AMReplayControl for every control, and adds them.  The replayer owns them.
+	void createMocks();
+	/// The mock detectors and controls that have been added.
+	QList<AMReplayDetector*> detectors() const { return detectors_; }
+	QList<AMReplayControl*> controls() const { return controls_; }
+	/// Returns the mock detector or control called \c name, or 0 if there isn't one.
+	AMReplayDetector* detectorNamed(const QString &name) const;
+	AMReplayControl* controlNamed(const QString &name) const;
+
+	/// The factor that recorded times are divided by.
+	double speed() const { return speed_; }
+	/// Returns true while a replay is running.
+	bool isRunning() const { return isRunning_; }
+	/// The number of events played so far.
+	int playedEventCount() const { return nextEvent_; }
+	/// The time (in ms) the last replay took, or has taken so far.
+	int elapsedTime() const { return isRunning_ ? elapsedTimer_.elapsed() : elapsedTime_; }
+	/// The number of events played per second during the last replay.
+	double eventsPerSecond() const;
+
+public slots:
+	/// Sets the factor that recorded times are divided by: 1 for the original timing, 10 for ten times faster, 0 for as fast as possible.  The mock detectors and controls change speed right away; the timeline of a running replay changes speed at the next start().
+	void setSpeed(double speed);
+	/// Starts playing the recording from the beginning.  Returns false if it is already running.
+	bool start();
+	/// Stops the replay.  finished() is not emitted.
+	void stop();
+
+signals:
+	/// Emitted after the last event has been played.
+	void finished();
+
+protected slots:
+	/// Plays every event that is due, and schedules the next one.
+	void playDueEvents();
+
+protected:
+	/// Plays one event.
+	void playEvent(const AMScanReplayEvent &event);
+
+	AMScanReplayRecording recording_;
+	QList<QPointer<QObject> > receivers_;
+	QList<AMReplayDetector*> detectors_;
+	QList<AMReplayControl*> controls_;
+
+	double speed_;
+	/// The speed of the replay that is running.
+	double runningSpeed_;
+	bool isRunning_;
+	int nextEvent_;
+	int elapsedTime_;
+	QTime elapsedTimer_;
+	/// Fires when the next event is due.
+	QTimer playTimer_;
+};
+
+#endif // AMSCANREPLAY_H
@@ -0,0 +1,52 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "CLSMAXvMotorContinuousMoveScanOptimizer.h"
+
+#include <math.h>
+
+#include "actions3/AMListAction3.h"
+#include "actions3/actions/AMControlMoveAction3.h"
+#include "actions3/actions/AMContinuousRegionActionInfo.h"
+#include "beamline/CLS/CLSMAXvMotor.h"
+
+CLSMAXvMotorContinuousMoveScanOptimizer::CLSMAXvMotorContinuousMoveScanOptimizer(AMAction3 *scanActionTree, QObject *parent) :
+	AMContinuousMoveScanOptimizer(scanActionTree, parent)
+{
+}
+
+AMAction3* CLSMAXvMotorContinuousMoveScanOptimizer::createContinuousMoveAction(AMControl *axisControl, const AMContinuousRegionActionInfo *regionInfo) const{
+	CLSMAXvMotor *motor = qobject_cast<CLSMAXvMotor*>(axisControl);
+	if(!motor || !motor->isConnected() || regionInfo->regionTime() <= 0 || regionInfo->regionStep() == 0)
+		return 0; //NULL
+
+	AMAction3 *regionVelocity = motor->createEGUVelocityAction3(fabs(regionInfo->regionStep())/regionInfo->regionTime());
+	AMAction3 *restoreVelocity = motor->createEGUVelocityAction3(motor->EGUVelocity());
+
+	AMControlInfo regionEndSetpoint = motor->toInfo();
+	regionEndSetpoint.setValue(regionInfo->regionEnd());
+	AMAction3 *regionMove = new AMControlMoveAction3(new AMControlMoveActionInfo3(regionEndSetpoint), motor);
+
+	AMListAction3 *retVal = new AMListAction3(new AMListActionInfo3(QString("Continuous Move %1").arg(motor->name()), QString("Move %1 to %2 at %3 per second").arg(motor->name()).arg(regionInfo->regionEnd()).arg(fabs(regionInfo->regionStep())/regionInfo->regionTime())), AMListAction3::Sequential);
+	retVal->addSubAction(regionVelocity);
+	retVal->addSubAction(regionMove);
+	retVal->addSubAction(restoreVelocity);
+
+	return retVal;
+}
@@ -0,0 +1,41 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CLSMAXVMOTORCONTINUOUSMOVESCANOPTIMIZER_H
+#define CLSMAXVMOTORCONTINUOUSMOVESCANOPTIMIZER_H
+
+#include "acquaman/AMContinuousMoveScanOptimizer.h"
+
+/// This AMContinuousMoveScanOptimizer rewrites regions whose axis is a CLSMAXvMotor.
+/*! The motor's EGU velocity is set to one step per dwell time (|regionStep()|/regionTime()) before it moves to the end of the region, and set back to what it was when the scan was optimized afterwards, so the remaining step moves run at their usual speed.  Regions on any other kind of control, or without a dwell time, are left as step loops.
+
+This is not installed by default.  Beamline app controllers that want it should add it with AMAppControllerSupport::prependPrincipleOptimizer().
+*/
+class CLSMAXvMotorContinuousMoveScanOptimizer : public AMContinuousMoveScanOptimizer
+{
+Q_OBJECT
+public:
+	CLSMAXvMotorContinuousMoveScanOptimizer(AMAction3 *scanActionTree = 0, QObject *parent = 0);
+
+protected:
+	/// Sets the velocity of the CLSMAXvMotor \c axisControl for the region, moves it to the region end, and restores the velocity.  Returns 0 if \c axisControl isn't a connected CLSMAXvMotor or the region has no dwell time.
+	virtual AMAction3* createContinuousMoveAction(AMControl *axisControl, const AMContinuousRegionActionInfo *regionInfo) const;
+};
+
+#endif // CLSMAXVMOTORCONTINUOUSMOVESCANOPTIMIZER_H
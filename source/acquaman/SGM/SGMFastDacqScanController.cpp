@@ -226,8 +226,9 @@ void SGMFastDacqScanController::cancelImplementation(){
 
 bool SGMFastDacqScanController::event(QEvent *e){
 	if(e->type() == (QEvent::Type)AM::AcqEvent){
-		QMap<int, double> aeData = ((AMAcqEvent*)e)->dataPackage_;
-		QMap<int, QList<double> > aeSpectra = ((AMAcqEvent*)e)->spectraPackage_;
+		// Only one point per fast scan, so the map forms are fine here.
+		QMap<int, double> aeData = ((AMAcqEvent*)e)->record_.scalarMap();
+		QMap<int, QList<double> > aeSpectra = ((AMAcqEvent*)e)->record_.spectrumMap();
 		QMap<int, double> aeExtras = ((AMAcqEvent*)e)->extraPackage_;
 		QMap<int, double>::const_iterator i = aeData.constBegin();
 		QMap<int, QList<double> >::const_iterator j = aeSpectra.constBegin();
@@ -432,8 +433,8 @@ bool SGMFastDacqScanController::event(QEvent *e){
 	*/
 }
 
-AMnDIndex SGMFastDacqScanController::toScanIndex(QMap<int, double> aeData){
-	Q_UNUSED(aeData)
+AMnDIndex SGMFastDacqScanController::toScanIndex(const AMAcqPointRecord &record){
+	Q_UNUSED(record)
 	// SGM XAS Scan has only one dimension (energy), simply append to the end of this
 	return AMnDIndex(scan_->rawData()->scanSize(0));
 }
@@ -74,7 +74,7 @@ protected:
 	/// Does all of the work to parse the full scan data from the scaler buffer. There's a lot of hardcoded information in here.
 	bool event(QEvent *e);
 	/// Simple scan index returns 1D scan size
-	AMnDIndex toScanIndex(QMap<int, double> aeData);
+	AMnDIndex toScanIndex(const AMAcqPointRecord &record);
 
 protected:
 	/// Tracks the progress through the scan
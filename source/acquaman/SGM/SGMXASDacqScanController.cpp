@@ -326,8 +326,8 @@ void SGMXASDacqScanController::cancelImplementation(){
 		AMDacqScanController::cancelImplementation();
 }
 
-AMnDIndex SGMXASDacqScanController::toScanIndex(QMap<int, double> aeData){
-	Q_UNUSED(aeData)
+AMnDIndex SGMXASDacqScanController::toScanIndex(const AMAcqPointRecord &record){
+	Q_UNUSED(record)
 	// SGM XAS Scan has only one dimension (energy), simply append to the end of this
 	return AMnDIndex(scan_->rawData()->scanSize(0));
 }
@@ -71,7 +71,7 @@ protected:
 	void cancelImplementation();
 
 	/// Simple scan index returns 1D scan size
-	AMnDIndex toScanIndex(QMap<int, double> aeData);
+	AMnDIndex toScanIndex(const AMAcqPointRecord &record);
 
 	/// A counter holding the current region index being scanned.
 	int currentRegionIndex_;
@@ -616,9 +616,9 @@ void VESPERSEXAFSDacqScanController::onDwellTimeTriggerChanged(double newValue)
 	}
 }
 
-AMnDIndex VESPERSEXAFSDacqScanController::toScanIndex(QMap<int, double> aeData)
+AMnDIndex VESPERSEXAFSDacqScanController::toScanIndex(const AMAcqPointRecord &record)
 {
-	Q_UNUSED(aeData)
+	Q_UNUSED(record)
 	return AMnDIndex(scan_->rawData()->scanSize(0));
 }
 
@@ -75,7 +75,7 @@ protected:
 	/// Method that cleans up the beamline after a scan is finished.  Makes a list of clean up actions and executes them.
 	void cleanup();
 
-	AMnDIndex toScanIndex(QMap<int, double> aeData);
+	AMnDIndex toScanIndex(const AMAcqPointRecord &record);
 
 	/// Adds all the data sources that are still important but not visualized.
 	void addExtraDatasources();
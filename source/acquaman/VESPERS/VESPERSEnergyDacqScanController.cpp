@@ -268,9 +268,9 @@ void VESPERSEnergyDacqScanController::onDwellTimeTriggerChanged(double newValue)
 	}
 }
 
-AMnDIndex VESPERSEnergyDacqScanController::toScanIndex(QMap<int, double> aeData)
+AMnDIndex VESPERSEnergyDacqScanController::toScanIndex(const AMAcqPointRecord &record)
 {
-	Q_UNUSED(aeData)
+	Q_UNUSED(record)
 	return AMnDIndex(scan_->rawData()->scanSize(0));
 }
 
@@ -236,6 +236,7 @@ public:
 	int acq_close() { if( bsp) return bsp->close(); return 0; }
 	int acq_next() { if( bsp) return bsp->next(); return 0; }
 	int acq_flush() { if( bsp) return bsp->flush(); return 0; }
+	int acq_sync() { if( bsp) return bsp->sync(); return 0; }
 	bool isReady() { if( bsp) return bsp->isReady(); return 0; }
 
 };
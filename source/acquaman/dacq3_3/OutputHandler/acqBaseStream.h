@@ -16,6 +16,9 @@ class acqBaseStream
 	virtual int open() = 0;
 	virtual int write(const void *base, unsigned int nbytes) = 0;
 	virtual int flush() = 0;
+	// flush() may only schedule the write (ex: a buffered stream with a background writer).
+	// sync() does not return until everything written so far has reached the output.
+	virtual int sync() { return flush(); }
 	virtual int offset() = 0;
 	virtual int close() = 0;
 	virtual int next() = 0;
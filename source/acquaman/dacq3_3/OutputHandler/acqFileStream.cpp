@@ -16,14 +16,28 @@
 
 static acqOutputStreamFactoryRegister myregister("File", acqFileStream::build_acqFileStream);
 
-acqFileStream::acqFileStream() : seqno(1), fp(NULL)
+acqFileStream::acqFileStream() : seqno(1), fp(NULL),
+	policy(FP_RECORD), flushBytes(64*1024), flushInterval(1.0),
+	writing(false), writeRequested(false), writerExit(false), writeError(0), acceptedOffset(0),
+	writerThread(NULL)
 {
+	bufferLock = epicsMutexCreate();
+	wakeWriter = epicsEventCreate(epicsEventEmpty);
+	writerIdle = epicsEventCreate(epicsEventEmpty);
+	writerExited = epicsEventCreate(epicsEventEmpty);
+
 	defProperty(PROP_FILE_PATH);
 	setProperty(PROP_FILE_PATH, ".");
 	defProperty(PROP_FILE_TEMPLATE);
 	setProperty(PROP_FILE_TEMPLATE, "acqdata.%03d.dat");
 	defProperty(PROP_SEQUENCE_NUMBER);
 	defProperty(PROP_OUTPUT_FILE);
+	defProperty(PROP_FLUSH_POLICY, "Record,Bytes,Time,Scan End");
+	setProperty(PROP_FLUSH_POLICY, "Record");
+	defProperty(PROP_FLUSH_BYTES);
+	setProperty(PROP_FLUSH_BYTES, "65536");
+	defProperty(PROP_FLUSH_INTERVAL);
+	setProperty(PROP_FLUSH_INTERVAL, "1.0");
 }
 
 acqBaseStream*
@@ -41,21 +55,45 @@ new_acqFileStream()
 
 acqFileStream::~acqFileStream()
 {
+	sync();
+	stopWriter();
 	if( fp && fp != stdout)
 		fclose(fp);
 	fp = NULL;
+
+	epicsEventDestroy(writerExited);
+	epicsEventDestroy(writerIdle);
+	epicsEventDestroy(wakeWriter);
+	epicsMutexDestroy(bufferLock);
 }
 
 int acqFileStream:: write( const void *base, unsigned int nbytes)
 {
-	if( fp)
+	if( !fp)
+		return -1;
+
+	if( !isBuffered() )
 	{
 		 int result = fwrite( base, nbytes, 1, fp);
 		 fflush(fp);
 		 return result;
 	}
-	
-	return -1;
+
+	// buffered: never touch the file on the caller's (dacq) thread.
+	epicsMutexLock(bufferLock);
+	if( writeError)
+	{
+		epicsMutexUnlock(bufferLock);
+		return -1;
+	}
+	pendingData.append( (const char *)base, nbytes);
+	acceptedOffset += nbytes;
+	bool wake = (policy == FP_BYTES && pendingData.size() >= flushBytes) || pendingData.size() >= FILESTREAM_MAX_PENDING_BYTES;
+	epicsMutexUnlock(bufferLock);
+
+	if( wake)
+		epicsEventSignal(wakeWriter);
+	return 1;
 }
 
 int acqFileStream:: open()
@@ -70,6 +108,12 @@ int acqFileStream:: open()
 		fp = stdout;
 		outputName = "< standard output >";
 	}
+	// with "a+" the position isn't at the end until the first write; offset() needs it now.
+	fseek(fp, 0, SEEK_END);
+	acceptedOffset = ftell(fp);
+	writeError = 0;
+	if( isBuffered() )
+		startWriter();
 	setProperty( PROP_OUTPUT_FILE, outputName);
 	if( getBaseOutput() )
 		getBaseOutput()->handlerSignal( acqFileStream_NewOutput, outputName.c_str() );
@@ -80,13 +124,21 @@ int acqFileStream:: open()
 
 int acqFileStream:: offset()
 {
-	if( fp)
-		return ftell(fp);
-	return 0;
+	if( !fp)
+		return 0;
+	if( isBuffered() )
+	{
+		epicsMutexLock(bufferLock);
+		long result = acceptedOffset;
+		epicsMutexUnlock(bufferLock);
+		return result;
+	}
+	return ftell(fp);
 }
 
 int acqFileStream:: close()
 {
+	sync();
 	if( fp && fp != stdout)
 		fclose(fp);
 	fp = NULL;
@@ -94,13 +146,111 @@ int acqFileStream:: close()
 	return 0;
 }
 
+// with a buffered policy, the background writer decides when to write; see sync() to wait for it.
 int acqFileStream:: flush()
 {
-	if( fp)
+	if( fp && !isBuffered() )
 		return fflush( fp);
 	return 0;
 }
 
+// wait until everything accepted by write() is in the file.
+int acqFileStream:: sync()
+{
+	if( !writerThread)
+		return flush();
+
+	epicsMutexLock(bufferLock);
+	writeRequested = true;
+	while( !pendingData.empty() || writing)
+	{
+		epicsMutexUnlock(bufferLock);
+		epicsEventSignal(wakeWriter);
+		epicsEventWait(writerIdle);
+		epicsMutexLock(bufferLock);
+	}
+	writeRequested = false;
+	int result = writeError ? -1 : 0;
+	epicsMutexUnlock(bufferLock);
+	return result;
+}
+
+void acqFileStream::startWriter()
+{
+	if( writerThread)
+		return;
+	writerExit = false;
+	writerThread = epicsThreadCreate("acqFileStream", epicsThreadPriorityLow, epicsThreadGetStackSize(epicsThreadStackSmall), (EPICSTHREADFUNC)writerTask, this);
+	if( !writerThread)
+	{
+		// no background writer: fall back to writing every record.
+		policy = FP_RECORD;
+		acqBaseStream::setProperty(PROP_FLUSH_POLICY, "Record");
+	}
+}
+
+void acqFileStream::stopWriter()
+{
+	if( !writerThread)
+		return;
+	epicsMutexLock(bufferLock);
+	writerExit = true;
+	epicsMutexUnlock(bufferLock);
+	epicsEventSignal(wakeWriter);
+	epicsEventWait(writerExited);
+	writerThread = NULL;
+}
+
+void acqFileStream::writerTask(void *arg)
+{
+	((acqFileStream *)arg)->writerLoop();
+}
+
+void acqFileStream::writerLoop()
+{
+	std::string batch;
+
+	for(;;)
+	{
+		if( policy == FP_TIME)
+			epicsEventWaitWithTimeout(wakeWriter, flushInterval);
+		else
+			epicsEventWait(wakeWriter);
+
+		epicsMutexLock(bufferLock);
+		while( !pendingData.empty() )
+		{
+			batch.swap(pendingData);
+			writing = true;
+			epicsMutexUnlock(bufferLock);
+
+			int failed = 0;
+			if( fp)
+			{
+				failed = fwrite( batch.data(), batch.size(), 1, fp) != 1;
+				failed |= fflush(fp) != 0;
+			}
+			DEBUG(this) printf("acqFileStream writer: %u bytes%s\n", (unsigned int)batch.size(), failed ? " FAILED" : "");
+			batch.clear();
+
+			epicsMutexLock(bufferLock);
+			writing = false;
+			if( failed)
+				writeError = 1;
+		}
+		bool exitNow = writerExit;
+		bool someoneWaiting = writeRequested;
+		epicsMutexUnlock(bufferLock);
+
+		if( someoneWaiting)
+			epicsEventSignal(writerIdle);
+		if( exitNow)
+			break;
+	}
+
+	epicsEventSignal(writerExited);
+}
+
 int acqFileStream:: next()
 {
 	close();
@@ -189,6 +339,33 @@ acqFileStream:: setProperty( const std::string name, const std::string value)
 		seqno = atoi( value.c_str() );
 	else if( name == PROP_OUTPUT_FILE)
 		outputName = value;
+	else if( name == PROP_FLUSH_POLICY)
+	{
+		flushPolicy newPolicy = FP_RECORD;
+		if( value == "Bytes")
+			newPolicy = FP_BYTES;
+		else if( value == "Time")
+			newPolicy = FP_TIME;
+		else if( value == "Scan End")
+			newPolicy = FP_SCAN_END;
+		if( newPolicy != policy)
+		{
+			// the writer thread reads the policy, so switch only once it's stopped.
+			sync();
+			stopWriter();
+			policy = newPolicy;
+			if( fp && isBuffered() )
+				startWriter();
+		}
+	}
+	else if( name == PROP_FLUSH_BYTES)
+		flushBytes = atoi( value.c_str() );
+	else if( name == PROP_FLUSH_INTERVAL)
+	{
+		flushInterval = atof( value.c_str() );
+		if( flushInterval <= 0)
+			flushInterval = 1.0;
+	}
 	else
 		return 0;
 	return 1;
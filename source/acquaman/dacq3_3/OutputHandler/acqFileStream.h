@@ -4,6 +4,11 @@
 // Copyright 2008 Canadian Light Source, Inc. All Rights Reserved
 //
 #include <string>
+#include <stdio.h>
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
 
 #include "acqBaseStream.h"
 
@@ -16,6 +21,7 @@ class acqFileStream : acqBaseStream
 	virtual int close();
 	virtual int next();
 	virtual int flush();
+	virtual int sync();
 	virtual int offset();
 	virtual bool isReady();
 	virtual std::string &streamName();
@@ -39,6 +45,34 @@ class acqFileStream : acqBaseStream
 	std::string outputName;
 	unsigned int seqno;
 	FILE *fp;
+
+	// Buffered output: an fflush() after every record ties the scan to file-server latency (ex: on NFS).
+	// With any policy other than FP_RECORD, write() only appends to pendingData, and a background thread
+	// does the fwrite()/fflush() when the policy says so. sync(), close() and next() wait for everything to be written.
+	enum flushPolicy { FP_RECORD, FP_BYTES, FP_TIME, FP_SCAN_END };
+
+	bool isBuffered() const { return policy != FP_RECORD; }
+	void startWriter();
+	void stopWriter();
+	static void writerTask(void *arg);
+	void writerLoop();
+
+	flushPolicy policy;
+	unsigned int flushBytes;		// FP_BYTES: write once this much is waiting
+	double flushInterval;			// FP_TIME: write this often (seconds)
+
+	std::string pendingData;		// accepted by write(), not yet handed to the writer
+	bool writing;				// the writer is in the middle of an fwrite()
+	bool writeRequested;			// someone is waiting in sync()
+	bool writerExit;
+	int writeError;				// set by the writer when an fwrite() fails
+	long acceptedOffset;			// the file offset after everything accepted so far
+
+	epicsMutexId bufferLock;
+	epicsEventId wakeWriter;
+	epicsEventId writerIdle;
+	epicsEventId writerExited;
+	epicsThreadId writerThread;
 };
 
 extern "C" {
@@ -56,5 +90,11 @@ extern "C" {
 #define PROP_FILE_PATH "File Path"
 #define PROP_SEQUENCE_NUMBER "Sequence Number"
 #define PROP_OUTPUT_FILE "Output File"
+#define PROP_FLUSH_POLICY "Flush Policy"	// Record (default), Bytes, Time, or Scan End
+#define PROP_FLUSH_BYTES "Flush Bytes"
+#define PROP_FLUSH_INTERVAL "Flush Interval"	// in seconds
+
+// Even with the "Scan End" policy, write once this much is waiting so memory use stays bounded.
+#define FILESTREAM_MAX_PENDING_BYTES (16*1024*1024)
 
 #endif
@@ -194,10 +194,12 @@ int acqTextOutput::resume( acqKey_t /*key*/)
 {
 	return 0;
 }
-// Commented out because unused to avoid compiler warning (David Chevrier, Aug 25 2011)
-// end of the run
-int acqTextOutput::stop( acqKey_t /*key*/)
+// end of the run (completed or aborted): make sure a buffered stream has written everything.
+int acqTextOutput::stop( acqKey_t key)
 {
+	acqTextOutput *to = (acqTextOutput *)key;
+	DEBUG(to) printf("stop(%p)\n", key);
+	to->acq_sync();
 	return 0;
 }
 // system is shutting down. perform any necessary cleanup
@@ -131,6 +131,17 @@ int acqTextSpectrumOutput::pvFlags( acqKey_t key, int eventno, int pvno, const c
 	return 0;
 }
 
+// end of the run (completed or aborted): the spectrum file may be buffered too.
+int acqTextSpectrumOutput::stop( acqKey_t key)
+{
+	acqTextOutput::stop(key);
+
+	acqTextSpectrumOutput *to = (acqTextSpectrumOutput *)key;
+	if( to->spectrumStream)
+		to->spectrumStream->sync();
+	return 0;
+}
+
 // system is shutting down. perform any necessary cleanup
 int acqTextSpectrumOutput::shutdown( acqKey_t key)
 {
@@ -83,6 +83,7 @@ public:
 
 	static int startRepeat( acqKey_t key, int passno);
 	static int start( acqKey_t key);
+	static int stop( acqKey_t key);
 	static int shutdown( acqKey_t key);
 	static int startRecord( acqKey_t key, int eventno);
 	static int endRecord( acqKey_t key, int eventno);
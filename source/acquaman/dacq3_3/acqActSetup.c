@@ -210,6 +210,10 @@ build_eventRecord_links( acqEvent_t *ev)
 	char *dot, *lbracket;
 	char *realName;
 
+	/*
+	 * created before the connectors, as callback_eventPVstate() signals it.
+	 */
+	ev->connectNotify = epicsEventCreate(0);
 	for( i=0; i < ev->numPvList; i++)
 	{
 		apv = &ev->pvList[i];
@@ -295,6 +299,11 @@ erase_eventRecord_links( acqEvent_t *ev)
 		epicsEventDestroy(ev->monitorPvEvent);
 		ev->monitorPvEvent = 0;
 	}
+	if( ev->connectNotify)
+	{
+		epicsEventDestroy(ev->connectNotify);
+		ev->connectNotify = 0;
+	}
 	return;
 }
 
@@ -788,7 +797,7 @@ valid_scanRecord_settings( acqScan_t *as)
  ** build links for a scan record. Returns 1 on success, 0 if 1 or more links failed to be made.
  **/
 
-static int buildAction( acqAction_t *ap)
+static int buildAction( acqScan_t *sc, acqAction_t *ap)
 {
 	switch( ap->type)
 	{
@@ -796,11 +805,14 @@ static int buildAction( acqAction_t *ap)
 		return 1;
 
 	case AA_SET_PV:
-		ap->au.spv.connector = build_connector( NULL, ap->au.spv.name);
+		ap->au.spv.connector = build_connector( sc, ap->au.spv.name);
+		if( ap->au.spv.connector)
+			ap->au.spv.connector->newState = callback_scanPVstate;
 		return 1;
 
 	case AA_WAIT_PV:
-		ap->au.wpv.connector = build_connector( NULL, ap->au.wpv.name);
+		ap->au.wpv.connector = build_connector( sc, ap->au.wpv.name);
+		ap->au.wpv.connector->newState = callback_scanPVstate;
 		ap->au.wpv.waitFlag = 0;
 		ap->au.wpv.endDelay = epicsEventCreate(0);
 		ap->au.wpv.connector->update = callback_check_delay;
@@ -849,6 +861,11 @@ build_scanRecord_links(acqScan_t *sc)
 	char *controlPV = NULL;
 
 	DEBUGM(sc->master,1) printf("build_scanRecord_links\n");
+	/*
+	 * created before the connectors, as the connector callbacks signal them.
+	 */
+	sc->connectNotify = epicsEventCreate(0);
+	sc->pauseNotify = epicsEventCreate(0);
 	if( sc->acqControlList)
 	{
 		for(i=0; i < sc->numControlPV; i++)
@@ -857,9 +874,10 @@ build_scanRecord_links(acqScan_t *sc)
 				controlPV = sc->acqControlList[i].controlPV;
 			if( !controlPV)	/* should not happen: 'valid settings' checks this */
 				return 0;
-			sc->acqControlList[i].controlChan = build_connector( NULL, controlPV);
+			sc->acqControlList[i].controlChan = build_connector( sc, controlPV);
 			sc->acqControlList[i].controlChan->user_data = (void *) sc;
 			sc->acqControlList[i].controlChan->update = NULL;		/* set to callbacks for updates */
+			sc->acqControlList[i].controlChan->newState = callback_scanPVstate;
 		}
 	}
 
@@ -868,7 +886,7 @@ build_scanRecord_links(acqScan_t *sc)
 		acqAction_t *ap;
 		for( ap=sc->actions[i]; ap ; ap=(ap->next==sc->actions[i]?NULL:ap->next) )
 		{
-			if( buildAction( ap) == 0)
+			if( buildAction( sc, ap) == 0)
 			{
 				sc->master->messageAdd(sc->master, "can't link action %s type %d", tgTypeName(i), ap->type);
 				return 0;
@@ -969,6 +987,17 @@ erase_scanRecord_links(acqScan_t *sc)
 	{
 		eraseActionList(sc->actions[i]);
 	}
+	/* after the action connectors are gone, nothing else can signal these */
+	if( sc->connectNotify)
+	{
+		epicsEventDestroy(sc->connectNotify);
+		sc->connectNotify = 0;
+	}
+	if( sc->pauseNotify)
+	{
+		epicsEventDestroy(sc->pauseNotify);
+		sc->pauseNotify = 0;
+	}
 
 	return 0;
 }
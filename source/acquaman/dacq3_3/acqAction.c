@@ -9,6 +9,8 @@
 #include <math.h>
 
 static int WaitForEvent( epicsEventId e_event, volatile int *shutdown, volatile acqState *state, acqMaster_t *master );
+static void WaitForChange( epicsEventId e_event, double timeout);
+static void recordDeadTime( acqScan_t *acq, const epicsTimeStamp *pointStart);
 static void runAcqAction( acqScan_t *acq, acqAction_t *aap, Channel *chan, double outval);
 static int checkScanConnections(acqScan_t *acq);
 static int checkEventConnections(acqEvent_t *ev);
@@ -38,28 +40,35 @@ runAcqScan( acqScan_t *acq)
 	int controlCount;	/* index of current control structure for this scan */
 	Channel *chan;		/* connected channel for each iteration */
 	int inPause = 0;	/* non-zero while this scan is paused */
-	int initial_count;	/* loop counter when waiting on initialization */
 	int connect_result;	/* results of checking scan connections */
+	epicsTimeStamp connectStart;	/* when the initial wait for connections began */
+	epicsTimeStamp pointStart;	/* start of the current point, for the dead time */
+	epicsTimeStamp now;
 	
 	
 
 	VERBOSE(acq->master) printf("Scan %s\n", acq->scanName);
 	ca_attach_context( (struct ca_client_context *)acq->master->GlobalContext );
 	/*
-	 * wait for up to 5 seconds for connections to be good
+	 * wait for up to 5 seconds for connections to be good. The connectors
+	 * signal connectNotify as channels come up, so this finishes as soon as
+	 * the last one connects; the timeout only matters if a signal is missed.
 	 */
-	for(initial_count = 0; initial_count < 5; initial_count++)
+	epicsTimeGetCurrent( &connectStart);
+	connect_result = checkScanConnections(acq);
+	while( connect_result != 2)
 	{
-		epicsThreadSleep(1.0);
-		connect_result = checkScanConnections(acq);
-		if( connect_result == 2)
+		epicsTimeGetCurrent( &now);
+		if( epicsTimeDiffInSeconds( &now, &connectStart) >= 5.0)
 			break;
+		WaitForChange( acq->connectNotify, 1.0);
+		connect_result = checkScanConnections(acq);
 	}
 	
 	/* run this while waiting for 'Pause' connections */
 	while( connect_result == -1 || connect_result == 0)
 	{
-		epicsThreadSleep(0.1);
+		WaitForChange( acq->connectNotify, 0.1);
 		connect_result = checkScanConnections(acq);
 	}
 		
@@ -87,6 +96,8 @@ runAcqScan( acqScan_t *acq)
 		acq->currentControl = 0;		/* this value is only valid when RUN or PAUSE */
 		acq->state = AS_RUN;
 		acq->count = 0;
+		acq->deadTimePoints = 0;
+		acq->deadTimeTotal = acq->deadTimeMax = acq->deadTimeLast = 0.0;
 		runAcqAction( acq, acq->actions[ACQ_TG_BEGIN], NULL, 0.0);
 
 		for( controlCount=0; controlCount < acq->numControlPV; controlCount++)
@@ -149,7 +160,7 @@ runAcqScan( acqScan_t *acq)
 						break;
 					/* at this point, either an indefinite pause, or still waiting for a timeout */
 					acq->master->acqStatusMessage( acq->master, "Waiting for PV connection\n");
-					epicsThreadSleep(0.1);
+					WaitForChange( acq->connectNotify, 0.1);
 				}
 				
 				if( acq->master->globalShutdown )
@@ -172,7 +183,7 @@ runAcqScan( acqScan_t *acq)
 						runAcqAction( acq, acq->actions[ACQ_TG_PAUSE], NULL, 0.0);
 						HANDLERS(acq->master, odh->pause_cb(key) );
 					}
-					epicsThreadSleep(0.1);
+					WaitForChange( acq->pauseNotify, 0.1);
 				}
 				if( inPause)
 				{
@@ -180,6 +191,7 @@ runAcqScan( acqScan_t *acq)
 					runAcqAction( acq, acq->actions[ACQ_TG_PAUSE_END], NULL, 0.0);
 					HANDLERS(acq->master, odh->resume_cb(key) );
 				}
+				epicsTimeGetCurrent( &pointStart);
 				if( ctlp->deltaVal != userDelta)
 				{
 					/* if the user changes the delta value, and the sign is different, or
@@ -201,6 +213,7 @@ runAcqScan( acqScan_t *acq)
 				}
 				runAcqAction( acq, acq->actions[ACQ_TG_MOVE], chan, val);
 
+				recordDeadTime( acq, &pointStart);
 				runAcqAction( acq, acq->actions[ACQ_TG_DWELL], NULL, val);
 			}
 			if( fabs(lastout-ctlp->finalVal) > fabs(0.01*delta) )
@@ -212,13 +225,14 @@ runAcqScan( acqScan_t *acq)
 						inPause = 1;
 						runAcqAction( acq, acq->actions[ACQ_TG_PAUSE], NULL, 0.0);
 					}
-					epicsThreadSleep(0.5);
+					WaitForChange( acq->pauseNotify, 0.5);
 				}
 				if( inPause)
 				{
 					inPause = 0;
 					runAcqAction( acq, acq->actions[ACQ_TG_PAUSE_END], NULL, 0.0);
 				}
+				epicsTimeGetCurrent( &pointStart);
 				acq->count++;
 				if( acq->needSetControl)
 				{
@@ -227,11 +241,15 @@ runAcqScan( acqScan_t *acq)
 				}
 				runAcqAction( acq, acq->actions[ACQ_TG_MOVE], chan, ctlp->finalVal);
 
+				recordDeadTime( acq, &pointStart);
 				runAcqAction( acq, acq->actions[ACQ_TG_DWELL], NULL, ctlp->finalVal);
 			}
 			runAcqAction( acq, acq->actions[ACQ_TG_END_PASS], NULL, 0.0);
 			HANDLERS(acq->master, odh->endpass_cb(key) );
 		}
+		VERBOSE(acq->master) printf("Scan %s: %d points, dead time %.3f s (average %.1f ms, longest %.1f ms)\n",
+			acq->scanName, acq->deadTimePoints, acq->deadTimeTotal,
+			acq->deadTimePoints ? 1000.0*acq->deadTimeTotal/acq->deadTimePoints : 0.0, 1000.0*acq->deadTimeMax);
 		runAcqAction( acq, acq->actions[ACQ_TG_DONE], NULL, 0.0);
 		acq->state = AS_STANDBY;		/* ensure that a waiting task sees this task is no longer in 'run' mode */
 		epicsEventSignal( acq->endEvent);
@@ -545,8 +563,9 @@ runEvent( acqEvent_t *ev)
 	//char *separator;
 	//epicsTimeStamp startTime, curTime, prevTime;
 	epicsTimeStamp startTime, prevTime;
+	epicsTimeStamp connectStart, connectTime;
 	//double relTime;
-	int initial_count, connect_result;
+	int connect_result;
 	eventDataHandler_t *odh;	/* Output Data Handler */
 
 	VERBOSE(ev->master) printf("runEvent %s\n", ev->eventName);
@@ -554,17 +573,20 @@ runEvent( acqEvent_t *ev)
 	ca_attach_context( (struct ca_client_context *)ev->master->GlobalContext);
 
 	/* wait for up to 5 seconds for connections to be good */
-	for( initial_count = 0; initial_count < 5; initial_count++)
+	epicsTimeGetCurrent( &connectStart);
+	connect_result = checkEventConnections(ev);
+	while( connect_result != 2)
 	{
-		epicsThreadSleep(1.0);
-		connect_result = checkEventConnections(ev);
-		if( connect_result == 2)
+		epicsTimeGetCurrent( &connectTime);
+		if( epicsTimeDiffInSeconds( &connectTime, &connectStart) >= 5.0)
 			break;
+		WaitForChange( ev->connectNotify, 1.0);
+		connect_result = checkEventConnections(ev);
 	}
 	
 	while( connect_result == -1 || connect_result == 0)
 	{
-		epicsThreadSleep(0.1);
+		WaitForChange( ev->connectNotify, 0.1);
 		connect_result = checkEventConnections(ev);
 	}
 	
@@ -920,6 +942,41 @@ WaitForEvent( epicsEventId e_event, volatile int *shutdown, volatile acqState *s
 	}
 }
 
+/*
+ * wait for a state change to be signalled on e_event, for at most 'timeout' seconds.
+ * Callers re-check their condition on return, so a stale signal or a timeout
+ * only costs another pass through their loop. The timeout bounds the wait
+ * in case a signal is missed.
+ */
+static void
+WaitForChange( epicsEventId e_event, double timeout)
+{
+	if( e_event == NULL)
+		epicsThreadSleep( timeout);
+	else
+		epicsEventWaitWithTimeout( e_event, timeout);
+}
+
+/*
+ * accumulate the dead time for one point: from pointStart until now, just
+ * before the DWELL actions run.
+ */
+static void
+recordDeadTime( acqScan_t *acq, const epicsTimeStamp *pointStart)
+{
+	epicsTimeStamp now;
+	double dead;
+
+	epicsTimeGetCurrent( &now);
+	dead = epicsTimeDiffInSeconds( &now, pointStart);
+	acq->deadTimeLast = dead;
+	acq->deadTimeTotal += dead;
+	if( dead > acq->deadTimeMax)
+		acq->deadTimeMax = dead;
+	acq->deadTimePoints++;
+	DEBUGM(acq->master,1) printf("scan %s point %d dead time %.1f ms\n", acq->scanName, acq->count, 1000.0*dead);
+}
+
 /*
  * callback after a monitor is detected
  */
@@ -1000,6 +1057,22 @@ callback_check_delay( Connector *conp)
 		epicsEventSignal( delay->au.wpv.endDelay);
 }
 
+/*
+ * callback when the state of a scan PV changes (the control PV, or a
+ * SET_PV/WAIT_PV action). The connector's private data is the scan.
+ * Wakes the scan thread if it is waiting for connections.
+ */
+void
+callback_scanPVstate(Connector *conp)
+{
+	acqScan_t *acq;
+
+	acq = (acqScan_t *) conp->private_data;
+	if( acq == NULL || acq->connectNotify == NULL)
+		return;
+	epicsEventSignal( acq->connectNotify);
+}
+
 /*
  * callback when the state of an event PV changes.
  */
@@ -1021,6 +1094,8 @@ callback_eventPVstate(Connector *conp)
 	ap = (acqPv_t *)(conp->user_data);
 	if( ap->event == NULL)
 		return;
+	if( ap->event->connectNotify)
+		epicsEventSignal( ap->event->connectNotify);
 	// if not yet running, then don't update
 	if( ap->event->master->globalState == AS_RUN)
 	{
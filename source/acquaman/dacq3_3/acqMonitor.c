@@ -35,6 +35,21 @@ acqMonitor_init(acqMaster_t *master)
 	acqMonitor_putState(master, AS_OFF);
 }
 
+/*
+ * set or clear the global pause. Paused scan threads wait on their pauseNotify
+ * event, so signal each of them rather than letting them find out on a timeout.
+ */
+void
+acqMonitor_pause(acqMaster_t *master, int mode)
+{
+	acqScan_t *sc;
+
+	master->globalPause = mode;
+	for( sc = first_acqScan(master) ; sc ; sc=next_acqScan(sc) )
+		if( sc->pauseNotify)
+			epicsEventSignal( sc->pauseNotify);
+}
+
 void
 acqMonitor_putState(acqMaster_t *master, acqState mode)
 {
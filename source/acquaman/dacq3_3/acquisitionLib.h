@@ -255,12 +255,22 @@ struct acqScan {
 	epicsEventId startEvent, endEvent;	/* communication of event state change */
 	epicsEventId putNotify;			/* communication of completion of an epicsPut */
 	epicsEventId connectNotify;		/* communication of change of connection status */
+	epicsEventId pauseNotify;		/* communication of change of the global pause flag */
 	epicsThreadId threadID;
 	acqState state;
 	int needSetControl;	/* non-zero if the control point is set explicity in the MOVE trigger list */
 	int shutdown;		/* non-zero to end this thread */
 	int count;		/* keeps track of the number of loops */
 	int currentControl;	/* current control element */
+	/*
+	 * dead time: the time from the start of a point (after any pause) until
+	 * its DWELL actions begin. This covers the control put, the MOVE actions
+	 * and any waits on motors or PV's. Reset each time the scan is started.
+	 */
+	int deadTimePoints;	/* number of points measured */
+	double deadTimeTotal;	/* total dead time, in seconds */
+	double deadTimeMax;	/* longest dead time of a single point, in seconds */
+	double deadTimeLast;	/* dead time of the most recent point, in seconds */
 } ;
 
 void acqModifyScanControlEntry( acqScan_t *scanp, int index, ...);
@@ -501,6 +511,7 @@ void startMonitorTask(acqMaster_t *master);
 int acqMonitor_status(acqMaster_t *master);		/* NOTE: this is suitable for calling by gtk_timer() */
 void acqMonitor_init(acqMaster_t *master);
 void acqMonitor_putState(acqMaster_t *master, acqState state);
+void acqMonitor_pause(acqMaster_t *master, int mode);	/* set the global pause flag and wake the scan threads */
 /*
  * support for callbacks from the monitoring task
  */
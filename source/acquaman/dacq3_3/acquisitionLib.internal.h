@@ -39,6 +39,7 @@
  * the calling interval of acq_showStatus */
 #define MSEC_DELAY 500
 void callback_eventPVstate(Connector *conp);
+void callback_scanPVstate(Connector *conp);
 
 void callback_PVmonitor( Connector *);
 void callback_PVdescription( Connector *);
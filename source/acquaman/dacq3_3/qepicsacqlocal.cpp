@@ -331,7 +331,7 @@ QEpicsAcqLocal::Pause( int mode)
 {
 	if( !running)
 		return;
-	master->globalPause = mode;
+	acqMonitor_pause(master, mode);
 	if( mode)
 		showMode( AS_STANDBY);
 	else
@@ -348,8 +348,8 @@ QEpicsAcqLocal::Pause( int mode)
 void
 QEpicsAcqLocal::Stop()
 {
-	master->globalPause = 0;
 	master->globalShutdown = 1;
+	acqMonitor_pause(master, 0);
 	showMode(AS_OFF);
 }
 
@@ -20,6 +20,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "AMActionLog3.h"
 
 #include "actions3/AMLoopAction3.h"
+#include "actions3/AMActionLogQueue3.h"
 #include "dataman/database/AMDbObjectSupport.h"
 #include "util/AMErrorMonitor.h"
 
@@ -121,6 +122,21 @@ void AMActionLog3::setParentId(int parentId){
 	parentId_ = parentId;
 }
 
+void AMActionLog3::detachInfo()
+{
+	// Already ours.
+	if(!info_ || loadedInfoFromDb_)
+		return;
+
+	disconnect(info_, SIGNAL(destroyed()), this, SLOT(onInfoDestroyed()));
+
+	info_ = info_->createCopy();
+	connect(info_, SIGNAL(destroyed()), this, SLOT(onInfoDestroyed()));
+
+	// Same ownership rules as an info loaded from the database: we delete it.
+	loadedInfoFromDb_ = true;
+}
+
 void AMActionLog3::dbLoadStartDateTime(const AMHighPrecisionDateTime &startDateTime)
 {
 	startDateTime_ = startDateTime;
@@ -181,6 +197,9 @@ bool AMActionLog3::logUncompletedAction(const AMAction3 *uncompletedAction, AMDa
 
 bool AMActionLog3::updateCompletedAction(const AMAction3 *completedAction, AMDatabase *database){
 	if(completedAction && completedAction->inFinalState()) {
+		// Any queued sub-action logs should be in the database before their parent is marked as finished.
+		AMActionLogQueue3::queue()->flush();
+
 		int infoId = completedAction->info()->id();
 		if(infoId < 1){
 			AMErrorMon::alert(0, AMACTIONLOG_CANNOT_UPDATE_UNSAVED_ACTIONLOG, "The actions logging system attempted to update a log action that hadn't already been saved. Please report this problem to the Acquaman developers.");
@@ -215,6 +234,10 @@ bool AMActionLog3::logCompletedAction(const AMAction3 *completedAction, AMDataba
 	}
 }
 
+bool AMActionLog3::queueCompletedAction(const AMAction3 *completedAction, AMDatabase *database, int parentLogId){
+	return AMActionLogQueue3::queue()->enqueueCompletedAction(completedAction, database, parentLogId);
+}
+
 void AMActionLog3::onInfoDestroyed(){
 	info_ = 0; //NULL
 }
@@ -70,6 +70,8 @@ public:
 
 	/// Call this function to log a completed action to the database. Returns false and does nothing if the action is still running.  Returns true if the action was successfully logged, and false if there was a problem accessing or storing in the database. Optionally pass a parent log id go enforce parent-child relationship.
 	static bool logCompletedAction(const AMAction3* completedAction, AMDatabase* database, int parentLogId = -1);
+	/// Call this function to log a completed action to the database later, along with other completed actions, in one transaction (see AMActionLogQueue3). Returns false and does nothing if the action is still running. Problems storing the log are reported through AMErrorMon when the queue is flushed.
+	static bool queueCompletedAction(const AMAction3* completedAction, AMDatabase* database, int parentLogId = -1);
 
 	// Public accessors
 	////////////////////////////
@@ -112,6 +114,9 @@ public:
 	/// Set the parent AMLogAction database id for this AMLogAction (no parent is -1)
 	void setParentId(int parentId);
 
+	/// Replaces the info() borrowed from the logged action with a copy owned by this log, so that the log can outlive the action. Used when logs are queued for storage later (see AMActionLogQueue3).
+	void detachInfo();
+
 	// For use by the database system ONLY, during loadFromDb():
 	//////////////////////////
 
@@ -0,0 +1,194 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMActionLogQueue3.h"
+
+#include "actions3/AMActionLog3.h"
+#include "dataman/database/AMDatabase.h"
+#include "util/AMErrorMonitor.h"
+
+AMActionLogQueue3* AMActionLogQueue3::instance_ = 0;
+
+AMActionLogQueue3::AMActionLogQueue3(QObject *parent) :
+	QObject(parent)
+{
+	flushInterval_ = 1000;
+	maximumQueuedLogs_ = 200;
+	loggedActionCount_ = 0;
+	committedTransactionCount_ = 0;
+
+	connect(&flushScheduler_, SIGNAL(executed()), this, SLOT(flush()));
+}
+
+AMActionLogQueue3::~AMActionLogQueue3()
+{
+	foreach(QueuedLog queuedLog, queuedLogs_)
+		delete queuedLog.log;
+	queuedLogs_.clear();
+}
+
+AMActionLogQueue3* AMActionLogQueue3::queue()
+{
+	if(!instance_)
+		instance_ = new AMActionLogQueue3();
+	return instance_;
+}
+
+void AMActionLogQueue3::releaseQueue()
+{
+	if(instance_)
+		instance_->flush();
+
+	delete instance_;
+	instance_ = 0;
+}
+
+bool AMActionLogQueue3::enqueueCompletedAction(const AMAction3 *completedAction, AMDatabase *database, int parentLogId)
+{
+	if(!completedAction || !completedAction->inFinalState() || !database)
+		return false;
+
+	AMActionLog3 *actionLog = new AMActionLog3(completedAction);
+	actionLog->setParentId(parentLogId);
+	// The action (and its info) may be deleted long before we get around to storing the log.
+	actionLog->detachInfo();
+
+	if(!activeTime_.isValid())
+		activeTime_.start();
+
+	queuedLogs_ << QueuedLog(actionLog, database);
+
+	if(queuedLogs_.count() >= maximumQueuedLogs_)
+		flush();
+	else
+		flushScheduler_.runLater(flushInterval_);
+
+	return true;
+}
+
+double AMActionLogQueue3::commitsPerSecond() const
+{
+	if(!activeTime_.isValid() || activeTime_.elapsed() == 0)
+		return 0;
+
+	return double(committedTransactionCount_)*1000.0/double(activeTime_.elapsed());
+}
+
+void AMActionLogQueue3::setFlushInterval(int milliseconds)
+{
+	flushInterval_ = qMax(0, milliseconds);
+}
+
+void AMActionLogQueue3::setMaximumQueuedLogs(int maximumQueuedLogs)
+{
+	maximumQueuedLogs_ = qMax(1, maximumQueuedLogs);
+
+	if(queuedLogs_.count() >= maximumQueuedLogs_)
+		flush();
+}
+
+bool AMActionLogQueue3::flush()
+{
+	flushScheduler_.cancelRunLater();
+
+	if(queuedLogs_.isEmpty())
+		return true;
+
+	// Take everything out of the queue first: storing could re-enter the event loop (ex: waiting on a busy database), and anything queued in the meantime will get its own flush.
+	QList<QueuedLog> logsToStore = queuedLogs_;
+	queuedLogs_.clear();
+
+	// Group by database, keeping the original order within each one so that logs appear in the order the actions completed.
+	QList<AMDatabase*> databases;
+	QList<QList<AMActionLog3*> > logsByDatabase;
+
+	foreach(QueuedLog queuedLog, logsToStore){
+
+		int index = databases.indexOf(queuedLog.database);
+
+		if(index == -1){
+
+			databases << queuedLog.database;
+			logsByDatabase << QList<AMActionLog3*>();
+			index = databases.count()-1;
+		}
+
+		logsByDatabase[index] << queuedLog.log;
+	}
+
+	bool success = true;
+
+	for(int i = 0, size = databases.count(); i < size; i++){
+
+		success &= storeLogs(logsByDatabase.at(i), databases.at(i));
+		qDeleteAll(logsByDatabase.at(i));
+	}
+
+	return success;
+}
+
+bool AMActionLogQueue3::storeLogs(const QList<AMActionLog3 *> &logs, AMDatabase *database)
+{
+	// If someone else already has a transaction open on this connection, our stores simply become part of it.
+	bool openedTransaction = false;
+
+	if(database->supportsTransactions() && !database->transactionInProgress()){
+
+		if(database->startTransaction())
+			openedTransaction = true;
+		else
+			AMErrorMon::alert(this, AMACTIONLOGQUEUE3_CANNOT_START_TRANSACTION, QString("Could not start a transaction to store %1 completed actions in the '%2' database. They will be stored one at a time instead.").arg(logs.count()).arg(database->connectionName()));
+	}
+
+	bool success = true;
+	int storedLogs = 0;
+
+	foreach(AMActionLog3 *actionLog, logs){
+
+		if(actionLog->storeToDb(database))
+			storedLogs++;
+
+		else {
+
+			success = false;
+			AMErrorMon::alert(this, AMACTIONLOGQUEUE3_CANNOT_STORE_LOG, QString("There was a problem logging the completed action '%1' to your database.  Please report this problem to the Acquaman developers.").arg(actionLog->name()));
+		}
+	}
+
+	if(openedTransaction){
+
+		if(database->commitTransaction())
+			committedTransactionCount_++;
+
+		else {
+
+			database->rollbackTransaction();
+			AMErrorMon::alert(this, AMACTIONLOGQUEUE3_CANNOT_COMMIT_TRANSACTION, QString("Could not commit %1 completed actions to the '%2' database. Please report this problem to the Acquaman developers.").arg(logs.count()).arg(database->connectionName()));
+			return false;
+		}
+	}
+
+	// Without our own transaction, every store committed on its own.
+	else if(!database->transactionInProgress())
+		committedTransactionCount_ += storedLogs;
+
+	loggedActionCount_ += storedLogs;
+
+	return success;
+}
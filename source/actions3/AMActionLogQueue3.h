@@ -0,0 +1,121 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMACTIONLOGQUEUE3_H
+#define AMACTIONLOGQUEUE3_H
+
+#include <QObject>
+#include <QList>
+#include <QTime>
+
+#include "util/AMDeferredFunctionCall.h"
+
+class AMAction3;
+class AMActionLog3;
+class AMDatabase;
+
+#define AMACTIONLOGQUEUE3_CANNOT_START_TRANSACTION 214101
+#define AMACTIONLOGQUEUE3_CANNOT_STORE_LOG 214102
+#define AMACTIONLOGQUEUE3_CANNOT_COMMIT_TRANSACTION 214103
+
+/// This singleton class accumulates completed-action logs (AMActionLog3) and writes them to the database in batches.
+/*! Storing an AMActionLog3 normally costs one database transaction (and, for SQLite, one flush to disk) per action.  When list actions log their sub-actions separately, a fine-grained scan can complete thousands of actions per minute, and committing each of them on the GUI thread becomes expensive.
+
+Instead of calling AMActionLog3::logCompletedAction(), callers can use enqueueCompletedAction().  The log is created immediately (with its own copy of the action's info, so the action can be deleted right away) and remembered along with its parent log id.  All queued logs are written in one transaction per database when:
+
+- flushInterval() ms have passed since the first log was queued,
+- maximumQueuedLogs() logs are waiting, or
+- flush() is called explicitly (ex: before a parent list action updates its own log, or when the queue is released at shutdown.)
+
+Parent logs for list actions are still stored immediately by AMActionLog3::logUncompletedAction(), so the parent log ids recorded here are always valid when the children are written.
+
+The number of logs stored and transactions committed are tracked in loggedActionCount() and committedTransactionCount(), which can be used to compare the commit rate against the unbatched path.
+*/
+class AMActionLogQueue3 : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Access the single instance of the queue.
+	static AMActionLogQueue3* queue();
+	/// Flushes any waiting logs and deletes the queue.  Call this at shutdown, before the logging databases are closed.
+	static void releaseQueue();
+
+	/// Queues a log for the given \c completedAction, to be stored in \c database with the parent log id \c parentLogId.  Returns false and does nothing if the action is still running.
+	bool enqueueCompletedAction(const AMAction3 *completedAction, AMDatabase *database, int parentLogId = -1);
+
+	/// The number of logs waiting to be written
+	int queuedLogCount() const { return queuedLogs_.count(); }
+
+	/// The maximum time (in ms) a log will wait in the queue before it is written.
+	int flushInterval() const { return flushInterval_; }
+	/// The number of waiting logs that will trigger an immediate flush.
+	int maximumQueuedLogs() const { return maximumQueuedLogs_; }
+
+	/// The total number of logs written by this queue.
+	int loggedActionCount() const { return loggedActionCount_; }
+	/// The total number of database transactions committed by this queue.
+	int committedTransactionCount() const { return committedTransactionCount_; }
+	/// The average number of commits per second over all flushes so far, measured against the time since the first log was queued.
+	double commitsPerSecond() const;
+
+public slots:
+	/// Sets the maximum time (in ms) a log will wait in the queue before it is written.
+	void setFlushInterval(int milliseconds);
+	/// Sets the number of waiting logs that will trigger an immediate flush.
+	void setMaximumQueuedLogs(int maximumQueuedLogs);
+
+	/// Writes all waiting logs to their databases, using one transaction per database.  Returns false if any log could not be stored.
+	bool flush();
+
+protected:
+	/// Protected constructor for singleton.
+	explicit AMActionLogQueue3(QObject *parent = 0);
+	/// Deletes any logs still waiting (without writing them).
+	virtual ~AMActionLogQueue3();
+
+	/// Stores all of the \c logs in \c database within one transaction.  Returns false if any of them could not be stored.
+	bool storeLogs(const QList<AMActionLog3*> &logs, AMDatabase *database);
+
+	/// A queued log and the database it is destined for.
+	struct QueuedLog {
+		QueuedLog(AMActionLog3 *l = 0, AMDatabase *db = 0) : log(l), database(db) {}
+		AMActionLog3 *log;
+		AMDatabase *database;
+	};
+
+	/// The logs waiting to be written, in the order they were queued.
+	QList<QueuedLog> queuedLogs_;
+
+	/// Used to schedule the flush after flushInterval_ ms.
+	AMDeferredFunctionCall flushScheduler_;
+
+	int flushInterval_;
+	int maximumQueuedLogs_;
+
+	int loggedActionCount_;
+	int committedTransactionCount_;
+	/// Started when the first log is queued; used for commitsPerSecond().
+	QTime activeTime_;
+
+	/// The single instance of this class.
+	static AMActionLogQueue3 *instance_;
+};
+
+#endif // AMACTIONLOGQUEUE3_H
@@ -28,6 +28,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "actions3/AMActionRegistry3.h"
 #include "actions3/AMAction3.h"
 #include "actions3/AMActionLog3.h"
+#include "actions3/AMActionLogQueue3.h"
 
 #include "util/AMErrorMonitor.h"
 #include "acquaman/AMScanController.h"
@@ -45,6 +46,9 @@ AMActionRunner3::AMActionRunner3(AMDatabase *loggingDatabase, QObject *parent) :
 }
 
 AMActionRunner3::~AMActionRunner3() {
+	// Make sure anything we've queued for logging gets written while our database is still around.
+	AMActionLogQueue3::queue()->flush();
+
 	while(queuedActionCount() != 0) {
 		deleteActionInQueue(queuedActionCount()-1);
 	}
@@ -416,8 +420,8 @@ void AMActionRunner3::onImmediateActionStateChanged(int state, int previousState
 		AMListAction3* parentAction = qobject_cast<AMListAction3*>(action->parentAction());
 		if(parentAction)
 			parentLogId = parentAction->logActionId();
-		// log it:
-		if(!AMActionLog3::logCompletedAction(action, loggingDatabase_, parentLogId)) {
+		// log it (queued; these can arrive in rapid bursts):
+		if(!AMActionLog3::queueCompletedAction(action, loggingDatabase_, parentLogId)) {
 			AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -201, "There was a problem logging the completed action to your database.  Please report this problem to the Acquaman developers."));
 		}
 
@@ -333,7 +333,7 @@ void AMListAction3::internalOnSubActionStateChanged(int newState, int oldState)
 		else{
 			if(internalShouldLogSubAction(generalAction)){
 				int parentLogId = logActionId();
-				AMActionLog3::logCompletedAction(generalAction, loggingDatabase_, parentLogId);
+				AMActionLog3::queueCompletedAction(generalAction, loggingDatabase_, parentLogId);
 			}
 		}
 	}
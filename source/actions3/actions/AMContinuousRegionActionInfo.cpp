@@ -0,0 +1,74 @@
+#include "AMContinuousRegionActionInfo.h"
+
+AMContinuousRegionActionInfo::AMContinuousRegionActionInfo(const QString &axisName, double regionStart, double regionStep, double regionTime, int pointCount, QObject *parent) :
+	AMListActionInfo3("Continuous Region", "Continuous Region", ":/32x32/format-line-spacing-triple.png", parent)
+{
+	axisName_ = axisName;
+	regionStart_ = regionStart;
+	regionStep_ = regionStep;
+	regionTime_ = regionTime;
+	pointCount_ = pointCount;
+
+	updateDescriptions();
+}
+
+AMContinuousRegionActionInfo::AMContinuousRegionActionInfo(const AMContinuousRegionActionInfo &other) :
+	AMListActionInfo3(other)
+{
+	axisName_ = other.axisName();
+	regionStart_ = other.regionStart();
+	regionStep_ = other.regionStep();
+	regionTime_ = other.regionTime();
+	pointCount_ = other.pointCount();
+}
+
+QList<double> AMContinuousRegionActionInfo::axisValues() const
+{
+	QList<double> retVal;
+
+	for(int x = 0; x < pointCount_; x++)
+		retVal.append(axisValueAt(x));
+
+	return retVal;
+}
+
+void AMContinuousRegionActionInfo::setAxisName(const QString &axisName)
+{
+	axisName_ = axisName;
+	updateDescriptions();
+	setModified(true);
+}
+
+void AMContinuousRegionActionInfo::setRegionStart(double regionStart)
+{
+	regionStart_ = regionStart;
+	updateDescriptions();
+	setModified(true);
+}
+
+void AMContinuousRegionActionInfo::setRegionStep(double regionStep)
+{
+	regionStep_ = regionStep;
+	updateDescriptions();
+	setModified(true);
+}
+
+void AMContinuousRegionActionInfo::setRegionTime(double regionTime)
+{
+	regionTime_ = regionTime;
+	updateDescriptions();
+	setModified(true);
+}
+
+void AMContinuousRegionActionInfo::setPointCount(int pointCount)
+{
+	pointCount_ = pointCount;
+	updateDescriptions();
+	setModified(true);
+}
+
+void AMContinuousRegionActionInfo::updateDescriptions()
+{
+	setShortDescription(QString("Continuous Region on %1").arg(axisName_));
+	setLongDescription(QString("Continuous move on %1 from %2 to %3, reading %4 points of %5s").arg(axisName_).arg(regionStart_).arg(regionEnd()).arg(pointCount_).arg(regionTime_));
+}
@@ -0,0 +1,67 @@
+#ifndef AMCONTINUOUSREGIONACTIONINFO_H
+#define AMCONTINUOUSREGIONACTIONINFO_H
+
+#include "actions3/AMListActionInfo3.h"
+
+/// This info describes a step-axis region that has been rewritten to run as one continuous move with buffered detector reads (see AMContinuousMoveScanOptimizer).
+/*! It keeps the original region's start, step, dwell time, and number of points so that the axis values of the buffered points can be recovered: point i is at regionStart() + i*regionStep().
+  */
+class AMContinuousRegionActionInfo : public AMListActionInfo3
+{
+Q_OBJECT
+Q_PROPERTY(QString axisName READ axisName WRITE setAxisName)
+Q_PROPERTY(double regionStart READ regionStart WRITE setRegionStart)
+Q_PROPERTY(double regionStep READ regionStep WRITE setRegionStep)
+Q_PROPERTY(double regionTime READ regionTime WRITE setRegionTime)
+Q_PROPERTY(int pointCount READ pointCount WRITE setPointCount)
+
+public:
+	/// Constructor
+	Q_INVOKABLE AMContinuousRegionActionInfo(const QString &axisName = QString(), double regionStart = 0, double regionStep = 0, double regionTime = 0, int pointCount = 0, QObject *parent = 0);
+
+	/// Copy Constructor
+	AMContinuousRegionActionInfo(const AMContinuousRegionActionInfo &other);
+
+	/// This function is used as a virtual copy constructor
+	virtual AMActionInfo3* createCopy() const { return new AMContinuousRegionActionInfo(*this); }
+
+	/// This should describe the type of the action
+	virtual QString typeDescription() const { return "Continuous Region"; }
+
+	/// The name of the control moved in this region
+	QString axisName() const { return axisName_; }
+	/// The position of the first point
+	double regionStart() const { return regionStart_; }
+	/// The spacing between points
+	double regionStep() const { return regionStep_; }
+	/// The dwell time for each point
+	double regionTime() const { return regionTime_; }
+	/// The number of points acquired during the move
+	int pointCount() const { return pointCount_; }
+
+	/// The position the control moves to: one step past the last point, matching where the step loop would have left it.
+	double regionEnd() const { return regionStart_ + pointCount_*regionStep_; }
+	/// The axis value of point \c index
+	double axisValueAt(int index) const { return regionStart_ + index*regionStep_; }
+	/// The axis values of all pointCount() points
+	QList<double> axisValues() const;
+
+	void setAxisName(const QString &axisName);
+	void setRegionStart(double regionStart);
+	void setRegionStep(double regionStep);
+	void setRegionTime(double regionTime);
+	void setPointCount(int pointCount);
+
+protected:
+	/// Updates the short and long descriptions to match the region.
+	void updateDescriptions();
+
+protected:
+	QString axisName_;
+	double regionStart_;
+	double regionStep_;
+	double regionTime_;
+	int pointCount_;
+};
+
+#endif // AMCONTINUOUSREGIONACTIONINFO_H
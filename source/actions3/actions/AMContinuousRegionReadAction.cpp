@@ -0,0 +1,67 @@
+#include "AMContinuousRegionReadAction.h"
+
+#include "beamline/AMDetector.h"
+#include "util/AMErrorMonitor.h"
+#include "acquaman/AMAgnosticDataAPI.h"
+
+AMContinuousRegionReadAction::AMContinuousRegionReadAction(AMContinuousRegionActionInfo *info, const QList<AMDetector *> &detectors, const QString &loopName, QObject *parent) :
+	AMAction3(info, parent)
+{
+	detectors_ = detectors;
+	loopName_ = loopName;
+}
+
+AMContinuousRegionReadAction::AMContinuousRegionReadAction(const AMContinuousRegionReadAction &other) :
+	AMAction3(other)
+{
+	detectors_ = other.detectors_;
+	loopName_ = other.loopName_;
+}
+
+void AMContinuousRegionReadAction::startImplementation(){
+	setStarted();
+
+	const AMContinuousRegionActionInfo *regionInfo = continuousRegionInfo();
+	int pointCount = regionInfo->pointCount();
+
+	// Copy all of the buffers before posting anything, so that a short buffer doesn't leave half a region in the scan.
+	QList<QVector<double> > buffers;
+	for(int x = 0; x < detectors_.count(); x++){
+		AMDetector *detector = detectors_.at(x);
+		int bufferSize = detector->lastContinuousSize();
+		QVector<double> buffer(qMax(bufferSize, pointCount));
+
+		if(bufferSize < pointCount || !detector->lastContinuousReading(buffer.data())){
+			AMErrorMon::alert(this,
+					  AMCONTINUOUSREGIONREADACTION_BUFFER_TOO_SHORT,
+					  QString("There was an error reading the continuous region for '%1', because the detector '%2' buffered %3 readings for %4 points. Please report this problem to the Acquaman developers.").arg(regionInfo->axisName()).arg(detector->name()).arg(bufferSize).arg(pointCount));
+			setFailed();
+			return;
+		}
+
+		buffers << buffer;
+	}
+
+	if(generateScanActionMessages_){
+		AMAgnosticDataMessageHandler *handler = AMAgnosticDataAPISupport::handlerFromLookupKey("ScanActions");
+
+		for(int i = 0; i < pointCount; i++){
+			AMAgnosticDataAPIControlMovedMessage controlMovedMessage(regionInfo->axisName(), "Absolute", regionInfo->axisValueAt(i));
+			handler->postMessage(controlMovedMessage);
+
+			for(int x = 0; x < detectors_.count(); x++){
+				AMAgnosticDataAPIDataAvailableMessage dataAvailableMessage(detectors_.at(x)->name(), QList<double>() << buffers.at(x).at(i), QList<int>(), QStringList(), QStringList());
+				handler->postMessage(dataAvailableMessage);
+			}
+
+			AMAgnosticDataAPILoopIncrementMessage loopIncrementedMessage(loopName_, i+1);
+			handler->postMessage(loopIncrementedMessage);
+		}
+
+		// Leave the axis where the step loop would have: one step past the last point.
+		AMAgnosticDataAPIControlMovedMessage controlMovedMessage(regionInfo->axisName(), "Absolute", regionInfo->regionEnd());
+		handler->postMessage(controlMovedMessage);
+	}
+
+	setSucceeded();
+}
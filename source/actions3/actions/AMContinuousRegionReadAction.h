@@ -0,0 +1,66 @@
+#ifndef AMCONTINUOUSREGIONREADACTION_H
+#define AMCONTINUOUSREGIONREADACTION_H
+
+#include "actions3/AMAction3.h"
+#include "actions3/actions/AMContinuousRegionActionInfo.h"
+
+#define AMCONTINUOUSREGIONREADACTION_BUFFER_TOO_SHORT 530001
+
+class AMDetector;
+
+/// This action unpacks the buffered readings of a continuous region into one scan point per buffered reading.
+/*! It runs after the detectors of a region rewritten by AMContinuousMoveScanOptimizer have been read.  For each of the region's pointCount() points it posts, through the AMAgnosticDataAPI, the same messages the original step loop did: the axis position (as an absolute ControlMoved), one DataAvailable per detector, and a LoopIncremented.  The axis positions are the nominal axisValueAt() values of the step loop, not read back from the control; they are only right because the optimizer's move crosses the region at one step per dwell time.  The scan controllers therefore record one row per point, exactly as they would have for the step loop.
+
+All the detectors must be 0D (one value per point).  The action fails if any of them buffered fewer readings than the region has points.
+*/
+class AMContinuousRegionReadAction : public AMAction3
+{
+Q_OBJECT
+public:
+	/// Constructor.  \c loopName is posted as the unique ID of the LoopIncremented messages, just like the step loop this replaces.
+	AMContinuousRegionReadAction(AMContinuousRegionActionInfo *info, const QList<AMDetector*> &detectors, const QString &loopName, QObject *parent = 0);
+	/// Copy Constructor
+	AMContinuousRegionReadAction(const AMContinuousRegionReadAction &other);
+	/// Virtual copy constructor
+	virtual AMAction3* createCopy() const { return new AMContinuousRegionReadAction(*this); }
+
+	/// Specify that we cannot pause
+	virtual bool canPause() const { return false; }
+	/// Specify that we cannot skip
+	virtual bool canSkip() const { return false; }
+
+	/// Virtual function that denotes that this action has children underneath it or not.
+	virtual bool hasChildren() const { return false; }
+	/// Virtual function that returns the number of children for this action.
+	virtual int numberOfChildren() const { return 0; }
+
+	/// The detectors whose buffers are unpacked.
+	QList<AMDetector*> detectors() const { return detectors_; }
+
+protected:
+	/// This function is called from the Starting state when the implementation should initiate the action. Once the action is started, you should call notifyStarted().
+	virtual void startImplementation();
+
+	/// For actions which support pausing, this function is called from the Pausing state when the implementation should pause the action. Once the action is paused, you should call notifyPaused().  The base class implementation does nothing and must be re-implemented.
+	virtual void pauseImplementation() { setPaused(); }
+
+	/// For actions that support resuming, this function is called from the Paused state when the implementation should resume the action. Once the action is running again, you should call notifyResumed().
+	virtual void resumeImplementation() { setResumed(); }
+
+	/// All implementations must support cancelling. This function will be called from the Cancelling state. Implementations will probably want to examine the previousState(), which could be any of Starting, Running, Pausing, Paused, or Resuming. Once the action is cancelled and can be deleted, you should call notifyCancelled().
+	/*! \note If startImplementation() was never called, you won't receive this when a user tries to cancel(); the base class will handle it for you. */
+	virtual void cancelImplementation() { setCancelled(); }
+
+	/// Since this action does not support skipping, the method is empty.
+	virtual void skipImplementation(const QString &command) { Q_UNUSED(command); }
+
+protected:
+	/// We can always access our info object via info_ or info(), but it will come back as a AMActionInfo* pointer that we would need to cast to AMContinuousRegionActionInfo. This makes it easier to access.
+	const AMContinuousRegionActionInfo* continuousRegionInfo() const { return qobject_cast<const AMContinuousRegionActionInfo*>(info()); }
+
+protected:
+	QList<AMDetector*> detectors_;
+	QString loopName_;
+};
+
+#endif // AMCONTINUOUSREGIONREADACTION_H
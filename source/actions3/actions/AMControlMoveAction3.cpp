@@ -39,9 +39,13 @@ AMControlMoveAction3::AMControlMoveAction3(const AMControlMoveAction3 &other)
 	const AMControlMoveActionInfo3 *info = qobject_cast<const AMControlMoveActionInfo3*>(other.info());
 
 	if (info)
-		control_ = AMBeamline::bl()->exposedControlByInfo(*(info->controlInfo()));
+		control_ = AMBeamline::isCreated() ? AMBeamline::bl()->exposedControlByInfo(*(info->controlInfo())) : 0;
 	else
 		control_ = 0;
+
+	// A control the beamline doesn't expose (ex: a replay mock) is shared with the original.
+	if(!control_)
+		control_ = other.control_;
 }
 
 void AMControlMoveAction3::startImplementation()
@@ -19,9 +19,13 @@ AMDetectorAcquisitionAction::AMDetectorAcquisitionAction(const AMDetectorAcquisi
 	const AMDetectorAcquisitionActionInfo *info = qobject_cast<const AMDetectorAcquisitionActionInfo*>(other.info());
 
 	if(info)
-		detector_ = AMBeamline::bl()->exposedDetectorByInfo(*(info->detectorInfo()));
+		detector_ = AMBeamline::isCreated() ? AMBeamline::bl()->exposedDetectorByInfo(*(info->detectorInfo())) : 0;
 	else
 		detector_ = 0;
+
+	// A detector the beamline doesn't expose (ex: a replay mock) is shared with the original.
+	if(!detector_)
+		detector_ = other.detector_;
 }
 
 void AMDetectorAcquisitionAction::startImplementation(){
@@ -18,9 +18,13 @@ AMDetectorCleanupAction::AMDetectorCleanupAction(const AMDetectorCleanupAction &
 	const AMDetectorCleanupActionInfo *info = qobject_cast<const AMDetectorCleanupActionInfo*>(other.info());
 
 	if(info)
-		detector_ = AMBeamline::bl()->exposedDetectorByInfo(*(info->detectorInfo()));
+		detector_ = AMBeamline::isCreated() ? AMBeamline::bl()->exposedDetectorByInfo(*(info->detectorInfo())) : 0;
 	else
 		detector_ = 0;
+
+	// A detector the beamline doesn't expose (ex: a replay mock) is shared with the original.
+	if(!detector_)
+		detector_ = other.detector_;
 }
 
 void AMDetectorCleanupAction::startImplementation(){
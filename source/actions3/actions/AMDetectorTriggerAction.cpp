@@ -19,10 +19,14 @@ AMDetectorTriggerAction::AMDetectorTriggerAction(const AMDetectorTriggerAction &
 	const AMDetectorTriggerActionInfo *info = qobject_cast<const AMDetectorTriggerActionInfo*>(other.info());
 
 	if(info)
-		detector_ = AMBeamline::bl()->exposedDetectorByInfo(*(info->detectorInfo()));
+		detector_ = AMBeamline::isCreated() ? AMBeamline::bl()->exposedDetectorByInfo(*(info->detectorInfo())) : 0;
 	else
 		detector_ = 0;
 
+	// A detector the beamline doesn't expose (ex: a replay mock) is shared with the original.
+	if(!detector_)
+		detector_ = other.detector_;
+
 	triggerSource_ = other.triggerSource_;
 }
 
@@ -57,6 +61,8 @@ void AMDetectorTriggerAction::startImplementation(){
 
 		detectorTriggerInfo()->setShortDescription(QString("Trigger %1").arg(triggerSource_->name()));
 		detectorTriggerInfo()->setLongDescription(QString("Trigger %1").arg(triggerSource_->name()));
+		if(detectorTriggerInfo()->readMode() == AMDetectorDefinitions::ContinuousRead)
+			triggerSource_->setContinuousPointCount(detectorTriggerInfo()->continuousPointCount());
 		triggerSource_->trigger(detectorTriggerInfo()->readMode());
 	}
 	else{
@@ -5,6 +5,7 @@ AMDetectorTriggerActionInfo::AMDetectorTriggerActionInfo(const AMDetectorInfo &d
 {
 	detectorInfo_.setValuesFrom(detectorInfo);
 	readMode_ = readMode;
+	continuousPointCount_ = -1;
 
 	QString description = QString("Trigger %1").arg(detectorInfo_.description());
 	setShortDescription(description);
@@ -16,4 +17,5 @@ AMDetectorTriggerActionInfo::AMDetectorTriggerActionInfo(const AMDetectorTrigger
 {
 	detectorInfo_.setValuesFrom(*(other.detectorInfo()));
 	readMode_ = other.readMode();
+	continuousPointCount_ = other.continuousPointCount();
 }
@@ -25,6 +25,10 @@ public:
 
 	/// Returns the read mode for this acquisition
 	AMDetectorDefinitions::ReadMode readMode() const { return readMode_; }
+	/// Returns the number of points a ContinuousRead trigger should buffer, or -1 if it's up to the trigger source.
+	int continuousPointCount() const { return continuousPointCount_; }
+	/// Sets the number of points a ContinuousRead trigger should buffer.  It is handed to the detector's trigger source when the action starts.
+	void setContinuousPointCount(int pointCount) { continuousPointCount_ = pointCount; }
 
 	/// For database storing only
 	AMDetectorInfo* dbReadDetectorInfo() { return &detectorInfo_; }
@@ -37,6 +41,8 @@ protected:
 
 	/// The read mode we want to acquire with
 	AMDetectorDefinitions::ReadMode readMode_;
+	/// The number of points for a ContinuousRead trigger
+	int continuousPointCount_;
 };
 
 #endif // AMDETECTORTRIGGERACTIONINFO_H
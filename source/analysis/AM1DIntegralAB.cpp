@@ -28,7 +28,7 @@ AM1DIntegralAB::AM1DIntegralAB(const QString &outputName, QObject *parent)
 	analyzedName_ = "";
 	canAnalyze_ = false;
 
-	cacheCompletelyInvalid_ = false;
+	validSumCount_ = 0;
 
 	axes_ << AMAxisInfo("invalid", 0, "No input data");
 	setState(AMDataSource::InvalidFlag);
@@ -103,6 +103,7 @@ void AM1DIntegralAB::setInputDataSourcesImplementation(const QList<AMDataSource*
 		setInputSource();
 	}
 
+	invalidateCache();
 	reviewState();
 
 	emitSizeChanged(0);
@@ -189,31 +190,10 @@ AMNumber AM1DIntegralAB::value(const AMnDIndex& indexes) const{
 			return AMNumber(AMNumber::OutOfBoundsError);
 #endif
 
-	AMNumber rv = cachedValues_.at(indexes.i());
-	// if we haven't calculated this sum yet, the cached value will be invalid. Sum and store.
-	if(!rv.isValid()) {
-
-		double newVal = 0.0;
-		int index = indexes.i();
-
-		// Implementing Int[f(x)] ~ 1/2 * SUM {(x[i+1] - x[i])*(f(x[i+1]) + f(x[i])) }
-		if ((unsigned)index == ((unsigned)axes_.at(0).size - 1))
-			newVal = 0.5*(double(inputSource_->axisValue(0, index))-double(inputSource_->axisValue(0, index-1)))*(double(inputSource_->value(index)) + double(inputSource_->value(index-1)));
-
-		else
-			newVal = 0.5*(double(inputSource_->axisValue(0, index+1))-double(inputSource_->axisValue(0, index)))*(double(inputSource_->value(index+1)) + double(inputSource_->value(index)));
-
-		if (index != 0)
-			newVal += double(value(AMnDIndex(index-1)));
-
-		cachedValues_[index] = newVal;
-		cacheCompletelyInvalid_ = false;
+	if(!updateCumulativeSums(indexes.i()))
+		return AMNumber(AMNumber::InvalidError);
 
-		return newVal;
-	}
-	// otherwise return the value we have.
-	else
-		return rv;
+	return cumulativeSums_.at(indexes.i());
 }
 
 bool AM1DIntegralAB::values(const AMnDIndex &indexStart, const AMnDIndex &indexEnd, double *outputValues) const
@@ -232,15 +212,45 @@ bool AM1DIntegralAB::values(const AMnDIndex &indexStart, const AMnDIndex &indexE
 		return false;
 #endif
 
-	int totalSize = indexStart.totalPointsTo(indexEnd);
-	int offset = indexStart.i();
+	if(!updateCumulativeSums(indexEnd.i()))
+		return false;
 
-	QVector<double> data = QVector<double>(totalSize);
-	QVector<double> axis = QVector<double>(totalSize);
+	memcpy(outputValues, cumulativeSums_.constData()+indexStart.i(), indexStart.totalPointsTo(indexEnd)*sizeof(double));
 
-	AMAxisInfo axisInfo = inputSource_->axisInfoAt(0);
+	return true;
+}
+
+bool AM1DIntegralAB::updateCumulativeSums(int index) const
+{
+	if(index < validSumCount_)
+		return true;
+
+	int size = axes_.at(0).size;
+
+	if(cumulativeSums_.size() != size)
+		cumulativeSums_.resize(size);
+
+	// There's no area under a single point.
+	if(size < 2) {
+
+		cumulativeSums_.fill(0.0);
+		validSumCount_ = size;
+		return true;
+	}
+
+	// Implementing Int[f(x)] ~ 1/2 * SUM {(x[i+1] - x[i])*(f(x[i+1]) + f(x[i])) }, where the sum at i includes the segment from i to i+1.  The last point has no next point, so it repeats the segment before it.
+	int first = validSumCount_;
+	int readStart = (first == size-1) ? first-1 : first;
+	int readEnd = qMin(index+1, size-1);
+	int readSize = readEnd-readStart+1;
 
-	inputSource_->values(indexStart, indexEnd, data.data());
+	QVector<double> data = QVector<double>(readSize);
+	QVector<double> axis = QVector<double>(readSize);
+
+	if(!inputSource_->values(AMnDIndex(readStart), AMnDIndex(readEnd), data.data()))
+		return false;
+
+	AMAxisInfo axisInfo = inputSource_->axisInfoAt(0);
 
 	// This is much faster because we can compute all the axis values ourselves rather than ask for them one at a time.
 	if (axisInfo.isUniform){
@@ -248,34 +258,31 @@ bool AM1DIntegralAB::values(const AMnDIndex &indexStart, const AMnDIndex &indexE
 		double axisStart = double(axisInfo.start);
 		double axisStep = double(axisInfo.increment);
 
-		for (int i = 0; i < totalSize; i++)
-			axis[i] = axisStart + (i+offset)*axisStep;
+		for (int i = 0; i < readSize; i++)
+			axis[i] = axisStart + (i+readStart)*axisStep;
 	}
 
 	else {
 
-		// Fill the axis vector.  Should minimize the overhead of making the same function calls and casting the values multiple times.
-		for (int i = 0; i < totalSize; i++)
-			axis[i] = inputSource_->axisValue(0, i+offset);
+		for (int i = 0; i < readSize; i++)
+			axis[i] = inputSource_->axisValue(0, i+readStart);
 	}
 
-	// Implementing Int[f(x)] ~ 1/2 * SUM {(x[i+1] - x[i])*(f(x[i+1]) + f(x[i])) }
-	if (offset == 0)
-		outputValues[0] = 0.5*((axis.at(1)-axis.at(0))*data.at(1)+data.at(0));
+	double sum = (first == 0) ? 0.0 : cumulativeSums_.at(first-1);
 
-	// If we are not at the very start, then we need to call the value(-1) which could be very expensive if the cached value is not valid.
-	else
-		outputValues[0] = 0.5*((axis.at(1)-axis.at(0))*data.at(1)+data.at(0)) + double(value(AMnDIndex(offset-1)));
+	for (int i = first; i <= index; i++){
 
-	for (int i = 1, count = totalSize-1; i < count; i++)
-		outputValues[i] = 0.5*((axis.at(i+1)-axis.at(i))*data.at(i+1)+data.at(i)) + outputValues[i-1];
+		int j = i-readStart;
 
-	outputValues[totalSize-1] = 0.5*((axis.at(totalSize-1)-axis.at(totalSize-2))*data.at(totalSize-1)+data.at(totalSize-2)) + outputValues[totalSize-2];
+		if (i == size-1)
+			sum += 0.5*(axis.at(j)-axis.at(j-1))*(data.at(j)+data.at(j-1));
+		else
+			sum += 0.5*(axis.at(j+1)-axis.at(j))*(data.at(j+1)+data.at(j));
 
-	for (int i = 0; i < totalSize; i++)
-		cachedValues_[i+offset] = AMNumber(outputValues[i]);
+		cumulativeSums_[i] = sum;
+	}
 
-	cacheCompletelyInvalid_ = false;
+	validSumCount_ = index+1;
 
 	return true;
 }
@@ -297,13 +304,11 @@ void AM1DIntegralAB::onInputSourceValuesChanged(const AMnDIndex& start, const AM
 
 	if(start.isValid() && end.isValid()) {
 
-		int startIndex = start.i();
-		int endIndex = end.i();
-
-		for(int i=startIndex; i<=endIndex; i++)
-			cachedValues_[i] = AMNumber();	// invalidate the changed region
+		// The sum at start-1 includes the segment up to start, and every sum after it depends on that one.
+		int firstChanged = qMax(0, start.i()-1);
+		validSumCount_ = qMin(validSumCount_, firstChanged);
 
-		emitValuesChanged(startIndex, endIndex);
+		emitValuesChanged(firstChanged, axes_.at(0).size-1);
 	}
 	else {
 
@@ -316,8 +321,11 @@ void AM1DIntegralAB::onInputSourceValuesChanged(const AMnDIndex& start, const AM
 void AM1DIntegralAB::onInputSourceSizeChanged() {
 
 	if (axes_.at(0).size != inputSource_->size(0)){
+		int oldSize = axes_.at(0).size;
 		axes_[0].size = inputSource_->size(0);
-		cachedValues_.resize(axes_.at(0).size);
+		// The old last point was calculated from the segment before it, so it isn't valid anymore.
+		validSumCount_ = qMin(validSumCount_, qMax(0, qMin(oldSize, axes_.at(0).size)-1));
+		cumulativeSums_.resize(axes_.at(0).size);
 		emitSizeChanged(0);
 	}
 }
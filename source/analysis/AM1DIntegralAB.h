@@ -96,18 +96,18 @@ protected:
 	/// Helper method that sets the inputSource_ pointer to the correct one based on the current state of analyzedName_.
 	void setInputSource();
 
-	/// helper function to clear the cachedValues_
+	/// Helper function to forget all of the cumulative sums.  They will be re-calculated on demand.
 	void invalidateCache() {
-		if(!cacheCompletelyInvalid_ || cachedValues_.size() != axes_.at(0).size) {
-			cachedValues_ = QVector<AMNumber>(axes_.at(0).size);	// everything in there is now AMNumber::Null.
-			cacheCompletelyInvalid_ = true;
-		}
+		cumulativeSums_.resize(axes_.at(0).size);
+		validSumCount_ = 0;
 	}
+	/// Makes sure the cumulative sums are calculated up to and including \c index, by reading only the input values past the last valid sum.  Returns false if the input values can't be read.
+	bool updateCumulativeSums(int index) const;
 
-	/// Cached previously-summed values.  Either they don't need to be re-calculated, or they're AMNumber::Null and do need to be recalculated.
-	mutable QVector<AMNumber> cachedValues_;
-	/// Optimization: invalidating the cache with invalid() requires clearing all values in it. If we've just done this, we can avoid re-doing it until there's actually something to clear.
-	mutable bool cacheCompletelyInvalid_;
+	/// The integral at every point: cumulativeSums_[i] is the trapezoid sum up to point i.  Only the first validSumCount_ entries are up to date.
+	mutable QVector<double> cumulativeSums_;
+	/// The number of leading entries in cumulativeSums_ that are valid. Since each sum depends on all the ones before it, a change in the input invalidates everything from the first changed point onwards, but nothing before it.
+	mutable int validSumCount_;
 
 	/// Pointer to the data source that will be analyzed.
 	AMDataSource* inputSource_;	// our single input source, or 0 if we don't have one.
@@ -20,6 +20,10 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "AM1DRunningAverageFilterAB.h"
 
+#include "util/AMSlidingWindow.h"
+
+#include <string.h>
+
 AM1DRunningAverageFilterAB::AM1DRunningAverageFilterAB(int filterSize, const QString &outputName, QObject *parent) :
 	AMStandardAnalysisBlock(outputName, parent)
 {
@@ -101,29 +105,22 @@ AMNumber AM1DRunningAverageFilterAB::value(const AMnDIndex& indexes) const{
 #endif
 
 	int index = indexes.i();
+	int halfWidth = (filterSize_-1)/2;
 
+	// Read the whole window at once, truncated at the ends of the data.
+	int first = qMax(0, index-halfWidth);
+	int last = qMin(int(axes_.at(0).size)-1, index+halfWidth);
+	QVector<double> window(last-first+1);
 
-	double runningAverage = 0;
-	int numAvgPoints = 1;
-
-	runningAverage += (double)inputSource_->value(index);
-
-	for(int x = 1; x <= (filterSize_-1)/2; x++){
-
-		if( (index-x) >= 0 ){
+	if(!inputSource_->values(AMnDIndex(first), AMnDIndex(last), window.data()))
+		return AMNumber(AMNumber::InvalidError);
 
-			runningAverage += (double)inputSource_->value(index-x);
-			numAvgPoints++;
-		}
+	double runningAverage = 0;
 
-		if( (index+x) < axes_.at(0).size ){
+	for(int x = 0, size = window.size(); x < size; x++)
+		runningAverage += window.at(x);
 
-			runningAverage += (double)inputSource_->value(index+x);
-			numAvgPoints++;
-		}
-	}
-
-	return runningAverage/((double)numAvgPoints);
+	return runningAverage/((double)window.size());
 }
 
 bool AM1DRunningAverageFilterAB::values(const AMnDIndex &indexStart, const AMnDIndex &indexEnd, double *outputValues) const
@@ -139,102 +136,20 @@ bool AM1DRunningAverageFilterAB::values(const AMnDIndex &indexStart, const AMnDI
 		return false;
 #endif
 
-	int totalSize = indexStart.totalPointsTo(indexEnd);
+	// The windows of the first and last points reach halfWidth points beyond the requested range, so read those too (up to the real ends of the data, where the windows are truncated exactly like in value()).
+	int halfWidth = (filterSize_-1)/2;
+	int first = qMax(0, int(indexStart.i())-halfWidth);
+	int last = qMin(int(axes_.at(0).size)-1, int(indexEnd.i())+halfWidth);
+	int totalSize = last-first+1;
 
 	QVector<double> data = QVector<double>(totalSize);
-	inputSource_->values(indexStart, indexEnd, data.data());
-
-	int numberOfPoints = (filterSize_-1)/2;
-	double average = 0;
-	int tempNumberOfPoints = 1;
-
-	// If the filter size is bigger then the total size of the data then we will just check every point along the way.
-	if (numberOfPoints > totalSize){
-
-		for (int i = 0; i < totalSize; i++){
-
-			average = data.at(i);
-			tempNumberOfPoints = 1;
-
-			for (int j = 1; j < numberOfPoints; j++){
-
-				if ((i-j) >= 0){
-
-					average += data.at(i-j);
-					tempNumberOfPoints++;
-				}
-
-				if ((i+j) < totalSize){
-
-					average += data.at(i+j);
-					tempNumberOfPoints++;
-				}
-			}
-
-			outputValues[i] = average/double(tempNumberOfPoints);
-		}
-	}
-
-	// Otherwise, we can optimize the middle indices of the without having to check if we will be accessing data outside of the array range.
-	else {
-
-		// Compute the beginning values.
-		for (int i = 0; i < numberOfPoints; i++){
-
-			average = data.at(i);
-			tempNumberOfPoints = 1;
-
-			// Only need the substraction check at the beginning.
-			for (int j = 1; j < numberOfPoints; j++){
-
-				if ((i-j) >= 0){
-
-					average += data.at(i-j);
-					tempNumberOfPoints++;
-				}
-
-				average += data.at(i+j);
-				tempNumberOfPoints++;
-			}
-
-			outputValues[i] = average/double(tempNumberOfPoints);
-		}
-
-		// No need for conditionals in the middle of the data.
-		double averagePoints = double(numberOfPoints);
-
-		for (int i = numberOfPoints, count = totalSize-numberOfPoints; i < count; i++){
-
-			average = data.at(i);
-
-			for (int j = 1; j < numberOfPoints; j++)
-				average += data.at(i-j) + data.at(i+j);
-
-			outputValues[i] = average/averagePoints;
-		}
-
-		// Compute the last values.
-		for (int i = totalSize-numberOfPoints; i < totalSize; i++){
-
-			average = data.at(i);
-			tempNumberOfPoints = 1;
-
-			// Only need the addition check at the end.
-			for (int j = 1; j < numberOfPoints; j++){
-
-				average += data.at(i-j);
-				tempNumberOfPoints++;
-
-				if ((i+j) < totalSize){
+	if(!inputSource_->values(AMnDIndex(first), AMnDIndex(last), data.data()))
+		return false;
 
-					average += data.at(i+j);
-					tempNumberOfPoints++;
-				}
-			}
+	QVector<double> averages = QVector<double>(totalSize);
+	AMSlidingWindow::runningMean(data.constData(), totalSize, halfWidth, averages.data());
 
-			outputValues[i] = average/double(tempNumberOfPoints);
-		}
-	}
+	memcpy(outputValues, averages.constData() + (indexStart.i()-first), indexStart.totalPointsTo(indexEnd)*sizeof(double));
 
 	return true;
 }
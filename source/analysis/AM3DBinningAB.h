@@ -68,6 +68,8 @@ public:
 	////////////////////////////////////
 	/// Create, connect, and return a widget suitable for displaying/editing the expressions.
 	virtual QWidget* createEditorWidget();
+	/// Binning a 3D input touches every value, so plots calculate a copy of this block on the analysis thread.
+	virtual AMAnalysisBlock* createThreadedCopy() const { return new AM3DBinningAB(name()); }
 
 	// Data value access
 	////////////////////////////
@@ -49,6 +49,8 @@ public:
 	////////////////////////////////////
 	/// Create, connect, and return a widget suitable for displaying/editing the expressions.
 	virtual QWidget* createEditorWidget();
+	/// Plots calculate a copy of this block on the analysis thread (4D inputs are large).
+	virtual AMAnalysisBlock* createThreadedCopy() const { return new AM4DBinningAB(name()); }
 
 	// Data value access
 	////////////////////////////
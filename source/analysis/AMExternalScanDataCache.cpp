@@ -0,0 +1,408 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMExternalScanDataCache.h"
+
+#include "dataman/AMScan.h"
+#include "dataman/database/AMDatabase.h"
+#include "dataman/database/AMDbObjectSupport.h"
+
+#include <QMutexLocker>
+
+AMExternalScanDataCache* AMExternalScanDataCache::instance_ = 0;
+
+AMExternalScanData::AMExternalScanData(const AMDataSource *dataSource)
+{
+	axes = dataSource->axes();
+	state = dataSource->state();
+
+	const AMnDIndex size = dataSource->size();
+
+	switch(dataSource->rank()) {
+	case 0:
+		values << dataSource->value(AMnDIndex());
+		break;
+
+	case 1: {
+		values.resize(size.i());
+		for(int i=0; i<size.i(); i++)
+			values[i] = dataSource->value(i);
+		break;
+	}
+	case 2: {
+		values.resize(size.i()*size.j());
+		for(int i=0; i<size.i(); i++)
+			for(int j=0; j<size.j(); j++)
+				values[i*size.j() + j] = dataSource->value(AMnDIndex(i,j));
+		break;
+	}
+	case 3: {
+		values.resize(size.i()*size.j()*size.k());
+		for(int i=0; i<size.i(); i++)
+			for(int j=0; j<size.j(); j++)
+				for(int k=0; k<size.k(); k++)
+					values[i*size.j()*size.k() + j*size.k() + k] = dataSource->value(AMnDIndex(i,j,k));
+		break;
+	}
+	case 4: {
+		values.resize(size.i()*size.j()*size.k()*size.l());
+		for(int i=0; i<size.i(); i++)
+			for(int j=0; j<size.j(); j++)
+				for(int k=0; k<size.k(); k++)
+					for(int l=0; l<size.l(); l++)
+						values[i*size.j()*size.k()*size.l() + j*size.k()*size.l() + k*size.l() + l] = dataSource->value(AMnDIndex(i,j,k,l));
+		break;
+	}
+	case 5: {
+		values.resize(size.i()*size.j()*size.k()*size.l()*size.m());
+		for(int i=0; i<size.i(); i++)
+			for(int j=0; j<size.j(); j++)
+				for(int k=0; k<size.k(); k++)
+					for(int l=0; l<size.l(); l++)
+						for(int m=0; m<size.m(); m++)
+							values[i*size.j()*size.k()*size.l()*size.m() + j*size.k()*size.l()*size.m() + k*size.l()*size.m() + l*size.m() + m] = dataSource->value(AMnDIndex(i,j,k,l,m));
+		/// \todo oh god, we really need a block copy or a multi-dimensional iterator for AMDataSource::value()...
+		break;
+	}
+	}
+
+	for(int mu=0; mu<size.rank(); mu++) {	// for each axis
+		QVector<AMNumber> av;
+
+		if(!axes.at(mu).isUniform) {
+			int axisLength = size.at(mu);
+			av.resize(axisLength);
+			for(int i=0; i<axisLength; i++)	// copy all the axis values
+				av[i] = dataSource->axisValue(mu, i);
+		}
+
+		axisValues << av;
+	}
+}
+
+qint64 AMExternalScanData::byteSize() const
+{
+	qint64 bytes = sizeof(AMExternalScanData) + qint64(values.size())*sizeof(AMNumber);
+	foreach(const QVector<AMNumber>& av, axisValues)
+		bytes += qint64(av.size())*sizeof(AMNumber);
+	return bytes;
+}
+
+AMExternalScanDataCache::AMExternalScanDataCache(QObject *parent) :
+	QObject(parent)
+{
+	totalBytes_ = 0;
+	maximumBytes_ = 64*1024*1024;
+	useCounter_ = 0;
+	hitCount_ = 0;
+	missCount_ = 0;
+	evictionCount_ = 0;
+}
+
+AMExternalScanDataCache* AMExternalScanDataCache::cache()
+{
+	if(!instance_)
+		instance_ = new AMExternalScanDataCache();
+	return instance_;
+}
+
+void AMExternalScanDataCache::releaseCache()
+{
+	delete instance_;
+	instance_ = 0;
+}
+
+AMExternalScanDataCache::Handle AMExternalScanDataCache::data(AMDatabase *database, int scanId, const QString &dataSourceName, int *errorCode)
+{
+	if(errorCode)
+		*errorCode = 0;
+
+	QString key;
+	{
+		QMutexLocker locker(&mutex_);
+		watchDatabase(database);
+		key = keyFor(database, scanId, dataSourceName);
+
+		if(entries_.contains(key)) {
+			Entry& entry = entries_[key];
+			entry.lastUsed = ++useCounter_;
+			hitCount_++;
+			return entry.data;
+		}
+		missCount_++;
+	}
+
+	// Not cached: load the scan (outside the lock, since this can take a while) and copy the data source.
+	AMDbObject* dbObject = AMDbObjectSupport::s()->createAndLoadObjectAt(database, AMDbObjectSupport::s()->tableNameForClass<AMScan>(), scanId);
+	AMScan* scan = qobject_cast<AMScan*>(dbObject);
+	if(!scan) {
+		delete dbObject;
+		if(errorCode)
+			*errorCode = -1;
+		return Handle();
+	}
+	scan->retain(this);
+
+	int dataSourceIndex = scan->indexOfDataSource(dataSourceName);
+	if(dataSourceIndex < 0) {
+		scan->release(this);
+		if(errorCode)
+			*errorCode = -2;
+		return Handle();
+	}
+
+	Handle copy(new AMExternalScanData(scan->dataSourceAt(dataSourceIndex)));
+	bool stillChanging = scan->currentlyScanning();
+	scan->release(this);
+
+	// Scans that are still acquiring are never cached; the caller gets its own copy.
+	if(stillChanging)
+		return copy;
+
+	// Stored under the key from before loading: if the scan was updated in the meantime, this copy may already be stale, and won't be found again.
+	QMutexLocker locker(&mutex_);
+	if(entries_.contains(key))
+		return entries_.value(key).data;
+
+	Entry entry;
+	entry.data = copy;
+	entry.byteSize = copy->byteSize();
+	entry.lastUsed = ++useCounter_;
+	entries_.insert(key, entry);
+	totalBytes_ += entry.byteSize;
+	evictIfNeeded();
+
+	return copy;
+}
+
+AMExternalScanDataCache::Handle AMExternalScanDataCache::find(AMDatabase *database, int scanId, const QString &dataSourceName)
+{
+	QMutexLocker locker(&mutex_);
+	QHash<QString, Entry>::iterator i = entries_.find(keyFor(database, scanId, dataSourceName));
+	if(i == entries_.end())
+		return Handle();
+
+	i.value().lastUsed = ++useCounter_;
+	return i.value().data;
+}
+
+AMExternalScanDataCache::Handle AMExternalScanDataCache::insert(AMDatabase *database, int scanId, const QString &dataSourceName, const Handle &data)
+{
+	if(!data)
+		return data;
+
+	QMutexLocker locker(&mutex_);
+	watchDatabase(database);
+	QString key = keyFor(database, scanId, dataSourceName);
+	if(entries_.contains(key))
+		return entries_.value(key).data;
+
+	Entry entry;
+	entry.data = data;
+	entry.byteSize = data->byteSize();
+	entry.lastUsed = ++useCounter_;
+	entries_.insert(key, entry);
+	totalBytes_ += entry.byteSize;
+	evictIfNeeded();
+
+	return data;
+}
+
+int AMExternalScanDataCache::modificationStamp(AMDatabase *database, int scanId)
+{
+	QMutexLocker locker(&mutex_);
+	QString connectionName = database->connectionName();
+	// Both stamps only ever increase, so their sum changes whenever either one does.
+	return stamps_.value(scanKey(connectionName, -1)) + stamps_.value(scanKey(connectionName, scanId));
+}
+
+int AMExternalScanDataCache::entryCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return entries_.count();
+}
+
+qint64 AMExternalScanDataCache::totalBytes() const
+{
+	QMutexLocker locker(&mutex_);
+	return totalBytes_;
+}
+
+qint64 AMExternalScanDataCache::maximumBytes() const
+{
+	QMutexLocker locker(&mutex_);
+	return maximumBytes_;
+}
+
+void AMExternalScanDataCache::setMaximumBytes(qint64 maximumBytes)
+{
+	QMutexLocker locker(&mutex_);
+	maximumBytes_ = qMax(qint64(0), maximumBytes);
+	evictIfNeeded();
+}
+
+int AMExternalScanDataCache::hitCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return hitCount_;
+}
+
+int AMExternalScanDataCache::missCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return missCount_;
+}
+
+int AMExternalScanDataCache::evictionCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return evictionCount_;
+}
+
+double AMExternalScanDataCache::hitRate() const
+{
+	QMutexLocker locker(&mutex_);
+	int requests = hitCount_ + missCount_;
+	if(requests == 0)
+		return 0;
+
+	return double(hitCount_)/double(requests);
+}
+
+void AMExternalScanDataCache::resetCounters()
+{
+	QMutexLocker locker(&mutex_);
+	hitCount_ = 0;
+	missCount_ = 0;
+	evictionCount_ = 0;
+}
+
+void AMExternalScanDataCache::clear()
+{
+	QMutexLocker locker(&mutex_);
+	QMutableHashIterator<QString, Entry> i(entries_);
+	while(i.hasNext()) {
+		i.next();
+		if(i.value().data->ref == 1) {
+			totalBytes_ -= i.value().byteSize;
+			i.remove();
+		}
+	}
+}
+
+void AMExternalScanDataCache::onDatabaseUpdated(const QString &connectionName, const QString &tableName, int id)
+{
+	QMutexLocker locker(&mutex_);
+	if(tableName != AMDbObjectSupport::s()->tableNameForClass<AMScan>())
+		return;
+
+	// id -1 means the whole table was refreshed.
+	if(id < 0) {
+		stamps_[scanKey(connectionName, -1)]++;
+		removeEntriesStartingWith(connectionName + "|");
+	}
+	else {
+		stamps_[scanKey(connectionName, id)]++;
+		removeEntriesStartingWith(scanKey(connectionName, id) + "|");
+	}
+}
+
+void AMExternalScanDataCache::onDatabaseDestroyed(QObject *database)
+{
+	QMutexLocker locker(&mutex_);
+	AMExternalScanDataCacheWatcher* watcher = watchedDatabases_.take(database);
+	if(!watcher)
+		return;
+
+	QString connectionName = watcher->connectionName();
+	watcher->deleteLater();
+
+	// A new database could be opened later with the same connection name; it must not see these copies.
+	stamps_[scanKey(connectionName, -1)]++;
+	removeEntriesStartingWith(connectionName + "|");
+}
+
+void AMExternalScanDataCache::watchDatabase(AMDatabase *database)
+{
+	if(watchedDatabases_.contains(database))
+		return;
+
+	watchedDatabases_.insert(database, new AMExternalScanDataCacheWatcher(database, this));
+	connect(database, SIGNAL(destroyed(QObject*)), this, SLOT(onDatabaseDestroyed(QObject*)), Qt::DirectConnection);
+}
+
+QString AMExternalScanDataCache::keyFor(AMDatabase *database, int scanId, const QString &dataSourceName)
+{
+	QString connectionName = database->connectionName();
+	int stamp = stamps_.value(scanKey(connectionName, -1)) + stamps_.value(scanKey(connectionName, scanId));
+	return QString("%1|%2|%3").arg(scanKey(connectionName, scanId)).arg(stamp).arg(dataSourceName);
+}
+
+QString AMExternalScanDataCache::scanKey(const QString &connectionName, int scanId)
+{
+	return QString("%1|%2").arg(connectionName).arg(scanId);
+}
+
+void AMExternalScanDataCache::removeEntriesStartingWith(const QString &prefix)
+{
+	QMutableHashIterator<QString, Entry> i(entries_);
+	while(i.hasNext()) {
+		i.next();
+		if(i.key().startsWith(prefix)) {
+			totalBytes_ -= i.value().byteSize;
+			i.remove();
+		}
+	}
+}
+
+void AMExternalScanDataCache::evictIfNeeded()
+{
+	while(totalBytes_ > maximumBytes_) {
+
+		// Find the least-recently-used entry that only the cache is holding.
+		QHash<QString, Entry>::iterator oldest = entries_.end();
+		for(QHash<QString, Entry>::iterator i = entries_.begin(), end = entries_.end(); i != end; ++i) {
+			if(i.value().data->ref == 1 && (oldest == entries_.end() || i.value().lastUsed < oldest.value().lastUsed))
+				oldest = i;
+		}
+
+		// Everything left is in use.
+		if(oldest == entries_.end())
+			return;
+
+		totalBytes_ -= oldest.value().byteSize;
+		entries_.erase(oldest);
+		evictionCount_++;
+	}
+}
+
+AMExternalScanDataCacheWatcher::AMExternalScanDataCacheWatcher(AMDatabase *database, AMExternalScanDataCache *cache)
+	: QObject(cache)
+{
+	connectionName_ = database->connectionName();
+	cache_ = cache;
+
+	connect(database, SIGNAL(updated(QString,int)), this, SLOT(onDatabaseUpdated(QString,int)), Qt::DirectConnection);
+	connect(database, SIGNAL(removed(QString,int)), this, SLOT(onDatabaseUpdated(QString,int)), Qt::DirectConnection);
+}
+
+void AMExternalScanDataCacheWatcher::onDatabaseUpdated(const QString &tableName, int id)
+{
+	cache_->onDatabaseUpdated(connectionName_, tableName, id);
+}
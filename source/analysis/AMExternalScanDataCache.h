@@ -0,0 +1,190 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMEXTERNALSCANDATACACHE_H
+#define AMEXTERNALSCANDATACACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QSharedData>
+#include <QExplicitlySharedDataPointer>
+#include <QVector>
+
+#include "dataman/AMAxisInfo.h"
+#include "dataman/AMNumber.h"
+
+class AMDatabase;
+class AMDataSource;
+class AMExternalScanDataCacheWatcher;
+
+/// The copied contents of one data source from an external scan, as shared by AMExternalScanDataCache.  Once created, it is never modified, so any number of AMExternalScanDataSourceAB blocks can read it at the same time.
+class AMExternalScanData : public QSharedData
+{
+public:
+	/// Copies the axes, values and axis values out of \c dataSource.
+	/*! \note Limitation: only data sources up to 5 dimensions are copied. */
+	explicit AMExternalScanData(const AMDataSource* dataSource);
+
+	/// The axes of the source data
+	QList<AMAxisInfo> axes;
+	/// A flat data array of all the data values.  The final AMnDIndex varies the fastest.
+	QVector<AMNumber> values;
+	/// A vector for each axis, holding the axis values.  Empty for uniform axes.
+	QList<QVector<AMNumber> > axisValues;
+	/// The state of the source data source when it was copied
+	int state;
+
+	/// The approximate memory used by this copy, in bytes.
+	qint64 byteSize() const;
+};
+
+/// This singleton class keeps the external scan data used by AMExternalScanDataSourceAB, so that the same data source is only loaded once no matter how many blocks refer to it.
+/*! Normalizing many scans against the same reference (ex: a reference foil spectrum) creates one AMExternalScanDataSourceAB per scan, and each of them would otherwise load the complete reference scan from the database just to copy one data source.  Instead, blocks ask for their data with data().  The first request loads the scan and copies the data source; later requests for the same (database, scan id, data source name) share that copy.
+
+The copies are reference-counted: every block holds a handle to the copy it is exposing, and the cache holds one more.  Entries that no block is using are kept until the total size of the cache goes over maximumBytes(), and then the least-recently-used ones are dropped first.  Entries that are still in use are never dropped (but do count towards the total.)
+
+Each key also includes a modification stamp for the scan.  Whenever the scan's row in the database is updated or removed (as signalled by AMDatabase::updated() and AMDatabase::removed()), its stamp is bumped and its entries are dropped, so the next refresh loads the new version.  Blocks that are still holding the old copy keep it until they refresh.  Scans that are still being acquired are never cached, since their data is still changing.
+
+hitCount(), missCount() and hitRate() tell how well the cache is working.
+
+\note The bookkeeping is protected by a mutex, but loading happens outside of it: two threads asking for the same data at the same time may both load it, and the first copy stored wins.
+*/
+class AMExternalScanDataCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// A shared, read-only handle to a cached copy.
+	typedef QExplicitlySharedDataPointer<AMExternalScanData> Handle;
+
+	/// Access the single instance of the cache.
+	static AMExternalScanDataCache* cache();
+	/// Deletes the cache, and all the copies that are not in use.
+	static void releaseCache();
+
+	/// Returns the data for the data source named \c dataSourceName in the scan \c scanId of \c database, loading it if it isn't already cached.  Returns a null handle if the scan can't be loaded or doesn't have that data source; in that case \c errorCode (if provided) is set to -1 or -2 respectively.
+	Handle data(AMDatabase* database, int scanId, const QString& dataSourceName, int* errorCode = 0);
+
+	/// Returns the cached copy for (\c database, \c scanId, \c dataSourceName) at the scan's current modification stamp, or a null handle if there isn't one.  Does not load anything, and doesn't count as a hit or miss.
+	Handle find(AMDatabase* database, int scanId, const QString& dataSourceName);
+	/// Stores \c data as the copy for (\c database, \c scanId, \c dataSourceName) at the scan's current modification stamp.  If another copy was stored in the meantime, that one is kept and returned instead.
+	Handle insert(AMDatabase* database, int scanId, const QString& dataSourceName, const Handle& data);
+
+	/// The current modification stamp for \c scanId in \c database.  This starts at 0 and increases each time the scan is updated in the database.
+	int modificationStamp(AMDatabase* database, int scanId);
+
+	/// The number of cached copies
+	int entryCount() const;
+	/// The total size of all cached copies, in bytes
+	qint64 totalBytes() const;
+	/// The total size that unused copies are allowed to take up before they are dropped, in bytes.
+	qint64 maximumBytes() const;
+	/// Sets the total size that unused copies are allowed to take up, and drops unused copies if needed.
+	void setMaximumBytes(qint64 maximumBytes);
+
+	/// The number of requests to data() answered from the cache
+	int hitCount() const;
+	/// The number of requests to data() that had to load the scan
+	int missCount() const;
+	/// The number of copies dropped to stay under maximumBytes()
+	int evictionCount() const;
+	/// The fraction of requests to data() answered from the cache (0 to 1)
+	double hitRate() const;
+	/// Resets the hit, miss and eviction counters
+	void resetCounters();
+
+	/// Drops all copies that are not in use.
+	void clear();
+
+protected slots:
+	/// Called when a watched database is deleted.
+	void onDatabaseDestroyed(QObject* database);
+
+protected:
+	/// Protected constructor for singleton.
+	explicit AMExternalScanDataCache(QObject* parent = 0);
+
+	/// One cached copy
+	struct Entry {
+		Entry() : byteSize(0), lastUsed(0) {}
+		Handle data;
+		qint64 byteSize;
+		quint64 lastUsed;
+	};
+
+	/// Called by the watcher of the database named \c connectionName when it updates or removes a row.  Bumps the modification stamp for scans.
+	void onDatabaseUpdated(const QString& connectionName, const QString& tableName, int id);
+
+	/// Starts listening to \c database for scan updates, if we aren't already.  Must be called with mutex_ locked.
+	void watchDatabase(AMDatabase* database);
+	/// Returns the key used for (\c database, \c scanId, \c dataSourceName) at the scan's current stamp.  Must be called with mutex_ locked.
+	QString keyFor(AMDatabase* database, int scanId, const QString& dataSourceName);
+	/// Returns the key prefix shared by all the data sources in \c scanId of the database named \c connectionName.
+	static QString scanKey(const QString& connectionName, int scanId);
+	/// Removes every entry whose key starts with \c prefix.  Must be called with mutex_ locked.
+	void removeEntriesStartingWith(const QString& prefix);
+	/// Drops least-recently-used unreferenced entries until totalBytes_ is within maximumBytes_.  Must be called with mutex_ locked.
+	void evictIfNeeded();
+
+	/// Cached copies, by key: "connectionName|scanId|stamp|dataSourceName"
+	QHash<QString, Entry> entries_;
+	/// Modification stamps by scanKey(). Scans that have never been updated are not listed, and have stamp 0.
+	QHash<QString, int> stamps_;
+	/// The databases we're listening to, and the watcher listening to each one
+	QHash<QObject*, AMExternalScanDataCacheWatcher*> watchedDatabases_;
+
+	qint64 totalBytes_;
+	qint64 maximumBytes_;
+	quint64 useCounter_;
+	int hitCount_;
+	int missCount_;
+	int evictionCount_;
+
+	mutable QMutex mutex_;
+
+	/// The single instance of this class.
+	static AMExternalScanDataCache* instance_;
+
+	friend class AMExternalScanDataCacheWatcher;
+};
+
+/// This class listens to one database for AMExternalScanDataCache, and tells the cache which database a change came from.  You should normally not need to use it directly.
+/*! The database signals are delivered with a direct connection, in whichever thread made the change, so the cache can't rely on sender() to find out which database it was. */
+class AMExternalScanDataCacheWatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.  Passes updates and removals from \c database to \c cache.
+	AMExternalScanDataCacheWatcher(AMDatabase* database, AMExternalScanDataCache* cache);
+
+	/// The connection name of the database we're listening to
+	QString connectionName() const { return connectionName_; }
+
+protected slots:
+	/// Called when the database updates or removes a row.
+	void onDatabaseUpdated(const QString& tableName, int id);
+
+protected:
+	QString connectionName_;
+	AMExternalScanDataCache* cache_;
+};
+
+#endif // AMEXTERNALSCANDATACACHE_H
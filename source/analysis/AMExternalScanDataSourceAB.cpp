@@ -19,8 +19,6 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include "AMExternalScanDataSourceAB.h"
-#include "dataman/AMScan.h"
-#include "dataman/database/AMDbObjectSupport.h"
 
 #include "util/AMErrorMonitor.h"
 #include <QTimer>
@@ -35,36 +33,13 @@ AMExternalScanDataSourceAB::AMExternalScanDataSourceAB(AMDatabase* sourceDatabas
 
 	// not valid until refreshData() is completed.
 	setState(AMDataSource::InvalidFlag);
-	scan_ = 0;
-
-	// however, we should still get our rank, which means trying to load the scan
-	AMDbObject* dbObject = 0;
-	try {
-		dbObject = AMDbObjectSupport::s()->createAndLoadObjectAt(sourceDb_,
-														 AMDbObjectSupport::s()->tableNameForClass<AMScan>(),
-														 sourceScanId_);
-		/// \todo Once we have just one scan class, then we don't need to use the dynamic loader. Then we can do this without having to load the scan's raw data just to get our rank.
-
-		scan_ = qobject_cast<AMScan*>(dbObject);
-		if(!scan_)
-			throw -1;
-
-		int dataSourceIndex = scan_->indexOfDataSource(sourceDataSourceName_);
-		if(dataSourceIndex < 0)
-			throw -2;
 
+	// however, we should still get our rank, which means loading the data. (If we were asked to load it later, we'll ask the cache again then; it will most likely still have it.)
+	AMExternalScanDataCache::Handle data = AMExternalScanDataCache::cache()->data(sourceDb_, sourceScanId_, sourceDataSourceName_);
+	if(data) {
 		// good... now we'll have our rank. Requirement to not change rank once constructed is satisfied.
-		axes_ = scan_->dataSourceAt(dataSourceIndex)->axes();
-
+		axes_ = data->axes;
 	}
-	catch(int errCode) {
-		if(dbObject) {
-			delete dbObject;
-		}
-		scan_ = 0;
-	}
-
-	scan_->retain(this);
 	insideConstructor_ = false;
 
 	switch(whenToLoadData) {
@@ -85,7 +60,6 @@ AMExternalScanDataSourceAB::AMExternalScanDataSourceAB(AMDatabase* db, int id) :
 	insideConstructor_ = true;
 
 	setState(AMDataSource::InvalidFlag);
-	scan_ = 0;
 	sourceScanId_ = -1;
 
 	loadFromDb(db, id);
@@ -103,58 +77,31 @@ bool AMExternalScanDataSourceAB::areInputDataSourcesAcceptable(const QList<AMDat
 
 bool AMExternalScanDataSourceAB::refreshData()
 {
-	AMDbObject* dbObject = 0;
 	AMnDIndex oldSize = size();
 
-	try {
-		// We might have a scan_ loaded already from the constructor. If not, attempt to load ourselves.
-		if(!scan_) {
-			dbObject = AMDbObjectSupport::s()->createAndLoadObjectAt(sourceDb_,
-															 AMDbObjectSupport::s()->tableNameForClass<AMScan>(),
-															 sourceScanId_);
-			scan_ = qobject_cast<AMScan*>(dbObject);
-			if(!scan_)
-				throw -1;
-		}
-		scan_->retain(this);
-
-		int dataSourceIndex = scan_->indexOfDataSource(sourceDataSourceName_);
-		if(dataSourceIndex < 0)
-			throw -2;
-
-		// get the axes from the source data. Since we're using AMStandardAnalysisBlock, this will automatically expose everything we need.
-		axes_ = scan_->dataSourceAt(dataSourceIndex)->axes();
-
-		// grab the data
-		copyValues(dataSourceIndex);
-		copyAxisValues(dataSourceIndex);
+	int errorCode;
+	AMExternalScanDataCache::Handle data = AMExternalScanDataCache::cache()->data(sourceDb_, sourceScanId_, sourceDataSourceName_, &errorCode);
 
-		setState(scan_->dataSourceAt(dataSourceIndex)->state());
+	if(!data) {
+		data_.reset();
+		setState(AMDataSource::InvalidFlag);
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Serious, errorCode, "Could not load external scan data."));
+		return false;
+	}
 
-		// delete the scan
-		scan_->release(this);
-		scan_ = 0;
+	// get the axes from the source data. Since we're using AMStandardAnalysisBlock, this will automatically expose everything we need.
+	data_ = data;
+	axes_ = data_->axes;
+	setState(data_->state);
 
-		// signalling:
+	// signalling:
 
-		emitAxisInfoChanged();
-		if(oldSize != size())
-			emitSizeChanged();
-		emitValuesChanged();
+	emitAxisInfoChanged();
+	if(oldSize != size())
+		emitSizeChanged();
+	emitValuesChanged();
 
-		return true;
-	}
-	catch(int errCode) {
-		if(dbObject)
-			delete dbObject;
-		if(scan_) {
-			scan_->release(this);
-			scan_ = 0;
-		}
-		setState(AMDataSource::InvalidFlag);
-		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Serious, errCode, "Could not load external scan data."));
-		return false;
-	}
+	return true;
 }
 
 AMNumber AMExternalScanDataSourceAB::value(const AMnDIndex &indexes) const
@@ -167,14 +114,14 @@ AMNumber AMExternalScanDataSourceAB::value(const AMnDIndex &indexes) const
 
 	switch(axes_.count()) {
 	case 0:
-		return values_.at(0);
+		return data_->values.at(0);
 
 	case 1:
 #ifdef AM_ENABLE_BOUNDS_CHECKING
 		if((unsigned)indexes.i() >= (unsigned)axes_.at(0).size)
 				return AMNumber::OutOfBoundsError;
 #endif
-		return values_.at(indexes.i());
+		return data_->values.at(indexes.i());
 
 	case 2:
 #ifdef AM_ENABLE_BOUNDS_CHECKING
@@ -182,7 +129,7 @@ AMNumber AMExternalScanDataSourceAB::value(const AMnDIndex &indexes) const
 				(unsigned)indexes.j() >= (unsigned)axes_.at(1).size))
 			return AMNumber::OutOfBoundsError;
 #endif
-		return values_.at(indexes.i()*axes_.at(1).size
+		return data_->values.at(indexes.i()*axes_.at(1).size
 						  + indexes.j());
 
 	case 3: {
@@ -198,7 +145,7 @@ AMNumber AMExternalScanDataSourceAB::value(const AMnDIndex &indexes) const
 		flatIndex += indexes.j()*stride;
 		stride *= axes_.at(1).size;
 		flatIndex += indexes.i()*stride;
-		return values_.at(flatIndex);
+		return data_->values.at(flatIndex);
 	}
 
 	case 4: {
@@ -216,8 +163,8 @@ AMNumber AMExternalScanDataSourceAB::value(const AMnDIndex &indexes) const
 		stride *= axes_.at(2).size;
 		flatIndex += indexes.j()*stride;
 		stride *= axes_.at(1).size;
-		flatIndex += indexes.i();
-		return values_.at(flatIndex);
+		flatIndex += indexes.i()*stride;
+		return data_->values.at(flatIndex);
 	}
 
 	case 5: {
@@ -240,7 +187,7 @@ AMNumber AMExternalScanDataSourceAB::value(const AMnDIndex &indexes) const
 		stride *= axes_.at(1).size;
 		flatIndex += indexes.i()*stride;
 
-		return values_.at(flatIndex);
+		return data_->values.at(flatIndex);
 	}
 	default:
 		return AMNumber::InvalidError;
@@ -257,86 +204,13 @@ AMNumber AMExternalScanDataSourceAB::axisValue(int axisNumber, int index) const
 	if(axisInfo.isUniform)
 		return (double)axisInfo.start + index*(double)axisInfo.increment;
 	else {
+		if(!data_)
+			return AMNumber::InvalidError;
 #ifdef AM_ENABLE_BOUNDS_CHECKING
 		if((unsigned)index >= (unsigned)axisInfo.size)
 			return AMNumber::OutOfBoundsError;
 #endif
-		return axisValues_.at(axisNumber).at(index);
-	}
-}
-
-void AMExternalScanDataSourceAB::copyValues(int dataSourceIndex)
-{
-	AMDataSource* ds = scan_->dataSourceAt(dataSourceIndex);
-	const AMnDIndex size = ds->size();
-
-	switch(ds->rank()) {
-	case 0:
-		values_.clear();
-		values_ << ds->value(AMnDIndex());
-		break;
-
-	case 1: {
-		values_.resize(size.i());
-		for(int i=0; i<size.i(); i++)
-			values_[i] = ds->value(i);
-		break;
-	}
-	case 2: {
-		values_.resize(size.i()*size.j());
-		for(int i=0; i<size.i(); i++)
-			for(int j=0; j<size.j(); j++)
-				values_[i*size.j() + j] = ds->value(AMnDIndex(i,j));
-		break;
-	}
-	case 3: {
-		values_.resize(size.i()*size.j()*size.k());
-		for(int i=0; i<size.i(); i++)
-			for(int j=0; j<size.j(); j++)
-				for(int k=0; k<size.k(); k++)
-					values_[i*size.j()*size.k() + j*size.k() + k] = ds->value(AMnDIndex(i,j,k));
-		break;
-	}
-	case 4: {
-		values_.resize(size.i()*size.j()*size.k()*size.l());
-		for(int i=0; i<size.i(); i++)
-			for(int j=0; j<size.j(); j++)
-				for(int k=0; k<size.k(); k++)
-					for(int l=0; l<size.l(); l++)
-						values_[i*size.j()*size.k()*size.l() + j*size.k()*size.l() + k*size.l() + l] = ds->value(AMnDIndex(i,j,k,l));
-		break;
-	}
-	case 5: {
-		values_.resize(size.i()*size.j()*size.k()*size.l()*size.m());
-		for(int i=0; i<size.i(); i++)
-			for(int j=0; j<size.j(); j++)
-				for(int k=0; k<size.k(); k++)
-					for(int l=0; l<size.l(); l++)
-						for(int m=0; m<size.m(); m++)
-							values_[i*size.j()*size.k()*size.l()*size.m() + j*size.k()*size.l()*size.m() + k*size.l()*size.m() + l*size.m() + m] = ds->value(AMnDIndex(i,j,k,l,m));
-		/// \todo oh god, we really need a block copy or a multi-dimensional iterator for AMDataSource::value()...
-		break;
-	}
-	}
-}
-
-void AMExternalScanDataSourceAB::copyAxisValues(int dataSourceIndex)
-{
-	AMDataSource* ds = scan_->dataSourceAt(dataSourceIndex);
-	const AMnDIndex size = ds->size();
-
-	axisValues_.clear();
-
-	for(int mu=0; mu<size.rank(); mu++) {	// for each axis
-		QVector<AMNumber> av;
-
-		if(!axes_.at(mu).isUniform) {
-			int axisLength = size.at(mu);
-			for(int i=0; i<axisLength; i++)	// copy all the axis values
-				av << axisValue(mu, i);
-		}
-
-		axisValues_ << av;
+		return data_->axisValues.at(axisNumber).at(index);
 	}
 }
 
@@ -363,10 +237,6 @@ bool AMExternalScanDataSourceAB::loadFromDb(AMDatabase *db, int id)
 		return false;
 	}
 
-	if(scan_) {	// don't want refreshData() to use an old scan object. This will ensure it loads a new one.
-		scan_->release(this);
-		scan_ = 0;
-	}
 	// from this point on, we've actually made permanent modifications to our parameters. Which means that we need to change the state to invalid if anything goes wrong from here. This will be taken care of by refreshData().
 	sourceDb_ = sourceDb;
 	sourceScanId_ = dbLoadScanId_;
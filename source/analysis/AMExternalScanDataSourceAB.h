@@ -22,11 +22,12 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #define AMEXTERNALSCANDATASOURCEAB_H
 
 #include "analysis/AMStandardAnalysisBlock.h"
-
-class AMScan;
+#include "analysis/AMExternalScanDataCache.h"
 
 /// This analysis block provides a way to access a data soure from another scan.  You can create one by specifying the database, id, and data source name of the source data in the constructor. The external scan will be loaded and the appropriate data source will be copied and exposed through this analysis block. Note that the data is not "live"; to pick up changes from the external scan, you must call refreshData().
-/*! \note Limitation: This version only supports data sources up to 5 dimensions */
+/*! The copied data comes from AMExternalScanDataCache, so blocks that expose the same data source from the same scan share one read-only copy, and the external scan is only loaded once.
+
+\note Limitation: This version only supports data sources up to 5 dimensions */
 class AMExternalScanDataSourceAB : public AMStandardAnalysisBlock
 {
 	Q_OBJECT
@@ -116,21 +117,18 @@ public:
 signals:
 
 public slots:
-	/// Refresh the data. This will create, load, and copy the data from the external scan's data source, and then delete the external scan.  Returns true if data was successfully loaded; returns false if there was a problem.
+	/// Refresh the data. This will create, load, and copy the data from the external scan's data source, and then delete the external scan.  If the scan hasn't changed in the database since another block loaded the same data source, the cached copy is used instead.  Returns true if data was successfully loaded; returns false if there was a problem.
 	/*! \note Our output is not automatically updated if the data within the external scan changes.  You must call refreshData() again to pick up the changes. */
 	bool refreshData();
 
 protected:
-	/// A flat data array of all the data values.  The final AMnDIndex varies the fastest.
-	QVector<AMNumber> values_;
-	/// A vector for each axis, to store the axis values.
-	QList<QVector<AMNumber> > axisValues_;
+	/// The shared copy of the external data: the values (in a flat array, with the final AMnDIndex varying the fastest) and the axis values.  Null until the data has been loaded.
+	AMExternalScanDataCache::Handle data_;
 
 
 	AMDatabase* sourceDb_;
 	int sourceScanId_;
 	QString sourceDataSourceName_;
-	AMScan* scan_;
 
 	/// Only used when re-loading out of the database [We can't store a database pointer; instead we store the connection name]
 	QString dbLoadConnectionName_;
@@ -141,12 +139,6 @@ protected:
 	/// True while running inside the constructor
 	bool insideConstructor_;
 
-private:
-	/// Helper function to copy the values from the source data source into values_.  Assumes that \c scan_ is set and \c dataSourceIndex is good.
-	void copyValues(int dataSourceIndex);
-	/// Helpver function to copy the axis values from the source data source into values_. Assumes that \c scan_ is set and \c dataSourceIndex is good.
-	void copyAxisValues(int dataSourceIndex);
-
 };
 
 #endif // AMEXTERNALSCANDATASOURCEAB_H
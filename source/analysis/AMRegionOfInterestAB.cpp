@@ -0,0 +1,347 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMRegionOfInterestAB.h"
+
+#include "analysis/AMRegionOfInterestEngine.h"
+
+AMRegionOfInterestAB::AMRegionOfInterestAB(const QString &outputName, QObject *parent)
+	: AMStandardAnalysisBlock(outputName, parent)
+{
+	regionMinimum_ = 0;
+	regionMaximum_ = 0;
+	analyzedName_ = "";
+	canAnalyze_ = false;
+
+	inputSource_ = 0;
+	engine_ = 0;
+	regionId_ = -1;
+	// leave sources_ empty for now.
+
+	axes_ << AMAxisInfo("invalid", 0, "No input data") << AMAxisInfo("invalid", 0, "No input data");
+	setState(AMDataSource::InvalidFlag);
+}
+
+AMRegionOfInterestAB::AMRegionOfInterestAB(AMDatabase *db, int id)
+	: AMStandardAnalysisBlock("tempName")
+{
+	regionMinimum_ = 0;
+	regionMaximum_ = 0;
+	canAnalyze_ = false;
+
+	inputSource_ = 0;
+	engine_ = 0;
+	regionId_ = -1;
+	// leave sources_ empty for now.
+
+	axes_ << AMAxisInfo("invalid", 0, "No input data") << AMAxisInfo("invalid", 0, "No input data");
+	setState(AMDataSource::InvalidFlag);
+
+	loadFromDb(db, id);
+		// will restore regionMinimum and regionMaximum. We'll remain invalid until we get connected.
+
+	AMDataSource::name_ = AMDbObject::name();	// normally it's not okay to change a dataSource's name. Here we get away with it because we're within the constructor, and nothing's watching us yet.
+}
+
+AMRegionOfInterestAB::~AMRegionOfInterestAB()
+{
+	if(engine_){
+
+		engine_->removeRegion(regionId_);
+		AMRegionOfInterestEngine::releaseEngine(engine_);
+		engine_ = 0;
+	}
+}
+
+// Check if a set of inputs is valid. The empty list (no inputs) must always be valid. For non-empty lists, our specific requirements are...
+/* - there must be a single input source or a list of data sources
+	- the rank() of the input sources must be at least 2
+	*/
+bool AMRegionOfInterestAB::areInputDataSourcesAcceptable(const QList<AMDataSource*>& dataSources) const {
+
+	if(dataSources.isEmpty())
+		return true;	// always acceptable; the null input.
+
+	for (int i = 0; i < dataSources.count(); i++)
+		if (dataSources.at(i)->rank() < 2)
+			return false;
+
+	return true;
+}
+
+void AMRegionOfInterestAB::setInputDataSourcesImplementation(const QList<AMDataSource*>& dataSources) {
+
+	if(dataSources.isEmpty()) {
+
+		sources_.clear();
+		canAnalyze_ = false;
+		connectInputSource(0);
+	}
+
+	// we know that this will only be called with valid input source
+	else if (dataSources.count() == 1) {
+
+		sources_ = dataSources;
+		canAnalyze_ = true;
+		connectInputSource(dataSources.at(0));
+	}
+
+	else {
+
+		sources_ = dataSources;
+		int index = indexOfInputSource(analyzedName_);
+		canAnalyze_ = index >= 0;
+		connectInputSource(index >= 0 ? inputDataSourceAt(index) : 0);
+	}
+
+	reviewState();
+
+	emitSizeChanged();
+	emitValuesChanged();
+	emitAxisInfoChanged();
+	emitInfoChanged();
+}
+
+void AMRegionOfInterestAB::setAnalyzedName(const QString &name)
+{
+	if(analyzedName_ == name)
+		return;
+
+	analyzedName_ = name;
+	setModified(true);
+	canAnalyze_ = canAnalyze(name);
+	setInputSource();
+}
+
+void AMRegionOfInterestAB::setInputSource()
+{
+	int index = sources_.count() == 1 ? 0 : indexOfInputSource(analyzedName_);
+
+	canAnalyze_ = index >= 0;
+	connectInputSource(index >= 0 ? inputDataSourceAt(index) : 0);
+	reviewState();
+
+	emitSizeChanged();
+	emitValuesChanged();
+	emitAxisInfoChanged();
+	emitInfoChanged();
+}
+
+void AMRegionOfInterestAB::connectInputSource(AMDataSource *source)
+{
+	// disconnect connections from old source, if it exists.
+	if(inputSource_) {
+		disconnect(inputSource_->signalSource(), SIGNAL(valuesChanged(AMnDIndex,AMnDIndex)), this, SLOT(onInputSourceValuesChanged(AMnDIndex,AMnDIndex)));
+		disconnect(inputSource_->signalSource(), SIGNAL(sizeChanged(int)), this, SLOT(onInputSourceSizeChanged()));
+		disconnect(inputSource_->signalSource(), SIGNAL(stateChanged(int)), this, SLOT(onInputSourceStateChanged()));
+		inputSource_ = 0;
+	}
+
+	if(engine_) {
+		engine_->removeRegion(regionId_);
+		AMRegionOfInterestEngine::releaseEngine(engine_);
+		engine_ = 0;
+		regionId_ = -1;
+	}
+
+	axes_.clear();
+
+	if(source) {
+
+		inputSource_ = source;
+
+		// The output has every axis of the input except the spectrum.
+		for(int mu = 0, outputRank = inputSource_->rank()-1; mu < outputRank; mu++)
+			axes_ << inputSource_->axisInfoAt(mu);
+
+		engine_ = AMRegionOfInterestEngine::engineFor(inputSource_);
+		regionId_ = engine_->addRegion(regionMinimum_, regionMaximum_);
+
+		// Have to call into AMDataSource directly to avoid setModified(true)
+		AMDataSource::setDescription(QString("%1 Region of Interest (over %2)")
+						 .arg(inputSource_->name())
+						 .arg(inputSource_->axisInfoAt(inputSource_->rank()-1).name));
+
+		connect(inputSource_->signalSource(), SIGNAL(valuesChanged(AMnDIndex,AMnDIndex)), this, SLOT(onInputSourceValuesChanged(AMnDIndex,AMnDIndex)));
+		connect(inputSource_->signalSource(), SIGNAL(sizeChanged(int)), this, SLOT(onInputSourceSizeChanged()));
+		connect(inputSource_->signalSource(), SIGNAL(stateChanged(int)), this, SLOT(onInputSourceStateChanged()));
+	}
+
+	else {
+
+		axes_ << AMAxisInfo("invalid", 0, "No input data") << AMAxisInfo("invalid", 0, "No input data");
+		AMDataSource::setDescription("-- No input data --");
+	}
+}
+
+bool AMRegionOfInterestAB::canAnalyze(const QString &name) const
+{
+	// Always can analyze a single data source.
+	if (sources_.count() == 1)
+		return true;
+
+	if (indexOfInputSource(name) >= 0)
+		return true;
+
+	return false;
+}
+
+void AMRegionOfInterestAB::setRegionMinimum(int regionMinimum)
+{
+	if(regionMinimum == regionMinimum_)
+		return;
+
+	regionMinimum_ = regionMinimum;
+
+	if(engine_)
+		engine_->setRegion(regionId_, regionMinimum_, regionMaximum_);
+
+	reviewState();
+
+	emitValuesChanged();
+	setModified(true);
+}
+
+void AMRegionOfInterestAB::setRegionMaximum(int regionMaximum)
+{
+	if(regionMaximum == regionMaximum_)
+		return;
+
+	regionMaximum_ = regionMaximum;
+
+	if(engine_)
+		engine_->setRegion(regionId_, regionMinimum_, regionMaximum_);
+
+	reviewState();
+
+	emitValuesChanged();
+	setModified(true);
+}
+
+AMNumber AMRegionOfInterestAB::value(const AMnDIndex& indexes) const {
+	if(indexes.rank() != axes_.count())
+		return AMNumber(AMNumber::DimensionError);
+
+	if(!isValid())
+		return AMNumber(AMNumber::InvalidError);
+
+#ifdef AM_ENABLE_BOUNDS_CHECKING
+	for(int mu = 0, rank = axes_.count(); mu < rank; mu++)
+		if((unsigned)indexes.at(mu) >= (unsigned)axes_.at(mu).size)
+			return AMNumber(AMNumber::OutOfBoundsError);
+#endif
+
+	return engine_->mapValue(regionId_, indexes);
+}
+
+bool AMRegionOfInterestAB::values(const AMnDIndex &indexStart, const AMnDIndex &indexEnd, double *outputValues) const
+{
+	if(indexStart.rank() != axes_.count() || indexEnd.rank() != axes_.count())
+		return false;
+
+	if(!isValid())
+		return false;
+
+	if (!canAnalyze())
+		return false;
+
+#ifdef AM_ENABLE_BOUNDS_CHECKING
+	for(int mu = 0, rank = axes_.count(); mu < rank; mu++)
+		if((unsigned)indexEnd.at(mu) >= (unsigned)axes_.at(mu).size || (unsigned)indexStart.at(mu) > (unsigned)indexEnd.at(mu))
+			return false;
+#endif
+
+	return engine_->mapValues(regionId_, indexStart, indexEnd, outputValues);
+}
+
+AMNumber AMRegionOfInterestAB::axisValue(int axisNumber, int index) const {
+
+	if(!isValid())
+		return AMNumber(AMNumber::InvalidError);
+
+	if(axisNumber < 0 || axisNumber >= axes_.count())
+		return AMNumber(AMNumber::DimensionError);
+
+	return inputSource_->axisValue(axisNumber, index);
+}
+
+// Connected to be called when the values of the input data source change
+void AMRegionOfInterestAB::onInputSourceValuesChanged(const AMnDIndex& start, const AMnDIndex& end) {
+
+	int rank = axes_.count();
+
+	if(start.isValid() && end.isValid() && start.rank() == rank+1) {
+
+		engine_->invalidateSpectra(start, end);
+
+		AMnDIndex pixelStart(rank, AMnDIndex::DoNotInit);
+		AMnDIndex pixelEnd(rank, AMnDIndex::DoNotInit);
+
+		for(int mu = 0; mu < rank; mu++) {
+			pixelStart[mu] = start.at(mu);
+			pixelEnd[mu] = end.at(mu);
+		}
+
+		emitValuesChanged(pixelStart, pixelEnd);
+	}
+	else {
+		engine_->invalidate();
+		emitValuesChanged();
+	}
+}
+
+// Connected to be called when the size of the input source changes
+void AMRegionOfInterestAB::onInputSourceSizeChanged()
+{
+	for(int mu = 0, rank = axes_.count(); mu < rank; mu++) {
+
+		int newSize = inputSource_->size(mu);
+
+		if(axes_.at(mu).size != newSize) {
+			axes_[mu].size = newSize;
+			emitSizeChanged(mu);
+		}
+	}
+
+	// The spectrum might not be big enough for the region anymore.
+	reviewState();
+}
+
+// Connected to be called when the state() flags of any input source change
+void AMRegionOfInterestAB::onInputSourceStateChanged() {
+
+	// just in case the size has changed while the input source was invalid, and now it's going valid.  Do we need this? probably not, if the input source is well behaved. But it's pretty inexpensive to do it twice... and we know we'll get the size right everytime it goes valid.
+	onInputSourceSizeChanged();
+	reviewState();
+}
+
+void AMRegionOfInterestAB::reviewState()
+{
+	if(!canAnalyze_ || inputSource_ == 0 || !inputSource_->isValid()) {
+		setState(AMDataSource::InvalidFlag);
+		return;
+	}
+
+	int spectrumSize = inputSource_->size(inputSource_->rank()-1);
+
+	if(regionMinimum_ < 0 || regionMaximum_ < regionMinimum_ || regionMaximum_ >= spectrumSize)
+		setState(AMDataSource::InvalidFlag);
+	else
+		setState(0);
+}
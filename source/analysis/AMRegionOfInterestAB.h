@@ -0,0 +1,140 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMREGIONOFINTERESTAB_H
+#define AMREGIONOFINTERESTAB_H
+
+#include "analysis/AMStandardAnalysisBlock.h"
+
+class AMRegionOfInterestEngine;
+
+/// This analysis block re-calculates a region of interest map from the spectra stored in a scan, instead of relying on the ROI values that were recorded from the detector during the scan.
+/*! The input is a data source whose last axis is a spectrum (ex: the rank 3 XRF spectra behind a 2D map), and the output is the map of the sum over the spectrum channels from regionMinimum() to regionMaximum() (inclusive), with one less dimension than the input.  Changing the region after the scan just re-calculates the map; there's no need to re-run the scan or export the spectra.
+
+The work is done by an AMRegionOfInterestEngine shared by all the region of interest blocks on the same input.  Asking for any of their maps calculates all of them in a single pass over the spectra, and each region costs O(1) per pixel however wide it is.
+
+Like the other blocks, it can take a list of data sources and only analyze the one that matches analyzedName().  If only one data source is provided then it will analyze it, even if the name does not match.
+
+\note The rank of the output follows the rank of the input.  Until an input is connected, the block reports two (invalid) axes, which is the usual case of a map.
+*/
+class AMRegionOfInterestAB : public AMStandardAnalysisBlock
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int regionMinimum READ regionMinimum WRITE setRegionMinimum)
+	Q_PROPERTY(int regionMaximum READ regionMaximum WRITE setRegionMaximum)
+	Q_PROPERTY(QString analyzedName READ analyzedName WRITE setAnalyzedName)
+
+	Q_CLASSINFO("AMDbObject_Attributes", "description=Region of Interest Block")
+
+public:
+	/// Constructor. \c outputName is the name() for the output data source.
+	AMRegionOfInterestAB(const QString &outputName, QObject *parent = 0);
+	/// This constructor is used to reload analysis blocks directly out of the database
+	Q_INVOKABLE AMRegionOfInterestAB(AMDatabase* db, int id);
+	/// Releases the shared engine.
+	virtual ~AMRegionOfInterestAB();
+
+	QString infoDescription() const { return QString("(Channels %1 to %2)").arg(regionMinimum_).arg(regionMaximum_); }
+
+	/// Check if a set of inputs is valid. The empty list (no inputs) must always be valid. For non-empty lists, our specific requirements are...
+	/*! - there must be a single input source or a list of data sources.
+  - the rank() of the input sources must be at least 2 (a spectrum, and at least one axis to map over)
+  */
+	virtual bool areInputDataSourcesAcceptable(const QList<AMDataSource*>& dataSources) const;
+
+protected:
+	/// Set the data source inputs.
+	virtual void setInputDataSourcesImplementation(const QList<AMDataSource*>& dataSources);
+
+public:
+	/// Set the analyzed data source name.
+	void setAnalyzedName(const QString &name);
+	/// Returns the current analyzed data source name.  If none have been set then this returns an empty string.
+	QString analyzedName() const { return analyzedName_; }
+	/// Returns whether the data source can be evaluated.  Checks against the current analyzed name.
+	bool canAnalyze() const { return canAnalyze_; }
+	/// Returns whether the data source can be evaluated by passing in a name.  Even though, the analysis block can be evaluated regardless of the name if there is only one data source, this will return true even if the name doesn't match.
+	bool canAnalyze(const QString &name) const;
+
+	// Data value access
+	////////////////////////////
+
+	/// Returns the dependent value at a (complete) set of axis indexes. Returns an invalid AMNumber if the indexes are insuffient or any are out of range, or if the data is not ready.
+	virtual AMNumber value(const AMnDIndex& indexes) const;
+	/// Performance optimization of value(): instead of a single value, copies a block of values from \c indexStart to \c indexEnd (inclusive), into \c outputValues.  The values are returned in row-major order (ie: with the first index varying the slowest). Returns false if the indexes have the wrong dimension, or (if AM_ENABLE_BOUNDS_CHECKING is defined, the indexes are out-of-range).
+	/*! 	It is the caller's responsibility to make sure that \c outputValues has sufficient size.  You can calculate this conviniently using:
+
+	\code
+	int outputSize = indexStart.totalPointsTo(indexEnd);
+	\endcode
+	*/
+	virtual bool values(const AMnDIndex& indexStart, const AMnDIndex& indexEnd, double* outputValues) const;
+	/// When the independent values along an axis is not simply the axis index, this returns the independent value along an axis (specified by axis number and index)
+	virtual AMNumber axisValue(int axisNumber, int index) const;
+
+	// Analysis parameters
+	///////////////////////////
+	/// The first spectrum channel in the region of interest
+	int regionMinimum() const { return regionMinimum_; }
+	/// The last spectrum channel in the region of interest
+	int regionMaximum() const { return regionMaximum_; }
+
+	/// Set the first spectrum channel in the region of interest.  If the region is beyond the size of the spectrum, the output goes invalid. The value remains as set, however.
+	void setRegionMinimum(int regionMinimum);
+	/// Set the last spectrum channel in the region of interest.  If the region is beyond the size of the spectrum, the output goes invalid. The value remains as set, however.
+	void setRegionMaximum(int regionMaximum);
+
+	/// The engine calculating this block's map along with all the other regions on the same input, or 0 if there is no input.
+	AMRegionOfInterestEngine* engine() const { return engine_; }
+	/// The id of this block's region in engine(), or -1 if there is no engine.
+	int regionId() const { return regionId_; }
+
+protected slots:
+	/// Connected to be called when the values of the input data source change
+	void onInputSourceValuesChanged(const AMnDIndex& start, const AMnDIndex& end);
+	/// Connected to be called when the size of the input source changes
+	void onInputSourceSizeChanged();
+	/// Connected to be called when the state() flags of any input source change
+	void onInputSourceStateChanged();
+
+protected:
+	/// Helper method that sets the inputSource_ pointer to the correct one based on the current state of analyzedName_.
+	void setInputSource();
+	/// Helper method that connects to \c source (which can be 0), gets its shared engine and sets up the output axes.  Disconnects from the previous source and releases its engine first.
+	void connectInputSource(AMDataSource *source);
+	/// Helper function to look at our overall situation and determine what the output state should be.
+	void reviewState();
+
+	/// Our single input source, or 0 if we don't have one.
+	AMDataSource* inputSource_;
+	/// The shared engine for inputSource_
+	AMRegionOfInterestEngine *engine_;
+	/// The id of our region within engine_
+	int regionId_;
+
+	int regionMinimum_, regionMaximum_;
+
+	/// The name of the data source that should be analyzed.
+	QString analyzedName_;
+	/// Flag holding whether or not the data source can be analyzed.
+	bool canAnalyze_;
+};
+
+#endif // AMREGIONOFINTERESTAB_H
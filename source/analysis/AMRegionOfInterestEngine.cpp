@@ -0,0 +1,369 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMRegionOfInterestEngine.h"
+
+#include <QMutexLocker>
+
+#include "dataman/datasource/AMDataSource.h"
+
+QHash<AMDataSource*, AMRegionOfInterestEngine*> AMRegionOfInterestEngine::sharedEngines_;
+QMutex AMRegionOfInterestEngine::sharedEnginesMutex_;
+
+AMRegionOfInterestEngine* AMRegionOfInterestEngine::engineFor(AMDataSource *spectrumSource)
+{
+	QMutexLocker locker(&sharedEnginesMutex_);
+
+	AMRegionOfInterestEngine *engine = sharedEngines_.value(spectrumSource);
+
+	if(!engine){
+
+		engine = new AMRegionOfInterestEngine(spectrumSource);
+		engine->shareCount_ = 0;
+		sharedEngines_.insert(spectrumSource, engine);
+	}
+
+	engine->shareCount_++;
+	return engine;
+}
+
+void AMRegionOfInterestEngine::releaseEngine(AMRegionOfInterestEngine *engine)
+{
+	if(!engine)
+		return;
+
+	QMutexLocker locker(&sharedEnginesMutex_);
+
+	if(--engine->shareCount_ <= 0){
+
+		sharedEngines_.remove(engine->spectrumSource());
+		delete engine;
+	}
+}
+
+AMRegionOfInterestEngine::AMRegionOfInterestEngine(AMDataSource *spectrumSource)
+{
+	spectrumSource_ = spectrumSource;
+	spectrumSize_ = 0;
+	nextRegionId_ = 0;
+	firstChangedPixel_ = 0;
+	lastChangedPixel_ = -1;
+	passCount_ = 0;
+	spectraRead_ = 0;
+	shareCount_ = 0;
+}
+
+AMnDIndex AMRegionOfInterestEngine::mapSize() const
+{
+	AMnDIndex sourceSize = spectrumSource_->size();
+	int rank = sourceSize.rank()-1;
+
+	if(rank < 1)
+		return AMnDIndex();
+
+	AMnDIndex rv(rank, AMnDIndex::DoNotInit);
+	for(int mu = 0; mu < rank; mu++)
+		rv[mu] = sourceSize.at(mu);
+
+	return rv;
+}
+
+int AMRegionOfInterestEngine::spectrumSize() const
+{
+	int rank = spectrumSource_->rank();
+	return rank < 2 ? 0 : spectrumSource_->size(rank-1);
+}
+
+int AMRegionOfInterestEngine::addRegion(int minimum, int maximum)
+{
+	QMutexLocker locker(&mutex_);
+
+	int regionId = nextRegionId_++;
+	regions_.insert(regionId, Region(minimum, maximum));
+	regions_[regionId].map.resize(mapSize_.isValid() ? int(mapSize_.product()) : 0);
+
+	return regionId;
+}
+
+void AMRegionOfInterestEngine::setRegion(int regionId, int minimum, int maximum)
+{
+	QMutexLocker locker(&mutex_);
+
+	QMap<int, Region>::iterator region = regions_.find(regionId);
+	if(region == regions_.end())
+		return;
+
+	if(region->minimum == minimum && region->maximum == maximum)
+		return;
+
+	region->minimum = minimum;
+	region->maximum = maximum;
+	region->needsUpdate = true;
+}
+
+void AMRegionOfInterestEngine::removeRegion(int regionId)
+{
+	QMutexLocker locker(&mutex_);
+	regions_.remove(regionId);
+}
+
+int AMRegionOfInterestEngine::regionCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return regions_.count();
+}
+
+void AMRegionOfInterestEngine::invalidatePixels(long firstPixel, long lastPixel)
+{
+	if(firstPixel > lastPixel)
+		qSwap(firstPixel, lastPixel);
+
+	QMutexLocker locker(&mutex_);
+	addChangedPixels(firstPixel, lastPixel);
+}
+
+void AMRegionOfInterestEngine::invalidateSpectra(const AMnDIndex &start, const AMnDIndex &end)
+{
+	AMnDIndex currentMapSize = mapSize();
+	int rank = currentMapSize.rank();
+
+	if(rank < 1 || start.rank() != rank+1 || end.rank() != rank+1){
+
+		invalidate();
+		return;
+	}
+
+	// Every pixel between the first and last one touched, in row-major order.
+	long firstPixel = 0;
+	long lastPixel = 0;
+
+	for(int mu = 0; mu < rank; mu++){
+
+		firstPixel = firstPixel*currentMapSize.at(mu) + start.at(mu);
+		lastPixel = lastPixel*currentMapSize.at(mu) + end.at(mu);
+	}
+
+	invalidatePixels(firstPixel, lastPixel);
+}
+
+void AMRegionOfInterestEngine::invalidate()
+{
+	QMutexLocker locker(&mutex_);
+
+	// Forgetting the size makes the next update start over.
+	mapSize_ = AMnDIndex();
+}
+
+AMNumber AMRegionOfInterestEngine::mapValue(int regionId, const AMnDIndex &pixelIndex)
+{
+	QMutexLocker locker(&mutex_);
+
+	if(!update() || !regions_.contains(regionId) || pixelIndex.rank() != mapSize_.rank() || !pixelIndex.validInArrayOfSize(mapSize_))
+		return AMNumber(AMNumber::InvalidError);
+
+	return regions_.value(regionId).map.at(int(flatPixelIndex(pixelIndex)));
+}
+
+bool AMRegionOfInterestEngine::mapValues(int regionId, const AMnDIndex &pixelStart, const AMnDIndex &pixelEnd, double *outputValues)
+{
+	QMutexLocker locker(&mutex_);
+
+	if(!update())
+		return false;
+
+	QMap<int, Region>::const_iterator region = regions_.constFind(regionId);
+	if(region == regions_.constEnd())
+		return false;
+
+	int rank = mapSize_.rank();
+
+	if(pixelStart.rank() != rank || pixelEnd.rank() != rank || !pixelStart.validInArrayOfSize(mapSize_) || !pixelEnd.validInArrayOfSize(mapSize_))
+		return false;
+
+	// The last axis is contiguous in the maps, so copy one run along it at a time, stepping through the other axes like an odometer.
+	const double *map = region->map.constData();
+	int runLength = int(pixelEnd.at(rank-1)-pixelStart.at(rank-1)+1);
+	AMnDIndex pixel = pixelStart;
+
+	forever {
+
+		memcpy(outputValues, map+flatPixelIndex(pixel), runLength*sizeof(double));
+		outputValues += runLength;
+
+		int mu = rank-2;
+
+		for(; mu >= 0; mu--){
+
+			if(pixel.at(mu) < pixelEnd.at(mu)){
+
+				pixel[mu]++;
+				break;
+			}
+
+			pixel[mu] = pixelStart.at(mu);
+		}
+
+		if(mu < 0)
+			break;
+	}
+
+	return true;
+}
+
+int AMRegionOfInterestEngine::passCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return passCount_;
+}
+
+long AMRegionOfInterestEngine::spectraRead() const
+{
+	QMutexLocker locker(&mutex_);
+	return spectraRead_;
+}
+
+bool AMRegionOfInterestEngine::update()
+{
+	AMnDIndex sourceSize = spectrumSource_->size();
+	int rank = sourceSize.rank();
+
+	if(rank < 2)
+		return false;
+
+	AMnDIndex currentMapSize(rank-1, AMnDIndex::DoNotInit);
+	for(int mu = 0; mu < rank-1; mu++)
+		currentMapSize[mu] = sourceSize.at(mu);
+
+	int currentSpectrumSize = int(sourceSize.at(rank-1));
+	long pixelCount = currentMapSize.product();
+
+	if(currentMapSize != mapSize_ || currentSpectrumSize != spectrumSize_){
+
+		// Since the first axis varies the slowest, new rows are added to the end of the maps and the existing pixels keep their place.  Anything else means starting over.
+		bool onlyAddedRows = mapSize_.rank() == rank-1 && currentSpectrumSize == spectrumSize_ && currentMapSize.at(0) > mapSize_.at(0);
+		for(int mu = 1; onlyAddedRows && mu < rank-1; mu++)
+			onlyAddedRows = currentMapSize.at(mu) == mapSize_.at(mu);
+
+		if(onlyAddedRows)
+			addChangedPixels(mapSize_.product(), pixelCount-1);
+		else {
+
+			firstChangedPixel_ = 0;
+			lastChangedPixel_ = pixelCount-1;
+		}
+
+		mapSize_ = currentMapSize;
+		spectrumSize_ = currentSpectrumSize;
+
+		QMap<int, Region>::iterator i = regions_.begin();
+		for(; i != regions_.end(); ++i)
+			i->map.resize(int(pixelCount));
+	}
+
+	QVector<Region*> regions;
+	bool regionsNeedUpdate = false;
+
+	QMap<int, Region>::iterator i = regions_.begin();
+	for(; i != regions_.end(); ++i){
+
+		regions << &(i.value());
+		regionsNeedUpdate |= i->needsUpdate;
+	}
+
+	lastChangedPixel_ = qMin(lastChangedPixel_, pixelCount-1);
+
+	if(regions.isEmpty() || (!regionsNeedUpdate && firstChangedPixel_ > lastChangedPixel_))
+		return true;
+
+	// A changed region needs every pixel; otherwise only the changed pixels are read.
+	long firstPixel = regionsNeedUpdate ? 0 : firstChangedPixel_;
+	long lastPixel = regionsNeedUpdate ? pixelCount-1 : lastChangedPixel_;
+
+	QVector<double> spectrum(spectrumSize_);
+	// runningSum[c] is the sum of channels 0 to c-1, so any region is runningSum[max+1] - runningSum[min].
+	QVector<double> runningSum(spectrumSize_+1);
+	runningSum[0] = 0;
+
+	AMnDIndex spectrumStart(rank, AMnDIndex::DoInit, 0);
+	AMnDIndex spectrumEnd(rank, AMnDIndex::DoInit, 0);
+	spectrumEnd[rank-1] = spectrumSize_-1;
+
+	for(long p = firstPixel; p <= lastPixel && spectrumSize_ > 0; p++){
+
+		bool pixelChanged = p >= firstChangedPixel_ && p <= lastChangedPixel_;
+		AMnDIndex pixel = AMnDIndex::fromFlatIndexInArrayOfSize(mapSize_, p);
+
+		for(int mu = 0; mu < rank-1; mu++)
+			spectrumStart[mu] = spectrumEnd[mu] = pixel.at(mu);
+
+		if(!spectrumSource_->values(spectrumStart, spectrumEnd, spectrum.data()))
+			return false;
+
+		spectraRead_++;
+
+		for(int c = 0; c < spectrumSize_; c++)
+			runningSum[c+1] = runningSum.at(c) + spectrum.at(c);
+
+		for(int r = 0, count = regions.count(); r < count; r++){
+
+			Region *region = regions.at(r);
+
+			if(pixelChanged || region->needsUpdate){
+
+				int minimum = qMax(0, region->minimum);
+				int maximum = qMin(spectrumSize_-1, region->maximum);
+				region->map[int(p)] = maximum >= minimum ? runningSum.at(maximum+1)-runningSum.at(minimum) : 0;
+			}
+		}
+	}
+
+	for(int r = 0, count = regions.count(); r < count; r++)
+		regions.at(r)->needsUpdate = false;
+
+	firstChangedPixel_ = 0;
+	lastChangedPixel_ = -1;
+	passCount_++;
+
+	return true;
+}
+
+void AMRegionOfInterestEngine::addChangedPixels(long firstPixel, long lastPixel)
+{
+	if(firstChangedPixel_ > lastChangedPixel_){
+
+		firstChangedPixel_ = firstPixel;
+		lastChangedPixel_ = lastPixel;
+	}
+
+	else {
+
+		firstChangedPixel_ = qMin(firstChangedPixel_, firstPixel);
+		lastChangedPixel_ = qMax(lastChangedPixel_, lastPixel);
+	}
+}
+
+long AMRegionOfInterestEngine::flatPixelIndex(const AMnDIndex &pixelIndex) const
+{
+	long rv = 0;
+
+	for(int mu = 0, rank = pixelIndex.rank(); mu < rank; mu++)
+		rv = rv*mapSize_.at(mu) + pixelIndex.at(mu);
+
+	return rv;
+}
@@ -0,0 +1,140 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMREGIONOFINTERESTENGINE_H
+#define AMREGIONOFINTERESTENGINE_H
+
+#include <QMap>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "dataman/AMnDIndex.h"
+#include "dataman/AMNumber.h"
+
+class AMDataSource;
+
+/// This class calculates region-of-interest maps from the spectra stored in a scan, in software.
+/*! The spectrum source is any data source whose last axis is a spectrum: a rank 2 source for a line scan, a rank 3 source for a 2D map, etc.  Every other axis is a "pixel" axis, and each region of interest becomes a map over the pixels: the sum of the spectrum channels from minimum() to maximum() (inclusive) at each pixel.
+
+All the regions on one source are calculated together, in a single pass over the spectra.  Each spectrum is read once with a block values() call, turned into a running (prefix) sum, and then every region costs one subtraction per pixel, regardless of how wide it is.
+
+The maps are calculated lazily, the first time one is asked for:
+- When the input values change, call invalidatePixels() with the changed range.  Only those pixels are re-read on the next pass.
+- When a region changes, only that region is re-calculated, but over all pixels.
+- If the size of the input changes, everything is re-calculated.
+
+Analysis blocks share one engine per source through engineFor() and releaseEngine(), so that N regions on the same spectra still take a single pass.  The engine can also be used on its own.
+
+All of the functions are protected by a mutex, so the maps can be read from any thread.
+*/
+class AMRegionOfInterestEngine
+{
+public:
+	/// Returns the shared engine for \c spectrumSource, creating it if needed.  Every call must be balanced by a call to releaseEngine().
+	static AMRegionOfInterestEngine* engineFor(AMDataSource* spectrumSource);
+	/// Releases a shared engine returned by engineFor().  It is deleted once nobody is using it.
+	static void releaseEngine(AMRegionOfInterestEngine* engine);
+
+	/// Creates an engine for \c spectrumSource, which must have a rank of at least 2.  The engine does not take ownership of the source.
+	explicit AMRegionOfInterestEngine(AMDataSource* spectrumSource);
+
+	/// The data source the spectra are read from
+	AMDataSource* spectrumSource() const { return spectrumSource_; }
+
+	/// The size of the maps: the size of every axis of the source except the last.
+	AMnDIndex mapSize() const;
+	/// The number of channels in each spectrum
+	int spectrumSize() const;
+
+	/// Adds a region from channel \c minimum to \c maximum (inclusive), and returns the id used to refer to it.
+	int addRegion(int minimum, int maximum);
+	/// Changes the channels covered by the region \c regionId.
+	void setRegion(int regionId, int minimum, int maximum);
+	/// Removes the region \c regionId.
+	void removeRegion(int regionId);
+	/// The number of regions being calculated
+	int regionCount() const;
+
+	/// Marks the pixels from \c firstPixel to \c lastPixel (inclusive, as flat indexes into the maps) as changed.
+	void invalidatePixels(long firstPixel, long lastPixel);
+	/// Marks the pixels whose spectra changed between \c start and \c end as changed.  These are indexes into the spectrum source, as reported by its valuesChanged() signal.
+	void invalidateSpectra(const AMnDIndex& start, const AMnDIndex& end);
+	/// Marks all the pixels as changed.
+	void invalidate();
+
+	/// Returns the value of the region \c regionId at the pixel \c pixelIndex (with the rank of mapSize()).  Returns an invalid AMNumber if the region doesn't exist, the pixel is outside the map, or the spectra can't be read.
+	AMNumber mapValue(int regionId, const AMnDIndex& pixelIndex);
+	/// Copies the block of the map of the region \c regionId from \c pixelStart to \c pixelEnd (inclusive) into \c outputValues, in row-major order.  Returns false if the region doesn't exist or the spectra can't be read.
+	bool mapValues(int regionId, const AMnDIndex& pixelStart, const AMnDIndex& pixelEnd, double* outputValues);
+
+	/// The number of passes over the spectra so far
+	int passCount() const;
+	/// The number of spectra read so far, in all passes
+	long spectraRead() const;
+
+protected:
+	/// One region of interest and its map
+	struct Region {
+		Region(int min = 0, int max = 0) : minimum(min), maximum(max), needsUpdate(true) {}
+		int minimum;
+		int maximum;
+		/// True when the whole map has to be re-calculated
+		bool needsUpdate;
+		/// The value at each pixel, in row-major order
+		QVector<double> map;
+	};
+
+	/// Brings all the maps up to date.  Must be called with the mutex locked.
+	bool update();
+	/// Adds the pixels from \c firstPixel to \c lastPixel to the changed range.  Must be called with the mutex locked.
+	void addChangedPixels(long firstPixel, long lastPixel);
+	/// Returns the flat index of \c pixelIndex in the maps.
+	long flatPixelIndex(const AMnDIndex& pixelIndex) const;
+
+	/// The data source the spectra are read from
+	AMDataSource* spectrumSource_;
+	/// The map size at the last update, to notice when the input grows
+	AMnDIndex mapSize_;
+	/// The spectrum size at the last update
+	int spectrumSize_;
+
+	/// The regions, by id
+	QMap<int, Region> regions_;
+	/// The id for the next new region
+	int nextRegionId_;
+
+	/// The range of pixels that changed since the last update.  Empty when firstChangedPixel_ > lastChangedPixel_.
+	long firstChangedPixel_, lastChangedPixel_;
+
+	int passCount_;
+	long spectraRead_;
+
+	/// Protects everything above
+	mutable QMutex mutex_;
+
+	/// The number of users of a shared engine
+	int shareCount_;
+
+	/// The shared engines, by source.  Protected by sharedEnginesMutex_.
+	static QHash<AMDataSource*, AMRegionOfInterestEngine*> sharedEngines_;
+	static QMutex sharedEnginesMutex_;
+};
+
+#endif // AMREGIONOFINTERESTENGINE_H
@@ -0,0 +1,295 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMThreadedAnalysisBlock.h"
+
+#include <QThread>
+#include <QMetaProperty>
+
+#include "dataman/AMAnalysisBlock.h"
+#include "util/AMErrorMonitor.h"
+
+QThread* AMThreadedAnalysisBlock::analysisThread_ = 0;
+
+// Helper function that returns the settings of \c block: the stored, writable properties that its class adds to AMAnalysisBlock.
+static QVariantMap amThreadedAnalysisBlockSettings(const AMAnalysisBlock *block)
+{
+	QVariantMap settings;
+	const QMetaObject *metaObject = block->metaObject();
+
+	for(int i = AMAnalysisBlock::staticMetaObject.propertyCount(), count = metaObject->propertyCount(); i < count; ++i) {
+
+		QMetaProperty property = metaObject->property(i);
+		if(property.isWritable() && property.isStored())
+			settings.insert(property.name(), property.read(block));
+	}
+
+	return settings;
+}
+
+// Helper function that applies \c settings from amThreadedAnalysisBlockSettings() to \c block.
+static void amThreadedAnalysisBlockApplySettings(AMAnalysisBlock *block, const QVariantMap &settings)
+{
+	QMapIterator<QString, QVariant> i(settings);
+	while(i.hasNext()) {
+		i.next();
+		block->setProperty(i.key().toLatin1().constData(), i.value());
+	}
+}
+
+AMThreadedAnalysisBlock::AMThreadedAnalysisBlock(AMAnalysisBlock *block, QObject *parent)
+	: QObject(parent)
+{
+	qRegisterMetaType<AMDataSourceSnapshotData>("AMDataSourceSnapshotData");
+	qRegisterMetaType<QList<AMDataSourceSnapshotData> >("QList<AMDataSourceSnapshotData>");
+
+	block_ = block;
+	original_ = 0;
+	sources_ = block->inputDataSources();
+	inputsChanged_ = false;
+	updateInFlight_ = false;
+	sentGeneration_ = 0;
+	completedUpdateCount_ = 0;
+
+	// The copies start out with the current inputs, so that the block accepts them in place of the originals.
+	QList<AMDataSourceSnapshot*> inputs;
+	QList<AMDataSource*> inputSources;
+	foreach(AMDataSource *source, sources_) {
+		AMDataSourceSnapshot *input = new AMDataSourceSnapshot(AMDataSourceSnapshotData(source));
+		inputs << input;
+		inputSources << input;
+	}
+
+	// Until the first result comes back, the output has the block's axes but no values.
+	AMDataSourceSnapshotData outputData;
+	outputData.name = block->name();
+	outputData.description = block->description();
+	outputData.axes = block->axes();
+	output_ = new AMDataSourceSnapshot(outputData);
+
+	bool canMove = true;
+
+	if(block->parent()) {
+		AMErrorMon::alert(this, AMTHREADEDANALYSISBLOCK_BLOCK_HAS_PARENT, QString("The analysis block '%1' has a parent, so it can't be moved to the analysis thread. It will keep running on its own thread.").arg(block->name()));
+		canMove = false;
+	}
+
+	else if(!block->setInputDataSources(inputSources)) {
+		AMErrorMon::alert(this, AMTHREADEDANALYSISBLOCK_CANNOT_SET_INPUTS, QString("The analysis block '%1' did not accept copies of its inputs, so it can't be moved to the analysis thread. It will keep running on its own thread.").arg(block->name()));
+		canMove = false;
+	}
+
+	worker_ = new AMThreadedAnalysisBlockWorker(block, inputs);
+	connect(worker_, SIGNAL(computed(AMDataSourceSnapshotData,int)), this, SLOT(onComputed(AMDataSourceSnapshotData,int)), Qt::QueuedConnection);
+
+	if(canMove) {
+
+		QThread *thread = analysisThread();
+
+		block->moveToThread(thread);
+		block->signalSource()->moveToThread(thread);
+		foreach(AMDataSourceSnapshot *input, inputs)
+			input->signalSource()->moveToThread(thread);
+		worker_->moveToThread(thread);
+	}
+
+	foreach(AMDataSource *source, sources_) {
+
+		connect(source->signalSource(), SIGNAL(valuesChanged(AMnDIndex,AMnDIndex)), this, SLOT(onInputSourceChanged()), Qt::UniqueConnection);
+		connect(source->signalSource(), SIGNAL(sizeChanged(int)), this, SLOT(onInputSourceChanged()), Qt::UniqueConnection);
+		connect(source->signalSource(), SIGNAL(axisInfoChanged(int)), this, SLOT(onInputSourceChanged()), Qt::UniqueConnection);
+		connect(source->signalSource(), SIGNAL(stateChanged(int)), this, SLOT(onInputSourceChanged()), Qt::UniqueConnection);
+		connect(source->signalSource(), SIGNAL(deleted(void*)), this, SLOT(onInputSourceDeleted(void*)), Qt::UniqueConnection);
+	}
+
+	connect(&updateScheduler_, SIGNAL(executed()), this, SLOT(sendUpdate()));
+
+	// The copies already hold the current inputs; all that's missing is the first result.
+	updateInFlight_ = true;
+	QMetaObject::invokeMethod(worker_, "recapture", Qt::QueuedConnection);
+}
+
+AMThreadedAnalysisBlock* AMThreadedAnalysisBlock::createForCopyOf(AMAnalysisBlock *original, QObject *parent)
+{
+	AMAnalysisBlock *copy = original->createThreadedCopy();
+	if(!copy)
+		return 0;
+
+	// Inputs first: some settings (ex: the summed axis of AM3DBinningAB) only take effect once there is an input.
+	copy->setInputDataSources(original->inputDataSources());
+	amThreadedAnalysisBlockApplySettings(copy, amThreadedAnalysisBlockSettings(original));
+	copy->setDescription(original->description());
+
+	AMThreadedAnalysisBlock *rv = new AMThreadedAnalysisBlock(copy, parent);
+
+	// The original re-emits changes of its inputs, and also emits when its settings change.
+	rv->original_ = original;
+	connect(original->signalSource(), SIGNAL(valuesChanged(AMnDIndex,AMnDIndex)), rv, SLOT(onInputSourceChanged()));
+	connect(original->signalSource(), SIGNAL(sizeChanged(int)), rv, SLOT(onInputSourceChanged()));
+	connect(original->signalSource(), SIGNAL(deleted(void*)), rv, SLOT(onInputSourceDeleted(void*)));
+
+	return rv;
+}
+
+AMThreadedAnalysisBlock::~AMThreadedAnalysisBlock()
+{
+	// If the worker is busy, it finishes the current calculation before deleting the block.
+	if(worker_->thread() != QThread::currentThread() && worker_->thread()->isRunning())
+		worker_->deleteLater();
+	else
+		delete worker_;
+
+	delete output_;
+}
+
+QThread* AMThreadedAnalysisBlock::analysisThread()
+{
+	if(!analysisThread_) {
+
+		analysisThread_ = new QThread();
+		analysisThread_->start();
+	}
+
+	return analysisThread_;
+}
+
+void AMThreadedAnalysisBlock::releaseAnalysisThread()
+{
+	if(!analysisThread_)
+		return;
+
+	// Any workers deleted with deleteLater() are cleaned up as the thread finishes.
+	analysisThread_->quit();
+	analysisThread_->wait();
+
+	delete analysisThread_;
+	analysisThread_ = 0;
+}
+
+void AMThreadedAnalysisBlock::onInputSourceChanged()
+{
+	inputsChanged_ = true;
+	updateScheduler_.schedule();
+}
+
+void AMThreadedAnalysisBlock::onInputSourceDeleted(void *deletedSource)
+{
+	for(int i = 0, count = sources_.count(); i < count; ++i)
+		if((void*)sources_.at(i) == deletedSource)
+			sources_[i] = 0;
+
+	if((void*)original_ == deletedSource)
+		original_ = 0;
+
+	onInputSourceChanged();
+}
+
+void AMThreadedAnalysisBlock::sendUpdate()
+{
+	if(updateInFlight_ || !inputsChanged_)
+		return;
+
+	// All of the inputs are captured here, together, so the block never sees one input ahead of another.
+	QList<AMDataSourceSnapshotData> inputData;
+	foreach(AMDataSource *source, sources_)
+		inputData << AMDataSourceSnapshotData(source);
+
+	QVariantMap settings;
+	if(original_)
+		settings = amThreadedAnalysisBlockSettings(original_);
+
+	inputsChanged_ = false;
+	updateInFlight_ = true;
+	QMetaObject::invokeMethod(worker_, "compute", Qt::QueuedConnection, Q_ARG(QList<AMDataSourceSnapshotData>, inputData), Q_ARG(QVariantMap, settings), Q_ARG(int, ++sentGeneration_));
+}
+
+void AMThreadedAnalysisBlock::onComputed(const AMDataSourceSnapshotData &output, int generation)
+{
+	output_->setData(output);
+	completedUpdateCount_++;
+
+	if(generation == sentGeneration_ && updateInFlight_) {
+
+		updateInFlight_ = false;
+
+		// Anything that changed while the block was busy goes out as one update.
+		if(inputsChanged_)
+			sendUpdate();
+	}
+
+	emit outputUpdated();
+}
+
+AMThreadedAnalysisBlockWorker::AMThreadedAnalysisBlockWorker(AMAnalysisBlock *block, const QList<AMDataSourceSnapshot *> &inputs)
+	: QObject()
+{
+	block_ = block;
+	inputs_ = inputs;
+	computing_ = false;
+	recapturePending_ = false;
+	generation_ = 0;
+
+	connect(block_->signalSource(), SIGNAL(valuesChanged(AMnDIndex,AMnDIndex)), this, SLOT(onBlockChanged()));
+	connect(block_->signalSource(), SIGNAL(sizeChanged(int)), this, SLOT(onBlockChanged()));
+	connect(block_->signalSource(), SIGNAL(stateChanged(int)), this, SLOT(onBlockChanged()));
+}
+
+AMThreadedAnalysisBlockWorker::~AMThreadedAnalysisBlockWorker()
+{
+	delete block_;
+	qDeleteAll(inputs_);
+}
+
+void AMThreadedAnalysisBlockWorker::compute(const QList<AMDataSourceSnapshotData> &inputData, const QVariantMap &settings, int generation)
+{
+	computing_ = true;
+
+	amThreadedAnalysisBlockApplySettings(block_, settings);
+
+	for(int i = 0, count = qMin(inputs_.count(), inputData.count()); i < count; ++i)
+		inputs_.at(i)->setData(inputData.at(i));
+
+	generation_ = generation;
+
+	// Reading the whole output is where the block actually does its calculation.
+	AMDataSourceSnapshotData output(block_);
+	computing_ = false;
+
+	emit computed(output, generation_);
+}
+
+void AMThreadedAnalysisBlockWorker::recapture()
+{
+	recapturePending_ = false;
+
+	computing_ = true;
+	AMDataSourceSnapshotData output(block_);
+	computing_ = false;
+
+	emit computed(output, generation_);
+}
+
+void AMThreadedAnalysisBlockWorker::onBlockChanged()
+{
+	if(computing_ || recapturePending_)
+		return;
+
+	recapturePending_ = true;
+	QMetaObject::invokeMethod(this, "recapture", Qt::QueuedConnection);
+}
@@ -0,0 +1,163 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMTHREADEDANALYSISBLOCK_H
+#define AMTHREADEDANALYSISBLOCK_H
+
+#include <QObject>
+#include <QList>
+#include <QVariantMap>
+
+#include "dataman/datasource/AMDataSourceSnapshot.h"
+#include "util/AMDeferredFunctionCall.h"
+
+class QThread;
+class AMAnalysisBlock;
+class AMThreadedAnalysisBlockWorker;
+
+#define AMTHREADEDANALYSISBLOCK_BLOCK_HAS_PARENT 291101
+#define AMTHREADEDANALYSISBLOCK_CANNOT_SET_INPUTS 291102
+
+/// This class runs an AMAnalysisBlock on the shared analysis thread, instead of the GUI thread.
+/*! Normally every analysis block lives in the GUI thread and re-calculates when its inputs emit valuesChanged().  For expensive blocks (REIXSXESImageAB, AM3DBinningAB, AM4DBinningAB, ...) on a scan that is still acquiring, that freezes the user interface for as long as each calculation takes.
+
+Creating an AMThreadedAnalysisBlock for a block that is already connected to its inputs moves the block off the GUI thread:
+
+- The block's inputs are replaced by AMDataSourceSnapshot copies, which the block reads on the analysis thread.  The original inputs are never touched outside the GUI thread.
+- The block (and its AMDataSourceSignalSource) is moved to analysisThread().
+- When the original inputs change, all of them are captured together, at the next return to the event loop, and the copies are sent to the analysis thread.  The block sees the new inputs, and its complete output is read there (which is where the calculation actually happens) and sent back.
+- The results are served to plots and other blocks by output(), an AMDataSourceSnapshot that only ever changes on the GUI thread, and always holds one complete result.  Plot adapters such as AMDataSourceSeriesData and AMDataSourceImageData can use it like any other source.
+
+Only one update is in flight at a time.  If the inputs change while the block is busy, the changes are collected and sent as a single update when it finishes, so a slow block falls behind by at most one update, instead of building up a queue.
+
+After it is handed over, the block belongs to the analysis thread: don't call its functions directly from the GUI thread.  Parameters can still be changed with QMetaObject::invokeMethod() and a Qt::QueuedConnection (ex: on the setter slots); the output is refreshed automatically when the block emits valuesChanged() or sizeChanged().  Deleting the AMThreadedAnalysisBlock deletes the block on the analysis thread.
+
+A block that already has a QObject parent can't be moved to another thread.  In that case an error is reported, and the block keeps running on its own thread, behind the same output().
+
+The analysis blocks of a scan are owned, stored and edited by the scan on the GUI thread, so they can't be handed over.  For those, createForCopyOf() runs a copy of the block instead (see AMAnalysisBlock::createThreadedCopy()).  The copy follows the settings of the original, which stays in the scan and is only read when something other than the plot asks for its values.  This is how AMScanView plots REIXSXESImageAB, AM3DBinningAB and AM4DBinningAB.
+*/
+class AMThreadedAnalysisBlock : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Takes over \c block, which should already be connected to its input sources.  The AMThreadedAnalysisBlock takes ownership of the block.
+	explicit AMThreadedAnalysisBlock(AMAnalysisBlock *block, QObject *parent = 0);
+	/// Deletes the output source, and the block on the analysis thread.
+	virtual ~AMThreadedAnalysisBlock();
+
+	/// Creates an AMThreadedAnalysisBlock that runs a copy of \c original, with the same inputs and settings.  Whenever the original changes (inputs or settings), its current settings are sent to the copy with the next update.  Returns 0 if \c original doesn't provide a copy (AMAnalysisBlock::createThreadedCopy()).
+	static AMThreadedAnalysisBlock* createForCopyOf(AMAnalysisBlock *original, QObject *parent = 0);
+
+	/// The shared thread that all threaded analysis blocks run on.  It is created and started the first time it is needed.
+	static QThread* analysisThread();
+	/// Stops and deletes the shared analysis thread.  Call this at shutdown, after all threaded analysis blocks have been deleted.
+	static void releaseAnalysisThread();
+
+	/// The block being run.  It lives on analysisThread(); see the class description for how to use it.
+	AMAnalysisBlock* block() const { return block_; }
+	/// For blocks created with createForCopyOf(), the block that the copy follows.  It stays on the GUI thread.  0 if there isn't one, or if it has been deleted.
+	AMAnalysisBlock* original() const { return original_; }
+	/// The original input sources of the block, on the GUI thread.  Deleted inputs are replaced by 0.
+	QList<AMDataSource*> inputDataSources() const { return sources_; }
+	/// The latest complete result of the block.  Use this in place of the block for plotting, or as input for other blocks.
+	AMDataSource* output() const { return output_; }
+
+	/// True when output() reflects the current inputs: no changes are waiting to be sent, and no update is in flight.
+	bool isUpToDate() const { return !inputsChanged_ && !updateInFlight_; }
+	/// The number of results received from the analysis thread so far
+	int completedUpdateCount() const { return completedUpdateCount_; }
+
+signals:
+	/// Emitted on the GUI thread after output() has been updated with a new result.
+	void outputUpdated();
+
+protected slots:
+	/// Called when any of the original inputs change.  Schedules an update.
+	void onInputSourceChanged();
+	/// Called when one of the original inputs (or the original block) is deleted.  The input's copy becomes invalid on the next update.
+	void onInputSourceDeleted(void *deletedSource);
+	/// Captures all of the original inputs and sends them to the analysis thread, unless an update is already in flight.
+	void sendUpdate();
+	/// Called (queued) with each new result from the analysis thread.
+	void onComputed(const AMDataSourceSnapshotData &output, int generation);
+
+protected:
+	/// The block being run
+	AMAnalysisBlock *block_;
+	/// The block whose settings are copied to block_ with each update, or 0
+	AMAnalysisBlock *original_;
+	/// The original inputs of the block
+	QList<AMDataSource*> sources_;
+	/// Serves the latest result on the GUI thread
+	AMDataSourceSnapshot *output_;
+	/// Does the work on the analysis thread; owns the block and its input copies.
+	AMThreadedAnalysisBlockWorker *worker_;
+
+	/// Collects input changes into one update per event loop
+	AMDeferredFunctionCall updateScheduler_;
+	/// True when the inputs have changed since they were last sent
+	bool inputsChanged_;
+	/// True while an update has been sent and its result has not come back
+	bool updateInFlight_;
+	/// Numbers the updates sent, so we can tell when the result of the latest one is back
+	int sentGeneration_;
+	int completedUpdateCount_;
+
+	/// The shared analysis thread
+	static QThread *analysisThread_;
+};
+
+/// This class does the work of an AMThreadedAnalysisBlock on the analysis thread.  You should never need to use it directly.
+class AMThreadedAnalysisBlockWorker : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Takes ownership of \c block and of its input copies \c inputs.
+	AMThreadedAnalysisBlockWorker(AMAnalysisBlock *block, const QList<AMDataSourceSnapshot*> &inputs);
+	/// Deletes the block, and then its input copies.
+	virtual ~AMThreadedAnalysisBlockWorker();
+
+public slots:
+	/// Applies \c settings to the block (if any), installs \c inputData in the input copies, reads the complete output of the block, and emits computed() with it.
+	void compute(const QList<AMDataSourceSnapshotData> &inputData, const QVariantMap &settings, int generation);
+	/// Reads the output of the block again, for the current inputs, and emits computed() with it.
+	void recapture();
+
+signals:
+	/// Emitted with each new result.  \c generation is the generation of the inputs it was calculated from.
+	void computed(const AMDataSourceSnapshotData &output, int generation);
+
+protected slots:
+	/// Called when the block's output changes on its own (ex: a parameter was changed).  Schedules recapture().
+	void onBlockChanged();
+
+protected:
+	AMAnalysisBlock *block_;
+	QList<AMDataSourceSnapshot*> inputs_;
+	/// True inside compute() and recapture(), when the block's own signals are expected and ignored.
+	bool computing_;
+	/// True when recapture() has been scheduled but has not run yet.
+	bool recapturePending_;
+	/// The generation of the inputs currently installed
+	int generation_;
+};
+
+#endif // AMTHREADEDANALYSISBLOCK_H
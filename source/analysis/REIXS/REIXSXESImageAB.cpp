@@ -51,6 +51,8 @@ REIXSXESImageAB::REIXSXESImageAB(const QString &outputName, QObject *parent) :
 
 	axes_ << AMAxisInfo("invalid", 0, "No input data");
 
+	// Parented so that it follows the block if the block is moved to the analysis thread (AMThreadedAnalysisBlock).
+	callCorrelation_.setParent(this);
 	connect(&callCorrelation_, SIGNAL(executed()), this, SLOT(correlateNow()));
 	setDescription("XES Analyzed Spectrum");
 }
@@ -81,6 +83,8 @@ REIXSXESImageAB::REIXSXESImageAB(AMDatabase *db, int id) :
 	loadFromDb(db, id); // will restore the parameters sumRangeMin_, sumRangeMax_, correlation settings, and shift values. We'll remain invalid until we get connected to a data source.
 	AMDataSource::name_ = AMDbObject::name();	// normally it's not okay to change a dataSource's name. Here we get away with it because we're within the constructor, and nothing's watching us yet.
 
+	// Parented so that it follows the block if the block is moved to the analysis thread (AMThreadedAnalysisBlock).
+	callCorrelation_.setParent(this);
 	connect(&callCorrelation_, SIGNAL(executed()), this, SLOT(correlateNow()));
 }
 
@@ -168,6 +168,8 @@ public:
 	////////////////////////////////////
 	/// Create, connect, and return a widget suitable for displaying/editing the expressions.
 	virtual QWidget* createEditorWidget();
+	/// Summing a whole detector image (with shifts) is slow, so plots calculate a copy of this block on the analysis thread.
+	virtual AMAnalysisBlock* createThreadedCopy() const { return new REIXSXESImageAB(name()); }
 
 
 	// Data value access
@@ -19,7 +19,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include "SGM1DFastScanFilterAB.h"
-#include <QDebug>
+#include "util/AMSlidingWindow.h"
 #include <math.h>
 
 SGM1DFastScanFilterAB::SGM1DFastScanFilterAB(const QString &outputName, QObject *parent) :
@@ -190,64 +190,41 @@ void SGM1DFastScanFilterAB::onInputSourceSizeChanged() {
 		//axes_[0].size = inputSource_->size(0);
 		inputAxis_.size = inputSource_->size(0);
 
-		QList<int> ignoreIndices;
-		int numLost = 1;
-		ignoreIndices << 0;
-
-		int numMoving = 0;
-		for(int x = 1; x < inputAxis_.size; x++){
-			if( fabs((double)inputSource_->axisValue(0,x)-(double)inputSource_->axisValue(0, x-1)) < 0.001 ){
-				if(numMoving > 3)
-					qDebug() << "Stopped moving on " << x;
-				numMoving = 0;
-				ignoreIndices << x;
-				numLost++;
-			}
-			else if(numMoving >= 3){
-				if(numMoving == 3){
-					ignoreIndices.pop_back();
-					ignoreIndices.pop_back();
-					numLost -= 2;
-					qDebug() << "Started moving on " << x;
-				}
-				numMoving++;
-			}
-			else{
-				ignoreIndices << x;
-				numLost++;
-				numMoving++;
-			}
-		}
-
-		/*
-		for(int x = 1; x < inputAxis_.size; x++){
-			if( fabs((double)inputSource_->axisValue(0,x)-(double)inputSource_->axisValue(0, x-1)) < 0.001 ){
-				ignoreIndices << x;
-				numLost++;
-				//qdebug() << "XX" << (double)inputSource_->axisValue(0,x) << (double)inputSource_->value(x);
-			}
-			else{
-				//qdebug() << (double)inputSource_->axisValue(0,x) << (double)inputSource_->value(x);
-			}
-		}
-		*/
-		qDebug() << "Total lost: " << numLost << ignoreIndices;
-		axes_[0].size = inputAxis_.size-numLost;
+		// Read each axis value once, rather than twice per point.
+		QVector<AMNumber> inputAxisValues(inputAxis_.size);
+		for(int x = 0; x < inputAxis_.size; x++)
+			inputAxisValues[x] = inputSource_->axisValue(0, x);
+
+		// Points are only kept while the monochromator moves steadily: both steps into the point moved (by 0.001 or more), and there are at least 3 such points in a row.
+		// This drops the points where it stood still, and the first ones after it starts moving again.  steadyMoves has an extra 0 at the end, so that the windows aren't truncated there.
+		QVector<double> steadyMoves(inputAxis_.size+1, 0);
+		for(int x = 2; x < inputAxis_.size; x++)
+			if(fabs((double)inputAxisValues.at(x)-(double)inputAxisValues.at(x-1)) >= 0.001 && fabs((double)inputAxisValues.at(x-1)-(double)inputAxisValues.at(x-2)) >= 0.001)
+				steadyMoves[x] = 1;
+
+		// A running minimum and then a running maximum over 3 points (a morphological opening) removes the runs shorter than 3.
+		QVector<double> steadyRuns(steadyMoves.size()), kept(steadyMoves.size());
+		AMSlidingWindow::runningMinimum(steadyMoves.constData(), steadyMoves.size(), 1, steadyRuns.data());
+		AMSlidingWindow::runningMaximum(steadyRuns.constData(), steadyRuns.size(), 1, kept.data());
+
+		int numKept = 0;
+		for(int x = 0; x < inputAxis_.size; x++)
+			if(kept.at(x) != 0)
+				numKept++;
+
+		axes_[0].size = numKept;
 		invalidateCache();
+
 		int goodIndex = 0;
 		for(int x = 0; x < inputAxis_.size; x++){
-			if(!ignoreIndices.contains(x)){
+			if(kept.at(x) != 0){
 				cachedValues_[goodIndex] = inputSource_->value(x);
-				cachedAxisValues_[goodIndex] = inputSource_->axisValue(0, x);
+				cachedAxisValues_[goodIndex] = inputAxisValues.at(x);
 				goodIndex++;
 			}
 		}
 		cacheCompletelyInvalid_ = false;
 
-		//qdebug() << "\n\n";
-		//qdebug() << cachedValues_.size() << cachedAxisValues_.size() << axes_.at(0).size << inputAxis_.size << numLost;
-		//qdebug() << "\n\n";
-
 		emitSizeChanged(0);
 	}
 }
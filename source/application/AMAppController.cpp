@@ -19,6 +19,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include <QStringBuilder>
+#include <QTimer>
 
 #include "AMAppController.h"
 
@@ -32,6 +33,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ui/actions3/AMWorkflowView3.h"
 #include "ui/AMAppBottomPanel.h"
+#include "beamline/AMBeamline.h"
 #include "actions3/AMActionRunner3.h"
 #include "actions3/AMActionRegistry3.h"
 #include "actions3/AMLoopAction3.h"
@@ -55,6 +57,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "acquaman/AMNestedAxisTypeValidator.h"
 
 #include "acquaman/AMAgnosticDataAPI.h"
+#include "dataman/AMScanJournal.h"
+#include "dataman/database/AMDatabase.h"
 
 AMAppController::AMAppController(QObject *parent)
 	: AMDatamanAppControllerForActions3(parent)
@@ -95,6 +99,13 @@ bool AMAppController::startup(){
 		AMNestedAxisTypeValidator *nestedAxisValidator = new AMNestedAxisTypeValidator();
 		AMAppControllerSupport::appendPrincipleValidator(nestedAxisValidator);
 
+		// Scans that were still running the last time we stopped left their journals behind.  Recover and save whatever data they collected.
+		foreach(QString journalFilePath, AMScanJournal::unfinishedJournals())
+			AMScanJournal::recoverToDatabase(journalFilePath, AMDatabase::database("user"));
+
+		// The beamline is created by the subclass right after this returns, and its controls connect in the background.  Show their progress once it exists.
+		QTimer::singleShot(0, this, SLOT(showBeamlineConnectionProgress()));
+
 		return success;
 	}
 	else
@@ -143,6 +154,14 @@ void AMAppController::addBottomPanel()
 	bottomPanel_ = panel;
 }
 
+void AMAppController::showBeamlineConnectionProgress()
+{
+	AMAppBottomPanel *panel = qobject_cast<AMAppBottomPanel *>(bottomPanel_);
+
+	if(panel && AMBeamline::isCreated())
+		panel->setBeamline(AMBeamline::bl());
+}
+
 void AMAppController::goToWorkflow()
 {
 	mw_->setCurrentPane(workflowView_);
@@ -84,6 +84,8 @@ protected slots:
 	void onCurrentScanActionFinished(AMScanAction *action);
 	/// Slot that changes the state of the scanEditorModelItem state when the scan action state changes.
 	void updateScanEditorModelItem();
+	/// Hands the beamline to the bottom panel, so that the controls that are still connecting are shown there.  Called on the first pass through the event loop after startup().
+	void showBeamlineConnectionProgress();
 
 protected:
 	/// Implementation method that individual applications can flesh out if extra setup is required when a scan action is started.  This is not pure virtual because there is no requirement to do anything to scan actions.
@@ -30,6 +30,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataman/export/AMExportController.h"
 #include "dataman/export/AMExporterGeneralAscii.h"
 #include "dataman/export/AMExporterAthena.h"
+#include "dataman/export/AMExporterBinary.h"
 
 #include "ui/AMMainWindow.h"
 #include "ui/AMWorkflowManagerView.h"
@@ -43,6 +44,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "ui/AMDatamanStartupSplashScreen.h"
 
 #include "application/AMPluginsManager.h"
+#include "actions3/AMActionLogQueue3.h"
 
 #include "util/AMErrorMonitor.h"
 
@@ -78,9 +80,12 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "analysis/AM2DSummingAB.h"
 #include "analysis/AM1DDerivativeAB.h"
 #include "analysis/AMExternalScanDataSourceAB.h"
+#include "analysis/AMExternalScanDataCache.h"
+#include "analysis/AMThreadedAnalysisBlock.h"
 #include "analysis/AM1DSummingAB.h"
 #include "analysis/AMDeadTimeAB.h"
 #include "dataman/export/AMExporterOptionGeneralAscii.h"
+#include "dataman/export/AMExporterOptionBinary.h"
 #include "dataman/AM2DScan.h"
 #include "dataman/AM3DScan.h"
 #include "analysis/AM2DNormalizationAB.h"
@@ -91,11 +96,13 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "analysis/AM2DDeadTimeAB.h"
 #include "analysis/AM3DDeadTimeAB.h"
 #include "analysis/AMOrderReductionAB.h"
+#include "analysis/AMRegionOfInterestAB.h"
 
 #include "dataman/AMDbUpgrade1Pt1.h"
 #include "dataman/AMDbUpgrade1Pt2.h"
 
 #include "dataman/database/AMDbObjectSupport.h"
+#include "dataman/database/AMDbSearchIndex.h"
 #include "ui/dataman/AMDbObjectGeneralView.h"
 #include "ui/dataman/AMDbObjectGeneralViewSupport.h"
 #include "acquaman/AM2DScanConfiguration.h"
@@ -131,8 +138,13 @@ bool AMDatamanAppController::startup() {
 
 	AM::registerTypes();
 
+	// Each startup phase reports how long it took, at debug level.
+	startupTime_.start();
+	startupPhaseTime_.start();
+
 	if(!startupBeforeAnything())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_BEFORE_ANYTHING, "Problem with Acquaman startup: before any other startup routines.");
+	reportStartupPhaseTime("startupBeforeAnything");
 
 	splashScreen_ = new AMDatamanStartupSplashScreen();
 	splashScreen_->show();
@@ -144,49 +156,68 @@ bool AMDatamanAppController::startup() {
 
 	if(!startupLoadSettings())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_LOADING_SETTING, "Problem with Acquaman startup: loading settings.");
+	reportStartupPhaseTime("startupLoadSettings");
 
 	if(!startupLoadPlugins())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_LOADING_PLUGINS, "Problem with Acquaman startup: loading plugins.");
+	reportStartupPhaseTime("startupLoadPlugins");
 
 	if((isFirstTimeRun_ = startupIsFirstTime())) {
 		if(!startupOnFirstTime())
 			return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_LOADING_SETTING, "Problem with Acquaman startup: handling first-time user.");
+		reportStartupPhaseTime("startupOnFirstTime");
 	}
 	else {
 		if(!startupOnEveryTime())
 			return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_HANDING_NON_FIRST_TIME_USER, "Problem with Acquaman startup: handling non-first-time user.");
+		reportStartupPhaseTime("startupOnEveryTime");
 	}
 
+	if(!startupFinishLoadingPlugins())
+		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_LOADING_PLUGINS, "Problem with Acquaman startup: loading plugins.");
+	reportStartupPhaseTime("startupFinishLoadingPlugins");
+
 	if(!startupRegisterDatabases())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_REGISTERING_DATABASES, "Problem with Acquaman startup: registering databases.");
+	reportStartupPhaseTime("startupRegisterDatabases");
 
 	// Now that we have a database: populate initial settings, or just load user settings
 	if(isFirstTimeRun_) {
 		if(!startupPopulateNewDatabase())
 			return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_POPULATING_NEW_USER_DATABASE, "Problem with Acquaman startup: populating new user database.");
+		reportStartupPhaseTime("startupPopulateNewDatabase");
 	}
 	else {
 		if(!startupLoadFromExistingDatabase())
 			return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_REVIEWING_EXISTING_USER_DATABASE, "Problem with Acquaman startup: reviewing existing database.");
+		reportStartupPhaseTime("startupLoadFromExistingDatabase");
 	}
 
 	if(!startupRegisterExporters())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_REGISTERING_EXPORTERS, "Problem with Acquaman startup: registering exporters.");
+	reportStartupPhaseTime("startupRegisterExporters");
 
 	if(!startupBeforeUserInterface())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_BEFORE_USER_INTERFACE, "Problem with Acquaman startup: prior to setting up the user interface.");
+	reportStartupPhaseTime("startupBeforeUserInterface");
 
 	if(!startupCreateUserInterface())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_SETTING_UP_USER_INTERFACE, "Problem with Acquaman startup: setting up the user interface.");
+	reportStartupPhaseTime("startupCreateUserInterface");
 
 	if(!startupAfterUserInterface())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_AFTER_USER_INTERFACE, "Problem with Acquaman startup: after setting up the user interface.");
+	reportStartupPhaseTime("startupAfterUserInterface");
 
 	if(!startupInstallActions())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_INSTALLING_MENU_ACTIONS, "Problem with Acquaman startup: installing menu actions.");
+	reportStartupPhaseTime("startupInstallActions");
 
 	if(!startupAfterEverything())
 		return AMErrorMon::errorAndReturn(this, AMDATAMANAPPCONTROLLER_STARTUP_ERROR_AFTER_EVERYTHING, "Problem with Acquaman startup: after all other startup routines.");
+	reportStartupPhaseTime("startupAfterEverything");
+
+	AMErrorMon::debug(this, AMDATAMANAPPCONTROLLER_STARTUP_TIMING, QString("Acquaman Startup: all startup phases took %1 ms").arg(startupTime_.elapsed()));
 
 	emit datamanStartupFinished();
 
@@ -194,6 +225,11 @@ bool AMDatamanAppController::startup() {
 	return true;
 }
 
+void AMDatamanAppController::reportStartupPhaseTime(const QString &phaseName)
+{
+	AMErrorMon::debug(this, AMDATAMANAPPCONTROLLER_STARTUP_TIMING, QString("Acquaman Startup: %1() took %2 ms").arg(phaseName).arg(startupPhaseTime_.restart()));
+}
+
 bool AMDatamanAppController::startupLoadSettings()
 {
 	AMErrorMon::information(this, AMDATAMANAPPCONTROLLER_STARTUP_MESSAGES, "Acquaman Startup: Loading Settings");
@@ -217,8 +253,20 @@ bool AMDatamanAppController::startupLoadPlugins()
 {
 	AMErrorMon::information(this, AMDATAMANAPPCONTROLLER_STARTUP_MESSAGES, "Acquaman Startup: Loading Plugins");
 	qApp->processEvents();
-	// Load plugins:
-	AMPluginsManager::s()->loadApplicationPlugins();
+	// Load plugins in the background: scanning the plugin folders doesn't depend on the databases, so it can overlap with opening and upgrading them.  The folders are read here, on the main thread.
+	pluginsLoading_ = AMPluginsManager::s()->loadApplicationPluginsInBackground(AMSettings::s()->fileLoaderPluginsFolder(), AMSettings::s()->analysisBlockPluginsFolder());
+	return true;
+}
+
+bool AMDatamanAppController::startupFinishLoadingPlugins()
+{
+	if(!pluginsLoading_.isFinished()){
+
+		AMErrorMon::information(this, AMDATAMANAPPCONTROLLER_STARTUP_SUBTEXT, "Waiting for plugins to finish loading");
+		qApp->processEvents();
+	}
+
+	pluginsLoading_.waitForFinished();
 	return true;
 }
 
@@ -463,7 +511,10 @@ bool AMDatamanAppController::onEveryTimeDatabaseUpgrade(QList<AMDbUpgrade *> upg
 			// Actually call the upgrade if it's necessary
 			if(success && upgrade->upgradeNecessary()){
 				upgradeIsNecessary = true;
-				if(!upgrade->upgrade()){
+				connect(upgrade, SIGNAL(progressChanged(int,int,QString)), this, SLOT(onDatabaseUpgradeProgress(int,int,QString)));
+				bool upgraded = upgrade->upgrade();
+				disconnect(upgrade, SIGNAL(progressChanged(int,int,QString)), this, SLOT(onDatabaseUpgradeProgress(int,int,QString)));
+				if(!upgraded){
 					lastErrorString = QString("Upgrade run failed for upgrade %1").arg(upgrade->upgradeToTag());
 					lastErrorCode = AMDATAMANAPPCONTROLLER_DB_UPGRADE_UPGRADE_FAILURE;
 					success = false;
@@ -549,6 +600,7 @@ bool AMDatamanAppController::startupRegisterDatabases()
 	success &= AMDbObjectSupport::s()->registerClass<AM2DDeadTimeAB>();
 	success &= AMDbObjectSupport::s()->registerClass<AM3DDeadTimeAB>();
 	success &= AMDbObjectSupport::s()->registerClass<AMOrderReductionAB>();
+	success &= AMDbObjectSupport::s()->registerClass<AMRegionOfInterestAB>();
 
 	success &= AMDbObjectSupport::s()->registerClass<AMOldDetectorInfo>();
 	success &= AMDbObjectSupport::s()->registerClass<AMSpectralOutputDetectorInfo>();
@@ -564,12 +616,20 @@ bool AMDatamanAppController::startupRegisterDatabases()
 	success &= AMDbObjectSupport::s()->registerClass<AMROIInfoList>();
 
 	success &= AMDbObjectSupport::s()->registerClass<AMExporterOptionGeneralAscii>();
+	success &= AMDbObjectSupport::s()->registerClass<AMExporterOptionBinary>();
 
 	success &= AMDbObjectSupport::s()->registerClass<AMUser>();
 
 	success &= AMDbObjectGeneralViewSupport::registerClass<AMDbObject, AMDbObjectGeneralView>();
 	success &= AMDbObjectGeneralViewSupport::registerClass<AM2DScanConfiguration, AM2DScanConfigurationGeneralView>();
 
+	// Full-text search over scan names, notes, and sample names, for the data view's search box.  (If the SQLite library doesn't support it, the data view simply doesn't offer searching.)
+	AMDbSearchIndex* scanSearchIndex = AMDbSearchIndex::createSearchIndex(db, AMDbObjectSupport::s()->tableNameForClass<AMScan>(), QStringList() << "name" << "notes");
+	if(scanSearchIndex) {
+		scanSearchIndex->addRelatedColumn("sampleId", AMDbObjectSupport::s()->tableNameForClass<AMSample>(), "name");
+		scanSearchIndex->initialize();
+	}
+
 	return success;
 }
 
@@ -614,6 +674,7 @@ bool AMDatamanAppController::startupRegisterExporters()
 	// Install exporters
 	AMExportController::registerExporter<AMExporterGeneralAscii>();
 	AMExportController::registerExporter<AMExporterAthena>();
+	AMExportController::registerExporter<AMExporterBinary>();
 
 	return true;
 }
@@ -759,6 +820,18 @@ void AMDatamanAppController::shutdown() {
 	// destroy the main window. This will delete everything else within it.
 	delete mw_;
 
+	// Write any completed-action logs that are still waiting in the queue.
+	AMActionLogQueue3::releaseQueue();
+
+	// Write any search index changes that are still waiting.
+	AMDbSearchIndex::releaseSearchIndexes();
+
+	// Drop the shared copies of external scan data.
+	AMExternalScanDataCache::releaseCache();
+
+	// Stop the thread that plotted analysis blocks were calculated on.
+	AMThreadedAnalysisBlock::releaseAnalysisThread();
+
 	// Close down connection to the user Database
 	AMDatabase::deleteDatabase("user");
 
@@ -986,6 +1059,19 @@ void AMDatamanAppController::onIssueSubmissionViewFinished(){
 	issueSubmissionView_ = 0;
 }
 
+void AMDatamanAppController::onDatabaseUpgradeProgress(int completedSteps, int totalSteps, const QString &description)
+{
+	AMDbUpgrade *upgrade = qobject_cast<AMDbUpgrade*>(sender());
+	QString upgradeTag = upgrade ? upgrade->upgradeToTag() : QString("Database upgrade");
+
+	if(completedSteps < totalSteps)
+		AMErrorMon::information(this, AMDATAMANAPPCONTROLLER_STARTUP_SUBTEXT, QString("%1: step %2 of %3: %4").arg(upgradeTag).arg(completedSteps+1).arg(totalSteps).arg(description));
+	else
+		AMErrorMon::information(this, AMDATAMANAPPCONTROLLER_STARTUP_SUBTEXT, QString("%1: finished").arg(upgradeTag));
+
+	qApp->processEvents();
+}
+
 void AMDatamanAppController::onStartupFinished(){
 	AMErrorMon::information(this, AMDATAMANAPPCONTROLLER_STARTUP_FINISHED, "Acquaman Startup: Finished");
 }
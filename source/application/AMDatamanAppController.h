@@ -26,6 +26,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QList>
 #include <QModelIndex>
 #include <QStringList>
+#include <QTime>
+#include <QFuture>
 
 #include "util/AMOrderedSet.h"
 
@@ -83,6 +85,7 @@ class AMScan;
 #define AMDATAMANAPPCONTROLLER_DB_UPGRADE_EVERY_TIME_UPGRADES_FAILED 270225
 
 #define AMDATAMANAPPCONTROLLER_USER_SETTINGS_STARTUP_ERROR 270226
+#define AMDATAMANAPPCONTROLLER_STARTUP_TIMING 270227
 
 /// This class takes the role of the main application controller for your particular version of the Acquaman program. It marshalls communication between separate widgets/objects, handles menus and menu actions, and all other cross-cutting issues that don't reside within a specific view or controller.  It creates and knows about all top-level GUI objects, and manages them within an AMMainWindow.
 /// This is the bare bones version of the GUI framework because it has no acquisition code inside and therefore forms the basis of a take home Dataman program for users.  It contains the ability to scan through the database, create experiments, and view scans using the scan editor.
@@ -109,10 +112,11 @@ public slots:
 	/*!
 	  0) startupBeforeAnything(): Can be overloaded to add anything prior to startup
 	  1) startupLoadSettings(): Load AMSettings and AMUserSettings.
-	  2) startupLoadPlugins(): Load Plugins (using the plugin folder paths in AMSettings)
+	  2) startupLoadPlugins(): Start loading plugins in the background (using the plugin folder paths in AMSettings), while the databases are opened and upgraded
 	  3) startupIsFirstTime(): Check if this is the first time a user runs Acquaman (ie: no user database found)
 	  3.1) startupOnFirstTime(): If no database, prompt for basic new user information and create+open one
 	  3.2) startupOnEveryTime(): If there is a database, open it and check if substantial upgrades are required
+	  3.3) startupFinishLoadingPlugins(): Wait for the plugins started in step 2, if they are not loaded already
 	  4) startupRegisterDatabases(): Register the user database and database classes with the AMDbObject system
 	  5.1) startupPopulateNewDatabase(): If this is a new database, give a chance to initialize its contents (ex: storing the AMUser, creating facilities, etc.)
 	  5.2) startupLoadFromExistingDatabase(): If this is an existing database, give a chance to retrieve information from it into memory (ex: AMUser() object)
@@ -134,6 +138,7 @@ public slots:
 		virtual bool startupOnEveryTime(); ///< Run on every time except the first time
 		virtual bool startupCreateDatabases(); ///< Run every time to create the databases (reimplement to create additional databases). This is always called before startupDatabaseUpgrades().
 		bool startupDatabaseUpgrades(); ///< Run every time except the first time, to see if non-trivial database upgrades are necessary. This SHOULD NOT BE SUBCLASSED, if you want other upgrades completed, add them to the databaseUpgrades_.
+		bool startupFinishLoadingPlugins(); ///< Blocks until the plugins started by startupLoadPlugins() are available.  Nothing after this needs to worry about them still loading.
 	virtual bool startupRegisterDatabases();
 		virtual bool startupPopulateNewDatabase(); ///< Run on first time only
 		virtual bool startupLoadFromExistingDatabase(); ///< Run on every time except the first time
@@ -278,6 +283,9 @@ protected slots:
 	/// This is called by a signal (chosen with the resetFinishedSignal function) to run when the startup is actually finished. Can be reimplemented in subclasses, but you show call this function in it at some point.
 	virtual void onStartupFinished();
 
+	/// Shows the progress of the database upgrade that emitted AMDbUpgrade::progressChanged() on the splash screen.
+	void onDatabaseUpgradeProgress(int completedSteps, int totalSteps, const QString &description);
+
 protected:
 	/// Helper function to go through all the scan editors and see if we can close all of them.
 	bool canCloseScanEditors() const;
@@ -299,6 +307,9 @@ protected:
 */
 	void getUserDataFolderFromDialog(bool presentAsParentFolder = false);
 
+	/// Reports (at debug level) the time since the last startup phase finished, for the phase called \c phaseName, and restarts the phase timer.  Called by startup() after each phase.
+	void reportStartupPhaseTime(const QString &phaseName);
+
 	/// Method that allows the app controller and all subclasses to have their own specific bottom panel.  This method MUST ensure that the bottomPanel_ member is valid.
 	virtual void addBottomPanel();
 
@@ -348,6 +359,10 @@ protected:
 	bool isStarting_, isShuttingDown_;
 	/// This will be set to true if this is the first time a user has run Acquaman
 	bool isFirstTimeRun_;
+	/// Measure the whole startup(), and each phase within it.
+	QTime startupTime_, startupPhaseTime_;
+	/// The background plugin load started in startupLoadPlugins().
+	QFuture<void> pluginsLoading_;
 
 	/// Holds the list of database upgrades to do in order (holds these as QMetaObjects so they can be new'd at the correct time)
 	QList<AMDbUpgrade*> databaseUpgrades_;
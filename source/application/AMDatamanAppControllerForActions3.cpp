@@ -37,6 +37,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "actions3/actions/AMAxisStartedActionInfo.h"
 #include "actions3/actions/AMAxisFinishedActionInfo.h"
 #include "actions3/actions/AMTimedWaitActionInfo3.h"
+#include "actions3/actions/AMContinuousRegionActionInfo.h"
 
 #include "dataman/AMDbUpgrade1Pt1.h"
 #include "dataman/AMDbUpgrade1Pt2.h"
@@ -117,6 +118,7 @@ bool AMDatamanAppControllerForActions3::startupRegisterDatabases()
 	AMDbObjectSupport::s()->registerClass<AMAxisStartedActionInfo>();
 	AMDbObjectSupport::s()->registerClass<AMAxisFinishedActionInfo>();
 	AMDbObjectSupport::s()->registerClass<AMTimedWaitActionInfo3>();
+	AMDbObjectSupport::s()->registerClass<AMContinuousRegionActionInfo>();
 
 	return true;
 }
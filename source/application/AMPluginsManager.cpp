@@ -21,10 +21,11 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "AMPluginsManager.h"
 
 #include <QMutexLocker>
-#include <QReadLocker>
-#include <QWriteLocker>
+#include <QtConcurrentRun>
 #include <QDir>
 #include <QPluginLoader>
+#include <QCoreApplication>
+#include <QThread>
 
 #include "dataman/AMFileLoaderInterface.h"
 #include "dataman/AMAnalysisBlockInterface.h"
@@ -46,42 +47,77 @@ AMPluginsManager * AMPluginsManager::s()
 
 QMultiMap<QString, AMFileLoaderFactory *> AMPluginsManager::availableFileLoaderPlugins() const
 {
-	QReadLocker rl(&mutex_);
+	QMutexLocker ml(&mutex_);
+	waitForLoads();
 	return fileFormats2fileLoaderFactories_;
 }
 
 QList<AMAnalysisBlockInterface *> AMPluginsManager::availableAnalysisBlocks() const
 {
-	QReadLocker rl(&mutex_);
+	QMutexLocker ml(&mutex_);
+	waitForLoads();
 	return availableAnalysisBlocks_;
 }
 
+void AMPluginsManager::waitForLoads() const
+{
+	while(loadsInProgress_ > 0)
+		loadFinished_.wait(&mutex_);
+}
+
+void AMPluginsManager::registerFileLoaderPlugin(AMFileLoaderFactory *factory)
+{
+	QMutexLocker ml(&mutex_);
+	waitForLoads();
+
+	foreach(QString fileFormat, factory->acceptedFileFormats())
+		fileFormats2fileLoaderFactories_.insert(fileFormat, factory);
+}
+
 #include "util/AMErrorMonitor.h"
 
 void AMPluginsManager::loadApplicationPlugins(){
 	loadApplicationPlugins(AMSettings::s()->fileLoaderPluginsFolder(), AMSettings::s()->analysisBlockPluginsFolder());
 }
 
-#include <QDebug>
 void AMPluginsManager::loadApplicationPlugins(const QString &fileLoaderFolder, const QString &analysisBlocksFolder) {
-	Q_UNUSED(analysisBlocksFolder) //Darren removed these a while ago
 
-	QWriteLocker wl(&mutex_);
+	mutex_.lock();
+	loadsInProgress_++;
+	mutex_.unlock();
 
+	loadPluginsAndFinish(fileLoaderFolder, analysisBlocksFolder);
+}
+
+QFuture<void> AMPluginsManager::loadApplicationPluginsInBackground(const QString &fileLoaderFolder, const QString &analysisBlocksFolder)
+{
+	// Count the load now, rather than when the worker gets to it, so that nobody reads the registry in between.
+	mutex_.lock();
+	loadsInProgress_++;
+	mutex_.unlock();
+
+	return QtConcurrent::run(this, &AMPluginsManager::loadPluginsAndFinish, fileLoaderFolder, analysisBlocksFolder);
+}
 
-	// Load file loader plugins
-	fileFormats2fileLoaderFactories_.clear();
+void AMPluginsManager::loadPluginsAndFinish(const QString &fileLoaderFolder, const QString &analysisBlocksFolder) {
+	Q_UNUSED(analysisBlocksFolder) //Darren removed these a while ago
 
+	// Load file loader plugins.  The registry is only replaced at the end; readers wait for it until then.
+	QMultiMap<QString, AMFileLoaderFactory*> fileFormats2fileLoaderFactories;
 
 	QDir fileLoaderPluginsDirectory(fileLoaderFolder);
 	foreach (QString fileName, fileLoaderPluginsDirectory.entryList(QDir::Files)) {
 		QPluginLoader pluginLoader(fileLoaderPluginsDirectory.absoluteFilePath(fileName));
 		QObject *plugin = pluginLoader.instance();
 		if(plugin) {
+			// When loading in the background during startup, hand the plugin's root object over to the main thread where it will be used.
+			if(QCoreApplication::instance() && plugin->thread() != QCoreApplication::instance()->thread())
+				plugin->moveToThread(QCoreApplication::instance()->thread());
+
 			AMFileLoaderFactory *factory = qobject_cast<AMFileLoaderFactory *>(plugin);
 			if(factory) {
 				foreach(QString fileFormat, factory->acceptedFileFormats()) {
-					fileFormats2fileLoaderFactories_.insert(fileFormat, factory);
+					fileFormats2fileLoaderFactories.insert(fileFormat, factory);
 				}
 			}
 		}
@@ -94,7 +130,7 @@ void AMPluginsManager::loadApplicationPlugins(const QString &fileLoaderFolder, c
 	}
 
 	// Load analysis block plugins
-	availableAnalysisBlocks_.clear();
+	QList<AMAnalysisBlockInterface*> availableAnalysisBlocks;
 
 	/* Not Building these at the current time
 	QDir analysisBlockPluginsDirectory(analysisBlocksFolder);
@@ -104,9 +140,15 @@ void AMPluginsManager::loadApplicationPlugins(const QString &fileLoaderFolder, c
 		if (plugin) {
 			AMAnalysisBlockInterface *analysisBlock = qobject_cast<AMAnalysisBlockInterface *>(plugin);
 			if (analysisBlock){
-				availableAnalysisBlocks_.append(analysisBlock);
+				availableAnalysisBlocks.append(analysisBlock);
 			}
 		}
 	}
 	*/
+
+	QMutexLocker ml(&mutex_);
+	fileFormats2fileLoaderFactories_ = fileFormats2fileLoaderFactories;
+	availableAnalysisBlocks_ = availableAnalysisBlocks;
+	loadsInProgress_--;
+	loadFinished_.wakeAll();
 }
@@ -24,34 +24,47 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QString>
 #include <QMultiMap>
 #include <QList>
-#include <QReadWriteLock>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QFuture>
 
 class AMFileLoaderFactory;
 class AMAnalysisBlockInterface;
 
 /// This class manages the loading of dynamic plugins (file loaders and analysis blocks) for Acquaman applications. You can cause plugins to be reloaded by calling AMPluginsManager::s()->loadApplicationPlugins(), and access the registry of current plugins with availableFileLoaders() and availableAnalysisBlocks().  This class is thread-safe.
+/*! While plugins are being loaded (including in the background, see loadApplicationPluginsInBackground()), the registry accessors wait until the load has finished, so they never return a partial or stale registry. */
 class AMPluginsManager {
 public:
 
 	/// AMPluginsManager is a singleton class. Access the only instance of it using AMPluginsManager::s().
 	static AMPluginsManager* s();
 
-	/// This returns a registry of the available AMFileLoaderFactory, indexed by the file formats they can handle.
+	/// This returns a registry of the available AMFileLoaderFactory, indexed by the file formats they can handle.  Waits for any plugin load in progress to finish.
 	QMultiMap<QString, AMFileLoaderFactory*> availableFileLoaderPlugins() const;
 
-	/// This returns a list of the available analysis block plugins (Warning: these are currently unused)
+	/// This returns a list of the available analysis block plugins (Warning: these are currently unused).  Waits for any plugin load in progress to finish.
 	QList<AMAnalysisBlockInterface*> availableAnalysisBlocks() const;
 
+	/// Adds \c factory to the registry for each of its acceptedFileFormats().  This is for file loaders built into the program rather than loaded from a plugin (ex: in the unit tests).  They are dropped the next time the plugins are loaded.
+	void registerFileLoaderPlugin(AMFileLoaderFactory *factory);
+
 	/// Calling this will clear the existing plugins and reload all that we find on the disk, in AMSettings::fileLoaderPluginsFolder() and AMSettings::analysisBlockPluginsFolder().
 	void loadApplicationPlugins();
 
 	/// Calling this will clear the existing plugins and reload all that we find on the disk, in fileLoaderFolder and analysisBlockFolder.
 	void loadApplicationPlugins(const QString &fileLoaderFolder, const QString &analysisBlocksFolder);
+	/// Starts the same load as loadApplicationPlugins() on a worker thread, and returns right away.  AMDatamanAppController does this at startup.
+	/*! The load is registered before this returns, so the registry accessors called from now on wait until it is finished, even if the worker thread hasn't started yet.  The plugin instances are moved to the main thread once they are loaded. */
+	QFuture<void> loadApplicationPluginsInBackground(const QString &fileLoaderFolder, const QString &analysisBlocksFolder);
 
 protected:
 	/// This is a singleton class, so the constructor is protected.
-	AMPluginsManager() : mutex_(QReadWriteLock::Recursive) {}
+	AMPluginsManager() : loadsInProgress_(0) {}
+
+	/// Loads the plugins from disk and replaces the registry with them.  The load must already have been counted in loadsInProgress_; this marks it as finished.
+	void loadPluginsAndFinish(const QString &fileLoaderFolder, const QString &analysisBlocksFolder);
+	/// Waits until no load is in progress.  Must be called with mutex_ locked.
+	void waitForLoads() const;
 
 	/// registry of available file formats, indexed by file format
 	QMultiMap<QString, AMFileLoaderFactory*> fileFormats2fileLoaderFactories_;
@@ -59,7 +72,11 @@ protected:
 	QList<AMAnalysisBlockInterface*> availableAnalysisBlocks_;
 
 	// thread safety:
-	mutable QReadWriteLock mutex_;
+	mutable QMutex mutex_;
+	/// Woken each time a load finishes.
+	mutable QWaitCondition loadFinished_;
+	/// The number of loads started but not finished yet.
+	int loadsInProgress_;
 
 	// singleton instance
 	static AMPluginsManager* instance_;
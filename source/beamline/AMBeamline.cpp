@@ -30,6 +30,15 @@ AMBeamline::AMBeamline(const QString& controlName)
 {
 	exposedControls_ = new AMControlSet(this);
 	exposedDetectors_ = new AMDetectorSet(this);
+
+	connectedControlCount_ = 0;
+	allControlsConnectedOnce_ = false;
+	connectionTime_.start();
+
+	connect(&startWatchingCall_, SIGNAL(executed()), this, SLOT(startWatchingControlConnections()));
+	connect(&connectionProgressCall_, SIGNAL(executed()), this, SLOT(updateControlConnectionProgress()));
+	// The subclass constructor hasn't created any controls yet; wait until it's done.
+	startWatchingCall_.schedule();
 }
 
 AMBeamline::~AMBeamline()
@@ -78,3 +87,62 @@ bool AMBeamline::addExposedDetectorGroup(AMDetectorGroup *detectorGroup){
 	exposedDetectorGroups_.append(detectorGroup);
 	return true;
 }
+
+QStringList AMBeamline::unconnectedControlNames() const
+{
+	QStringList names;
+
+	foreach(AMControl *control, watchedControls_)
+		if(!control->isConnected())
+			names << control->name();
+
+	return names;
+}
+
+void AMBeamline::startWatchingControlConnections()
+{
+	foreach(AMControl *control, findChildren<AMControl *>()){
+
+		// Plain AMControls are only used to group other controls, and never report being connected themselves.
+		if(control->metaObject() == &AMControl::staticMetaObject || watchedControls_.contains(control))
+			continue;
+
+		watchedControls_ << control;
+		connect(control, SIGNAL(connected(bool)), &connectionProgressCall_, SLOT(schedule()));
+		connect(control, SIGNAL(destroyed(QObject*)), this, SLOT(onWatchedControlDestroyed(QObject*)));
+	}
+
+	connectedControlCount_ = -1;
+	updateControlConnectionProgress();
+}
+
+void AMBeamline::updateControlConnectionProgress()
+{
+	int connectedCount = 0;
+
+	foreach(AMControl *control, watchedControls_)
+		if(control->isConnected())
+			connectedCount++;
+
+	if(connectedCount == connectedControlCount_)
+		return;
+
+	connectedControlCount_ = connectedCount;
+	emit controlConnectionProgressChanged(connectedControlCount_, watchedControls_.count());
+
+	if(!allControlsConnectedOnce_ && !watchedControls_.isEmpty() && connectedControlCount_ == watchedControls_.count()){
+
+		allControlsConnectedOnce_ = true;
+		AMErrorMon::information(this, AMBEAMLINE_ALL_CONTROLS_CONNECTED, QString("All %1 beamline controls connected after %2 ms.").arg(watchedControls_.count()).arg(connectionTime_.elapsed()));
+	}
+}
+
+void AMBeamline::onWatchedControlDestroyed(QObject *control)
+{
+	// Only the QObject part is left at this point, so compare pointers without calling into the control.
+	for(int i = watchedControls_.count()-1; i >= 0; i--)
+		if(static_cast<QObject *>(watchedControls_.at(i)) == control)
+			watchedControls_.removeAt(i);
+
+	connectionProgressCall_.schedule();
+}
@@ -26,8 +26,12 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "beamline/AMSynchronizedDwellTime.h"
 #include "beamline/AMDetectorSet.h"
 #include "beamline/AMDetectorGroup.h"
+#include "util/AMDeferredFunctionCall.h"
+
+#include <QTime>
 
 #define AMBEAMLINE_BEAMLINE_NOT_CREATED_YET 280301
+#define AMBEAMLINE_ALL_CONTROLS_CONNECTED 280302
 
 /// One good way for components in the Acquaman framework to access and set a variety of beamline controls is through a centralized AMBeamline object.  This class provides the basic functionality expected of every beamline, and can be subclassed to include the specific controls available on a particular machine.  It uses the singleton design pattern to ensure that only a single instance of the beamline object exists; you can access this object through AMBeamline::bl().
 
@@ -47,6 +51,9 @@ static YOURBeamline* bl() {
 which sets AMBeamline's protected instance_ variable.
 
 As long as the FIRST call to use the beamline is through YOURBeamline::bl(), then all successive calls to AMBeamline::bl() will return the instance of your specific beamline.  If anything calls AMBeamline::bl() before this, there will be no instance_ yet, and it will return 0.  Therefore, it's necessary to call YOURBeamline::bl() to initialize the beamline object before any other code might access AMBeamline; we would normally place this intialization inside your specific version of AMAppController::startup().
+
+<b>Note on connecting</b>
+Constructing the beamline only creates the channels for its controls; the PVs connect in the background afterwards, so the application doesn't need to wait for them before showing the main window.  On the first pass through the event loop after construction, the beamline finds every control it owns and tracks their connection state.  controlConnectionProgressChanged() reports how many are connected (see AMBeamlineConnectionView), and an information message is reported with the elapsed time once they are all up.
 */
 
 class AMBeamline : public AMControl {
@@ -59,6 +66,8 @@ public:
 	static AMBeamline* bl();
 	/// Call this to delete the beamline object instance
 	static void releaseBl();
+	/// Returns true if a beamline has been created, without the alert that bl() raises when it hasn't.
+	static bool isCreated() { return instance_ != 0; }
 
 	virtual ~AMBeamline();
 
@@ -110,9 +119,26 @@ public:
 	/// Returns the beamline's synchronized dwell time object if one is available. Returns 0 (NULL) otherwise.
 	virtual AMSynchronizedDwellTime* synchronizedDwellTime() { return 0; }
 
+	/// Returns the number of controls owned by the beamline whose connections are being tracked. This is 0 until the first pass through the event loop after the beamline is constructed.
+	int controlCount() const { return watchedControls_.count(); }
+	/// Returns how many of the tracked controls are currently connected.
+	int connectedControlCount() const { return connectedControlCount_; }
+	/// Returns the names of the tracked controls that are not connected yet.
+	QStringList unconnectedControlNames() const;
+
 signals:
 	/// Emit this signal whenever isBeamlineScanning() changes.
 	void beamlineScanningChanged(bool isScanning);
+	/// Emitted (at most once per pass through the event loop) when the number of connected controls changes.
+	void controlConnectionProgressChanged(int connectedCount, int totalCount);
+
+protected slots:
+	/// Finds all of the controls owned by the beamline and starts tracking their connection state.
+	void startWatchingControlConnections();
+	/// Recounts the connected controls and emits controlConnectionProgressChanged() if the count changed.
+	void updateControlConnectionProgress();
+	/// Stops tracking a control that was deleted before the beamline.
+	void onWatchedControlDestroyed(QObject *control);
 
 protected:
 	/// Singleton classes have a protected constructor; all access is through AMBeamline::bl() or YourBeamline::bl()
@@ -127,6 +153,19 @@ protected:
 	AMDetectorSet *exposedDetectors_;
 
 	QList<AMDetectorGroup*> exposedDetectorGroups_;
+
+	/// The controls owned by the beamline whose connection state is tracked for controlConnectionProgressChanged().
+	QList<AMControl*> watchedControls_;
+	/// The number of watchedControls_ that were connected at the last count.
+	int connectedControlCount_;
+	/// Runs startWatchingControlConnections() once the subclass constructor has created all of its controls.
+	AMDeferredFunctionCall startWatchingCall_;
+	/// Coalesces the connection changes from a burst of PVs coming up into one recount.
+	AMDeferredFunctionCall connectionProgressCall_;
+	/// Started when the beamline is constructed; used to report how long it took for every control to connect.
+	QTime connectionTime_;
+	/// Whether every control has been connected at least once, so that the information message is only reported once.
+	bool allControlsConnectedOnce_;
 };
 
 #endif /*BEAMLINE_H_*/
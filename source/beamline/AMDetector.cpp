@@ -111,6 +111,15 @@ bool AMDetector::reading1D(const AMnDIndex &startIndex, const AMnDIndex &endInde
 	if(!checkValid(startIndex, endIndex))
 		return false;
 
+	for(int i = startIndex.i(); i <= endIndex.i(); i++){
+
+		AMNumber retVal = reading(AMnDIndex(i));
+		if(!retVal.isValid())
+			return false;
+
+		*(outputValues++) = double(retVal);
+	}
+
 	return true;
 }
 
@@ -118,6 +127,17 @@ bool AMDetector::reading2D(const AMnDIndex &startIndex, const AMnDIndex &endInde
 	if(!checkValid(startIndex, endIndex))
 		return false;
 
+	for(int i = startIndex.i(); i <= endIndex.i(); i++){
+		for(int j = startIndex.j(); j <= endIndex.j(); j++){
+
+			AMNumber retVal = reading(AMnDIndex(i, j));
+			if(!retVal.isValid())
+				return false;
+
+			*(outputValues++) = double(retVal);
+		}
+	}
+
 	return true;
 }
 
@@ -344,6 +364,41 @@ bool AMDetector::checkValid(const AMnDIndex &startIndex, const AMnDIndex &endInd
 	return true;
 }
 
+bool AMDetector::readingFromData(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const{
+	if(!checkValid(startIndex, endIndex))
+		return false;
+
+	const double *detectorData = data();
+	if(!detectorData)
+		return false;
+
+	switch(rank()){
+
+	case 1:
+		memcpy(outputValues, detectorData+startIndex.i(), (endIndex.i()-startIndex.i()+1)*sizeof(double));
+		return true;
+
+	case 2: {
+		int rowSize = size(1);
+		int rowCount = endIndex.i()-startIndex.i()+1;
+		int columnCount = endIndex.j()-startIndex.j()+1;
+
+		// Whole rows are contiguous in data(), so they can be copied in one go.
+		if(columnCount == rowSize)
+			memcpy(outputValues, detectorData+startIndex.i()*rowSize, rowCount*rowSize*sizeof(double));
+
+		else
+			for(int i = 0; i < rowCount; i++)
+				memcpy(outputValues+i*columnCount, detectorData+(startIndex.i()+i)*rowSize+startIndex.j(), columnCount*sizeof(double));
+
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
 void AMDetector::setAcquisitionState(AcqusitionState newState){
 	//if(!acceptableChangeAcquisitionState(newState))
 	//	return;
@@ -49,7 +49,7 @@ class AMDetectorDwellTimeSource;
   \b MAY Reimplement:
   - rank(), size(), axes() There are default implementations, but these are only valid for 0D detectors
 
-  - reading0D, reading1D, reading2D There are default implementations, but they are inefficient because they will call reading() repeatedly
+  - reading0D, reading1D, reading2D There are default implementations, but they are inefficient because they will call reading() repeatedly.  If data() always holds the latest reading, you can re-implement reading1D() and reading2D() by calling readingFromData().
   - lastContinuousReadingImplementation(double*) May be implemented to return the continuous reading. Default implementation returns false. Also, lastContinuousReading() automatically checks canContinuousAcquire() and returns false if the detector doesn't support it.
   - clearImplementation() May be implemented to internally clear the current data if possible. Default implementation returns false. Also, clear() automatically checks canClear() and returns false if the detector doesn't support it.
 
@@ -396,6 +396,8 @@ protected:
 
 	/// Helper function for checking rank and bounds on readingXD functions
 	bool checkValid(const AMnDIndex &startIndex, const AMnDIndex &endIndex) const;
+	/// Helper function for implementing reading1D() and reading2D() in detectors whose data() holds the latest reading: copies the block from \c startIndex to \c endIndex straight out of data(), one row at a time (or all at once when whole rows are requested).  Returns false if the indexes are invalid, the rank is not 1 or 2, or data() is null.
+	bool readingFromData(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const;
 
 	/// Changes the automatic behavior for calls to initialize()
 	void setAutoSetInitializing(bool autoSetInitializing) { autoSetInitializing_ = autoSetInitializing; }
@@ -4,12 +4,17 @@ AMDetectorTriggerSource::AMDetectorTriggerSource(const QString &name, QObject *p
 	QObject(parent)
 {
 	name_ = name;
+	continuousPointCount_ = -1;
 }
 
 void AMDetectorTriggerSource::trigger(AMDetectorDefinitions::ReadMode readMode){
 	emit triggered(readMode);
 }
 
+void AMDetectorTriggerSource::setContinuousPointCount(int pointCount){
+	continuousPointCount_ = pointCount;
+}
+
 void AMDetectorTriggerSource::setSucceeded(){
 	emit succeeded();
 }
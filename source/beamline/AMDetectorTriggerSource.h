@@ -13,10 +13,14 @@ public:
 
 	/// Returns the programmer name
 	QString name() const { return name_; }
+	/// Returns the number of points the next ContinuousRead trigger should buffer, or -1 if the caller didn't say.  Sources that can size their buffer should read this when they are triggered.
+	int continuousPointCount() const { return continuousPointCount_; }
 
 public slots:
 	/// Call this slot to trigger the source (cause detectors connected to it to acquire)
 	void trigger(AMDetectorDefinitions::ReadMode readMode);
+	/// Sets the number of points the next ContinuousRead trigger should buffer.  Use -1 to leave it up to the source.
+	void setContinuousPointCount(int pointCount);
 
 	void setSucceeded();
 	void setFailed();
@@ -31,6 +35,8 @@ signals:
 protected:
 	/// Holds the programmer name
 	QString name_;
+	/// Holds the number of points for the next ContinuousRead trigger
+	int continuousPointCount_;
 };
 
 class AMDetectorDwellTimeSource : public QObject
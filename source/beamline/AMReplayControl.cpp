@@ -0,0 +1,87 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMReplayControl.h"
+
+AMReplayControl::AMReplayControl(const QString &name, const QString &units, double initialValue, double moveTime, QObject *parent) :
+	AMControl(name, units, parent)
+{
+	value_ = initialValue;
+	setpoint_ = initialValue;
+	moveTime_ = qMax(0.0, moveTime);
+	timeScale_ = 1.0;
+	completedMoveCount_ = 0;
+
+	moveTimer_.setSingleShot(true);
+	connect(&moveTimer_, SIGNAL(timeout()), this, SLOT(onMoveTimerTimeout()));
+}
+
+AMControl::FailureExplanation AMReplayControl::move(double setpoint)
+{
+	if(isMoving() && !allowsMovesWhileMoving())
+		return AlreadyMovingFailure;
+
+	bool wasMoving = isMoving();
+
+	setpoint_ = setpoint;
+	emit setpointChanged(setpoint_);
+
+	moveTimer_.start(timeScale_ > 0 ? int(moveTime_*1000/timeScale_) : 0);
+
+	if(wasMoving)
+		emit moveReTargetted();
+
+	else {
+
+		emit moveStarted();
+		emit movingChanged(true);
+	}
+
+	return NoFailure;
+}
+
+bool AMReplayControl::stop()
+{
+	if(!isMoving())
+		return true;
+
+	moveTimer_.stop();
+	emit movingChanged(false);
+	emit moveFailed(WasStoppedFailure);
+
+	return true;
+}
+
+void AMReplayControl::setReplayedValue(double value)
+{
+	if(value_ == value)
+		return;
+
+	value_ = value;
+	emit valueChanged(value_);
+}
+
+void AMReplayControl::onMoveTimerTimeout()
+{
+	setReplayedValue(setpoint_);
+	completedMoveCount_++;
+
+	emit movingChanged(false);
+	emit moveSucceeded();
+}
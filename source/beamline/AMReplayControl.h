@@ -0,0 +1,99 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMREPLAYCONTROL_H
+#define AMREPLAYCONTROL_H
+
+#include "beamline/AMControl.h"
+
+#include <QTimer>
+
+/// This AMControl stands in for a real beamline control when scans are replayed from recorded data (see AMScanReplayer).
+/*! It never talks to hardware.  move() always succeeds: the value reaches the setpoint after moveTime() seconds, divided by the time scale set with setTimeScale() (so a replay at 10x speed also moves the control 10x faster).  A time scale of 0 completes moves as soon as control returns to the event loop.
+
+While a recording is replayed, the control's feedback can also follow the recorded values through setReplayedValue(), so that anything watching valueChanged() sees the same sequence of values it saw on the beamline.
+*/
+class AMReplayControl : public AMControl
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.  \c initialValue is the starting value and setpoint; \c moveTime is the time (in seconds, at normal speed) that every move takes.
+	AMReplayControl(const QString &name, const QString &units = "", double initialValue = 0, double moveTime = 0, QObject *parent = 0);
+
+	/// The current (replayed) value.
+	virtual double value() const { return value_; }
+	/// The last setpoint requested with move().
+	virtual double setpoint() const { return setpoint_; }
+
+	/// Replay controls are always connected, and can always be measured, moved, and stopped.
+	virtual bool isConnected() const { return true; }
+	virtual bool canMeasure() const { return true; }
+	virtual bool shouldMeasure() const { return true; }
+	virtual bool canMove() const { return true; }
+	virtual bool shouldMove() const { return true; }
+	virtual bool canStop() const { return true; }
+	virtual bool shouldStop() const { return true; }
+
+	/// True while a move is in progress.
+	virtual bool isMoving() const { return moveTimer_.isActive(); }
+	/// True while a move started by move() is in progress.
+	virtual bool moveInProgress() const { return moveTimer_.isActive(); }
+
+	/// There are no limits on a replay control.
+	virtual double minimumValue() const { return -1e300; }
+	virtual double maximumValue() const { return 1e300; }
+
+	/// The time (in seconds, at normal speed) that every move takes.
+	double moveTime() const { return moveTime_; }
+	/// The factor that replay times are divided by: 1 for the recorded timing, 10 for ten times faster, 0 for no waiting at all.
+	double timeScale() const { return timeScale_; }
+
+	/// The number of moves that have completed.
+	int completedMoveCount() const { return completedMoveCount_; }
+
+public slots:
+	/// Starts a move to \c setpoint.  The value reaches the setpoint after moveTime(), scaled by the timeScale().
+	virtual FailureExplanation move(double setpoint);
+	/// Stops a move in progress, leaving the value where it was.
+	virtual bool stop();
+
+	/// Sets the time (in seconds, at normal speed) that every move takes.
+	void setMoveTime(double seconds) { moveTime_ = qMax(0.0, seconds); }
+	/// Sets the factor that replay times are divided by.
+	void setTimeScale(double timeScale) { timeScale_ = qMax(0.0, timeScale); }
+
+	/// Changes the value as if the feedback had changed on the beamline.  Used by AMScanReplayer to play recorded control values.
+	void setReplayedValue(double value);
+
+protected slots:
+	/// Completes the move in progress.
+	void onMoveTimerTimeout();
+
+protected:
+	double value_;
+	double setpoint_;
+	double moveTime_;
+	double timeScale_;
+	int completedMoveCount_;
+	/// Runs for the duration of each move.
+	QTimer moveTimer_;
+};
+
+#endif // AMREPLAYCONTROL_H
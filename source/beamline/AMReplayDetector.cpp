@@ -0,0 +1,152 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMReplayDetector.h"
+
+#include "actions3/actions/AMDetectorTriggerAction.h"
+#include "actions3/actions/AMDetectorReadAction.h"
+
+AMReplayDetector::AMReplayDetector(const QString &name, const QString &description, const QList<AMAxisInfo> &axes, double acquisitionTime, QObject *parent) :
+	AMDetector(name, description, parent)
+{
+	axes_ = axes;
+	acquisitionTime_ = qMax(0.0, acquisitionTime);
+	timeScale_ = 1.0;
+	acquiredReadingCount_ = 0;
+	data_ = QVector<double>(int(size().product()), 0);
+
+	acquisitionTimer_.setSingleShot(true);
+	connect(&acquisitionTimer_, SIGNAL(timeout()), this, SLOT(onAcquisitionTimerTimeout()));
+
+	setConnected(true);
+	setReadyForAcquisition();
+}
+
+AMnDIndex AMReplayDetector::size() const
+{
+	int rank = axes_.count();
+	AMnDIndex rv = rank > 0 ? AMnDIndex(rank, AMnDIndex::DoNotInit) : AMnDIndex();
+	for(int mu = 0; mu < rank; mu++)
+		rv[mu] = axes_.at(mu).size;
+
+	return rv;
+}
+
+AMNumber AMReplayDetector::reading(const AMnDIndex &indexes) const
+{
+	if(acquiredReadingCount_ == 0)
+		return AMNumber(AMNumber::Null);
+
+	if(indexes.rank() != rank())
+		return AMNumber(AMNumber::DimensionError);
+
+	long flatIndex = 0;
+	for(int mu = 0; mu < rank(); mu++){
+
+		if((unsigned long)indexes.at(mu) >= (unsigned long)axes_.at(mu).size)
+			return AMNumber(AMNumber::OutOfBoundsError);
+
+		flatIndex = flatIndex*axes_.at(mu).size + indexes.at(mu);
+	}
+
+	return data_.at(int(flatIndex));
+}
+
+AMAction3* AMReplayDetector::createTriggerAction(AMDetectorDefinitions::ReadMode readMode)
+{
+	return new AMDetectorTriggerAction(new AMDetectorTriggerActionInfo(toInfo(), readMode), this);
+}
+
+AMAction3* AMReplayDetector::createReadAction()
+{
+	return new AMDetectorReadAction(new AMDetectorReadActionInfo(toInfo()), this);
+}
+
+void AMReplayDetector::setReadings(const QList<QVector<double> > &readings)
+{
+	readings_ = readings;
+}
+
+void AMReplayDetector::appendReading(const QVector<double> &reading)
+{
+	readings_ << reading;
+}
+
+bool AMReplayDetector::setAcquisitionTime(double seconds)
+{
+	if(seconds < 0)
+		return false;
+
+	if(acquisitionTime_ != seconds){
+
+		acquisitionTime_ = seconds;
+		emit acquisitionTimeChanged(acquisitionTime_);
+	}
+
+	return true;
+}
+
+void AMReplayDetector::onAcquisitionTimerTimeout()
+{
+	if(readings_.isEmpty() || readings_.first().count() != data_.count()){
+
+		setAcquisitionFailed();
+		setReadyForAcquisition();
+		return;
+	}
+
+	data_ = readings_.takeFirst();
+	acquiredReadingCount_++;
+	emit newValuesAvailable();
+
+	setAcquisitionSucceeded();
+	setReadyForAcquisition();
+}
+
+bool AMReplayDetector::initializeImplementation()
+{
+	setInitialized();
+	return true;
+}
+
+bool AMReplayDetector::acquireImplementation(AMDetectorDefinitions::ReadMode readMode)
+{
+	if(readMode != AMDetectorDefinitions::SingleRead)
+		return false;
+
+	setAcquiring();
+	acquisitionTimer_.start(timeScale_ > 0 ? int(acquisitionTime_*1000/timeScale_) : 0);
+
+	return true;
+}
+
+bool AMReplayDetector::cancelAcquisitionImplementation()
+{
+	acquisitionTimer_.stop();
+	setAcquisitionCancelled();
+	setReadyForAcquisition();
+
+	return true;
+}
+
+bool AMReplayDetector::cleanupImplementation()
+{
+	setCleanedUp();
+	return true;
+}
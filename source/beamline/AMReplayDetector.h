@@ -0,0 +1,121 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMREPLAYDETECTOR_H
+#define AMREPLAYDETECTOR_H
+
+#include "beamline/AMDetector.h"
+
+#include <QTimer>
+
+/// This AMDetector stands in for a real detector when scans are replayed from recorded data (see AMScanReplayer).
+/*! It never talks to hardware.  Instead, it holds a queue of recorded readings (scaler counts, MCA spectra, CCD frames: anything whose shape is described by axes()).  Every acquire() waits for the acquisitionTime(), divided by the time scale set with setTimeScale(), and then makes the next recorded reading available in data() and succeeds.  Once the queue is empty, acquisitions fail.
+
+This lets the trigger and read actions in a scan controller's action tree run against recorded data, at the original speed or faster, without a beamline.  The trigger and read actions are created with this detector directly, since a replayed detector doesn't exist in any AMBeamline; the copies that loop actions make at every iteration keep it too.
+*/
+class AMReplayDetector : public AMDetector
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.  \c axes describes the shape of each reading (empty for a single-point detector like a scaler channel), and \c acquisitionTime is the dwell time in seconds (at normal speed).
+	AMReplayDetector(const QString &name, const QString &description, const QList<AMAxisInfo> &axes = QList<AMAxisInfo>(), double acquisitionTime = 0, QObject *parent = 0);
+
+	/// The shape of the readings.
+	virtual int rank() const { return axes_.count(); }
+	virtual AMnDIndex size() const;
+	virtual int size(int axisNumber) const { return axes_.at(axisNumber).size; }
+	virtual QList<AMAxisInfo> axes() const { return axes_; }
+
+	/// Replay detectors don't require power, can't be cleared, and only do single reads.
+	virtual bool requiresPower() const { return false; }
+	virtual bool canCancel() const { return true; }
+	virtual bool canClear() const { return false; }
+	virtual bool canContinuousAcquire() const { return false; }
+
+	/// The dwell time, in seconds at normal speed.
+	virtual double acquisitionTime() const { return acquisitionTime_; }
+
+	virtual bool supportsSynchronizedDwell() const { return false; }
+	virtual QString synchronizedDwellKey() const { return QString(); }
+
+	virtual AMDetectorDefinitions::ReadMethod readMethod() const { return AMDetectorDefinitions::RequestRead; }
+	virtual AMDetectorDefinitions::ReadMode readMode() const { return AMDetectorDefinitions::SingleRead; }
+
+	/// Returns the value at \c indexes in the last reading.  Returns an invalid AMNumber if no reading has been made yet, or the indexes don't fit.
+	virtual AMNumber reading(const AMnDIndex &indexes) const;
+	/// Returns the last reading of a single-point detector.
+	virtual AMNumber singleReading() const { return rank() == 0 ? reading(AMnDIndex()) : AMNumber(AMNumber::DimensionError); }
+	/// data() always holds the last reading, so blocks are copied straight out of it.
+	virtual bool reading1D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const { return readingFromData(startIndex, endIndex, outputValues); }
+	virtual bool reading2D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const { return readingFromData(startIndex, endIndex, outputValues); }
+	/// The last reading.
+	virtual const double* data() const { return data_.constData(); }
+
+	virtual AMDataSource* dataSource() const { return 0; }
+
+	/// Creates trigger and read actions that use this detector directly, instead of looking it up in the beamline.
+	virtual AMAction3* createTriggerAction(AMDetectorDefinitions::ReadMode readMode = AMDetectorDefinitions::SingleRead);
+	virtual AMAction3* createReadAction();
+
+	/// Replaces the queue of recorded readings.  Each reading must have size().product() values.
+	void setReadings(const QList<QVector<double> > &readings);
+	/// Adds a reading to the end of the queue.
+	void appendReading(const QVector<double> &reading);
+	/// The number of readings still waiting in the queue.
+	int remainingReadingCount() const { return readings_.count(); }
+	/// The number of readings that have been acquired so far.
+	int acquiredReadingCount() const { return acquiredReadingCount_; }
+
+	/// The factor that replay times are divided by: 1 for the recorded timing, 10 for ten times faster, 0 for no waiting at all.
+	double timeScale() const { return timeScale_; }
+
+public slots:
+	/// Only SingleRead is supported.
+	virtual bool setReadMode(AMDetectorDefinitions::ReadMode readMode) { return readMode == AMDetectorDefinitions::SingleRead; }
+	/// Sets the dwell time, in seconds at normal speed.
+	virtual bool setAcquisitionTime(double seconds);
+	/// Sets the factor that replay times are divided by.
+	void setTimeScale(double timeScale) { timeScale_ = qMax(0.0, timeScale); }
+
+protected slots:
+	/// Completes the acquisition in progress with the next recorded reading.
+	void onAcquisitionTimerTimeout();
+
+protected:
+	virtual bool initializeImplementation();
+	virtual bool acquireImplementation(AMDetectorDefinitions::ReadMode readMode);
+	virtual bool cancelAcquisitionImplementation();
+	virtual bool cleanupImplementation();
+
+	QList<AMAxisInfo> axes_;
+	double acquisitionTime_;
+	double timeScale_;
+
+	/// The recorded readings that haven't been acquired yet.
+	QList<QVector<double> > readings_;
+	int acquiredReadingCount_;
+	/// The last reading (or zeros, before the first one).
+	QVector<double> data_;
+
+	/// Runs for the duration of each acquisition.
+	QTimer acquisitionTimer_;
+};
+
+#endif // AMREPLAYDETECTOR_H
@@ -96,6 +96,13 @@ AMNumber CLSAmptekSDD123DetectorNew::reading(const AMnDIndex &indexes) const{
 	return tmpControl->readPV()->lastIntegerValues().at(indexes.i());
 }
 
+bool CLSAmptekSDD123DetectorNew::reading1D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const{
+	if(!isConnected())
+		return false;
+
+	return readingFromData(startIndex, endIndex, outputValues);
+}
+
 AMNumber CLSAmptekSDD123DetectorNew::singleReading() const{
 	if(!isConnected())
 		return AMNumber(AMNumber::Null);
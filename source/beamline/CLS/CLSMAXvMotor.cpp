@@ -22,6 +22,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "actions/AMBeamlineControlMoveAction.h"
 #include "actions/AMBeamlineControlStopAction.h"
+#include "actions3/actions/AMControlMoveAction3.h"
 
 CLSMAXvMotor::CLSMAXvMotor(const QString &name, const QString &baseName, const QString &description, bool hasEncoder, double tolerance, double moveStartTimeoutSeconds, QObject *parent) :
 	AMPVwStatusControl(name, hasEncoder ? baseName+":mm:fbk" : baseName+":mm:sp", baseName+":mm", baseName+":status", baseName+":stop", parent, tolerance, moveStartTimeoutSeconds, new AMControlStatusCheckerCLSMAXv(), 1, description)
@@ -473,6 +474,17 @@ AMBeamlineActionItem* CLSMAXvMotor::createEGUVelocityAction(double EGUVelocity){
 	return action;
 }
 
+AMAction3* CLSMAXvMotor::createEGUVelocityAction3(double EGUVelocity){
+	if(!isConnected())
+		return 0; //NULL
+
+	AMControlInfo setpoint = EGUVelocity_->toInfo();
+	setpoint.setValue(EGUVelocity);
+	AMControlMoveActionInfo3 *actionInfo = new AMControlMoveActionInfo3(setpoint);
+
+	return new AMControlMoveAction3(actionInfo, EGUVelocity_);
+}
+
 AMBeamlineActionItem* CLSMAXvMotor::createEGUBaseVelocityAction(double EGUBaseVelocity){
 	if(!isConnected())
 		return 0;
@@ -24,6 +24,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "beamline/AMPVControl.h"
 #include "actions/AMBeamlineActionItem.h"
 
+class AMAction3;
+
 /// This function object provides the moving check for the CLSMAXvMotors
 class AMControlStatusCheckerCLSMAXv : public AMAbstractControlStatusChecker {
 public:
@@ -174,6 +176,8 @@ public:
 	AMBeamlineActionItem* createEGUMoveAction(double EGUPosition);
 	/// Returns a newly created action to change the EGU velocity. Returns 0 if the control is not connected.
 	AMBeamlineActionItem* createEGUVelocityAction(double EGUVelocity);
+	/// Returns a newly created actions3 action to change the EGU velocity. Returns 0 if the control is not connected.
+	AMAction3* createEGUVelocityAction3(double EGUVelocity);
 	/// Returns a newly created action to change the EGU base velocity. Returns 0 if the control is not connected.
 	AMBeamlineActionItem* createEGUBaseVelocityAction(double EGUBaseVelocity);
 	/// Returns a newly created action to change the EGU acceleration. Returns 0 if the control is not connected.
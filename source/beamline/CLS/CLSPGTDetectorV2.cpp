@@ -105,6 +105,13 @@ AMNumber CLSPGTDetectorV2::reading(const AMnDIndex &indexes) const{
 	return tmpControl->readPV()->lastIntegerValues().at(indexes.i());
 }
 
+bool CLSPGTDetectorV2::reading1D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const{
+	if(!isConnected())
+		return false;
+
+	return readingFromData(startIndex, endIndex, outputValues);
+}
+
 AMNumber CLSPGTDetectorV2::singleReading() const{
 	if(!isConnected())
 		return AMNumber(AMNumber::Null);
@@ -56,6 +56,8 @@ public:
 
 	/// Returns the dependent value at a (complete) set of axis indexes. Returns an invalid AMNumber if the indexes are insuffient or (if AM_ENABLE_BOUNDS_CHECKING is defined, any are out of range), or if the data is not ready.
 	virtual AMNumber reading(const AMnDIndex& indexes) const;
+	/// Copies a block of the spectrum straight out of data(), instead of calling reading() for every bin.
+	virtual bool reading1D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const;
 
 	/// Returns the total count (sum of all bins) as the single reading
 	virtual AMNumber singleReading() const;
@@ -97,6 +97,13 @@ AMNumber CLSQE65000Detector::reading(const AMnDIndex &indexes) const{
 	return tmpControl->readPV()->lastIntegerValues().at(indexes.i());
 }
 
+bool CLSQE65000Detector::reading1D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const{
+	if(!isConnected())
+		return false;
+
+	return readingFromData(startIndex, endIndex, outputValues);
+}
+
 AMNumber CLSQE65000Detector::singleReading() const{
 	if(!isConnected())
 		return AMNumber(AMNumber::Null);
@@ -92,6 +92,9 @@ public:
 	/// Provides a very simple editor widget for inside AMDataSourcesEditor, which only lists the rank and size of the analysis block (and the value, for 0D analysis blocks only). Re-implement to provide custom editors.
 	virtual QWidget* createEditorWidget();
 
+	/// Returns a new block of the same type, with no inputs, for plots to calculate away from the GUI thread (see AMThreadedAnalysisBlock::createForCopyOf()).  The default returns 0, which means this block is cheap enough to calculate on the GUI thread.  Blocks that re-implement this should keep all of their settings in stored, writable Q_PROPERTYs, so that they can be copied.
+	virtual AMAnalysisBlock* createThreadedCopy() const { return 0; }
+
 protected:
 	/// Implementing subclasses must provide a setInputDataSourcesImplementation(), which is called from setInputDataSources(). This will only be called if \c dataSources are acceptable and sufficient  (according to areInputDataSourcesAcceptable()), or if \c dataSources is empty, indicating the block is in the inactive/invalid state.
 	virtual void setInputDataSourcesImplementation(const QList<AMDataSource*>& dataSources) = 0;
@@ -1,5 +1,7 @@
 #include "AMDbUpgrade1Pt1.h"
 
+#include "dataman/database/AMDbMigration.h"
+
 AMDbUpgrade1Pt1::AMDbUpgrade1Pt1(QString databaseNameToUpgrade, QObject *parent) :
 	AMDbUpgrade(databaseNameToUpgrade, parent)
 {
@@ -50,10 +52,11 @@ bool AMDbUpgrade1Pt1::upgradeImplementation(){
 	QMap<QString, int> indexTablesToIndexSide;
 	indexTablesToIndexSide.insert("AMDetectorInfoSet_table_detectorInfos", 2);
 
-	// Use dbObjectClassBecomes to upgrade each detectorInfo to its new counterpart
-	success &= AMDbUpgradeSupport::dbObjectClassBecomes(databaseToUpgrade_, "AMDetectorInfo", "AMOldDetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
+	// Rename the class to its new counterpart, in one transaction
+	AMDbMigration migration(databaseToUpgrade_);
+	success &= AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(&migration, "AMDetectorInfo", "AMOldDetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
 
-	return success;
+	return success && runMigration(&migration);
 }
 
 AMDbUpgrade* AMDbUpgrade1Pt1::createCopy() const{
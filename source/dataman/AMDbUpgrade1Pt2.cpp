@@ -1,5 +1,7 @@
 #include "AMDbUpgrade1Pt2.h"
 
+#include "dataman/database/AMDbMigration.h"
+
 AMDbUpgrade1Pt2::AMDbUpgrade1Pt2(QString databaseNameToUpgrade, QObject *parent) :
 	AMDbUpgrade(databaseNameToUpgrade, parent)
 {
@@ -49,10 +51,11 @@ bool AMDbUpgrade1Pt2::upgradeImplementation(){
 	QMap<QString, int> indexTablesToIndexSide;
 	indexTablesToIndexSide.insert("AMDetectorInfoSet_table_detectorInfos", 1);
 
-	// Use dbObjectClassBecomes to upgrade each detectorInfo to its new counterpart
-	success &= AMDbUpgradeSupport::dbObjectClassBecomes(databaseToUpgrade_, "AMDetectorInfoSet", "AMOldDetectorInfoSet", parentTablesToColumnsNames, indexTablesToIndexSide);
+	// Rename the class to its new counterpart, in one transaction
+	AMDbMigration migration(databaseToUpgrade_);
+	success &= AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(&migration, "AMDetectorInfoSet", "AMOldDetectorInfoSet", parentTablesToColumnsNames, indexTablesToIndexSide);
 
-	return success;
+	return success && runMigration(&migration);
 }
 
 AMDbUpgrade* AMDbUpgrade1Pt2::createCopy() const{
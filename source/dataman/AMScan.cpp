@@ -472,12 +472,8 @@ bool AMScan::addAnalyzedDataSource(AMAnalysisBlock *newAnalyzedDataSource, bool
 #include <QFile>
 
 #include "util/AMDataSourcePlotSettings.h"
-#include "MPlot/MPlot.h"
-#include "MPlot/MPlotSeries.h"
-#include "MPlot/MPlotImage.h"
-#include "dataman/datasource/AMDataSourceSeriesData.h"
-#include "dataman/datasource/AMDataSourceImageData.h"
-#include "dataman/datasource/AMDataSourceImageDatawDefault.h"
+#include "dataman/datasource/AMDataSourceThumbnailRenderer.h"
+#include "dataman/datasource/AMDataSourceSnapshot.h"
 #include "util/AMDateTimeUtils.h"
 
 int AMScan::thumbnailCount() const{
@@ -491,19 +487,65 @@ int AMScan::thumbnailCount() const{
 		return nonHiddenRawDataSourceCount();
 }
 
-// Return a thumbnail picture for thumbnail number \c index. For now, we use the following decision: Normally we provide thumbnails for all the analyzed data sources.  If there are no analyzed data sources, we provide thumbnails for all the raw data sources.
-AMDbThumbnail AMScan::thumbnail(int index) const {
-	if(currentlyScanning()) {
+/// Returns the thumbnail shown while a scan started at \c dateTime is still running.
+static AMDbThumbnail amScanCurrentlyScanningThumbnail(const QDateTime &dateTime)
+{
+	QFile file(":/240x180/currentlyScanningThumbnail.png");
+	file.open(QIODevice::ReadOnly);
+	return AMDbThumbnail("Started",
+						 AMDateTimeUtils::prettyDateTime(dateTime),
+						 AMDbThumbnail::PNGType,
+						 file.readAll());
+}
 
-		AMErrorMon::debug(this, AMSCAN_THUMBNAIL_SCANNING_MESSAGE, "Thumbnail: AMScan know it's scanning");
-		QFile file(":/240x180/currentlyScanningThumbnail.png");
-		file.open(QIODevice::ReadOnly);
-		return AMDbThumbnail("Started",
-							 AMDateTimeUtils::prettyDateTime(dateTime()),
-							 AMDbThumbnail::PNGType,
-							 file.readAll());
+/// Returns the thumbnail for \c dataSource, drawn as thumbnail number \c index of a scan with rank \c scanRank.
+static AMDbThumbnail amScanDataSourceThumbnail(const AMDataSource *dataSource, int index, int scanRank)
+{
+	// Drawn straight into a QImage (no MPlot or QGraphicsScene), so this is safe to run in the thumbnail thread.  Scans of the same rank as the data source leave unacquired points at the default value of -1.
+	QImage image = AMDataSourceThumbnailRenderer::render(dataSource,
+														 QSize(240, 180),
+														 AMDataSourcePlotSettings::colorAt(index),
+														 dataSource->rank() > 1 && scanRank == dataSource->rank(),
+														 -1);
+
+	return AMDbThumbnail(dataSource->description(), dataSource->name(), image);
+}
+
+/// This class makes AMScan thumbnails in a separate thread, from snapshots of the data sources taken in the scan's thread.
+class AMScanThumbnailGenerator : public AMDbThumbnailGenerator
+{
+public:
+	/// Constructor. \c sources are the snapshots of the data sources to draw, one per thumbnail, unless \c currentlyScanning is true.
+	AMScanThumbnailGenerator(bool currentlyScanning, const QDateTime &dateTime, int scanRank, const QList<AMDataSourceSnapshotData> &sources)
+		: currentlyScanning_(currentlyScanning), dateTime_(dateTime), scanRank_(scanRank), sources_(sources) {}
+
+	virtual QList<AMDbThumbnail> generateThumbnails() {
+		QList<AMDbThumbnail> thumbnails;
+
+		if(currentlyScanning_) {
+			thumbnails << amScanCurrentlyScanningThumbnail(dateTime_);
+			return thumbnails;
+		}
+
+		for(int i = 0, count = sources_.count(); i < count; i++) {
+			AMDataSourceSnapshot source(sources_.at(i));
+			thumbnails << amScanDataSourceThumbnail(&source, i, scanRank_);
+		}
+
+		return thumbnails;
 	}
 
+protected:
+	bool currentlyScanning_;
+	QDateTime dateTime_;
+	int scanRank_;
+	QList<AMDataSourceSnapshotData> sources_;
+};
+
+const AMDataSource* AMScan::thumbnailDataSource(int index) const
+{
+	if(currentlyScanning())
+		return 0;
 
 	int analyzedCount = nonHiddenAnalyzedDataSourceCount();
 
@@ -514,98 +556,39 @@ AMDbThumbnail AMScan::thumbnail(int index) const {
 			(useRawSources && index >= nonHiddenRawDataSourceCount()) ||
 			(!useRawSources && index >= analyzedCount)
 			)
-		return AMDbThumbnail(QString(), QString(), AMDbThumbnail::InvalidType, QByteArray());
-
+		return 0;
 
-	QImage image(240, 180, QImage::Format_ARGB32_Premultiplied);
-	QPainter painter(&image);
-	painter.setRenderHint(QPainter::Antialiasing, true);
-	QGraphicsScene gscene(QRectF(0,0,240,180));
-	MPlot* plot = new MPlot(QRectF(0,0,240,180));
-	gscene.addItem(plot);
-
-	plot->setMarginLeft(0);
-	plot->setMarginRight(0);
-	plot->setMarginTop(0);
-	plot->setMarginBottom(10);
-	plot->axisRight()->setTicks(0);
-	plot->axisTop()->setTicks(0);
-	plot->axisBottom()->setTicks(2);
-	plot->axisLeft()->showGrid(false);
-	plot->axisBottom()->showGrid(false);
-	plot->axisBottom()->showAxisName(false);
-	plot->axisLeft()->showAxisName(false);
-	plot->legend()->enableDefaultLegend(false);	// don't show default legend names, because we want to provide these as text later; don't include them in the bitmap
-
-	const AMDataSource* dataSource;
 	if(useRawSources)
-		dataSource = rawDataSources()->at(nonHiddenRawDataSourceIndexes().at(index));
+		return rawDataSources()->at(nonHiddenRawDataSourceIndexes().at(index));
 	else
-		dataSource = analyzedDataSources()->at(nonHiddenAnalyzedDataSourceIndexes().at(index));
-
-	switch(dataSource->rank()) {
-	case 1: {
-		MPlotSeriesBasic* series = new MPlotSeriesBasic();
-		series->setModel(new AMDataSourceSeriesData(dataSource), true);
-		QPen seriesPen(QBrush(AMDataSourcePlotSettings::nextColor()), 0);
-		series->setLinePen(seriesPen);
-		series->setMarker(MPlotMarkerShape::None);
-		plot->addItem(series);
-		plot->doDelayedAutoScale();
-		break; }
-	case 2: {
-		if (scanRank() == 2){
-
-			MPlotImageBasicwDefault* image = new MPlotImageBasicwDefault();
-			image->setDefaultValue(-1);
-			image->setModel(new AMDataSourceImageDatawDefault(dataSource, -1), true);
-			plot->addItem(image);
-			plot->doDelayedAutoScale();
-		}
-
-		else{
-
-			MPlotImageBasic* image = new MPlotImageBasic();
-			image->setModel(new AMDataSourceImageData(dataSource), true);
-			plot->addItem(image);
-			plot->doDelayedAutoScale();
-		}
-
-		break; }
-
-	case 3: {
-
-		if (scanRank() == 3){
-
-			MPlotImageBasicwDefault* image = new MPlotImageBasicwDefault();
-			image->setDefaultValue(-1);
-			image->setModel(new AMDataSourceImageDatawDefault(dataSource, -1), true);
-			plot->addItem(image);
-			plot->doDelayedAutoScale();
-		}
-
-		else{
+		return analyzedDataSources()->at(nonHiddenAnalyzedDataSourceIndexes().at(index));
+}
 
-			MPlotImageBasic* image = new MPlotImageBasic();
-			image->setModel(new AMDataSourceImageData(dataSource), true);
-			plot->addItem(image);
-			plot->doDelayedAutoScale();
-		}
+// Return a thumbnail picture for thumbnail number \c index. For now, we use the following decision: Normally we provide thumbnails for all the analyzed data sources.  If there are no analyzed data sources, we provide thumbnails for all the raw data sources.
+AMDbThumbnail AMScan::thumbnail(int index) const {
+	if(currentlyScanning()) {
 
-		break;
-	}
-	default: {
-		// what?
-		break; }
+		AMErrorMon::debug(this, AMSCAN_THUMBNAIL_SCANNING_MESSAGE, "Thumbnail: AMScan know it's scanning");
+		return amScanCurrentlyScanningThumbnail(dateTime());
 	}
 
-	gscene.render(&painter);
-	painter.end();
+	const AMDataSource* dataSource = thumbnailDataSource(index);
+	if(!dataSource)
+		return AMDbThumbnail(QString(), QString(), AMDbThumbnail::InvalidType, QByteArray());
 
-	delete plot;	// deletes all plot items (series, image) with it.
+	return amScanDataSourceThumbnail(dataSource, index, scanRank());
+}
 
-	return AMDbThumbnail(dataSource->description(), dataSource->name(), image);
+AMDbThumbnailGenerator* AMScan::createThumbnailGenerator() const
+{
+	// The data sources belong to this thread, so they are copied here.  The copies are implicitly shared, so nothing is copied again on the way to the worker.
+	QList<AMDataSourceSnapshotData> sources;
+
+	if(!currentlyScanning())
+		for(int i = 0, count = thumbnailCount(); i < count; i++)
+			sources << AMDataSourceSnapshotData(thumbnailDataSource(i));
 
+	return new AMScanThumbnailGenerator(currentlyScanning(), dateTime(), scanRank(), sources);
 }
 
 bool AMScan::loadData()
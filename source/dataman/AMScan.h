@@ -381,9 +381,13 @@ Returns false and does nothing if the new \c dataStore is incompatible with any
 
 	/// Return a thumbnail picture of the data sources. If we have any analyzed data sources, we have a thumbnail for each analyzed data source. Otherwise, rather than showing nothing, we have a thumbnail for each raw data source.  Unless we are currently scanning, in which case we just have one (which visually indicates this). In all cases, we exclude data sources that have the AMDataSource::hiddenFromUsers() attribute set.
 	AMDbThumbnail thumbnail(int index) const;
+	/// Returns the data source drawn by thumbnail() for \c index, or 0 if there isn't one (including while scanning).
+	const AMDataSource* thumbnailDataSource(int index) const;
 
-	/// Generating these thumbnails is time-consuming, because we have to draw a bunch of plots and render them to PNGs. Therefore, we should do it in a seperate thread.
-	virtual bool shouldGenerateThumbnailsInSeparateThread() const { return false; }
+	/// Generating these thumbnails is time-consuming, because we have to read all of the data and render it to PNGs. Therefore, we do it in a seperate thread, from snapshots of the data sources (see createThumbnailGenerator()).
+	virtual bool shouldGenerateThumbnailsInSeparateThread() const { return true; }
+	/// Copies the data sources that thumbnail() would draw into AMDataSourceSnapshotData, so that the thumbnails can be drawn in a separate thread without re-loading the scan there (which would run the file loader plugins off the GUI thread).
+	virtual AMDbThumbnailGenerator* createThumbnailGenerator() const;
 
 
 	// Role 9: Acquisition status, and link to scan controller
@@ -0,0 +1,812 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMScanJournal.h"
+
+#include <QThread>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "dataman/AMScan.h"
+#include "dataman/AMAxisInfo.h"
+#include "dataman/AMMeasurementInfo.h"
+#include "dataman/datastore/AMDataStore.h"
+#include "dataman/datastore/AMCDFDataStore.h"
+#include "dataman/datasource/AMRawDataSource.h"
+#include "dataman/database/AMDbObjectSupport.h"
+#include "dataman/database/AMDatabase.h"
+#include "util/AMSettings.h"
+#include "util/AMErrorMonitor.h"
+
+/// Identifies a journal file; it is the payload prefix of the header record.
+static const char AMSCANJOURNAL_MAGIC[] = "AMJOURNL";
+static const qint32 AMSCANJOURNAL_VERSION = 1;
+/// Records larger than this are assumed to be garbage left by a torn write.
+static const quint32 AMSCANJOURNAL_MAXIMUM_RECORD_SIZE = 256*1024*1024;
+
+/// The background thread that writes and syncs an AMScanJournal.
+class AMScanJournalCommitThread : public QThread
+{
+public:
+	AMScanJournalCommitThread(AMScanJournal *journal) : QThread(), journal_(journal) {}
+
+protected:
+	virtual void run() { journal_->commitLoop(); }
+
+	AMScanJournal *journal_;
+};
+
+AMScanJournal::AMScanJournal(AMScan *scan, const QString &journalFilePath, QObject *parent) :
+	QObject(parent)
+{
+	scan_ = scan;
+	store_ = scan->rawData();
+
+	journaledAxes_ = 0;
+	journaledMeasurements_ = 0;
+	journaledRows_ = 0;
+	finished_ = false;
+
+	commitInterval_ = 250;
+	maximumPendingBytes_ = 1024*1024;
+	appendedRecords_ = 0;
+	committedRecords_ = 0;
+	commitCount_ = 0;
+	flushRequested_ = false;
+	stopping_ = false;
+	writeError_ = false;
+
+	journalFilePath_ = journalFilePath;
+	if(journalFilePath_.isEmpty()){
+
+		QString folder = defaultJournalFolder();
+		QDir().mkpath(folder);
+		journalFilePath_ = folder + QDateTime::currentDateTime().toString("/yyyyMMdd_hhmmss") + QString("_%1.amjournal").arg(int(qrand()%10000), 4, 10, QChar('0'));
+	}
+
+	file_.setFileName(journalFilePath_);
+	if(!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+
+		writeError_ = true;
+		AMErrorMon::alert(this, AMSCANJOURNAL_CANNOT_OPEN_JOURNAL, QString("Could not create the journal file '%1' for the scan '%2'. If the program stops unexpectedly, this scan will not be recoverable.").arg(journalFilePath_).arg(scan_->fullName()));
+	}
+
+	QByteArray header;
+	QDataStream headerStream(&header, QIODevice::WriteOnly);
+	headerStream.setVersion(QDataStream::Qt_4_6);
+	headerStream.writeRawData(AMSCANJOURNAL_MAGIC, 8);
+	headerStream << AMSCANJOURNAL_VERSION << QString(scan_->metaObject()->className()) << scan_->name() << qint32(scan_->number()) << scan_->dateTime() << qint32(scan_->runId()) << qint32(scan_->sampleId()) << scan_->notes();
+	appendRecord(HeaderRecord, header);
+
+	// Anything already in the store is journaled now; from here on, we hear about every change.
+	journalStructure();
+	for(int measurementId = 0, count = store_->measurementCount(); measurementId < count && !store_->scanSpaceIsEmpty(); measurementId++){
+
+		if(measurementId == 0)
+			journalAxisValues(AMnDIndex(), AMnDIndex());
+		journalValues(AMnDIndex(), AMnDIndex(), measurementId);
+	}
+
+	connect(store_, SIGNAL(dataChanged(AMnDIndex,AMnDIndex,int)), this, SLOT(onDataChanged(AMnDIndex,AMnDIndex,int)));
+	connect(store_, SIGNAL(sizeChanged()), this, SLOT(onSizeChanged()));
+
+	commitThread_ = new AMScanJournalCommitThread(this);
+	if(file_.isOpen())
+		commitThread_->start();
+}
+
+AMScanJournal::~AMScanJournal()
+{
+	mutex_.lock();
+	stopping_ = true;
+	commitNeeded_.wakeAll();
+	mutex_.unlock();
+
+	commitThread_->wait();
+	delete commitThread_;
+
+	file_.close();
+}
+
+bool AMScanJournal::isValid() const
+{
+	QMutexLocker locker(&mutex_);
+	return file_.isOpen() && !writeError_;
+}
+
+int AMScanJournal::commitInterval() const
+{
+	QMutexLocker locker(&mutex_);
+	return commitInterval_;
+}
+
+int AMScanJournal::maximumPendingBytes() const
+{
+	QMutexLocker locker(&mutex_);
+	return maximumPendingBytes_;
+}
+
+qint64 AMScanJournal::recordCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return appendedRecords_;
+}
+
+qint64 AMScanJournal::commitCount() const
+{
+	QMutexLocker locker(&mutex_);
+	return commitCount_;
+}
+
+void AMScanJournal::setCommitInterval(int milliseconds)
+{
+	QMutexLocker locker(&mutex_);
+	commitInterval_ = qMax(0, milliseconds);
+}
+
+void AMScanJournal::setMaximumPendingBytes(int bytes)
+{
+	QMutexLocker locker(&mutex_);
+	maximumPendingBytes_ = qMax(1, bytes);
+}
+
+QString AMScanJournal::defaultJournalFolder()
+{
+	return AMUserSettings::userDataFolder + "/journals";
+}
+
+bool AMScanJournal::flush()
+{
+	QMutexLocker locker(&mutex_);
+
+	if(!commitThread_->isRunning())
+		return false;
+
+	qint64 target = appendedRecords_;
+	flushRequested_ = true;
+	commitNeeded_.wakeAll();
+
+	while(committedRecords_ < target && !writeError_)
+		commitDone_.wait(&mutex_);
+
+	return !writeError_;
+}
+
+void AMScanJournal::finish()
+{
+	if(finished_)
+		return;
+
+	disconnect(store_, 0, this, 0);
+	appendRecord(FinishedRecord, QByteArray());
+
+	mutex_.lock();
+	stopping_ = true;
+	commitNeeded_.wakeAll();
+	mutex_.unlock();
+
+	// Stopping the commit thread writes everything that is left, including the end record.
+	commitThread_->wait();
+	file_.close();
+
+	finished_ = true;
+	QFile::remove(journalFilePath_);
+}
+
+void AMScanJournal::onDataChanged(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd, int measurementId)
+{
+	journalStructure();
+
+	// Axis values are set along with the data, so they are journaled with the first measurement.  (Later writes replace earlier ones when the journal is replayed.)
+	if(measurementId == 0)
+		journalAxisValues(scanIndexStart, scanIndexEnd);
+
+	journalValues(scanIndexStart, scanIndexEnd, measurementId);
+}
+
+void AMScanJournal::onSizeChanged()
+{
+	journalStructure();
+}
+
+void AMScanJournal::journalStructure()
+{
+	for(int count = store_->scanAxesCount(); journaledAxes_ < count; journaledAxes_++){
+
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_4_6);
+		writeAxisInfo(stream, store_->scanAxisAt(journaledAxes_));
+		appendRecord(ScanAxisRecord, payload);
+	}
+
+	for(int count = store_->measurementCount(); journaledMeasurements_ < count; journaledMeasurements_++){
+
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_4_6);
+		writeMeasurementInfo(stream, store_->measurementAt(journaledMeasurements_));
+		appendRecord(MeasurementRecord, payload);
+	}
+
+	// Only the first scan axis can grow. (The store may also have been cleared, in which case the journal starts the rows over.)
+	long rows = store_->scanAxesCount() > 0 ? store_->scanSize(0) : 0;
+
+	if(rows != journaledRows_){
+
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_4_6);
+		stream << qint64(rows);
+		appendRecord(RowsRecord, payload);
+		journaledRows_ = rows;
+	}
+}
+
+void AMScanJournal::journalAxisValues(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd)
+{
+	bool wholeSpace = !scanIndexStart.isValid() || !scanIndexEnd.isValid();
+
+	for(int axisId = 0, count = store_->scanAxesCount(); axisId < count; axisId++){
+
+		// Uniform axes are described completely by their definition.
+		if(store_->scanAxisAt(axisId).isUniform)
+			continue;
+
+		long first = wholeSpace ? 0 : scanIndexStart.at(axisId);
+		long last = wholeSpace ? store_->scanSize(axisId)-1 : scanIndexEnd.at(axisId);
+
+		if(last < first)
+			continue;
+
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_4_6);
+		stream << qint32(axisId) << qint64(first) << qint64(last);
+
+		for(long i = first; i <= last; i++)
+			stream << double(store_->axisValue(axisId, i));
+
+		appendRecord(AxisValuesRecord, payload);
+	}
+}
+
+void AMScanJournal::journalValues(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd, int measurementId)
+{
+	if((unsigned)measurementId >= (unsigned)store_->measurementCount())
+		return;
+
+	int scanRank = store_->scanRank();
+	if(scanRank > 0 && store_->scanSpaceIsEmpty())
+		return;
+
+	AMnDIndex start, end;
+
+	if(scanIndexStart.isValid() && scanIndexEnd.isValid() && scanIndexStart.rank() == scanRank && scanIndexEnd.rank() == scanRank){
+
+		start = scanIndexStart;
+		end = scanIndexEnd;
+	}
+
+	else if(scanRank > 0){
+
+		start = AMnDIndex(scanRank, AMnDIndex::DoInit, 0);
+		end = store_->scanSize();
+		for(int mu = 0; mu < scanRank; mu++)
+			end[mu] = end.at(mu)-1;
+	}
+
+	AMMeasurementInfo measurement = store_->measurementAt(measurementId);
+	int measurementRank = measurement.rank();
+	AMnDIndex measurementStart = measurementRank > 0 ? AMnDIndex(measurementRank, AMnDIndex::DoInit, 0) : AMnDIndex();
+	AMnDIndex measurementEnd = measurement.size();
+	for(int mu = 0; mu < measurementRank; mu++)
+		measurementEnd[mu] = measurementEnd.at(mu)-1;
+
+	long valuesPerPoint = measurement.size().product();
+	QVector<double> buffer(valuesPerPoint);
+
+	// Walk every scan point in the block, last axis fastest.  Each point gets its own record, so that a torn write only loses the point being written.
+	AMnDIndex scanIndex = start;
+	forever {
+
+		if(!store_->values(scanIndex, scanIndex, measurementId, measurementStart, measurementEnd, buffer.data()))
+			return;
+
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_4_6);
+		stream << qint32(measurementId) << qint32(scanRank);
+		for(int mu = 0; mu < scanRank; mu++)
+			stream << qint64(scanIndex.at(mu));
+		stream << qint64(valuesPerPoint);
+		for(long i = 0; i < valuesPerPoint; i++)
+			stream << buffer.at(i);
+
+		appendRecord(ValuesRecord, payload);
+
+		int mu = scanRank-1;
+		for(; mu >= 0; mu--){
+
+			if(scanIndex.at(mu) < end.at(mu)){
+
+				scanIndex[mu] = scanIndex.at(mu)+1;
+				break;
+			}
+
+			scanIndex[mu] = start.at(mu);
+		}
+
+		if(mu < 0)
+			break;
+	}
+}
+
+void AMScanJournal::appendRecord(RecordType type, const QByteArray &payload)
+{
+	// Frame: [quint32 payload length][quint8 type][payload][quint16 checksum of type and payload]
+	QByteArray record;
+	record.reserve(payload.size() + 7);
+
+	QDataStream stream(&record, QIODevice::WriteOnly);
+	stream << quint32(payload.size()) << quint8(type);
+	stream.writeRawData(payload.constData(), payload.size());
+	stream << quint16(qChecksum(record.constData()+4, record.size()-4));
+
+	QMutexLocker locker(&mutex_);
+
+	// Once the journal can't be written, there's no point holding on to the data.
+	if(writeError_)
+		return;
+
+	bool wasEmpty = pendingData_.isEmpty();
+	pendingData_.append(record);
+	appendedRecords_++;
+
+	if(wasEmpty || pendingData_.size() >= maximumPendingBytes_)
+		commitNeeded_.wakeAll();
+}
+
+void AMScanJournal::commitLoop()
+{
+	QMutexLocker locker(&mutex_);
+
+	forever {
+
+		if(pendingData_.isEmpty()){
+
+			if(stopping_)
+				break;
+
+			commitNeeded_.wait(&mutex_);
+			continue;
+		}
+
+		// Give other records a chance to join this commit, unless someone is waiting for it.
+		if(!stopping_ && !flushRequested_ && pendingData_.size() < maximumPendingBytes_)
+			commitNeeded_.wait(&mutex_, commitInterval_);
+
+		QByteArray data = pendingData_;
+		pendingData_.clear();
+		qint64 records = appendedRecords_;
+		flushRequested_ = false;
+
+		locker.unlock();
+		bool success = writeAndSync(data);
+		locker.relock();
+
+		if(success){
+
+			committedRecords_ = records;
+			commitCount_++;
+		}
+		else
+			writeError_ = true;
+
+		commitDone_.wakeAll();
+
+		if(!success)
+			break;
+	}
+}
+
+bool AMScanJournal::writeAndSync(const QByteArray &data)
+{
+	if(file_.write(data) != data.size() || !file_.flush()){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_WRITE_JOURNAL, QString("Could not write to the scan journal '%1': %2. If the program stops unexpectedly, the rest of this scan will not be recoverable.").arg(journalFilePath_).arg(file_.errorString()));
+		return false;
+	}
+
+#ifdef Q_OS_UNIX
+	if(::fsync(file_.handle()) != 0){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_WRITE_JOURNAL, QString("Could not sync the scan journal '%1' to disk. If the program stops unexpectedly, the rest of this scan may not be recoverable.").arg(journalFilePath_));
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+void AMScanJournal::writeAxisInfo(QDataStream &stream, const AMAxisInfo &axis)
+{
+	stream << axis.name << qint64(axis.size) << axis.description << axis.units << axis.isUniform;
+	stream << axis.start.isValid() << double(axis.start) << axis.increment.isValid() << double(axis.increment);
+}
+
+AMAxisInfo AMScanJournal::readAxisInfo(QDataStream &stream)
+{
+	QString name, description, units;
+	qint64 size;
+	bool isUniform, startIsValid, incrementIsValid;
+	double start, increment;
+
+	stream >> name >> size >> description >> units >> isUniform >> startIsValid >> start >> incrementIsValid >> increment;
+
+	AMAxisInfo axis(name, long(size), description, units);
+	axis.isUniform = isUniform;
+	axis.start = startIsValid ? AMNumber(start) : AMNumber(AMNumber::Null);
+	axis.increment = incrementIsValid ? AMNumber(increment) : AMNumber(AMNumber::Null);
+
+	return axis;
+}
+
+void AMScanJournal::writeMeasurementInfo(QDataStream &stream, const AMMeasurementInfo &measurement)
+{
+	stream << measurement.name << measurement.description << measurement.units << qint32(measurement.axes.count());
+
+	foreach(AMAxisInfo axis, measurement.axes)
+		writeAxisInfo(stream, axis);
+}
+
+AMMeasurementInfo AMScanJournal::readMeasurementInfo(QDataStream &stream)
+{
+	QString name, description, units;
+	qint32 axisCount;
+
+	stream >> name >> description >> units >> axisCount;
+
+	QList<AMAxisInfo> axes;
+	for(int i = 0; i < axisCount && stream.status() == QDataStream::Ok; i++)
+		axes << readAxisInfo(stream);
+
+	return AMMeasurementInfo(name, description, units, axes);
+}
+
+bool AMScanJournal::readRecord(QFile &file, RecordType *type, QByteArray *payload, bool *torn)
+{
+	if(torn)
+		*torn = false;
+
+	if(file.atEnd())
+		return false;
+
+	QByteArray lengthBytes = file.read(4);
+	if(lengthBytes.size() != 4){
+
+		if(torn)
+			*torn = true;
+		return false;
+	}
+
+	quint32 length;
+	QDataStream lengthStream(lengthBytes);
+	lengthStream >> length;
+
+	if(length > AMSCANJOURNAL_MAXIMUM_RECORD_SIZE){
+
+		if(torn)
+			*torn = true;
+		return false;
+	}
+
+	QByteArray body = file.read(qint64(length) + 3);
+	if(body.size() != int(length) + 3){
+
+		if(torn)
+			*torn = true;
+		return false;
+	}
+
+	quint16 checksum;
+	QDataStream checksumStream(body.right(2));
+	checksumStream >> checksum;
+
+	if(checksum != qChecksum(body.constData(), body.size()-2)){
+
+		if(torn)
+			*torn = true;
+		return false;
+	}
+
+	*type = RecordType(quint8(body.at(0)));
+	*payload = body.mid(1, int(length));
+	return true;
+}
+
+QStringList AMScanJournal::unfinishedJournals(const QString &folder)
+{
+	QDir dir(folder.isEmpty() ? defaultJournalFolder() : folder);
+	QStringList rv;
+
+	foreach(QFileInfo info, dir.entryInfoList(QStringList() << "*.amjournal", QDir::Files, QDir::Time | QDir::Reversed)){
+
+		QFile file(info.absoluteFilePath());
+		if(!file.open(QIODevice::ReadOnly))
+			continue;
+
+		RecordType type, lastType = HeaderRecord;
+		QByteArray payload;
+		bool isJournal = false;
+
+		if(readRecord(file, &type, &payload) && type == HeaderRecord && payload.startsWith(AMSCANJOURNAL_MAGIC))
+			isJournal = true;
+
+		while(isJournal && readRecord(file, &type, &payload))
+			lastType = type;
+
+		if(isJournal && lastType != FinishedRecord)
+			rv << info.absoluteFilePath();
+	}
+
+	return rv;
+}
+
+AMScan *AMScanJournal::recover(const QString &journalFilePath, AMDataStore *dataStore, bool *finished)
+{
+	if(finished)
+		*finished = false;
+
+	QFile file(journalFilePath);
+	if(!file.open(QIODevice::ReadOnly)){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_READ_JOURNAL, QString("Could not open the scan journal '%1' to recover a scan.").arg(journalFilePath));
+		delete dataStore;
+		return 0;
+	}
+
+	RecordType type;
+	QByteArray payload;
+
+	if(!readRecord(file, &type, &payload) || type != HeaderRecord || !payload.startsWith(AMSCANJOURNAL_MAGIC)){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_READ_JOURNAL, QString("The file '%1' is not a scan journal, or its header is damaged.").arg(journalFilePath));
+		delete dataStore;
+		return 0;
+	}
+
+	QDataStream headerStream(payload);
+	headerStream.setVersion(QDataStream::Qt_4_6);
+	headerStream.skipRawData(8);
+
+	qint32 version, number, runId, sampleId;
+	QString className, name, notes;
+	QDateTime dateTime;
+	headerStream >> version >> className >> name >> number >> dateTime >> runId >> sampleId >> notes;
+
+	if(headerStream.status() != QDataStream::Ok || version > AMSCANJOURNAL_VERSION){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_READ_JOURNAL, QString("The scan journal '%1' was written by a newer version of Acquaman, or its header is damaged.").arg(journalFilePath));
+		delete dataStore;
+		return 0;
+	}
+
+	// Create a scan of the same class we were journaling.
+	AMScan *scan = 0;
+	const AMDbObjectInfo *info = AMDbObjectSupport::s()->objectInfoForClass(className);
+	if(info && info->metaObject)
+		scan = qobject_cast<AMScan*>(info->metaObject->newInstance());
+
+	if(!scan){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_CREATE_SCAN, QString("Could not create a scan of type '%1' while recovering the journal '%2'. The data will be recovered into a generic scan instead.").arg(className).arg(journalFilePath));
+		scan = new AMScan();
+	}
+
+	scan->clearRawDataCompletely();
+	if(dataStore)
+		scan->replaceRawDataStore(dataStore);
+
+	scan->setName(name);
+	scan->setNumber(number);
+	scan->setDateTime(dateTime);
+	scan->setRunId(runId);
+	scan->setSampleId(sampleId);
+	scan->setNotes(notes);
+
+	bool isFinished = false;
+	bool torn = false;
+	int replayedRecords = 0;
+
+	while(readRecord(file, &type, &payload, &torn)){
+
+		if(type == FinishedRecord){
+
+			isFinished = true;
+			break;
+		}
+
+		if(!replayRecord(scan, type, payload)){
+
+			AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_REPLAY_RECORD, QString("Record %1 of the scan journal '%2' could not be replayed. The scan was recovered up to that point.").arg(replayedRecords+2).arg(journalFilePath));
+			break;
+		}
+
+		replayedRecords++;
+	}
+
+	if(torn)
+		AMErrorMon::debug(0, AMSCANJOURNAL_JOURNAL_TRUNCATED, QString("The scan journal '%1' ends with an incomplete record, which was ignored.").arg(journalFilePath));
+
+	// Expose each measurement, since analysis blocks are not recorded in the journal.
+	AMDataStore *store = scan->rawData();
+	for(int measurementId = 0, count = store->measurementCount(); measurementId < count; measurementId++)
+		scan->addRawDataSource(new AMRawDataSource(store, measurementId));
+
+	if(finished)
+		*finished = isFinished;
+
+	return scan;
+}
+
+bool AMScanJournal::replayRecord(AMScan *scan, RecordType type, const QByteArray &payload)
+{
+	AMDataStore *store = scan->rawData();
+	QDataStream stream(payload);
+	stream.setVersion(QDataStream::Qt_4_6);
+
+	switch(type){
+
+	case ScanAxisRecord:
+		return store->addScanAxis(readAxisInfo(stream)) && stream.status() == QDataStream::Ok;
+
+	case MeasurementRecord:
+		return store->addMeasurement(readMeasurementInfo(stream)) && stream.status() == QDataStream::Ok;
+
+	case RowsRecord: {
+
+		qint64 rows;
+		stream >> rows;
+
+		if(stream.status() != QDataStream::Ok || store->scanAxesCount() == 0)
+			return false;
+
+		long currentRows = store->scanSize(0);
+
+		if(rows < currentRows){
+
+			store->clearScanDataPoints();
+			currentRows = 0;
+		}
+
+		if(rows > currentRows){
+
+			if(!store->beginInsertRows(long(rows-currentRows), -1))
+				return false;
+			store->endInsertRows();
+		}
+
+		return true;
+	}
+
+	case AxisValuesRecord: {
+
+		qint32 axisId;
+		qint64 first, last;
+		stream >> axisId >> first >> last;
+
+		for(qint64 i = first; i <= last && stream.status() == QDataStream::Ok; i++){
+
+			double value;
+			stream >> value;
+			store->setAxisValue(axisId, long(i), value);
+		}
+
+		return stream.status() == QDataStream::Ok;
+	}
+
+	case ValuesRecord: {
+
+		qint32 measurementId, scanRank;
+		stream >> measurementId >> scanRank;
+
+		if(scanRank != store->scanRank() || (unsigned)measurementId >= (unsigned)store->measurementCount())
+			return false;
+
+		AMnDIndex scanIndex = scanRank > 0 ? AMnDIndex(scanRank, AMnDIndex::DoNotInit) : AMnDIndex();
+		for(int mu = 0; mu < scanRank; mu++){
+
+			qint64 index;
+			stream >> index;
+			scanIndex[mu] = long(index);
+		}
+
+		qint64 count;
+		stream >> count;
+
+		if(stream.status() != QDataStream::Ok || count != store->measurementAt(measurementId).size().product())
+			return false;
+
+		QVector<double> values(int(count));
+		for(int i = 0; i < count; i++)
+			stream >> values[i];
+
+		return stream.status() == QDataStream::Ok && store->setValue(scanIndex, measurementId, values.constData());
+	}
+
+	default:
+		// Unknown records (from a newer version) are skipped.
+		return true;
+	}
+}
+
+int AMScanJournal::recoverToDatabase(const QString &journalFilePath, AMDatabase *database)
+{
+	if(!database)
+		return -1;
+
+	QString dataFilePath = AMUserSettings::defaultAbsolutePathForScan(QDateTime::currentDateTime()) + ".cdf";
+	AMCDFDataStore *dataStore = new AMCDFDataStore(dataFilePath, false);
+
+	if(!dataStore->isValid()){
+
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_CREATE_DATA_FILE, QString("Could not create the data file '%1' to recover the scan journal '%2'.").arg(dataFilePath).arg(journalFilePath));
+		delete dataStore;
+		return -1;
+	}
+
+	AMScan *scan = recover(journalFilePath, dataStore);
+	if(!scan){
+
+		QFile::remove(dataFilePath);
+		return -1;
+	}
+
+	dataStore->flushToDisk();
+
+	scan->setFileFormat("amCDFv1");
+	scan->setFilePath(AMUserSettings::relativePathFromUserDataFolder(dataFilePath));
+	scan->setNotes(scan->notes() + QString("%1Recovered from the journal '%2' on %3, after the scan did not finish normally.").arg(scan->notes().isEmpty() ? "" : "\n\n").arg(QFileInfo(journalFilePath).fileName()).arg(QDateTime::currentDateTime().toString()));
+
+	int scanId = -1;
+
+	if(scan->storeToDb(database)){
+
+		scanId = scan->id();
+		QFile::remove(journalFilePath);
+		AMErrorMon::information(0, AMSCANJOURNAL_RECOVERED_SCAN, QString("The scan '%1' did not finish normally the last time Acquaman was running. The data collected up to that point has been recovered and saved.").arg(scan->fullName()));
+	}
+
+	else
+		AMErrorMon::alert(0, AMSCANJOURNAL_CANNOT_STORE_RECOVERED_SCAN, QString("The scan '%1' was recovered from the journal '%2', but could not be saved to the database. The journal has been kept so that it can be recovered later.").arg(scan->fullName()).arg(journalFilePath));
+
+	scan->release();
+
+	if(scanId == -1)
+		QFile::remove(dataFilePath);
+
+	return scanId;
+}
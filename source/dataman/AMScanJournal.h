@@ -0,0 +1,198 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMSCANJOURNAL_H
+#define AMSCANJOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QStringList>
+
+#include "dataman/AMnDIndex.h"
+
+class AMScan;
+class AMDataStore;
+class AMDatabase;
+class AMAxisInfo;
+class AMMeasurementInfo;
+class AMScanJournalCommitThread;
+
+#define AMSCANJOURNAL_CANNOT_OPEN_JOURNAL 290901
+#define AMSCANJOURNAL_CANNOT_WRITE_JOURNAL 290902
+#define AMSCANJOURNAL_CANNOT_READ_JOURNAL 290903
+#define AMSCANJOURNAL_JOURNAL_TRUNCATED 290904
+#define AMSCANJOURNAL_CANNOT_CREATE_SCAN 290905
+#define AMSCANJOURNAL_CANNOT_REPLAY_RECORD 290906
+#define AMSCANJOURNAL_CANNOT_CREATE_DATA_FILE 290907
+#define AMSCANJOURNAL_CANNOT_STORE_RECOVERED_SCAN 290908
+#define AMSCANJOURNAL_RECOVERED_SCAN 290909
+
+/// This class keeps a crash-safe, append-only journal of the raw data arriving in a scan, so that the scan can be rebuilt if the program dies before the scan is saved.
+/*! Scan controllers accumulate their data in the scan's rawData() store, which usually lives in memory until the scan finishes.  If the program crashes or is killed in the middle of a long scan, that data is gone.  An AMScanJournal attaches to a running scan and watches its rawData() store.  Every change is appended to a binary journal file:
+
+- the scan's class name, name, number, run and date/time (once, when the journal is attached),
+- the definition of every scan axis and measurement (as soon as they appear in the store),
+- the number of rows whenever the first scan axis grows,
+- the axis values and measurement values for every scan point that changes.
+
+The journal is passive: it only listens to the store's dataChanged() and sizeChanged() signals, so scan controllers don't need to know it exists.
+
+<b>Group commit</b>
+
+Appending to the journal only copies the record into a memory buffer.  A background thread writes the buffer to disk and calls fsync() at most once every commitInterval() ms (or sooner if more than maximumPendingBytes() are waiting, or if flush() is called).  The acquisition path never waits for the disk, and many records share the cost of each fsync().  A crash can lose at most the last commitInterval() ms of data.
+
+<b>Recovery</b>
+
+When the scan ends normally, call finish(): the journal writes an end record and removes its file.  Any journal left in the journal folder at startup therefore belongs to a scan that never finished.  unfinishedJournals() finds them, and recover() replays one into a new scan of the original class (with one AMRawDataSource for each measurement).  recoverToDatabase() does the same into a new CDF file in the user data folder, and stores the recovered scan in a database so that it can be opened like any other.
+
+Every record is framed with its length and a checksum.  A record that was only partially written when the program died is detected and ignored, along with anything after it.
+*/
+class AMScanJournal : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// The types of records stored in the journal.
+	enum RecordType { HeaderRecord = 1, ScanAxisRecord, MeasurementRecord, RowsRecord, AxisValuesRecord, ValuesRecord, FinishedRecord };
+
+	/// Attaches a new journal to \c scan, writing it to \c journalFilePath.  If \c journalFilePath is empty, a unique file is created in defaultJournalFolder().  The scan's current axes, measurements and data are journaled right away.  Check isValid() to see if the journal file could be created.
+	/*! The journal must be deleted (or finish() called) before the \c scan is deleted. */
+	explicit AMScanJournal(AMScan *scan, const QString &journalFilePath = QString(), QObject *parent = 0);
+	/// Commits anything that is still waiting and stops the commit thread.  If finish() was not called, the journal file is left in place for recovery.
+	virtual ~AMScanJournal();
+
+	/// Returns true if the journal file was opened successfully, and no write error has happened since.
+	bool isValid() const;
+	/// The path of the journal file.
+	QString journalFilePath() const { return journalFilePath_; }
+	/// Returns true once finish() has been called.
+	bool isFinished() const { return finished_; }
+
+	/// The maximum time (in ms) a record will wait in memory before it is written and synced to disk.
+	int commitInterval() const;
+	/// The amount of waiting data (in bytes) that will trigger a commit before the commitInterval() has passed.
+	int maximumPendingBytes() const;
+
+	/// The number of records appended to the journal so far.
+	qint64 recordCount() const;
+	/// The number of times the journal has been written and synced to disk.
+	qint64 commitCount() const;
+
+	/// The folder where journals are created by default: 'journals' inside the user data folder.
+	static QString defaultJournalFolder();
+	/// Returns the paths of all journals in \c folder that were not finished.  If \c folder is empty, defaultJournalFolder() is used.
+	static QStringList unfinishedJournals(const QString &folder = QString());
+
+	/// Rebuilds a scan from the journal at \c journalFilePath.  Returns 0 if the journal could not be read or replayed.  The scan is created using the class recorded in the journal, and the caller takes ownership of it.
+	/*! If \c dataStore is provided, the data is replayed into it, and it becomes the scan's rawData().  (It should be empty.)  Otherwise the scan keeps its default in-memory store.  Each measurement gets an AMRawDataSource with the same name; analysis blocks are not recorded in the journal, and are not restored.
+
+	If \c finished is provided, it is set to whether the journal was finished normally.
+	*/
+	static AMScan *recover(const QString &journalFilePath, AMDataStore *dataStore = 0, bool *finished = 0);
+	/// Recovers the journal at \c journalFilePath into a new CDF file in the user data folder, and stores the scan in \c database.  If this succeeds, the journal file is removed.  Returns the database id of the recovered scan, or -1 if it could not be recovered.
+	static int recoverToDatabase(const QString &journalFilePath, AMDatabase *database);
+
+public slots:
+	/// Sets the maximum time (in ms) a record will wait in memory before it is written and synced to disk.
+	void setCommitInterval(int milliseconds);
+	/// Sets the amount of waiting data (in bytes) that will trigger a commit before the commitInterval() has passed.
+	void setMaximumPendingBytes(int bytes);
+
+	/// Writes and syncs everything appended so far, and waits until it is on disk.  Returns false if the journal could not be written.
+	bool flush();
+	/// Marks the journal as complete: writes an end record, commits it, detaches from the scan and removes the journal file.  Call this once the scan has been saved normally.
+	void finish();
+
+protected slots:
+	/// Journals any new axes, measurements or rows, and the values of the scan points between \c scanIndexStart and \c scanIndexEnd for \c measurementId.
+	void onDataChanged(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd, int measurementId);
+	/// Journals any new axes, measurements or rows.
+	void onSizeChanged();
+
+protected:
+	/// Journals scan axes and measurements that have been added to the store since the last call, and any new rows along the first scan axis.
+	void journalStructure();
+	/// Journals the values of all the scan axes for the scan points between \c scanIndexStart and \c scanIndexEnd.
+	void journalAxisValues(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd);
+	/// Journals the values of \c measurementId for every scan point between \c scanIndexStart and \c scanIndexEnd.
+	void journalValues(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd, int measurementId);
+
+	/// Frames \c payload as a record of \c type and adds it to the waiting data.  Wakes the commit thread if this is the first waiting record, or if there is enough data to commit right away.
+	void appendRecord(RecordType type, const QByteArray &payload);
+
+	/// Called by the commit thread: waits for data to be appended, and writes and syncs it until the journal is destroyed.
+	void commitLoop();
+	/// Writes \c data to the journal file and syncs it to disk.  Called with mutex_ unlocked.
+	bool writeAndSync(const QByteArray &data);
+
+	/// Helper functions for serializing axes and measurements.
+	static void writeAxisInfo(QDataStream &stream, const AMAxisInfo &axis);
+	static AMAxisInfo readAxisInfo(QDataStream &stream);
+	static void writeMeasurementInfo(QDataStream &stream, const AMMeasurementInfo &measurement);
+	static AMMeasurementInfo readMeasurementInfo(QDataStream &stream);
+
+	/// Reads the next complete record from \c file.  Returns false at the end of the file, or if the record was torn or corrupt.  If \c torn is provided, it is set to true when there was something in the file that could not be read.
+	static bool readRecord(QFile &file, RecordType *type, QByteArray *payload, bool *torn = 0);
+	/// Replays one record into \c scan.  Returns false if the record doesn't make sense for the scan.
+	static bool replayRecord(AMScan *scan, RecordType type, const QByteArray &payload);
+
+	/// The scan we're journaling.
+	AMScan *scan_;
+	/// The scan's rawData() store.
+	AMDataStore *store_;
+
+	/// The journal file.  After construction, it is only used by the commit thread (and by finish(), once that thread has stopped).
+	QFile file_;
+	QString journalFilePath_;
+
+	/// How many scan axes, measurements and rows of the store have already been journaled.
+	int journaledAxes_;
+	int journaledMeasurements_;
+	long journaledRows_;
+
+	bool finished_;
+
+	/// Protects everything below, which is shared with the commit thread.
+	mutable QMutex mutex_;
+	/// Wakes the commit thread when there is something to do.
+	QWaitCondition commitNeeded_;
+	/// Wakes flush() when a commit has completed.
+	QWaitCondition commitDone_;
+
+	/// Framed records waiting to be written.
+	QByteArray pendingData_;
+	int commitInterval_;
+	int maximumPendingBytes_;
+	/// Number of records appended, and the number of them that are safely on disk.
+	qint64 appendedRecords_;
+	qint64 committedRecords_;
+	qint64 commitCount_;
+	bool flushRequested_;
+	bool stopping_;
+	bool writeError_;
+
+	/// The background thread that runs commitLoop().
+	AMScanJournalCommitThread *commitThread_;
+
+	friend class AMScanJournalCommitThread;
+};
+
+#endif // AMSCANJOURNAL_H
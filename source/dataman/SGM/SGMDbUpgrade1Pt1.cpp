@@ -19,6 +19,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SGMDbUpgrade1Pt1.h"
 
+#include "dataman/database/AMDbMigration.h"
+
 SGMDbUpgrade1Pt1::SGMDbUpgrade1Pt1(QString databaseNameToUpgrade, QObject *parent) :
 	AMDbUpgrade(databaseNameToUpgrade, parent)
 {
@@ -51,12 +53,13 @@ bool SGMDbUpgrade1Pt1::upgradeImplementation(){
 	QMap<QString, int> indexTablesToIndexSide;
 	indexTablesToIndexSide.insert("AMDetectorInfoSet_table_detectorInfos", 2);
 
-	// Use dbObjectClassBecomes to upgrade each detectorInfo to its new counterpart
-	success &= AMDbUpgradeSupport::dbObjectClassBecomes(databaseToUpgrade_, "PGTDetectorInfo", "CLSPGTDetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
-	success &= AMDbUpgradeSupport::dbObjectClassBecomes(databaseToUpgrade_, "OceanOptics65000DetectorInfo", "CLSOceanOptics65000DetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
-	success &= AMDbUpgradeSupport::dbObjectClassBecomes(databaseToUpgrade_, "MCPDetectorInfo", "SGMMCPDetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
+	// Rename each class to its new counterpart. All of the renames are applied in one transaction.
+	AMDbMigration migration(databaseToUpgrade_);
+	success &= AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(&migration, "PGTDetectorInfo", "CLSPGTDetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
+	success &= AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(&migration, "OceanOptics65000DetectorInfo", "CLSOceanOptics65000DetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
+	success &= AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(&migration, "MCPDetectorInfo", "SGMMCPDetectorInfo", parentTablesToColumnsNames, indexTablesToIndexSide);
 
-	return success;
+	return success && runMigration(&migration);
 }
 
 AMDbUpgrade* SGMDbUpgrade1Pt1::createCopy() const{
@@ -29,6 +29,10 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSqlDriver>
 #include <QTime>
 #include <QFileInfo>
+#include <QVector>
+#include <QPair>
+#include <QtAlgorithms>
+#include <string.h>
 
 #include "util/AMErrorMonitor.h"
 
@@ -581,6 +585,116 @@ QList<int> AMDatabase::objectsContaining(const QString& tableName, const QString
 	return rl;
 }
 
+bool AMDatabase::ensureSearchTable(const QString &searchTableName, const QStringList &columnNames)
+{
+	if(searchTableName.isEmpty() || columnNames.isEmpty())
+		return false;
+
+	if(tableExists(searchTableName))
+		return true;
+
+	// FTS4 is preferred, but FTS3 has the same query syntax and matchinfo(), so either one will do.
+	QStringList modules;
+	modules << "fts4" << "fts3";
+
+	foreach(QString module, modules) {
+
+		QSqlQuery q(qdb());
+		q.prepare(QString("CREATE VIRTUAL TABLE %1 USING %2(%3)").arg(searchTableName).arg(module).arg(columnNames.join(", ")));
+
+		if(execQuery(q)) {
+			q.finish();
+			return true;
+		}
+
+		q.finish();
+	}
+
+	AMErrorMon::report(AMErrorReport(this, AMErrorReport::Debug, AMDATABASE_SEARCH_TABLE_NOT_SUPPORTED, QString("Could not create the full-text search table '%1'. This SQLite library might not support full-text search.").arg(searchTableName)));
+	return false;
+}
+
+// Computes a relevance score from the default matchinfo() blob ("pcx" format: phrase count, column count, and then three numbers for every phrase/column pair).
+static double searchRank(const QByteArray &matchInfo)
+{
+	QVector<quint32> info(matchInfo.size()/int(sizeof(quint32)));
+
+	if(info.size() < 2)
+		return 0;
+
+	memcpy(info.data(), matchInfo.constData(), info.size()*sizeof(quint32));
+
+	int phraseCount = info.at(0);
+	int columnCount = info.at(1);
+
+	if(info.size() < 2 + 3*phraseCount*columnCount)
+		return 0;
+
+	// Each hit in this row counts for more when the word is rare across the whole table.
+	double rank = 0;
+
+	for(int phrase = 0; phrase < phraseCount; phrase++) {
+		for(int column = 0; column < columnCount; column++) {
+
+			const quint32 *hits = info.constData() + 2 + 3*(phrase*columnCount + column);
+
+			if(hits[0] > 0 && hits[1] > 0)
+				rank += double(hits[0])/double(hits[1]);
+		}
+	}
+
+	return rank;
+}
+
+QList<int> AMDatabase::searchObjects(const QString &searchTableName, const QString &searchText, int limit) const
+{
+	QList<int> rl;
+
+	QString expression = searchExpression(searchText);
+
+	if(searchTableName.isEmpty() || expression.isEmpty())
+		return rl;
+
+	QSqlQuery q( qdb() );
+	q.setForwardOnly(true);
+	q.prepare(QString("SELECT docid, matchinfo(%1) FROM %1 WHERE %1 MATCH ?").arg(searchTableName));
+	q.bindValue(0, expression);
+
+	if(!execQuery(q)) {
+		q.finish();
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, AMDATABASE_SEARCH_QUERY_FAILED, QString("Could not search the database for '%1'. The SQL reply was: %2").arg(searchText).arg(q.lastError().text())));
+		return rl;
+	}
+
+	// Sorting ascending on (-rank, -id) puts the best matches first, and the newest first among equal matches.
+	QList<QPair<double, int> > ranked;
+
+	while(q.next())
+		ranked << qMakePair(-searchRank(q.value(1).toByteArray()), -q.value(0).toInt());
+
+	q.finish();
+
+	qSort(ranked);
+
+	int count = (limit > 0) ? qMin(limit, ranked.count()) : ranked.count();
+
+	for(int i = 0; i < count; i++)
+		rl << -ranked.at(i).second;
+
+	return rl;
+}
+
+QString AMDatabase::searchExpression(const QString &searchText)
+{
+	QStringList words = searchText.split(QRegExp("\\W+"), QString::SkipEmptyParts);
+	QStringList terms;
+
+	foreach(QString word, words)
+		terms << QString("\"%1*\"").arg(word);
+
+	return terms.join(" ");
+}
+
 bool AMDatabase::tableExists(const QString &tableName)
 {
 	QSqlQuery q = query();
@@ -697,6 +811,76 @@ bool AMDatabase::createIndex(const QString& tableName, const QString& columnName
 	}
 }
 
+bool AMDatabase::attachDatabase(const QString &filePath, const QString &schemaName)
+{
+	QSqlQuery q(qdb());
+	q.prepare(QString("ATTACH DATABASE ? AS %1").arg(schemaName));
+	q.bindValue(0, filePath);
+
+	if(!execQuery(q)) {
+		q.finish();
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Debug, AMDATABASE_ATTACH_FAILED, QString("Could not attach the database '%1' as '%2'. The SQL reply was: %3").arg(filePath).arg(schemaName).arg(q.lastError().text())));
+		return false;
+	}
+
+	q.finish();
+	return true;
+}
+
+bool AMDatabase::detachDatabase(const QString &schemaName)
+{
+	QSqlQuery q(qdb());
+	q.prepare(QString("DETACH DATABASE %1").arg(schemaName));
+
+	bool success = execQuery(q);
+	q.finish();
+
+	return success;
+}
+
+QStringList AMDatabase::columnNames(const QString &tableName)
+{
+	// PRAGMA takes the schema in front of the pragma name, not the table name.
+	QString schemaPrefix;
+	QString table = tableName;
+
+	if(tableName.contains('.')) {
+		schemaPrefix = tableName.section('.', 0, 0) % ".";
+		table = tableName.section('.', 1);
+	}
+
+	QSqlQuery q(qdb());
+	q.prepare(QString("PRAGMA %1table_info(%2);").arg(schemaPrefix).arg(table));
+	execQuery(q);
+
+	QStringList names;
+
+	while(q.next())
+		names << q.value(1).toString();
+
+	q.finish();
+
+	return names;
+}
+
+int AMDatabase::insertFromSelect(const QString &tableName, const QStringList &columnNames, const QString &selectStatement)
+{
+	QSqlQuery q(qdb());
+	q.prepare(QString("INSERT INTO %1 (%2) %3").arg(tableName).arg(columnNames.join(", ")).arg(selectStatement));
+
+	if(!execQuery(q)) {
+		q.finish();	// make sure that sqlite lock is released before emitting signals
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, AMDATABASE_INSERT_FROM_SELECT_FAILED, QString("Could not copy rows into the table '%1'. The SQL reply was: %2").arg(tableName).arg(q.lastError().text())));
+		return -1;
+	}
+
+	int insertedRows = q.numRowsAffected();
+	q.finish();	// make sure that sqlite lock is released before emitting signals
+
+	emit updated(tableName, -1);
+	return insertedRows;
+}
+
 QSqlQuery AMDatabase::select(const QString &tableName, const QString &columnNames, const QString &whereClause)
 {
 	QSqlQuery q(qdb());
@@ -38,6 +38,10 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #define AMDATABASE_LOCK_FOR_EXECQUERY_CONTENTION_FAILED -3106
 #define AMDATABASE_MISSING_TABLE_NAME_IN_RETRIEVE -3107
 #define AMDATABASE_RETRIEVE_QUERY_FAILED -3108
+#define AMDATABASE_SEARCH_TABLE_NOT_SUPPORTED -3109
+#define AMDATABASE_SEARCH_QUERY_FAILED -3110
+#define AMDATABASE_ATTACH_FAILED -3111
+#define AMDATABASE_INSERT_FROM_SELECT_FAILED -3112
 
 /// This class provides thread-safe, general access to an SQL database.
 /*! Instances of this class are used to query or modify a database; all of the functions are thread-safe and will operate using a per-thread connection to the same underlying database.
@@ -191,12 +195,37 @@ The parameters by which to access the database are given in \c dbAccessString. (
 
 	/// Return a list of all the objects/rows (by id) that contain 'value' in a certain column
 	/// ex: AMDatabase::db()->scansContaining("name", "Carbon60") could return Scans with names Carbon60_alpha and bCarbon60_gamma
+	/*! This matches substrings anywhere in the column, which requires a scan of the whole table.  For searching large tables by whole words or word prefixes, use a full-text search table and searchObjects() instead (see AMDbSearchIndex).*/
 	QList<int> objectsContaining(const QString& tableName, const QString& colName, const QVariant& value) const;
 
 	/// returns a list of all the objecst/rows (by id) that match a given condition. \c whereClause is a string suitable for appending after an SQL "WHERE" statement. If you want the id of all objects, you can omit the where clause.
 	QList<int> objectsWhere(const QString& tableName, const QString& whereClause = QString()) const;
 
 
+	// Full-text search
+	///////////////////////////
+
+	/// Ensure that an SQLite full-text search (FTS4, or FTS3 on older libraries) table called \c searchTableName exists, with the given \c columnNames. Its rowid ("docid") is meant to be the id of the indexed object.  Returns false if it could not be created, for example because the SQLite library was built without full-text search.
+	bool ensureSearchTable(const QString& searchTableName, const QStringList& columnNames);
+	/// Returns the ids (docids) of all the rows in the full-text search table \c searchTableName that contain every word in \c searchText, as a whole word or a word prefix.  The ids are ranked best-first: matches in rows with rare words, or several matches in the same row, come first, and ties go to the newest (highest) id.  If \c limit is positive, at most \c limit ids are returned.
+	QList<int> searchObjects(const QString& searchTableName, const QString& searchText, int limit = -1) const;
+	/// Converts text typed by a user into an FTS MATCH expression: every word must be present, and is matched as a prefix.  Punctuation (including FTS operators and quotes) is ignored.  Returns an empty string if there are no words in \c searchText.
+	static QString searchExpression(const QString& searchText);
+
+
+	// Bulk copies between databases
+	///////////////////////////
+
+	/// Attaches the SQLite database file at \c filePath to this thread's connection as \c schemaName, so that SQL run on this connection can refer to its tables as "schemaName.tableName" (ex: to copy rows between databases with insertFromSelect()).  This can't be done while a transaction is open.  Returns false on failure.
+	bool attachDatabase(const QString& filePath, const QString& schemaName);
+	/// Detaches a database that was attached with attachDatabase() on this thread's connection.
+	bool detachDatabase(const QString& schemaName);
+	/// Returns the names of the columns in \c tableName, in table order.  Use "schemaName.tableName" for a table in an attached database.  Returns an empty list if the table doesn't exist.
+	QStringList columnNames(const QString& tableName);
+	/// Runs "INSERT INTO tableName (columnNames) selectStatement" to copy many rows in one statement, and returns the number of rows inserted, or -1 on failure.  Since the new ids aren't reported individually, this emits updated(tableName, -1) instead of created().
+	int insertFromSelect(const QString& tableName, const QStringList& columnNames, const QString& selectStatement);
+
+
 	/// Starts an SQL transaction if the implementation supports them. Returns true on success.
 	bool startTransaction();
 	/// Tries to commit a transaction. Since SQLite commits may fail with SQLITE_BUSY errors, this will keep retrying up to \c timeoutMs ms for the commit to succeed. Returns true on success.
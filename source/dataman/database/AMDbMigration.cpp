@@ -0,0 +1,156 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMDbMigration.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTime>
+
+#include "dataman/database/AMDatabase.h"
+#include "util/AMErrorMonitor.h"
+
+AMDbMigration::AMDbMigration(AMDatabase *database, QObject *parent) :
+	QObject(parent)
+{
+	database_ = database;
+	rowsAffected_ = 0;
+	elapsedMs_ = 0;
+}
+
+void AMDbMigration::addStep(const QString &description, const QStringList &statements)
+{
+	descriptions_ << description;
+	statements_ << statements;
+}
+
+void AMDbMigration::addStep(const QString &description, const QString &statement)
+{
+	addStep(description, QStringList() << statement);
+}
+
+void AMDbMigration::clear()
+{
+	descriptions_.clear();
+	statements_.clear();
+}
+
+bool AMDbMigration::run()
+{
+	QTime timer;
+	timer.start();
+	rowsAffected_ = 0;
+	elapsedMs_ = 0;
+	lastError_.clear();
+
+	// If the caller already has a transaction open on this connection, we become part of it (transactions can't be nested), and leave the final commit or rollback to them.
+	bool openedTransaction = false;
+
+	if(!database_->transactionInProgress()){
+
+		if(!database_->startTransaction()){
+
+			lastError_ = QString("Could not start a transaction on the '%1' database.").arg(database_->connectionName());
+			AMErrorMon::alert(this, AMDBMIGRATION_COULD_NOT_START_TRANSACTION, lastError_);
+			return false;
+		}
+
+		openedTransaction = true;
+	}
+
+	for(int i = 0, size = stepCount(); i < size; i++){
+
+		emit progressChanged(i, size, descriptions_.at(i));
+
+		QString savepoint = QString("AMDbMigration_%1").arg(i);
+
+		if(!exec(QString("SAVEPOINT %1").arg(savepoint)))
+			return abandon(QString(), openedTransaction, AMDBMIGRATION_COULD_NOT_CREATE_SAVEPOINT);
+
+		foreach(QString statement, statements_.at(i)){
+
+			int rows = 0;
+
+			if(!exec(statement, &rows))
+				return abandon(savepoint, openedTransaction, AMDBMIGRATION_STATEMENT_FAILED);
+
+			rowsAffected_ += rows;
+		}
+
+		if(!exec(QString("RELEASE SAVEPOINT %1").arg(savepoint)))
+			return abandon(savepoint, openedTransaction, AMDBMIGRATION_COULD_NOT_RELEASE_SAVEPOINT);
+	}
+
+	if(openedTransaction && !database_->commitTransaction()){
+
+		database_->rollbackTransaction();
+		lastError_ = QString("Could not commit the migration to the '%1' database.").arg(database_->connectionName());
+		AMErrorMon::alert(this, AMDBMIGRATION_COULD_NOT_COMMIT_TRANSACTION, lastError_);
+		return false;
+	}
+
+	elapsedMs_ = timer.elapsed();
+	emit progressChanged(stepCount(), stepCount(), "Finished");
+
+	return true;
+}
+
+QString AMDbMigration::quoted(const QString &value)
+{
+	QString escaped = value;
+	escaped.replace("'", "''");
+	return QString("'%1'").arg(escaped);
+}
+
+bool AMDbMigration::exec(const QString &statement, int *rowsAffected)
+{
+	QSqlQuery query = database_->query();
+
+	if(!query.prepare(statement) || !AMDatabase::execQuery(query)){
+
+		lastError_ = QString("'%1' failed: %2").arg(statement).arg(query.lastError().text());
+		query.finish();
+		return false;
+	}
+
+	if(rowsAffected)
+		*rowsAffected = qMax(0, query.numRowsAffected());
+
+	query.finish();
+	return true;
+}
+
+bool AMDbMigration::abandon(const QString &savepoint, bool openedTransaction, int errorCode)
+{
+	QString failure = lastError_;
+
+	if(!savepoint.isEmpty()){
+
+		exec(QString("ROLLBACK TO SAVEPOINT %1").arg(savepoint));
+		exec(QString("RELEASE SAVEPOINT %1").arg(savepoint));
+	}
+
+	if(openedTransaction)
+		database_->rollbackTransaction();
+
+	lastError_ = failure;
+	AMErrorMon::alert(this, errorCode, QString("Database migration on '%1' was rolled back: %2").arg(database_->connectionName()).arg(lastError_));
+
+	return false;
+}
@@ -0,0 +1,98 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMDBMIGRATION_H
+#define AMDBMIGRATION_H
+
+#include <QObject>
+#include <QStringList>
+
+class AMDatabase;
+
+#define AMDBMIGRATION_COULD_NOT_START_TRANSACTION 450201
+#define AMDBMIGRATION_COULD_NOT_CREATE_SAVEPOINT 450202
+#define AMDBMIGRATION_STATEMENT_FAILED 450203
+#define AMDBMIGRATION_COULD_NOT_RELEASE_SAVEPOINT 450204
+#define AMDBMIGRATION_COULD_NOT_COMMIT_TRANSACTION 450205
+
+/// This class runs a database migration (ex: the work of an AMDbUpgrade) as a list of set-based SQL steps, all within one transaction.
+/*! A step is a short description and one or more SQL statements.  Statements should work on whole sets of rows at once (UPDATE ... WHERE, INSERT ... SELECT, DELETE ... WHERE, ALTER TABLE) rather than one row at a time: a class rename that used to cost one AMDatabase::update() per row becomes a single UPDATE, which SQLite can do for hundreds of thousands of rows in well under a second.
+
+run() opens a transaction (unless one is already open on this connection, in which case the migration becomes part of it), and wraps each step in its own savepoint.  If any statement fails, the step is rolled back to its savepoint, and then the whole migration is rolled back if run() opened the transaction.  Either every step is applied or none are.
+
+progressChanged() is emitted before each step and once at the end, so that a long migration can be followed (ex: on the startup splash screen, through AMDbUpgrade::progressChanged()).
+*/
+class AMDbMigration : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Creates an empty migration for \c database.
+	explicit AMDbMigration(AMDatabase *database, QObject *parent = 0);
+
+	/// The database this migration applies to.
+	AMDatabase* database() const { return database_; }
+
+	/// Adds a step made of several statements, run in order.
+	void addStep(const QString &description, const QStringList &statements);
+	/// Adds a step made of a single statement.
+	void addStep(const QString &description, const QString &statement);
+	/// Removes all the steps.
+	void clear();
+
+	/// The number of steps.
+	int stepCount() const { return descriptions_.count(); }
+	/// The description of step \c index.
+	QString stepDescription(int index) const { return descriptions_.at(index); }
+	/// The statements of step \c index.
+	QStringList stepStatements(int index) const { return statements_.at(index); }
+
+	/// Runs all the steps within one transaction.  Returns false (and leaves the database unchanged) if any statement fails.
+	bool run();
+
+	/// The total number of rows changed by the last run().
+	int rowsAffected() const { return rowsAffected_; }
+	/// How long the last run() took, in ms.
+	int elapsedMs() const { return elapsedMs_; }
+	/// Describes what went wrong in the last run(), or an empty string if it succeeded.
+	QString lastError() const { return lastError_; }
+
+	/// Quotes \c value as an SQL string literal.
+	static QString quoted(const QString &value);
+
+signals:
+	/// Emitted before step \c completedSteps starts (with its \c description), and once more with \c completedSteps == \c totalSteps when the migration finishes successfully.
+	void progressChanged(int completedSteps, int totalSteps, const QString &description);
+
+protected:
+	/// Runs \c statement on this thread's connection.  Returns false and records the error on failure.
+	bool exec(const QString &statement, int *rowsAffected = 0);
+	/// Ends a failed run: rolls back to \c savepoint, and the whole transaction if we opened it.  Always returns false.
+	bool abandon(const QString &savepoint, bool openedTransaction, int errorCode);
+
+	AMDatabase *database_;
+	QStringList descriptions_;
+	QList<QStringList> statements_;
+
+	int rowsAffected_;
+	int elapsedMs_;
+	QString lastError_;
+};
+
+#endif // AMDBMIGRATION_H
@@ -348,7 +348,7 @@ bool AMDbObject::storeToDb(AMDatabase* db, bool generateThumbnails) {
 			setModified(false);
 			//qdebug() << "Finished save of " << myInfo->className << "in" << saveTime.elapsed() << "ms; transaction committed.";
 			if(shouldGenerateThumbnailsInSeparateThread() && generateThumbnails && thumbnailCount() > 0) {
-				QtConcurrent::run(&AMDbObject::updateThumbnailsInSeparateThread, db, id_, myInfo->tableName, neverSavedHere);
+				startThumbnailsInSeparateThread(db, myInfo->tableName, neverSavedHere);
 			}
 			return true;
 		}
@@ -364,7 +364,7 @@ bool AMDbObject::storeToDb(AMDatabase* db, bool generateThumbnails) {
 		// we were just stored to the database, so our properties must be in sync with it.
 		setModified(false);
 		if(shouldGenerateThumbnailsInSeparateThread() && generateThumbnails && thumbnailCount() > 0) {
-			QtConcurrent::run(&AMDbObject::updateThumbnailsInSeparateThread, db, id_, myInfo->tableName, neverSavedHere);
+			startThumbnailsInSeparateThread(db, myInfo->tableName, neverSavedHere);
 		}
 		return true;
 	}
@@ -640,6 +640,24 @@ void AMDbObject::updateThumbnailsInSeparateThread(AMDatabase *db, int id, const
 	delete object;
 }
 
+void AMDbObject::generateThumbnailsInSeparateThread(AMDbThumbnailGenerator *generator, AMDatabase *db, int id, const QString &dbTableName, bool neverSavedHereBefore)
+{
+	QList<AMDbThumbnail> thumbnails = generator->generateThumbnails();
+	delete generator;
+
+	QCoreApplication::postEvent(AMDbObjectSupport::s(), new AMDbThumbnailsGeneratedEvent(thumbnails, db, dbTableName, id, neverSavedHereBefore));
+}
+
+void AMDbObject::startThumbnailsInSeparateThread(AMDatabase *db, const QString &dbTableName, bool neverSavedHereBefore) const
+{
+	AMDbThumbnailGenerator* generator = createThumbnailGenerator();
+
+	if(generator)
+		QtConcurrent::run(&AMDbObject::generateThumbnailsInSeparateThread, generator, db, id_, dbTableName, neverSavedHereBefore);
+	else
+		QtConcurrent::run(&AMDbObject::updateThumbnailsInSeparateThread, db, id_, dbTableName, neverSavedHereBefore);
+}
+
 void AMDbObject::updateThumbnailsInCurrentThread(bool neverSavedHereBefore)
 {
 	QString databaseTableName = dbTableName();
@@ -90,6 +90,16 @@ public:
 	bool neverSavedHereBefore;
 };
 
+/// This class makes an object's thumbnails in another thread, from data copied out of the object beforehand.
+/*! AMDbObject::createThumbnailGenerator() creates one in the object's own thread, copying whatever it needs to draw the thumbnails.  generateThumbnails() is then called once from a worker thread, so it must not touch the original object (or anything else owned by another thread).  The generator is deleted in the worker thread afterwards. */
+class AMDbThumbnailGenerator {
+public:
+	/// Destructor
+	virtual ~AMDbThumbnailGenerator() {}
+	/// Makes all of the thumbnails.  Called from a worker thread.
+	virtual QList<AMDbThumbnail> generateThumbnails() = 0;
+};
+
 class AMDbObjectInfo;
 class AMDbLoadErrorInfo;
 
@@ -346,8 +356,10 @@ public:
 	}
 	/// Overload this to indicate that it is safe to (and the database system should) generate thumbnails in a separate thread after a storeToDb(). By default, this is disabled and there is no imposed requirement that database classes be thread-safe or reentrant.
 	/*! Some database objects could take a long time to generate thumbnails; for performance, they might want to do this in another thread. Theferfore, the storeToDb() process can save the object without thumbnails, and then instruct it to be re-loaded in another thread to actually generate and store the thumbnails. However, it should only do that if the object's loadFromDb(), thumbnail(), and thumbnailCount() functions are full re-entrant; otherwise, this might be unsafe.
-This virtual function should return true for AMDbObject classes where it is both safe and desirable to generate thumbnails in another thread. */
+This virtual function should return true for AMDbObject classes where it is both safe and desirable to generate thumbnails in another thread.  Classes that can't be re-loaded safely in another thread should also implement createThumbnailGenerator(). */
 	virtual bool shouldGenerateThumbnailsInSeparateThread() const { return false; }
+	/// Overload this to generate the thumbnails in a separate thread from a copy of the object's data, instead of re-loading the object there.  Called in the object's thread after storeToDb(), when shouldGenerateThumbnailsInSeparateThread() is true.  The default returns 0, which means the object is re-loaded.  The database system takes ownership of the generator.
+	virtual AMDbThumbnailGenerator* createThumbnailGenerator() const { return 0; }
 
 	QMap<QString, AMDbLoadErrorInfo*> loadingErrors() const;
 
@@ -399,6 +411,10 @@ private:
 	/// This is a static helper function that will run in another thread to reload the object, generate, and save thumbnails after a db object is saved with storeToDb().
 	/*! \c neverSavedHereBefore is an optimization for when we know there are no existing thumbnails.*/
 	static void updateThumbnailsInSeparateThread(AMDatabase* db, int id, const QString& dbTableName, bool neverSavedHereBefore);
+	/// This is a static helper function that will run in another thread to generate thumbnails with \c generator (see createThumbnailGenerator()), and pass them back to be saved.  It deletes \c generator.
+	static void generateThumbnailsInSeparateThread(AMDbThumbnailGenerator* generator, AMDatabase* db, int id, const QString& dbTableName, bool neverSavedHereBefore);
+	/// Starts generating the thumbnails in a separate thread, with createThumbnailGenerator() if there is one, or by re-loading the object otherwise.
+	void startThumbnailsInSeparateThread(AMDatabase* db, const QString& dbTableName, bool neverSavedHereBefore) const;
 	/// This is a helper function used by storeToDb() to save the thumanils, in the current thread. It should only be called after the object has been stored in the main table and has a valid id() and database(). \c neverSavedHereBefore is an optimization for when we know there are no existing thumbnails.
 	void updateThumbnailsInCurrentThread(bool neverSavedHereBefore);
 
@@ -35,6 +35,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QWriteLocker>
 #include <QThread>
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QMetaType>
 
 // fill the className, tableName, metaObject, columns, columnTypes, isVisible, isLoadable, and doNotReuseIds properties based on a prototype AMDbObject.
 AMDbObjectInfo::AMDbObjectInfo(AMDbObject* prototype) {
@@ -201,7 +203,7 @@ bool AMDbObjectSupport::registerClass(const QMetaObject* mo) {
 	bool success = true;
 	QSetIterator<AMDatabase*> iDatabases(registeredDatabases_);
 	while(iDatabases.hasNext()) {
-		success = success && getDatabaseReadyForClass(iDatabases.next(), newInfo);
+		success = success && getDatabaseReadyForClassIfChanged(iDatabases.next(), newInfo);
 	}
 
 	if(success) {
@@ -282,13 +284,25 @@ bool AMDbObjectSupport::registerDatabase(AMDatabase* db) {
 	db->createIndex(controlSetEntriesTableName(), "csiId");
 	/////////////////////////////////
 
+	// This table remembers what each class's schema looked like the last time it was made ready in this database, so that unchanged classes can skip the table introspection.  Read it all now, in one query.
+	QHash<QString, QString> fingerprints;
+	if(db->ensureTable(schemaFingerprintsTableName(), QString("className,fingerprint").split(','), QString("TEXT,TEXT").split(','))) {
+		QSqlQuery q = db->select(schemaFingerprintsTableName(), "className,fingerprint");
+		if(AMDatabase::execQuery(q)) {
+			while(q.next())
+				fingerprints.insert(q.value(0).toString(), q.value(1).toString());
+		}
+		q.finish();
+	}
+	schemaFingerprints_.insert(db, fingerprints);
+
 	/// \todo error checking on creating these previous tables.
 
 
 	// Retro-actively add all previously registered classes.
 	bool success = true;
 	foreach(const AMDbObjectInfo& dbo, registeredClassesInOrder_) {
-		success = success && getDatabaseReadyForClass(db, dbo);
+		success = success && getDatabaseReadyForClassIfChanged(db, dbo);
 	}
 
 	if(success) {
@@ -302,6 +316,54 @@ bool AMDbObjectSupport::registerDatabase(AMDatabase* db) {
 	}
 }
 
+bool AMDbObjectSupport::getDatabaseReadyForClassIfChanged(AMDatabase* db, const AMDbObjectInfo& info) {
+
+	QString fingerprint = schemaFingerprint(info);
+	QHash<QString, QString>& fingerprints = schemaFingerprints_[db];
+
+	if(fingerprints.value(info.className) == fingerprint)
+		return true;
+
+	if(!getDatabaseReadyForClass(db, info))
+		return false;
+
+	// Remember this schema for next time.  If this fails, the class will simply be fully checked again next time.
+	db->deleteRows(schemaFingerprintsTableName(), QString("className = '%1'").arg(info.className));
+	if(db->insertOrUpdate(0, schemaFingerprintsTableName(), QString("className,fingerprint").split(','), QVariantList() << info.className << fingerprint))
+		fingerprints.insert(info.className, fingerprint);
+
+	return true;
+}
+
+QString AMDbObjectSupport::schemaFingerprint(const AMDbObjectInfo& info) {
+
+	// Everything that getDatabaseReadyForClass() looks at. Column types are recorded by name, because the ids of custom meta-types depend on their registration order.
+	QStringList parts;
+	parts << "1" << info.className << info.tableName << QString::number(info.version) << QString::number(info.sharedTable) << QString::number(info.doNotReuseIds);
+
+	const QMetaObject* mo = info.metaObject;
+	while(mo) {
+		parts << mo->className();
+		mo = mo->superClass();
+	}
+
+	for(int i=0; i<info.columns.count(); i++)
+		parts << QString("%1:%2:%3%4%5").arg(info.columns.at(i)).arg(QMetaType::typeName(info.columnTypes.at(i))).arg(int(info.isIndexed.at(i))).arg(int(info.isVisible.at(i))).arg(int(info.isLoadable.at(i)));
+
+	return QString(QCryptographicHash::hash(parts.join("|").toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+void AMDbObjectSupport::clearSchemaFingerprints(AMDatabase* db) {
+
+	if(db && db->tableExists(schemaFingerprintsTableName()))
+		db->deleteRows(schemaFingerprintsTableName(), "1");
+
+	AMDbObjectSupport* support = s();
+	QWriteLocker wl(&support->registryMutex_);
+	if(support->schemaFingerprints_.contains(db))
+		support->schemaFingerprints_[db].clear();
+}
+
 #include <QDebug>
 bool AMDbObjectSupport::getDatabaseReadyForClass(AMDatabase* db, const AMDbObjectInfo& info) {
 
@@ -666,6 +728,7 @@ QString AMDbObjectSupport::allColumnsTableName() { return "AMDbObjectTypes_allCo
 QString AMDbObjectSupport::visibleColumnsTableName() { return "AMDbObjectTypes_visibleColumns"; }
 QString AMDbObjectSupport::loadColumnsTableName() { return "AMDbObjectTypes_loadColumns"; }
 QString AMDbObjectSupport::upgradesTableName() { return "AMDbObjectUpgrades_table"; }
+QString AMDbObjectSupport::schemaFingerprintsTableName() { return "AMDbObjectSchemaFingerprints_table"; }
 
 
 bool AMDbObjectSupport::ensureTableForDbObjects(const QString& tableName, AMDatabase* db, bool reuseDeletedIds) {
@@ -795,6 +858,7 @@ void AMDbObjectSupport::onRegisteredDatabaseDeleted()
 		rl.unlock();
 		registryMutex_.lockForWrite();
 		registeredDatabases_.remove(db);
+		schemaFingerprints_.remove(db);
 		registryMutex_.unlock();
 	}
 }
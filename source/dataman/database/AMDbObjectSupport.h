@@ -211,6 +211,13 @@ public:
 	static QString visibleColumnsTableName();
 	static QString loadColumnsTableName();
 	static QString upgradesTableName();
+	/// name of the table that stores a fingerprint of the schema each class was last made ready with, in each database.  See getDatabaseReadyForClassIfChanged().
+	static QString schemaFingerprintsTableName();
+
+	/// Returns a fingerprint of everything about the class described by \c info that affects its database tables: its table name, columns, column types and attributes, and inheritance.  If this hasn't changed since a class was last made ready in a database, nothing needs to be checked again.
+	static QString schemaFingerprint(const AMDbObjectInfo& info);
+	/// Forgets the stored schema fingerprints in \c db, so that every class is fully checked the next time the database is registered.  Call this after making schema changes outside of AMDbObjectSupport (ex: in an AMDbUpgrade).
+	static void clearSchemaFingerprints(AMDatabase* db);
 
 
 	// Temporary tables (to be generalized?)
@@ -231,6 +238,8 @@ protected:
 
 	/// ensure that a database \c db is ready to hold objects of the class described by \c info. Will call initializeDatabaseForClass() or upgradeDatabaseForClass() if required.
 	static bool getDatabaseReadyForClass(AMDatabase* db, const AMDbObjectInfo& info);
+	/// Calls getDatabaseReadyForClass(), unless the schemaFingerprint() of the class matches the one stored the last time it was made ready in \c db.  On success, the new fingerprint is stored.  The caller must hold the registryMutex_ for writing.
+	bool getDatabaseReadyForClassIfChanged(AMDatabase* db, const AMDbObjectInfo& info);
 	/// Helper function: Creates table and columns for a class which has never been stored in the database before.
 	static bool initializeDatabaseForClass(AMDatabase* db, const AMDbObjectInfo& info);
 	/// Helper function: checks if a class can be stored in the database as-is, or if the DB needs to be upgraded.
@@ -262,6 +271,8 @@ private:
 	QList<AMDbObjectInfo> registeredClassesInOrder_;
 	/// A set of databases that have been registered so far (at runtime) with the database system
 	QSet<AMDatabase*> registeredDatabases_;
+	/// For each registered database, the stored schema fingerprints by class name.  These are read once when the database is registered, so that checking an unchanged class doesn't need any queries.
+	QHash<AMDatabase*, QHash<QString, QString> > schemaFingerprints_;
 
 	/// This is a singleton class, so the constructor is private.
 	AMDbObjectSupport() : QObject(), registryMutex_(QReadWriteLock::Recursive) {}
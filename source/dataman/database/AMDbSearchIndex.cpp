@@ -0,0 +1,387 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMDbSearchIndex.h"
+
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringBuilder>
+
+#include "dataman/database/AMDatabase.h"
+#include "util/AMErrorMonitor.h"
+
+/// The maximum number of ids written into one "IN (...)" list, to stay well within SQLite's statement length limit.
+#define AMDBSEARCHINDEX_IDS_PER_STATEMENT 500
+
+QHash<QString, AMDbSearchIndex*> AMDbSearchIndex::registry_;
+
+AMDbSearchIndex* AMDbSearchIndex::createSearchIndex(AMDatabase *database, const QString &tableName, const QStringList &columnNames)
+{
+	if(!database || tableName.isEmpty() || columnNames.isEmpty())
+		return 0;
+
+	QString key = database->connectionName() % "/" % tableName;
+
+	if(registry_.contains(key))
+		return 0;
+
+	AMDbSearchIndex *index = new AMDbSearchIndex(database, tableName, columnNames);
+	registry_.insert(key, index);
+	return index;
+}
+
+AMDbSearchIndex* AMDbSearchIndex::searchIndex(AMDatabase *database, const QString &tableName)
+{
+	if(!database)
+		return 0;
+
+	return registry_.value(database->connectionName() % "/" % tableName, 0);
+}
+
+void AMDbSearchIndex::releaseSearchIndexes()
+{
+	foreach(AMDbSearchIndex *index, registry_)
+		index->flush();
+
+	qDeleteAll(registry_);
+	registry_.clear();
+}
+
+AMDbSearchIndex::AMDbSearchIndex(AMDatabase *database, const QString &tableName, const QStringList &columnNames, QObject *parent) :
+	QObject(parent)
+{
+	database_ = database;
+	tableName_ = tableName;
+	columnNames_ = columnNames;
+	isValid_ = false;
+	rebuildRequired_ = false;
+
+	connect(&flushFunctionCall_, SIGNAL(executed()), this, SLOT(flush()));
+}
+
+void AMDbSearchIndex::addRelatedColumn(const QString &foreignKeyColumnName, const QString &relatedTableName, const QString &relatedColumnName)
+{
+	if(isValid_)
+		return;
+
+	RelatedColumn related;
+	related.foreignKeyColumnName = foreignKeyColumnName;
+	related.relatedTableName = relatedTableName;
+	related.relatedColumnName = relatedColumnName;
+	relatedColumns_ << related;
+}
+
+bool AMDbSearchIndex::initialize()
+{
+	if(isValid_)
+		return true;
+
+	QStringList indexColumnNames = columnNames_;
+	foreach(RelatedColumn related, relatedColumns_)
+		indexColumnNames << related.foreignKeyColumnName % "_" % related.relatedColumnName;
+
+	// If the set of indexed columns has changed since the search table was created, start over with a new one.
+	bool needsRebuild = !database_->tableExists(searchTableName());
+
+	if(!needsRebuild) {
+
+		QSqlQuery q = database_->query();
+		q.prepare(QString("PRAGMA table_info(%1);").arg(searchTableName()));
+		AMDatabase::execQuery(q);
+
+		QStringList existingColumnNames;
+		while(q.next())
+			existingColumnNames << q.value(1).toString();
+		q.finish();
+
+		if(existingColumnNames != indexColumnNames) {
+
+			QSqlQuery drop = database_->query();
+			drop.prepare(QString("DROP TABLE %1").arg(searchTableName()));
+			AMDatabase::execQuery(drop);
+			drop.finish();
+			needsRebuild = true;
+		}
+	}
+
+	isValid_ = database_->ensureSearchTable(searchTableName(), indexColumnNames);
+
+	if(!isValid_)
+		return false;
+
+	// Rows inserted or removed with raw SQL (ex: by an import or upgrade) don't emit signals; catch them here by comparing row counts.
+	if(!needsRebuild) {
+
+		QSqlQuery q = database_->query();
+		q.prepare(QString("SELECT (SELECT COUNT(1) FROM %1), (SELECT COUNT(1) FROM %2)").arg(tableName_).arg(searchTableName()));
+
+		if(AMDatabase::execQuery(q) && q.first())
+			needsRebuild = (q.value(0).toInt() != q.value(1).toInt());
+		else
+			needsRebuild = true;
+
+		q.finish();
+	}
+
+	if(needsRebuild)
+		rebuild();
+
+	connect(database_, SIGNAL(created(QString,int)), this, SLOT(onDatabaseItemCreatedOrUpdated(QString,int)), Qt::QueuedConnection);
+	connect(database_, SIGNAL(updated(QString,int)), this, SLOT(onDatabaseItemCreatedOrUpdated(QString,int)), Qt::QueuedConnection);
+	connect(database_, SIGNAL(removed(QString,int)), this, SLOT(onDatabaseItemRemoved(QString,int)), Qt::QueuedConnection);
+
+	return true;
+}
+
+QList<int> AMDbSearchIndex::search(const QString &searchText, int limit)
+{
+	if(!isValid_)
+		return QList<int>();
+
+	flush();
+	return database_->searchObjects(searchTableName(), searchText, limit);
+}
+
+QString AMDbSearchIndex::whereClause(const QString &searchText)
+{
+	QString expression = AMDatabase::searchExpression(searchText);
+
+	if(!isValid_ || expression.isEmpty())
+		return QString();
+
+	flush();
+
+	// The expression only contains word characters, spaces, quotes and asterisks, so it is safe to put inside single quotes.
+	return QString("id IN (SELECT docid FROM %1 WHERE %1 MATCH '%2')").arg(searchTableName()).arg(expression);
+}
+
+void AMDbSearchIndex::flush()
+{
+	flushFunctionCall_.unschedule();
+
+	if(!isValid_) {
+
+		pendingUpdates_.clear();
+		pendingRemovals_.clear();
+		return;
+	}
+
+	if(rebuildRequired_) {
+
+		rebuild();
+		return;
+	}
+
+	if(pendingUpdates_.isEmpty() && pendingRemovals_.isEmpty())
+		return;
+
+	// Every changed id is removed from the index, and the ones that still exist are inserted again.
+	QList<int> changedIds = (pendingUpdates_ + pendingRemovals_).toList();
+	QList<int> updatedIds = pendingUpdates_.toList();
+	pendingUpdates_.clear();
+	pendingRemovals_.clear();
+
+	bool openedTransaction = false;
+
+	if(database_->supportsTransactions() && !database_->transactionInProgress())
+		openedTransaction = database_->startTransaction();
+
+	bool success = true;
+
+	for(int start = 0, count = changedIds.count(); start < count; start += AMDBSEARCHINDEX_IDS_PER_STATEMENT) {
+
+		QStringList ids;
+		for(int i = start, end = qMin(count, start + AMDBSEARCHINDEX_IDS_PER_STATEMENT); i < end; i++)
+			ids << QString::number(changedIds.at(i));
+
+		QSqlQuery q = database_->query();
+		q.prepare(QString("DELETE FROM %1 WHERE docid IN (%2)").arg(searchTableName()).arg(ids.join(",")));
+		success &= AMDatabase::execQuery(q);
+		q.finish();
+	}
+
+	for(int start = 0, count = updatedIds.count(); start < count; start += AMDBSEARCHINDEX_IDS_PER_STATEMENT) {
+
+		QStringList ids;
+		for(int i = start, end = qMin(count, start + AMDBSEARCHINDEX_IDS_PER_STATEMENT); i < end; i++)
+			ids << QString::number(updatedIds.at(i));
+
+		QSqlQuery q = database_->query();
+		q.prepare(insertStatement(QString("%1.id IN (%2)").arg(tableName_).arg(ids.join(","))));
+		success &= AMDatabase::execQuery(q);
+		q.finish();
+	}
+
+	if(openedTransaction) {
+
+		if(success)
+			success = database_->commitTransaction();
+		else
+			database_->rollbackTransaction();
+	}
+
+	// The index is now out of step with the table; the safest recovery is to rebuild it next time.
+	if(!success) {
+
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Debug, AMDBSEARCHINDEX_CANNOT_UPDATE_INDEX, QString("Could not update the search index for %1 changed rows in '%2'. It will be rebuilt.").arg(changedIds.count()).arg(tableName_)));
+		rebuildRequired_ = true;
+		flushFunctionCall_.schedule();
+	}
+}
+
+bool AMDbSearchIndex::rebuild()
+{
+	flushFunctionCall_.unschedule();
+
+	if(!isValid_)
+		return false;
+
+	pendingUpdates_.clear();
+	pendingRemovals_.clear();
+	rebuildRequired_ = false;
+
+	bool openedTransaction = false;
+
+	if(database_->supportsTransactions() && !database_->transactionInProgress())
+		openedTransaction = database_->startTransaction();
+
+	QSqlQuery clear = database_->query();
+	clear.prepare(QString("DELETE FROM %1").arg(searchTableName()));
+	bool success = AMDatabase::execQuery(clear);
+	clear.finish();
+
+	QSqlQuery fill = database_->query();
+	fill.prepare(insertStatement());
+	success &= AMDatabase::execQuery(fill);
+	QString error = fill.lastError().text();
+	fill.finish();
+
+	if(openedTransaction) {
+
+		if(success)
+			success = database_->commitTransaction();
+		else
+			database_->rollbackTransaction();
+	}
+
+	if(!success)
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, AMDBSEARCHINDEX_CANNOT_REBUILD_INDEX, QString("Could not rebuild the search index for '%1'. Searching may not find all of your data. The SQL reply was: %2").arg(tableName_).arg(error)));
+
+	return success;
+}
+
+void AMDbSearchIndex::onDatabaseItemCreatedOrUpdated(const QString &tableName, int id)
+{
+	if(tableName == tableName_) {
+
+		if(id < 0)
+			rebuildRequired_ = true;
+		else
+			pendingUpdates_ << id;
+
+		flushFunctionCall_.schedule();
+	}
+
+	else {
+
+		foreach(RelatedColumn related, relatedColumns_)
+			if(related.relatedTableName == tableName)
+				queueRowsReferringTo(related.foreignKeyColumnName, id);
+	}
+}
+
+void AMDbSearchIndex::onDatabaseItemRemoved(const QString &tableName, int id)
+{
+	if(tableName == tableName_) {
+
+		// An id of -1 means that several rows were removed at once.
+		if(id < 0)
+			rebuildRequired_ = true;
+
+		else {
+
+			pendingUpdates_.remove(id);
+			pendingRemovals_ << id;
+		}
+
+		flushFunctionCall_.schedule();
+	}
+
+	else {
+
+		foreach(RelatedColumn related, relatedColumns_)
+			if(related.relatedTableName == tableName)
+				queueRowsReferringTo(related.foreignKeyColumnName, id);
+	}
+}
+
+void AMDbSearchIndex::queueRowsReferringTo(const QString &foreignKeyColumnName, int relatedId)
+{
+	if(relatedId < 0) {
+
+		rebuildRequired_ = true;
+		flushFunctionCall_.schedule();
+		return;
+	}
+
+	QList<int> ids = database_->objectsWhere(tableName_, QString("%1 = %2").arg(foreignKeyColumnName).arg(relatedId));
+
+	if(ids.isEmpty())
+		return;
+
+	foreach(int id, ids)
+		pendingUpdates_ << id;
+
+	flushFunctionCall_.schedule();
+}
+
+QString AMDbSearchIndex::insertStatement(const QString &whereClause) const
+{
+	QStringList indexColumnNames;
+	QStringList sourceColumns;
+	QStringList joins;
+
+	sourceColumns << tableName_ % ".id";
+
+	foreach(QString columnName, columnNames_) {
+
+		indexColumnNames << columnName;
+		sourceColumns << tableName_ % "." % columnName;
+	}
+
+	for(int i = 0, count = relatedColumns_.count(); i < count; i++) {
+
+		const RelatedColumn &related = relatedColumns_.at(i);
+		QString alias = QString("related%1").arg(i);
+
+		indexColumnNames << related.foreignKeyColumnName % "_" % related.relatedColumnName;
+		sourceColumns << alias % "." % related.relatedColumnName;
+		joins << QString("LEFT JOIN %1 AS %2 ON %2.id = %3.%4").arg(related.relatedTableName).arg(alias).arg(tableName_).arg(related.foreignKeyColumnName);
+	}
+
+	QString statement = QString("INSERT INTO %1(docid, %2) SELECT %3 FROM %4").arg(searchTableName()).arg(indexColumnNames.join(", ")).arg(sourceColumns.join(", ")).arg(tableName_);
+
+	if(!joins.isEmpty())
+		statement.append(" ").append(joins.join(" "));
+
+	if(!whereClause.isEmpty())
+		statement.append(" WHERE ").append(whereClause);
+
+	return statement;
+}
@@ -0,0 +1,132 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMDBSEARCHINDEX_H
+#define AMDBSEARCHINDEX_H
+
+#include <QObject>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+
+#include "util/AMDeferredFunctionCall.h"
+
+class AMDatabase;
+
+#define AMDBSEARCHINDEX_CANNOT_UPDATE_INDEX -3201
+#define AMDBSEARCHINDEX_CANNOT_REBUILD_INDEX -3202
+
+/// This class keeps a full-text search table up to date alongside a regular database table (ex: the AMScan table), so that the table can be searched by words without scanning every row.
+/*! The search table is called tableName() + "_fts", and has one row per row in the indexed table, with the same id (its docid).  It holds a copy of the indexed columns (ex: name and notes), plus any related columns added with addRelatedColumn() (ex: the name of a scan's sample, found in the sample table through the scan's sampleId).
+
+The index is kept current from the database's created(), updated() and removed() signals: changed ids are collected and written in one transaction when control returns to the event loop, or when search() is called.  Changes made with raw SQL queries don't emit these signals; call rebuild() after them.  The index is also rebuilt automatically when it is first created, or when its row count no longer matches the indexed table.
+
+Search indexes are kept in a registry, like AMDatabase instances: create them with createSearchIndex(), and find them later with searchIndex().  They should be created and used from the main thread.
+
+If the SQLite library doesn't support full-text search, isValid() is false and search() returns nothing; callers should fall back to AMDatabase::objectsContaining().
+*/
+class AMDbSearchIndex : public QObject
+{
+	Q_OBJECT
+
+public:
+	// Registry functions
+	/////////////////////////
+
+	/// Creates a search index on the \c columnNames of \c tableName in \c database, and registers it.  Returns 0 if there is already an index for that table.  Use addRelatedColumn() to include columns from other tables, and then call initialize().
+	static AMDbSearchIndex* createSearchIndex(AMDatabase *database, const QString &tableName, const QStringList &columnNames);
+	/// Returns the search index registered for \c tableName in \c database, or 0 if there isn't one.
+	static AMDbSearchIndex* searchIndex(AMDatabase *database, const QString &tableName);
+	/// Deletes all the registered search indexes.  Call this at shutdown, before the databases are deleted.
+	static void releaseSearchIndexes();
+
+	// Setup
+	/////////////////////////
+
+	/// Also indexes \c relatedColumnName from \c relatedTableName, for the row whose id is stored in our table's \c foreignKeyColumnName.  Must be called before initialize().
+	void addRelatedColumn(const QString &foreignKeyColumnName, const QString &relatedTableName, const QString &relatedColumnName);
+	/// Creates the search table if required, and rebuilds it if it is new or out of date.  Returns false (and isValid() stays false) if full-text search isn't available.
+	bool initialize();
+
+	/// Returns true once the search table has been created successfully by initialize().
+	bool isValid() const { return isValid_; }
+
+	/// The database containing the indexed table
+	AMDatabase* database() const { return database_; }
+	/// The name of the indexed table
+	QString tableName() const { return tableName_; }
+	/// The name of the full-text search table
+	QString searchTableName() const { return tableName_ + "_fts"; }
+
+	// Searching
+	/////////////////////////
+
+	/// Returns the ids of all the rows in tableName() containing every word of \c searchText (as whole words or prefixes), best matches first.  See AMDatabase::searchObjects().  Any pending changes are written first.
+	QList<int> search(const QString &searchText, int limit = -1);
+	/// Returns an SQL condition (suitable for appending after "WHERE") that selects the rows of tableName() matching \c searchText, for combining with other conditions.  Returns an empty string if \c searchText has no words.  Any pending changes are written first.
+	QString whereClause(const QString &searchText);
+
+public slots:
+	/// Writes all the pending changes to the search table, in one transaction.
+	void flush();
+	/// Re-creates the contents of the search table from scratch, in one transaction.  Returns false if it could not be done.
+	bool rebuild();
+
+protected slots:
+	/// Queues the changed row \c id for re-indexing, or the rows that refer to it in a related table.
+	void onDatabaseItemCreatedOrUpdated(const QString &tableName, int id);
+	/// Queues the removed row \c id for removal from the index, or the rows that refer to it in a related table for re-indexing.
+	void onDatabaseItemRemoved(const QString &tableName, int id);
+
+protected:
+	/// Protected constructor: use createSearchIndex().
+	AMDbSearchIndex(AMDatabase *database, const QString &tableName, const QStringList &columnNames, QObject *parent = 0);
+
+	/// Queues the rows of our table whose \c foreignKeyColumnName is \c relatedId for re-indexing.
+	void queueRowsReferringTo(const QString &foreignKeyColumnName, int relatedId);
+	/// Returns the INSERT ... SELECT statement that copies the indexed columns of the rows matching \c whereClause (or all rows, if \c whereClause is empty) into the search table.
+	QString insertStatement(const QString &whereClause = QString()) const;
+
+	/// A column from another table included in the index.
+	struct RelatedColumn {
+		QString foreignKeyColumnName;
+		QString relatedTableName;
+		QString relatedColumnName;
+	};
+
+	AMDatabase *database_;
+	QString tableName_;
+	QStringList columnNames_;
+	QList<RelatedColumn> relatedColumns_;
+	bool isValid_;
+
+	/// Ids that were created or updated since the last flush().
+	QSet<int> pendingUpdates_;
+	/// Ids that were removed since the last flush().
+	QSet<int> pendingRemovals_;
+	/// Set when the database asks for a whole refresh (an updated() signal with an id of -1).
+	bool rebuildRequired_;
+	/// Used to flush() when control returns to the event loop.
+	AMDeferredFunctionCall flushFunctionCall_;
+
+	/// The registered search indexes, by database connection name and table name.
+	static QHash<QString, AMDbSearchIndex*> registry_;
+};
+
+#endif // AMDBSEARCHINDEX_H
@@ -22,6 +22,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDateTime>
 #include <QStringBuilder>
 #include "dataman/database/AMDbObjectSupport.h"
+#include "dataman/database/AMDbMigration.h"
 
 #include "util/AMErrorMonitor.h"
 
@@ -46,7 +47,12 @@ bool AMDbUpgrade::upgrade(){
 		}
 	}
 	// If so, call and return the specific upgradeImplementation for the subclass
-	return upgradeImplementation();
+	bool success = upgradeImplementation();
+
+	// The upgrade changes tables directly, so every class needs to be fully checked when this database is registered.  (Also after a failure, which may have left partial changes.)
+	AMDbObjectSupport::clearSchemaFingerprints(databaseToUpgrade_);
+
+	return success;
 }
 
 bool AMDbUpgrade::updateUpgradeTable(bool isNecessary, bool duringCreation){
@@ -139,199 +145,142 @@ void AMDbUpgrade::setIsResponsibleForUpgrade(bool isResponsibleForUpgrade){
 	isResponsibleForUpgrade_ = isResponsibleForUpgrade;
 }
 
+bool AMDbUpgrade::runMigration(AMDbMigration *migration){
+	connect(migration, SIGNAL(progressChanged(int,int,QString)), this, SIGNAL(progressChanged(int,int,QString)));
+	bool success = migration->run();
+	disconnect(migration, SIGNAL(progressChanged(int,int,QString)), this, SIGNAL(progressChanged(int,int,QString)));
+
+	if(success)
+		AMErrorMon::debug(this, -270104, QString("Database upgrade %1: %2 steps changed %3 rows in %4 ms.").arg(upgradeToTag()).arg(migration->stepCount()).arg(migration->rowsAffected()).arg(migration->elapsedMs()));
+
+	return success;
+}
+
 bool AMDbUpgradeSupport::dbObjectClassBecomes(AMDatabase *databaseToEdit, const QString &originalClassName, const QString &newClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide){
-	AMDatabase *userDb = databaseToEdit;
+	AMDbMigration migration(databaseToEdit);
+	if(!appendDbObjectClassBecomesSteps(&migration, originalClassName, newClassName, parentTablesToColumnNames, indexTablesToIndexSide))
+		return false;
 
-	QString originalTableName = originalClassName%"_table";
-	QString newTableName = newClassName%"_table";
+	return migration.run();
+}
 
-	QList<int> matchingOriginial;
-	QList<int> matchingNew;
+bool AMDbUpgradeSupport::dbObjectClassMerge(AMDatabase *databaseToEdit, const QString &mergeToClassName, const QString &mergeFromClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide){
+	AMDbMigration migration(databaseToEdit);
+	if(!appendDbObjectClassMergeSteps(&migration, mergeToClassName, mergeFromClassName, parentTablesToColumnNames, indexTablesToIndexSide))
+		return false;
+
+	return migration.run();
+}
 
-	// Find the number of objects matching the original and new class names in the AMDbObjectTypes table
-	matchingOriginial = userDb->objectsMatching("AMDbObjectTypes_table", "AMDbObjectType", originalClassName);
-	matchingNew = userDb->objectsMatching("AMDbObjectTypes_table", "AMDbObjectType", newClassName);
+bool AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(AMDbMigration *migration, const QString &originalClassName, const QString &newClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide){
+	AMDatabase *userDb = migration->database();
+
+	QString originalTableName = originalClassName%"_table";
+	QString newTableName = newClassName%"_table";
 
+	// Find the objects matching the original and new class names in the AMDbObjectTypes table
+	QList<int> matchingOriginial = userDb->objectsMatching("AMDbObjectTypes_table", "AMDbObjectType", originalClassName);
+	int matchingNewCount = userDb->objectsMatching("AMDbObjectTypes_table", "AMDbObjectType", newClassName).count();
 
-	// If they're both non-zero, then roll the database back by converting all of the "new" side instances to "original" side instances by using the classMerge function.
-	if(matchingOriginial.count() > 0 && matchingNew.count() > 0){
-		if(!dbObjectClassMerge(userDb, originalClassName, newClassName, parentTablesToColumnNames, indexTablesToIndexSide))
+	// If they're both non-zero, then roll the database back by converting all of the "new" side instances to "original" side instances.  The merge removes the new class from the AMDbObjectTypes table, so nothing will match it afterwards.
+	if(matchingOriginial.count() > 0 && matchingNewCount > 0){
+		if(!appendDbObjectClassMergeSteps(migration, originalClassName, newClassName, parentTablesToColumnNames, indexTablesToIndexSide))
 			return false;
 
-		matchingNew = userDb->objectsMatching("AMDbObjectTypes_table", "AMDbObjectType", newClassName);
+		matchingNewCount = 0;
 	}
 
-	// If there are no instances of the new class, then we can upgrade in this fashion
-	if(matchingOriginial.count() > 0 && matchingNew.count() == 0){
-		// Start the transaction, we can rollback to here if things go badly
-		userDb->startTransaction();
-
-		// Update the AMDbObjectTypes_table to replace the AMDbObjectType and table name with the new values
-		QStringList columnsToChange;
-		QVariantList changesToMake;
-		columnsToChange << "AMDbObjectType" << "tableName";
-		changesToMake << QVariant(newClassName) << QVariant(newTableName);
-		if(!userDb->update(matchingOriginial.at(0), "AMDbObjectTypes_table", columnsToChange, changesToMake)){
-			userDb->rollbackTransaction();
-			AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -270, QString("Database support: There was an error trying to update the AMDbObjectTypes table for (%1) to become %2.").arg(originalClassName).arg(newClassName)));
-			return false;
-		}
+	// If there are no instances of the original class then no upgrade is necessary.  If neither class name can be found, maybe they just aren't in this database.
+	if(matchingOriginial.count() == 0 || matchingNewCount > 0)
+		return true;
 
-		// Loop over all the parent tables to column names map values
-		QMap<QString, QString>::const_iterator j = parentTablesToColumnNames.constBegin();
-		while (j != parentTablesToColumnNames.constEnd()) {
-			// Grab the list of indices we're interested in and for all those indices update to the new class name while maintaining the original index value (format: table_name;index_value)
-			QList<int> parentTableIndices = userDb->objectsWhere(j.key(), QString("%1 LIKE '%2;%'").arg(j.value()).arg(originalTableName));
-			for(int x = 0; x < parentTableIndices.count(); x++){
-				QString indexStringToUse = userDb->retrieve(parentTableIndices.at(x), j.key(), j.value()).toString();
-				int indexToUse = indexStringToUse.split(';').at(1).toInt();
-				if(!userDb->update(parentTableIndices.at(x), j.key(), j.value(), QVariant(QString("%1;%2").arg(newTableName).arg(indexToUse)))){
-					userDb->rollbackTransaction();
-					AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -281, QString("Database support: There was an error trying to update the %1 column for %2 table at id %2.").arg(j.value()).arg(j.key()).arg(parentTableIndices.at(x))));
-					return false;
-				}
-			}
-			++j;
-		}
+	QString quotedOriginalTableName = AMDbMigration::quoted(originalTableName);
+	QString quotedNewTableName = AMDbMigration::quoted(newTableName);
 
-		// Loop over all the index table to column map values
-		QMap<QString, int>::const_iterator i = indexTablesToIndexSide.constBegin();
-		while (i != indexTablesToIndexSide.constEnd()) {
-			// Grab the list of indices we're interested in and for all those indices update to the new class name
-			QList<int> indexTableIndices = userDb->objectsWhere(i.key(), QString("table%1='%2'").arg(i.value()).arg(originalTableName));
-			for(int x = 0; x < indexTableIndices.count(); x++){
-				if(!userDb->update(indexTableIndices.at(x), i.key(), QString("table%1").arg(i.value()), QVariant(newTableName))){
-					userDb->rollbackTransaction();
-					AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -271, QString("Database support: There was an error trying to update the %1 table at id %2.").arg(i.key()).arg(indexTableIndices.at(x))));
-					return false;
-				}
-			}
+	// Update the AMDbObjectTypes_table to replace the AMDbObjectType and table name with the new values
+	migration->addStep(QString("Renaming %1 to %2").arg(originalClassName).arg(newClassName),
+			   QString("UPDATE AMDbObjectTypes_table SET AMDbObjectType=%1, tableName=%2 WHERE id=%3;").arg(AMDbMigration::quoted(newClassName)).arg(quotedNewTableName).arg(matchingOriginial.at(0)));
 
-			// If we're editing the left side (column 1) we need to update the name of the index table as well
-			//  (and possibly alter any indices associated with the table)
-			if(i.value() == 1 && i.key().contains(originalTableName)){
-				// Finally, rename the table from the original index table name to the new index table name
-				QString originalIndexTableName = i.key();
-				QString newIndexTableName = i.key();
-				newIndexTableName.remove(originalTableName);
-				newIndexTableName.prepend(newTableName);
-
-				// Query if this table has an index (or indices) defined for it
-				QSqlQuery q1 = userDb->query();
-				q1.prepare("PRAGMA index_list("%originalIndexTableName%")");
-				if(!AMDatabase::execQuery(q1)) {
-					q1.finish();
-					userDb->rollbackTransaction();
-					AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -291, QString("Database support: There was an error trying to find the index list for %1.").arg(originalIndexTableName)));
-					return false;
-				}
-				// Fill a stringList with the responses
-				QStringList indexListResponses;
-				while(q1.next()){
-					indexListResponses << q1.value(1).toString();
-				}
-				q1.finish();
+	// Parent tables store references as "table_name;index_value". Keep the index value and swap in the new table name, for every matching row at once.
+	QString originalPrefix = AMDbMigration::quoted(originalTableName%";");
+	int prefixLength = originalTableName.length()+1;
+	QMap<QString, QString>::const_iterator j = parentTablesToColumnNames.constBegin();
+	while (j != parentTablesToColumnNames.constEnd()) {
+		migration->addStep(QString("Updating %1 references in %2").arg(originalClassName).arg(j.key()),
+				   QString("UPDATE %1 SET %2 = %3 || substr(%2, %4) WHERE substr(%2, 1, %5) = %6;").arg(j.key()).arg(j.value()).arg(AMDbMigration::quoted(newTableName%";")).arg(prefixLength+1).arg(prefixLength).arg(originalPrefix));
+		++j;
+	}
 
-				// If there were any indices found, then loop over them and drop them from the database
-				for(int x = 0; x < indexListResponses.count(); x++){
-					QSqlQuery q1A = userDb->query();
-					q1A.prepare(QString("DROP INDEX %1;").arg(indexListResponses.at(x)));
-
-					if(AMDatabase::execQuery(q1A)){
-						q1A.finish();
-					}
-					else{
-						q1A.finish();
-						userDb->rollbackTransaction();
-						AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -292, QString("Database support: There was an error trying to drop the index %1 for %2.").arg(indexListResponses.at(x)).arg(originalIndexTableName)));
-						return false;
-					}
-				}
-
-				// Actually rename the table (we need to do this every time)
-				QSqlQuery q2 = userDb->query();
-				q2.prepare("ALTER table "%originalIndexTableName%" RENAME to "%newIndexTableName);
-				if(!AMDatabase::execQuery(q2)) {
-					q2.finish();
-					userDb->rollbackTransaction();
-					AMErrorMon::report(AMErrorReport(0, AMErrorReport::Debug, -283, QString("Database support: There was an error while trying to update table %1 to become %2.").arg(originalIndexTableName).arg(newIndexTableName)));
-					return false;
-				}
-
-				// If there were any indices found, then we need to re-add them using the new table name
-				for(int x = 0; x < indexListResponses.count(); x++){
-					QSqlQuery q2A = userDb->query();
-					QString tempIndexListResponse = indexListResponses.at(x);
-					QString columnName = tempIndexListResponse.split('_').last();
-					QString indexName = QString("idx_%1_%2").arg(newIndexTableName, columnName);
-					indexName.remove(QRegExp("[\\s\\,\\;]"));// remove whitespace, commas, and semicolons from index name...
-					q2A.prepare(QString("CREATE INDEX %1 ON %2(%3);").arg(indexName, newIndexTableName, columnName));
-
-					if(AMDatabase::execQuery(q2A)){
-						q2A.finish();
-					}
-					else{
-						q2A.finish();
-						userDb->rollbackTransaction();
-						AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -293, QString("Database support: There was an error trying to recreate index %1 for new table %2.").arg(indexName).arg(newIndexTableName)));
-						return false;
-					}
-				}
+	// Loop over all the index table to column map values
+	QMap<QString, int>::const_iterator i = indexTablesToIndexSide.constBegin();
+	while (i != indexTablesToIndexSide.constEnd()) {
+		QStringList statements;
+		statements << QString("UPDATE %1 SET table%2 = %3 WHERE table%2 = %4;").arg(i.key()).arg(i.value()).arg(quotedNewTableName).arg(quotedOriginalTableName);
+
+		// If we're editing the left side (column 1) we need to update the name of the index table as well
+		//  (and possibly alter any indices associated with the table)
+		if(i.value() == 1 && i.key().contains(originalTableName)){
+			QString originalIndexTableName = i.key();
+			QString newIndexTableName = i.key();
+			newIndexTableName.remove(originalTableName);
+			newIndexTableName.prepend(newTableName);
+
+			// Query if this table has an index (or indices) defined for it
+			QSqlQuery q1 = userDb->query();
+			q1.prepare("PRAGMA index_list("%originalIndexTableName%")");
+			if(!AMDatabase::execQuery(q1)) {
+				q1.finish();
+				AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -291, QString("Database support: There was an error trying to find the index list for %1.").arg(originalIndexTableName)));
+				return false;
 			}
+			QStringList indexListResponses;
+			while(q1.next()){
+				indexListResponses << q1.value(1).toString();
+			}
+			q1.finish();
 
-			++i;
-		}
+			// Drop the indices, rename the table, and re-add the indices using the new table name
+			for(int x = 0; x < indexListResponses.count(); x++)
+				statements << QString("DROP INDEX %1;").arg(indexListResponses.at(x));
 
-		// Go to the actual class table (the original one) and update the AMDbObjectType column
-		if(!userDb->update(originalTableName, "AMDbObjectType='"%originalClassName%"'", "AMDbObjectType", QVariant(newClassName))){
-			userDb->rollbackTransaction();
-			AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -272, QString("Database support: There was an error trying to update the %1 table for new AMDbObjectType %2.").arg(originalTableName).arg(newClassName)));
-			return false;
-		}
+			statements << "ALTER table "%originalIndexTableName%" RENAME to "%newIndexTableName;
 
-		// Finally, rename the table from the original name to the new name
-		QSqlQuery q = userDb->query();
-		q.prepare("ALTER table "%originalTableName%" RENAME to "%newTableName);
-		if(!AMDatabase::execQuery(q)) {
-			q.finish();
-			userDb->rollbackTransaction();
-			AMErrorMon::report(AMErrorReport(0, AMErrorReport::Debug, -273, QString("Database support: There was an error while trying to update table %1 to become %2.").arg(originalClassName).arg(newClassName)));
-			return false;
+			for(int x = 0; x < indexListResponses.count(); x++){
+				QString columnName = indexListResponses.at(x).split('_').last();
+				QString indexName = QString("idx_%1_%2").arg(newIndexTableName, columnName);
+				indexName.remove(QRegExp("[\\s\\,\\;]"));// remove whitespace, commas, and semicolons from index name...
+				statements << QString("CREATE INDEX %1 ON %2(%3);").arg(indexName, newIndexTableName, columnName);
+			}
 		}
 
-		// If there were no problems then commit the transaction
-		userDb->commitTransaction();
-	}
-	// If there are no instances of the original class then no upgrade is necessary
-	else if(matchingOriginial.count() == 0 && matchingNew.count() > 0){
-	}
-	// Neither class name can be found, did you type something in wrong or maybe they aren't in this database
-	else{
+		migration->addStep(QString("Updating %1 references in %2").arg(originalClassName).arg(i.key()), statements);
+		++i;
 	}
+
+	// Go to the actual class table (the original one), update the AMDbObjectType column, and finally rename the table from the original name to the new name
+	migration->addStep(QString("Updating the %1 table").arg(originalTableName),
+			   QStringList() << QString("UPDATE %1 SET AMDbObjectType = %2 WHERE AMDbObjectType = %3;").arg(originalTableName).arg(AMDbMigration::quoted(newClassName)).arg(AMDbMigration::quoted(originalClassName))
+			   << "ALTER table "%originalTableName%" RENAME to "%newTableName);
+
 	return true;
 }
 
-bool AMDbUpgradeSupport::dbObjectClassMerge(AMDatabase *databaseToEdit, const QString &mergeToClassName, const QString &mergeFromClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide){
-	//AMDatabase *userDb = AMDatabase::database("user");
-	AMDatabase *userDb = databaseToEdit;
+bool AMDbUpgradeSupport::appendDbObjectClassMergeSteps(AMDbMigration *migration, const QString &mergeToClassName, const QString &mergeFromClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide){
+	AMDatabase *userDb = migration->database();
 
 	QString mergeToTableName = mergeToClassName%"_table";
 	QString mergeFromTableName = mergeFromClassName%"_table";
+	QString quotedMergeToTableName = AMDbMigration::quoted(mergeToTableName);
+	QString quotedMergeFromTableName = AMDbMigration::quoted(mergeFromTableName);
 
-	// Grab the list of toIDs and fromIDs so we can get counts and offsets
-	QList<int> allToIDs = userDb->objectsMatching(mergeToTableName, "AMDbObjectType", mergeToClassName);
-	QList<int> allFromIDs = userDb->objectsMatching(mergeFromTableName, "AMDbObjectType", mergeFromClassName);
-	int toCount = allToIDs.count();
+	// "From" side ids are offset by the number of "to" side objects
+	int toCount = userDb->objectsMatching(mergeToTableName, "AMDbObjectType", mergeToClassName).count();
 
-	// Start the transaction so we can rollback to here if something goes wrong
-	userDb->startTransaction();
-
-	// Query and record all the column names (except id) from the from table. We need this string list to pass around.
+	// Query and record all the column names (except id) from the from table.
 	QSqlQuery q = userDb->query();
 	q.prepare("PRAGMA table_info("%mergeFromTableName%")");
 	if(!AMDatabase::execQuery(q)) {
 		q.finish();
-		userDb->rollbackTransaction();
 		AMErrorMon::report(AMErrorReport(0, AMErrorReport::Debug, -274, QString("Database support: There was an error while trying to read meta data on table %1.").arg(mergeFromTableName)));
 		return false;
 	}
@@ -339,97 +288,52 @@ bool AMDbUpgradeSupport::dbObjectClassMerge(AMDatabase *databaseToEdit, const QS
 	while(q.next()){
 		allTableColumns << q.value(1).toString();
 	}
-	allTableColumns.removeFirst();
 	q.finish();
-
-	// Insert all the "from" side items into the "to" side table with an offset in their ids
-	for(int x = 0; x < allFromIDs.count(); x++){
-		QVariantList valuesFromFromTable = userDb->retrieve(allFromIDs.at(x), mergeFromTableName, allTableColumns);
-		int fromIDInOldTable = userDb->insertOrUpdate(toCount+allFromIDs.at(x), mergeToTableName, allTableColumns, valuesFromFromTable );
-		if(fromIDInOldTable == 0){
-			userDb->rollbackTransaction();
-			AMErrorMon::report(AMErrorReport(0, AMErrorReport::Debug, -275, QString("Database support: There was an error while trying to insert into to table format %1.").arg(mergeToTableName)));
-			return false;
-		}
-	}
-
-	// Loop over all the parent tables to column names map values
-	QMap<QString, QString>::const_iterator j = parentTablesToColumnNames.constBegin();
-	while (j != parentTablesToColumnNames.constEnd()) {
-		// Grab the list of indices we're interested in and for all those indices update to the new class name while updating the original index value for the correct offset (format: table_name;index_value)
-		QList<int> parentTableIndices = userDb->objectsWhere(j.key(), QString("%1 LIKE '%2;%'").arg(j.value()).arg(mergeFromTableName));
-		for(int x = 0; x < parentTableIndices.count(); x++){
-			QString indexStringToUse = userDb->retrieve(parentTableIndices.at(x), j.key(), j.value()).toString();
-			int indexToUse = indexStringToUse.split(';').at(1).toInt() + toCount;
-			if(!userDb->update(parentTableIndices.at(x), j.key(), j.value(), QVariant(QString("%1;%2").arg(mergeToTableName).arg(indexToUse)))){
-				userDb->rollbackTransaction();
-				AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -282, QString("Database support: There was an error trying to update the %1 column for %2 table at id %2.").arg(j.value()).arg(j.key()).arg(parentTableIndices.at(x))));
-				return false;
-			}
-		}
-		++j;
-	}
-
-	// Loop over all of the index tables we're interested in so we can change any "from" side items to refer to the "original" side table with their revamped ids.
-	QMap<QString, int>::const_iterator i = indexTablesToIndexSide.constBegin();
-	while (i != indexTablesToIndexSide.constEnd()) {
-		QList<int> indexTableIndices = userDb->objectsWhere(i.key(), QString("table%1='%2'").arg(i.value()).arg(mergeFromTableName));
-		QStringList updateColumns;
-		QString idString = QString("id%1").arg(i.value());
-		updateColumns << idString << QString("table%1").arg(i.value());
-		for(int x = 0; x< indexTableIndices.count(); x++){
-			int currentId2 = userDb->retrieve(indexTableIndices.at(x), i.key(), idString).toInt() + toCount;
-			QVariantList updateValues;
-			updateValues << QVariant(currentId2) << QVariant(mergeToTableName);
-			if(!userDb->update(indexTableIndices.at(x), i.key(), updateColumns, updateValues)){
-				userDb->rollbackTransaction();
-				AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -276, QString("Database support: There was an error trying to update the %1 table at id %2.").arg(i.key()).arg(indexTableIndices.at(x))));
-				return false;
-			}
-		}
-		++i;
+	if(allTableColumns.isEmpty()){
+		AMErrorMon::report(AMErrorReport(0, AMErrorReport::Debug, -274, QString("Database support: There was an error while trying to read meta data on table %1.").arg(mergeFromTableName)));
+		return false;
 	}
+	allTableColumns.removeFirst();
 
 	// Grab the id of the from class from the AMDbObjectTypes table. We need this to get rid of items in the related tables
-	QList<int> fromClassDbObjectIds = userDb->objectsWhere("AMDbObjectTypes_table", "AMDbObjectType = '"%mergeFromClassName%"'");
+	QList<int> fromClassDbObjectIds = userDb->objectsWhere("AMDbObjectTypes_table", "AMDbObjectType = "%AMDbMigration::quoted(mergeFromClassName));
 	if(fromClassDbObjectIds.count() != 1){
-		userDb->rollbackTransaction();
 		AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -277, QString("Database support: There was an error trying to find %1 in the AMDbObjectTypes table.").arg(mergeFromClassName)));
 		return false;
 	}
 	int fromClassDbObjectId = fromClassDbObjectIds.at(0);
 
-	// Delete the from class from the AMDbObjectsType table.
-	if(!userDb->deleteRow(fromClassDbObjectId, "AMDbObjectTypes_table")){
-		userDb->rollbackTransaction();
-		AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -278, QString("Database support: There was an error trying to rollback the AMDbObjectTypes table for %1.").arg(mergeFromClassName)));
-		return false;
-	}
+	// Insert all the "from" side items into the "to" side table with an offset in their ids.  (Replacing any row already at that id, as insertOrUpdate() would.)
+	QString columns = allTableColumns.join(", ");
+	migration->addStep(QString("Merging %1 into %2").arg(mergeFromClassName).arg(mergeToClassName),
+			   QString("INSERT OR REPLACE INTO %1 (id, %2) SELECT id + %3, %2 FROM %4 WHERE AMDbObjectType = %5;").arg(mergeToTableName).arg(columns).arg(toCount).arg(mergeFromTableName).arg(AMDbMigration::quoted(mergeFromClassName)));
 
-	// Loop over a list of tables related to AMDbObjectTypes. Remove all instances of the TypeId we just grabbed from the last db call.
-	QStringList relatedAMDbObjectTypesTables;
-	relatedAMDbObjectTypesTables << "allColumns" << "visibleColumns" << "loadColumns";
-	for(int x = 0; x < relatedAMDbObjectTypesTables.count(); x++){
-		if(userDb->deleteRows("AMDbObjectTypes_"%relatedAMDbObjectTypesTables.at(x), QString("TypeId='%1'").arg(fromClassDbObjectId)) == 0){
-			userDb->rollbackTransaction();
-			AMErrorMon::report(AMErrorReport(0, AMErrorReport::Alert, -279, QString("Database support: There was an error trying to rollback the AMDbObjectTypes related table %1.").arg("AMDbObjectTypes_"%relatedAMDbObjectTypesTables.at(x))));
-			return false;
-		}
+	// Parent tables store references as "table_name;index_value". Point them at the "to" table, with the offset index value.
+	QString fromPrefix = AMDbMigration::quoted(mergeFromTableName%";");
+	int prefixLength = mergeFromTableName.length()+1;
+	QMap<QString, QString>::const_iterator j = parentTablesToColumnNames.constBegin();
+	while (j != parentTablesToColumnNames.constEnd()) {
+		migration->addStep(QString("Updating %1 references in %2").arg(mergeFromClassName).arg(j.key()),
+				   QString("UPDATE %1 SET %2 = %3 || (CAST(substr(%2, %4) AS INTEGER) + %5) WHERE substr(%2, 1, %6) = %7;").arg(j.key()).arg(j.value()).arg(AMDbMigration::quoted(mergeToTableName%";")).arg(prefixLength+1).arg(toCount).arg(prefixLength).arg(fromPrefix));
+		++j;
 	}
 
-	// Actually delete the "from" side class table.
-	q = userDb->query();
-	q.prepare("DROP TABLE "%mergeFromTableName);
-	if(!AMDatabase::execQuery(q)) {
-		q.finish();
-		userDb->rollbackTransaction();
-		AMErrorMon::report(AMErrorReport(0, AMErrorReport::Debug, -280, QString("Database support: There was an error while trying to rollback table %1.").arg(mergeFromTableName)));
-		return false;
+	// Change any "from" side items in the index tables to refer to the "to" side table with their revamped ids.
+	QMap<QString, int>::const_iterator i = indexTablesToIndexSide.constBegin();
+	while (i != indexTablesToIndexSide.constEnd()) {
+		migration->addStep(QString("Updating %1 references in %2").arg(mergeFromClassName).arg(i.key()),
+				   QString("UPDATE %1 SET id%2 = id%2 + %3, table%2 = %4 WHERE table%2 = %5;").arg(i.key()).arg(i.value()).arg(toCount).arg(quotedMergeToTableName).arg(quotedMergeFromTableName));
+		++i;
 	}
-	q.finish();
 
-	// Commit this transaction
-	userDb->commitTransaction();
+	// Delete the from class from the AMDbObjectsType table and its related tables, and then delete the "from" side class table.
+	migration->addStep(QString("Removing %1").arg(mergeFromClassName),
+			   QStringList() << QString("DELETE FROM AMDbObjectTypes_table WHERE id = %1;").arg(fromClassDbObjectId)
+			   << QString("DELETE FROM AMDbObjectTypes_allColumns WHERE TypeId = %1;").arg(fromClassDbObjectId)
+			   << QString("DELETE FROM AMDbObjectTypes_visibleColumns WHERE TypeId = %1;").arg(fromClassDbObjectId)
+			   << QString("DELETE FROM AMDbObjectTypes_loadColumns WHERE TypeId = %1;").arg(fromClassDbObjectId)
+			   << "DROP TABLE "%mergeFromTableName);
+
 	return true;
 }
 
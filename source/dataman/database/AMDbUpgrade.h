@@ -25,6 +25,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "AMDatabase.h"
 
+class AMDbMigration;
+
 class AMDbUpgrade : public QObject
 {
 Q_OBJECT
@@ -94,7 +96,15 @@ public slots:
 	/// Sets whether or not this instance is responsible for doing the upgrade (for shared databases) or just checking that it's been done
 	void setIsResponsibleForUpgrade(bool isResponsibleForUpgrade);
 
+signals:
+	/// Emitted as the migrations run by runMigration() progress: \c completedSteps of \c totalSteps are done, and \c description is the step now running.
+	void progressChanged(int completedSteps, int totalSteps, const QString &description);
+
 protected:
+	/// Runs \c migration (all of its steps in one transaction), forwarding its progress to progressChanged().  Subclasses should build their upgradeImplementation() this way, using the AMDbUpgradeSupport::append...Steps() functions or their own set-based SQL, rather than updating the database one row at a time.  Returns false if the migration was rolled back.
+	bool runMigration(AMDbMigration *migration);
+
+
 	/// The database name that has been requested for this upgrade
 	QString databaseNameToUpgrade_;
 	/// The database that has been requested for this upgrade.
@@ -131,6 +141,13 @@ namespace AMDbUpgradeSupport{
 	  */
 	bool dbObjectClassMerge(AMDatabase *databaseToEdit, const QString &mergeToClassName, const QString &mergeFromClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide);
 
+	/// Adds the work of dbObjectClassBecomes() to \c migration as set-based SQL steps, without running it.  Several renames can be added to one migration, so that they are applied (or rolled back) together.
+	/*! The database is only read here, to find which classes are present and what indices the index tables have.  Returns false if it could not be examined.
+	  */
+	bool appendDbObjectClassBecomesSteps(AMDbMigration *migration, const QString &originalClassName, const QString &newClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide);
+	/// Adds the work of dbObjectClassMerge() to \c migration as set-based SQL steps, without running it.  Returns false if the database could not be examined or the "from" class is not in the AMDbObjectTypes table.
+	bool appendDbObjectClassMergeSteps(AMDbMigration *migration, const QString &mergeToClassName, const QString &mergeFromClassName, QMap<QString, QString> parentTablesToColumnNames, QMap<QString, int> indexTablesToIndexSide);
+
 	/// Changes a column name given by \param oldColumnName and replaces it with \param newColumnName.  It can also change the type.  Make sure that you don't give it a type that isn't compatible.  If you don't provide a type it will assume the type should be the same.
 	/*!
 		This takes care of changing column names after a table has been created.  This would be used if you have changed the name of a Q_PROPERTY of an AMDbObject.  Since
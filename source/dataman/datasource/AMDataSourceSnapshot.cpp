@@ -0,0 +1,251 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMDataSourceSnapshot.h"
+
+#include <string.h>
+
+bool AMDataSourceSnapshotData::capture(const AMDataSource *source)
+{
+	axes.clear();
+	axisValues.clear();
+	values.clear();
+	state = AMDataSource::InvalidFlag;
+
+	if(!source)
+		return false;
+
+	name = source->name();
+	description = source->description();
+	axes = source->axes();
+
+	int axisCount = axes.count();
+	axisValues.resize(axisCount);
+	for(int mu = 0; mu < axisCount; ++mu) {
+		int axisSize = axes.at(mu).size;
+		QVector<double> &axis = axisValues[mu];
+		axis.resize(axisSize);
+		for(int i = 0; i < axisSize; ++i)
+			axis[i] = double(source->axisValue(mu, i));
+	}
+
+	if(!source->isValid())
+		return false;
+
+	AMnDIndex end = size();
+	long count = end.product();
+	if(count <= 0) {
+		state = source->state();
+		return true;
+	}
+
+	for(int mu = 0; mu < axisCount; ++mu)
+		end[mu]--;
+
+	values.resize(count);
+	if(!source->values(AMnDIndex(axisCount, AMnDIndex::DoInit, 0), end, values.data())) {
+		values.clear();
+		return false;
+	}
+
+	state = source->state();
+	return true;
+}
+
+AMnDIndex AMDataSourceSnapshotData::size() const
+{
+	int axisCount = axes.count();
+	AMnDIndex rv(axisCount, AMnDIndex::DoNotInit);
+	for(int mu = 0; mu < axisCount; ++mu)
+		rv[mu] = axes.at(mu).size;
+	return rv;
+}
+
+long AMDataSourceSnapshotData::flatIndex(const AMnDIndex &indexes) const
+{
+	long rv = 0;
+	for(int mu = 0, axisCount = axes.count(); mu < axisCount; ++mu)
+		rv = rv*axes.at(mu).size + indexes.at(mu);
+	return rv;
+}
+
+AMDataSourceSnapshot::AMDataSourceSnapshot(const QString &name)
+	: AMDataSource(name)
+{
+}
+
+AMDataSourceSnapshot::AMDataSourceSnapshot(const AMDataSourceSnapshotData &data)
+	: AMDataSource(data.name)
+{
+	data_ = data;
+	description_ = data.description;
+}
+
+AMDataSourceSnapshotData AMDataSourceSnapshot::data() const
+{
+	QMutexLocker locker(&mutex_);
+	return data_;
+}
+
+void AMDataSourceSnapshot::setData(const AMDataSourceSnapshotData &data)
+{
+	mutex_.lock();
+	AMDataSourceSnapshotData oldData = data_;
+	data_ = data;
+	mutex_.unlock();
+
+	bool sizeChanged = oldData.size() != data.size();
+	bool axisInfoChanged = oldData.rank() != data.rank();
+	for(int mu = 0, axisCount = data.rank(); mu < axisCount && !axisInfoChanged; ++mu) {
+		const AMAxisInfo &oldAxis = oldData.axes.at(mu);
+		const AMAxisInfo &newAxis = data.axes.at(mu);
+		axisInfoChanged = oldAxis.name != newAxis.name || oldAxis.description != newAxis.description || oldAxis.units != newAxis.units || oldAxis.isUniform != newAxis.isUniform;
+	}
+	bool infoChanged = description_ != data.description;
+	if(infoChanged)
+		description_ = data.description;
+
+	if(sizeChanged)
+		emitSizeChanged(-1);
+	if(axisInfoChanged)
+		emitAxisInfoChanged(-1);
+	if(infoChanged)
+		emitInfoChanged();
+	emitValuesChanged();
+	if(oldData.state != data.state)
+		emitStateChanged(data.state);
+}
+
+int AMDataSourceSnapshot::state() const
+{
+	QMutexLocker locker(&mutex_);
+	return data_.state;
+}
+
+QList<AMAxisInfo> AMDataSourceSnapshot::axes() const
+{
+	QMutexLocker locker(&mutex_);
+	return data_.axes;
+}
+
+int AMDataSourceSnapshot::rank() const
+{
+	QMutexLocker locker(&mutex_);
+	return data_.rank();
+}
+
+AMnDIndex AMDataSourceSnapshot::size() const
+{
+	QMutexLocker locker(&mutex_);
+	return data_.size();
+}
+
+int AMDataSourceSnapshot::size(int axisNumber) const
+{
+	QMutexLocker locker(&mutex_);
+	if((unsigned)axisNumber >= (unsigned)data_.axes.count())
+		return 0;
+	return data_.axes.at(axisNumber).size;
+}
+
+AMAxisInfo AMDataSourceSnapshot::axisInfoAt(int axisNumber) const
+{
+	QMutexLocker locker(&mutex_);
+	if((unsigned)axisNumber >= (unsigned)data_.axes.count())
+		return AMAxisInfo("invalid", 0, "invalid axis");
+	return data_.axes.at(axisNumber);
+}
+
+int AMDataSourceSnapshot::idOfAxis(const QString &axisName)
+{
+	QMutexLocker locker(&mutex_);
+	for(int mu = 0, axisCount = data_.axes.count(); mu < axisCount; ++mu)
+		if(data_.axes.at(mu).name == axisName)
+			return mu;
+	return -1;
+}
+
+AMNumber AMDataSourceSnapshot::value(const AMnDIndex &indexes) const
+{
+	QMutexLocker locker(&mutex_);
+
+	int axisCount = data_.axes.count();
+	if(indexes.rank() != axisCount)
+		return AMNumber(AMNumber::DimensionError);
+	if(data_.values.isEmpty())
+		return AMNumber(AMNumber::InvalidError);
+
+	for(int mu = 0; mu < axisCount; ++mu)
+		if((unsigned long)indexes.at(mu) >= (unsigned long)data_.axes.at(mu).size)
+			return AMNumber(AMNumber::OutOfBoundsError);
+
+	return data_.values.at(data_.flatIndex(indexes));
+}
+
+bool AMDataSourceSnapshot::values(const AMnDIndex &indexStart, const AMnDIndex &indexEnd, double *outputValues) const
+{
+	QMutexLocker locker(&mutex_);
+
+	int axisCount = data_.axes.count();
+	if(indexStart.rank() != axisCount || indexEnd.rank() != axisCount || data_.values.isEmpty())
+		return false;
+
+	for(int mu = 0; mu < axisCount; ++mu)
+		if(indexStart.at(mu) < 0 || indexEnd.at(mu) >= data_.axes.at(mu).size || indexEnd.at(mu) < indexStart.at(mu))
+			return false;
+
+	if(axisCount == 0) {
+		*outputValues = data_.values.at(0);
+		return true;
+	}
+
+	// Copy one run along the last axis at a time, stepping through the other axes like an odometer.
+	const double *values = data_.values.constData();
+	long runLength = indexEnd.at(axisCount-1) - indexStart.at(axisCount-1) + 1;
+	AMnDIndex current = indexStart;
+
+	forever {
+		memcpy(outputValues, values + data_.flatIndex(current), runLength*sizeof(double));
+		outputValues += runLength;
+
+		int mu = axisCount-2;
+		for(; mu >= 0; --mu) {
+			if(++current[mu] <= indexEnd.at(mu))
+				break;
+			current[mu] = indexStart.at(mu);
+		}
+
+		if(mu < 0)
+			break;
+	}
+
+	return true;
+}
+
+AMNumber AMDataSourceSnapshot::axisValue(int axisNumber, int index) const
+{
+	QMutexLocker locker(&mutex_);
+
+	if((unsigned)axisNumber >= (unsigned)data_.axisValues.count())
+		return AMNumber(AMNumber::DimensionError);
+	if((unsigned)index >= (unsigned)data_.axisValues.at(axisNumber).count())
+		return AMNumber(AMNumber::OutOfBoundsError);
+
+	return data_.axisValues.at(axisNumber).at(index);
+}
@@ -0,0 +1,109 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMDATASOURCESNAPSHOT_H
+#define AMDATASOURCESNAPSHOT_H
+
+#include <QVector>
+#include <QMutex>
+#include <QMetaType>
+
+#include "dataman/datasource/AMDataSource.h"
+#include "dataman/AMNumber.h"
+
+/// This class holds a complete copy of an AMDataSource at one moment: its axes, axis values, dependent values and state.
+/*! The copy is taken in one go by capture(), on the thread that owns the source, so it is always self-consistent: the values match the size, even if the source keeps growing afterwards.  The containers are implicitly shared, so snapshots can be passed by value between threads (ex: as the argument of a queued signal) without copying the data again.
+*/
+class AMDataSourceSnapshotData
+{
+public:
+	/// Creates an empty (invalid) snapshot
+	AMDataSourceSnapshotData() { state = AMDataSource::InvalidFlag; }
+	/// Creates a snapshot of \c source.  \sa capture()
+	explicit AMDataSourceSnapshotData(const AMDataSource* source) { capture(source); }
+
+	/// Copies everything from \c source, reading the values with one values() call.  Must be called on the thread that owns the source.  If \c source is 0, or its values can't be read, the snapshot is left invalid and this returns false.
+	bool capture(const AMDataSource* source);
+
+	/// The rank of the copied source
+	int rank() const { return axes.count(); }
+	/// The size of the copied source
+	AMnDIndex size() const;
+	/// The flat (row-major) index of \c indexes into values.  No bounds checking is done.
+	long flatIndex(const AMnDIndex& indexes) const;
+
+	/// The name and description of the copied source
+	QString name, description;
+	/// The state() of the copied source
+	int state;
+	/// The axes of the copied source, including their sizes
+	QList<AMAxisInfo> axes;
+	/// The independent values along each axis
+	QVector<QVector<double> > axisValues;
+	/// The dependent values, in row-major order.  Empty when the source was not valid.
+	QVector<double> values;
+};
+
+Q_DECLARE_METATYPE(AMDataSourceSnapshotData)
+Q_DECLARE_METATYPE(QList<AMDataSourceSnapshotData>)
+
+/// This class is an AMDataSource that serves the contents of an AMDataSourceSnapshotData.
+/*! It is used to hand data across threads: the thread that owns a source captures it into an AMDataSourceSnapshotData, and the receiving thread installs it with setData().  The change is atomic; readers always see either the complete old snapshot or the complete new one.  setData() then emits sizeChanged(), axisInfoChanged(), valuesChanged() and stateChanged() as needed, from the calling thread.
+
+All of the reading functions are protected by a mutex, so a snapshot can be read from any thread.
+*/
+class AMDataSourceSnapshot : public AMDataSource
+{
+public:
+	/// Creates an empty (invalid) snapshot source called \c name.
+	explicit AMDataSourceSnapshot(const QString& name);
+	/// Creates a snapshot source serving \c data, named after the original source.
+	explicit AMDataSourceSnapshot(const AMDataSourceSnapshotData& data);
+
+	/// Returns a copy of the snapshot being served.  This is cheap: the data is implicitly shared.
+	AMDataSourceSnapshotData data() const;
+	/// Replaces the snapshot being served with \c data, and emits the signals for whatever changed.
+	void setData(const AMDataSourceSnapshotData& data);
+
+	// Reimplemented from AMDataSource
+	//////////////////////////////
+
+	virtual QString typeDescription() const { return "Snapshot"; }
+	virtual int state() const;
+
+	virtual QList<AMAxisInfo> axes() const;
+	virtual int rank() const;
+	virtual AMnDIndex size() const;
+	virtual int size(int axisNumber) const;
+	virtual AMAxisInfo axisInfoAt(int axisNumber) const;
+	virtual int idOfAxis(const QString& axisName);
+
+	virtual AMNumber value(const AMnDIndex& indexes) const;
+	/// Copies the values from \c indexStart to \c indexEnd (inclusive) into \c outputValues, one contiguous run along the last axis at a time.
+	virtual bool values(const AMnDIndex& indexStart, const AMnDIndex& indexEnd, double* outputValues) const;
+	virtual AMNumber axisValue(int axisNumber, int index) const;
+
+protected:
+	/// The snapshot being served
+	AMDataSourceSnapshotData data_;
+	/// Protects data_
+	mutable QMutex mutex_;
+};
+
+#endif // AMDATASOURCESNAPSHOT_H
@@ -0,0 +1,387 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMDataSourceThumbnailRenderer.h"
+
+#include <QPainter>
+#include <QLineF>
+#include <qnumeric.h>
+#include <math.h>
+
+#include "dataman/datasource/AMDataSource.h"
+
+namespace AMDataSourceThumbnailRenderer
+{
+	/// Space (in pixels) left around the plot area.
+	static const int plotMargin = 4;
+
+	/// Returns an image of \c size, filled with the background colour.
+	static QImage blankImage(const QSize &size)
+	{
+		QImage image(size, QImage::Format_ARGB32_Premultiplied);
+		image.fill(qRgb(255, 255, 255));
+		return image;
+	}
+
+	/// Returns the area of an image of \c size that data is drawn into.
+	static QRect plotRect(const QSize &size)
+	{
+		return QRect(QPoint(0, 0), size).adjusted(plotMargin, plotMargin, -plotMargin, -plotMargin);
+	}
+
+	/// Draws the left and bottom axis lines around \c rect.
+	static void drawAxes(QPainter &painter, const QRect &rect)
+	{
+		painter.setPen(QPen(QColor(160, 160, 160), 0));
+		painter.drawLine(rect.bottomLeft(), rect.topLeft());
+		painter.drawLine(rect.bottomLeft(), rect.bottomRight());
+	}
+
+	/// Returns true if \c value should be used when colour-mapping.
+	static bool usableValue(double value, bool useDefaultValue, double defaultValue)
+	{
+		return qIsFinite(value) && !(useDefaultValue && value == defaultValue);
+	}
+}
+
+QImage AMDataSourceThumbnailRenderer::render(const AMDataSource *source, const QSize &size, const QColor &lineColor, bool useDefaultValue, double defaultValue)
+{
+	if(!source || !source->isValid())
+		return blankImage(size);
+
+	switch(source->rank()){
+
+	case 1: {
+
+		int count = source->size(0);
+
+		if(count <= 0)
+			return blankImage(size);
+
+		QVector<double> y(count);
+
+		if(!source->values(AMnDIndex(0), AMnDIndex(count-1), y.data()))
+			return blankImage(size);
+
+		// Fall back to the point index if the axis doesn't provide values.
+		QVector<double> x(count);
+		bool useAxisValues = true;
+
+		for(int i = 0; i < count && useAxisValues; i++){
+
+			AMNumber axisValue = source->axisValue(0, i);
+
+			if(axisValue.isValid())
+				x[i] = double(axisValue);
+			else
+				useAxisValues = false;
+		}
+
+		return render1D(useAxisValues ? x.constData() : 0, y.constData(), count, size, lineColor);
+	}
+
+	case 2: {
+
+		int xCount = source->size(0);
+		int yCount = source->size(1);
+
+		if(xCount <= 0 || yCount <= 0)
+			return blankImage(size);
+
+		QVector<double> data(xCount*yCount);
+
+		if(!source->values(AMnDIndex(0, 0), AMnDIndex(xCount-1, yCount-1), data.data()))
+			return blankImage(size);
+
+		return render2D(data.constData(), xCount, yCount, size, useDefaultValue, defaultValue);
+	}
+
+	case 3: {
+
+		int xCount = source->size(0);
+		int yCount = source->size(1);
+		int zCount = source->size(2);
+
+		if(xCount <= 0 || yCount <= 0 || zCount <= 0)
+			return blankImage(size);
+
+		// Sum over the last axis, reading one x slice at a time so that we never hold the whole volume.
+		QVector<double> sums(xCount*yCount);
+		QVector<double> slice(yCount*zCount);
+
+		for(int i = 0; i < xCount; i++){
+
+			if(!source->values(AMnDIndex(i, 0, 0), AMnDIndex(i, yCount-1, zCount-1), slice.data()))
+				return blankImage(size);
+
+			for(int j = 0; j < yCount; j++){
+
+				const double *spectrum = slice.constData() + j*zCount;
+				double sum = 0;
+				bool hasValues = false;
+
+				for(int k = 0; k < zCount; k++){
+
+					if(usableValue(spectrum[k], useDefaultValue, defaultValue)){
+
+						sum += spectrum[k];
+						hasValues = true;
+					}
+				}
+
+				sums[i*yCount+j] = hasValues ? sum : (useDefaultValue ? defaultValue : qQNaN());
+			}
+		}
+
+		return render2D(sums.constData(), xCount, yCount, size, useDefaultValue, defaultValue);
+	}
+
+	default:
+		return blankImage(size);
+	}
+}
+
+QImage AMDataSourceThumbnailRenderer::render1D(const double *x, const double *y, int count, const QSize &size, const QColor &lineColor)
+{
+	QImage image = blankImage(size);
+	QRect rect = plotRect(size);
+
+	if(count <= 0 || rect.width() <= 0 || rect.height() <= 0)
+		return image;
+
+	// Find the range of the finite points.
+	double xMinimum = 0, xMaximum = 0, yMinimum = 0, yMaximum = 0;
+	bool hasPoints = false;
+
+	for(int i = 0; i < count; i++){
+
+		double xValue = x ? x[i] : double(i);
+		double yValue = y[i];
+
+		if(!qIsFinite(xValue) || !qIsFinite(yValue))
+			continue;
+
+		if(!hasPoints){
+
+			xMinimum = xMaximum = xValue;
+			yMinimum = yMaximum = yValue;
+			hasPoints = true;
+		}
+
+		else {
+
+			xMinimum = qMin(xMinimum, xValue);
+			xMaximum = qMax(xMaximum, xValue);
+			yMinimum = qMin(yMinimum, yValue);
+			yMaximum = qMax(yMaximum, yValue);
+		}
+	}
+
+	QPainter painter(&image);
+	drawAxes(painter, rect);
+
+	if(!hasPoints)
+		return image;
+
+	if(xMinimum == xMaximum){
+
+		xMinimum -= 0.5;
+		xMaximum += 0.5;
+	}
+
+	if(yMinimum == yMaximum){
+
+		yMinimum -= 0.5;
+		yMaximum += 0.5;
+	}
+
+	int columns = rect.width();
+	QVector<double> minimums(columns), maximums(columns), firsts(columns), lasts(columns);
+	QVector<int> pointCounts = minMaxDecimate(x, y, count, xMinimum, xMaximum, columns, minimums.data(), maximums.data(), firsts.data(), lasts.data());
+
+	double yScale = double(rect.height()-1)/(yMaximum-yMinimum);
+	double bottom = rect.bottom();
+
+	// Each column becomes (at most) a vertical segment from its minimum to its maximum, joined to the previous column from its last point to this column's first point.
+	QVector<QLineF> lines;
+	lines.reserve(2*columns);
+	bool hasPreviousColumn = false;
+	QPointF previousPoint;
+
+	for(int column = 0; column < columns; column++){
+
+		if(pointCounts.at(column) == 0)
+			continue;
+
+		double xPixel = rect.left() + column + 0.5;
+		QPointF firstPoint(xPixel, bottom - (firsts.at(column)-yMinimum)*yScale);
+
+		if(hasPreviousColumn)
+			lines << QLineF(previousPoint, firstPoint);
+
+		if(minimums.at(column) != maximums.at(column))
+			lines << QLineF(xPixel, bottom - (minimums.at(column)-yMinimum)*yScale, xPixel, bottom - (maximums.at(column)-yMinimum)*yScale);
+
+
+		previousPoint = QPointF(xPixel, bottom - (lasts.at(column)-yMinimum)*yScale);
+		hasPreviousColumn = true;
+	}
+
+	painter.setRenderHint(QPainter::Antialiasing, true);
+	painter.setPen(QPen(lineColor, 0));
+	painter.drawLines(lines);
+
+	// A single point (or a flat line within one column) would otherwise be invisible.
+	if(lines.isEmpty() && hasPreviousColumn)
+		painter.drawPoint(previousPoint);
+
+	painter.end();
+
+	return image;
+}
+
+QImage AMDataSourceThumbnailRenderer::render2D(const double *data, int xCount, int yCount, const QSize &size, bool useDefaultValue, double defaultValue)
+{
+	QImage image = blankImage(size);
+	QRect rect = plotRect(size);
+
+	if(xCount <= 0 || yCount <= 0 || rect.width() <= 0 || rect.height() <= 0)
+		return image;
+
+	// Average into at most one bin per pixel.
+	int binColumns = qMin(xCount, rect.width());
+	int binRows = qMin(yCount, rect.height());
+	QVector<double> binSums(binColumns*binRows, 0);
+	QVector<int> binCounts(binColumns*binRows, 0);
+
+	for(int i = 0; i < xCount; i++){
+
+		int binColumn = int(qint64(i)*binColumns/xCount);
+		const double *column = data + qint64(i)*yCount;
+
+		for(int j = 0; j < yCount; j++){
+
+			if(!usableValue(column[j], useDefaultValue, defaultValue))
+				continue;
+
+			int bin = binColumn*binRows + int(qint64(j)*binRows/yCount);
+			binSums[bin] += column[j];
+			binCounts[bin]++;
+		}
+	}
+
+	double minimum = 0, maximum = 0;
+	bool hasValues = false;
+
+	for(int bin = 0, bins = binSums.size(); bin < bins; bin++){
+
+		if(binCounts.at(bin) == 0)
+			continue;
+
+		double mean = binSums.at(bin)/binCounts.at(bin);
+		binSums[bin] = mean;
+
+		if(!hasValues){
+
+			minimum = maximum = mean;
+			hasValues = true;
+		}
+
+		else {
+
+			minimum = qMin(minimum, mean);
+			maximum = qMax(maximum, mean);
+		}
+	}
+
+	QPainter painter(&image);
+	drawAxes(painter, rect);
+
+	if(!hasValues)
+		return image;
+
+	double range = maximum - minimum;
+	QImage bins(binColumns, binRows, QImage::Format_ARGB32_Premultiplied);
+	bins.fill(qRgba(0, 0, 0, 0));
+
+	// y increases upwards in the plot, but downwards in the image.
+	for(int binColumn = 0; binColumn < binColumns; binColumn++){
+
+		for(int binRow = 0; binRow < binRows; binRow++){
+
+			int bin = binColumn*binRows + binRow;
+
+			if(binCounts.at(bin) > 0)
+				bins.setPixel(binColumn, binRows-1-binRow, jetColor(range > 0 ? (binSums.at(bin)-minimum)/range : 0.5));
+		}
+	}
+
+	painter.drawImage(QRectF(rect), bins);
+	painter.end();
+
+	return image;
+}
+
+QVector<int> AMDataSourceThumbnailRenderer::minMaxDecimate(const double *x, const double *y, int count, double xMinimum, double xMaximum, int columns, double *minimums, double *maximums, double *firsts, double *lasts)
+{
+	QVector<int> pointCounts(qMax(columns, 0), 0);
+
+	if(columns <= 0 || xMaximum <= xMinimum)
+		return pointCounts;
+
+	double columnsPerUnit = double(columns)/(xMaximum-xMinimum);
+
+	for(int i = 0; i < count; i++){
+
+		double xValue = x ? x[i] : double(i);
+		double yValue = y[i];
+
+		if(!qIsFinite(xValue) || !qIsFinite(yValue) || xValue < xMinimum || xValue > xMaximum)
+			continue;
+
+		int column = qMin(int((xValue-xMinimum)*columnsPerUnit), columns-1);
+
+		if(pointCounts.at(column) == 0){
+
+			minimums[column] = maximums[column] = firsts[column] = yValue;
+		}
+
+		else {
+
+			minimums[column] = qMin(minimums[column], yValue);
+			maximums[column] = qMax(maximums[column], yValue);
+		}
+
+		lasts[column] = yValue;
+		pointCounts[column]++;
+	}
+
+	return pointCounts;
+}
+
+QRgb AMDataSourceThumbnailRenderer::jetColor(double fraction)
+{
+	fraction = qBound(0.0, fraction, 1.0);
+
+	double red = qBound(0.0, 1.5 - fabs(4*fraction - 3), 1.0);
+	double green = qBound(0.0, 1.5 - fabs(4*fraction - 2), 1.0);
+	double blue = qBound(0.0, 1.5 - fabs(4*fraction - 1), 1.0);
+
+	return qRgb(int(red*255 + 0.5), int(green*255 + 0.5), int(blue*255 + 0.5));
+}
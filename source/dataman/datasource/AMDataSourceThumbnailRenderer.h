@@ -0,0 +1,56 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMDATASOURCETHUMBNAILRENDERER_H
+#define AMDATASOURCETHUMBNAILRENDERER_H
+
+#include <QImage>
+#include <QColor>
+#include <QSize>
+#include <QVector>
+
+class AMDataSource;
+
+/// Draws small preview images of data sources directly into a QImage, for database thumbnails (ex: AMScan::thumbnail()).
+/*! Unlike a full MPlot inside a QGraphicsScene, these functions only use QImage and QPainter, so they are safe to call from a worker thread.  They also never draw more than a few primitives per pixel column:
+
+- 1D data is min/max decimated: the points falling into each pixel column are reduced to their first, last, minimum and maximum values, which is enough to draw exactly the same envelope as the full line.
+- 2D data is averaged into at most one bin per pixel, and the bins are colour-mapped.
+- 3D data is summed over its last axis, and then drawn like 2D data.
+
+All the data is read with AMDataSource::values(), one block at a time.
+*/
+namespace AMDataSourceThumbnailRenderer
+{
+	/// Renders \c source into an image of \c size.  1D data is drawn with \c lineColor.  If \c useDefaultValue is true, 2D and 3D points equal to \c defaultValue (ie: not acquired yet) are left out of the colour range and drawn as background.  Returns a blank image for invalid or empty sources, or ranks above 3.
+	QImage render(const AMDataSource *source, const QSize &size, const QColor &lineColor, bool useDefaultValue = false, double defaultValue = -1);
+
+	/// Renders the \c count points in \c x and \c y as a line of \c lineColor.  If \c x is 0, the point index is used instead.
+	QImage render1D(const double *x, const double *y, int count, const QSize &size, const QColor &lineColor);
+	/// Renders the \c xCount by \c yCount values in \c data (row-major, x varying the slowest, like AMDataSource::values()) as a colour map.  See render() for \c useDefaultValue and \c defaultValue.
+	QImage render2D(const double *data, int xCount, int yCount, const QSize &size, bool useDefaultValue = false, double defaultValue = -1);
+
+	/// Reduces the \c count points in \c x and \c y to \c columns pixel columns spanning \c xMinimum to \c xMaximum.  For each column, writes the minimum and maximum y value into \c minimums and \c maximums, and the y value of the first and last point (in input order) into \c firsts and \c lasts.  Returns the number of points in each column; empty columns are left untouched.  Non-finite points are skipped.  If \c x is 0, the point index is used instead.
+	QVector<int> minMaxDecimate(const double *x, const double *y, int count, double xMinimum, double xMaximum, int columns, double *minimums, double *maximums, double *firsts, double *lasts);
+
+	/// Returns the "jet" colour map colour (dark blue through cyan, yellow and dark red) for \c fraction, from 0 to 1.
+	QRgb jetColor(double fraction);
+}
+
+#endif // AMDATASOURCETHUMBNAILRENDERER_H
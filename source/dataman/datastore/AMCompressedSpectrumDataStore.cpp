@@ -0,0 +1,543 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMCompressedSpectrumDataStore.h"
+
+#include <QMutexLocker>
+#include <math.h>
+#include <string.h>
+
+/// The first byte of an encoded spectrum says how the rest is stored:
+#define AMCSDS_DELTA_VARINT_FORMAT 1
+#define AMCSDS_RAW_DOUBLE_FORMAT 2
+/// A partly-written spectrum: a bit mask of the written channels ((count+7)/8 bytes), followed by one of the other formats.
+#define AMCSDS_PARTIAL_FORMAT 3
+
+/// The largest magnitude that can be stored as an integer.  (Doubles hold every integer up to 2^53 exactly; this leaves room for the differences.)
+#define AMCSDS_MAXIMUM_INTEGER 4503599627370496.0
+
+/// Encodes \c count integer \c values as the differences between neighbours, zig-zag encoded (so that small negative numbers are small too) and written 7 bits per byte.
+template <class T>
+static QByteArray encodeDeltaVarint(const T* values, int count)
+{
+	QByteArray encoded;
+	// worst case: 10 bytes for every 64-bit difference
+	encoded.resize(1 + count*10);
+	uchar *output = reinterpret_cast<uchar*>(encoded.data());
+	uchar *start = output;
+
+	*(output++) = AMCSDS_DELTA_VARINT_FORMAT;
+
+	qint64 previous = 0;
+	for(int i = 0; i < count; i++) {
+		qint64 current = qint64(values[i]);
+		qint64 difference = current - previous;
+		quint64 zigZag = (quint64(difference) << 1) ^ quint64(difference >> 63);
+
+		while(zigZag >= 0x80) {
+			*(output++) = uchar(zigZag | 0x80);
+			zigZag >>= 7;
+		}
+		*(output++) = uchar(zigZag);
+
+		previous = current;
+	}
+
+	encoded.resize(int(output - start));
+	encoded.squeeze();
+	return encoded;
+}
+
+/// Copies the block from \c start to \c end (inclusive) out of \c measurement, which is a full measurement of \c size in row-major order, to \c output.  Returns the position in \c output after the block.
+static double* copyMeasurementBlock(const double* measurement, const AMnDIndex& size, const AMnDIndex& start, const AMnDIndex& end, double* output)
+{
+	int rank = size.rank();
+	long innerCount = end.at(rank-1) - start.at(rank-1) + 1;
+	AMnDIndex index = start;
+
+	forever {
+		long offset = 0;
+		for(int mu = 0; mu < rank; mu++)
+			offset = offset*size.at(mu) + index.at(mu);
+
+		memcpy(output, measurement + offset, innerCount*sizeof(double));
+		output += innerCount;
+
+		// Step through all but the last dimension, which we just copied in one go.
+		int mu = rank-2;
+		for(; mu >= 0; mu--) {
+			if(index.at(mu) < end.at(mu)) {
+				index[mu]++;
+				break;
+			}
+			index[mu] = start.at(mu);
+		}
+
+		if(mu < 0)
+			return output;
+	}
+}
+
+AMCompressedSpectrumDataStore::AMCompressedSpectrumDataStore(QObject* parent)
+	: AMInMemoryDataStore(parent)
+{
+	compressedByteCount_ = 0;
+	rowDecodeCount_ = 0;
+	rowCache_.setMaxCost(8*1024*1024);
+}
+
+AMCompressedSpectrumDataStore::~AMCompressedSpectrumDataStore() {
+
+}
+
+bool AMCompressedSpectrumDataStore::addMeasurement(const AMMeasurementInfo &measurementDetails) {
+
+	if(measurementDetails.rank() == 0) {
+
+		if(!AMInMemoryDataStore::addMeasurement(measurementDetails))
+			return false;
+
+		rows_.append(QVector<AMCSDSRow>());
+		return true;
+	}
+
+	// already a measurement with this name?
+	if(idOfMeasurement(measurementDetails.name) != -1)
+		return false;
+
+	measurements_.append(measurementDetails);
+
+	// A scalar scan space (no scan axes) is still handled by AMInMemoryDataStore.
+	scalarScanPoint_.append(AMIMDSMeasurement(measurementDetails.spanSize()));
+	// Existing scan points need an entry to keep the indexing, but the values live in rows_.
+	for(int i=0, cc=scanPoints_.count(); i<cc; ++i)
+		scanPoints_[i].append(AMIMDSMeasurement());
+
+	long rowCount = axes_.isEmpty() ? 0 : scanSize_.at(0);
+	rows_.append(QVector<AMCSDSRow>(rowCount, AMCSDSRow(pointsPerRow())));
+
+	return true;
+}
+
+bool AMCompressedSpectrumDataStore::isCompressed(int measurementId) const {
+	return (unsigned)measurementId < (unsigned)measurements_.count() && measurements_.at(measurementId).rank() > 0 && !axes_.isEmpty();
+}
+
+AMNumber AMCompressedSpectrumDataStore::value(const AMnDIndex &scanIndex, int measurementId, const AMnDIndex &measurementIndex) const {
+
+	if(!isCompressed(measurementId))
+		return AMInMemoryDataStore::value(scanIndex, measurementId, measurementIndex);
+
+	if(scanIndex.rank() != axes_.count() || measurementIndex.rank() != measurements_.at(measurementId).rank())
+		return AMNumber(AMNumber::DimensionError);
+
+	if(!scanIndexInRange(scanIndex))
+		return AMNumber(AMNumber::OutOfBoundsError);
+
+	long point = pointInRow(scanIndex);
+	const QByteArray& encodedSpectrum = rows_.at(measurementId).at(scanIndex.i()).at(point);
+	if(encodedSpectrum.isEmpty())
+		return AMNumber();
+
+	long spanSize = measurements_.at(measurementId).spanSize();
+	int flatMeasurementIndex = flatIndexForMeasurement(measurementId, measurementIndex);
+	if((unsigned)flatMeasurementIndex >= (unsigned)spanSize)
+		return AMNumber(AMNumber::OutOfBoundsError);
+
+	// Channels left out of a partly-written spectrum are still invalid.
+	if(encodedSpectrum.at(0) == char(AMCSDS_PARTIAL_FORMAT) && !(encodedSpectrum.at(1 + flatMeasurementIndex/8) & (1 << (flatMeasurementIndex%8))))
+		return AMNumber();
+
+	return decodedRow(measurementId, scanIndex.i()).at(point*spanSize + flatMeasurementIndex);
+}
+
+bool AMCompressedSpectrumDataStore::setValue(const AMnDIndex &scanIndex, int measurementId, const AMnDIndex &measurementIndex, const AMNumber &newValue) {
+
+	if(!isCompressed(measurementId))
+		return AMInMemoryDataStore::setValue(scanIndex, measurementId, measurementIndex, newValue);
+
+	if(scanIndex.rank() != axes_.count() || measurementIndex.rank() != measurements_.at(measurementId).rank())
+		return false;
+
+	if(!scanIndexInRange(scanIndex))
+		return false;
+
+	long spanSize = measurements_.at(measurementId).spanSize();
+	int flatMeasurementIndex = flatIndexForMeasurement(measurementId, measurementIndex);
+	if((unsigned)flatMeasurementIndex >= (unsigned)spanSize)
+		return false;
+
+	// Decode the spectrum, change the one value, and encode it again.  The channels that haven't been written (ex: all the others, the first time) have to stay invalid.
+	const QByteArray& encodedSpectrum = rows_.at(measurementId).at(scanIndex.i()).at(pointInRow(scanIndex));
+	QVector<double> spectrum(spanSize);
+	decodeSpectrum(encodedSpectrum, spanSize, spectrum.data());
+	QBitArray written = writtenChannels(encodedSpectrum, spanSize);
+
+	spectrum[flatMeasurementIndex] = newValue.isValid() ? double(newValue) : AMNUMBER_INVALID_FLOATINGPOINT;
+	written.setBit(flatMeasurementIndex, newValue.isValid());
+	storeSpectrum(scanIndex, measurementId, encodeSpectrum(spectrum.constData(), written));
+
+	emitDataChanged(scanIndex, scanIndex, measurementId);
+	return true;
+}
+
+bool AMCompressedSpectrumDataStore::values(const AMnDIndex &scanIndexStart, const AMnDIndex &scanIndexEnd, int measurementId, const AMnDIndex &measurementIndexStart, const AMnDIndex &measurementIndexEnd, double *outputValues) const {
+
+	if(!isCompressed(measurementId))
+		return AMInMemoryDataStore::values(scanIndexStart, scanIndexEnd, measurementId, measurementIndexStart, measurementIndexEnd, outputValues);
+
+	int scanRank = axes_.count();
+	if(scanIndexStart.rank() != scanRank || scanIndexEnd.rank() != scanRank)
+		return false;
+
+	const AMMeasurementInfo& mi = measurements_.at(measurementId);
+	if(measurementIndexStart.rank() != mi.rank() || measurementIndexEnd.rank() != mi.rank())
+		return false;
+
+	// Unlike AMInMemoryDataStore, always check the bounds: we're copying blocks, not reading through QVector::at().
+	for(int mu=scanRank-1; mu >= 0; --mu)
+		if(scanIndexStart.at(mu) < 0 || scanIndexEnd.at(mu) < scanIndexStart.at(mu) || scanIndexEnd.at(mu) >= scanSize_.at(mu))
+			return false;
+
+	for(int mu=mi.rank()-1; mu >= 0; --mu)
+		if(measurementIndexStart.at(mu) < 0 || measurementIndexEnd.at(mu) < measurementIndexStart.at(mu) || measurementIndexEnd.at(mu) >= mi.size(mu))
+			return false;
+
+	AMnDIndex measurementSize = mi.size();
+	long spanSize = mi.spanSize();
+	bool wholeMeasurement = (measurementIndexStart.totalPointsTo(measurementIndexEnd) == spanSize);
+
+	AMnDIndex scanIndex = scanIndexStart;
+
+	for(long row = scanIndexStart.i(); row <= scanIndexEnd.i(); row++) {
+
+		// Holding our own copy keeps the row valid even if another thread pushes it out of the cache.
+		QVector<double> decoded = decodedRow(measurementId, row);
+		const double *rowValues = decoded.constData();
+
+		scanIndex[0] = row;
+		for(int mu=1; mu<scanRank; mu++)
+			scanIndex[mu] = scanIndexStart.at(mu);
+
+		forever {
+			const double *spectrum = rowValues + pointInRow(scanIndex)*spanSize;
+
+			if(wholeMeasurement) {
+				memcpy(outputValues, spectrum, spanSize*sizeof(double));
+				outputValues += spanSize;
+			}
+			else
+				outputValues = copyMeasurementBlock(spectrum, measurementSize, measurementIndexStart, measurementIndexEnd, outputValues);
+
+			// Step through the scan axes after the first, within this row.
+			int mu = scanRank-1;
+			for(; mu >= 1; mu--) {
+				if(scanIndex.at(mu) < scanIndexEnd.at(mu)) {
+					scanIndex[mu]++;
+					break;
+				}
+				scanIndex[mu] = scanIndexStart.at(mu);
+			}
+
+			if(mu < 1)
+				break;
+		}
+	}
+
+	return true;
+}
+
+bool AMCompressedSpectrumDataStore::setValue(const AMnDIndex &scanIndex, int measurementId, const int *inputData) {
+
+	if(!isCompressed(measurementId))
+		return AMInMemoryDataStore::setValue(scanIndex, measurementId, inputData);
+
+	if(scanIndex.rank() != axes_.count() || !scanIndexInRange(scanIndex))
+		return false;
+
+	storeSpectrum(scanIndex, measurementId, encodeSpectrum(inputData, measurements_.at(measurementId).spanSize()));
+
+	emitDataChanged(scanIndex, scanIndex, measurementId);
+	return true;
+}
+
+bool AMCompressedSpectrumDataStore::setValue(const AMnDIndex &scanIndex, int measurementId, const double *inputData) {
+
+	if(!isCompressed(measurementId))
+		return AMInMemoryDataStore::setValue(scanIndex, measurementId, inputData);
+
+	if(scanIndex.rank() != axes_.count() || !scanIndexInRange(scanIndex))
+		return false;
+
+	storeSpectrum(scanIndex, measurementId, encodeSpectrum(inputData, measurements_.at(measurementId).spanSize()));
+
+	emitDataChanged(scanIndex, scanIndex, measurementId);
+	return true;
+}
+
+int AMCompressedSpectrumDataStore::rowCacheSize() const {
+	QMutexLocker lock(&rowCacheMutex_);
+	return rowCache_.maxCost();
+}
+
+void AMCompressedSpectrumDataStore::setRowCacheSize(int maximumValues) {
+	QMutexLocker lock(&rowCacheMutex_);
+	rowCache_.setMaxCost(qMax(0, maximumValues));
+}
+
+qint64 AMCompressedSpectrumDataStore::uncompressedByteCount() const {
+	if(axes_.isEmpty())
+		return 0;
+
+	qint64 pointCount = scanSize_.product();
+	qint64 valueCount = 0;
+	for(int m=0, cc=measurements_.count(); m<cc; ++m)
+		if(measurements_.at(m).rank() > 0)
+			valueCount += pointCount*measurements_.at(m).spanSize();
+
+	return valueCount*qint64(sizeof(AMNumber));
+}
+
+double AMCompressedSpectrumDataStore::compressionRatio() const {
+	if(compressedByteCount_ == 0)
+		return 0;
+
+	return double(uncompressedByteCount())/double(compressedByteCount_);
+}
+
+bool AMCompressedSpectrumDataStore::beginInsertRowsImplementation(long numRows, long atRowIndex) {
+
+	long oldRowCount = scanSize_.at(0);
+
+	axes_[0].size += numRows;
+	scanSize_[0] += numRows;
+
+	long points = pointsPerRow();
+
+	// Build a scan point with storage for the scalar measurements only.
+	AMIMDSScanPoint sp;
+	for(int i=0,cc=measurements_.count(); i<cc; ++i)
+		sp.append(measurements_.at(i).rank() == 0 ? AMIMDSMeasurement(1) : AMIMDSMeasurement());
+
+	scanPoints_.insert(atRowIndex*points, numRows*points, sp);
+
+	if(!axes_.at(0).isUniform)
+		axisValues_[0].insert(atRowIndex, numRows, AMNumber());
+
+	for(int m=0, cc=measurements_.count(); m<cc; ++m)
+		if(measurements_.at(m).rank() > 0)
+			rows_[m].insert(atRowIndex, numRows, AMCSDSRow(points));
+
+	// Rows after the insert point have moved, so their cache keys are wrong now.
+	if(atRowIndex < oldRowCount) {
+		QMutexLocker lock(&rowCacheMutex_);
+		rowCache_.clear();
+	}
+
+	return true;
+}
+
+void AMCompressedSpectrumDataStore::clearScanDataPointsImplementation() {
+	AMInMemoryDataStore::clearScanDataPointsImplementation();
+
+	for(int m=0, cc=rows_.count(); m<cc; ++m)
+		rows_[m].clear();
+	compressedByteCount_ = 0;
+
+	QMutexLocker lock(&rowCacheMutex_);
+	rowCache_.clear();
+}
+
+void AMCompressedSpectrumDataStore::clearMeasurementsImplementation() {
+	AMInMemoryDataStore::clearMeasurementsImplementation();
+
+	rows_.clear();
+	compressedByteCount_ = 0;
+
+	QMutexLocker lock(&rowCacheMutex_);
+	rowCache_.clear();
+}
+
+void AMCompressedSpectrumDataStore::clearScanAxesImplementation() {
+	AMInMemoryDataStore::clearScanAxesImplementation();
+
+	QMutexLocker lock(&rowCacheMutex_);
+	rowCache_.clear();
+}
+
+long AMCompressedSpectrumDataStore::pointsPerRow() const {
+	long points = 1;
+	for(int mu=axes_.count()-1; mu>=1; --mu)
+		points *= scanSize_.at(mu);
+	return points;
+}
+
+long AMCompressedSpectrumDataStore::pointInRow(const AMnDIndex &scanIndex) const {
+	long point = 0;
+	for(int mu=1, cc=scanIndex.rank(); mu<cc; ++mu)
+		point = point*scanSize_.at(mu) + scanIndex.at(mu);
+	return point;
+}
+
+bool AMCompressedSpectrumDataStore::scanIndexInRange(const AMnDIndex &scanIndex) const {
+	for(int mu=scanIndex.rank()-1; mu>=0; --mu)
+		if((unsigned long)scanIndex.at(mu) >= (unsigned long)scanSize_.at(mu))
+			return false;
+	return true;
+}
+
+void AMCompressedSpectrumDataStore::storeSpectrum(const AMnDIndex &scanIndex, int measurementId, const QByteArray &encodedSpectrum) {
+
+	long row = scanIndex.i();
+	long point = pointInRow(scanIndex);
+
+	QByteArray& storedSpectrum = rows_[measurementId][row][point];
+	compressedByteCount_ += encodedSpectrum.size() - storedSpectrum.size();
+	storedSpectrum = encodedSpectrum;
+
+	// Keep the decoded row up to date, instead of throwing it away: the row being acquired is usually the one being plotted.
+	QMutexLocker lock(&rowCacheMutex_);
+	QVector<double>* cachedRow = rowCache_.object(rowCacheKey(measurementId, row));
+	if(cachedRow) {
+		long spanSize = measurements_.at(measurementId).spanSize();
+		decodeSpectrum(encodedSpectrum, spanSize, cachedRow->data() + point*spanSize);
+	}
+}
+
+QVector<double> AMCompressedSpectrumDataStore::decodedRow(int measurementId, long row) const {
+
+	qint64 key = rowCacheKey(measurementId, row);
+
+	{
+		QMutexLocker lock(&rowCacheMutex_);
+		QVector<double>* cachedRow = rowCache_.object(key);
+		if(cachedRow)
+			return *cachedRow;
+	}
+
+	long spanSize = measurements_.at(measurementId).spanSize();
+	const AMCSDSRow& encodedRow = rows_.at(measurementId).at(row);
+
+	QVector<double> decoded(encodedRow.count()*spanSize);
+	double* output = decoded.data();
+	for(int point=0, cc=encodedRow.count(); point<cc; ++point)
+		decodeSpectrum(encodedRow.at(point), spanSize, output + point*spanSize);
+
+	QMutexLocker lock(&rowCacheMutex_);
+	rowDecodeCount_++;
+	// QCache would delete a row that's bigger than the whole cache right away; don't bother.
+	if(decoded.size() <= rowCache_.maxCost())
+		rowCache_.insert(key, new QVector<double>(decoded), decoded.size());
+
+	return decoded;
+}
+
+QByteArray AMCompressedSpectrumDataStore::encodeSpectrum(const double *values, int count) {
+
+	bool allIntegers = true;
+	for(int i = 0; i < count && allIntegers; i++)
+		allIntegers = (fabs(values[i]) <= AMCSDS_MAXIMUM_INTEGER && values[i] == floor(values[i]));
+
+	if(allIntegers)
+		return encodeDeltaVarint(values, count);
+
+	QByteArray encoded;
+	encoded.resize(1 + count*int(sizeof(double)));
+	encoded[0] = char(AMCSDS_RAW_DOUBLE_FORMAT);
+	memcpy(encoded.data()+1, values, count*sizeof(double));
+	return encoded;
+}
+
+QByteArray AMCompressedSpectrumDataStore::encodeSpectrum(const int *values, int count) {
+	return encodeDeltaVarint(values, count);
+}
+
+QByteArray AMCompressedSpectrumDataStore::encodeSpectrum(const double *values, const QBitArray &writtenChannels) {
+
+	int count = writtenChannels.size();
+	int writtenCount = writtenChannels.count(true);
+
+	if(writtenCount == 0)
+		return QByteArray();
+
+	if(writtenCount == count)
+		return encodeSpectrum(values, count);
+
+	QByteArray encoded(1 + (count+7)/8, 0);
+	encoded[0] = char(AMCSDS_PARTIAL_FORMAT);
+	for(int i = 0; i < count; i++)
+		if(writtenChannels.testBit(i))
+			encoded[1 + i/8] = char(encoded.at(1 + i/8) | (1 << (i%8)));
+
+	encoded.append(encodeSpectrum(values, count));
+	return encoded;
+}
+
+QBitArray AMCompressedSpectrumDataStore::writtenChannels(const QByteArray &encodedSpectrum, int count) {
+
+	if(encodedSpectrum.isEmpty())
+		return QBitArray(count, false);
+
+	if(encodedSpectrum.at(0) != char(AMCSDS_PARTIAL_FORMAT))
+		return QBitArray(count, true);
+
+	QBitArray written(count);
+	for(int i = 0; i < count; i++)
+		written.setBit(i, encodedSpectrum.at(1 + i/8) & (1 << (i%8)));
+
+	return written;
+}
+
+void AMCompressedSpectrumDataStore::decodeSpectrum(const QByteArray &encodedSpectrum, int count, double *output) {
+
+	if(encodedSpectrum.isEmpty()) {
+		for(int i = 0; i < count; i++)
+			output[i] = AMNUMBER_INVALID_FLOATINGPOINT;
+		return;
+	}
+
+	const uchar *input = reinterpret_cast<const uchar*>(encodedSpectrum.constData());
+
+	// The unwritten channels of a partial spectrum were encoded as -1, so only the mask needs to be skipped.
+	if(input[0] == AMCSDS_PARTIAL_FORMAT)
+		input += 1 + (count+7)/8;
+
+	if(input[0] == AMCSDS_RAW_DOUBLE_FORMAT) {
+		memcpy(output, input+1, count*sizeof(double));
+		return;
+	}
+
+	input++;
+	qint64 previous = 0;
+
+	for(int i = 0; i < count; i++) {
+		quint64 zigZag = 0;
+		int shift = 0;
+		uchar byte;
+
+		do {
+			byte = *(input++);
+			zigZag |= quint64(byte & 0x7F) << shift;
+			shift += 7;
+		} while(byte & 0x80);
+
+		previous += qint64(zigZag >> 1) ^ -qint64(zigZag & 1);
+		output[i] = double(previous);
+	}
+}
@@ -0,0 +1,136 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMCOMPRESSEDSPECTRUMDATASTORE_H
+#define AMCOMPRESSEDSPECTRUMDATASTORE_H
+
+#include <QByteArray>
+#include <QBitArray>
+#include <QCache>
+#include <QMutex>
+#include "dataman/datastore/AMInMemoryDataStore.h"
+
+/// (Internal class for AMCompressedSpectrumDataStore) The encoded spectra of one scan row: one QByteArray for every scan point in the row.  An empty QByteArray is a spectrum that hasn't been written yet.
+typedef QVector<QByteArray> AMCSDSRow;
+
+/// This class is an in-memory data store that keeps multi-dimensional measurements (ex: XRF spectra) compressed.
+/*! AMInMemoryDataStore stores every value as an AMNumber (16 bytes).  For a 2D map with a 2048-channel spectrum at every pixel, that's 32 kB per pixel, or over a GB for a 200 x 200 map, before any analysis starts.  Detector spectra are integer counts, and neighbouring channels are usually close to each other, so they compress very well.
+
+<b>Storage</b>
+
+Scalar measurements (ex: I0, ring current) are stored exactly like AMInMemoryDataStore.  Measurements with rank 1 or higher are stored one encoded spectrum per scan point, grouped by scan row (the first scan axis):
+
+- Spectra that are all integers are stored as the differences between neighbouring channels, in zig-zag variable-length integers.  Low-count spectra take about 1 byte per channel, instead of 16.
+- Spectra with any fractional or very large values are stored as raw doubles (8 bytes per channel), so any data can still be stored exactly.
+
+Every setValue() encodes only the spectrum it writes, so filling a map point by point costs the same at the end of the scan as at the beginning.
+
+<b>Reading</b>
+
+values() decodes a whole scan row at a time, and keeps the most recently used decoded rows in a cache (see setRowCacheSize()).  Analysis blocks and plots that read row by row or pixel by pixel (ex: AM3DBinningAB) only pay for decoding a row once, as long as it stays in the cache.  Writes update a cached row in place, so the row being acquired doesn't need to be decoded again after every point.
+
+Values that have never been written read as AMNumber::Null from value(), and as -1 (AMNUMBER_INVALID_FLOATINGPOINT) from values(), the same as AMInMemoryDataStore.  That includes the other channels of a spectrum that has only been written one channel at a time: a partly-written spectrum also stores a bit mask of the channels that are valid.
+
+\note Setting a single value with setValue(scanIndex, measurementId, measurementIndex, value) re-encodes the whole spectrum.  Use the array versions of setValue() to write spectra.
+*/
+class AMCompressedSpectrumDataStore : public AMInMemoryDataStore
+{
+	Q_OBJECT
+public:
+	/// Constructs an empty data store.
+	AMCompressedSpectrumDataStore(QObject* parent = 0);
+
+	virtual ~AMCompressedSpectrumDataStore();
+
+	/// Re-implemented from AMInMemoryDataStore to keep measurements with rank 1 or higher compressed.
+	virtual bool addMeasurement(const AMMeasurementInfo& measurementDetails);
+
+	/// Re-implemented from AMInMemoryDataStore to decode compressed measurements.
+	virtual AMNumber value(const AMnDIndex& scanIndex, int measurementId, const AMnDIndex& measurementIndex) const;
+	/// Re-implemented from AMInMemoryDataStore.  For compressed measurements, this re-encodes the whole spectrum at \c scanIndex.
+	virtual bool setValue(const AMnDIndex& scanIndex, int measurementId, const AMnDIndex& measurementIndex, const AMNumber& newValue);
+	/// Re-implemented from AMInMemoryDataStore to read compressed measurements a decoded row at a time.
+	virtual bool values(const AMnDIndex& scanIndexStart, const AMnDIndex& scanIndexEnd, int measurementId, const AMnDIndex& measurementIndexStart, const AMnDIndex& measurementIndexEnd, double* outputValues) const;
+	/// Re-implemented from AMInMemoryDataStore to encode compressed measurements.
+	virtual bool setValue(const AMnDIndex &scanIndex, int measurementId, const int* inputData);
+	/// Re-implemented from AMInMemoryDataStore to encode compressed measurements.
+	virtual bool setValue(const AMnDIndex &scanIndex, int measurementId, const double* inputData);
+
+	/// Returns true if \c measurementId is stored compressed (ie: it has rank 1 or higher, and there is at least one scan axis.)
+	bool isCompressed(int measurementId) const;
+
+	/// The maximum number of decoded values kept in the row cache.  The default is 8M values (64 MB).
+	int rowCacheSize() const;
+	/// Sets the maximum number of decoded values kept in the row cache.  Rows bigger than this are still decoded, but never cached.
+	void setRowCacheSize(int maximumValues);
+
+	/// The number of bytes used by the encoded spectra of all compressed measurements.
+	qint64 compressedByteCount() const { return compressedByteCount_; }
+	/// The number of bytes AMInMemoryDataStore would use for the same compressed measurements (one AMNumber for every value.)
+	qint64 uncompressedByteCount() const;
+	/// uncompressedByteCount() / compressedByteCount(), or 0 if nothing has been written.
+	double compressionRatio() const;
+	/// The number of times a row has been decoded since the store was created.  Useful for checking the effectiveness of the row cache.
+	int rowDecodeCount() const { return rowDecodeCount_; }
+
+protected:
+	/// Re-implemented from AMInMemoryDataStore to leave out the AMNumber storage for compressed measurements.
+	virtual bool beginInsertRowsImplementation(long numRows, long atRowIndex);
+	virtual void clearScanDataPointsImplementation();
+	virtual void clearMeasurementsImplementation();
+	virtual void clearScanAxesImplementation();
+
+	/// Returns the number of scan points in one scan row (the product of the sizes of all scan axes after the first.)
+	long pointsPerRow() const;
+	/// Returns the position of \c scanIndex within its row (the flat index of all but the first scan index.)
+	long pointInRow(const AMnDIndex& scanIndex) const;
+	/// Returns true if \c scanIndex is within the current scan size.
+	bool scanIndexInRange(const AMnDIndex& scanIndex) const;
+
+	/// Stores \c encodedSpectrum for \c measurementId at \c scanIndex, and updates the decoded row if it's in the cache.
+	void storeSpectrum(const AMnDIndex& scanIndex, int measurementId, const QByteArray& encodedSpectrum);
+	/// Returns the decoded values of \c row in \c measurementId, from the row cache or by decoding it.
+	QVector<double> decodedRow(int measurementId, long row) const;
+	/// The row cache key for \c row in \c measurementId
+	qint64 rowCacheKey(int measurementId, long row) const { return (qint64(measurementId) << 40) | qint64(row); }
+
+	/// Encodes \c count values from \c values.  Uses delta / variable-length integers if all the values are integers, and raw doubles otherwise.
+	static QByteArray encodeSpectrum(const double* values, int count);
+	/// Encodes \c count integer values from \c values.
+	static QByteArray encodeSpectrum(const int* values, int count);
+	/// Encodes a spectrum where only the channels set in \c writtenChannels are valid.  Returns an empty QByteArray (never written) if none are set, and the normal encoding if all of them are.  The values of the other channels should be -1 (AMNUMBER_INVALID_FLOATINGPOINT).
+	static QByteArray encodeSpectrum(const double* values, const QBitArray& writtenChannels);
+	/// Decodes \c encodedSpectrum into \c count values at \c output.  An empty \c encodedSpectrum decodes to -1 (AMNUMBER_INVALID_FLOATINGPOINT) for every value.
+	static void decodeSpectrum(const QByteArray& encodedSpectrum, int count, double* output);
+	/// Returns which of the \c count channels of \c encodedSpectrum have been written: none for an empty spectrum, all of them unless it was only partly written.
+	static QBitArray writtenChannels(const QByteArray& encodedSpectrum, int count);
+
+	/// The encoded spectra, indexed by measurement id and then by row.  Empty for scalar measurements.
+	QVector<QVector<AMCSDSRow> > rows_;
+	/// The total size of all the encoded spectra
+	qint64 compressedByteCount_;
+
+	/// Recently decoded rows, keyed by rowCacheKey().  The cost of each row is its number of values.
+	mutable QCache<qint64, QVector<double> > rowCache_;
+	/// Protects rowCache_, so that several threads can read at the same time.
+	mutable QMutex rowCacheMutex_;
+	mutable int rowDecodeCount_;
+};
+
+#endif // AMCOMPRESSEDSPECTRUMDATASTORE_H
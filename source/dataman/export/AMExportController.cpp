@@ -27,6 +27,9 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 #include <QStandardItemModel>
 #include <QStringBuilder>
+#include <QThreadPool>
+#include <QThread>
+#include <QMetaProperty>
 
 #include "dataman/export/AMExporter.h"
 #include "dataman/export/AMExporterOption.h"
@@ -53,6 +56,12 @@ AMExportController::AMExportController(const QList<QUrl>& scansToExport) :
 	exportScanIndex_ = -1;
 	succeededCount_ = failedCount_ = 0;
 
+	parallelExportEnabled_ = false;
+	parallelExportActive_ = false;
+	maximumScansInFlight_ = qMax(1, QThread::idealThreadCount());
+	exportPool_ = 0;
+	nextParallelScanIndex_ = 0;
+
 	destinationFolderPath_ = AMUser::user()->lastExportDestination();
 	if(destinationFolderPath_.isEmpty())
 		destinationFolderPath_ = QDir::toNativeSeparators(QDir::homePath());
@@ -75,6 +84,12 @@ AMExportController::AMExportController(const QList<AMScan*>& scansToExport) :
 	exportScanIndex_ = -1;
 	succeededCount_ = failedCount_ = 0;
 
+	parallelExportEnabled_ = false;
+	parallelExportActive_ = false;
+	maximumScansInFlight_ = qMax(1, QThread::idealThreadCount());
+	exportPool_ = 0;
+	nextParallelScanIndex_ = 0;
+
 	destinationFolderPath_ = AMUser::user()->lastExportDestination();
 	if(destinationFolderPath_.isEmpty())
 		destinationFolderPath_ = QDir::toNativeSeparators(QDir::homePath());
@@ -204,6 +219,21 @@ void AMExportController::addFoundAvailableDataSource(const QString &name, const
 	availableDataSourcesModel_->sort(1, Qt::AscendingOrder); // and (re)-sort by rank.
 }
 
+// Helper function that returns true if any of the text settings of \c option (ex: the file name templates) use the $fsIndex keyword.
+static bool amExportOptionUsesFileSystemIndex(const AMExporterOption *option)
+{
+	const QMetaObject *metaObject = option->metaObject();
+
+	for(int i = 0, count = metaObject->propertyCount(); i < count; i++) {
+
+		QMetaProperty property = metaObject->property(i);
+		if(property.type() == QVariant::String && property.read(option).toString().contains("$fsIndex"))
+			return true;
+	}
+
+	return false;
+}
+
 bool AMExportController::start(bool autoExport)
 {
 	if(!exporter_)
@@ -215,6 +245,23 @@ bool AMExportController::start(bool autoExport)
 		return false;	// Can't start except from this state
 
 	exportScanIndex_ = 0;
+	parallelExportActive_ = parallelExportEnabled_ && usingScanURLs_ && scanCount() > 1;
+
+	// $fsIndex numbers scans (and stores them) as they're written; that has to happen one at a time, on this thread.
+	if(parallelExportActive_ && amExportOptionUsesFileSystemIndex(option_)) {
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Information, 0, "The file names use $fsIndex, so the scans will be exported one at a time."));
+		parallelExportActive_ = false;
+	}
+
+	if(parallelExportActive_) {
+		nextParallelScanIndex_ = 0;
+		deferredScanIndexes_.clear();
+		pathClaims_.clear();
+
+		exportPool_ = new QThreadPool(this);
+		exportPool_->setMaxThreadCount(maximumScansInFlight_);
+	}
+
 	emit stateChanged(state_ = Exporting);
 
 	if (autoExport)
@@ -226,69 +273,70 @@ bool AMExportController::start(bool autoExport)
 	return true;
 }
 
+void AMExportController::setParallelExportEnabled(bool enabled)
+{
+	if(state_ == Preparing)
+		parallelExportEnabled_ = enabled;
+}
+
+void AMExportController::setMaximumScansInFlight(int maximumScansInFlight)
+{
+	if(state_ == Preparing)
+		maximumScansInFlight_ = qMax(1, maximumScansInFlight);
+}
+
+bool AMExportController::parseScanUrl(const QUrl &url, AMDatabase *&database, QString &tableName, int &id)
+{
+	QStringList path;
+	bool idOkay = false;
+
+	return url.scheme() == "amd" &&
+			(database = AMDatabase::database(url.host())) &&
+			(path = url.path().split('/', QString::SkipEmptyParts)).count() == 2 &&
+			(id = path.at(1).toInt(&idOkay)) > 0 &&
+			idOkay == true &&
+			(tableName = path.at(0)).isEmpty() == false;
+}
+
 void AMExportController::continueScanExport()
 {
 	if(state_ != Exporting)
 		return;	// done, or paused. Don't keep going.
 
+	if(parallelExportActive_) {
+		continueParallelScanExport();
+		return;
+	}
+
 	// 0. emit progress and signals
 	emit progressChanged(exportScanIndex_, scanCount());
 
 	// 1. Check for finished:
 	if(exportScanIndex_ >= scanCount()) {
-		emit stateChanged(state_ = Finished);
-
-		// Reset whether the exporter should overwrite files with matching filenames.
-		exporter_->setOverwriteOption(AMExporter::Default);
+		finishExport();
+		return; // We're done!
+	}
 
-		QString message = "Exported " % QString::number(succeededCount()) % " scans.";
-		if(failedCount())
-			message.append("  (" % QString::number(failedCount()) % " scans could not be exported.)");
-		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Information, 0, message));
+	// 2. - 4. Load and export
+	exportScanAt(exportScanIndex_);
 
-		AMUser::user()->setLastExportDestination(destinationFolderPath());
-		AMUser::user()->storeToDb(AMUser::user()->database());
+	// 5. increment exportScanIndex_ and re-schedule next one
+	exportScanIndex_++;
+	QTimer::singleShot(5, this, SLOT(continueScanExport()));
 
-		deleteLater();
-		return; // We're done!
-	}
+}
 
+void AMExportController::exportScanAt(int scanIndex)
+{
 	try {
 		// 2. Load scan from db and check loaded successfully
 
 
 		AMScan* scan = 0;
-		AMDbObject* databaseObject = 0;
-		if(usingScanURLs_){
-			const QUrl& url = scanURLsToExport_.at(exportScanIndex_);
-			AMDatabase* db = 0;
-			QStringList path;
-			QString tableName;
-			int id = 0;
-			bool idOkay = false;
-
-			// parse the URL and make sure it's valid
-			if(!( url.scheme() == "amd" &&
-				  (db = AMDatabase::database(url.host())) &&
-				  (path = url.path().split('/', QString::SkipEmptyParts)).count() == 2 &&
-				  (id = path.at(1).toInt(&idOkay)) > 0 &&
-				  idOkay == true &&
-				  (tableName = path.at(0)).isEmpty() == false
-				  ))
-				throw QString("The export system couldn't understand the scan URL '" % url.toString() % "', so this scan has not been exported.");
-			emit statusChanged(status_ = "Opening: " % url.toString());
-
-			databaseObject = AMDbObjectSupport::s()->createAndLoadObjectAt(db, tableName, id);
-			scan = qobject_cast<AMScan*>(databaseObject);
-
-			if(!scan) {
-				delete databaseObject;
-				throw QString("The export system couldn't load a scan out of the database (" % url.toString() % "), so this scan has not been exported.");
-			}
-			scan->retain(this);
-		}
+		if(usingScanURLs_)
+			scan = loadScanAt(scanIndex);
 		else if(usingScanObjects_) {
-			scan = scanObjectsToExport_.at(exportScanIndex_);
+			scan = scanObjectsToExport_.at(scanIndex);
 			if(!scan)
 				throw QString("An invalid scan reference was provided, so this scan has not been exported.");
 		}
@@ -305,7 +353,7 @@ void AMExportController::continueScanExport()
 		}
 
 		// 4. Export
-		QString writtenFile = exporter_->exportScan(scan, destinationFolderPath_, option_, exportScanIndex_);
+		QString writtenFile = exporter_->exportScan(scan, destinationFolderPath_, option_, scanIndex);
 		if(writtenFile.isNull()) {
 			QString err("Export failed for scan '" % scan->fullName() % "'.");
 			emit statusChanged(status_ = err);
@@ -322,11 +370,136 @@ void AMExportController::continueScanExport()
 		failedCount_++;
 		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -1, errMsg));
 	}
+}
 
-	// 5. increment exportScanIndex_ and re-schedule next one
-	exportScanIndex_++;
-	QTimer::singleShot(5, this, SLOT(continueScanExport()));
+AMScan* AMExportController::loadScanAt(int scanIndex)
+{
+	const QUrl& url = scanURLsToExport_.at(scanIndex);
+	AMDatabase* db = 0;
+	QString tableName;
+	int id = 0;
+
+	// parse the URL and make sure it's valid
+	if(!parseScanUrl(url, db, tableName, id))
+		throw QString("The export system couldn't understand the scan URL '" % url.toString() % "', so this scan has not been exported.");
+	emit statusChanged(status_ = "Opening: " % url.toString());
+
+	AMDbObject* databaseObject = AMDbObjectSupport::s()->createAndLoadObjectAt(db, tableName, id);
+	AMScan* scan = qobject_cast<AMScan*>(databaseObject);
+
+	if(!scan) {
+		delete databaseObject;
+		throw QString("The export system couldn't load a scan out of the database (" % url.toString() % "), so this scan has not been exported.");
+	}
+	scan->retain(this);
 
+	return scan;
+}
+
+void AMExportController::continueParallelScanExport()
+{
+	emit progressChanged(exportScanIndex_, scanCount());
+
+	// Load the next scan here, on the GUI thread: the file loader plugins and the CDF library aren't thread-safe.  Only the writing is handed to the workers.  Never hold more than maximumScansInFlight_ scans in memory.
+	if(scansInFlight_.count() < maximumScansInFlight_ && nextParallelScanIndex_ < scanCount()) {
+
+		int scanIndex = nextParallelScanIndex_++;
+
+		try {
+			AMScan *scan = loadScanAt(scanIndex);
+
+			if(!exporter_->isValidFor(scan, option_)) {
+				QString err("The exporter '" % exporter_->description() % "' and the template '" % option_->name() % "' are not compatible with this scan (" % scan->fullName() % "), so it has not been exported.");
+				scan->release(this);
+				throw err;
+			}
+
+			emit statusChanged(status_ = "Writing: " % scan->fullName());
+
+			AMExportControllerScanRunnable *runnable = new AMExportControllerScanRunnable(this,
+																						   scanIndex,
+																						   scan,
+																						   exporter_->metaObject(),
+																						   exporter_->overwriteOption(),
+																						   option_,
+																						   destinationFolderPath_,
+																						   &pathClaims_);
+			runnable->setAutoDelete(true);
+
+			scansInFlight_.insert(scanIndex, scan);
+			exportPool_->start(runnable);
+		}
+
+		catch(QString errMsg) {
+			exportScanIndex_++;
+			failedCount_++;
+			emit statusChanged(status_ = errMsg);
+			AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -1, errMsg));
+		}
+
+		// Give the event loop a turn between loading scans.
+		QTimer::singleShot(0, this, SLOT(continueScanExport()));
+		return;
+	}
+
+	if(!scansInFlight_.isEmpty() || nextParallelScanIndex_ < scanCount())
+		return;	// we'll be back when the next one finishes.
+
+	// The workers are done.  Export anything they had to leave for us, one at a time like the serial export.
+	if(!deferredScanIndexes_.isEmpty()) {
+		exportScanAt(deferredScanIndexes_.takeFirst());
+		exportScanIndex_++;
+		QTimer::singleShot(5, this, SLOT(continueScanExport()));
+		return;
+	}
+
+	finishExport();
+}
+
+void AMExportController::onParallelScanExported(int scanIndex, const QString &writtenFile, const QString &errorMessage, bool deferred)
+{
+	// The worker is done with the scan.  It lives in this thread, so this is where we let it go.
+	AMScan *scan = scansInFlight_.take(scanIndex);
+	if(scan)
+		scan->release(this);
+
+	if(deferred)
+		deferredScanIndexes_.insert(qLowerBound(deferredScanIndexes_.begin(), deferredScanIndexes_.end(), scanIndex), scanIndex);
+
+	else {
+		exportScanIndex_++;
+
+		if(writtenFile.isNull()) {
+			failedCount_++;
+			emit statusChanged(status_ = errorMessage);
+			AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -1, errorMessage));
+		}
+
+		else {
+			succeededCount_++;
+			emit statusChanged(status_ = "Wrote: " % writtenFile);
+		}
+	}
+
+	continueScanExport();
+}
+
+void AMExportController::finishExport()
+{
+	emit stateChanged(state_ = Finished);
+
+	// Reset whether the exporter should overwrite files with matching filenames.
+	exporter_->setOverwriteOption(AMExporter::Default);
+
+	QString message = "Exported " % QString::number(succeededCount()) % " scans.";
+	if(failedCount())
+		message.append("  (" % QString::number(failedCount()) % " scans could not be exported.)");
+	AMErrorMon::report(AMErrorReport(this, AMErrorReport::Information, 0, message));
+
+	AMUser::user()->setLastExportDestination(destinationFolderPath());
+	AMUser::user()->storeToDb(AMUser::user()->database());
+
+	deleteLater();
 }
 
 void AMExportController::setOption(AMExporterOption *option) {
@@ -347,7 +520,12 @@ bool AMExportController::cancel()
 }
 
 AMExportController::~AMExportController() {
-	// nothing for now
+	// The workers use our scans, option_ and pathClaims_: make sure they're done with them.  Any results they queued for us are dropped along with us, so release their scans here.
+	if(exportPool_)
+		exportPool_->waitForDone();
+
+	foreach(AMScan *scan, scansInFlight_)
+		scan->release(this);
 }
 
 bool AMExportController::pause()
@@ -370,3 +548,38 @@ bool AMExportController::resume()
 	return true;
 }
 
+
+AMExportControllerScanRunnable::AMExportControllerScanRunnable(AMExportController *controller, int scanIndex, AMScan *scan, const QMetaObject *exporterMetaObject, AMExporter::OverwriteOption overwriteOption, const AMExporterOption *option, const QString &destinationFolderPath, AMExporterPathClaims *pathClaims)
+	: QRunnable()
+{
+	controller_ = controller;
+	scanIndex_ = scanIndex;
+	scan_ = scan;
+	exporterMetaObject_ = exporterMetaObject;
+	overwriteOption_ = overwriteOption;
+	option_ = option;
+	destinationFolderPath_ = destinationFolderPath;
+	pathClaims_ = pathClaims;
+}
+
+void AMExportControllerScanRunnable::run()
+{
+	// The exporter is created and deleted in this worker thread.  The scan was loaded on the GUI thread, which leaves it alone until we report back.
+	AMExporter *exporter = qobject_cast<AMExporter*>(exporterMetaObject_->newInstance());
+	exporter->setOverwriteOption(overwriteOption_);
+	exporter->setInteractive(false);
+	exporter->setPathClaims(pathClaims_);
+
+	QString writtenFile = exporter->exportScan(scan_, destinationFolderPath_, option_, scanIndex_);
+	QString errorMessage;
+	bool deferred = false;
+
+	if(writtenFile.isNull()) {
+		deferred = exporter->overwriteConfirmationNeeded();
+		errorMessage = "Export failed for scan '" % scan_->fullName() % "'.";
+	}
+
+	delete exporter;
+
+	QMetaObject::invokeMethod(controller_, "onParallelScanExported", Qt::QueuedConnection, Q_ARG(int, scanIndex_), Q_ARG(QString, writtenFile), Q_ARG(QString, errorMessage), Q_ARG(bool, deferred));
+}
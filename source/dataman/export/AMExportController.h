@@ -25,9 +25,13 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMetaObject>
 #include <QHash>
 #include <QUrl>
+#include <QRunnable>
 #include "util/AMErrorMonitor.h"
+#include "dataman/export/AMExporter.h"
 
 class QStandardItemModel;
+class QThreadPool;
+class AMDatabase;
 
 /// This helper class is used by AMExportController to register the available exporters.  You should normally not need to use it directly.
 class AMExporterInfo {
@@ -48,7 +52,6 @@ public:
 
 };
 
-class AMExporter;
 class AMExporterOption;
 class AMScan;
 
@@ -67,6 +70,16 @@ class AMScan;
 
   - Call startExport() to start writing the files.  You can monitor progress() and progressChanged(), as well as status() and statusChanged(), while the exporter is running.  You can also call cancel() to give up at the current point.
 
+<b>Parallel export</b>
+
+When exporting from database URLs, a lot of the time goes into formatting and writing each file.  Calling setParallelExportEnabled(true) before start() (or checking "Export several scans at once" in the AMExportWizard) writes the files on a pool of worker threads instead of one at a time on the GUI thread.  The scans themselves are still loaded one at a time on the GUI thread, since the file loader plugins (and the CDF library) are not thread-safe.  Each loaded scan is then handed to a worker, which writes it with its own instance of the chosen exporter.  The GUI thread doesn't touch a scan while a worker has it, and releases it once the worker is done.  At most maximumScansInFlight() scans are held in memory at once.  progressChanged() is emitted every time a scan is finished, and the scans keep the same auto-index they would have in a serial export, so the files written are identical.
+
+Workers can't ask the user whether to overwrite an existing file.  Scans that would have needed to ask, or that would have written the same file as a scan being exported at the same time, are exported afterwards on the GUI thread (in their original order) exactly like the serial export would.
+
+Exporting a list of AMScan objects always uses the serial export, since those scans may still be in use by the rest of the program.
+
+So does an option whose file names use the $fsIndex keyword.  That number is chosen by looking at the files already in the destination folder, and is then stored in the scan with AMScan::setNumber() and storeToDb().  Neither can be done safely from a worker: the scan and the database belong to the GUI thread, and workers running at the same time would see the same files and choose the same number.
+
 Note that creating an AMExportWizard on an export controller will handle all but the first two steps for you, through a user-driven GUI interface:
 \code
 AMExportController exportController(myListOfScansToExport);
@@ -132,6 +145,9 @@ public:
 	}
 
 
+	/// Parses a scan URL in the amd://databaseConnectionName/tableName/objectId format.  Returns false if it isn't valid.
+	static bool parseScanUrl(const QUrl &url, AMDatabase *&database, QString &tableName, int &id);
+
 	/// Access the set of currently-registered exporters
 	static const QHash<QString, AMExporterInfo>& registeredExporters() { return registeredExporters_; }
 
@@ -177,6 +193,13 @@ public:
 	/// Returns the current progress of the export process: the current scan index (from 0 to scanCount())
 	int progress() const { return exportScanIndex_; }
 
+	/// Returns whether scans will be written on worker threads.  Only used when exporting from database URLs.
+	bool parallelExportEnabled() const { return parallelExportEnabled_; }
+	/// The maximum number of scans held in memory at the same time by a parallel export.
+	int maximumScansInFlight() const { return maximumScansInFlight_; }
+	/// Returns whether the export that has been started is running on worker threads.  This is false when parallelExportEnabled() can't be used (see the class description).
+	bool parallelExportActive() const { return parallelExportActive_; }
+
 
 
 
@@ -210,6 +233,11 @@ public slots:
 	/// Call to resume an export in progress.  Will return false if the export is not currently in the Paused state().
 	bool resume();
 
+	/// Sets whether scans will be written on worker threads.  Must be called before start().
+	void setParallelExportEnabled(bool enabled);
+	/// Sets the maximum number of scans held in memory at the same time by a parallel export (one per worker thread).  Must be called before start().
+	void setMaximumScansInFlight(int maximumScansInFlight);
+
 	/// Number of scans successfully exported so far
 	int succeededCount() const { return succeededCount_; }
 	/// Number of scans that failed so far with an error
@@ -269,12 +297,64 @@ protected:
 	/// Number of scans exported, failed
 	int succeededCount_, failedCount_;
 
+	/// Whether the scans will be written on worker threads.
+	bool parallelExportEnabled_;
+	/// Whether the current export is running on worker threads.
+	bool parallelExportActive_;
+	/// The maximum number of scans exported at once by a parallel export.
+	int maximumScansInFlight_;
+	/// The worker threads for a parallel export.  0 until a parallel export is started.
+	QThreadPool *exportPool_;
+	/// The scans currently being written by the workers, by scan index.  They are retained by us, and released on the GUI thread when the worker is done.
+	QHash<int, AMScan*> scansInFlight_;
+	/// The index of the next scan to hand to a worker.
+	int nextParallelScanIndex_;
+	/// The indexes of scans that the workers couldn't export without asking the user. They are exported on the GUI thread once the workers are done, in order.
+	QList<int> deferredScanIndexes_;
+	/// The files claimed by the workers, so that two of them never write to the same file.
+	AMExporterPathClaims pathClaims_;
+
+	/// Loads and exports the scan at \c scanIndex on the GUI thread, using exporter_.
+	void exportScanAt(int scanIndex);
+	/// Loads the scan at \c scanIndex from the database and retains it.  Throws a QString error message if it can't be loaded.
+	AMScan* loadScanAt(int scanIndex);
+	/// Loads the next scan on the GUI thread and hands it to the workers, and once they are all done, exports any deferred scans and finishes.
+	void continueParallelScanExport();
+	/// Reports the results and cleans up once all the scans have been exported.
+	void finishExport();
+
 protected slots:
 	/// Called periodically to search scans for their data sources
 	void continueAvailableDataSourceSearch();
 
 	/// Called repeatedly to export the current scan
 	void continueScanExport();
+
+	/// Called (through a queued connection) when a worker has finished with the scan at \c scanIndex.  \c writtenFile is null if it failed, in which case \c errorMessage explains why, unless \c deferred is true and the scan should be exported again on the GUI thread.
+	void onParallelScanExported(int scanIndex, const QString &writtenFile, const QString &errorMessage, bool deferred);
+};
+
+/// This class writes a single, already loaded, scan on one of AMExportController's worker threads.  You should normally not need to use it directly.
+/*! It isn't a QObject, so nothing is left behind for the worker thread to delete except the exporter it creates (and deletes) itself.  The result is reported by queuing a call to AMExportController::onParallelScanExported() on the GUI thread.  The scan is not released here: that has to happen on the GUI thread, where it lives.
+*/
+class AMExportControllerScanRunnable : public QRunnable
+{
+public:
+	/// Constructor. The \c scan is exported using a new instance of the exporter described by \c exporterMetaObject, and the result is reported to \c controller.  The \c scan, \c option and \c pathClaims must remain valid until the runnable is finished.
+	AMExportControllerScanRunnable(AMExportController *controller, int scanIndex, AMScan *scan, const QMetaObject *exporterMetaObject, AMExporter::OverwriteOption overwriteOption, const AMExporterOption *option, const QString &destinationFolderPath, AMExporterPathClaims *pathClaims);
+
+	/// Exports the scan. Runs on a worker thread.
+	virtual void run();
+
+protected:
+	AMExportController *controller_;
+	int scanIndex_;
+	AMScan *scan_;
+	const QMetaObject *exporterMetaObject_;
+	AMExporter::OverwriteOption overwriteOption_;
+	const AMExporterOption *option_;
+	QString destinationFolderPath_;
+	AMExporterPathClaims *pathClaims_;
 };
 
 #endif // AMEXPORTCONTROLLER_H
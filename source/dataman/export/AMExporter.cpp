@@ -23,6 +23,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QStringBuilder>
 #include <QMessageBox>
+#include <QFileInfo>
+#include <QMutexLocker>
 
 #include "util/AMTagReplacementParser.h"
 #include "dataman/AMScan.h"
@@ -33,6 +35,9 @@ AMExporter::AMExporter(QObject *parent) : QObject(parent) {
 
 	autoIndex_ = 0;
 	overwriteAll_ = Default;
+	interactive_ = true;
+	overwriteConfirmationNeeded_ = false;
+	pathClaims_ = 0;
 
 	keywordParser_ = new AMTagReplacementParser();
 
@@ -48,6 +53,23 @@ AMExporter::~AMExporter() {
 	delete keywordParser_;
 }
 
+bool AMExporterPathClaims::claim(const QString &filePath)
+{
+	QMutexLocker locker(&mutex_);
+
+	if (claimedPaths_.contains(filePath))
+		return false;
+
+	claimedPaths_.insert(filePath);
+	return true;
+}
+
+void AMExporterPathClaims::clear()
+{
+	QMutexLocker locker(&mutex_);
+	claimedPaths_.clear();
+}
+
 const QMetaObject* AMExporter::getMetaObject(){
 	return metaObject();
 }
@@ -59,11 +81,24 @@ bool AMExporter::openFile(const QString &filePath)
 
 bool AMExporter::openFile(QFile* file, const QString& filePath) {
 
+	// Another exporter running at the same time is writing this file.  Leave it for later, when we'll be able to do whatever the serial export would have done.
+	if (pathClaims_ && !pathClaims_->claim(QFileInfo(filePath).absoluteFilePath())){
+
+		overwriteConfirmationNeeded_ = true;
+		return false;
+	}
+
 	bool fileExists = QFile::exists(filePath);
 
 	if (fileExists && overwriteAll_ == None)
 		return false;
 
+	else if (fileExists && overwriteAll_ == Default && !interactive_){
+
+		overwriteConfirmationNeeded_ = true;
+		return false;
+	}
+
 	else if (fileExists && overwriteAll_ == Default){
 
 		QMessageBox::StandardButton button = QMessageBox::question(0, "Overwrite file?",
@@ -23,6 +23,8 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QHash>
+#include <QSet>
+#include <QMutex>
 
 
 class AMExporterOption;
@@ -32,6 +34,23 @@ class QFile;
 class AMTagReplacementParser;
 class AMAbstractTagReplacementFunctor;
 
+/// This helper class keeps track of the files written by several exporters running at the same time, so that two of them never write to the same file.  It is thread-safe.  You should normally not need to use it directly: AMExportController uses it for parallel exports.
+class AMExporterPathClaims
+{
+public:
+	/// Constructor.
+	AMExporterPathClaims() {}
+
+	/// Claims \c filePath for the caller. Returns false if another exporter has already claimed it.
+	bool claim(const QString &filePath);
+	/// Forgets all claimed paths.
+	void clear();
+
+protected:
+	QMutex mutex_;
+	QSet<QString> claimedPaths_;
+};
+
 /// This class defines the interface for objects which can be used export scans in different formats.  For example, AMExporterGeneralAscii, AMExporterExcel, AMExporterOrigin, and AMExporterNexus all inherit this interface.
 /*! To implement a new exporter, you must subclass AMExporter.  Additionally, you must declare a default constructor and tag it with the Q_INVOKABLE macro, and call AMExportController::registerExporter<MyExporterSubclass>() to make it known to the export system. */
 class AMExporter : public QObject
@@ -81,6 +100,18 @@ For example: AMExporterGeneralAscii::exporterOptionClassName() would probably re
 	/// Sets whether the exporter will overwrite all files with matching filenames.
 	void setOverwriteOption(OverwriteOption overwrite) { overwriteAll_ = overwrite; }
 
+	/// Returns whether the exporter may ask the user questions (ex: whether to overwrite an existing file).  True by default.
+	bool isInteractive() const { return interactive_; }
+	/// Sets whether the exporter may ask the user questions.  Exporters running outside of the GUI thread must not be interactive: instead of asking, openFile() fails and overwriteConfirmationNeeded() becomes true.
+	void setInteractive(bool interactive) { interactive_ = interactive; }
+	/// Returns true if a non-interactive exporter could not open a file because it would have needed to ask the user first, or because another exporter sharing its pathClaims() is writing the same file.
+	bool overwriteConfirmationNeeded() const { return overwriteConfirmationNeeded_; }
+
+	/// Returns the set of paths shared with other exporters running at the same time, or 0 if this exporter runs alone.
+	AMExporterPathClaims* pathClaims() const { return pathClaims_; }
+	/// Sets the set of paths shared with other exporters running at the same time.  Every file opened by openFile() is claimed in it first.  The claims are not owned by the exporter.
+	void setPathClaims(AMExporterPathClaims *pathClaims) { pathClaims_ = pathClaims; }
+
 signals:
 
 public slots:
@@ -145,6 +176,12 @@ protected:
 
 	/// Flag used if a scan should overwrite all pre-existing files with the same name.
 	OverwriteOption overwriteAll_;
+	/// Whether we can ask the user questions.
+	bool interactive_;
+	/// Set when a non-interactive exporter refused to open a file instead of asking.
+	bool overwriteConfirmationNeeded_;
+	/// Paths shared with other exporters running at the same time. Not owned.
+	AMExporterPathClaims *pathClaims_;
 
 	///////////////////////////////
 	// functions to implement the keyword replacement system
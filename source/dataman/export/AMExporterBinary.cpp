@@ -0,0 +1,303 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMExporterBinary.h"
+
+#include <QFile>
+#include <QStringBuilder>
+#include <QVariantMap>
+#include <QVector>
+#include <QtEndian>
+#include <qnumeric.h>
+
+#include <string.h>
+
+#include "dataman/export/AMExporterOptionBinary.h"
+#include "dataman/AMScan.h"
+#include "util/AMErrorMonitor.h"
+#include "source/qjson/serializer.h"
+
+AMExporterBinary::AMExporterBinary(QObject *parent) :
+	AMExporter(parent)
+{
+}
+
+const QMetaObject* AMExporterBinary::getMetaObject(){
+	return metaObject();
+}
+
+AMExporterOption* AMExporterBinary::createDefaultOption() const
+{
+	return new AMExporterOptionBinary();
+}
+
+bool AMExporterBinary::isValidFor(const AMScan *scan, const AMExporterOption *option) const
+{
+	Q_UNUSED(scan)
+
+	if(!qobject_cast<const AMExporterOptionBinary*>(option)) {
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -2, "Invalid options specified for the Binary Exporter. Please report this bug to the Acquaman developers."));
+		return false;
+	}
+
+	return true;
+}
+
+QString AMExporterBinary::exportScan(const AMScan *scan, const QString &destinationFolderPath, const AMExporterOption *option, int autoIndex)
+{
+	setCurrentAutoIndex(autoIndex);
+	setCurrentFilename(option->fileName());
+	setDestinationFolderPath(destinationFolderPath);
+	setCurrentScan(scan);
+
+	const AMExporterOptionBinary *binaryOption = qobject_cast<const AMExporterOptionBinary*>(option);
+	if(!binaryOption) {
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -2, "Invalid options specified for the Binary Exporter. Please report this bug to the Acquaman developers."));
+		return QString();
+	}
+
+	// 1. Which data sources?
+	QList<const AMDataSource*> sources;
+	QStringList kinds;
+
+	if(binaryOption->includeRawDataSources()) {
+		for(int i = 0, size = scan->rawDataSourceCount(); i < size; i++) {
+			sources << scan->rawDataSources()->at(i);
+			kinds << "raw";
+		}
+	}
+
+	if(binaryOption->includeAnalyzedDataSources()) {
+		for(int i = 0, size = scan->analyzedDataSourceCount(); i < size; i++) {
+			sources << scan->analyzedDataSources()->at(i);
+			kinds << "analyzed";
+		}
+	}
+
+	// 2. Lay out the data section and describe it in the header.  Each data source gets its axis arrays, followed by its data.
+	bool singlePrecision = binaryOption->singlePrecision();
+	int bytesPerValue = singlePrecision ? 4 : 8;
+	qint64 offset = 0;
+	QVariantList dataSourceDescriptions;
+
+	for(int s = 0, sSize = sources.count(); s < sSize; s++) {
+
+		const AMDataSource *source = sources.at(s);
+		QVariantMap description;
+		QVariantList sizes;
+		QVariantList axisDescriptions;
+
+		for(int a = 0, rank = source->rank(); a < rank; a++) {
+
+			AMAxisInfo axis = source->axisInfoAt(a);
+			QVariantMap axisDescription;
+			axisDescription.insert("name", axis.name);
+			axisDescription.insert("description", axis.description);
+			axisDescription.insert("units", axis.units);
+			axisDescription.insert("size", qlonglong(source->size(a)));
+			axisDescription.insert("isUniform", axis.isUniform);
+			axisDescription.insert("dataType", "float64");
+			axisDescription.insert("offset", offset);
+			axisDescription.insert("byteCount", qlonglong(source->size(a))*8);
+			axisDescriptions << axisDescription;
+
+			sizes << qlonglong(source->size(a));
+			offset += qlonglong(source->size(a))*8;
+		}
+
+		qint64 byteCount = valueCount(source)*bytesPerValue;
+
+		description.insert("name", source->name());
+		description.insert("description", source->description());
+		description.insert("kind", kinds.at(s));
+		description.insert("rank", source->rank());
+		description.insert("size", sizes);
+		description.insert("dataType", singlePrecision ? "float32" : "float64");
+		description.insert("offset", offset);
+		description.insert("byteCount", byteCount);
+		description.insert("axes", axisDescriptions);
+		dataSourceDescriptions << description;
+
+		// Keep every array aligned to 8 bytes.
+		offset += (byteCount + 7) & ~qint64(7);
+	}
+
+	QVariantMap scanDescription;
+	scanDescription.insert("name", scan->name());
+	scanDescription.insert("number", scan->number());
+	scanDescription.insert("dateTime", scan->dateTime().toString(Qt::ISODate));
+	scanDescription.insert("sampleName", scan->sampleName());
+
+	QVariantMap header;
+	header.insert("format", "AMBinary");
+	header.insert("version", formatVersion());
+	header.insert("byteOrder", "littleEndian");
+	header.insert("scan", scanDescription);
+	header.insert("dataSources", dataSourceDescriptions);
+
+	QJson::Serializer serializer;
+	QByteArray headerText = serializer.serialize(header);
+
+	// 3. Open the file
+	QString fileName = parseKeywordString( destinationFolderPath % "/" % option->fileName() );
+
+	if(!openFile(fileName)) {
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -3, "Export failed: Could not open the file '" % fileName % "' for writing.  Check that you have permission to save files there, and that a file with that name doesn't already exists."));
+		return QString();
+	}
+
+	// 4. Write the preamble and header
+	uchar preamble[8];
+	qToLittleEndian<quint32>(formatVersion(), preamble);
+	qToLittleEndian<quint32>(quint32(headerText.size()), preamble+4);
+
+	bool success = file_->write(magic(), 8) == 8
+			&& file_->write((const char *)preamble, 8) == 8
+			&& file_->write(headerText) == headerText.size()
+			&& writePadding((8 - (16 + headerText.size()) % 8) % 8);
+
+	// 5. Stream the data section, in the order laid out above.
+	for(int s = 0, sSize = sources.count(); s < sSize && success; s++) {
+
+		const AMDataSource *source = sources.at(s);
+
+		for(int a = 0, rank = source->rank(); a < rank && success; a++) {
+
+			QVector<double> axisValues(source->size(a));
+
+			for(int i = 0, size = axisValues.size(); i < size; i++)
+				axisValues[i] = source->axisValue(a, i);
+
+			success = writeValues(axisValues.constData(), axisValues.size(), false);
+		}
+
+		if(success)
+			success = writeDataSource(source, singlePrecision);
+
+		if(success)
+			success = writePadding((8 - (valueCount(source)*bytesPerValue) % 8) % 8);
+	}
+
+	file_->close();
+
+	if(!success) {
+		AMErrorMon::report(AMErrorReport(this, AMErrorReport::Alert, -4, "Export failed: Could not write all of the data to the file '" % fileName % "'.  Check that there is enough space on the disk."));
+		return QString();
+	}
+
+	return fileName;
+}
+
+qint64 AMExporterBinary::valueCount(const AMDataSource *source)
+{
+	qint64 count = 1;
+
+	for(int a = 0, rank = source->rank(); a < rank; a++)
+		count *= source->size(a);
+
+	return count;
+}
+
+bool AMExporterBinary::writeDataSource(const AMDataSource *source, bool singlePrecision)
+{
+	int rank = source->rank();
+
+	if(rank == 0) {
+		double value = source->value(AMnDIndex());
+		return writeValues(&value, 1, singlePrecision);
+	}
+
+	qint64 rowSize = valueCount(source)/qMax(1, source->size(0));
+	int rowCount = source->size(0);
+
+	if(rowCount == 0 || rowSize == 0)
+		return true;
+
+	// Read whole rows (along the first axis) at a time, about 4 million values per chunk.
+	int rowsPerChunk = int(qBound(qint64(1), qint64(4*1024*1024)/rowSize, qint64(rowCount)));
+	QVector<double> chunk(int(rowsPerChunk*rowSize));
+
+	AMnDIndex start(rank, AMnDIndex::DoInit, 0);
+	AMnDIndex end = source->size();
+	for(int a = 0; a < rank; a++)
+		end[a] = end.at(a) - 1;
+
+	for(int firstRow = 0; firstRow < rowCount; firstRow += rowsPerChunk) {
+
+		int lastRow = qMin(firstRow + rowsPerChunk, rowCount) - 1;
+		qint64 count = qint64(lastRow - firstRow + 1)*rowSize;
+
+		start[0] = firstRow;
+		end[0] = lastRow;
+
+		if(!source->values(start, end, chunk.data())) {
+
+			double notANumber = qQNaN();
+			for(qint64 i = 0; i < count; i++)
+				chunk[int(i)] = notANumber;
+		}
+
+		if(!writeValues(chunk.constData(), count, singlePrecision))
+			return false;
+	}
+
+	return true;
+}
+
+bool AMExporterBinary::writeValues(const double *values, qint64 count, bool singlePrecision)
+{
+	if(count == 0)
+		return true;
+
+	if(!singlePrecision && Q_BYTE_ORDER == Q_LITTLE_ENDIAN) {
+		qint64 byteCount = count*8;
+		return file_->write((const char *)values, byteCount) == byteCount;
+	}
+
+	// Convert (and/or byte swap) into a buffer first.
+	int bytesPerValue = singlePrecision ? 4 : 8;
+	QByteArray buffer(int(count*bytesPerValue), Qt::Uninitialized);
+	uchar *output = (uchar *)buffer.data();
+
+	for(qint64 i = 0; i < count; i++) {
+
+		if(singlePrecision) {
+			float value = float(values[i]);
+			quint32 bits;
+			memcpy(&bits, &value, 4);
+			qToLittleEndian<quint32>(bits, output + i*4);
+		}
+
+		else {
+			quint64 bits;
+			memcpy(&bits, values + i, 8);
+			qToLittleEndian<quint64>(bits, output + i*8);
+		}
+	}
+
+	return file_->write(buffer) == buffer.size();
+}
+
+bool AMExporterBinary::writePadding(qint64 count)
+{
+	if(count <= 0)
+		return true;
+
+	return file_->write(QByteArray(int(count), '\0')) == count;
+}
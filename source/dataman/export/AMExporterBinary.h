@@ -0,0 +1,100 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMEXPORTERBINARY_H
+#define AMEXPORTERBINARY_H
+
+#include "dataman/export/AMExporter.h"
+
+class AMDataSource;
+class AMExporterOptionBinary;
+
+/// This exporter writes every raw and analyzed data source of a scan as a typed binary array, with a JSON header describing the arrays and their axes.
+/*! Large scans (especially 2D maps with a spectrum at every point) take a long time to write and read back as text.  This format stores the numbers exactly as they are in memory, streamed straight out of AMDataSource::values() one chunk at a time, so the file can be read with a few lines of numpy or Matlab.
+
+<b>File layout</b> (all integers and floating point numbers are little-endian):
+
+- 8 bytes: the magic string "AMBINARY"
+- 4 bytes: unsigned format version (currently 1)
+- 4 bytes: unsigned length \c L of the JSON header, in bytes
+- \c L bytes: the JSON header (UTF-8)
+- zero padding, up to the next multiple of 8 bytes.  This is where the data section starts.
+- the data section: the arrays described in the header, one after another.
+
+The JSON header contains:
+
+\code
+{
+	"format" : "AMBinary", "version" : 1, "byteOrder" : "littleEndian",
+	"scan" : { "name" : ..., "number" : ..., "dateTime" : ..., "sampleName" : ... },
+	"dataSources" : [
+		{
+			"name" : ..., "description" : ..., "kind" : "raw" | "analyzed", "rank" : 2, "size" : [ 256, 2048 ],
+			"dataType" : "float64" | "float32", "offset" : ..., "byteCount" : ...,
+			"axes" : [ { "name" : ..., "description" : ..., "units" : ..., "size" : 256, "isUniform" : true, "dataType" : "float64", "offset" : ..., "byteCount" : ... }, ... ]
+		}, ...
+	]
+}
+\endcode
+
+Every "offset" is measured in bytes from the start of the data section.  Data arrays are in row-major order (the first axis varies the slowest), exactly like AMDataSource::values(); a 0D data source is a single number.  Points that were not valid are written as -1, following the values() contract.  A data source that could not be read at all is written as NaN.
+
+Each axis is stored as an array of its float64 values, whether or not it is uniform.
+*/
+class AMExporterBinary : public AMExporter
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.
+	Q_INVOKABLE explicit AMExporterBinary(QObject *parent = 0);
+
+	const QMetaObject* getMetaObject();
+
+	virtual QString description() const { return "Binary (columnar, with JSON header)"; }
+	virtual QString longDescription() const {
+		return "The Binary file format writes every data source as a typed binary array, with a JSON header describing the arrays and their axes.  It is much faster to write and read than plain text, and is intended for analysis programs (numpy, Matlab, etc.) rather than for reading by eye.";
+	}
+	virtual QString exporterOptionClassName() const { return "AMExporterOptionBinary"; }
+
+	/// Checks that \c option is an AMExporterOptionBinary.
+	virtual bool isValidFor(const AMScan *scan, const AMExporterOption *option) const;
+
+	virtual QString exportScan(const AMScan *scan, const QString &destinationFolderPath, const AMExporterOption *option, int autoIndex = 0);
+
+	virtual AMExporterOption* createDefaultOption() const;
+
+	/// The magic string at the start of every file.
+	static const char *magic() { return "AMBINARY"; }
+	/// The file format version written by this exporter.
+	static quint32 formatVersion() { return 1; }
+
+protected:
+	/// Writes \c count numbers from \c values to file_, as little-endian float32 if \c singlePrecision is true, otherwise float64.  Returns false if the write failed.
+	bool writeValues(const double *values, qint64 count, bool singlePrecision);
+	/// Streams all of \c source's data to file_, reading at most a few million values at a time.  Returns false if the write failed.
+	bool writeDataSource(const AMDataSource *source, bool singlePrecision);
+	/// Writes \c count zero bytes.  Returns false if the write failed.
+	bool writePadding(qint64 count);
+
+	/// Returns the number of values in \c source (1 for a 0D data source).
+	static qint64 valueCount(const AMDataSource *source);
+};
+
+#endif // AMEXPORTERBINARY_H
@@ -24,7 +24,9 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QStringBuilder>
 #include <QFile>
 #include <QTextStream>
+#include <QVector>
 #include "util/AMErrorMonitor.h"
+#include "util/AMBufferedTextWriter.h"
 
 AMExporterGeneralAscii::AMExporterGeneralAscii(QObject *parent) :
 	AMExporter(parent)
@@ -252,77 +254,115 @@ void AMExporterGeneralAscii::writeHeader()
 
 void AMExporterGeneralAscii::writeMainTable()
 {
-	QTextStream ts(file_);
+	AMBufferedTextWriter ts(file_);
+	QByteArray columnDelimiter = option_->columnDelimiter().toLocal8Bit();
+	QByteArray newlineDelimiter = option_->newlineDelimiter().toLocal8Bit();
 
 	// 1. Column header.
 	int maxTableRows = 0;
+	for(int c=0; c<mainTableDataSources_.count(); c++) {
+		AMDataSource* ds = currentScan_->dataSourceAt(mainTableDataSources_.at(c));
+		if(ds->size(0) > maxTableRows)
+			maxTableRows = ds->size(0);
+	}
+
 	if(option_->columnHeaderIncluded()) {
 		for(int c=0; c<mainTableDataSources_.count(); c++) {
 			setCurrentDataSource(mainTableDataSources_.at(c));
 			AMDataSource* ds = currentScan_->dataSourceAt(currentDataSourceIndex_);
 
-			if(ds->size(0) > maxTableRows)
-				maxTableRows = ds->size(0); // convenient... lets figure this out while we're looping through anyway
-
 			// 1D data sources:
 			if(ds->rank() == 1) {
 				if(mainTableIncludeX_.at(c))
-					ts << parseKeywordString(option_->columnHeader()) << ".X" << option_->columnDelimiter();
-				ts << parseKeywordString(option_->columnHeader()) << option_->columnDelimiter();
+					ts << parseKeywordString(option_->columnHeader()) << ".X" << columnDelimiter;
+				ts << parseKeywordString(option_->columnHeader()) << columnDelimiter;
 			}
 			else {	// 2D
 				if(mainTableIncludeX_.at(c))
-					ts << parseKeywordString(option_->columnHeader()) << ".X" << option_->columnDelimiter();
+					ts << parseKeywordString(option_->columnHeader()) << ".X" << columnDelimiter;
 				// need a loop over the second axis columns
 				for(int cc=0; cc<ds->size(1); cc++) {
 					setCurrentColumnIndex(cc);
-					ts << parseKeywordString(option_->columnHeader()) << "[" << ds->axisValue(1, cc).toString() << ds->axisInfoAt(1).units << "]" << option_->columnDelimiter();
+					ts << parseKeywordString(option_->columnHeader()) << "[" << ds->axisValue(1, cc) << ds->axisInfoAt(1).units << "]" << columnDelimiter;
 				}
 			}
 		}
-		ts << option_->newlineDelimiter() << option_->columnHeaderDelimiter() << option_->newlineDelimiter();
+		ts << newlineDelimiter << option_->columnHeaderDelimiter() << newlineDelimiter;
 	}
 
 
-	// 2. rows
-	for(int r=0; r<maxTableRows; r++) {
+	// 2. rows.  Read them in blocks with values(), rather than one value() at a time.
+	const int blockRows = 1024;
+	QList<QVector<double> > blockValues;
+	QList<bool> blockValid;
+	for(int c=0; c<mainTableDataSources_.count(); c++) {
+		blockValues << QVector<double>();
+		blockValid << false;
+	}
 
-		// over rows within columns
-		for(int c=0; c<mainTableDataSources_.count(); c++) {
-			setCurrentDataSource(mainTableDataSources_.at(c));
-			AMDataSource* ds = currentScan_->dataSourceAt(currentDataSourceIndex_);
+	for(int blockStart=0; blockStart<maxTableRows; blockStart+=blockRows) {
 
-			bool doPrint = (ds->size(0) > r);
+		int blockEnd = qMin(blockStart+blockRows, maxTableRows);	// exclusive
 
-			// print x column?
-			if(mainTableIncludeX_.at(c)) {
-				if(doPrint)
-					ts << ds->axisValue(0,r).toString();
-				ts << option_->columnDelimiter();
-			}
+		for(int c=0; c<mainTableDataSources_.count(); c++) {
+			AMDataSource* ds = currentScan_->dataSourceAt(mainTableDataSources_.at(c));
+			int lastRow = qMin(blockEnd, ds->size(0)) - 1;
 
-			// 1D data sources:
+			if(lastRow < blockStart)
+				continue;
+
+			blockValid[c] = false;
 			if(ds->rank() == 1) {
-				if(doPrint)
-					ts << ds->value(r).toString();
-				ts << option_->columnDelimiter();
+				blockValues[c].resize(lastRow-blockStart+1);
+				blockValid[c] = ds->values(AMnDIndex(blockStart), AMnDIndex(lastRow), blockValues[c].data());
 			}
-			else if(ds->rank() == 2) {
-				// need a loop over the second axis columns
-				for(int cc=0; cc<ds->size(1); cc++) {
+			else if(ds->rank() == 2 && ds->size(1) > 0) {
+				blockValues[c].resize((lastRow-blockStart+1)*ds->size(1));
+				blockValid[c] = ds->values(AMnDIndex(blockStart, 0), AMnDIndex(lastRow, ds->size(1)-1), blockValues[c].data());
+			}
+		}
+
+		for(int r=blockStart; r<blockEnd; r++) {
+
+			// over rows within columns
+			for(int c=0; c<mainTableDataSources_.count(); c++) {
+				setCurrentDataSource(mainTableDataSources_.at(c));
+				AMDataSource* ds = currentScan_->dataSourceAt(currentDataSourceIndex_);
+
+				bool doPrint = (ds->size(0) > r);
+
+				// print x column?
+				if(mainTableIncludeX_.at(c)) {
+					if(doPrint)
+						ts << ds->axisValue(0,r);
+					ts << columnDelimiter;
+				}
+
+				// 1D data sources:
+				if(ds->rank() == 1) {
 					if(doPrint)
-						ts << ds->value(AMnDIndex(r,cc)).toString();
-					ts << option_->columnDelimiter();
+						writeBlockValue(ts, ds, AMnDIndex(r), blockValid.at(c) ? blockValues.at(c).at(r-blockStart) : AMNUMBER_INVALID_FLOATINGPOINT);
+					ts << columnDelimiter;
+				}
+				else if(ds->rank() == 2) {
+					// need a loop over the second axis columns
+					int columns = ds->size(1);
+					const double *rowValues = doPrint && blockValid.at(c) ? blockValues.at(c).constData() + (r-blockStart)*columns : 0;
+					for(int cc=0; cc<columns; cc++) {
+						if(doPrint)
+							writeBlockValue(ts, ds, AMnDIndex(r, cc), rowValues ? rowValues[cc] : AMNUMBER_INVALID_FLOATINGPOINT);
+						ts << columnDelimiter;
+					}
 				}
 			}
+			ts << newlineDelimiter;
 		}
-		ts << option_->newlineDelimiter();
 	}
 }
 
 void AMExporterGeneralAscii::writeSeparateSections()
 {
-	QTextStream ts(file_);
+	AMBufferedTextWriter ts(file_);
 
 	for(int s=0; s<separateSectionDataSources_.count(); s++) {
 
@@ -354,44 +394,14 @@ void AMExporterGeneralAscii::writeSeparateSections()
 				// need a loop over the second axis columns
 				for(int cc=0; cc<ds->size(1); cc++) {
 					setCurrentColumnIndex(cc);
-					ts << parseKeywordString(option_->columnHeader()) << "[" << ds->axisValue(1, cc).toString() << ds->axisInfoAt(1).units << "]" << option_->columnDelimiter();
+					ts << parseKeywordString(option_->columnHeader()) << "[" << ds->axisValue(1, cc) << ds->axisInfoAt(1).units << "]" << option_->columnDelimiter();
 				}
 			}
 			ts << option_->newlineDelimiter() << option_->columnHeaderDelimiter() << option_->newlineDelimiter();
 		}
 
 		// table
-		switch(ds->rank()) {
-		case 0:
-			ts << ds->value(AMnDIndex()).toString() << option_->columnDelimiter() << option_->newlineDelimiter();
-			break;
-		case 1: {
-			int maxTableRows = ds->size(0);
-			for(int r=0; r<maxTableRows; r++) {
-				if(separateSectionIncludeX_.at(s)) {
-					ts << ds->axisValue(0,r).toString() << option_->columnDelimiter();
-				}
-				ts << ds->value(r).toString() << option_->columnDelimiter() << option_->newlineDelimiter();
-			}
-		}
-		break;
-		case 2: {
-			int maxTableRows = ds->size(0);
-			for(int r=0; r<maxTableRows; r++) {
-				if(separateSectionIncludeX_.at(s))
-					ts << ds->axisValue(0,r).toString() << option_->columnDelimiter();
-				// need a loop over the second axis columns
-				for(int cc=0; cc<ds->size(1); cc++) {
-					ts << ds->value(AMnDIndex(r,cc)).toString() << option_->columnDelimiter();
-				}
-				ts << option_->newlineDelimiter();
-			}
-		}
-		break;
-		default:
-			/// \todo Implement 3D
-			break;
-		}
+		writeSectionTable(ts, ds, separateSectionIncludeX_.at(s));
 	}
 }
 
@@ -410,7 +420,7 @@ bool AMExporterGeneralAscii::writeSeparateFiles(const QString& destinationFolder
 			return false;
 		}
 
-		QTextStream ts(&file);
+		AMBufferedTextWriter ts(&file);
 
 		// section header?
 		if(option_->sectionHeaderIncluded()) {
@@ -435,47 +445,77 @@ bool AMExporterGeneralAscii::writeSeparateFiles(const QString& destinationFolder
 				// need a loop over the second axis columns
 				for(int cc=0; cc<ds->size(1); cc++) {
 					setCurrentColumnIndex(cc);
-					ts << parseKeywordString(option_->columnHeader()) << "[" << ds->axisValue(1, cc).toString() << ds->axisInfoAt(1).units << "]" << option_->columnDelimiter();
+					ts << parseKeywordString(option_->columnHeader()) << "[" << ds->axisValue(1, cc) << ds->axisInfoAt(1).units << "]" << option_->columnDelimiter();
 				}
 			}
 			ts << option_->newlineDelimiter() << option_->columnHeaderDelimiter() << option_->newlineDelimiter();
 		}
 
 		// table
-		switch(ds->rank()) {
-		case 0:
-			ts << ds->value(AMnDIndex()).toString() << option_->columnDelimiter() << option_->newlineDelimiter();
+		writeSectionTable(ts, ds, separateFileIncludeX_.at(s));
+	}
+
+	return true;
+}
+
+void AMExporterGeneralAscii::writeSectionTable(AMBufferedTextWriter &ts, AMDataSource *ds, bool includeX)
+{
+	QByteArray columnDelimiter = option_->columnDelimiter().toLocal8Bit();
+	QByteArray newlineDelimiter = option_->newlineDelimiter().toLocal8Bit();
+
+	switch(ds->rank()) {
+	case 0:
+		ts << ds->value(AMnDIndex()) << columnDelimiter << newlineDelimiter;
+		break;
+	case 1: {
+		int maxTableRows = ds->size(0);
+		if(maxTableRows == 0)
 			break;
-		case 1: {
-			int maxTableRows = ds->size(0);
-			for(int r=0; r<maxTableRows; r++) {
-				if(separateFileIncludeX_.at(s)) {
-					ts << ds->axisValue(0,r).toString() << option_->columnDelimiter();
-				}
-				ts << ds->value(r).toString() << option_->columnDelimiter() << option_->newlineDelimiter();
-			}
+
+		QVector<double> data(maxTableRows);
+		if(!ds->values(AMnDIndex(0), AMnDIndex(maxTableRows-1), data.data()))
+			data.fill(AMNUMBER_INVALID_FLOATINGPOINT);
+
+		for(int r=0; r<maxTableRows; r++) {
+			if(includeX)
+				ts << ds->axisValue(0,r) << columnDelimiter;
+			writeBlockValue(ts, ds, AMnDIndex(r), data.at(r));
+			ts << columnDelimiter << newlineDelimiter;
 		}
-		break;
-		case 2: {
-			int maxTableRows = ds->size(0);
-			for(int r=0; r<maxTableRows; r++) {
-				if(separateFileIncludeX_.at(s))
-					ts << ds->axisValue(0,r).toString() << option_->columnDelimiter();
-				// need a loop over the second axis columns
-				for(int cc=0; cc<ds->size(1); cc++) {
-					ts << ds->value(AMnDIndex(r,cc)).toString() << option_->columnDelimiter();
-				}
-				ts << option_->newlineDelimiter();
+	}
+	break;
+	case 2: {
+		int maxTableRows = ds->size(0);
+		int columns = ds->size(1);
+		QVector<double> rowData(columns);
+
+		for(int r=0; r<maxTableRows; r++) {
+			if(includeX)
+				ts << ds->axisValue(0,r) << columnDelimiter;
+			// read the whole row at once, instead of one value() per column.
+			if(columns > 0 && !ds->values(AMnDIndex(r, 0), AMnDIndex(r, columns-1), rowData.data()))
+				rowData.fill(AMNUMBER_INVALID_FLOATINGPOINT);
+			for(int cc=0; cc<columns; cc++) {
+				writeBlockValue(ts, ds, AMnDIndex(r, cc), rowData.at(cc));
+				ts << columnDelimiter;
 			}
+			ts << newlineDelimiter;
 		}
+	}
+	break;
+	default:
+		/// \todo Implement 3D
 		break;
-		default:
-			/// \todo Implement 3D
-			break;
-		}
 	}
+}
 
-	return true;
+void AMExporterGeneralAscii::writeBlockValue(AMBufferedTextWriter &ts, AMDataSource *ds, const AMnDIndex &index, double blockValue)
+{
+	// values() gives invalid points as AMNUMBER_INVALID_FLOATINGPOINT.  Only those are checked again with value(), so that invalid ones are still written as "[X]".
+	if(blockValue == AMNUMBER_INVALID_FLOATINGPOINT)
+		ts << ds->value(index);
+	else
+		ts << blockValue;
 }
 
 void AMExporterGeneralAscii::normalizeLineEndings(QString &inputString)
@@ -24,6 +24,9 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataman/export/AMExporter.h"
 
 class AMExporterOptionGeneralAscii;
+class AMBufferedTextWriter;
+class AMDataSource;
+class AMnDIndex;
 
 class AMExporterGeneralAscii : public AMExporter
 {
@@ -74,6 +77,10 @@ protected:
 	virtual void writeSeparateSections();
 	/// Method that writes the separate files for other data sources.
 	virtual bool writeSeparateFiles(const QString& destinationFolderPath);
+	/// Writes the data table for a single data source \c ds, as used by writeSeparateSections() and writeSeparateFiles().  Rows are read with AMDataSource::values() instead of one value() call per point.
+	void writeSectionTable(AMBufferedTextWriter &ts, AMDataSource *ds, bool includeX);
+	/// Writes \c blockValue, read with values() for the point \c index of \c ds.  Points that values() reported as invalid are checked with value(), so that they are written as "[X]" like before.
+	void writeBlockValue(AMBufferedTextWriter &ts, AMDataSource *ds, const AMnDIndex &index, double blockValue);
 
 	/// converts all "\r\n" windows style line endings in \c inputString to "\n"
 	void normalizeLineEndings(QString& inputString);
@@ -0,0 +1,63 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMEXPORTEROPTIONBINARY_H
+#define AMEXPORTEROPTIONBINARY_H
+
+#include "dataman/export/AMExporterOption.h"
+
+/// The export options for AMExporterBinary, which writes the data sources of a scan as typed binary arrays.
+class AMExporterOptionBinary : public AMExporterOption
+{
+	Q_OBJECT
+
+	Q_PROPERTY(bool includeRawDataSources READ includeRawDataSources WRITE setIncludeRawDataSources)
+	Q_PROPERTY(bool includeAnalyzedDataSources READ includeAnalyzedDataSources WRITE setIncludeAnalyzedDataSources)
+	Q_PROPERTY(bool singlePrecision READ singlePrecision WRITE setSinglePrecision)
+
+public:
+	/// Constructor.  By default, all raw and analyzed data sources are written as 64-bit floating point numbers.
+	Q_INVOKABLE explicit AMExporterOptionBinary(QObject *parent = 0);
+
+	const QMetaObject* getMetaObject();
+
+	virtual AMExporterOption* createCopy() const { return new AMExporterOptionBinary(*this); }
+
+	/// Whether the raw data sources are written.
+	bool includeRawDataSources() const { return includeRawDataSources_; }
+	/// Whether the analyzed data sources are written.
+	bool includeAnalyzedDataSources() const { return includeAnalyzedDataSources_; }
+	/// Whether the data is written as 32-bit ("float32") instead of 64-bit ("float64") floating point numbers.  Axis values are always 64-bit.
+	bool singlePrecision() const { return singlePrecision_; }
+
+public slots:
+	/// Sets whether the raw data sources are written.
+	void setIncludeRawDataSources(bool include) { includeRawDataSources_ = include; setModified(true); }
+	/// Sets whether the analyzed data sources are written.
+	void setIncludeAnalyzedDataSources(bool include) { includeAnalyzedDataSources_ = include; setModified(true); }
+	/// Sets whether the data is written as 32-bit instead of 64-bit floating point numbers.
+	void setSinglePrecision(bool singlePrecision) { singlePrecision_ = singlePrecision; setModified(true); }
+
+protected:
+	bool includeRawDataSources_;
+	bool includeAnalyzedDataSources_;
+	bool singlePrecision_;
+};
+
+#endif // AMEXPORTEROPTIONBINARY_H
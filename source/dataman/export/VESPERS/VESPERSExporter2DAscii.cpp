@@ -22,6 +22,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataman/export/AMExporterOptionGeneralAscii.h"
 #include "dataman/AMScan.h"
 #include "util/AMErrorMonitor.h"
+#include "util/AMBufferedTextWriter.h"
 #include "acquaman/VESPERS/VESPERS2DScanConfiguration.h"
 
 #include <QStringBuilder>
@@ -136,7 +137,9 @@ void VESPERSExporter2DAscii::writeHeader()
 
 void VESPERSExporter2DAscii::writeMainTable()
 {
-	QTextStream ts(file_);
+	AMBufferedTextWriter ts(file_);
+	QByteArray columnDelimiter = option_->columnDelimiter().toLocal8Bit();
+	QByteArray newlineDelimiter = option_->newlineDelimiter().toLocal8Bit();
 
 	// 1. Column header.
 	if(option_->columnHeaderIncluded()) {
@@ -148,13 +151,13 @@ void VESPERSExporter2DAscii::writeMainTable()
 			setCurrentDataSource(mainTableDataSources_.at(c));
 
 			if(mainTableIncludeX_.at(c))
-				ts << currentScan_->rawData()->scanAxisAt(0).name << option_->columnDelimiter() << currentScan_->rawData()->scanAxisAt(1).name << option_->columnDelimiter();
+				ts << currentScan_->rawData()->scanAxisAt(0).name << columnDelimiter << currentScan_->rawData()->scanAxisAt(1).name << columnDelimiter;
 
-			ts << parseKeywordString(option_->columnHeader()) << option_->columnDelimiter();
+			ts << parseKeywordString(option_->columnHeader()) << columnDelimiter;
 		}
 	}
 
-	ts << option_->newlineDelimiter() << option_->columnHeaderDelimiter() << option_->newlineDelimiter();
+	ts << newlineDelimiter << option_->columnHeaderDelimiter() << newlineDelimiter;
 
 	// 2. rows
 	VESPERS2DScanConfiguration *config = qobject_cast<VESPERS2DScanConfiguration *>(const_cast<AMScanConfiguration *>(currentScan_->scanConfiguration()));
@@ -180,37 +183,50 @@ void VESPERSExporter2DAscii::writeMainTable()
 	else
 		ccdString = "";
 
+	QList<AMDataSource *> sources;
+	for(int c=0; c<mainTableDataSources_.count(); c++)
+		sources << currentScan_->dataSourceAt(mainTableDataSources_.at(c));
+
+	// One line of the map for every source, read with values() instead of one value() call per pixel.
+	QVector<QVector<double> > rowData(sources.size(), QVector<double>(xRange));
+	QVector<bool> rowValid(sources.size());
+
 	for(int y = 0; y < yRange; y++) {
 
+		for(int c=0; c<sources.size(); c++)
+			rowValid[c] = xRange > 0 && sources.at(c)->values(AMnDIndex(0, y), AMnDIndex(xRange-1, y), rowData[c].data());
+
 		for (int x = 0; x < xRange; x++){
 
 			// over rows within columns
-			for(int c=0; c<mainTableDataSources_.count(); c++) {
-				setCurrentDataSource(mainTableDataSources_.at(c));
-				AMDataSource* ds = currentScan_->dataSourceAt(currentDataSourceIndex_);
+			for(int c=0; c<sources.size(); c++) {
+				AMDataSource* ds = sources.at(c);
 
 				// print x and y column?
 				if(mainTableIncludeX_.at(c)) {
 
-					ts << ds->axisValue(0, x).toString();
-					ts << option_->columnDelimiter();
-					ts << ds->axisValue(1, y).toString();
-					ts << option_->columnDelimiter();
+					ts << ds->axisValue(0, x);
+					ts << columnDelimiter;
+					ts << ds->axisValue(1, y);
+					ts << columnDelimiter;
 				}
 
 				if(c == indexOfCCDName)
-					ts << QString(ccdString).arg(int(ds->value(AMnDIndex(x, y)))-1);	// The -1 is because the value stored here is the NEXT number in the scan.  Purely a nomenclature setup from the EPICS interface.
+					ts << QString(ccdString).arg(int(rowValid.at(c) ? rowData.at(c).at(x) : double(ds->value(AMnDIndex(x, y))))-1);	// The -1 is because the value stored here is the NEXT number in the scan.  Purely a nomenclature setup from the EPICS interface.
+				// values() gives invalid points as AMNUMBER_INVALID_FLOATINGPOINT; those are checked with value(), so that invalid ones are still written as "[X]".
+				else if(rowValid.at(c) && rowData.at(c).at(x) != AMNUMBER_INVALID_FLOATINGPOINT)
+					ts << rowData.at(c).at(x);
 				else
-					ts << ds->value(AMnDIndex(x, y)).toString();
+					ts << ds->value(AMnDIndex(x, y));
 
-				ts << option_->columnDelimiter();
+				ts << columnDelimiter;
 			}
 
-			ts << option_->newlineDelimiter();
+			ts << newlineDelimiter;
 		}
 	}
 
-	ts << option_->newlineDelimiter();
+	ts << newlineDelimiter;
 }
 
 void VESPERSExporter2DAscii::writeSeparateSections()
@@ -234,21 +250,27 @@ bool VESPERSExporter2DAscii::writeSeparateFiles(const QString &destinationFolder
 		}
 
 		int spectraSize = source->size(2);
-		QString columnDelimiter = option_->columnDelimiter();
-		QString newLineDelimiter = option_->newlineDelimiter();
-		QTextStream out(&output);
+		int xSize = source->size(0);
+		QByteArray columnDelimiter = option_->columnDelimiter().toLocal8Bit();
+		QByteArray newLineDelimiter = option_->newlineDelimiter().toLocal8Bit();
+		// Every spectrum in a line of the map is read with one values() call.  It comes back ordered by x, then by channel.
+		QVector<double> data(xSize*spectraSize);
+
+		{
+			AMBufferedTextWriter out(&output);
 
-		for (int y = 0, ySize = source->size(1); y < ySize; y++){
+			for (int y = 0, ySize = source->size(1); y < ySize && xSize > 0 && spectraSize > 0; y++){
 
-			for (int x = 0, xSize = source->size(0); x < xSize; x++){
+				source->values(AMnDIndex(0, y, 0), AMnDIndex(xSize-1, y, spectraSize-1), data.data());
+				const double *spectrum = data.constData();
 
-				QVector<double> data(spectraSize);
-				source->values(AMnDIndex(x, y, 0), AMnDIndex(x, y, spectraSize-1), data.data());
+				for (int x = 0; x < xSize; x++, spectrum += spectraSize){
 
-				for (int i = 0; i < spectraSize; i++)
-					out << data.at(i) << columnDelimiter;
+					for (int i = 0; i < spectraSize; i++)
+						out << spectrum[i] << columnDelimiter;
 
-				out << newLineDelimiter;
+					out << newLineDelimiter;
+				}
 			}
 		}
 
@@ -22,6 +22,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataman/export/AMExporterOptionGeneralAscii.h"
 #include "dataman/AMScan.h"
 #include "util/AMErrorMonitor.h"
+#include "util/AMBufferedTextWriter.h"
 #include "acquaman/VESPERS/VESPERS2DScanConfiguration.h"
 
 #include <QStringBuilder>
@@ -150,7 +151,9 @@ void VESPERSExporterSMAK::writeHeader()
 
 void VESPERSExporterSMAK::writeMainTable()
 {
-	QTextStream ts(file_);
+	AMBufferedTextWriter ts(file_);
+	QByteArray columnDelimiter = option_->columnDelimiter().toLocal8Bit();
+	QByteArray newlineDelimiter = option_->newlineDelimiter().toLocal8Bit();
 
 	// 1. Column header.
 	if(option_->columnHeaderIncluded()) {
@@ -162,13 +165,13 @@ void VESPERSExporterSMAK::writeMainTable()
 			setCurrentDataSource(mainTableDataSources_.at(c));
 
 			if(mainTableIncludeX_.at(c))
-				ts << "H" << option_->columnDelimiter() << "V" << option_->columnDelimiter();
+				ts << "H" << columnDelimiter << "V" << columnDelimiter;
 
-			ts << parseKeywordString(option_->columnHeader()) << option_->columnDelimiter();
+			ts << parseKeywordString(option_->columnHeader()) << columnDelimiter;
 		}
 	}
 
-	ts << option_->newlineDelimiter() << option_->columnHeaderDelimiter() << option_->newlineDelimiter();
+	ts << newlineDelimiter << option_->columnHeaderDelimiter() << newlineDelimiter;
 
 	// 2. rows
 	VESPERS2DScanConfiguration *config = qobject_cast<VESPERS2DScanConfiguration *>(const_cast<AMScanConfiguration *>(currentScan_->scanConfiguration()));
@@ -177,41 +180,54 @@ void VESPERSExporterSMAK::writeMainTable()
 
 	// This will return -1 if it fails.  This means any checks inside this loop will always fail if the CCD was not included.
 	int indexOfCCDName = currentScan_->indexOfDataSource("CCDFileNumber");
-	QString ccdFileName = config->ccdFileName();
+	QByteArray ccdFileName = config->ccdFileName().toLocal8Bit();
 	int yRange = currentScan_->scanSize(1);
 	int xRange = currentScan_->scanSize(0);
 
+	QList<AMDataSource *> sources;
+	for(int c=0; c<mainTableDataSources_.count(); c++)
+		sources << currentScan_->dataSourceAt(mainTableDataSources_.at(c));
+
+	// One line of the map for every source, read with values() instead of one value() call per pixel.
+	QVector<QVector<double> > rowData(sources.size(), QVector<double>(xRange));
+	QVector<bool> rowValid(sources.size());
+
 	for(int y = 0; y < yRange; y++) {
 
+		for(int c=0; c<sources.size(); c++)
+			rowValid[c] = xRange > 0 && sources.at(c)->values(AMnDIndex(0, y), AMnDIndex(xRange-1, y), rowData[c].data());
+
 		for (int x = 0; x < xRange; x++){
 
 			// over rows within columns
-			for(int c=0; c<mainTableDataSources_.count(); c++) {
-				setCurrentDataSource(mainTableDataSources_.at(c));
-				AMDataSource* ds = currentScan_->dataSourceAt(currentDataSourceIndex_);
+			for(int c=0; c<sources.size(); c++) {
+				AMDataSource* ds = sources.at(c);
 
 				// print x and y column?
 				if(mainTableIncludeX_.at(c)) {
 
-					ts << ds->axisValue(0,x).toString();
-					ts << option_->columnDelimiter();
-					ts << ds->axisValue(1, y).toString();
-					ts << option_->columnDelimiter();
+					ts << ds->axisValue(0,x);
+					ts << columnDelimiter;
+					ts << ds->axisValue(1, y);
+					ts << columnDelimiter;
 				}
 
 				if(c == indexOfCCDName)
-					ts << QString("%1_%2.spe").arg(ccdFileName).arg(int(ds->value(AMnDIndex(x, y)))-1);	// The -1 is because the value stored here is the NEXT number in the scan.  Purely a nomenclature setup from the EPICS interface.
+					ts << ccdFileName << "_" << (int(rowValid.at(c) ? rowData.at(c).at(x) : double(ds->value(AMnDIndex(x, y))))-1) << ".spe";	// The -1 is because the value stored here is the NEXT number in the scan.  Purely a nomenclature setup from the EPICS interface.
+				// values() gives invalid points as AMNUMBER_INVALID_FLOATINGPOINT; those are checked with value(), so that invalid ones are still written as "[X]".
+				else if(rowValid.at(c) && rowData.at(c).at(x) != AMNUMBER_INVALID_FLOATINGPOINT)
+					ts << rowData.at(c).at(x);
 				else
-					ts << ds->value(AMnDIndex(x, y)).toString();
+					ts << ds->value(AMnDIndex(x, y));
 
-				ts << option_->columnDelimiter();
+				ts << columnDelimiter;
 			}
 
-			ts << option_->newlineDelimiter();
+			ts << newlineDelimiter;
 		}
 	}
 
-	ts << option_->newlineDelimiter();
+	ts << newlineDelimiter;
 }
 
 void VESPERSExporterSMAK::writeSeparateSections()
@@ -235,23 +251,29 @@ bool VESPERSExporterSMAK::writeSeparateFiles(const QString &destinationFolderPat
 			return false;
 		}
 
-		QTextStream out(&output);
 		int spectraSize = source->size(2);
-		QVector<double> data(spectraSize);
+		int xSize = source->size(0);
+		// Every spectrum in a line of the map is read with one values() call.  It comes back ordered by x, then by channel.
+		QVector<double> data(xSize*spectraSize);
 		int index = 0;
 
-		for (int y = 0, ySize = source->size(1); y < ySize; y++){
+		{
+			AMBufferedTextWriter out(&output);
 
-			for (int x = 0, xSize = source->size(0); x < xSize; x++){
+			for (int y = 0, ySize = source->size(1); y < ySize && xSize > 0 && spectraSize > 0; y++){
 
-				source->values(AMnDIndex(x, y, 0), AMnDIndex(x, y, spectraSize-1), data.data());
+				source->values(AMnDIndex(0, y, 0), AMnDIndex(xSize-1, y, spectraSize-1), data.data());
+				const double *spectrum = data.constData();
 
-				out << ++index;
+				for (int x = 0; x < xSize; x++, spectrum += spectraSize){
 
-				for (int i = 0; i < spectraSize; i++)
-					out << "\t" << data.at(i);
+					out << ++index;
 
-				out << "\n";
+					for (int i = 0; i < spectraSize; i++)
+						out << '\t' << spectrum[i];
+
+					out << '\n';
+				}
 			}
 		}
 
@@ -302,8 +324,19 @@ void VESPERSExporterSMAK::writeSMAKFile()
 	temp.append("\n* BLANK LINE\n* BLANK LINE\n* Energy points requested:\n*\t30000.0\n* BLANK LINE\n* DATA\n");
 	ts << temp;
 
+	// QTextStream buffers internally: make sure everything above is in the file before the data is written.
+	ts.flush();
+
+	AMBufferedTextWriter out(file_);
+	QByteArray newlineDelimiter = option_->newlineDelimiter().toLocal8Bit();
+	QVector<QVector<double> > rowData(sources.size(), QVector<double>(xRange));
+	QVector<bool> rowValid(sources.size());
+
 	for(int y = 0; y < yRange; y++) {
 
+		for(int c=0; c < sources.size(); c++)
+			rowValid[c] = xRange > 0 && sources.at(c)->values(AMnDIndex(0, y), AMnDIndex(xRange-1, y), rowData[c].data());
+
 		for (int x = 0; x < xRange; x++){
 
 			// over rows within columns
@@ -313,19 +346,22 @@ void VESPERSExporterSMAK::writeSMAKFile()
 
 				// print x and y column?
 				if(c == 0) {
-					ts << ds->axisValue(0, x).toString();
-					ts << "\t";
-					ts << ds->axisValue(1, y).toString();
-					ts << "\t";
+					out << ds->axisValue(0, x);
+					out << '\t';
+					out << ds->axisValue(1, y);
+					out << '\t';
 				}
 
-				ts << ds->value(AMnDIndex(x, y)).toString();
-				ts << "\t";
+				if (rowValid.at(c) && rowData.at(c).at(x) != AMNUMBER_INVALID_FLOATINGPOINT)
+					out << rowData.at(c).at(x);
+				else
+					out << ds->value(AMnDIndex(x, y));
+				out << '\t';
 			}
 
-			ts << option_->newlineDelimiter();
+			out << newlineDelimiter;
 		}
 	}
 
-	ts << option_->newlineDelimiter();
+	out << newlineDelimiter;
 }
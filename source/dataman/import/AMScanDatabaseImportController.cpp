@@ -24,6 +24,9 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QStringBuilder>
 #include <QTime>
 #include <QApplication>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
 
 #include "dataman/database/AMDatabase.h"
 #include "dataman/database/AMDbObjectSupport.h"
@@ -45,6 +48,36 @@ AMScanDatabaseImportController::AMScanDatabaseImportController(AMDatabase* desti
 	destinationDb_ = destinationDb;
 	destinationPath_ = destinationPath;
 	state_ = Preparing;
+	sourceAttached_ = false;
+}
+
+AMScanDatabaseImportController::~AMScanDatabaseImportController()
+{
+	if(state_ == Importing)
+		cancelAndRollBack();
+
+	detachSourceDatabase();
+}
+
+/// The name the source database is attached under, on the destination connection.
+static QString sourceSchemaName()
+{
+	return "AMImportSource";
+}
+
+/// Returns the largest id in \c tableName of the main database on \c db's connection, or 0 if the table is empty.
+static int maximumId(AMDatabase *db, const QString &tableName)
+{
+	QSqlQuery q = db->query();
+	q.prepare(QString("SELECT MAX(id) FROM main.%1").arg(tableName));
+
+	int id = 0;
+
+	if(AMDatabase::execQuery(q) && q.first())
+		id = q.value(0).toInt();
+
+	q.finish();
+	return id;
 }
 
 bool AMScanDatabaseImportController::setSourceFolderAndLoadDatabase(const QString &absolutePathToSourceFolder)
@@ -53,6 +86,7 @@ bool AMScanDatabaseImportController::setSourceFolderAndLoadDatabase(const QStrin
 		return false;
 
 	if(sourceDb_) {
+		detachSourceDatabase();
 		AMDatabase::deleteDatabase(sourceDb_->connectionName());
 		sourceDb_ = 0;
 	}
@@ -76,6 +110,9 @@ bool AMScanDatabaseImportController::setSourceFolderAndLoadDatabase(const QStrin
 		return false;
 	}
 
+	// Not fatal: without it, we just copy one object at a time.
+	attachSourceDatabase();
+
 	state_ = Analyzing;
 	return true;
 }
@@ -93,8 +130,10 @@ void AMScanDatabaseImportController::analyzeFacilitiesForDuplicates()
 	emit stepProgress(-1);
 
 	// go through facilities in source, and make sure they all exist in destination. Map ids.
-	QSqlQuery q = AMDbObjectSupport::s()->select<AMFacility>(sourceDb_, "id, name, description");
-	q.exec();
+	QString tableName = AMDbObjectSupport::s()->tableNameForClass<AMFacility>();
+	QStringList matchColumns;
+	matchColumns << "name" << "description";
+	QSqlQuery q = sourceRowsWithMatches(tableName, matchColumns);
 	int stepIndex = 0;
 	int totalSteps = q.size();
 	while(q.next()) {
@@ -106,19 +145,8 @@ void AMScanDatabaseImportController::analyzeFacilitiesForDuplicates()
 
 		sourceFacilities_[id] = name % " " % description;
 
-		// Find a matching one in destinationDb_.
-		QSqlQuery q2 = AMDbObjectSupport::s()->select<AMFacility>(destinationDb_, "id", "name = ? AND description = ?");
-		q2.bindValue(0, name);
-		q2.bindValue(1, description);
-		q2.exec();
-		if(q2.first()) {
-			// found one.
-			s2dFacilityIds_[id] = q2.value(0).toInt();	// insert a mapping from source facility IDs to destination facility IDs
-		}
-		else {
-			// none found in destination. Will need to create it.
-			s2dFacilityIds_[id] = -1;
-		}
+		// Find a matching one in destinationDb_: insert a mapping from source facility IDs to destination facility IDs, or -1 if none was found and it will need to be created.
+		s2dFacilityIds_[id] = matchingDestinationId(q, tableName, matchColumns);
 
 		qApp->sendPostedEvents();
 		qApp->processEvents();
@@ -139,8 +167,10 @@ void AMScanDatabaseImportController::analyzeRunsForDuplicates()
 	emit stepProgress(-1);
 
 	// go through runs in source, and see if any exist in destination
-	QSqlQuery q = AMDbObjectSupport::s()->select<AMRun>(sourceDb_, "id, name, dateTime");
-	q.exec();
+	QString tableName = AMDbObjectSupport::s()->tableNameForClass<AMRun>();
+	QStringList matchColumns;
+	matchColumns << "name" << "dateTime";
+	QSqlQuery q = sourceRowsWithMatches(tableName, matchColumns);
 	int stepIndex = 0;
 	int totalSteps = q.size();
 	while(q.next()) {
@@ -152,19 +182,8 @@ void AMScanDatabaseImportController::analyzeRunsForDuplicates()
 
 		sourceRuns_[id] = name % ", started " % AMDateTimeUtils::prettyDateTime(dateTime);
 
-		// Find a matching one in destinationDb_.
-		QSqlQuery q2 = AMDbObjectSupport::s()->select<AMRun>(destinationDb_, "id", "name = ? AND dateTime = ?");
-		q2.bindValue(0, name);
-		q2.bindValue(1, dateTime);
-		q2.exec();
-		if(q2.first()) {
-			// found one.
-			s2dRunIds_[id] = q2.value(0).toInt();	// insert a mapping from source run IDs to destination run IDs
-		}
-		else {
-			// none found in destination. Will need to create it.
-			s2dRunIds_[id] = -1;
-		}
+		// Find a matching one in destinationDb_: insert a mapping from source run IDs to destination run IDs, or -1 if none was found and it will need to be created.
+		s2dRunIds_[id] = matchingDestinationId(q, tableName, matchColumns);
 
 		qApp->sendPostedEvents();
 		qApp->processEvents();
@@ -185,8 +204,10 @@ void AMScanDatabaseImportController::analyzeExperimentsForDuplicates()
 	emit stepProgress(-1);
 
 	// go through experiments in source, and see if any exist in destination
-	QSqlQuery q = AMDbObjectSupport::s()->select<AMExperiment>(sourceDb_, "id, name");
-	q.exec();
+	QString tableName = AMDbObjectSupport::s()->tableNameForClass<AMExperiment>();
+	QStringList matchColumns;
+	matchColumns << "name";
+	QSqlQuery q = sourceRowsWithMatches(tableName, matchColumns);
 	int stepIndex = 0;
 	int totalSteps = q.size();
 	while(q.next()) {
@@ -197,18 +218,8 @@ void AMScanDatabaseImportController::analyzeExperimentsForDuplicates()
 
 		sourceExperiments_[id] = name;
 
-		// Find a matching one in destinationDb_.
-		QSqlQuery q2 = AMDbObjectSupport::s()->select<AMExperiment>(destinationDb_, "id", "name = ?");
-		q2.bindValue(0, name);
-		q2.exec();
-		if(q2.first()) {
-			// found one.
-			s2dExperimentIds_[id] = q2.value(0).toInt();	// insert a mapping from source experiment IDs to destination experiment IDs
-		}
-		else {
-			// none found in destination. Will need to create it.
-			s2dExperimentIds_[id] = -1;
-		}
+		// Find a matching one in destinationDb_: insert a mapping from source experiment IDs to destination experiment IDs, or -1 if none was found and it will need to be created.
+		s2dExperimentIds_[id] = matchingDestinationId(q, tableName, matchColumns);
 		qApp->sendPostedEvents();
 		qApp->processEvents();
 	}
@@ -228,8 +239,10 @@ void AMScanDatabaseImportController::analyzeSamplesForDuplicates()
 	emit stepProgress(-1);
 
 	// go through samples in source, and see if any exist in destination
-	QSqlQuery q = AMDbObjectSupport::s()->select<AMSample>(sourceDb_, "id, name, dateTime");
-	q.exec();
+	QString tableName = AMDbObjectSupport::s()->tableNameForClass<AMSample>();
+	QStringList matchColumns;
+	matchColumns << "name" << "dateTime";
+	QSqlQuery q = sourceRowsWithMatches(tableName, matchColumns);
 	int stepIndex = 0;
 	int totalSteps = q.size();
 	while(q.next()) {
@@ -241,19 +254,8 @@ void AMScanDatabaseImportController::analyzeSamplesForDuplicates()
 
 		sourceSamples_[id] = name % ", created " % AMDateTimeUtils::prettyDateTime(dateTime);
 
-		// Find a matching one in destinationDb_.
-		QSqlQuery q2 = AMDbObjectSupport::s()->select<AMSample>(destinationDb_, "id", "name = ? AND dateTime = ?");
-		q2.bindValue(0, name);
-		q2.bindValue(1, dateTime);
-		q2.exec();
-		if(q2.first()) {
-			// found one.
-			s2dSampleIds_[id] = q2.value(0).toInt();	// insert a mapping from source sample IDs to destination sample IDs
-		}
-		else {
-			// none found in destination. Will need to create it.
-			s2dSampleIds_[id] = -1;
-		}
+		// Find a matching one in destinationDb_: insert a mapping from source sample IDs to destination sample IDs, or -1 if none was found and it will need to be created.
+		s2dSampleIds_[id] = matchingDestinationId(q, tableName, matchColumns);
 		qApp->sendPostedEvents();
 		qApp->processEvents();
 	}
@@ -277,6 +279,7 @@ void AMScanDatabaseImportController::startDatabaseOperations()
 	if(state_ == Importing) {	// if we were cancelled, don't commit the transaction.
 		state_ = Finished;
 		destinationDb_->commitTransaction();
+		detachSourceDatabase();
 		emit progressDescription("Import complete.");
 		emit stepProgress(100);
 	}
@@ -288,6 +291,9 @@ void AMScanDatabaseImportController::copyFacilities()
 
 	emit progressDescription("Copying Facilities...");
 	emit stepProgress(-1);
+
+	if(copyRowsInBulk(&AMFacility::staticMetaObject, s2dFacilityIds_))
+		return;
 	int totalSteps = s2dFacilityIds_.count();
 	int currentStep = 0;
 
@@ -317,6 +323,11 @@ void AMScanDatabaseImportController::copyRuns()
 
 	emit progressDescription("Copying Runs...");
 	emit stepProgress(-1);
+
+	QMap<QString, QString> foreignKeyTables;
+	foreignKeyTables.insert("facilityId", AMDbObjectSupport::s()->tableNameForClass<AMFacility>());
+	if(copyRowsInBulk(&AMRun::staticMetaObject, s2dRunIds_, foreignKeyTables))
+		return;
 	int totalSteps = s2dRunIds_.count();
 	int currentStep = 0;
 
@@ -346,6 +357,9 @@ void AMScanDatabaseImportController::copyExperiments()
 	if(state_ != Importing) return;
 	emit progressDescription("Copying Experiments...");
 	emit stepProgress(-1);
+
+	if(copyRowsInBulk(&AMExperiment::staticMetaObject, s2dExperimentIds_))
+		return;
 	int totalSteps = s2dExperimentIds_.count();
 	int currentStep = 0;
 
@@ -375,6 +389,9 @@ void AMScanDatabaseImportController::copySamples()
 	if(state_ != Importing) return;
 	emit progressDescription("Copying Samples...");
 	emit stepProgress(-1);
+
+	if(copyRowsInBulk(&AMSample::staticMetaObject, s2dSampleIds_))
+		return;
 	int totalSteps = s2dSampleIds_.count();
 	int currentStep = 0;
 
@@ -440,12 +457,11 @@ void AMScanDatabaseImportController::copyScans()
 		scan->setSampleId(s2dSampleIds_.value(scan->sampleId(), -1));
 
 		// copy the raw data: filePath and additionalFilePaths
-		QDir destinationDir(destinationPath_);
 		// Assuming paths always in relative file format.
 		QString filePath = scan->filePath();
 
-		// Does the file exist already in the destination?
-		if(destinationDir.exists(filePath)) {
+		// Does the file exist already in the destination (or is another imported scan going to put it there)?
+		if(destinationFileExists(filePath)) {
 			// I know we're not supposed to be a GUI module... but is it okay to prompt here for what to do?
 			if(userSaysShouldSkipDuplicateScan(scan)) {
 				scan->release(this);
@@ -453,19 +469,22 @@ void AMScanDatabaseImportController::copyScans()
 			}
 			filePath = makeUniqueFileName(destinationPath_, filePath);
 		}
-		copyFileAndMakeFoldersAsRequired(sourcePath_ % "/" % scan->filePath(),
-										 destinationPath_ % "/" % filePath);
+		// The files are copied in parallel once all the scans are stored.
+		queueFileCopy(sourcePath_ % "/" % scan->filePath(),
+					  destinationPath_ % "/" % filePath);
+		reservedDestinationFiles_ << filePath;
 		scan->setFilePath(filePath);
 
 		// Copy additional file paths:
 		QStringList extraPaths = scan->additionalFilePaths();
 		for(int j=0, cc=extraPaths.count(); j<cc; j++) {
 			QString destinationFilePath = extraPaths.at(j);
-			if(destinationDir.exists(destinationFilePath)) {
+			if(destinationFileExists(destinationFilePath)) {
 				destinationFilePath = makeUniqueFileName(destinationPath_, destinationFilePath);
 			}
-			copyFileAndMakeFoldersAsRequired(sourcePath_ % "/" % extraPaths.at(j),
-											 destinationPath_ % "/" % destinationFilePath);
+			queueFileCopy(sourcePath_ % "/" % extraPaths.at(j),
+						  destinationPath_ % "/" % destinationFilePath);
+			reservedDestinationFiles_ << destinationFilePath;
 			extraPaths[j] = destinationFilePath;
 		}
 		scan->setAdditionalFilePaths(extraPaths);
@@ -547,13 +566,16 @@ void AMScanDatabaseImportController::copyScans()
 		qApp->processEvents();
 	}
 	AMScan::setAutoLoadData(true);	// turn it back on, so we don't interfere with anyone else...
+
+	if(state_ == Importing)
+		copyQueuedFilesInParallel();
 }
 
 #include <QFileInfo>
 QString AMScanDatabaseImportController::makeUniqueFileName(const QString &parentFolder, const QString &file)
 {
 	QDir parentDir(parentFolder);
-	if(!parentDir.exists(file))
+	if(!parentDir.exists(file) && !reservedDestinationFiles_.contains(file))
 		return file;
 
 	QFileInfo fileInfo(file);
@@ -563,7 +585,7 @@ QString AMScanDatabaseImportController::makeUniqueFileName(const QString &parent
 
 	int numberAppended = 1;
 	QString adjustedName;
-	while(parentDir.exists((adjustedName = path % "/" % baseName % "_c" % QString::number(numberAppended) % "." % completeSuffix)))
+	while(parentDir.exists((adjustedName = path % "/" % baseName % "_c" % QString::number(numberAppended) % "." % completeSuffix)) || reservedDestinationFiles_.contains(adjustedName))
 		numberAppended++;
 
 	return adjustedName;
@@ -603,8 +625,309 @@ void AMScanDatabaseImportController::cancelAndRollBack()
 {
 	if(state_ == Importing) {
 		state_ = Cancelled;	// this will trigger all functions to give up
+		fileCopies_.cancel();
 		destinationDb_->rollbackTransaction();
+		detachSourceDatabase();
 		emit progressDescription("Cancelled. Your database has not been changed.");
 		emit stepProgress(0);
 	}
 }
+
+bool AMScanDatabaseImportController::attachSourceDatabase()
+{
+	if(sourceAttached_)
+		return true;
+
+	sourceAttached_ = destinationDb_->attachDatabase(sourcePath_ % "/" % AMUserSettings::userDatabaseFilename, sourceSchemaName());
+	return sourceAttached_;
+}
+
+void AMScanDatabaseImportController::detachSourceDatabase()
+{
+	if(sourceAttached_) {
+		destinationDb_->detachDatabase(sourceSchemaName());
+		sourceAttached_ = false;
+	}
+}
+
+QSqlQuery AMScanDatabaseImportController::sourceRowsWithMatches(const QString &tableName, const QStringList &matchColumns)
+{
+	if(!sourceAttached_) {
+		QSqlQuery q = sourceDb_->select(tableName, (QStringList() << "id" << matchColumns).join(", "));
+		q.exec();
+		return q;
+	}
+
+	QStringList sourceColumns;
+	QStringList conditions;
+	sourceColumns << "s.id";
+	foreach(QString column, matchColumns) {
+		sourceColumns << "s." % column;
+		conditions << "d." % column % " = s." % column;
+	}
+
+	// One pass over both tables instead of one destination query per source row.
+	QSqlQuery q = destinationDb_->query();
+	q.prepare(QString("SELECT %1, MIN(d.id) FROM %2.%3 s LEFT JOIN main.%3 d ON %4 GROUP BY s.id ORDER BY s.id")
+			  .arg(sourceColumns.join(", "))
+			  .arg(sourceSchemaName())
+			  .arg(tableName)
+			  .arg(conditions.join(" AND ")));
+	AMDatabase::execQuery(q);
+	return q;
+}
+
+int AMScanDatabaseImportController::matchingDestinationId(const QSqlQuery &sourceRow, const QString &tableName, const QStringList &matchColumns)
+{
+	if(sourceAttached_) {
+		QVariant destinationId = sourceRow.value(matchColumns.count()+1);
+		return destinationId.isNull() ? -1 : destinationId.toInt();
+	}
+
+	QStringList conditions;
+	foreach(QString column, matchColumns)
+		conditions << column % " = ?";
+
+	QSqlQuery q = destinationDb_->select(tableName, "id", conditions.join(" AND "));
+	for(int i = 0, size = matchColumns.count(); i < size; i++)
+		q.bindValue(i, sourceRow.value(i+1));
+	q.exec();
+
+	if(q.first())
+		return q.value(0).toInt();
+
+	return -1;
+}
+
+bool AMScanDatabaseImportController::copyRowsInBulk(const QMetaObject *classMetaObject, QMap<int, int> &s2dIds, const QMap<QString, QString> &foreignKeyTables)
+{
+	if(!sourceAttached_)
+		return false;
+
+	const AMDbObjectInfo *info = AMDbObjectSupport::s()->objectInfoForClass(classMetaObject->className());
+	if(!info || info->sharedTable)
+		return false;
+
+	// Child objects, and lists of them, are stored in other tables and need the object path.
+	foreach(int columnType, info->columnTypes)
+		if(columnType == qMetaTypeId<AMDbObject*>() || columnType == qMetaTypeId<AMDbObjectList>())
+			return false;
+
+	QString tableName = info->tableName;
+
+	// The source might have been written by an older version, so only copy the columns both tables have.  The new thumbnails are pointed at afterwards.
+	QStringList sourceColumns = destinationDb_->columnNames(sourceSchemaName() % "." % tableName);
+	QStringList columns;
+	foreach(QString column, destinationDb_->columnNames(tableName))
+		if(column != "id" && column != "thumbnailFirstId" && sourceColumns.contains(column))
+			columns << column;
+
+	if(columns.isEmpty())
+		return false;
+
+	// QMap keys are sorted, so these are in the same order as the copied rows.
+	QList<int> sourceIds;
+	QMapIterator<int, int> i(s2dIds);
+	while(i.hasNext()) {
+		i.next();
+		if(i.value() < 1)
+			sourceIds << i.key();
+	}
+
+	if(sourceIds.isEmpty())
+		return true;
+
+	QStringList selectColumns;
+	foreach(QString column, columns) {
+
+		if(foreignKeyTables.contains(column)) {
+
+			QString referencedTable = foreignKeyTables.value(column);
+			QMap<int, int> *referencedIds = idMappingForTable(referencedTable);
+			if(!referencedIds || !storeIdMapping(referencedTable, *referencedIds))
+				return false;
+
+			selectColumns << QString("COALESCE((SELECT m.destinationId FROM temp.AMImportIdMap m WHERE m.tableName = '%1' AND m.sourceId = s.%2 AND m.destinationId > 0), -1)").arg(referencedTable).arg(column);
+		}
+
+		else
+			selectColumns << "s." % column;
+	}
+
+	if(!storeIdMapping(tableName, s2dIds))
+		return false;
+
+	int lastIdBeforeCopy = maximumId(destinationDb_, tableName);
+
+	int insertedRows = destinationDb_->insertFromSelect(tableName, columns, QString("SELECT %1 FROM %2.%3 s WHERE s.id IN (SELECT sourceId FROM temp.AMImportIdMap WHERE tableName = '%3' AND destinationId < 1) ORDER BY s.id")
+														.arg(selectColumns.join(", "))
+														.arg(sourceSchemaName())
+														.arg(tableName));
+	if(insertedRows < 0)
+		return false;	// Nothing was inserted: a failed statement is rolled back by itself.
+
+	// New rows get increasing ids in the order they were inserted, with or without AUTOINCREMENT.
+	QList<int> destinationIds = destinationDb_->objectsWhere(tableName, QString("id > %1 ORDER BY id").arg(lastIdBeforeCopy));
+
+	if(destinationIds.count() != sourceIds.count()) {
+
+		AMErrorMon::alert(this, AMSCANDATABASEIMPORTCONTROLLER_BULK_COPY_FAILED, QString("Copied %1 rows into '%2', but expected %3. They will be copied one at a time instead.").arg(destinationIds.count()).arg(tableName).arg(sourceIds.count()));
+		destinationDb_->deleteRows(tableName, QString("id > %1").arg(lastIdBeforeCopy));
+		return false;
+	}
+
+	for(int j = 0, size = sourceIds.count(); j < size; j++)
+		s2dIds[sourceIds.at(j)] = destinationIds.at(j);
+
+	if(!storeIdMapping(tableName, s2dIds) || !copyThumbnailsInBulk(tableName, lastIdBeforeCopy))
+		AMErrorMon::alert(this, AMSCANDATABASEIMPORTCONTROLLER_BULK_COPY_FAILED, QString("Could not copy the thumbnails for the rows imported into '%1'.").arg(tableName));
+
+	emit stepProgress(100);
+	return true;
+}
+
+bool AMScanDatabaseImportController::copyThumbnailsInBulk(const QString &tableName, int lastIdBeforeCopy)
+{
+	QString thumbnailTableName = AMDbObjectSupport::thumbnailTableName();
+	QStringList thumbnailColumns;
+	thumbnailColumns << "objectId" << "objectTableName" << "number" << "type" << "title" << "subtitle" << "thumbnail";
+
+	int lastThumbnailIdBeforeCopy = maximumId(destinationDb_, thumbnailTableName);
+
+	// Only the thumbnails each source row actually points at (older, stale ones may be left in the table), kept contiguous for each new row.
+	QString select = QString("SELECT m.destinationId, t.objectTableName, t.number, t.type, t.title, t.subtitle, t.thumbnail "
+							 "FROM %1.%2 t JOIN %1.%3 s ON s.id = t.objectId JOIN temp.AMImportIdMap m ON m.tableName = '%3' AND m.sourceId = s.id "
+							 "WHERE t.objectTableName = '%3' AND m.destinationId > %4 AND t.id >= s.thumbnailFirstId AND t.id < s.thumbnailFirstId + s.thumbnailCount "
+							 "ORDER BY m.destinationId, t.id")
+			.arg(sourceSchemaName())
+			.arg(thumbnailTableName)
+			.arg(tableName)
+			.arg(lastIdBeforeCopy);
+
+	if(destinationDb_->insertFromSelect(thumbnailTableName, thumbnailColumns, select) < 0)
+		return false;
+
+	QSqlQuery q = destinationDb_->query();
+	q.prepare(QString("UPDATE %1 SET thumbnailFirstId = (SELECT MIN(th.id) FROM main.%2 th WHERE th.objectTableName = '%1' AND th.objectId = %1.id AND th.id > %3) WHERE id > %4 AND thumbnailCount > 0")
+			  .arg(tableName)
+			  .arg(thumbnailTableName)
+			  .arg(lastThumbnailIdBeforeCopy)
+			  .arg(lastIdBeforeCopy));
+
+	bool success = AMDatabase::execQuery(q);
+	q.finish();
+
+	return success;
+}
+
+bool AMScanDatabaseImportController::storeIdMapping(const QString &tableName, const QMap<int, int> &s2dIds)
+{
+	QSqlQuery q = destinationDb_->query();
+
+	// Temporary tables belong to this connection, and disappear when it closes.
+	q.prepare("CREATE TEMP TABLE IF NOT EXISTS AMImportIdMap (tableName TEXT, sourceId INTEGER, destinationId INTEGER, PRIMARY KEY (tableName, sourceId))");
+	if(!AMDatabase::execQuery(q))
+		return false;
+
+	q.prepare("DELETE FROM temp.AMImportIdMap WHERE tableName = ?");
+	q.bindValue(0, tableName);
+	if(!AMDatabase::execQuery(q))
+		return false;
+
+	if(s2dIds.isEmpty())
+		return true;
+
+	QVariantList tableNames, sourceIds, destinationIds;
+	QMapIterator<int, int> i(s2dIds);
+	while(i.hasNext()) {
+		i.next();
+		tableNames << tableName;
+		sourceIds << i.key();
+		destinationIds << i.value();
+	}
+
+	q.prepare("INSERT INTO temp.AMImportIdMap (tableName, sourceId, destinationId) VALUES (?, ?, ?)");
+	q.addBindValue(tableNames);
+	q.addBindValue(sourceIds);
+	q.addBindValue(destinationIds);
+
+	bool success = q.execBatch();
+	q.finish();
+
+	return success;
+}
+
+QMap<int, int> * AMScanDatabaseImportController::idMappingForTable(const QString &tableName)
+{
+	if(tableName == AMDbObjectSupport::s()->tableNameForClass<AMFacility>())
+		return &s2dFacilityIds_;
+	if(tableName == AMDbObjectSupport::s()->tableNameForClass<AMRun>())
+		return &s2dRunIds_;
+	if(tableName == AMDbObjectSupport::s()->tableNameForClass<AMExperiment>())
+		return &s2dExperimentIds_;
+	if(tableName == AMDbObjectSupport::s()->tableNameForClass<AMSample>())
+		return &s2dSampleIds_;
+
+	return 0;
+}
+
+bool AMScanDatabaseImportController::destinationFileExists(const QString &file) const
+{
+	return reservedDestinationFiles_.contains(file) || QDir(destinationPath_).exists(file);
+}
+
+void AMScanDatabaseImportController::queueFileCopy(const QString &sourcePath, const QString &destinationPath)
+{
+	// Make the folders here, so the worker threads don't race to create the same ones.
+	QString destinationFolder = QFileInfo(destinationPath).path();
+	if(!QDir(destinationFolder).exists())
+		QDir::root().mkpath(destinationFolder);
+
+	queuedFileCopies_ << qMakePair(sourcePath, destinationPath);
+}
+
+/// Used by copyQueuedFilesInParallel() to copy one (source, destination) pair.
+static bool copyQueuedFile(const QPair<QString, QString> &sourceAndDestination)
+{
+	return QFile::copy(sourceAndDestination.first, sourceAndDestination.second);
+}
+
+bool AMScanDatabaseImportController::copyQueuedFilesInParallel()
+{
+	if(queuedFileCopies_.isEmpty())
+		return true;
+
+	emit progressDescription("Copying Raw Data Files...");
+	emit stepProgress(0);
+
+	// Keep processing events while the copies run, like the rest of the import does.
+	QEventLoop waitLoop;
+	QFutureWatcher<bool> watcher;
+	connect(&watcher, SIGNAL(progressValueChanged(int)), this, SLOT(onFileCopyProgressChanged(int)));
+	connect(&watcher, SIGNAL(finished()), &waitLoop, SLOT(quit()));
+
+	fileCopies_ = QtConcurrent::mapped(queuedFileCopies_, copyQueuedFile);
+	watcher.setFuture(fileCopies_);
+	waitLoop.exec();
+
+	int failedCopies = 0;
+	if(!fileCopies_.isCanceled())
+		foreach(bool copied, fileCopies_.results())
+			if(!copied)
+				failedCopies++;
+
+	if(failedCopies > 0)
+		AMErrorMon::alert(this, AMSCANDATABASEIMPORTCONTROLLER_FILE_COPY_FAILED, QString("Could not copy %1 of the %2 raw data files for the imported scans.").arg(failedCopies).arg(queuedFileCopies_.count()));
+
+	queuedFileCopies_.clear();
+	reservedDestinationFiles_.clear();
+	fileCopies_ = QFuture<bool>();
+
+	return failedCopies == 0;
+}
+
+void AMScanDatabaseImportController::onFileCopyProgressChanged(int filesCopied)
+{
+	if(!queuedFileCopies_.isEmpty())
+		emit stepProgress(int(100.0*filesCopied/queuedFileCopies_.count()));
+}
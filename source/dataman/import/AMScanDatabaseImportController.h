@@ -23,14 +23,24 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QMap>
+#include <QSet>
+#include <QPair>
+#include <QFuture>
 
 #include "dataman/database/AMDatabase.h"
 #include "util/AMSettings.h"
 
 #define AMSCANDATABASEIMPORTCONTROLLER_ERROR_STORING_UPDATED_THUMBNAIL_COUNT_AND_FIRST_ID -3315
+#define AMSCANDATABASEIMPORTCONTROLLER_BULK_COPY_FAILED -3316
+#define AMSCANDATABASEIMPORTCONTROLLER_FILE_COPY_FAILED -3317
 
 class AMScan;
 
+/// This class imports the runs, experiments, samples, and scans (with their raw data files) from another user data folder into the current database.
+/*! After the source folder is set, the analyze...() functions look for facilities, runs, experiments and samples that exist in both databases, so they can be merged.  startDatabaseOperations() then copies everything in one transaction on the destination database.
+
+When the source database can be attached to the destination connection (AMDatabase::attachDatabase()), the duplicate analysis is done with one join per table, and the rows of classes stored entirely in their own table (facilities, runs, experiments, samples) are copied with a single INSERT...SELECT, along with their thumbnails.  Ids are remapped through a temporary mapping table.  Scans own child objects in other tables and need their file paths adjusted, so they are still copied one object at a time; their raw data files are copied in parallel once all of the scans are stored.  If the database can't be attached, everything falls back to copying objects one at a time.
+*/
 class AMScanDatabaseImportController : public QObject
 {
     Q_OBJECT
@@ -47,6 +57,8 @@ public:
 	explicit AMScanDatabaseImportController(AMDatabase* destinationDb = AMDatabase::database("user"),
 											const QString& destinationPath = AMUserSettings::userDataFolder,
 											QObject *parent = 0);
+	/// Detaches the source database, if it was attached.
+	virtual ~AMScanDatabaseImportController();
 
 	// linear sequence of states
 	AMScanDatabaseImportControllerState state() { return state_; }
@@ -87,6 +99,10 @@ signals:
 
 public slots:
 
+protected slots:
+	/// Reports the progress of the parallel file copies as stepProgress().
+	void onFileCopyProgressChanged(int filesCopied);
+
 protected:
 	QString sourcePath_, destinationPath_;
 	AMDatabase* sourceDb_, *destinationDb_;
@@ -106,6 +122,32 @@ protected:
 	void copySamples();
 	void copyScans();
 
+	/// Attaches the source database to the destination connection for the bulk paths.  Returns false (and the object paths are used) if it can't be attached.
+	bool attachSourceDatabase();
+	/// Detaches the source database. Must not be called while the import transaction is open.
+	void detachSourceDatabase();
+
+	/// Returns a query (already executed) over the rows of \c tableName in the source database, selecting the id, then \c matchColumns.  When the source is attached, the id of the first destination row with equal \c matchColumns (or NULL) is selected last.
+	QSqlQuery sourceRowsWithMatches(const QString& tableName, const QStringList& matchColumns);
+	/// Returns the id of the destination row matching the current row of a query from sourceRowsWithMatches(), or -1 if there is none.
+	int matchingDestinationId(const QSqlQuery& sourceRow, const QString& tableName, const QStringList& matchColumns);
+
+	/// Copies the rows of the class described by \c classMetaObject that are mapped to -1 in \c s2dIds, in one statement, and fills in their new ids.  \c foreignKeyTables maps column names to the tables they refer to; these columns are remapped to destination ids. Returns false if the class can't be copied this way (ex: it owns child objects in other tables), so that the caller should use the object path.
+	bool copyRowsInBulk(const QMetaObject* classMetaObject, QMap<int, int>& s2dIds, const QMap<QString, QString>& foreignKeyTables = QMap<QString, QString>());
+	/// Copies the thumbnails for the rows of \c tableName that were inserted by copyRowsInBulk() (those with ids above \c lastIdBeforeCopy), and points the rows at them.
+	bool copyThumbnailsInBulk(const QString& tableName, int lastIdBeforeCopy);
+	/// Writes the source-to-destination id mapping for \c tableName into the temporary mapping table used by the bulk copies.
+	bool storeIdMapping(const QString& tableName, const QMap<int, int>& s2dIds);
+	/// Returns the id mapping for the table of facilities, runs, experiments or samples, or 0 for other tables.
+	QMap<int, int>* idMappingForTable(const QString& tableName);
+
+	/// Returns true if \c file exists in the destination folder, or is already going to be copied there.
+	bool destinationFileExists(const QString& file) const;
+	/// Creates the folders for \c destinationPath and queues a copy from \c sourcePath for copyQueuedFilesInParallel().
+	void queueFileCopy(const QString& sourcePath, const QString& destinationPath);
+	/// Copies all of the queued files using a thread pool, while processing events. Returns false if any copy failed.
+	bool copyQueuedFilesInParallel();
+
 	/// Helper function to check if a \c file exists within the \c parentFolder, and returns a unique name that doesn't conflict with what's already on the file system.  Relative paths are OK within \c file.
 	QString makeUniqueFileName(const QString& parentFolder, const QString& file);
 	/// Helper function to check if a user wants to skip or duplicate a scan where the raw data seems to already exist in the destination. Returns true if we should skip the new scan, false if the user wants to keep both.
@@ -115,6 +157,15 @@ protected:
 
 
 	AMScanDatabaseImportControllerState state_;
+
+	/// True when the source database is attached to the destination connection (see attachSourceDatabase()).
+	bool sourceAttached_;
+	/// Raw data files waiting to be copied: (absolute source path, absolute destination path).
+	QList<QPair<QString, QString> > queuedFileCopies_;
+	/// Destination files (relative to destinationPath_) that are queued to be copied.
+	QSet<QString> reservedDestinationFiles_;
+	/// The parallel file copies, while they are running.
+	QFuture<bool> fileCopies_;
 };
 
 #endif // AMSCANDATABASEIMPORTCONTROLLER_H
@@ -0,0 +1,587 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef BENCHMARKDATAMAN_H
+#define BENCHMARKDATAMAN_H
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <math.h>
+
+#include "dataman/database/AMDatabase.h"
+#include "dataman/AMScan.h"
+#include "dataman/AMXASScan.h"
+#include "dataman/AMSample.h"
+#include "dataman/datastore/AMInMemoryDataStore.h"
+#include "dataman/datastore/AMCDFDataStore.h"
+#include "dataman/datasource/AMRawDataSource.h"
+#include "dataman/datasource/AMDataSourceThumbnailRenderer.h"
+#include "dataman/export/AMExporterGeneralAscii.h"
+#include "dataman/export/AMExporterOptionGeneralAscii.h"
+#include "dataman/datastore/AMCompressedSpectrumDataStore.h"
+#include "analysis/AM1DExpressionAB.h"
+#include "analysis/AM2DSummingAB.h"
+#include "analysis/AM1DIntegralAB.h"
+#include "analysis/AMRegionOfInterestAB.h"
+#include "analysis/AMRegionOfInterestEngine.h"
+#include "util/AMSlidingWindow.h"
+#include "application/AMPluginsManager.h"
+#include "acquaman/AMScanReplay.h"
+
+/// This class contains the QBENCHMARK performance tests for the dataman and analysis modules.
+/*! Each private slot measures one hot path, on synthetic data generated here so that the suite runs anywhere, without beamline files or a populated database.  Slots with a matching _data() function are run once for every row, so that the same path can be compared at several sizes.
+
+The benchmarks don't check results; the unit tests in TestDataman do that.  They only QVERIFY enough to make sure they're measuring real work (ex: that a data store accepted its values.)
+
+See benchmarkMain.cpp for how to save the results and compare them between commits.
+*/
+class BenchmarkDataman : public QObject
+{
+	Q_OBJECT
+
+private slots:
+
+	/// Writes a rows x channels scan into an AMInMemoryDataStore, one spectrum at a time.
+	void benchmarkAMInMemoryDataStoreSetValue_data() { addScanSizes(); }
+	void benchmarkAMInMemoryDataStoreSetValue()
+	{
+		QFETCH(int, rows);
+		QFETCH(int, channels);
+
+		QVector<double> spectrum = syntheticSpectrum(channels);
+
+		QBENCHMARK {
+			AMInMemoryDataStore store;
+			initializeStore(&store, channels);
+			store.beginInsertRows(rows, -1);
+			for(int i = 0; i < rows; i++) {
+				store.setAxisValue(0, i, 270.0 + 0.1*i);
+				store.setValue(AMnDIndex(i), 0, AMnDIndex(), 1.5*i);
+				store.setValue(AMnDIndex(i), 1, AMnDIndex(), 1000.0 + i);
+				store.setValue(AMnDIndex(i), 2, spectrum.constData());
+			}
+			store.endInsertRows();
+		}
+	}
+
+	/// Reads a whole rows x channels measurement out of an AMInMemoryDataStore in one values() call.
+	void benchmarkAMInMemoryDataStoreValues_data() { addScanSizes(); }
+	void benchmarkAMInMemoryDataStoreValues()
+	{
+		QFETCH(int, rows);
+		QFETCH(int, channels);
+
+		AMInMemoryDataStore store;
+		fillStore(&store, rows, channels);
+		QVector<double> output(rows*channels);
+
+		QBENCHMARK {
+			QVERIFY(store.values(AMnDIndex(0), AMnDIndex(rows-1), 2, AMnDIndex(0), AMnDIndex(channels-1), output.data()));
+		}
+	}
+
+	/// Reads a rows x channels measurement out of an AMCDFDataStore, in one values() call and one spectrum at a time.
+	void benchmarkAMCDFDataStoreValues_data() { addScanSizes(); }
+	void benchmarkAMCDFDataStoreValues()
+	{
+		QFETCH(int, rows);
+		QFETCH(int, channels);
+
+		AMCDFDataStore store;
+		QVERIFY(store.isValid());
+		fillStore(&store, rows, channels);
+		QVERIFY(store.flushToDisk());
+		QVector<double> output(rows*channels);
+
+		QBENCHMARK {
+			QVERIFY(store.values(AMnDIndex(0), AMnDIndex(rows-1), 2, AMnDIndex(0), AMnDIndex(channels-1), output.data()));
+			for(int i = 0; i < rows; i++)
+				store.values(AMnDIndex(i), AMnDIndex(i), 2, AMnDIndex(0), AMnDIndex(channels-1), output.data());
+		}
+	}
+
+	/// Sums the spectra of a rows x channels scan with AM2DSummingAB.
+	void benchmarkAM2DSummingAB_data() { addScanSizes(); }
+	void benchmarkAM2DSummingAB()
+	{
+		QFETCH(int, rows);
+		QFETCH(int, channels);
+
+		AMInMemoryDataStore store;
+		fillStore(&store, rows, channels);
+		AMRawDataSource *spectra = new AMRawDataSource(&store, 2);
+
+		AM2DSummingAB sum("sum");
+		sum.setInputDataSources(QList<AMDataSource*>() << spectra);
+		sum.setSumAxis(1);
+		sum.setSumRangeMin(0);
+		sum.setSumRangeMax(channels-1);
+		QVERIFY(sum.isValid());
+		QVector<double> output(rows);
+
+		QBENCHMARK {
+			QVERIFY(sum.values(AMnDIndex(0), AMnDIndex(rows-1), output.data()));
+		}
+
+		sum.setInputDataSources(QList<AMDataSource*>());
+		delete spectra;
+	}
+
+	/// Evaluates "tey/I0" over a scan with AM1DExpressionAB, one value() at a time and with values().
+	void benchmarkAM1DExpressionAB_data()
+	{
+		QTest::addColumn<int>("rows");
+		QTest::newRow("1k") << 1000;
+		QTest::newRow("100k") << 100000;
+	}
+	void benchmarkAM1DExpressionAB()
+	{
+		QFETCH(int, rows);
+
+		AMInMemoryDataStore store;
+		fillStore(&store, rows, 1);
+		AMRawDataSource *tey = new AMRawDataSource(&store, 0);
+		AMRawDataSource *i0 = new AMRawDataSource(&store, 1);
+
+		AM1DExpressionAB expression("tey_n");
+		expression.setInputDataSources(QList<AMDataSource*>() << tey << i0);
+		QVERIFY(expression.setExpression("tey/I0"));
+		QVERIFY(expression.isValid());
+		QVector<double> output(rows);
+
+		QBENCHMARK {
+			for(int i = 0; i < rows; i++)
+				output[i] = expression.value(AMnDIndex(i));
+			QVERIFY(expression.values(AMnDIndex(0), AMnDIndex(rows-1), output.data()));
+		}
+
+		expression.setInputDataSources(QList<AMDataSource*>());
+		delete tey;
+		delete i0;
+	}
+
+	/// Computes the full running integral of a 1M point source with AM1DIntegralAB, starting from an empty cache every time.
+	void benchmarkAM1DIntegralAB()
+	{
+		const int rows = 1000000;
+
+		AMInMemoryDataStore store;
+		fillStore(&store, rows, 1);
+		AMRawDataSource *tey = new AMRawDataSource(&store, 0);
+		QVector<double> output(rows);
+
+		QBENCHMARK {
+			AM1DIntegralAB integral("integral");
+			integral.setInputDataSources(QList<AMDataSource*>() << tey);
+			QVERIFY(integral.values(AMnDIndex(0), AMnDIndex(rows-1), output.data()));
+			integral.setInputDataSources(QList<AMDataSource*>());
+		}
+
+		delete tey;
+	}
+
+	/// Recomputes three regions of interest over a 64x64x1024 map with AMRegionOfInterestAB.
+	void benchmarkAMRegionOfInterestAB()
+	{
+		const int xSize = 64, ySize = 64, channels = 1024;
+
+		AMInMemoryDataStore store;
+		store.addScanAxis(AMAxisInfo("x", 0, "x axis"));
+		store.addScanAxis(AMAxisInfo("y", ySize, "y axis"));
+		store.addMeasurement(AMMeasurementInfo("xrf", "XRF Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels, "Channel")));
+		QVector<double> spectrum = syntheticSpectrum(channels);
+		store.beginInsertRows(xSize, -1);
+		for(int x = 0; x < xSize; x++)
+			for(int y = 0; y < ySize; y++)
+				QVERIFY(store.setValue(AMnDIndex(x, y), 0, spectrum.constData()));
+		store.endInsertRows();
+
+		AMRawDataSource *xrf = new AMRawDataSource(&store, 0);
+		QList<AMRegionOfInterestAB*> regions;
+		for(int r = 0; r < 3; r++) {
+			AMRegionOfInterestAB *region = new AMRegionOfInterestAB(QString("roi%1").arg(r));
+			region->setRegionMinimum(100 + 200*r);
+			region->setRegionMaximum(199 + 200*r);
+			region->setInputDataSources(QList<AMDataSource*>() << xrf);
+			regions << region;
+		}
+		QVERIFY(regions.first()->isValid());
+		QVector<double> output(xSize*ySize);
+
+		QBENCHMARK {
+			regions.first()->engine()->invalidate();
+			foreach(AMRegionOfInterestAB *region, regions)
+				QVERIFY(region->values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), output.data()));
+		}
+
+		qDeleteAll(regions);
+		delete xrf;
+	}
+
+	/// Runs the AMSlidingWindow kernels over 100k points, for several window sizes.
+	void benchmarkAMSlidingWindow_data()
+	{
+		QTest::addColumn<int>("halfWidth");
+		QTest::newRow("halfWidth 2") << 2;
+		QTest::newRow("halfWidth 16") << 16;
+		QTest::newRow("halfWidth 128") << 128;
+	}
+	void benchmarkAMSlidingWindow()
+	{
+		QFETCH(int, halfWidth);
+
+		const int count = 100000;
+		QVector<double> input(count), output(count);
+		for(int i = 0; i < count; i++)
+			input[i] = sin(0.001*i) + (i%17)*0.01;
+		QVector<double> coefficients = AMSlidingWindow::savitzkyGolayCoefficients(halfWidth, 2);
+
+		QBENCHMARK {
+			AMSlidingWindow::runningMean(input.constData(), count, halfWidth, output.data());
+			AMSlidingWindow::runningMinimum(input.constData(), count, halfWidth, output.data());
+			AMSlidingWindow::runningMaximum(input.constData(), count, halfWidth, output.data());
+			AMSlidingWindow::savitzkyGolay(input.constData(), count, coefficients, output.data());
+		}
+	}
+
+	/// Renders a 100k point line into a database thumbnail.
+	void benchmarkAMDataSourceThumbnailRenderer()
+	{
+		const int count = 100000;
+		QVector<double> x(count), y(count);
+		for(int i = 0; i < count; i++) {
+			x[i] = 100.0 + 0.01*i;
+			y[i] = sin(0.001*i) + (i%13)*0.01;
+		}
+
+		QBENCHMARK {
+			QImage image = AMDataSourceThumbnailRenderer::render1D(x.constData(), y.constData(), count, QSize(240, 180), Qt::black);
+			QVERIFY(!image.isNull());
+		}
+	}
+
+	/// Inserts new AMSample and AMXASScan objects into the database with AMDbObject::storeToDb().
+	void benchmarkAMDbObjectStore_data() { addDbObjectClasses(); }
+	void benchmarkAMDbObjectStore()
+	{
+		QFETCH(QString, className);
+		AMDatabase *db = AMDatabase::database("user");
+		QVERIFY(db);
+
+		int number = 0;
+		QBENCHMARK {
+			AMDbObject *object = createDbObject(className, number++);
+			QVERIFY(object->storeToDb(db));
+			deleteDbObject(object);
+		}
+	}
+
+	/// Loads AMSample and AMXASScan objects back from the database with AMDbObject::loadFromDb().
+	void benchmarkAMDbObjectLoad_data() { addDbObjectClasses(); }
+	void benchmarkAMDbObjectLoad()
+	{
+		QFETCH(QString, className);
+		AMDatabase *db = AMDatabase::database("user");
+		QVERIFY(db);
+
+		AMDbObject *stored = createDbObject(className, 0);
+		QVERIFY(stored->storeToDb(db));
+		int id = stored->id();
+		deleteDbObject(stored);
+
+		AMDbObject *loaded = createDbObject(className, 1);
+		QBENCHMARK {
+			QVERIFY(loaded->loadFromDb(db, id));
+		}
+		deleteDbObject(loaded);
+	}
+
+	/// Exports a rows x channels scan (one 1D source and one 2D source) with AMExporterGeneralAscii.
+	void benchmarkAMExporterGeneralAscii_data() { addScanSizes(); }
+	void benchmarkAMExporterGeneralAscii()
+	{
+		QFETCH(int, rows);
+		QFETCH(int, channels);
+
+		AMScan *scan = new AMScan();
+		scan->setName("benchmarkExport");
+		fillStore(scan->rawData(), rows, channels);
+		scan->addRawDataSource(new AMRawDataSource(scan->rawData(), 0));
+		scan->addRawDataSource(new AMRawDataSource(scan->rawData(), 1));
+		scan->addRawDataSource(new AMRawDataSource(scan->rawData(), 2));
+
+		AMExporterGeneralAscii exporter;
+		AMExporterOptionGeneralAscii *option = qobject_cast<AMExporterOptionGeneralAscii*>(exporter.createDefaultOption());
+		QVERIFY(option);
+		option->setFileName("amBenchmarkExport.txt");
+		exporter.setOverwriteOption(AMExporter::All);
+		QVERIFY(exporter.isValidFor(scan, option));
+
+		QString fileName;
+		QBENCHMARK {
+			fileName = exporter.exportScan(scan, QDir::tempPath(), option);
+			QVERIFY(!fileName.isNull());
+		}
+		QFile::remove(fileName);
+
+		delete option;
+		scan->release();
+	}
+
+	/// Exports the spectra of a synthetic square map (256 x 256 pixels of 2048 channels at full size) with AMExporterGeneralAscii.  The exporter's tables don't take rank 3 sources, so the map is stored one pixel per row; that writes the same number of values through the same block reads.  The spectra are kept in an AMCompressedSpectrumDataStore, so that the full map fits in memory.
+	void benchmarkAMExporterGeneralAsciiMap_data()
+	{
+		QTest::addColumn<int>("mapSize");
+		QTest::addColumn<int>("channels");
+		QTest::newRow("64x64x2048") << 64 << 2048;
+		QTest::newRow("256x256x2048") << 256 << 2048;
+	}
+	void benchmarkAMExporterGeneralAsciiMap()
+	{
+		QFETCH(int, mapSize);
+		QFETCH(int, channels);
+
+		AMScan *scan = new AMScan();
+		scan->setName("benchmarkMapExport");
+		AMCompressedSpectrumDataStore *store = new AMCompressedSpectrumDataStore();
+		QVERIFY(scan->replaceRawDataStore(store));
+
+		QVERIFY(store->addScanAxis(AMAxisInfo("pixel", 0, "Pixel")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("I0", "I0")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("spectra", "Spectra", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels, "Channel"))));
+
+		int pixels = mapSize*mapSize;
+		QVector<double> shape = syntheticSpectrum(channels);
+		QVector<int> spectrum(channels);
+		QVERIFY(store->beginInsertRows(pixels, -1));
+		for(int i = 0; i < pixels; i++) {
+			for(int c = 0; c < channels; c++)
+				spectrum[c] = int(shape.at(c)) + (i+c)%4;
+			store->setAxisValue(0, i, i);
+			store->setValue(AMnDIndex(i), 0, AMnDIndex(), 1000.0 + i);
+			store->setValue(AMnDIndex(i), 1, spectrum.constData());
+		}
+		store->endInsertRows();
+		scan->addRawDataSource(new AMRawDataSource(store, 0));
+		scan->addRawDataSource(new AMRawDataSource(store, 1));
+
+		AMExporterGeneralAscii exporter;
+		AMExporterOptionGeneralAscii *option = qobject_cast<AMExporterOptionGeneralAscii*>(exporter.createDefaultOption());
+		QVERIFY(option);
+		option->setFileName("amBenchmarkMapExport.txt");
+		exporter.setOverwriteOption(AMExporter::All);
+		QVERIFY(exporter.isValidFor(scan, option));
+
+		QString fileName;
+		QBENCHMARK {
+			fileName = exporter.exportScan(scan, QDir::tempPath(), option);
+			QVERIFY(!fileName.isNull());
+		}
+		QFile::remove(fileName);
+
+		delete option;
+		scan->release();
+	}
+
+	/// Loads synthetic scan files through the file loader plugins, with AMScan::loadData().
+	void benchmarkFileLoaderPlugins_data()
+	{
+		QTest::addColumn<QString>("fileFormat");
+		QTest::addColumn<int>("rows");
+		QTest::newRow("sgm2004 1k") << "sgm2004" << 1000;
+		QTest::newRow("sgm2004 10k") << "sgm2004" << 10000;
+		QTest::newRow("amCDFv1 1k") << "amCDFv1" << 1000;
+		QTest::newRow("amCDFv1 10k") << "amCDFv1" << 10000;
+	}
+	void benchmarkFileLoaderPlugins()
+	{
+		QFETCH(QString, fileFormat);
+		QFETCH(int, rows);
+
+		if(AMPluginsManager::s()->availableFileLoaderPlugins().values(fileFormat).isEmpty())
+			QSKIP("The file loader plugin for this format isn't available. Check the plugin folder in the Acquaman settings.", SkipSingle);
+
+		QString filePath;
+		if(fileFormat == "sgm2004")
+			filePath = writeSGM2004File(rows);
+		else
+			filePath = writeCDFFile(rows);
+		QVERIFY(!filePath.isEmpty());
+
+		AMXASScan scan;
+		scan.setFileFormat(fileFormat);
+		scan.setFilePath(filePath);
+
+		QBENCHMARK {
+			QVERIFY(scan.loadData());
+		}
+
+		QFile::remove(filePath);
+	}
+
+	/// Replays a rows x channels scan as fast as possible, delivering every AMAgnosticDataAPI message to a receiver, the way scan controllers receive them.
+	void benchmarkAMScanReplayer_data() { addScanSizes(); }
+	void benchmarkAMScanReplayer()
+	{
+		QFETCH(int, rows);
+		QFETCH(int, channels);
+
+		AMXASScan *scan = new AMXASScan();
+		fillStore(scan->rawData(), rows, channels);
+		AMScanReplayRecording recording = AMScanReplayRecording::fromScan(scan, 0);
+		scan->release();
+
+		AMScanReplayRecorder receiver;
+		AMScanReplayer replayer(recording);
+		replayer.addReceiver(&receiver);
+		replayer.setSpeed(0);
+
+		QBENCHMARK {
+			receiver.startRecording();
+			QVERIFY(replayer.start());
+			QCoreApplication::sendPostedEvents(&receiver, 0);
+		}
+
+		int messageCount = 0;
+		foreach(const AMScanReplayEvent &event, recording.events())
+			if(event.kind == AMScanReplayEvent::Message)
+				messageCount++;
+		QCOMPARE(receiver.recording().eventCount(), messageCount);
+	}
+
+private:
+	/// Adds the "rows" and "channels" columns, with the scan sizes used by most of the benchmarks.
+	void addScanSizes()
+	{
+		QTest::addColumn<int>("rows");
+		QTest::addColumn<int>("channels");
+		QTest::newRow("1000x256") << 1000 << 256;
+		QTest::newRow("4000x1024") << 4000 << 1024;
+	}
+
+	/// Adds the "className" column, with the database object classes used by the database benchmarks.
+	void addDbObjectClasses()
+	{
+		QTest::addColumn<QString>("className");
+		QTest::newRow("AMSample") << "AMSample";
+		QTest::newRow("AMXASScan") << "AMXASScan";
+	}
+
+	/// Returns a synthetic spectrum of \c channels values: a couple of peaks on a sloped background.
+	QVector<double> syntheticSpectrum(int channels) const
+	{
+		QVector<double> spectrum(channels);
+		for(int c = 0; c < channels; c++)
+			spectrum[c] = 10 + 0.01*c + 500*exp(-pow((c-0.3*channels)/8.0, 2)) + 200*exp(-pow((c-0.7*channels)/12.0, 2));
+		return spectrum;
+	}
+
+	/// Sets up \c store with an energy axis, and three measurements: "tey" and "I0" (scalars), and "spectra" with \c channels channels.
+	void initializeStore(AMDataStore *store, int channels) const
+	{
+		store->addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV"));
+		store->addMeasurement(AMMeasurementInfo("tey", "TEY"));
+		store->addMeasurement(AMMeasurementInfo("I0", "I0"));
+		store->addMeasurement(AMMeasurementInfo("spectra", "Spectra", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels, "Channel")));
+	}
+
+	/// Sets up \c store with initializeStore(), and fills in \c rows rows of synthetic data.
+	void fillStore(AMDataStore *store, int rows, int channels) const
+	{
+		initializeStore(store, channels);
+		QVector<double> spectrum = syntheticSpectrum(channels);
+
+		store->beginInsertRows(rows, -1);
+		for(int i = 0; i < rows; i++) {
+			store->setAxisValue(0, i, 270.0 + 0.1*i);
+			store->setValue(AMnDIndex(i), 0, AMnDIndex(), 1.5*i + sin(0.01*i));
+			store->setValue(AMnDIndex(i), 1, AMnDIndex(), 1000.0 + i);
+			store->setValue(AMnDIndex(i), 2, spectrum.constData());
+		}
+		store->endInsertRows();
+	}
+
+	/// Creates a new, unsaved object of \c className, with a few properties set.
+	AMDbObject* createDbObject(const QString &className, int number) const
+	{
+		if(className == "AMSample") {
+			AMSample *sample = new AMSample(QString("Benchmark sample %1").arg(number));
+			sample->setDateTime(QDateTime::currentDateTime());
+			return sample;
+		}
+
+		AMXASScan *scan = new AMXASScan();
+		scan->setName(QString("Benchmark scan"));
+		scan->setNumber(number);
+		scan->setNotes("A scan created by the benchmark suite.");
+		return scan;
+	}
+
+	/// Deletes an object created by createDbObject().  Scans are reference-counted, so they must be released instead of deleted.
+	void deleteDbObject(AMDbObject *object) const
+	{
+		AMScan *scan = qobject_cast<AMScan*>(object);
+		if(scan)
+			scan->release();
+		else
+			delete object;
+	}
+
+	/// Writes a synthetic SGM 2004-format file with \c rows points, and returns its path.
+	QString writeSGM2004File(int rows) const
+	{
+		QString filePath = QDir::tempPath() + "/amBenchmarkSGM2004.dat";
+		QFile file(filePath);
+		if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+			return QString();
+
+		QTextStream ts(&file);
+		ts << "# COMMENT\n# A synthetic scan written by the benchmark suite.\n";
+		ts << "#(1) Event-ID BL1611-ID-1:Energy A1611-4-15:A:fbk A1611-4-16:A:fbk A1611-4-14:A:fbk A1611-4-13:A:fbk BL1611-ID-1:Energy:fbk PCT1402-01:mA:fbk\n";
+		ts << "#(2) Event-ID Absolute-Time-Stamp A1611I1:cont_interval SG16114I1001:choice\n";
+		ts << "# 2,1285706567,1,0\n";
+		for(int i = 0; i < rows; i++) {
+			double eV = 270.0 + 0.01*i;
+			ts << "1," << eV << "," << 1.5*i + sin(0.01*i) << "," << 0.5*i << "," << 1000.0 + i << "," << 20.0 + sin(0.1*i) << "," << eV + 0.001 << "," << 250.0 - 0.0001*i << "\n";
+		}
+
+		return filePath;
+	}
+
+	/// Writes a synthetic CDF file with \c rows points of 256-channel spectra (see fillStore()), and returns its path.
+	QString writeCDFFile(int rows) const
+	{
+		QString filePath = QDir::tempPath() + "/amBenchmarkCDF.cdf";
+		QFile::remove(filePath);
+
+		AMCDFDataStore store(filePath, false);
+		if(!store.isValid())
+			return QString();
+
+		fillStore(&store, rows, 256);
+		if(!store.flushToDisk())
+			return QString();
+
+		return filePath;
+	}
+};
+
+#endif // BENCHMARKDATAMAN_H
@@ -26,13 +26,69 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "dataman/SGM/SGM2004FileLoader.h"
 #include "util/AMErrorMonitor.h"
 #include "dataman/database/AMDbObjectSupport.h"
+#include "dataman/database/AMDbSearchIndex.h"
+#include "dataman/database/AMDbUpgrade.h"
+#include "dataman/database/AMDbMigration.h"
 #include "analysis/AM1DExpressionAB.h"
+#include "analysis/AM1DRunningAverageFilterAB.h"
+#include "analysis/SGM/SGM1DFastScanFilterAB.h"
+#include "analysis/AM1DIntegralAB.h"
+#include "analysis/AMRegionOfInterestAB.h"
+#include "analysis/AMRegionOfInterestEngine.h"
+#include "analysis/AMExternalScanDataCache.h"
+#include "analysis/AMExternalScanDataSourceAB.h"
+#include "util/AMSlidingWindow.h"
+#include "dataman/datasource/AMDataSourceThumbnailRenderer.h"
+#include <math.h>
 #include "dataman/datastore/AMInMemoryDataStore.h"
+#include "dataman/datastore/AMCompressedSpectrumDataStore.h"
+#include "analysis/AM3DBinningAB.h"
+#include "dataman/AMScanJournal.h"
+#include "acquaman/AMScanReplay.h"
+#include "acquaman/AMScanActionController.h"
+#include "acquaman/AMScanActionControllerScanAssembler.h"
+#include "acquaman/SGM/SGMXASScanActionControllerFileWriter.h"
+#include "actions3/AMActionRunner3.h"
+#include "actions3/AMActionLog3.h"
+#include "actions3/AMActionLogQueue3.h"
+#include "beamline/AMReplayDetector.h"
+#include "beamline/AMReplayControl.h"
+#include "analysis/AMThreadedAnalysisBlock.h"
 #include "dataman/AMSamplePlate.h"
 #include "util/AMOrderedSet.h"
 
 #include "util/AMTagReplacementParser.h"
 
+#include "beamline/AMDetector.h"
+#include "beamline/AMDetectorTriggerSource.h"
+#include "actions3/AMLoopAction3.h"
+#include "actions3/actions/AMControlMoveAction3.h"
+#include "actions3/actions/AMDetectorTriggerAction.h"
+#include "actions3/actions/AMDetectorReadAction.h"
+#include "actions3/actions/AMContinuousRegionActionInfo.h"
+#include "acquaman/AMContinuousMoveScanOptimizer.h"
+#include "acquaman/AMAcqScanSpectrumOutput.h"
+#include "acquaman/dacq3_3/OutputHandler/acqFactory.h"
+#include "util/AMBufferedTextWriter.h"
+#include "dataman/export/AMExporterBinary.h"
+#include "dataman/export/AMExporterOptionBinary.h"
+#include "dataman/export/AMExporterGeneralAscii.h"
+#include "dataman/export/AMExporterOptionGeneralAscii.h"
+#include "dataman/export/AMExportController.h"
+#include "dataman/AMFileLoaderInterface.h"
+#include "application/AMPluginsManager.h"
+#include "dataman/datasource/AMRawDataSource.h"
+#include "dataman/import/AMScanDatabaseImportController.h"
+#include "dataman/AMRun.h"
+#include "dataman/AMSample.h"
+#include "source/qjson/parser.h"
+#include <QDir>
+#include <QtConcurrentRun>
+#include <QThread>
+#include <QtEndian>
+#include <QBuffer>
+#include <QTextStream>
+
 /// This subclass of AMDbObject is used only for test purposes.
 class AMTestDbObject : public AMDbObject {
 
@@ -85,6 +141,609 @@ protected:
 
 };
 
+/// This AMDetector subclass is used only for test purposes. It never talks to hardware; it just reports whether it can buffer readings and which trigger source it shares.
+class AMTestBufferedDetector : public AMDetector {
+
+	Q_OBJECT
+
+public:
+	AMTestBufferedDetector(const QString &name, bool canContinuousAcquire, AMDetectorTriggerSource *triggerSource, QObject *parent = 0) : AMDetector(name, name, parent) {
+		canContinuousAcquire_ = canContinuousAcquire;
+		triggerSource_ = triggerSource;
+		value_ = 0;
+		acquisitionTime_ = -1;
+	}
+
+	/// Sets the readings returned by lastContinuousReading(), as if the trigger source had just finished a continuous acquisition.
+	void setBuffer(const QVector<double> &buffer) { buffer_ = buffer; }
+
+	virtual int size(int axisNumber) const { Q_UNUSED(axisNumber); return 0; }
+	virtual bool requiresPower() const { return false; }
+	virtual bool canCancel() const { return false; }
+	virtual bool canClear() const { return false; }
+	virtual bool canContinuousAcquire() const { return canContinuousAcquire_; }
+	virtual double acquisitionTime() const { return acquisitionTime_; }
+	virtual bool supportsSynchronizedDwell() const { return false; }
+	virtual QString synchronizedDwellKey() const { return QString(); }
+	virtual int lastContinuousSize() const { return canContinuousAcquire_ ? buffer_.count() : -1; }
+	virtual bool sharesDetectorTriggerSource() { return triggerSource_ != 0; }
+	virtual AMDetectorTriggerSource* detectorTriggerSource() { return triggerSource_; }
+	virtual AMDetectorDefinitions::ReadMethod readMethod() const { return AMDetectorDefinitions::RequestRead; }
+	virtual AMDetectorDefinitions::ReadMode readMode() const { return AMDetectorDefinitions::SingleRead; }
+	virtual AMNumber reading(const AMnDIndex& indexes) const { Q_UNUSED(indexes); return value_; }
+	virtual const double* data() const { return &value_; }
+	virtual AMDataSource* dataSource() const { return 0; }
+
+	// The base class versions look the detector up from the beamline, which doesn't exist here.
+	virtual AMAction3* createTriggerAction(AMDetectorDefinitions::ReadMode readMode) { return new AMDetectorTriggerAction(new AMDetectorTriggerActionInfo(toInfo(), readMode), this); }
+	virtual AMAction3* createReadAction() { return new AMDetectorReadAction(new AMDetectorReadActionInfo(toInfo()), this); }
+
+public slots:
+	virtual bool setReadMode(AMDetectorDefinitions::ReadMode readMode) { Q_UNUSED(readMode); return false; }
+	virtual bool setAcquisitionTime(double seconds) { acquisitionTime_ = seconds; emit acquisitionTimeChanged(seconds); return true; }
+
+protected:
+	virtual bool initializeImplementation() { return false; }
+	virtual bool acquireImplementation(AMDetectorDefinitions::ReadMode readMode) { Q_UNUSED(readMode); return false; }
+	virtual bool cleanupImplementation() { return false; }
+	virtual bool lastContinuousReadingImplementation(double *outputValues) const { memcpy(outputValues, buffer_.constData(), buffer_.count()*sizeof(double)); return true; }
+
+	bool canContinuousAcquire_;
+	AMDetectorTriggerSource *triggerSource_;
+	double value_;
+	double acquisitionTime_;
+	QVector<double> buffer_;
+};
+
+/// This AMDetector subclass is used only for test purposes. It holds a fixed 1D or 2D array in data(), and reads blocks of it with AMDetector::readingFromData().
+class AMTestArrayDetector : public AMDetector {
+
+	Q_OBJECT
+
+public:
+	AMTestArrayDetector(const QString &name, const AMnDIndex &size, QObject *parent = 0) : AMDetector(name, name, parent) {
+		size_ = size;
+		data_.resize(int(size.product()));
+		for(int i = 0; i < data_.size(); i++)
+			data_[i] = i*1.5 - 7;
+	}
+
+	virtual int rank() const { return size_.rank(); }
+	virtual AMnDIndex size() const { return size_; }
+	virtual int size(int axisNumber) const { return size_.at(axisNumber); }
+	virtual bool requiresPower() const { return false; }
+	virtual bool canCancel() const { return false; }
+	virtual bool canClear() const { return false; }
+	virtual bool canContinuousAcquire() const { return false; }
+	virtual double acquisitionTime() const { return -1; }
+	virtual bool supportsSynchronizedDwell() const { return false; }
+	virtual QString synchronizedDwellKey() const { return QString(); }
+	virtual AMDetectorDefinitions::ReadMethod readMethod() const { return AMDetectorDefinitions::RequestRead; }
+	virtual AMDetectorDefinitions::ReadMode readMode() const { return AMDetectorDefinitions::SingleRead; }
+	virtual AMNumber reading(const AMnDIndex& indexes) const { return data_.at(rank() == 1 ? indexes.i() : indexes.i()*size_.j()+indexes.j()); }
+	virtual bool reading1D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const { return readingFromData(startIndex, endIndex, outputValues); }
+	virtual bool reading2D(const AMnDIndex &startIndex, const AMnDIndex &endIndex, double *outputValues) const { return readingFromData(startIndex, endIndex, outputValues); }
+	virtual const double* data() const { return data_.constData(); }
+	virtual AMDataSource* dataSource() const { return 0; }
+
+public slots:
+	virtual bool setReadMode(AMDetectorDefinitions::ReadMode readMode) { Q_UNUSED(readMode); return false; }
+	virtual bool setAcquisitionTime(double seconds) { Q_UNUSED(seconds); return false; }
+
+protected:
+	virtual bool initializeImplementation() { return false; }
+	virtual bool acquireImplementation(AMDetectorDefinitions::ReadMode readMode) { Q_UNUSED(readMode); return false; }
+	virtual bool cleanupImplementation() { return false; }
+
+	AMnDIndex size_;
+	QVector<double> data_;
+};
+
+/// This thread is used only for test purposes.  It reports \c reportCount alerts with the same error code to AMErrorMon, as fast as it can.
+class AMTestErrorReporterThread : public QThread {
+
+public:
+	AMTestErrorReporterThread(int errorCode, int reportCount, QObject *parent = 0) : QThread(parent) {
+		errorCode_ = errorCode;
+		reportCount_ = reportCount;
+	}
+
+protected:
+	virtual void run() {
+		for(int i = 0; i < reportCount_; i++)
+			AMErrorMon::alert(0, errorCode_, QString("Test report %1 from a worker thread").arg(i));
+	}
+
+	int errorCode_;
+	int reportCount_;
+};
+
+/// This class is used only for test purposes.  It ingests AMAgnosticDataAPI messages into a data store the same way the action-based scan controllers do (see SGMXASScanActionController::event()), adding each measurement the first time it arrives.
+class AMTestReplayReceiver : public QObject {
+
+public:
+	AMTestReplayReceiver(QObject *parent = 0) : QObject(parent) {
+		store_.addScanAxis(AMAxisInfo("eV", 0, "Incident Energy", "eV"));
+		row_ = 0;
+		axisValue_ = 0;
+		isFinished_ = false;
+	}
+
+	AMDataStore* store() { return &store_; }
+	bool isFinished() const { return isFinished_; }
+
+protected:
+	virtual bool event(QEvent *e) {
+		if(e->type() != (QEvent::Type)AMAgnosticDataAPIDefinitions::MessageEvent)
+			return QObject::event(e);
+
+		AMAgnosticDataAPIMessage message = ((AMAgnositicDataEvent*)e)->message_;
+
+		switch(message.messageType()){
+
+		case AMAgnosticDataAPIDefinitions::ControlMoved:
+			if(message.value("ControlMovementType") == "Relative")
+				axisValue_ += message.value("ControlMovementValue").toDouble();
+			else
+				axisValue_ = message.value("ControlMovementValue").toDouble();
+			break;
+
+		case AMAgnosticDataAPIDefinitions::DataAvailable: {
+			if(store_.idOfMeasurement(message.uniqueID()) == -1){
+				QList<AMAxisInfo> axes;
+				QVariantList sizes = message.value("DetectorDimensionalitySize").toList();
+				QVariantList names = message.value("DetectorDimensionalityName").toList();
+				for(int mu = 0; mu < sizes.count(); mu++)
+					axes << AMAxisInfo(names.at(mu).toString(), sizes.at(mu).toInt());
+				store_.addMeasurement(AMMeasurementInfo(message.uniqueID(), message.uniqueID(), QString(), axes));
+			}
+
+			if(row_ >= store_.scanSize(0)){
+				store_.beginInsertRows(1, -1);
+				store_.setAxisValue(0, row_, axisValue_);
+			}
+
+			QVector<double> values;
+			foreach(QVariant value, message.value("DetectorData").toList())
+				values << value.toDouble();
+			store_.setValue(AMnDIndex(row_), store_.idOfMeasurement(message.uniqueID()), values.constData());
+			break;
+		}
+
+		case AMAgnosticDataAPIDefinitions::LoopIncremented:
+			store_.endInsertRows();
+			row_++;
+			break;
+
+		case AMAgnosticDataAPIDefinitions::AxisFinished:
+			isFinished_ = true;
+			break;
+
+		default:
+			break;
+		}
+
+		e->accept();
+		return true;
+	}
+
+	AMInMemoryDataStore store_;
+	long row_;
+	double axisValue_;
+	bool isFinished_;
+};
+
+/// Brute-force Savitzky-Golay smoothing of one point: fits a polynomial of order \c order to the 2*halfWidth+1 values in \c window by least squares (projecting onto the monomials, orthonormalized with Gram-Schmidt), and returns the fit at the center of the window.
+static double amTestPolynomialFitAtCenter(const double *window, int halfWidth, int order)
+{
+	int size = 2*halfWidth+1;
+	QList<QVector<double> > basis;
+	double fit = 0;
+
+	for(int k = 0; k <= order; k++) {
+
+		QVector<double> q(size);
+		for(int i = 0; i < size; i++)
+			q[i] = pow(double(i-halfWidth), k);
+
+		foreach(const QVector<double> &b, basis) {
+			double dot = 0;
+			for(int i = 0; i < size; i++)
+				dot += q.at(i)*b.at(i);
+			for(int i = 0; i < size; i++)
+				q[i] -= dot*b.at(i);
+		}
+
+		double norm = 0;
+		for(int i = 0; i < size; i++)
+			norm += q.at(i)*q.at(i);
+		norm = sqrt(norm);
+
+		double projection = 0;
+		for(int i = 0; i < size; i++) {
+			q[i] /= norm;
+			projection += q.at(i)*window[i];
+		}
+
+		fit += projection*q.at(halfWidth);
+		basis << q;
+	}
+
+	return fit;
+}
+
+/// The indexes that SGM1DFastScanFilterAB kept before it used AMSlidingWindow: a point-by-point walk along the axis, which drops the points where the monochromator stood still, and the first 3 after it starts moving (giving 2 of them back once it has moved 4 times in a row).
+static QList<int> amTestFastScanKeptIndexes(const QVector<double> &axisValues)
+{
+	QList<int> ignoreIndices;
+	ignoreIndices << 0;
+	int numMoving = 0;
+
+	for(int x = 1; x < axisValues.count(); x++) {
+		if(fabs(axisValues.at(x)-axisValues.at(x-1)) < 0.001) {
+			numMoving = 0;
+			ignoreIndices << x;
+		}
+		else if(numMoving >= 3) {
+			if(numMoving == 3) {
+				ignoreIndices.pop_back();
+				ignoreIndices.pop_back();
+			}
+			numMoving++;
+		}
+		else {
+			ignoreIndices << x;
+			numMoving++;
+		}
+	}
+
+	QList<int> kept;
+	for(int x = 0; x < axisValues.count(); x++)
+		if(!ignoreIndices.contains(x))
+			kept << x;
+
+	return kept;
+}
+
+/// Returns true if \c integral holds the trapezoid sums (as calculated by AM1DIntegralAB) of the first size(0) points of \c x and \c f.  Used to check results that were calculated from a snapshot of a growing input.
+static bool amTestIntegralMatchesPrefix(const AMDataSource *integral, const QVector<double> &x, const QVector<double> &f)
+{
+	int count = integral->size(0);
+	if(count < 2 || count > x.count())
+		return false;
+
+	QVector<double> values(count);
+	if(!integral->values(AMnDIndex(0), AMnDIndex(count-1), values.data()))
+		return false;
+
+	double sum = 0;
+	for(int i = 0; i < count; i++) {
+		if(i == count-1)
+			sum += 0.5*(x.at(i)-x.at(i-1))*(f.at(i)+f.at(i-1));
+		else
+			sum += 0.5*(x.at(i+1)-x.at(i))*(f.at(i+1)+f.at(i));
+
+		if(fabs(values.at(i) - sum) > 1e-9*qMax(1.0, fabs(sum)) || double(integral->axisValue(0, i)) != x.at(i))
+			return false;
+	}
+
+	return true;
+}
+
+/// Builds a step region the way AMScanActionControllerScanAssembler does, with the given \c detectors acquired at each point.
+static AMListAction3* amTestCreateStepRegion(AMControl *axisControl, double start, double step, int points, double dwellTime, const QList<AMDetector*> &detectors)
+{
+	AMListAction3 *regionList = new AMListAction3(new AMListActionInfo3("Region on Test", "Region on Test"), AMListAction3::Sequential);
+
+	AMControlInfo startSetpoint = axisControl->toInfo();
+	startSetpoint.setValue(start);
+	AMAction3 *regionStart = new AMControlMoveAction3(new AMControlMoveActionInfo3(startSetpoint), axisControl);
+	regionStart->setGenerateScanActionMessage(true);
+	regionList->addSubAction(regionStart);
+
+	AMListAction3 *dwellList = new AMListAction3(new AMListActionInfo3("Set All Detectors Dwell Times", "Set All Detectors Dwell Times"), AMListAction3::Parallel);
+	for(int x = 0; x < detectors.count(); x++)
+		dwellList->addSubAction(detectors.at(x)->createSetAcquisitionTimeAction(dwellTime));
+	regionList->addSubAction(dwellList);
+
+	AMLoopAction3 *axisLoop = new AMLoopAction3(new AMLoopActionInfo3(points, "Loop Test", "Loop Test"));
+	axisLoop->setGenerateScanActionMessage(true);
+	AMListAction3 *acquisitionList = new AMListAction3(new AMListActionInfo3("Acquire All Detectors", "Acquire All Detectors"), AMListAction3::Parallel);
+	for(int x = 0; x < detectors.count(); x++){
+		AMListAction3 *detectorList = new AMListAction3(new AMListActionInfo3("Acquire One Detector", "Acquire One Detector"), AMListAction3::Sequential);
+		detectorList->addSubAction(detectors.at(x)->createTriggerAction(AMDetectorDefinitions::SingleRead));
+		AMAction3 *readAction = detectors.at(x)->createReadAction();
+		readAction->setGenerateScanActionMessage(true);
+		detectorList->addSubAction(readAction);
+		acquisitionList->addSubAction(detectorList);
+	}
+	AMControlInfo stepSetpoint = axisControl->toInfo();
+	stepSetpoint.setValue(step);
+	AMControlMoveActionInfo3 *stepInfo = new AMControlMoveActionInfo3(stepSetpoint);
+	stepInfo->setIsRelativeMove(true);
+	stepInfo->setIsRelativeFromSetpoint(true);
+	axisLoop->addSubAction(acquisitionList);
+	AMAction3 *stepMove = new AMControlMoveAction3(stepInfo, axisControl);
+	stepMove->setGenerateScanActionMessage(true);
+	axisLoop->addSubAction(stepMove);
+	regionList->addSubAction(axisLoop);
+
+	return regionList;
+}
+
+/// This AMContinuousMoveScanOptimizer is used only for test purposes.  The simulated controls have no velocity to set, so the region is crossed with a plain absolute move.
+class AMTestContinuousMoveScanOptimizer : public AMContinuousMoveScanOptimizer {
+
+	Q_OBJECT
+
+public:
+	AMTestContinuousMoveScanOptimizer(AMAction3 *scanActionTree = 0, QObject *parent = 0) : AMContinuousMoveScanOptimizer(scanActionTree, parent) {}
+
+protected:
+	virtual AMAction3* createContinuousMoveAction(AMControl *axisControl, const AMContinuousRegionActionInfo *regionInfo) const {
+		AMControlInfo regionEndSetpoint = axisControl->toInfo();
+		regionEndSetpoint.setValue(regionInfo->regionEnd());
+		return new AMControlMoveAction3(new AMControlMoveActionInfo3(regionEndSetpoint), axisControl);
+	}
+};
+
+/// Returns the "ScanActions" message handler that the scan actions post to, registering one if the application hasn't.
+static AMAgnosticDataMessageQEventHandler* amTestScanActionsHandler()
+{
+	AMAgnosticDataMessageQEventHandler *handler = qobject_cast<AMAgnosticDataMessageQEventHandler*>(AMAgnosticDataAPISupport::handlerFromLookupKey("ScanActions"));
+	if(!handler){
+		handler = new AMAgnosticDataMessageQEventHandler();
+		AMAgnosticDataAPISupport::registerHandler("ScanActions", handler);
+	}
+
+	return handler;
+}
+
+/// This AMScanActionController is used only for test purposes.  It runs a one-axis step scan of \c axisControl over \c region, acquiring \c detectors at every point (normally the mocks of an AMScanReplayer).
+/*! The action tree is built by AMScanActionControllerScanAssembler and run by the scan action runner, and the messages are ingested into the scan's raw data and written to \c filePath (.dat, plus _spectra.dat for 1D detectors) the same way SGMXASScanActionController does, but without the SGM beamline.
+  */
+class AMTestStepScanActionController : public AMScanActionController {
+
+	Q_OBJECT
+
+public:
+	AMTestStepScanActionController(AMControl *axisControl, const QList<AMDetector*> &detectors, const AMScanAxisRegion &region, const QString &filePath, QObject *parent = 0) : AMScanActionController(0, parent) {
+		actionTree_ = 0;
+		insertionIndex_ = AMnDIndex(0);
+		currentAxisValue_ = 0;
+
+		scan_ = new AMXASScan();
+		scan_->rawData()->addScanAxis(AMAxisInfo(axisControl->name(), 0, axisControl->name(), axisControl->units()));
+
+		bool has1DDetectors = false;
+		AMScanActionControllerScanAssembler assembler;
+		for(int x = 0; x < detectors.count(); x++){
+			if(detectors.at(x)->rank() == 1)
+				has1DDetectors = true;
+			if(scan_->rawData()->addMeasurement(AMMeasurementInfo(*detectors.at(x))))
+				scan_->addRawDataSource(new AMRawDataSource(scan_->rawData(), scan_->rawData()->measurementCount()-1));
+			assembler.addDetector(detectors.at(x));
+		}
+
+		AMScanAxis *scanAxis = new AMScanAxis(AMScanAxis::StepAxis, region, this);
+		assembler.appendAxis(axisControl, scanAxis);
+		connect(&assembler, SIGNAL(actionTreeGenerated(AMAction3*)), this, SLOT(onActionTreeGenerated(AMAction3*)));
+		assembler.generateActionTree();
+
+		fileWriter_ = new SGMXASScanActionControllerFileWriter(filePath, has1DDetectors, this);
+	}
+
+	AMAction3* actionTree() const { return actionTree_; }
+
+protected slots:
+	void onActionTreeGenerated(AMAction3 *actionTree) { actionTree_ = actionTree; }
+	void onActionTreeFailed() { setFailed(); }
+
+protected:
+	virtual bool initializeImplementation() { setInitialized(); return true; }
+
+	virtual bool startImplementation() {
+		if(!actionTree_)
+			return false;
+
+		connect(actionTree_, SIGNAL(failed()), this, SLOT(onActionTreeFailed()));
+		AMActionRunner3::scanActionRunner()->addActionToQueue(actionTree_);
+		return AMScanActionController::startImplementation();
+	}
+
+	virtual void cancelImplementation() { setCancelled(); }
+
+	bool event(QEvent *e) {
+		if(e->type() != (QEvent::Type)AMAgnosticDataAPIDefinitions::MessageEvent)
+			return AMScanActionController::event(e);
+
+		AMAgnosticDataAPIMessage message = ((AMAgnositicDataEvent*)e)->message_;
+
+		switch(message.messageType()){
+		case AMAgnosticDataAPIDefinitions::AxisFinished:
+			scan_->rawData()->endInsertRows();
+			writeDataToFiles();
+			fileWriter_->finishWriting();
+			setFinished();
+			break;
+		case AMAgnosticDataAPIDefinitions::LoopIncremented:
+			scan_->rawData()->endInsertRows();
+			writeDataToFiles();
+			insertionIndex_[0] = insertionIndex_.i()+1;
+			break;
+		case AMAgnosticDataAPIDefinitions::DataAvailable: {
+			if(insertionIndex_.i() >= scan_->rawData()->scanSize(0)){
+				scan_->rawData()->beginInsertRows(insertionIndex_.i()-scan_->rawData()->scanSize(0)+1, -1);
+				scan_->rawData()->setAxisValue(0, insertionIndex_.i(), currentAxisValue_);
+			}
+
+			QVector<double> localDetectorData;
+			QVariantList detectorDataValues = message.value("DetectorData").toList();
+			for(int x = 0; x < detectorDataValues.count(); x++)
+				localDetectorData.append(detectorDataValues.at(x).toDouble());
+
+			scan_->rawData()->setValue(insertionIndex_, scan_->rawData()->idOfMeasurement(message.uniqueID()), localDetectorData.constData());
+			break;
+		}
+		case AMAgnosticDataAPIDefinitions::ControlMoved:
+			if(message.value("ControlMovementType") == "Absolute")
+				currentAxisValue_ = message.value("ControlMovementValue").toDouble();
+			else if(message.value("ControlMovementType") == "Relative")
+				currentAxisValue_ += message.value("ControlMovementValue").toDouble();
+			break;
+		default:
+			break;
+		}
+
+		e->accept();
+		return true;
+	}
+
+	/// Writes the row at insertionIndex_: the axis value and the 0D detectors on one line of the .dat file, and one line per 1D detector in the _spectra.dat file.
+	void writeDataToFiles() {
+		QString rank1String = QString("%1 ").arg(double(scan_->rawData()->axisValue(0, insertionIndex_.i())));
+		QString rank2String;
+		for(int x = 0; x < scan_->rawDataSourceCount(); x++){
+			AMRawDataSource *oneRawDataSource = scan_->rawDataSources()->at(x);
+			if(oneRawDataSource->rank() == 1)
+				rank1String.append(QString("%1 ").arg(double(oneRawDataSource->value(insertionIndex_))));
+			if(oneRawDataSource->rank() == 2){
+				QVector<double> outputValues(oneRawDataSource->size(1));
+				oneRawDataSource->values(AMnDIndex(insertionIndex_.i(), 0), AMnDIndex(insertionIndex_.i(), outputValues.count()-1), outputValues.data());
+				for(int y = 0; y < outputValues.count(); y++)
+					rank2String.append(QString("%1 ").arg(outputValues.at(y)));
+				rank2String.append("\n");
+			}
+		}
+		rank1String.append("\n");
+
+		fileWriter_->writeToFile(1, rank1String);
+		fileWriter_->writeToFile(2, rank2String);
+	}
+
+	AMAction3 *actionTree_;
+	SGMXASScanActionControllerFileWriter *fileWriter_;
+	AMnDIndex insertionIndex_;
+	double currentAxisValue_;
+};
+
+/// File loader for the "amTestExport" scans stored by the tests (ex: testAMExportControllerParallel()).  It fills in a 40 point energy axis, a "tey" measurement and a 5 channel "sdd" measurement, all made up from the number at the end of the scan's filePath().
+class AMTestExportFileLoader : public AMFileLoaderInterface {
+public:
+	virtual QStringList acceptedFileFormats() { return QStringList() << "amTestExport"; }
+	virtual bool accepts(AMScan *scan) { return scan->fileFormat() == "amTestExport"; }
+
+	virtual bool load(AMScan *scan, const QString &userDataFolder, AMErrorMon *errorMonitor) {
+		Q_UNUSED(userDataFolder)
+		Q_UNUSED(errorMonitor)
+
+		int k = scan->filePath().section('/', -1).toInt();
+		AMDataStore *store = scan->rawData();
+		store->clearAll();
+
+		if(!store->addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV"))
+				|| !store->addMeasurement(AMMeasurementInfo("tey", "TEY"))
+				|| !store->addMeasurement(AMMeasurementInfo("sdd", "SDD", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", 5, "Channel"))))
+			return false;
+
+		store->beginInsertRows(40, -1);
+		for(int i = 0; i < 40; i++) {
+			store->setAxisValue(0, i, 270.0 + 0.5*i);
+			store->setValue(AMnDIndex(i), 0, AMnDIndex(), k*100 + i*0.25);
+			for(int c = 0; c < 5; c++)
+				store->setValue(AMnDIndex(i), 1, AMnDIndex(c), k + i*c);
+		}
+		store->endInsertRows();
+
+		return true;
+	}
+};
+
+/// Factory for AMTestExportFileLoader, registered with AMPluginsManager::registerFileLoaderPlugin().
+class AMTestExportFileLoaderFactory : public AMFileLoaderFactory {
+public:
+	virtual QStringList acceptedFileFormats() { return QStringList() << "amTestExport"; }
+	virtual bool accepts(AMScan *scan) { return scan->fileFormat() == "amTestExport"; }
+	virtual AMFileLoaderInterface* createFileLoader() { return new AMTestExportFileLoader(); }
+};
+
+/// Registers an AMTestExportFileLoaderFactory with the plugins manager, so that "amTestExport" scans can be loaded out of the database.
+static void amTestRegisterExportFileLoader()
+{
+	static AMTestExportFileLoaderFactory factory;
+	if(!AMPluginsManager::s()->availableFileLoaderPlugins().contains("amTestExport"))
+		AMPluginsManager::s()->registerFileLoaderPlugin(&factory);
+}
+
+/// Exports \c scanUrls to \c folder with the General Ascii exporter, and returns the contents of the files written, by file name.  The export runs on the workers if \c parallel is true.  Returns an empty map if the export doesn't finish.
+static QMap<QString, QByteArray> amTestExportScans(const QList<QUrl> &scanUrls, const QString &folder, bool parallel)
+{
+	QMap<QString, QByteArray> files;
+
+	QDir dir(folder);
+	dir.mkpath(folder);
+	foreach(QString fileName, dir.entryList(QDir::Files))
+		dir.remove(fileName);
+
+	AMExportController *controller = new AMExportController(scanUrls);
+	controller->setDestinationFolderPath(folder);
+	controller->setParallelExportEnabled(parallel);
+	controller->setMaximumScansInFlight(3);
+	if(!controller->chooseExporter("AMExporterGeneralAscii")) {
+		delete controller;
+		return files;
+	}
+
+	AMExporterOptionGeneralAscii *option = qobject_cast<AMExporterOptionGeneralAscii*>(controller->exporter()->createDefaultOption());
+	option->setFileName("$name_$exportIndex.txt");
+	option->setIncludeAllDataSources(true);
+	controller->setOption(option);
+	controller->exporter()->setOverwriteOption(AMExporter::All);
+
+	// The controller deletes itself once it's finished.
+	QPointer<AMExportController> running(controller);
+	if(!controller->start()) {
+		delete controller;
+		return files;
+	}
+
+	QTime timer;
+	timer.start();
+	while(running && timer.elapsed() < 30000)
+		QTest::qWait(10);
+
+	if(running)
+		return files;
+
+	foreach(QString fileName, dir.entryList(QDir::Files)) {
+		QFile file(dir.absoluteFilePath(fileName));
+		if(file.open(QIODevice::ReadOnly))
+			files.insert(fileName, file.readAll());
+		dir.remove(fileName);
+	}
+
+	return files;
+}
+
+/// This AMAction3 subclass is used only for test purposes. It succeeds as soon as it is started, so it can be logged right away.
+class AMTestLogAction : public AMAction3 {
+
+	Q_OBJECT
+
+public:
+	AMTestLogAction(AMActionInfo3 *info, QObject *parent = 0) : AMAction3(info, parent) {}
+
+	virtual bool hasChildren() const { return false; }
+	virtual int numberOfChildren() const { return 0; }
+
+protected:
+	virtual void startImplementation() { setStarted(); setSucceeded(); }
+	virtual void pauseImplementation() { setPaused(); }
+	virtual void resumeImplementation() { setResumed(); }
+	virtual void cancelImplementation() { setCancelled(); }
+	virtual void skipImplementation(const QString &command) { Q_UNUSED(command); }
+};
+
 /// This class contains all of the unit tests for the dataman module.
 /*! Each private slot corresponds to one test (which can actually contain several individual unit tests.)  The initTestCase() function is run before any of the tests, and the cleanupTestCase is run after all of them finish.
   */
@@ -945,6 +1604,2203 @@ private slots:
 
 	}
 
+	/// Tests that AMContinuousMoveScanOptimizer rewrites a step region into a continuous region, that running the rewritten region records one row per point with the step loop's axis values, and that regions are left alone when a detector can't buffer.  Uses simulated detectors and controls only.
+	void testAMContinuousMoveScanOptimizer() {
+		const int points = 400;
+		AMReplayControl axisControl("testAxis", "mm");
+		AMDetectorTriggerSource triggerSource("testTriggerSource");
+		AMTestBufferedDetector bufferedDetector1("buffered1", true, &triggerSource);
+		AMTestBufferedDetector bufferedDetector2("buffered2", true, &triggerSource);
+		AMTestBufferedDetector singleDetector("single", false, 0);
+
+		QList<AMDetector*> bufferedDetectors;
+		bufferedDetectors << &bufferedDetector1 << &bufferedDetector2;
+
+		// Detectors that can all be read out from one buffered acquisition: the loop should be replaced.
+		AMListAction3 *scanTree = new AMListAction3(new AMListActionInfo3("Test Scan", "Test Scan"), AMListAction3::Sequential);
+		AMListAction3 *regionList = amTestCreateStepRegion(&axisControl, 270.0, 0.25, points, 0.5, bufferedDetectors);
+		scanTree->addSubAction(regionList);
+
+		// The lists are found by the types of their actions, not by their descriptions.
+		qobject_cast<AMLoopAction3*>(regionList->subActionAt(2))->subActionAt(0)->info()->setShortDescription("Renamed Acquisition");
+		regionList->subActionAt(1)->info()->setShortDescription("Renamed Dwell Times");
+
+		// The base class doesn't know how to synchronize a move with the detectors, so it leaves the region alone.
+		AMContinuousMoveScanOptimizer baseOptimizer(scanTree);
+		baseOptimizer.optimize();
+		QVERIFY(qobject_cast<AMLoopAction3*>(regionList->subActionAt(2)) != 0);
+
+		AMTestContinuousMoveScanOptimizer optimizer(scanTree);
+		optimizer.optimize();
+
+		QVERIFY(qobject_cast<AMLoopAction3*>(regionList->subActionAt(2)) == 0);
+		AMListAction3 *continuousRegion = qobject_cast<AMListAction3*>(regionList->subActionAt(2));
+		QVERIFY(continuousRegion != 0);
+		const AMContinuousRegionActionInfo *continuousInfo = qobject_cast<const AMContinuousRegionActionInfo*>(continuousRegion->info());
+		QVERIFY(continuousInfo != 0);
+		QCOMPARE(continuousInfo->pointCount(), points);
+		QCOMPARE(continuousInfo->regionTime(), 0.5);
+		QCOMPARE(continuousInfo->regionEnd(), 370.0);
+
+		// Run the rewritten tree.  The trigger source finishes its continuous acquisition as soon as it gets back to the event loop, with these buffers.
+		QVector<double> buffer1(points), buffer2(points);
+		for(int i = 0; i < points; i++){
+			buffer1[i] = 1000.0 + i;
+			buffer2[i] = -0.5*i;
+		}
+		bufferedDetector1.setBuffer(buffer1);
+		bufferedDetector2.setBuffer(buffer2);
+
+		QTimer triggerResponse;
+		triggerResponse.setSingleShot(true);
+		triggerResponse.setInterval(0);
+		connect(&triggerSource, SIGNAL(triggered(AMDetectorDefinitions::ReadMode)), &triggerResponse, SLOT(start()));
+		connect(&triggerResponse, SIGNAL(timeout()), &triggerSource, SLOT(setSucceeded()));
+
+		AMTestReplayReceiver receiver;
+		AMAgnosticDataMessageQEventHandler *handler = amTestScanActionsHandler();
+		handler->addReceiver(&receiver);
+
+		scanTree->start();
+		QTime timeout;
+		timeout.start();
+		while(!scanTree->inFinalState() && timeout.elapsed() < 5000)
+			QTest::qWait(10);
+		QCoreApplication::sendPostedEvents(&receiver, 0);
+		handler->removeReceiver(&receiver);
+
+		QCOMPARE(int(scanTree->state()), int(AMAction3::Succeeded));
+		QCOMPARE(axisControl.value(), 370.0);
+		QCOMPARE(triggerSource.continuousPointCount(), points);
+
+		AMDataStore *rows = receiver.store();
+		QCOMPARE(rows->scanSize(0), long(points));
+		QCOMPARE(rows->measurementCount(), 2);
+		QCOMPARE(rows->measurementAt(0).name, QString("buffered1"));
+		QCOMPARE(rows->measurementAt(1).name, QString("buffered2"));
+		for(int i = 0; i < points; i++){
+			QCOMPARE(double(rows->axisValue(0, i)), 270.0 + 0.25*i);
+			QCOMPARE(double(rows->value(AMnDIndex(i), 0, AMnDIndex())), buffer1.at(i));
+			QCOMPARE(double(rows->value(AMnDIndex(i), 1, AMnDIndex())), buffer2.at(i));
+		}
+
+		delete scanTree;
+
+		// A buffer that's shorter than the region fails the region, instead of recording partial rows.
+		scanTree = new AMListAction3(new AMListActionInfo3("Test Scan", "Test Scan"), AMListAction3::Sequential);
+		regionList = amTestCreateStepRegion(&axisControl, 270.0, 0.25, points, 0.5, bufferedDetectors);
+		scanTree->addSubAction(regionList);
+		optimizer.setScanActionTree(scanTree);
+		optimizer.optimize();
+		bufferedDetector2.setBuffer(buffer2.mid(0, points-1));
+
+		scanTree->start();
+		timeout.start();
+		while(!scanTree->inFinalState() && timeout.elapsed() < 5000)
+			QTest::qWait(10);
+		QCOMPARE(int(scanTree->state()), int(AMAction3::Failed));
+
+		delete scanTree;
+
+		// One detector that can't buffer: nothing should change.
+		QList<AMDetector*> mixedDetectors;
+		mixedDetectors << &bufferedDetector1 << &singleDetector;
+		scanTree = new AMListAction3(new AMListActionInfo3("Test Scan", "Test Scan"), AMListAction3::Sequential);
+		regionList = amTestCreateStepRegion(&axisControl, 270.0, 0.25, points, 0.5, mixedDetectors);
+		scanTree->addSubAction(regionList);
+
+		optimizer.setScanActionTree(scanTree);
+		optimizer.optimize();
+
+		QVERIFY(qobject_cast<AMLoopAction3*>(regionList->subActionAt(2)) != 0);
+		QCOMPARE(AMContinuousMoveScanOptimizer::regionAxisValues(regionList).count(), points);
+
+		delete scanTree;
+	}
+
+
+	/// Tests that AMBufferedTextWriter produces exactly the same text as QTextStream and AMNumber::toString(), which the exporters used before.
+	void testAMBufferedTextWriter() {
+		QList<double> doubles;
+		doubles << 0.0 << 1.0 << -1.5 << 3.14159265358979 << 1234567.0 << 123456.0 << 1e-5 << 0.0001 << -2.5e-12 << 6.02214e23 << 1e100 << 270.25 << -1.0;
+		QList<int> integers;
+		integers << 0 << 1 << -1 << 42 << 2147483647 << (-2147483647-1);
+
+		QBuffer expectedBuffer;
+		expectedBuffer.open(QIODevice::WriteOnly);
+		QBuffer actualBuffer;
+		actualBuffer.open(QIODevice::WriteOnly);
+
+		{
+			QTextStream expected(&expectedBuffer);
+			AMBufferedTextWriter actual(&actualBuffer, 16);	// tiny buffer, to exercise the flushing
+
+			foreach(double value, doubles) {
+				expected << value << "\t" << AMNumber(value).toString() << "\n";
+				actual << value << "\t" << AMNumber(value) << '\n';
+			}
+
+			foreach(int value, integers) {
+				expected << value << "\t" << AMNumber(value).toString() << "\n";
+				actual << value << "\t" << AMNumber(value) << '\n';
+			}
+
+			expected << AMNumber(AMNumber::InvalidError).toString() << QString("eV");
+			actual << AMNumber(AMNumber::InvalidError) << QString("eV");
+		}
+
+		QCOMPARE(actualBuffer.data(), expectedBuffer.data());
+	}
+
+
+	/// Tests that AMExporterGeneralAscii still writes points that were never acquired as "[X]", in both the main table and the separate sections, now that they are read in blocks with values().
+	void testAMExporterGeneralAsciiInvalidValues() {
+		AMScan *scan = new AMScan();
+		scan->setName("asciiExportTest");
+
+		AMDataStore *store = scan->rawData();
+		QVERIFY(store->addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("tey", "TEY")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("sdd", "SDD", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", 5, "Channel"))));
+
+		// Row 1 of tey and channel 2 of the row 1 spectrum are never written.
+		QVERIFY(store->beginInsertRows(3, -1));
+		for(int i = 0; i < 3; i++) {
+			QVERIFY(store->setAxisValue(0, i, 270.0 + 0.5*i));
+			if(i != 1)
+				QVERIFY(store->setValue(AMnDIndex(i), 0, AMnDIndex(), 1.5*i));
+			for(int c = 0; c < 5; c++)
+				if(i != 1 || c != 2)
+					QVERIFY(store->setValue(AMnDIndex(i), 1, AMnDIndex(c), 10*i + c));
+		}
+		store->endInsertRows();
+
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 0)));
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 1)));
+
+		AMExporterGeneralAscii exporter;
+		AMExporterOptionGeneralAscii *option = qobject_cast<AMExporterOptionGeneralAscii*>(exporter.createDefaultOption());
+		QVERIFY(option);
+		option->setFileName("amAsciiExportTest.txt");
+		exporter.setOverwriteOption(AMExporter::All);
+
+		QVERIFY(exporter.isValidFor(scan, option));
+		QString fileName = exporter.exportScan(scan, QDir::tempPath(), option);
+		QVERIFY(!fileName.isNull());
+
+		QFile file(fileName);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		QByteArray contents = file.readAll();
+		file.close();
+		QFile::remove(fileName);
+
+		QCOMPARE(contents.count("[X]"), 2);
+		QVERIFY(contents.contains("1.5"));
+		QVERIFY(contents.contains("24"));
+
+		delete option;
+		scan->release();
+	}
+
+
+	/// Tests that AMExporterBinary writes a file that can be read back: the preamble, the JSON header, and a 1D and a 2D (spectrum) data source with their axes.
+	void testAMExporterBinary() {
+		AMScan *scan = new AMScan();
+		scan->setName("binaryExportTest");
+		scan->setNumber(7);
+
+		AMDataStore *store = scan->rawData();
+		QVERIFY(store->addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("tey", "TEY")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("sdd", "SDD", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", 5, "Channel"))));
+
+		QVERIFY(store->beginInsertRows(3, -1));
+		for(int i = 0; i < 3; i++) {
+			QVERIFY(store->setAxisValue(0, i, 270.0 + 0.5*i));
+			QVERIFY(store->setValue(AMnDIndex(i), 0, AMnDIndex(), 1.5*i));
+			for(int c = 0; c < 5; c++)
+				QVERIFY(store->setValue(AMnDIndex(i), 1, AMnDIndex(c), 10*i + c));
+		}
+		store->endInsertRows();
+
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 0)));
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 1)));
+
+		AMExporterBinary exporter;
+		AMExporterOptionBinary *option = qobject_cast<AMExporterOptionBinary*>(exporter.createDefaultOption());
+		QVERIFY(option);
+		option->setFileName("amBinaryExportTest.amb");
+		exporter.setOverwriteOption(AMExporter::All);
+
+		QVERIFY(exporter.isValidFor(scan, option));
+		QString fileName = exporter.exportScan(scan, QDir::tempPath(), option);
+		QVERIFY(!fileName.isNull());
+
+		QFile file(fileName);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		QByteArray contents = file.readAll();
+		file.close();
+		QFile::remove(fileName);
+
+		QVERIFY(contents.startsWith("AMBINARY"));
+		QCOMPARE(qFromLittleEndian<quint32>((const uchar *)contents.constData() + 8), AMExporterBinary::formatVersion());
+		int headerLength = int(qFromLittleEndian<quint32>((const uchar *)contents.constData() + 12));
+		int dataStart = (16 + headerLength + 7) & ~7;
+
+		bool ok = false;
+		QJson::Parser parser;
+		QVariantMap header = parser.parse(contents.mid(16, headerLength), &ok).toMap();
+		QVERIFY(ok);
+		QCOMPARE(header.value("scan").toMap().value("number").toInt(), 7);
+
+		QVariantList dataSources = header.value("dataSources").toList();
+		QCOMPARE(dataSources.count(), 2);
+
+		QVariantMap tey = dataSources.at(0).toMap();
+		QCOMPARE(tey.value("name").toString(), QString("tey"));
+		QCOMPARE(tey.value("dataType").toString(), QString("float64"));
+		QVariantMap energyAxis = tey.value("axes").toList().at(0).toMap();
+		QCOMPARE(energyAxis.value("units").toString(), QString("eV"));
+
+		QVariantMap sdd = dataSources.at(1).toMap();
+		QCOMPARE(sdd.value("rank").toInt(), 2);
+		QCOMPARE(sdd.value("size").toList().at(1).toInt(), 5);
+		QCOMPARE(sdd.value("byteCount").toLongLong(), qlonglong(3*5*8));
+
+		for(int i = 0; i < 3; i++) {
+			const char *axisValue = contents.constData() + dataStart + energyAxis.value("offset").toLongLong() + i*8;
+			const char *teyValue = contents.constData() + dataStart + tey.value("offset").toLongLong() + i*8;
+			double value;
+			memcpy(&value, axisValue, 8);
+			QCOMPARE(value, 270.0 + 0.5*i);
+			memcpy(&value, teyValue, 8);
+			QCOMPARE(value, 1.5*i);
+
+			for(int c = 0; c < 5; c++) {
+				memcpy(&value, contents.constData() + dataStart + sdd.value("offset").toLongLong() + (i*5 + c)*8, 8);
+				QCOMPARE(value, double(10*i + c));
+			}
+		}
+
+		delete option;
+		scan->release();
+	}
+
+
+	/// Tests the AMSlidingWindow kernels against a direct computation of every window, for several window sizes.
+	void testAMSlidingWindow() {
+		const int count = 1000;
+		QVector<double> input(count);
+		qsrand(27);
+		for(int i = 0; i < count; i++)
+			input[i] = double(qrand() % 20000)/100.0 - 100.0;
+
+		QVector<double> mean(count), minimum(count), maximum(count);
+		QList<int> halfWidths;
+		halfWidths << 0 << 1 << 2 << 7 << 50 << 499 << 2000;
+
+		foreach(int halfWidth, halfWidths) {
+			AMSlidingWindow::runningMean(input.constData(), count, halfWidth, mean.data());
+			AMSlidingWindow::runningMinimum(input.constData(), count, halfWidth, minimum.data());
+			AMSlidingWindow::runningMaximum(input.constData(), count, halfWidth, maximum.data());
+
+			for(int i = 0; i < count; i++) {
+				double sum = 0, windowMinimum = input.at(i), windowMaximum = input.at(i);
+				int first = qMax(0, i-halfWidth), last = qMin(count-1, i+halfWidth);
+				for(int j = first; j <= last; j++) {
+					sum += input.at(j);
+					windowMinimum = qMin(windowMinimum, input.at(j));
+					windowMaximum = qMax(windowMaximum, input.at(j));
+				}
+
+				QVERIFY(fabs(mean.at(i) - sum/double(last-first+1)) < 1e-9);
+				QCOMPARE(minimum.at(i), windowMinimum);
+				QCOMPARE(maximum.at(i), windowMaximum);
+			}
+		}
+
+		// Savitzky-Golay: the classic 5-point quadratic coefficients, and a quadratic passes through unchanged.
+		QVector<double> coefficients = AMSlidingWindow::savitzkyGolayCoefficients(2, 2);
+		QCOMPARE(coefficients.size(), 5);
+		double expected[5] = { -3.0/35.0, 12.0/35.0, 17.0/35.0, 12.0/35.0, -3.0/35.0 };
+		for(int i = 0; i < 5; i++)
+			QVERIFY(fabs(coefficients.at(i) - expected[i]) < 1e-12);
+
+		QVector<double> quadratic(count), smoothed(count);
+		for(int i = 0; i < count; i++)
+			quadratic[i] = 0.5*i*i - 3.0*i + 2.0;
+		coefficients = AMSlidingWindow::savitzkyGolayCoefficients(10, 3);
+		AMSlidingWindow::savitzkyGolay(quadratic.constData(), count, coefficients, smoothed.data());
+		for(int i = 0; i < count; i++)
+			QVERIFY(fabs(smoothed.at(i) - quadratic.at(i)) < 1e-6*qMax(1.0, fabs(quadratic.at(i))));
+
+		QVERIFY(AMSlidingWindow::savitzkyGolayCoefficients(2, 5).isEmpty());
+
+		// Every smoothed point is the center of a least-squares fit to its own window; the ends are copied.
+		QList<int> sgHalfWidths;
+		sgHalfWidths << 1 << 3 << 10;
+		foreach(int halfWidth, sgHalfWidths) {
+			for(int order = 0; order <= qMin(4, 2*halfWidth); order++) {
+
+				coefficients = AMSlidingWindow::savitzkyGolayCoefficients(halfWidth, order);
+				QCOMPARE(coefficients.size(), 2*halfWidth+1);
+				AMSlidingWindow::savitzkyGolay(input.constData(), count, coefficients, smoothed.data());
+
+				for(int i = 0; i < count; i++) {
+					if(i < halfWidth || i >= count-halfWidth)
+						QCOMPARE(smoothed.at(i), input.at(i));
+					else {
+						double expectedValue = amTestPolynomialFitAtCenter(input.constData()+i-halfWidth, halfWidth, order);
+						QVERIFY(fabs(smoothed.at(i) - expectedValue) < 1e-9*qMax(1.0, fabs(expectedValue)));
+					}
+				}
+			}
+		}
+	}
+
+	/// Tests that SGM1DFastScanFilterAB keeps exactly the points that its original point-by-point walk kept, for an axis that starts and stops many times.
+	void testSGM1DFastScanFilterAB() {
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("energy", 0, "Energy")));
+		QVERIFY(store.addMeasurement(AMMeasurementInfo("tey", "TEY")));
+
+		AMRawDataSource *rawSource = new AMRawDataSource(&store, 0);
+		SGM1DFastScanFilterAB filter("filtered");
+		QVERIFY(filter.setInputDataSources(QList<AMDataSource*>() << rawSource));
+
+		// Runs of 1 to 6 moving or standing points, in random order.  Runs shorter than 4 moves are dropped completely.
+		qsrand(31);
+		QVector<double> axisValues;
+		double energy = 280;
+		bool moving = false;
+		while(axisValues.count() < 2000) {
+			int runLength = qrand() % 6 + 1;
+			for(int i = 0; i < runLength; i++) {
+				if(moving)
+					energy += 0.01 + (qrand() % 100)*0.001;
+				axisValues << energy;
+			}
+			moving = !moving;
+		}
 
+		QVERIFY(store.beginInsertRows(axisValues.count(), -1));
+		for(int x = 0; x < axisValues.count(); x++) {
+			store.setAxisValue(0, x, axisValues.at(x));
+			store.setValue(AMnDIndex(x), 0, AMnDIndex(), 1000.0 + x);
+		}
+		store.endInsertRows();
+
+		QList<int> expected = amTestFastScanKeptIndexes(axisValues);
+		QVERIFY(!expected.isEmpty());
+		QVERIFY(expected.count() < axisValues.count());
+		QCOMPARE(filter.size(0), expected.count());
+
+		for(int i = 0; i < expected.count(); i++) {
+			QCOMPARE(double(filter.axisValue(0, i)), axisValues.at(expected.at(i)));
+			QCOMPARE(double(filter.value(AMnDIndex(i))), 1000.0 + expected.at(i));
+		}
+
+		filter.setInputDataSources(QList<AMDataSource*>());
+		delete rawSource;
+	}
+
+	/// Tests that AM1DRunningAverageFilterAB::values() gives the same results as value() for every point, for whole and partial ranges.
+	void testAM1DRunningAverageFilterAB() {
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("x", 0, "x axis")));
+		QVERIFY(store.addMeasurement(AMMeasurementInfo("signal", "Signal")));
+
+		const int count = 500;
+		QVERIFY(store.beginInsertRows(count, -1));
+		for(int i = 0; i < count; i++) {
+			store.setAxisValue(0, i, i);
+			store.setValue(AMnDIndex(i), 0, AMnDIndex(), sin(i/10.0)*100 + i%7);
+		}
+		store.endInsertRows();
+
+		AMRawDataSource *rawSource = new AMRawDataSource(&store, 0);
+
+		QList<int> filterSizes;
+		filterSizes << 1 << 3 << 4 << 25 << 1001;
+
+		foreach(int filterSize, filterSizes) {
+			AM1DRunningAverageFilterAB filter(filterSize, "average");
+			filter.setInputDataSources(QList<AMDataSource*>() << rawSource);
+			QVERIFY(filter.isValid());
+
+			QVector<double> all(count);
+			QVERIFY(filter.values(AMnDIndex(0), AMnDIndex(count-1), all.data()));
+
+			QVector<double> part(101);
+			QVERIFY(filter.values(AMnDIndex(200), AMnDIndex(300), part.data()));
+
+			for(int i = 0; i < count; i++) {
+				double single = filter.value(AMnDIndex(i));
+				QVERIFY(fabs(all.at(i) - single) < 1e-9);
+				if(i >= 200 && i <= 300)
+					QVERIFY(fabs(part.at(i-200) - single) < 1e-9);
+			}
+
+			filter.setInputDataSources(QList<AMDataSource*>());
+		}
+
+		delete rawSource;
+	}
+
+
+	void testAMDataSourceThumbnailRenderer() {
+		// min/max decimation against a brute-force reduction of each column.
+		const int count = 100000;
+		const int columns = 232;
+		QVector<double> x(count), y(count);
+		qsrand(32);
+		for(int i = 0; i < count; i++) {
+			x[i] = 100.0 + 0.01*i;
+			y[i] = sin(0.001*i) + double(qrand() % 1000)/10000.0;
+		}
+
+		QVector<double> minimums(columns), maximums(columns), firsts(columns), lasts(columns);
+		QVector<int> pointCounts = AMDataSourceThumbnailRenderer::minMaxDecimate(x.constData(), y.constData(), count, x.first(), x.last(), columns, minimums.data(), maximums.data(), firsts.data(), lasts.data());
+		QCOMPARE(pointCounts.size(), columns);
+
+		int totalPoints = 0;
+		double columnsPerUnit = double(columns)/(x.last()-x.first());
+		for(int column = 0; column < columns; column++) {
+			QVERIFY(pointCounts.at(column) > 0);
+			totalPoints += pointCounts.at(column);
+
+			bool found = false;
+			double columnMinimum = 0, columnMaximum = 0, columnFirst = 0, columnLast = 0;
+			for(int i = 0; i < count; i++) {
+				if(qMin(int((x.at(i)-x.first())*columnsPerUnit), columns-1) != column)
+					continue;
+				if(!found) {
+					columnMinimum = columnMaximum = columnFirst = y.at(i);
+					found = true;
+				}
+				columnMinimum = qMin(columnMinimum, y.at(i));
+				columnMaximum = qMax(columnMaximum, y.at(i));
+				columnLast = y.at(i);
+			}
+
+			QVERIFY(found);
+			QCOMPARE(minimums.at(column), columnMinimum);
+			QCOMPARE(maximums.at(column), columnMaximum);
+			QCOMPARE(firsts.at(column), columnFirst);
+			QCOMPARE(lasts.at(column), columnLast);
+		}
+		QCOMPARE(totalPoints, count);
+
+		// Rendering a 100k point line touches every plot column.
+		QImage line = AMDataSourceThumbnailRenderer::render1D(x.constData(), y.constData(), count, QSize(240, 180), Qt::black);
+		QCOMPARE(line.size(), QSize(240, 180));
+		int darkColumns = 0;
+		for(int column = 0; column < line.width(); column++) {
+			for(int row = 0; row < line.height(); row++) {
+				if(qGray(line.pixel(column, row)) < 64) {
+					darkColumns++;
+					break;
+				}
+			}
+		}
+		QVERIFY(darkColumns >= columns-2);
+
+		// Points at the default value are left as background, and the colour range comes from the rest.
+		QVector<double> map(20*10, -1);
+		for(int i = 0; i < 10; i++)
+			for(int j = 0; j < 10; j++)
+				map[i*10+j] = i;
+		QImage image = AMDataSourceThumbnailRenderer::render2D(map.constData(), 20, 10, QSize(240, 180), true, -1);
+		QCOMPARE(image.size(), QSize(240, 180));
+		QCOMPARE(image.pixel(10, 90), AMDataSourceThumbnailRenderer::jetColor(0));
+		QCOMPARE(image.pixel(110, 90), AMDataSourceThumbnailRenderer::jetColor(1));
+		QCOMPARE(image.pixel(200, 90), qRgb(255, 255, 255));
+
+		QCOMPARE(AMDataSourceThumbnailRenderer::jetColor(0), qRgb(0, 0, 128));
+		QCOMPARE(AMDataSourceThumbnailRenderer::jetColor(1), qRgb(128, 0, 0));
+
+		// A scan's thumbnails are drawn in a worker thread from snapshots taken when the generator is created: they match the ones drawn directly, even if the scan changes in the meantime.
+		AMScan *scan = new AMScan();
+		AMDataStore *store = scan->rawData();
+		QVERIFY(store->addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("i0", "I0")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("tey", "TEY")));
+		QVERIFY(store->beginInsertRows(500, -1));
+		for(int i = 0; i < 500; i++) {
+			QVERIFY(store->setAxisValue(0, i, 270.0 + 0.1*i));
+			QVERIFY(store->setValue(AMnDIndex(i), 0, AMnDIndex(), sin(0.05*i)));
+			QVERIFY(store->setValue(AMnDIndex(i), 1, AMnDIndex(), 0.01*i*i));
+		}
+		store->endInsertRows();
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 0)));
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 1)));
+		QVERIFY(scan->shouldGenerateThumbnailsInSeparateThread());
+		QCOMPARE(scan->thumbnailCount(), 2);
+
+		QList<AMDbThumbnail> direct;
+		for(int i = 0; i < scan->thumbnailCount(); i++)
+			direct << scan->thumbnail(i);
+
+		AMDbThumbnailGenerator *generator = scan->createThumbnailGenerator();
+		QVERIFY(generator);
+		QVERIFY(store->setValue(AMnDIndex(250), 1, AMnDIndex(), 1e6));
+
+		QList<AMDbThumbnail> threaded = QtConcurrent::run(generator, &AMDbThumbnailGenerator::generateThumbnails).result();
+		delete generator;
+
+		QCOMPARE(threaded.count(), direct.count());
+		for(int i = 0; i < direct.count(); i++) {
+			QCOMPARE(threaded.at(i).title, direct.at(i).title);
+			QCOMPARE(threaded.at(i).subtitle, direct.at(i).subtitle);
+			QCOMPARE(int(threaded.at(i).type), int(AMDbThumbnail::PNGType));
+			QVERIFY(threaded.at(i).thumbnail == direct.at(i).thumbnail);
+		}
+		QVERIFY(scan->thumbnail(1).thumbnail != direct.at(1).thumbnail);
+
+		scan->release();
+	}
+
+
+	void testAMDbSearchIndex() {
+		QCOMPARE(AMDatabase::searchExpression("  Carbon60, alpha-'test'  "), QString("\"Carbon60*\" \"alpha*\" \"test*\""));
+		QVERIFY(AMDatabase::searchExpression(" -- ").isEmpty());
+
+		AMDatabase* db = AMDatabase::database("user");
+		QVERIFY(db->ensureTable("SearchTestSample_table", QStringList() << "name", QStringList() << "TEXT"));
+		QVERIFY(db->ensureTable("SearchTest_table", QStringList() << "name" << "notes" << "sampleId", QStringList() << "TEXT" << "TEXT" << "INTEGER"));
+		db->deleteRows("SearchTestSample_table", "1");
+		db->deleteRows("SearchTest_table", "1");
+
+		int sampleId = db->insertOrUpdate(0, "SearchTestSample_table", QStringList() << "name", QVariantList() << "Graphene oxide");
+		int carbonId = db->insertOrUpdate(0, "SearchTest_table", QStringList() << "name" << "notes" << "sampleId", QVariantList() << "Carbon K edge" << "carbon carbon" << sampleId);
+		int nitrogenId = db->insertOrUpdate(0, "SearchTest_table", QStringList() << "name" << "notes" << "sampleId", QVariantList() << "Nitrogen K edge" << "carbon contamination" << 0);
+
+		AMDbSearchIndex* index = AMDbSearchIndex::createSearchIndex(db, "SearchTest_table", QStringList() << "name" << "notes");
+		QVERIFY(index);
+		QVERIFY(!AMDbSearchIndex::createSearchIndex(db, "SearchTest_table", QStringList() << "name"));
+		QCOMPARE(AMDbSearchIndex::searchIndex(db, "SearchTest_table"), index);
+		index->addRelatedColumn("sampleId", "SearchTestSample_table", "name");
+
+		if(!index->initialize())
+			QSKIP("This SQLite library does not support full-text search.", SkipAll);
+
+		// Existing rows are indexed when the index is created, and more hits in a row rank higher.
+		QCOMPARE(index->search("carb"), QList<int>() << carbonId << nitrogenId);
+		QCOMPARE(index->search("edge nitro"), QList<int>() << nitrogenId);
+		QCOMPARE(index->search("graphene"), QList<int>() << carbonId);
+		QCOMPARE(index->search("carbon", 1), QList<int>() << carbonId);
+		QVERIFY(index->search("oxygen").isEmpty());
+
+		// Changes through the AMDatabase API are picked up from its signals.
+		int oxygenId = db->insertOrUpdate(0, "SearchTest_table", QStringList() << "name" << "notes" << "sampleId", QVariantList() << "Oxygen K edge" << QString() << sampleId);
+		db->update(sampleId, "SearchTestSample_table", "name", "Graphite");
+		db->deleteRow(nitrogenId, "SearchTest_table");
+		QCoreApplication::processEvents();
+
+		QCOMPARE(index->search("oxygen"), QList<int>() << oxygenId);
+		QCOMPARE(index->search("graphite").toSet(), QSet<int>() << carbonId << oxygenId);
+		QVERIFY(index->search("graphene").isEmpty());
+		QCOMPARE(index->search("contamination"), QList<int>());
+
+		// Raw SQL doesn't emit signals; rebuild() catches up.
+		QSqlQuery q = db->query();
+		q.prepare("UPDATE SearchTest_table SET notes = 'sulfur' WHERE id = ?");
+		q.bindValue(0, oxygenId);
+		QVERIFY(AMDatabase::execQuery(q));
+		q.finish();
+		QVERIFY(index->search("sulfur").isEmpty());
+		QVERIFY(index->rebuild());
+		QCOMPARE(index->search("sulfur"), QList<int>() << oxygenId);
+
+		QString where = index->whereClause("sulf");
+		QCOMPARE(db->objectsWhere("SearchTest_table", where), QList<int>() << oxygenId);
+		QCOMPARE(db->objectsWhere("SearchTest_table", QString("(name LIKE 'Carbon%') AND ") + where), QList<int>());
+	}
+
+
+	void testAMDbObjectSupportSchemaFingerprints() {
+		QString scanFingerprint = AMDbObjectSupport::schemaFingerprint(AMDbObjectInfo(&AMScan::staticMetaObject));
+		QCOMPARE(AMDbObjectSupport::schemaFingerprint(AMDbObjectInfo(&AMScan::staticMetaObject)), scanFingerprint);
+		QVERIFY(AMDbObjectSupport::schemaFingerprint(AMDbObjectInfo(&AMXASScan::staticMetaObject)) != scanFingerprint);
+
+		// Registering a database records the schema of every registered class, and clearing forgets them.
+		QString fileName = QDir::tempPath() + "/testAMDbObjectSupportSchemaFingerprints.db";
+		QFile::remove(fileName);
+		AMDatabase* db = AMDatabase::createDatabase("fingerprintTest", fileName);
+		QVERIFY(db);
+		QVERIFY(AMDbObjectSupport::s()->registerDatabase(db));
+
+		QList<int> scanRows = db->objectsMatching(AMDbObjectSupport::schemaFingerprintsTableName(), "className", "AMScan");
+		QCOMPARE(scanRows.count(), 1);
+		QCOMPARE(db->retrieve(scanRows.first(), AMDbObjectSupport::schemaFingerprintsTableName(), "fingerprint").toString(), scanFingerprint);
+
+		AMDbObjectSupport::clearSchemaFingerprints(db);
+		QVERIFY(db->objectsWhere(AMDbObjectSupport::schemaFingerprintsTableName()).isEmpty());
+
+		AMDatabase::deleteDatabase("fingerprintTest");
+		QFile::remove(fileName);
+	}
+
+	void testAMScanDatabaseImportControllerBulkCopy() {
+		QString sourceFolder = QDir::tempPath() + "/testAMScanDatabaseImportSource";
+		QString destinationFileName = QDir::tempPath() + "/testAMScanDatabaseImportDestination.db";
+		QDir().mkpath(sourceFolder);
+		QFile::remove(sourceFolder + "/" + AMUserSettings::userDatabaseFilename);
+		QFile::remove(destinationFileName);
+
+		AMDatabase* sourceDb = AMDatabase::createDatabase("importSourceTest", sourceFolder + "/" + AMUserSettings::userDatabaseFilename);
+		AMDatabase* destinationDb = AMDatabase::createDatabase("importDestinationTest", destinationFileName);
+		QVERIFY(sourceDb && destinationDb);
+		QVERIFY(AMDbObjectSupport::s()->registerDatabase(sourceDb));
+		QVERIFY(AMDbObjectSupport::s()->registerDatabase(destinationDb));
+
+		// One facility is in both databases (at different ids), and one is new.  The run refers to the new one.
+		AMFacility unrelatedFacility("REIXS", "Only in the destination");
+		AMFacility existingFacility("SGM", "In both");
+		QVERIFY(unrelatedFacility.storeToDb(destinationDb));
+		QVERIFY(existingFacility.storeToDb(destinationDb));
+
+		AMFacility sharedFacility("SGM", "In both");
+		AMFacility newFacility("VESPERS", "Only in the source");
+		QVERIFY(sharedFacility.storeToDb(sourceDb));
+		QVERIFY(newFacility.storeToDb(sourceDb));
+
+		AMRun run("Imported run", newFacility.id());
+		QVERIFY(run.storeToDb(sourceDb));
+
+		for(int i = 0; i < 50; i++) {
+			AMSample sample(QString("Imported sample %1").arg(i));
+			QVERIFY(sample.storeToDb(sourceDb));
+		}
+
+		QString facilityTable = AMDbObjectSupport::s()->tableNameForClass<AMFacility>();
+		QString sampleTable = AMDbObjectSupport::s()->tableNameForClass<AMSample>();
+
+		{
+			AMScanDatabaseImportController importer(destinationDb, QDir::tempPath() + "/testAMScanDatabaseImportDestinationData");
+			QVERIFY(importer.setSourceFolderAndLoadDatabase(sourceFolder));
+			importer.analyzeFacilitiesForDuplicates();
+			importer.analyzeRunsForDuplicates();
+			importer.analyzeExperimentsForDuplicates();
+			importer.analyzeSamplesForDuplicates();
+			QCOMPARE(importer.runIdMapping().value(run.id()), -1);
+
+			importer.startDatabaseOperations();
+			QCOMPARE(importer.state(), AMScanDatabaseImportController::Finished);
+
+			// The shared facility was merged, and the new one was added.
+			QCOMPARE(destinationDb->objectsWhere(facilityTable).count(), 3);
+			QList<int> newFacilityIds = destinationDb->objectsMatching(facilityTable, "name", "VESPERS");
+			QCOMPARE(newFacilityIds.count(), 1);
+
+			// The run's facility id was remapped.
+			AMRun importedRun;
+			QVERIFY(importedRun.loadFromDb(destinationDb, importer.runIdMapping().value(run.id())));
+			QCOMPARE(importedRun.name(), QString("Imported run"));
+			QCOMPARE(importedRun.facilityId(), newFacilityIds.first());
+
+			// Every sample was copied, and the mapping points at the right rows.
+			QCOMPARE(destinationDb->objectsWhere(sampleTable).count(), 50);
+			QMap<int, int> sampleIds = importer.sampleIdMapping();
+			QCOMPARE(sampleIds.count(), 50);
+			foreach(int sourceId, sampleIds.keys())
+				QCOMPARE(destinationDb->retrieve(sampleIds.value(sourceId), sampleTable, "name").toString(), sourceDb->retrieve(sourceId, sampleTable, "name").toString());
+		}
+
+		AMDatabase::deleteDatabase("importSourceTest");
+		AMDatabase::deleteDatabase("importDestinationTest");
+		QFile::remove(sourceFolder + "/" + AMUserSettings::userDatabaseFilename);
+		QFile::remove(destinationFileName);
+	}
+
+
+	void testAMExternalScanDataCache() {
+		AMScan *scan = new AMScan();
+		scan->setName("externalScanDataCacheTest");
+
+		AMDataStore *store = scan->rawData();
+		QVERIFY(store->addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV")));
+		QVERIFY(store->addMeasurement(AMMeasurementInfo("i0", "I0")));
+		QVERIFY(store->beginInsertRows(100, -1));
+		for(int i = 0; i < 100; i++) {
+			QVERIFY(store->setAxisValue(0, i, 270.0 + 0.1*i));
+			QVERIFY(store->setValue(AMnDIndex(i), 0, AMnDIndex(), 2.0*i));
+		}
+		store->endInsertRows();
+		QVERIFY(scan->addRawDataSource(new AMRawDataSource(store, 0)));
+
+		QString dbFileName = QDir::tempPath() + "/testAMExternalScanDataCache.db";
+		QFile::remove(dbFileName);
+		AMDatabase* db = AMDatabase::createDatabase("externalScanDataCacheTest", dbFileName);
+		QVERIFY(db);
+		QVERIFY(AMDbObjectSupport::s()->registerDatabase(db));
+		QVERIFY(scan->storeToDb(db));
+
+		AMExternalScanDataCache* cache = AMExternalScanDataCache::cache();
+		cache->clear();
+		cache->resetCounters();
+
+		AMExternalScanDataCache::Handle copy(new AMExternalScanData(scan->dataSourceAt(0)));
+		QCOMPARE(copy->values.size(), 100);
+		QCOMPARE(double(copy->values.at(50)), 100.0);
+		QCOMPARE(copy->axisValues.count(), 1);
+		QCOMPARE(double(copy->axisValues.at(0).at(10)), 271.0);
+
+		// Every block asking for the same data source shares the one copy.
+		QVERIFY(cache->insert(db, scan->id(), "i0", copy) == copy);
+		for(int i = 0; i < 49; i++)
+			QVERIFY(cache->data(db, scan->id(), "i0") == copy);
+		QCOMPARE(cache->hitCount(), 49);
+		QCOMPARE(cache->missCount(), 0);
+		QCOMPARE(cache->hitRate(), 1.0);
+		QCOMPARE(cache->entryCount(), 1);
+		QCOMPARE(cache->totalBytes(), copy->byteSize());
+
+		// Copies that are in use are kept even when over budget; unused ones are dropped.
+		cache->setMaximumBytes(0);
+		QCOMPARE(cache->entryCount(), 1);
+		QCOMPARE(cache->evictionCount(), 0);
+		copy.reset();
+		cache->setMaximumBytes(0);
+		QCOMPARE(cache->entryCount(), 0);
+		QCOMPARE(cache->evictionCount(), 1);
+		QCOMPARE(cache->totalBytes(), qint64(0));
+		cache->setMaximumBytes(64*1024*1024);
+
+		// Storing the scan again bumps its stamp, so the old copy is never found again.
+		copy = new AMExternalScanData(scan->dataSourceAt(0));
+		cache->insert(db, scan->id(), "i0", copy);
+		int stamp = cache->modificationStamp(db, scan->id());
+		scan->setNotes("changed");
+		QVERIFY(scan->storeToDb(db));
+		QVERIFY(cache->modificationStamp(db, scan->id()) > stamp);
+		QVERIFY(!cache->find(db, scan->id(), "i0"));
+		QCOMPARE(cache->entryCount(), 0);
+		QCOMPARE(copy->values.size(), 100);
+
+		// On a miss, data() loads the scan out of the database and copies the data source.
+		amTestRegisterExportFileLoader();
+		AMScan *reference = new AMScan();
+		reference->setName("externalScanDataCacheReference");
+		reference->setFileFormat("amTestExport");
+		reference->setFilePath("externalScanDataCacheTest/3");
+		QVERIFY(AMTestExportFileLoader().load(reference, QString(), 0));
+		QVERIFY(reference->addRawDataSource(new AMRawDataSource(reference->rawData(), 0)));
+		QVERIFY(reference->addRawDataSource(new AMRawDataSource(reference->rawData(), 1)));
+		QVERIFY(reference->storeToDb(db));
+
+		cache->resetCounters();
+		int errorCode = 1;
+		AMExternalScanDataCache::Handle loaded = cache->data(db, reference->id(), "tey", &errorCode);
+		QVERIFY(loaded);
+		QCOMPARE(errorCode, 0);
+		QCOMPARE(cache->missCount(), 1);
+		QCOMPARE(cache->hitCount(), 0);
+		QCOMPARE(loaded->values.size(), 40);
+		QCOMPARE(double(loaded->values.at(4)), 301.0);
+		QCOMPARE(double(loaded->axisValues.at(0).at(4)), 272.0);
+		QVERIFY(cache->data(db, reference->id(), "tey") == loaded);
+		QCOMPARE(cache->hitCount(), 1);
+
+		QVERIFY(!cache->data(db, reference->id(), "notThere", &errorCode));
+		QCOMPARE(errorCode, -2);
+		QVERIFY(!cache->data(db, reference->id()+1000, "tey", &errorCode));
+		QCOMPARE(errorCode, -1);
+
+		// Blocks exposing the same data source share the cached copy, and the scan is only loaded once.
+		cache->resetCounters();
+		AMExternalScanDataSourceAB teyBlock(db, reference->id(), "tey", "referenceTey", AMExternalScanDataSourceAB::InConstructor);
+		AMExternalScanDataSourceAB otherTeyBlock(db, reference->id(), "tey", "otherReferenceTey", AMExternalScanDataSourceAB::InConstructor);
+		QCOMPARE(cache->missCount(), 0);
+		QCOMPARE(cache->hitCount(), 4);
+		QVERIFY(teyBlock.isValid());
+		QCOMPARE(teyBlock.rank(), 1);
+		QCOMPARE(teyBlock.size(0), 40);
+		QCOMPARE(double(teyBlock.value(AMnDIndex(4))), 301.0);
+		QCOMPARE(double(teyBlock.axisValue(0, 4)), 272.0);
+		QCOMPARE(double(otherTeyBlock.value(AMnDIndex(39))), 309.75);
+
+		AMExternalScanDataSourceAB sddBlock(db, reference->id(), "sdd", "referenceSdd", AMExternalScanDataSourceAB::Manually);
+		QCOMPARE(sddBlock.rank(), 2);
+		QVERIFY(!sddBlock.isValid());
+		QVERIFY(sddBlock.refreshData());
+		QCOMPARE(sddBlock.size(1), 5);
+		QCOMPARE(double(sddBlock.value(AMnDIndex(4, 3))), 15.0);
+		QCOMPARE(cache->missCount(), 1);
+
+		// Once the reference is stored again, refreshing loads the new version.
+		reference->setNotes("changed");
+		QVERIFY(reference->storeToDb(db));
+		QVERIFY(!cache->find(db, reference->id(), "tey"));
+		QVERIFY(teyBlock.refreshData());
+		QCOMPARE(cache->missCount(), 2);
+		QCOMPARE(double(teyBlock.value(AMnDIndex(4))), 301.0);
+
+		loaded.reset();
+		reference->release();
+		copy.reset();
+		scan->release();
+		AMExternalScanDataCache::releaseCache();
+		AMDatabase::deleteDatabase("externalScanDataCacheTest");
+		QFile::remove(dbFileName);
+	}
+
+
+	/// Tests AMAcqPointRecord with a synthetic dacq stream (200 points, four 512-channel spectra per point), and times it against packaging the same stream as maps, the way the output handler used to.
+	void testAMAcqPointRecord() {
+		// Raw spectra as the dacq library hands them over: DBF_LONG spectra are packed as 4-byte ints.
+		const int channels = 512;
+		QVector<int> rawLong(channels);
+		QVector<short> rawShort(channels);
+		for(int c = 0; c < channels; c++) {
+			rawLong[c] = 1000*c;
+			rawShort[c] = short(c);
+		}
+		QVector<double> converted(channels);
+		QVERIFY(AMAcqScanSpectrumOutput::spectrumToDoubles(DBF_LONG, rawLong.constData(), channels, converted.data()));
+		QCOMPARE(converted.at(511), 511000.0);
+		QVERIFY(AMAcqScanSpectrumOutput::spectrumToDoubles(DBF_SHORT, rawShort.constData(), channels, converted.data()));
+		QCOMPARE(converted.at(7), 7.0);
+
+		// Column 0 is the scan axis, columns 1-4 are scalars, and columns 5-8 are four-element detector spectra.
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV")));
+		for(int m = 0; m < 4; m++)
+			QVERIFY(store.addMeasurement(AMMeasurementInfo(QString("scalar%1").arg(m), "Scalar")));
+		for(int m = 0; m < 4; m++)
+			QVERIFY(store.addMeasurement(AMMeasurementInfo(QString("element%1").arg(m), "Element", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels, "Channel"))));
+
+		// A synthetic stream of points, recorded and written the way the output handler and scan controller do it.
+		const int points = 200;
+		AMAcqPointRecord record;
+		QTime timer;
+		timer.start();
+		for(int p = 0; p < points; p++) {
+			record.clear();
+			record.reserve(5, 4*channels);
+			record.setScalar(0, 7000.0 + p);
+			for(int column = 1; column <= 4; column++)
+				record.setScalar(column, 10.0*p + column);
+			for(int column = 5; column <= 8; column++) {
+				for(int c = 0; c < channels; c++)
+					rawLong[c] = p + column*c;
+				QVERIFY(AMAcqScanSpectrumOutput::spectrumToDoubles(DBF_LONG, rawLong.constData(), channels, record.appendSpectrum(column, channels)));
+			}
+
+			QVERIFY(record.hasScalar(0) && record.scalarCount() == 5);
+			QCOMPARE(record.spectrumCount(), 4);
+			QCOMPARE(record.spectrumValueCount(), 4*channels);
+
+			AMnDIndex insertIndex(store.scanSize(0));
+			QVERIFY(store.beginInsertRows(1, -1));
+			QVERIFY(record.writeTo(&store, insertIndex, 1));
+			store.endInsertRows();
+		}
+		int recordTime = qMax(1, timer.elapsed());
+
+		// The same stream packaged as maps of scalars and spectra, and written one value at a time.
+		AMInMemoryDataStore mapStore;
+		QVERIFY(mapStore.addScanAxis(AMAxisInfo("energy", 0, "Energy", "eV")));
+		for(int m = 0; m < 4; m++)
+			QVERIFY(mapStore.addMeasurement(AMMeasurementInfo(QString("scalar%1").arg(m), "Scalar")));
+		for(int m = 0; m < 4; m++)
+			QVERIFY(mapStore.addMeasurement(AMMeasurementInfo(QString("element%1").arg(m), "Element", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels, "Channel"))));
+
+		timer.start();
+		for(int p = 0; p < points; p++) {
+			QMap<int, double> scalarMap;
+			QMap<int, QList<double> > spectrumMap;
+			scalarMap.insert(0, 7000.0 + p);
+			for(int column = 1; column <= 4; column++)
+				scalarMap.insert(column, 10.0*p + column);
+			for(int column = 5; column <= 8; column++) {
+				for(int c = 0; c < channels; c++)
+					rawLong[c] = p + column*c;
+				QVERIFY(AMAcqScanSpectrumOutput::spectrumToDoubles(DBF_LONG, rawLong.constData(), channels, converted.data()));
+				QList<double> spectrum;
+				for(int c = 0; c < channels; c++)
+					spectrum << converted.at(c);
+				spectrumMap.insert(column, spectrum);
+			}
+
+			int row = mapStore.scanSize(0);
+			QVERIFY(mapStore.beginInsertRows(1, -1));
+			mapStore.setAxisValue(0, row, scalarMap.value(0));
+			for(int column = 1; column <= 4; column++)
+				mapStore.setValue(AMnDIndex(row), column-1, AMnDIndex(), scalarMap.value(column));
+			QMapIterator<int, QList<double> > i(spectrumMap);
+			while(i.hasNext()) {
+				i.next();
+				for(int c = 0; c < i.value().count(); c++)
+					mapStore.setValue(AMnDIndex(row), i.key()-1, AMnDIndex(c), i.value().at(c));
+			}
+			mapStore.endInsertRows();
+		}
+		int mapTime = qMax(1, timer.elapsed());
+
+		qDebug() << "Dacq stream of" << points << "points with four" << channels << "channel spectra:" << recordTime << "ms with AMAcqPointRecord," << mapTime << "ms with maps";
+		// Either way this is well under a second.  The bound only catches something going badly wrong (ex: copying the whole record per value).
+		QVERIFY2(recordTime < 5000, qPrintable(QString("Writing the records took %1 ms").arg(recordTime)));
+		QCOMPARE(double(mapStore.value(AMnDIndex(150), 6, AMnDIndex(100))), double(store.value(AMnDIndex(150), 6, AMnDIndex(100))));
+
+		QCOMPARE(int(store.scanSize(0)), points);
+		QCOMPARE(double(store.axisValue(0, 150)), 7150.0);
+		QCOMPARE(double(store.value(AMnDIndex(150), 2, AMnDIndex())), 1503.0);
+		QCOMPARE(double(store.value(AMnDIndex(150), 6, AMnDIndex(100))), 150.0 + 7*100);
+
+		// The map forms match what used to be posted.
+		QMap<int, double> scalars = record.scalarMap();
+		QCOMPARE(scalars.count(), 5);
+		QCOMPARE(scalars.value(4), 10.0*(points-1) + 4);
+		QMap<int, QList<double> > spectra = record.spectrumMap();
+		QCOMPARE(spectra.keys(), QList<int>() << 5 << 6 << 7 << 8);
+		QCOMPARE(spectra.value(8).at(3), double(points-1 + 8*3));
+
+		// Spectrum columns leave holes in the scalar array.
+		AMAcqPointRecord sparse;
+		sparse.setScalar(0, 1);
+		sparse.appendSpectrum(1, 4);
+		sparse.setScalar(2, 3);
+		QCOMPARE(sparse.columnCount(), 3);
+		QCOMPARE(sparse.scalarCount(), 2);
+		QVERIFY(!sparse.hasScalar(1));
+		QCOMPARE(sparse.scalar(2), 3.0);
+	}
+
+
+	void testAcqFileStreamBufferedWrites() {
+		QString fileName = QDir::tempPath() + "/testAcqFileStream.dat";
+		QFile::remove(fileName);
+
+		acqBaseStream *stream = acqOutputStreamFactoryRegister::new_acqStream("File");
+		QVERIFY(stream);
+		stream->setProperty("File Path", QDir::tempPath().toStdString());
+		stream->setProperty("File Template", "testAcqFileStream.dat");
+		stream->setProperty("Flush Policy", "Scan End");
+		QCOMPARE(QString::fromStdString(stream->getProperty("Flush Policy")), QString("Scan End"));
+		QCOMPARE(stream->open(), 0);
+
+		// Writes only go into the buffer, but offsets still count them.
+		QByteArray line("1.000000,2.000000,3.000000,4.000000\n");
+		int total = 0;
+		for(int i = 0; i < 1000; i++) {
+			QCOMPARE(stream->write(line.constData(), line.size()), 1);
+			total += line.size();
+			stream->flush();
+		}
+		QCOMPARE(stream->offset(), total);
+		QCOMPARE(QFileInfo(fileName).size(), qint64(0));
+
+		// sync() waits for the background writer.
+		QCOMPARE(stream->sync(), 0);
+		QCOMPARE(QFileInfo(fileName).size(), qint64(total));
+
+		// With the byte policy, the writer catches up on its own.
+		stream->setProperty("Flush Bytes", "4096");
+		stream->setProperty("Flush Policy", "Bytes");
+		for(int i = 0; i < 1000; i++)
+			stream->write(line.constData(), line.size());
+		total += 1000*line.size();
+		QCOMPARE(stream->offset(), total);
+		QCOMPARE(stream->close(), 0);
+		QCOMPARE(QFileInfo(fileName).size(), qint64(total));
+
+		delete stream;
+		QFile::remove(fileName);
+	}
+
+
+	void testAMDbUpgradeSetBasedMigration() {
+		QString fileName = QDir::tempPath() + "/testAMDbUpgradeSetBasedMigration.db";
+		QFile::remove(fileName);
+		AMDatabase* db = AMDatabase::createDatabase("migrationTest", fileName);
+		QVERIFY(db);
+
+		// A synthetic database in the AMDbObject layout: a class table with 100k objects, an index table and a parent table referring to all of them.
+		QVERIFY(db->ensureTable("AMDbObjectTypes_table", QString("AMDbObjectType,tableName,description").split(','), QString("TEXT,TEXT,TEXT").split(',')));
+		QVERIFY(db->ensureTable("AMDbObjectTypes_allColumns", QString("typeId,columnName").split(','), QString("INTEGER,TEXT").split(',')));
+		QVERIFY(db->ensureTable("AMDbObjectTypes_visibleColumns", QString("typeId,columnName").split(','), QString("INTEGER,TEXT").split(',')));
+		QVERIFY(db->ensureTable("AMDbObjectTypes_loadColumns", QString("typeId,columnName").split(','), QString("INTEGER,TEXT").split(',')));
+		QVERIFY(db->ensureTable("TestOldRecord_table", QString("AMDbObjectType,name").split(','), QString("TEXT,TEXT").split(',')));
+		QVERIFY(db->ensureTable("TestRecordSet_table_records", QString("id1,table1,id2,table2").split(','), QString("INTEGER,TEXT,INTEGER,TEXT").split(',')));
+		QVERIFY(db->ensureTable("TestRecordOwner_table", QString("record").split(','), QString("TEXT").split(',')));
+
+		int typeId = db->insertOrUpdate(0, "AMDbObjectTypes_table", QString("AMDbObjectType,tableName,description").split(','), QVariantList() << "TestOldRecord" << "TestOldRecord_table" << "Test Record");
+		QVERIFY(typeId > 0);
+
+		const int rowCount = 100000;
+		QVERIFY(db->startTransaction());
+		QSqlQuery q = db->query();
+		QVERIFY(q.prepare("INSERT INTO TestOldRecord_table (AMDbObjectType, name) VALUES ('TestOldRecord', ?)"));
+		for(int i = 1; i <= rowCount; i++) {
+			q.bindValue(0, QString("Record %1").arg(i));
+			QVERIFY(q.exec());
+		}
+		QVERIFY(q.prepare("INSERT INTO TestRecordSet_table_records (id1, table1, id2, table2) VALUES (?, 'TestRecordSet_table', ?, 'TestOldRecord_table')"));
+		for(int i = 1; i <= rowCount; i++) {
+			q.bindValue(0, 1 + i/100);
+			q.bindValue(1, i);
+			QVERIFY(q.exec());
+		}
+		QVERIFY(q.prepare("INSERT INTO TestRecordOwner_table (record) VALUES (?)"));
+		for(int i = 1; i <= rowCount; i++) {
+			q.bindValue(0, QString("TestOldRecord_table;%1").arg(i));
+			QVERIFY(q.exec());
+		}
+		q.finish();
+		QVERIFY(db->commitTransaction());
+
+		QMap<QString, QString> parentTablesToColumnNames;
+		parentTablesToColumnNames.insert("TestRecordOwner_table", "record");
+		QMap<QString, int> indexTablesToIndexSide;
+		indexTablesToIndexSide.insert("TestRecordSet_table_records", 2);
+
+		AMDbMigration migration(db);
+		QSignalSpy progressSpy(&migration, SIGNAL(progressChanged(int,int,QString)));
+		QVERIFY(AMDbUpgradeSupport::appendDbObjectClassBecomesSteps(&migration, "TestOldRecord", "TestNewRecord", parentTablesToColumnNames, indexTablesToIndexSide));
+		QCOMPARE(migration.stepCount(), 4);
+
+		QTime timer;
+		timer.start();
+		QVERIFY(migration.run());
+		int elapsedMs = timer.elapsed();
+		qDebug() << "Set-based class rename of" << rowCount << "objects:" << migration.rowsAffected() << "rows changed in" << elapsedMs << "ms";
+		// Row-at-a-time, this took minutes.  Set-based, it should be a few seconds at most, even on a slow disk.
+		QVERIFY2(elapsedMs < 30000, qPrintable(QString("The upgrade took %1 ms").arg(elapsedMs)));
+
+		// One progress report per step, and one at the end.
+		QCOMPARE(progressSpy.count(), 5);
+		QCOMPARE(progressSpy.last().at(0).toInt(), 4);
+		QVERIFY(!db->transactionInProgress());
+
+		// Every reference was updated, and the table was renamed.
+		QCOMPARE(db->retrieve(typeId, "AMDbObjectTypes_table", "AMDbObjectType").toString(), QString("TestNewRecord"));
+		QCOMPARE(db->retrieve(typeId, "AMDbObjectTypes_table", "tableName").toString(), QString("TestNewRecord_table"));
+		QCOMPARE(db->columnNames("TestOldRecord_table"), QStringList());
+		QCOMPARE(db->objectsMatching("TestNewRecord_table", "AMDbObjectType", "TestNewRecord").count(), rowCount);
+		QCOMPARE(db->objectsMatching("TestRecordSet_table_records", "table2", "TestNewRecord_table").count(), rowCount);
+		QCOMPARE(db->retrieve(rowCount, "TestRecordOwner_table", "record").toString(), QString("TestNewRecord_table;%1").arg(rowCount));
+		QCOMPARE(db->objectsWhere("TestRecordOwner_table", "record LIKE 'TestOldRecord_table;%'").count(), 0);
+		QCOMPARE(db->retrieve(12345, "TestNewRecord_table", "name").toString(), QString("Record 12345"));
+
+		// Merging another class in offsets its ids by the number of objects already there, everywhere they are referred to.
+		int otherTypeId = db->insertOrUpdate(0, "AMDbObjectTypes_table", QString("AMDbObjectType,tableName,description").split(','), QVariantList() << "TestOtherRecord" << "TestOtherRecord_table" << "Other Record");
+		QVERIFY(db->insertOrUpdate(0, "AMDbObjectTypes_allColumns", QString("typeId,columnName").split(','), QVariantList() << otherTypeId << "name") > 0);
+		QVERIFY(db->ensureTable("TestOtherRecord_table", QString("AMDbObjectType,name").split(','), QString("TEXT,TEXT").split(',')));
+		for(int i = 1; i <= 3; i++)
+			QVERIFY(db->insertOrUpdate(0, "TestOtherRecord_table", QString("AMDbObjectType,name").split(','), QVariantList() << "TestOtherRecord" << QString("Other %1").arg(i)) == i);
+		QVERIFY(db->insertOrUpdate(0, "TestRecordSet_table_records", QString("id1,table1,id2,table2").split(','), QVariantList() << 1 << "TestRecordSet_table" << 2 << "TestOtherRecord_table") > 0);
+		QVERIFY(db->insertOrUpdate(0, "TestRecordOwner_table", QString("record").split(','), QVariantList() << "TestOtherRecord_table;3") > 0);
+
+		QVERIFY(AMDbUpgradeSupport::dbObjectClassMerge(db, "TestNewRecord", "TestOtherRecord", parentTablesToColumnNames, indexTablesToIndexSide));
+		QCOMPARE(db->retrieve(rowCount+2, "TestNewRecord_table", "name").toString(), QString("Other 2"));
+		QCOMPARE(db->objectsMatching("TestRecordSet_table_records", "table2", "TestNewRecord_table").count(), rowCount+1);
+		QCOMPARE(db->retrieve(rowCount+1, "TestRecordOwner_table", "record").toString(), QString("TestNewRecord_table;%1").arg(rowCount+3));
+		QVERIFY(db->objectsMatching("AMDbObjectTypes_table", "AMDbObjectType", "TestOtherRecord").isEmpty());
+		QVERIFY(db->objectsWhere("AMDbObjectTypes_allColumns", QString("typeId=%1").arg(otherTypeId)).isEmpty());
+		QCOMPARE(db->columnNames("TestOtherRecord_table"), QStringList());
+
+		// If any statement fails, none of the steps are applied.
+		AMDbMigration failingMigration(db);
+		failingMigration.addStep("Renaming every record", "UPDATE TestNewRecord_table SET name = 'Renamed';");
+		failingMigration.addStep("Failing", "UPDATE TestMissing_table SET name = 'Missing';");
+		QVERIFY(!failingMigration.run());
+		QVERIFY(!failingMigration.lastError().isEmpty());
+		QVERIFY(!db->transactionInProgress());
+		QCOMPARE(db->retrieve(12345, "TestNewRecord_table", "name").toString(), QString("Record 12345"));
+
+		AMDatabase::deleteDatabase("migrationTest");
+		QFile::remove(fileName);
+	}
+
+
+	/// Tests that AM1DIntegralAB gives the same trapezoid sums as the point-by-point definition on a 1M point input, and only re-calculates what changed.
+	void testAM1DIntegralABCumulativeSums() {
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("x", 0, "x axis")));
+		QVERIFY(store.addMeasurement(AMMeasurementInfo("signal", "Signal")));
+
+		const int count = 1000000;
+		QVector<double> x(count), f(count);
+		QVERIFY(store.beginInsertRows(count, -1));
+		for(int i = 0; i < count; i++) {
+			x[i] = 250.0 + i*0.001 + (i%3)*0.0001;	// not quite uniform
+			f[i] = sin(i/1000.0)*100 + i%7;
+			store.setAxisValue(0, i, x.at(i));
+			store.setValue(AMnDIndex(i), 0, AMnDIndex(), f.at(i));
+		}
+		store.endInsertRows();
+
+		AMRawDataSource *rawSource = new AMRawDataSource(&store, 0);
+		AM1DIntegralAB integral("integral");
+		integral.setInputDataSources(QList<AMDataSource*>() << rawSource);
+		QVERIFY(integral.isValid());
+
+		// The definition the recursive value() used: the sum at i includes the segment from i to i+1, and the last point repeats the segment before it.
+		QVector<double> expected(count);
+		double sum = 0;
+		for(int i = 0; i < count; i++) {
+			if(i == count-1)
+				sum += 0.5*(x.at(i)-x.at(i-1))*(f.at(i)+f.at(i-1));
+			else
+				sum += 0.5*(x.at(i+1)-x.at(i))*(f.at(i+1)+f.at(i));
+			expected[i] = sum;
+		}
+
+		// A cold lookup at the very end used to recurse through every point before it.
+		QTime timer;
+		timer.start();
+		double last = integral.value(AMnDIndex(count-1));
+		QVERIFY(fabs(last - expected.at(count-1)) < 1e-9*qMax(1.0, fabs(expected.at(count-1))));
+
+		QVector<double> all(count);
+		QVERIFY(integral.values(AMnDIndex(0), AMnDIndex(count-1), all.data()));
+		for(int i = 0; i < count; i++)
+			QVERIFY(fabs(all.at(i) - double(integral.value(AMnDIndex(i)))) < 1e-12 && fabs(all.at(i) - expected.at(i)) < 1e-9*qMax(1.0, fabs(expected.at(i))));
+		qDebug() << "Integral of" << count << "points, read twice:" << timer.elapsed() << "ms";
+
+		// Changing one value changes the integral from the point before it onwards, and nothing earlier.
+		qRegisterMetaType<AMnDIndex>();
+		QSignalSpy valuesChangedSpy(integral.signalSource(), SIGNAL(valuesChanged(AMnDIndex,AMnDIndex)));
+		const int changed = 600000;
+		f[changed] += 50;
+		store.setValue(AMnDIndex(changed), 0, AMnDIndex(), f.at(changed));
+		QCOMPARE(valuesChangedSpy.count(), 1);
+		QCOMPARE(valuesChangedSpy.at(0).at(0).value<AMnDIndex>().i(), changed-1);
+
+		sum = expected.at(changed-2);
+		for(int i = changed-1; i < count; i++) {
+			if(i == count-1)
+				sum += 0.5*(x.at(i)-x.at(i-1))*(f.at(i)+f.at(i-1));
+			else
+				sum += 0.5*(x.at(i+1)-x.at(i))*(f.at(i+1)+f.at(i));
+			expected[i] = sum;
+		}
+
+		QVector<double> part(1001);
+		QVERIFY(integral.values(AMnDIndex(changed-500), AMnDIndex(changed+500), part.data()));
+		for(int i = 0; i < part.size(); i++)
+			QVERIFY(fabs(part.at(i) - expected.at(changed-500+i)) < 1e-9*qMax(1.0, fabs(expected.at(changed-500+i))));
+		QVERIFY(fabs(double(integral.value(AMnDIndex(count-1))) - expected.at(count-1)) < 1e-9*qMax(1.0, fabs(expected.at(count-1))));
+
+		integral.setInputDataSources(QList<AMDataSource*>());
+		delete rawSource;
+	}
+
+
+	/// Tests that AMDetector::readingFromData() copies the same values as the element-by-element reading1D() and reading2D(), for whole and partial blocks.
+	void testAMDetectorReadingFromData() {
+		AMTestArrayDetector spectrum("spectrum", AMnDIndex(1024));
+
+		QVector<double> fast(1024), slow(1024);
+		QVERIFY(spectrum.reading1D(AMnDIndex(0), AMnDIndex(1023), fast.data()));
+		QVERIFY(spectrum.AMDetector::reading1D(AMnDIndex(0), AMnDIndex(1023), slow.data()));
+		QVERIFY(fast == slow);
+
+		QVector<double> fastPart(101), slowPart(101);
+		QVERIFY(spectrum.reading1D(AMnDIndex(300), AMnDIndex(400), fastPart.data()));
+		QVERIFY(spectrum.AMDetector::reading1D(AMnDIndex(300), AMnDIndex(400), slowPart.data()));
+		QVERIFY(fastPart == slowPart);
+		QCOMPARE(fastPart.at(0), double(spectrum.reading(AMnDIndex(300))));
+
+		QVERIFY(!spectrum.reading1D(AMnDIndex(0, 0), AMnDIndex(1, 1), fast.data()));
+
+		AMTestArrayDetector image("image", AMnDIndex(64, 48));
+
+		QVector<double> fastImage(64*48), slowImage(64*48);
+		QVERIFY(image.reading2D(AMnDIndex(0, 0), AMnDIndex(63, 47), fastImage.data()));
+		QVERIFY(image.AMDetector::reading2D(AMnDIndex(0, 0), AMnDIndex(63, 47), slowImage.data()));
+		QVERIFY(fastImage == slowImage);
+
+		QVector<double> fastBlock(11*7), slowBlock(11*7);
+		QVERIFY(image.reading2D(AMnDIndex(20, 5), AMnDIndex(30, 11), fastBlock.data()));
+		QVERIFY(image.AMDetector::reading2D(AMnDIndex(20, 5), AMnDIndex(30, 11), slowBlock.data()));
+		QVERIFY(fastBlock == slowBlock);
+		QCOMPARE(fastBlock.at(7), double(image.reading(AMnDIndex(21, 5))));
+
+		QVector<double> fastRows(3*48), slowRows(3*48);
+		QVERIFY(image.reading2D(AMnDIndex(10, 0), AMnDIndex(12, 47), fastRows.data()));
+		QVERIFY(image.AMDetector::reading2D(AMnDIndex(10, 0), AMnDIndex(12, 47), slowRows.data()));
+		QVERIFY(fastRows == slowRows);
+	}
+
+
+	/// Tests that AMRegionOfInterestAB maps match the sums over the stored spectra, that all the regions on one input are calculated in a single pass, and that changes only re-read what they need to.
+	void testAMRegionOfInterestAB() {
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("x", 0, "x axis")));
+		QVERIFY(store.addScanAxis(AMAxisInfo("y", 30, "y axis")));
+		QVERIFY(store.addMeasurement(AMMeasurementInfo("xrf", "XRF Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", 512, "Channel"))));
+
+		const int xSize = 40, ySize = 30, channels = 512;
+		QVector<double> spectra(xSize*ySize*channels);
+		for(int i = 0; i < spectra.size(); i++)
+			spectra[i] = (i*7919)%101;
+
+		QVERIFY(store.beginInsertRows(xSize, -1));
+		for(int x = 0; x < xSize; x++)
+			for(int y = 0; y < ySize; y++)
+				QVERIFY(store.setValue(AMnDIndex(x, y), 0, spectra.constData()+(x*ySize+y)*channels));
+		store.endInsertRows();
+
+		AMRawDataSource *rawSource = new AMRawDataSource(&store, 0);
+		QCOMPARE(rawSource->rank(), 3);
+
+		QList<QPair<int, int> > ranges;
+		ranges << qMakePair(0, 0) << qMakePair(100, 199) << qMakePair(0, channels-1);
+
+		QList<AMRegionOfInterestAB*> regions;
+		for(int r = 0; r < ranges.count(); r++) {
+			AMRegionOfInterestAB *region = new AMRegionOfInterestAB(QString("roi%1").arg(r));
+			region->setRegionMinimum(ranges.at(r).first);
+			region->setRegionMaximum(ranges.at(r).second);
+			region->setInputDataSources(QList<AMDataSource*>() << rawSource);
+			QVERIFY(region->isValid());
+			QCOMPARE(region->rank(), 2);
+			QCOMPARE(region->size(), AMnDIndex(xSize, ySize));
+			regions << region;
+		}
+
+		AMRegionOfInterestEngine *engine = regions.first()->engine();
+		QVERIFY(engine);
+		QCOMPARE(engine->regionCount(), ranges.count());
+		for(int r = 1; r < regions.count(); r++)
+			QVERIFY(regions.at(r)->engine() == engine);
+
+		QVector<double> map(xSize*ySize);
+		for(int r = 0; r < regions.count(); r++) {
+			QVERIFY(regions.at(r)->values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), map.data()));
+
+			for(int p = 0; p < xSize*ySize; p++) {
+				double expected = 0;
+				for(int c = ranges.at(r).first; c <= ranges.at(r).second; c++)
+					expected += spectra.at(p*channels+c);
+				QCOMPARE(map.at(p), expected);
+			}
+		}
+
+		// Every map came from the same single pass over the spectra.
+		QCOMPARE(engine->passCount(), 1);
+		QCOMPARE(engine->spectraRead(), long(xSize*ySize));
+
+		// Partial blocks and single values come from the same maps.
+		QVector<double> block(5*4);
+		QVERIFY(regions.at(1)->values(AMnDIndex(10, 20), AMnDIndex(14, 23), block.data()));
+		QCOMPARE(block.at(6), double(regions.at(1)->value(AMnDIndex(11, 22))));
+		double expected = 0;
+		for(int c = 100; c <= 199; c++)
+			expected += spectra.at((11*ySize+22)*channels+c);
+		QCOMPARE(block.at(6), expected);
+		QCOMPARE(double(engine->mapValue(regions.at(1)->regionId(), AMnDIndex(11, 22))), expected);
+
+		// Regions and pixels the engine doesn't have give invalid values, not 0.
+		QVERIFY(!engine->mapValue(-1, AMnDIndex(11, 22)).isValid());
+		QVERIFY(!engine->mapValue(regions.at(1)->regionId(), AMnDIndex(xSize, 0)).isValid());
+		QVERIFY(!engine->mapValue(regions.at(1)->regionId(), AMnDIndex(11)).isValid());
+
+		// Changing one spectrum only re-reads that spectrum.
+		QVector<double> newSpectrum(channels, 2.0);
+		QVERIFY(store.setValue(AMnDIndex(5, 6), 0, newSpectrum.constData()));
+		QCOMPARE(double(regions.at(1)->value(AMnDIndex(5, 6))), 200.0);
+		QCOMPARE(double(regions.at(2)->value(AMnDIndex(5, 6))), 2.0*channels);
+		QCOMPARE(engine->spectraRead(), long(xSize*ySize+1));
+
+		// Changing a region re-calculates it over every pixel.
+		regions.at(0)->setRegionMinimum(10);
+		regions.at(0)->setRegionMaximum(12);
+		QCOMPARE(double(regions.at(0)->value(AMnDIndex(5, 6))), 6.0);
+		QCOMPARE(double(regions.at(0)->value(AMnDIndex(0, 1))), spectra.at(channels+10)+spectra.at(channels+11)+spectra.at(channels+12));
+		QCOMPARE(engine->spectraRead(), long(2*xSize*ySize+1));
+
+		// A region outside the spectrum makes the output invalid.
+		regions.at(0)->setRegionMaximum(channels);
+		QVERIFY(!regions.at(0)->isValid());
+
+		qDeleteAll(regions);
+		delete rawSource;
+	}
+
+	/// Reports from many threads at once, and checks that every report is either delivered, held back by the repeat limit, or counted as dropped.
+	void testAMErrorMonConcurrentReports()
+	{
+		const int threadCount = 8;
+		const int reportsPerThread = 20000;
+		const int firstCode = 290890;
+
+		AMErrorMon *monitor = AMErrorMon::mon();
+		monitor->processQueuedReports();
+		AMErrorMon::setRepeatLimit(5, 60000);
+		monitor->resetReportCounts();
+		QSignalSpy alertSpy(monitor, SIGNAL(alert(AMErrorReport)));
+
+		QList<AMTestErrorReporterThread*> threads;
+		for(int i = 0; i < threadCount; i++)
+			threads << new AMTestErrorReporterThread(firstCode+i, reportsPerThread);
+
+		QTime timer;
+		timer.start();
+
+		foreach(AMTestErrorReporterThread *thread, threads)
+			thread->start();
+		foreach(AMTestErrorReporterThread *thread, threads)
+			thread->wait();
+
+		int reportingTime = timer.elapsed();
+		monitor->processQueuedReports();
+		qDebug() << "AMErrorMon: " << threadCount*reportsPerThread << "reports from" << threadCount << "threads in" << reportingTime << "ms." << monitor->droppedReportCount() << "were dropped.";
+
+		int deliveredOwnReports = 0;
+		int droppedAlertCount = 0;
+		for(int i = 0; i < alertSpy.count(); i++) {
+			AMErrorReport e = alertSpy.at(i).at(0).value<AMErrorReport>();
+			if(e.errorCode >= firstCode && e.errorCode < firstCode+threadCount) {
+				deliveredOwnReports++;
+				QVERIFY(e.description.endsWith("[Message received from out of main thread.]"));
+			}
+			else if(e.errorCode == AMERRORMON_REPORTS_DROPPED)
+				droppedAlertCount++;
+		}
+
+		// The main thread was busy waiting, so no more than one ring's worth could have been taken out.
+		QVERIFY(monitor->droppedReportCount() >= threadCount*reportsPerThread - 4096);
+		QCOMPARE(droppedAlertCount, 1);
+		QVERIFY(deliveredOwnReports <= threadCount*5);
+		QCOMPARE(deliveredOwnReports + monitor->suppressedReportCount() + monitor->droppedReportCount(), threadCount*reportsPerThread);
+
+		qDeleteAll(threads);
+		AMErrorMon::setRepeatLimit(10, 1000);
+	}
+
+	/// Checks that repeated reports from the main thread are limited, and summed up when the window ends.
+	void testAMErrorMonRepeatLimit()
+	{
+		const int code = 290899;
+
+		AMErrorMon *monitor = AMErrorMon::mon();
+		AMErrorMon::setRepeatLimit(10, 50);
+		monitor->resetReportCounts();
+		QSignalSpy alertSpy(monitor, SIGNAL(alert(AMErrorReport)));
+		QSignalSpy informationSpy(monitor, SIGNAL(information(AMErrorReport)));
+
+		for(int i = 0; i < 100; i++)
+			AMErrorMon::alert(this, code, QString("Repeated alert %1").arg(i));
+
+		// Main thread reports are still delivered right away; only the first 10 get through.
+		QCOMPARE(alertSpy.count(), 10);
+		QCOMPARE(monitor->suppressedReportCount(), 90);
+		QVERIFY(alertSpy.at(0).at(0).value<AMErrorReport>().description.startsWith("in [TestDataman]: "));
+
+		// Information reports are never limited.
+		for(int i = 0; i < 20; i++)
+			AMErrorMon::information(this, code, QString("Progress %1").arg(i));
+		QCOMPARE(informationSpy.count(), 20);
+
+		QTest::qWait(150);
+
+		QCOMPARE(alertSpy.count(), 11);
+		AMErrorReport summary = alertSpy.at(10).at(0).value<AMErrorReport>();
+		QCOMPARE(summary.errorCode, code);
+		QVERIFY(summary.description.contains("90 more like this"));
+		QVERIFY(summary.description.endsWith("Repeated alert 99"));
+
+		// A new window: reports get through again.
+		AMErrorMon::alert(this, code, "After the window");
+		QCOMPARE(alertSpy.count(), 12);
+
+		AMErrorMon::setRepeatLimit(10, 1000);
+	}
+
+	/// Checks AMCompressedSpectrumDataStore against AMInMemoryDataStore on a 40x30 map of 2048-channel spectra, and reports the compression ratio and read throughput.
+	void testAMCompressedSpectrumDataStore()
+	{
+		const int xSize = 40, ySize = 30, channels = 2048;
+
+		AMInMemoryDataStore reference;
+		AMCompressedSpectrumDataStore compressed;
+		QList<AMDataStore*> stores;
+		stores << &reference << &compressed;
+
+		foreach(AMDataStore *store, stores) {
+			QVERIFY(store->addScanAxis(AMAxisInfo("x", 0, "x axis")));
+			QVERIFY(store->addScanAxis(AMAxisInfo("y", ySize, "y axis")));
+			QVERIFY(store->addMeasurement(AMMeasurementInfo("I0", "I0")));
+			QVERIFY(store->addMeasurement(AMMeasurementInfo("xrf", "XRF Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels, "Channel"))));
+		}
+		QVERIFY(!compressed.isCompressed(0));
+		QVERIFY(compressed.isCompressed(1));
+
+		// Low counts on a background with two peaks, like a real XRF spectrum.
+		QVector<int> spectrum(channels);
+		qsrand(47);
+		foreach(AMDataStore *store, stores) {
+			QVERIFY(store->beginInsertRows(xSize, -1));
+			store->endInsertRows();
+		}
+		for(int x = 0; x < xSize; x++) {
+			for(int y = 0; y < ySize; y++) {
+				// Leave the last pixel unwritten.
+				if(x == xSize-1 && y == ySize-1)
+					continue;
+
+				for(int c = 0; c < channels; c++)
+					spectrum[c] = 3 + (x+y)%5 + int(400*exp(-pow((c-600)/15.0, 2))) + int(150*exp(-pow((c-1400)/20.0, 2))) + qrand()%4;
+
+				foreach(AMDataStore *store, stores) {
+					QVERIFY(store->setValue(AMnDIndex(x, y), 0, AMnDIndex(), 1000.0 + x*ySize + y));
+					QVERIFY(store->setValue(AMnDIndex(x, y), 1, spectrum.constData()));
+				}
+			}
+		}
+
+		qDebug() << "AMCompressedSpectrumDataStore:" << compressed.uncompressedByteCount() << "bytes stored in" << compressed.compressedByteCount() << "bytes. Compression ratio:" << compressed.compressionRatio();
+		QVERIFY(compressed.compressionRatio() > 8);
+
+		// The whole map, a block of it, and single values.
+		QVector<double> expected(xSize*ySize*channels), actual(xSize*ySize*channels);
+		QVERIFY(reference.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), expected.data()));
+		QVERIFY(compressed.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		QVERIFY(expected == actual);
+		QCOMPARE(actual.last(), -1.0);
+
+		QVERIFY(reference.values(AMnDIndex(3, 10), AMnDIndex(7, 12), 1, AMnDIndex(100), AMnDIndex(199), expected.data()));
+		QVERIFY(compressed.values(AMnDIndex(3, 10), AMnDIndex(7, 12), 1, AMnDIndex(100), AMnDIndex(199), actual.data()));
+		QVERIFY(memcmp(expected.constData(), actual.constData(), 5*3*100*sizeof(double)) == 0);
+
+		QVERIFY(compressed.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 0, AMnDIndex(), AMnDIndex(), actual.data()));
+		QCOMPARE(actual.at(ySize+2), 1000.0 + ySize + 2);
+
+		QVERIFY(compressed.value(AMnDIndex(5, 6), 1, AMnDIndex(600)) == reference.value(AMnDIndex(5, 6), 1, AMnDIndex(600)));
+		QCOMPARE(compressed.value(AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0)).state(), AMNumber::Null);
+		QVERIFY(!compressed.values(AMnDIndex(0, 0), AMnDIndex(xSize, 0), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+
+		// Non-integer spectra are kept exactly, and writes show up in cached rows.
+		QVector<double> fractional(channels);
+		for(int c = 0; c < channels; c++)
+			fractional[c] = c/3.0 - 100.25;
+		QVERIFY(compressed.setValue(AMnDIndex(2, 4), 1, fractional.constData()));
+		QVERIFY(compressed.values(AMnDIndex(2, 4), AMnDIndex(2, 4), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		QVERIFY(memcmp(fractional.constData(), actual.constData(), channels*sizeof(double)) == 0);
+		QVERIFY(compressed.setValue(AMnDIndex(2, 4), 1, AMnDIndex(7), 42));
+		QCOMPARE(double(compressed.value(AMnDIndex(2, 4), 1, AMnDIndex(7))), 42.0);
+		QCOMPARE(double(compressed.value(AMnDIndex(2, 4), 1, AMnDIndex(8))), fractional.at(8));
+
+		// Put the reference spectrum back, for the comparisons below.
+		QVERIFY(reference.values(AMnDIndex(2, 4), AMnDIndex(2, 4), 1, AMnDIndex(0), AMnDIndex(channels-1), fractional.data()));
+		QVERIFY(compressed.setValue(AMnDIndex(2, 4), 1, fractional.constData()));
+
+		// One channel of the unwritten spectrum: the other channels stay invalid, like in AMInMemoryDataStore.  Clearing it again leaves the spectrum unwritten.
+		AMnDIndex unwritten(xSize-1, ySize-1);
+		QVERIFY(reference.setValue(unwritten, 1, AMnDIndex(7), 42));
+		QVERIFY(compressed.setValue(unwritten, 1, AMnDIndex(7), 42));
+		QCOMPARE(double(compressed.value(unwritten, 1, AMnDIndex(7))), 42.0);
+		QCOMPARE(compressed.value(unwritten, 1, AMnDIndex(6)).state(), reference.value(unwritten, 1, AMnDIndex(6)).state());
+		QCOMPARE(compressed.value(unwritten, 1, AMnDIndex(6)).state(), AMNumber::Null);
+		QCOMPARE(compressed.value(unwritten, 1, AMnDIndex(channels-1)).state(), AMNumber::Null);
+		QVERIFY(compressed.values(unwritten, unwritten, 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		QCOMPARE(actual.at(7), 42.0);
+		QCOMPARE(actual.at(8), -1.0);
+
+		QVERIFY(compressed.setValue(unwritten, 1, AMnDIndex(8), 43));
+		QCOMPARE(double(compressed.value(unwritten, 1, AMnDIndex(7))), 42.0);
+		QCOMPARE(double(compressed.value(unwritten, 1, AMnDIndex(8))), 43.0);
+		QCOMPARE(compressed.value(unwritten, 1, AMnDIndex(9)).state(), AMNumber::Null);
+
+		QVERIFY(reference.setValue(unwritten, 1, AMnDIndex(7), AMNumber()));
+		QVERIFY(compressed.setValue(unwritten, 1, AMnDIndex(7), AMNumber()));
+		QVERIFY(compressed.setValue(unwritten, 1, AMnDIndex(8), AMNumber()));
+		QCOMPARE(compressed.value(unwritten, 1, AMnDIndex(7)).state(), AMNumber::Null);
+		QCOMPARE(compressed.value(unwritten, 1, AMnDIndex(8)).state(), AMNumber::Null);
+
+		// AM3DBinningAB works the same on both.
+		AMRawDataSource *referenceSource = new AMRawDataSource(&reference, 1);
+		AMRawDataSource *compressedSource = new AMRawDataSource(&compressed, 1);
+		AM3DBinningAB referenceBinning("referenceBinning"), compressedBinning("compressedBinning");
+		referenceBinning.setSumRangeMin(550);
+		referenceBinning.setSumRangeMax(650);
+		compressedBinning.setSumRangeMin(550);
+		compressedBinning.setSumRangeMax(650);
+		referenceBinning.setInputDataSources(QList<AMDataSource*>() << referenceSource);
+		compressedBinning.setInputDataSources(QList<AMDataSource*>() << compressedSource);
+		QVERIFY(compressedBinning.isValid());
+		QVERIFY(referenceBinning.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), expected.data()));
+		QVERIFY(compressedBinning.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), actual.data()));
+		QVERIFY(memcmp(expected.constData(), actual.constData(), xSize*ySize*sizeof(double)) == 0);
+		referenceBinning.setInputDataSources(QList<AMDataSource*>());
+		compressedBinning.setInputDataSources(QList<AMDataSource*>());
+		delete referenceSource;
+		delete compressedSource;
+
+		// Read throughput: every row decoded (no cache), then from the row cache.
+		double megabytes = double(xSize*ySize*channels*sizeof(double))/1048576.0;
+		QTime timer;
+
+		compressed.setRowCacheSize(0);
+		int decodeCount = compressed.rowDecodeCount();
+		timer.start();
+		QVERIFY(compressed.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		int decodingTime = qMax(1, timer.elapsed());
+		QCOMPARE(compressed.rowDecodeCount() - decodeCount, xSize);
+
+		compressed.setRowCacheSize(xSize*ySize*channels);
+		QVERIFY(compressed.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		decodeCount = compressed.rowDecodeCount();
+		timer.start();
+		QVERIFY(compressed.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		int cachedTime = qMax(1, timer.elapsed());
+		QCOMPARE(compressed.rowDecodeCount(), decodeCount);
+
+		timer.start();
+		QVERIFY(reference.values(AMnDIndex(0, 0), AMnDIndex(xSize-1, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), expected.data()));
+		int referenceTime = qMax(1, timer.elapsed());
+		QVERIFY(expected == actual);
+
+		qDebug() << "AMCompressedSpectrumDataStore read throughput (MB/s): decoding" << megabytes*1000/decodingTime << ", cached" << megabytes*1000/cachedTime << ", AMInMemoryDataStore" << megabytes*1000/referenceTime;
+
+		// Inserting rows in front moves the cached rows.
+		QVERIFY(compressed.beginInsertRows(1, 0));
+		compressed.endInsertRows();
+		QVERIFY(compressed.values(AMnDIndex(1, 0), AMnDIndex(xSize, ySize-1), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		QVERIFY(expected == actual);
+		QCOMPARE(double(compressed.value(AMnDIndex(0, 0), 1, AMnDIndex(0))), AMNUMBER_INVALID_FLOATINGPOINT);
+	}
+
+
+	/// Abandons a journal in the middle of a scan, as if the program had crashed, and makes sure the scan can be recovered from what it left behind.
+	void testAMScanJournalRecovery()
+	{
+		QString folder = QDir::tempPath() + "/testAMScanJournal";
+		QString crashedFolder = folder + "/crashed";
+		QDir().mkpath(crashedFolder);
+		foreach(QString fileName, QDir(folder).entryList(QStringList() << "*.amjournal", QDir::Files))
+			QFile::remove(folder + "/" + fileName);
+		foreach(QString fileName, QDir(crashedFolder).entryList(QStringList() << "*.amjournal", QDir::Files))
+			QFile::remove(crashedFolder + "/" + fileName);
+
+		QString liveJournalFilePath = folder + "/abandoned.amjournal";
+		QString journalFilePath = crashedFolder + "/abandoned.amjournal";
+		const int committedRows = 40;
+		const int totalRows = 50;
+		const int channels = 16;
+
+		AMXASScan *scan = new AMXASScan();
+		scan->setName("Journaled Scan");
+		scan->setNumber(7);
+		AMDataStore *store = scan->rawData();
+		store->addScanAxis(AMAxisInfo("eV", 0, "Incident Energy", "eV"));
+		store->addMeasurement(AMMeasurementInfo("tey", "Total Electron Yield"));
+		store->addMeasurement(AMMeasurementInfo("sdd", "SDD Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels)));
+
+		AMScanJournal *journal = new AMScanJournal(scan, liveJournalFilePath);
+		QVERIFY(journal->isValid());
+		journal->setCommitInterval(5);
+
+		QVector<double> spectrum(channels);
+
+		for(int row = 0; row < totalRows; row++){
+
+			// Everything up to here is guaranteed to be on disk; the rest may or may not make it before the "crash".
+			if(row == committedRows)
+				QVERIFY(journal->flush());
+
+			store->beginInsertRows(1, -1);
+			store->setAxisValue(0, row, 250.0 + 0.1*row);
+			store->setValue(AMnDIndex(row), 0, AMnDIndex(), 1.5*row);
+			for(int i = 0; i < channels; i++)
+				spectrum[i] = row*channels + i;
+			store->setValue(AMnDIndex(row), 1, spectrum.constData());
+			store->endInsertRows();
+		}
+
+		// Crash in the middle of the scan: what a dead program leaves behind is whatever the journal file holds right now, while the journal is still open and was never finished.
+		QVERIFY(QFile::copy(liveJournalFilePath, journalFilePath));
+
+		// Abandon the live journal without finishing it.  It leaves its file behind for recovery, just like the crashed one.
+		delete journal;
+		scan->release();
+		QCOMPARE(AMScanJournal::unfinishedJournals(folder), QStringList() << QFileInfo(liveJournalFilePath).absoluteFilePath());
+		QFile::remove(liveJournalFilePath);
+
+		QCOMPARE(AMScanJournal::unfinishedJournals(crashedFolder), QStringList() << QFileInfo(journalFilePath).absoluteFilePath());
+
+		// Chop the last record in half, as if the writer had died during a write.
+		QFile journalFile(journalFilePath);
+		QVERIFY(journalFile.size() > 10);
+		QVERIFY(journalFile.resize(journalFile.size()-5));
+
+		bool finished = true;
+		AMScan *recovered = AMScanJournal::recover(journalFilePath, 0, &finished);
+		QVERIFY(recovered);
+		QVERIFY(!finished);
+		QCOMPARE(QString(recovered->metaObject()->className()), QString("AMXASScan"));
+		QCOMPARE(recovered->name(), QString("Journaled Scan"));
+		QCOMPARE(recovered->number(), 7);
+
+		store = recovered->rawData();
+		QCOMPARE(store->scanAxesCount(), 1);
+		QCOMPARE(store->measurementCount(), 2);
+		QCOMPARE(store->measurementAt(1).name, QString("sdd"));
+		QCOMPARE(store->measurementAt(1).size(0), long(channels));
+		QCOMPARE(recovered->rawDataSourceCount(), 2);
+
+		long rows = store->scanSize(0);
+		QVERIFY(rows >= committedRows);
+		QVERIFY(rows <= totalRows);
+
+		// The last row may have been inserted without its values; every row before it is complete.
+		for(int row = 0; row < rows-1; row++){
+
+			QCOMPARE(double(store->axisValue(0, row)), 250.0 + 0.1*row);
+			QCOMPARE(double(store->value(AMnDIndex(row), 0, AMnDIndex())), 1.5*row);
+			QVERIFY(store->values(AMnDIndex(row), AMnDIndex(row), 1, AMnDIndex(0), AMnDIndex(channels-1), spectrum.data()));
+			for(int i = 0; i < channels; i++)
+				QCOMPARE(spectrum.at(i), double(row*channels + i));
+		}
+
+		recovered->release();
+		QFile::remove(journalFilePath);
+
+		// A journal that finishes normally removes itself, and is never offered for recovery.
+		scan = new AMXASScan();
+		scan->rawData()->addScanAxis(AMAxisInfo("eV", 0, "Incident Energy", "eV"));
+		scan->rawData()->addMeasurement(AMMeasurementInfo("tey", "Total Electron Yield"));
+
+		journal = new AMScanJournal(scan, liveJournalFilePath);
+		QVERIFY(journal->isValid());
+		scan->rawData()->beginInsertRows(1, -1);
+		scan->rawData()->setValue(AMnDIndex(0), 0, AMnDIndex(), 3.0);
+		scan->rawData()->endInsertRows();
+		QVERIFY(journal->flush());
+		QVERIFY(journal->commitCount() > 0);
+		QCOMPARE(AMScanJournal::unfinishedJournals(folder).count(), 1);
+
+		journal->finish();
+		QVERIFY(journal->isFinished());
+		QVERIFY(!QFile::exists(liveJournalFilePath));
+		QVERIFY(AMScanJournal::unfinishedJournals(folder).isEmpty());
+
+		delete journal;
+		scan->release();
+	}
+
+
+	/// Replays a synthetic scan (scaler, MCA spectrum and CCD frame at every point) through AMScanReplayer, its mock detectors and controls, and a receiver that ingests the messages like a scan controller.
+	void testAMScanReplay()
+	{
+		const int points = 20;
+		const int channels = 32;
+		const int width = 8;
+		const int height = 4;
+		const int pointTime = 10;
+
+		AMXASScan *scan = new AMXASScan();
+		AMDataStore *store = scan->rawData();
+		store->addScanAxis(AMAxisInfo("eV", 0, "Incident Energy", "eV"));
+		store->addMeasurement(AMMeasurementInfo("I0", "I0 Scaler"));
+		store->addMeasurement(AMMeasurementInfo("sdd", "SDD Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels)));
+		store->addMeasurement(AMMeasurementInfo("ccd", "CCD Frame", "counts", QList<AMAxisInfo>() << AMAxisInfo("x", width) << AMAxisInfo("y", height)));
+
+		QVector<double> spectrum(channels);
+		QVector<double> frame(width*height);
+		store->beginInsertRows(points, -1);
+		for(int i = 0; i < points; i++){
+			store->setAxisValue(0, i, 400.0 + 0.5*i);
+			store->setValue(AMnDIndex(i), 0, AMnDIndex(), 1000.0 + i);
+			for(int c = 0; c < channels; c++)
+				spectrum[c] = i*channels + c;
+			store->setValue(AMnDIndex(i), 1, spectrum.constData());
+			for(int p = 0; p < width*height; p++)
+				frame[p] = -1.5*i*p;
+			store->setValue(AMnDIndex(i), 2, frame.constData());
+		}
+		store->endInsertRows();
+
+		AMScanReplayRecording recording = AMScanReplayRecording::fromScan(scan, pointTime);
+		QCOMPARE(recording.detectorNames(), QStringList() << "I0" << "sdd" << "ccd");
+		QCOMPARE(recording.controlNames(), QStringList() << "eV");
+		QCOMPARE(recording.detectorReadings("sdd").count(), points);
+		QCOMPARE(recording.detectorAxes("ccd").count(), 2);
+		QCOMPARE(recording.duration(), qint64(points*pointTime));
+
+		// Save and load.
+		QString filePath = QDir::tempPath() + "/testAMScanReplay.amreplay";
+		QVERIFY(recording.save(filePath));
+		AMScanReplayRecording loaded;
+		QVERIFY(loaded.load(filePath));
+		QFile::remove(filePath);
+		QCOMPARE(loaded.eventCount(), recording.eventCount());
+		QVERIFY(loaded.detectorReadings("ccd") == recording.detectorReadings("ccd"));
+
+		// Replay the messages as fast as possible, and check that the receiver ingested the same scan.
+		AMTestReplayReceiver receiver;
+		AMScanReplayer replayer(loaded);
+		replayer.addReceiver(&receiver);
+		replayer.createMocks();
+		replayer.setSpeed(0);
+		QSignalSpy finishedSpy(&replayer, SIGNAL(finished()));
+		QVERIFY(replayer.start());
+		QCOMPARE(finishedSpy.count(), 1);
+		QCOMPARE(replayer.playedEventCount(), loaded.eventCount());
+		QCoreApplication::sendPostedEvents(&receiver, 0);
+		QVERIFY(receiver.isFinished());
+
+		AMDataStore *ingested = receiver.store();
+		QCOMPARE(ingested->scanSize(0), long(points));
+		QCOMPARE(ingested->measurementCount(), 3);
+		QVector<double> expected(points*width*height), actual(points*width*height);
+		for(int m = 0; m < 3; m++){
+			AMMeasurementInfo measurement = store->measurementAt(m);
+			AMnDIndex start = measurement.rank() > 0 ? AMnDIndex(measurement.rank(), AMnDIndex::DoInit, 0) : AMnDIndex();
+			AMnDIndex end = measurement.size();
+			for(int mu = 0; mu < measurement.rank(); mu++)
+				end[mu] = end.at(mu)-1;
+			int count = points*int(measurement.size().product());
+			QCOMPARE(ingested->measurementAt(m).name, measurement.name);
+			QVERIFY(store->values(AMnDIndex(0), AMnDIndex(points-1), m, start, end, expected.data()));
+			QVERIFY(ingested->values(AMnDIndex(0), AMnDIndex(points-1), m, start, end, actual.data()));
+			QVERIFY(memcmp(expected.constData(), actual.constData(), count*sizeof(double)) == 0);
+		}
+		for(int i = 0; i < points; i++)
+			QCOMPARE(double(ingested->axisValue(0, i)), 400.0 + 0.5*i);
+
+		// The mock control followed the recorded values, and can still be moved.
+		AMReplayControl *energy = replayer.controlNamed("eV");
+		QVERIFY(energy);
+		QCOMPARE(energy->value(), 400.0 + 0.5*(points-1));
+		QSignalSpy moveSpy(energy, SIGNAL(moveSucceeded()));
+		QCOMPARE(int(energy->move(250)), int(AMControl::NoFailure));
+		QVERIFY(energy->isMoving());
+		QTest::qWait(20);
+		QCOMPARE(moveSpy.count(), 1);
+		QCOMPARE(energy->value(), 250.0);
+
+		// The mock detectors serve the recorded readings in order, one per acquisition, and fail once they run out.
+		AMReplayDetector *sdd = replayer.detectorNamed("sdd");
+		QVERIFY(sdd);
+		QCOMPARE(sdd->rank(), 1);
+		QCOMPARE(sdd->size(0), channels);
+		QCOMPARE(sdd->remainingReadingCount(), points);
+		QSignalSpy succeededSpy(sdd, SIGNAL(acquisitionSucceeded()));
+		QSignalSpy failedSpy(sdd, SIGNAL(acquisitionFailed()));
+		QVector<double> reading(channels);
+		for(int i = 0; i < points; i++){
+			QVERIFY(sdd->acquire());
+			QTime timeout;
+			timeout.start();
+			while(succeededSpy.count() < i+1 && timeout.elapsed() < 1000)
+				QTest::qWait(1);
+			QCOMPARE(succeededSpy.count(), i+1);
+			QVERIFY(sdd->reading1D(AMnDIndex(0), AMnDIndex(channels-1), reading.data()));
+			QCOMPARE(reading.at(channels-1), double(i*channels + channels-1));
+		}
+		QVERIFY(sdd->acquire());
+		QTest::qWait(20);
+		QCOMPARE(failedSpy.count(), 1);
+		QCOMPARE(sdd->acquiredReadingCount(), points);
+
+		// At 4x speed, the timeline takes (at least) a quarter of the recorded time.
+		AMTestReplayReceiver timedReceiver;
+		AMScanReplayer timedReplayer(recording);
+		timedReplayer.addReceiver(&timedReceiver);
+		timedReplayer.setSpeed(4);
+		QSignalSpy timedFinishedSpy(&timedReplayer, SIGNAL(finished()));
+		QVERIFY(timedReplayer.start());
+		QVERIFY(timedReplayer.isRunning());
+		QTime timeout;
+		timeout.start();
+		while(timedFinishedSpy.count() == 0 && timeout.elapsed() < 5000)
+			QTest::qWait(5);
+		QCOMPARE(timedFinishedSpy.count(), 1);
+		QVERIFY(timedReplayer.elapsedTime() >= points*pointTime/4 - 5);
+		QCoreApplication::sendPostedEvents(&timedReceiver, 0);
+		QVERIFY(timedReceiver.isFinished());
+		QCOMPARE(timedReceiver.store()->scanSize(0), long(points));
+
+		scan->release();
+	}
+
+	/// Runs a scan action controller's step scan against the mock detectors and control of an AMScanReplayer, and checks the scan's raw data and data files against the recording.
+	void testAMScanActionControllerReplay()
+	{
+		const int points = 20;
+		const int channels = 32;
+
+		AMXASScan *scan = new AMXASScan();
+		AMDataStore *store = scan->rawData();
+		store->addScanAxis(AMAxisInfo("eV", 0, "Incident Energy", "eV"));
+		store->addMeasurement(AMMeasurementInfo("I0", "I0 Scaler"));
+		store->addMeasurement(AMMeasurementInfo("sdd", "SDD Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", channels)));
+
+		QVector<double> spectrum(channels);
+		store->beginInsertRows(points, -1);
+		for(int i = 0; i < points; i++){
+			store->setAxisValue(0, i, 400.0 + 0.5*i);
+			store->setValue(AMnDIndex(i), 0, AMnDIndex(), 1000.0 + i);
+			for(int c = 0; c < channels; c++)
+				spectrum[c] = i*channels + c;
+			store->setValue(AMnDIndex(i), 1, spectrum.constData());
+		}
+		store->endInsertRows();
+
+		AMScanReplayer replayer(AMScanReplayRecording::fromScan(scan, 10));
+		replayer.createMocks();
+		replayer.setSpeed(0);
+		QList<AMDetector*> detectors;
+		detectors << replayer.detectorNamed("I0") << replayer.detectorNamed("sdd");
+		QVERIFY(detectors.at(0) && detectors.at(1));
+		QVERIFY(replayer.controlNamed("eV"));
+
+		QString filePath = QDir::tempPath() + "/testAMScanActionControllerReplay";
+		QFile::remove(filePath + ".dat");
+		QFile::remove(filePath + "_spectra.dat");
+
+		amTestScanActionsHandler();
+		AMTestStepScanActionController *controller = new AMTestStepScanActionController(replayer.controlNamed("eV"), detectors, AMScanAxisRegion(400.0, 0.5, 409.5, 1.0), filePath);
+		QVERIFY(controller->actionTree());
+		QVERIFY(controller->initialize());
+		QVERIFY(controller->start());
+
+		QTime timeout;
+		timeout.start();
+		while(!controller->isFinished() && !controller->isFailed() && timeout.elapsed() < 10000)
+			QTest::qWait(10);
+		QVERIFY(controller->isFinished());
+
+		// Every recorded reading was acquired once, and the scan holds the recording.
+		QCOMPARE(replayer.detectorNamed("I0")->acquiredReadingCount(), points);
+		QCOMPARE(replayer.detectorNamed("sdd")->remainingReadingCount(), 0);
+
+		AMDataStore *rawData = controller->scan()->rawData();
+		QCOMPARE(rawData->scanSize(0), long(points));
+		QCOMPARE(rawData->measurementCount(), 2);
+		QVector<double> expected(points*channels), actual(points*channels);
+		for(int i = 0; i < points; i++){
+			QCOMPARE(double(rawData->axisValue(0, i)), 400.0 + 0.5*i);
+			QCOMPARE(double(rawData->value(AMnDIndex(i), 0, AMnDIndex())), 1000.0 + i);
+		}
+		QVERIFY(store->values(AMnDIndex(0), AMnDIndex(points-1), 1, AMnDIndex(0), AMnDIndex(channels-1), expected.data()));
+		QVERIFY(rawData->values(AMnDIndex(0), AMnDIndex(points-1), 1, AMnDIndex(0), AMnDIndex(channels-1), actual.data()));
+		QVERIFY(expected == actual);
+
+		// The data files have one line per point.
+		QFile dataFile(filePath + ".dat");
+		QVERIFY(dataFile.open(QIODevice::ReadOnly | QIODevice::Text));
+		QStringList dataLines = QString(dataFile.readAll()).split("\n", QString::SkipEmptyParts);
+		QCOMPARE(dataLines.count(), points);
+		for(int i = 0; i < points; i++)
+			QCOMPARE(dataLines.at(i), QString("%1 %2 ").arg(400.0 + 0.5*i).arg(1000.0 + i));
+
+		QFile spectraFile(filePath + "_spectra.dat");
+		QVERIFY(spectraFile.open(QIODevice::ReadOnly | QIODevice::Text));
+		QStringList spectraLines = QString(spectraFile.readAll()).split("\n", QString::SkipEmptyParts);
+		QCOMPARE(spectraLines.count(), points);
+		for(int i = 0; i < points; i++){
+			QStringList values = spectraLines.at(i).split(" ", QString::SkipEmptyParts);
+			QCOMPARE(values.count(), channels);
+			QCOMPARE(values.first().toDouble(), double(i*channels));
+			QCOMPARE(values.last().toDouble(), double(i*channels + channels-1));
+		}
+
+		dataFile.close();
+		spectraFile.close();
+		QFile::remove(filePath + ".dat");
+		QFile::remove(filePath + "_spectra.dat");
+
+		delete controller;
+		scan->release();
+	}
+
+
+	/// Tests that an AM1DIntegralAB running on the analysis thread (AMThreadedAnalysisBlock) always produces results for a complete, consistent copy of its input, while the input keeps growing on this thread.
+	void testAMThreadedAnalysisBlock()
+	{
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("x", 0, "x axis")));
+		QVERIFY(store.addMeasurement(AMMeasurementInfo("signal", "Signal")));
+
+		const int rounds = 200;
+		const int rowsPerRound = 2000;
+		QVector<double> x, f;
+
+		AMRawDataSource *rawSource = new AMRawDataSource(&store, 0);
+		AM1DIntegralAB *integral = new AM1DIntegralAB("integral");
+		AM1DIntegralAB reference("reference");
+		QVERIFY(integral->setInputDataSources(QList<AMDataSource*>() << rawSource));
+		QVERIFY(reference.setInputDataSources(QList<AMDataSource*>() << rawSource));
+
+		AMThreadedAnalysisBlock *threaded = new AMThreadedAnalysisBlock(integral);
+		QVERIFY(integral->thread() == AMThreadedAnalysisBlock::analysisThread());
+		QVERIFY(integral->signalSource()->thread() == AMThreadedAnalysisBlock::analysisThread());
+
+		AMDataSource *output = threaded->output();
+		QCOMPARE(output->rank(), 1);
+		QCOMPARE(output->name(), QString("integral"));
+
+		int lastCompletedUpdateCount = 0;
+
+		for(int round = 0; round < rounds; round++) {
+
+			QVERIFY(store.beginInsertRows(rowsPerRound, -1));
+			for(int row = 0; row < rowsPerRound; row++) {
+
+				int i = x.count();
+				x << 250.0 + i*0.001 + (i%3)*0.0001;
+				f << sin(i/1000.0)*100 + i%7;
+				store.setAxisValue(0, i, x.last());
+				store.setValue(AMnDIndex(i), 0, AMnDIndex(), f.last());
+			}
+			store.endInsertRows();
+
+			// Let results come back while the input is still growing.  Each one must match some prefix of the input exactly.
+			QCoreApplication::processEvents();
+
+			// The first result can come from the empty input the block was handed over with; the integral needs at least 2 points.
+			if(threaded->completedUpdateCount() != lastCompletedUpdateCount && output->isValid() && output->size(0) >= 2) {
+
+				lastCompletedUpdateCount = threaded->completedUpdateCount();
+				QVERIFY(amTestIntegralMatchesPrefix(output, x, f));
+			}
+		}
+
+		QTime timer;
+		timer.start();
+		while(!threaded->isUpToDate() && timer.elapsed() < 30000)
+			QTest::qWait(10);
+
+		QVERIFY(threaded->isUpToDate());
+		QCOMPARE(output->size(0), x.count());
+		QVERIFY(amTestIntegralMatchesPrefix(output, x, f));
+
+		// The same block on this thread gives the same answer.
+		QVector<double> expected(x.count()), actual(x.count());
+		QVERIFY(reference.values(AMnDIndex(0), AMnDIndex(x.count()-1), expected.data()));
+		QVERIFY(output->values(AMnDIndex(0), AMnDIndex(x.count()-1), actual.data()));
+		for(int i = 0; i < x.count(); i++)
+			QVERIFY(fabs(actual.at(i) - expected.at(i)) < 1e-9*qMax(1.0, fabs(expected.at(i))));
+
+		reference.setInputDataSources(QList<AMDataSource*>());
+		delete threaded;
+		delete rawSource;
+		AMThreadedAnalysisBlock::releaseAnalysisThread();
+	}
+
+	/// Tests that AMThreadedAnalysisBlock::createForCopyOf() (used by AMScanView to plot expensive blocks) runs a copy of an AM3DBinningAB that gives the same answer as the original, and follows changes to the original's settings.
+	void testAMThreadedAnalysisBlockCopy()
+	{
+		AMInMemoryDataStore store;
+		QVERIFY(store.addScanAxis(AMAxisInfo("x", 0, "x axis")));
+		QVERIFY(store.addScanAxis(AMAxisInfo("y", 0, "y axis")));
+		QVERIFY(store.addMeasurement(AMMeasurementInfo("spectrum", "Spectrum", "counts", QList<AMAxisInfo>() << AMAxisInfo("channel", 50, "Channel"))));
+
+		const int xSize = 6, ySize = 4, channels = 50;
+		QVector<double> spectrum(channels);
+		QVERIFY(store.beginInsertRows(xSize, -1));
+		for(int x = 0; x < xSize; x++) {
+			for(int y = 0; y < ySize; y++) {
+				for(int c = 0; c < channels; c++)
+					spectrum[c] = x*1000 + y*100 + c;
+				store.setValue(AMnDIndex(x, y), 0, spectrum.constData());
+			}
+		}
+		store.endInsertRows();
+
+		AMRawDataSource *rawSource = new AMRawDataSource(&store, 0);
+
+		// Cheap blocks aren't copied.
+		AM1DIntegralAB integral("integral");
+		QVERIFY(AMThreadedAnalysisBlock::createForCopyOf(&integral) == 0);
+
+		AM3DBinningAB original("binned");
+		original.setSumRangeMin(10);
+		original.setSumRangeMax(30);
+		QVERIFY(original.setInputDataSources(QList<AMDataSource*>() << rawSource));
+		QVERIFY(original.isValid());
+
+		AMThreadedAnalysisBlock *threaded = AMThreadedAnalysisBlock::createForCopyOf(&original);
+		QVERIFY(threaded);
+		QVERIFY(threaded->original() == &original);
+		QVERIFY(threaded->block() != &original);
+		QVERIFY(threaded->block()->thread() == AMThreadedAnalysisBlock::analysisThread());
+		QVERIFY(original.thread() == QThread::currentThread());
+
+		AMDataSource *output = threaded->output();
+		QCOMPARE(output->rank(), 2);
+
+		for(int round = 0; round < 2; round++) {
+
+			// The second round checks that a new setting on the original reaches the copy.
+			if(round == 1)
+				original.setSumRangeMax(20);
+
+			QVERIFY(!threaded->isUpToDate());
+
+			QTime timer;
+			timer.start();
+			while(!threaded->isUpToDate() && timer.elapsed() < 30000)
+				QTest::qWait(10);
+
+			QVERIFY(threaded->isUpToDate());
+			QCOMPARE(output->size(0), xSize);
+			QCOMPARE(output->size(1), ySize);
+
+			for(int x = 0; x < xSize; x++)
+				for(int y = 0; y < ySize; y++)
+					QCOMPARE(double(output->value(AMnDIndex(x, y))), double(original.value(AMnDIndex(x, y))));
+		}
+
+		delete threaded;
+		original.setInputDataSources(QList<AMDataSource*>());
+		delete rawSource;
+		AMThreadedAnalysisBlock::releaseAnalysisThread();
+	}
+
+
+
+	/// Tests that a parallel export of scans from the database (AMExportController::setParallelExportEnabled()) writes exactly the same files, byte for byte, as the serial export.
+	void testAMExportControllerParallel()
+	{
+		amTestRegisterExportFileLoader();
+
+		AMDatabase *db = AMDatabase::database("user");
+		QList<QUrl> scanUrls;
+
+		for(int k = 0; k < 8; k++) {
+			AMScan *scan = new AMScan();
+			scan->setName(QString("parallelExportTest%1").arg(k));
+			scan->setNumber(k+1);
+			scan->setFileFormat("amTestExport");
+			scan->setFilePath(QString("parallelExportTest/%1").arg(k));
+			QVERIFY(AMTestExportFileLoader().load(scan, QString(), 0));
+			QVERIFY(scan->addRawDataSource(new AMRawDataSource(scan->rawData(), 0)));
+			QVERIFY(scan->addRawDataSource(new AMRawDataSource(scan->rawData(), 1)));
+			QVERIFY(scan->storeToDb(db));
+
+			scanUrls << QUrl(QString("amd://user/%1/%2").arg(scan->dbTableName()).arg(scan->id()));
+			scan->release();
+		}
+
+		QMap<QString, QByteArray> serialFiles = amTestExportScans(scanUrls, QDir::tempPath() + "/testAMExportControllerSerial", false);
+		QMap<QString, QByteArray> parallelFiles = amTestExportScans(scanUrls, QDir::tempPath() + "/testAMExportControllerParallel", true);
+
+		QVERIFY(serialFiles.count() >= scanUrls.count());
+		QCOMPARE(parallelFiles.keys(), serialFiles.keys());
+		foreach(QString fileName, serialFiles.keys())
+			QVERIFY(parallelFiles.value(fileName) == serialFiles.value(fileName));
+
+		// Every scan really made it through the loader.
+		QVERIFY(serialFiles.value("parallelExportTest7_7.txt").contains("701.75"));
+
+		// $fsIndex numbers and stores the scans as they are written, so it always uses the serial export.
+		AMExportController *controller = new AMExportController(scanUrls);
+		controller->setDestinationFolderPath(QDir::tempPath() + "/testAMExportControllerFsIndex");
+		controller->setParallelExportEnabled(true);
+		QVERIFY(controller->chooseExporter("AMExporterGeneralAscii"));
+		AMExporterOption *option = controller->exporter()->createDefaultOption();
+		option->setFileName("$name_$fsIndex.txt");
+		controller->setOption(option);
+
+		QPointer<AMExportController> running(controller);
+		QVERIFY(controller->start());
+		QVERIFY(controller->parallelExportEnabled());
+		QVERIFY(!controller->parallelExportActive());
+
+		QVERIFY(controller->cancel());
+		QTime timer;
+		timer.start();
+		while(running && timer.elapsed() < 30000)
+			QTest::qWait(10);
+		QVERIFY(!running);
+	}
+
+
+	/// Tests that AMActionLogQueue3 writes the same logs as AMActionLog3::logCompletedAction(), but in one transaction per flush, and times both paths.
+	void testAMActionLogQueue3()
+	{
+		AMDbObjectSupport::s()->registerClass<AMActionInfo3>();
+		AMDbObjectSupport::s()->registerClass<AMActionLog3>();
+
+		QString fileName = QDir::tempPath() + "/testAMActionLogQueue3.db";
+		QFile::remove(fileName);
+		AMDatabase* db = AMDatabase::createDatabase("actionLogQueueTest", fileName);
+		QVERIFY(db);
+		QVERIFY(AMDbObjectSupport::s()->registerDatabase(db));
+		QString logTable = AMDbObjectSupport::s()->tableNameForClass<AMActionLog3>();
+
+		const int actionCount = 500;
+		QList<AMAction3*> actions;
+		for(int i = 0; i < actionCount; i++) {
+			AMAction3* action = new AMTestLogAction(new AMActionInfo3(QString("Test action %1").arg(i)));
+			QVERIFY(action->start());
+			QVERIFY(action->inFinalState());
+			actions << action;
+		}
+
+		// Unbatched: every log is its own transaction.
+		QTime time;
+		time.start();
+		for(int i = 0; i < actionCount; i++)
+			QVERIFY(AMActionLog3::logCompletedAction(actions.at(i), db, 7));
+		int unbatchedTime = time.elapsed();
+		QCOMPARE(db->objectsWhere(logTable).count(), actionCount);
+
+		// Batched: nothing is written until the queue is flushed, and then everything goes in one transaction.
+		AMActionLogQueue3* queue = AMActionLogQueue3::queue();
+		QVERIFY(queue->flush());
+		queue->setFlushInterval(60000);
+		queue->setMaximumQueuedLogs(actionCount+1);
+		int loggedBefore = queue->loggedActionCount();
+		int committedBefore = queue->committedTransactionCount();
+
+		time.restart();
+		for(int i = 0; i < actionCount; i++)
+			QVERIFY(AMActionLog3::queueCompletedAction(actions.at(i), db, 7));
+		QCOMPARE(queue->queuedLogCount(), actionCount);
+		QCOMPARE(db->objectsWhere(logTable).count(), actionCount);
+
+		// The queued logs own copies of the infos, so the actions can go away before the flush.
+		qDeleteAll(actions);
+		actions.clear();
+
+		QVERIFY(queue->flush());
+		int batchedTime = time.elapsed();
+
+		QCOMPARE(queue->queuedLogCount(), 0);
+		QCOMPARE(queue->loggedActionCount() - loggedBefore, actionCount);
+		QCOMPARE(queue->committedTransactionCount() - committedBefore, 1);
+
+		QList<int> logIds = db->objectsWhere(logTable);
+		QCOMPARE(logIds.count(), 2*actionCount);
+		QCOMPARE(db->retrieve(logIds.last(), logTable, "parentId").toInt(), 7);
+		AMActionLog3 lastLog;
+		QVERIFY(lastLog.loadFromDb(db, logIds.last()));
+		QCOMPARE(lastLog.name(), QString("Test action %1").arg(actionCount-1));
+
+		qDebug() << "Logging" << actionCount << "completed actions took" << unbatchedTime << "ms one at a time and" << batchedTime << "ms through the queue.";
+
+		// Reaching maximumQueuedLogs() flushes right away; the rest wait for the timer.
+		queue->setMaximumQueuedLogs(100);
+		queue->setFlushInterval(50);
+		committedBefore = queue->committedTransactionCount();
+		for(int i = 0; i < 250; i++) {
+			AMTestLogAction action(new AMActionInfo3(QString("Threshold action %1").arg(i)));
+			QVERIFY(action.start());
+			QVERIFY(queue->enqueueCompletedAction(&action, db));
+		}
+		QCOMPARE(queue->queuedLogCount(), 50);
+		QCOMPARE(queue->committedTransactionCount() - committedBefore, 2);
+
+		QTime timeout;
+		timeout.start();
+		while(queue->queuedLogCount() > 0 && timeout.elapsed() < 5000)
+			QTest::qWait(10);
+		QCOMPARE(queue->queuedLogCount(), 0);
+		QCOMPARE(queue->committedTransactionCount() - committedBefore, 3);
+		QCOMPARE(db->objectsWhere(logTable).count(), 2*actionCount + 250);
+
+		queue->setFlushInterval(1000);
+		queue->setMaximumQueuedLogs(200);
+
+		AMDatabase::deleteDatabase("actionLogQueueTest");
+		QFile::remove(fileName);
+	}
 
 };
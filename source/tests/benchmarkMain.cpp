@@ -0,0 +1,123 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QApplication>
+#include <QtTest/QtTest>
+#include <QFile>
+#include <QXmlStreamReader>
+#include <QTextStream>
+#include "util/AMSettings.h"
+#include "tests/BenchmarkDataman.h"
+
+#include "application/AMDatamanAppController.h"
+
+/// Reads the benchmark results from a QTest XML log (-xml) into \c results, as the time (or other metric) per iteration, keyed by "function[data row]".  Returns false if the file can't be read.
+static bool readBenchmarkResults(const QString &fileName, QMap<QString, double> &results, QMap<QString, QString> &metrics)
+{
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QXmlStreamReader xml(&file);
+	QString functionName;
+
+	while(!xml.atEnd()) {
+		xml.readNext();
+
+		if(!xml.isStartElement())
+			continue;
+
+		if(xml.name() == "TestFunction")
+			functionName = xml.attributes().value("name").toString();
+
+		else if(xml.name() == "BenchmarkResult") {
+			QString key = QString("%1[%2]").arg(functionName).arg(xml.attributes().value("tag").toString());
+			double iterations = xml.attributes().value("iterations").toString().toDouble();
+			double value = xml.attributes().value("value").toString().toDouble();
+
+			results.insert(key, iterations > 0 ? value/iterations : value);
+			metrics.insert(key, xml.attributes().value("metric").toString());
+		}
+	}
+
+	return !xml.hasError();
+}
+
+/// Prints a table comparing the results in \c oldFileName and \c newFileName, with the ratio new/old for every benchmark found in both.  Returns 0 on success.
+static int compareBenchmarkResults(const QString &oldFileName, const QString &newFileName)
+{
+	QMap<QString, double> oldResults, newResults;
+	QMap<QString, QString> oldMetrics, newMetrics;
+	QTextStream out(stdout);
+
+	if(!readBenchmarkResults(oldFileName, oldResults, oldMetrics) || !readBenchmarkResults(newFileName, newResults, newMetrics)) {
+		out << "Could not read the benchmark results in " << oldFileName << " and " << newFileName << ".\n";
+		return -1;
+	}
+
+	out << "benchmark\tmetric\told\tnew\tnew/old\n";
+	foreach(QString key, newResults.keys()) {
+		if(!oldResults.contains(key) || oldMetrics.value(key) != newMetrics.value(key))
+			continue;
+
+		double oldValue = oldResults.value(key);
+		double newValue = newResults.value(key);
+		out << key << "\t" << newMetrics.value(key) << "\t" << oldValue << "\t" << newValue << "\t" << (oldValue > 0 ? QString::number(newValue/oldValue, 'f', 3) : QString("-")) << "\n";
+	}
+
+	return 0;
+}
+
+/// Runs the QBENCHMARK performance suite.
+/*! Usage:
+
+- AcquamanBenchmark [QTest options]: runs the benchmarks.  With no options, the results are written to AcquamanBenchmark.xml in the current folder, in QTest's XML format.  Any other QTest options (ex: -xml -o results.xml, -callgrind, -tickcounter, or the name of a single benchmark) are passed through as they are.
+- AcquamanBenchmark -compare old.xml new.xml: prints a tab-separated table comparing two saved result files (ex: from before and after a commit), with the ratio new/old for every benchmark and data row.
+*/
+int main(int argc, char *argv[])
+{
+	if(argc == 4 && QString(argv[1]) == "-compare") {
+		QCoreApplication app(argc, argv);
+		return compareBenchmarkResults(argv[2], argv[3]);
+	}
+
+	/// Program Startup:
+	// =================================
+	QApplication app(argc, argv);
+	app.setApplicationName("AcquamanBenchmark");
+
+	// ensure user data folder and database are ready for use, if this is the first time the program is ever run.
+	AMDatamanAppController ac;
+	if(!ac.startup())
+		return -1;
+
+	QStringList arguments = app.arguments();
+	if(arguments.count() == 1)
+		arguments << "-xml" << "-o" << "AcquamanBenchmark.xml";
+
+	/// Benchmark Running
+	// =================================
+
+	BenchmarkDataman bd;
+	int retVal = QTest::qExec(&bd, arguments);
+
+	AMDatabase::deleteDatabase("user");
+
+	return retVal;
+}
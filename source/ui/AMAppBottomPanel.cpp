@@ -6,4 +6,7 @@ AMAppBottomPanel::AMAppBottomPanel(AMActionRunner3 *actionRunner, QWidget *paren
 	workflowView_ = new AMActionRunnerBottomBarCurrentView3(actionRunner);
 	layout_->insertStretch(2);
 	layout_->insertWidget(3, workflowView_);
+
+	beamlineConnectionView_ = new AMBeamlineConnectionView;
+	layout_->insertWidget(5, beamlineConnectionView_);
 }
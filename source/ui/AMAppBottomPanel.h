@@ -4,6 +4,7 @@
 #include "ui/AMDatamanAppBottomPanel.h"
 #include "ui/actions3/AMActionRunnerBottomBarCurrentView3.h"
 #include "actions3/AMActionRunner3.h"
+#include "ui/beamline/AMBeamlineConnectionView.h"
 
 /// This class implements the bottom panel used in the standard App for AM.  It contains a mini-view of the workflow and adds it between the add experiment button and the status view.
 class AMAppBottomPanel : public AMDatamanAppBottomPanel
@@ -14,9 +15,14 @@ public:
 	/// Constructor.  Passes in the action runner to appropriately build the mini-workflow view.
 	AMAppBottomPanel(AMActionRunner3 *actionRunner, QWidget *parent = 0);
 
+	/// Sets the beamline whose connection progress is shown next to the status view.
+	void setBeamline(AMBeamline *beamline) { beamlineConnectionView_->setBeamline(beamline); }
+
 protected:
 	/// The current workflow view.
 	AMActionRunnerBottomBarCurrentView3 *workflowView_;
+	/// Shows the beamline controls that are still connecting.  Hidden when they are all connected.
+	AMBeamlineConnectionView *beamlineConnectionView_;
 };
 
 #endif // AMAPPBOTTOMPANEL_H
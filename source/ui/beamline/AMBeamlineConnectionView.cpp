@@ -0,0 +1,88 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMBeamlineConnectionView.h"
+
+#include <QLabel>
+#include <QProgressBar>
+#include <QHBoxLayout>
+
+#include "beamline/AMBeamline.h"
+
+AMBeamlineConnectionView::AMBeamlineConnectionView(AMBeamline *beamline, QWidget *parent)
+	: QWidget(parent)
+{
+	beamline_ = 0;
+
+	label_ = new QLabel("Connecting beamline");
+	progressBar_ = new QProgressBar;
+	progressBar_->setFormat("%v of %m controls");
+	progressBar_->setMaximumWidth(200);
+
+	QHBoxLayout *layout = new QHBoxLayout;
+	layout->setContentsMargins(0, 0, 0, 0);
+	layout->addWidget(label_);
+	layout->addWidget(progressBar_);
+	setLayout(layout);
+
+	setVisible(false);
+	setBeamline(beamline);
+}
+
+void AMBeamlineConnectionView::setBeamline(AMBeamline *beamline)
+{
+	if(beamline_)
+		disconnect(beamline_, 0, this, 0);
+
+	beamline_ = beamline;
+
+	if(beamline_){
+
+		connect(beamline_, SIGNAL(controlConnectionProgressChanged(int,int)), this, SLOT(onControlConnectionProgressChanged(int,int)));
+		connect(beamline_, SIGNAL(destroyed()), this, SLOT(onBeamlineDestroyed()));
+		onControlConnectionProgressChanged(beamline_->connectedControlCount(), beamline_->controlCount());
+	}
+
+	else
+		setVisible(false);
+}
+
+void AMBeamlineConnectionView::onControlConnectionProgressChanged(int connectedCount, int totalCount)
+{
+	progressBar_->setRange(0, totalCount);
+	progressBar_->setValue(connectedCount);
+
+	QStringList unconnected = beamline_->unconnectedControlNames();
+	int shownNames = qMin(unconnected.count(), 20);
+	QString toolTip = QString("Waiting for:\n %1").arg(QStringList(unconnected.mid(0, shownNames)).join("\n "));
+
+	if(shownNames < unconnected.count())
+		toolTip.append(QString("\n ... and %1 more").arg(unconnected.count()-shownNames));
+
+	setToolTip(toolTip);
+
+	// Before the beamline has found its controls, there's nothing to show yet.
+	setVisible(totalCount > 0 && connectedCount < totalCount);
+}
+
+void AMBeamlineConnectionView::onBeamlineDestroyed()
+{
+	beamline_ = 0;
+	setVisible(false);
+}
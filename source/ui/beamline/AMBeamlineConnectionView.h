@@ -0,0 +1,62 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMBEAMLINECONNECTIONVIEW_H
+#define AMBEAMLINECONNECTIONVIEW_H
+
+#include <QWidget>
+
+class QLabel;
+class QProgressBar;
+class AMBeamline;
+
+/// This small widget shows how many of a beamline's controls have connected, while some of them are still missing.
+/*! The beamline is created without waiting for its PVs, so the rest of the application is usable while they come up.  This view shows a progress bar with the connected count, and lists the controls that are still missing in its tool tip.  It hides itself whenever every control is connected (and reappears if one drops out later).  It can be placed in the bottom panel; see AMAppBottomPanel. */
+class AMBeamlineConnectionView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.  \c beamline can be 0, and set later using setBeamline().
+	explicit AMBeamlineConnectionView(AMBeamline *beamline = 0, QWidget *parent = 0);
+
+	/// Returns the beamline being watched.
+	AMBeamline *beamline() const { return beamline_; }
+
+public slots:
+	/// Sets the beamline whose control connections are shown.
+	void setBeamline(AMBeamline *beamline);
+
+protected slots:
+	/// Updates the progress bar, the tool tip, and the visibility.
+	void onControlConnectionProgressChanged(int connectedCount, int totalCount);
+	/// Forgets the beamline when it is released.
+	void onBeamlineDestroyed();
+
+protected:
+	/// The beamline being watched.
+	AMBeamline *beamline_;
+
+	/// Shows "Connecting beamline".
+	QLabel *label_;
+	/// Shows the connected count out of the total.
+	QProgressBar *progressBar_;
+};
+
+#endif // AMBEAMLINECONNECTIONVIEW_H
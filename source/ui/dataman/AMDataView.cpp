@@ -22,12 +22,14 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "dataman/database/AMDatabase.h"
 #include "dataman/database/AMDbObjectSupport.h"
+#include "dataman/database/AMDbSearchIndex.h"
 #include "util/AMErrorMonitor.h"
 #include "util/AMDateTimeUtils.h"
 #include "dataman/AMUser.h"
 #include "dataman/AMScan.h"
 
 #include <QScrollBar>
+#include <QLineEdit>
 #include <QApplication>
 #include <QStringBuilder>
 
@@ -103,6 +105,23 @@ AMDataView::AMDataView(AMDatabase* database, QWidget *parent) :
 	connect(viewModeButtonGroup_, SIGNAL(buttonClicked(int)), this, SLOT(setViewMode(int)));
 	connect(organizeModeBox_, SIGNAL(currentIndexChanged(int)), this, SLOT(onOrganizeModeBoxCurrentIndexChanged(int)));
 
+	// add the search box, if this database can be searched:
+	/////////////////////////////
+	searchEdit_ = 0;
+	searchIndex_ = AMDbSearchIndex::searchIndex(db_, scansTableName_);
+	if(searchIndex_ && !searchIndex_->isValid())
+		searchIndex_ = 0;
+
+	if(searchIndex_) {
+		searchEdit_ = new QLineEdit();
+		searchEdit_->setPlaceholderText("Search names, notes, samples");
+		searchEdit_->setMaximumWidth(220);
+		horizontalLayout_2->insertWidget(3, searchEdit_);
+		connect(searchEdit_, SIGNAL(textChanged(QString)), this, SLOT(onSearchEditTextChanged()));
+		connect(searchEdit_, SIGNAL(returnPressed()), this, SLOT(applySearchEditText()));
+		connect(&searchFnCall_, SIGNAL(executed()), this, SLOT(applySearchEditText()));
+	}
+
 
 	// pick up database changes...
 	//////////////////////////////
@@ -319,6 +338,9 @@ void AMDataView::refreshView() {
 
 	refreshOrganizeModeBox();
 
+	// Searching narrows down every section below. (This also writes any pending changes to the search index, so new scans are found.)
+	searchWhereClause_ = (searchIndex_ && !searchText_.isEmpty()) ? searchIndex_->whereClause(searchText_) : QString();
+
 	// what we do from here depends on what we're showing (ie: run or experiment? all or just one?), as well as the organize mode.
 
 	// Showing runs - all runs, or experiments - all experiments
@@ -335,7 +357,7 @@ void AMDataView::refreshView() {
 			AMDataViewSection* section = new AMDataViewSection(
 						userName_ + "Data",
 						"Showing all data",
-						QString(),
+						sectionWhereClause(QString()),
 						viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 			connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -369,7 +391,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								fullRunName,
 								"Showing all data from this run",
-								QString("runId = '%1'").arg(runId),
+								sectionWhereClause(QString("runId = '%1'").arg(runId)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -408,7 +430,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								expName,
 								"Showing all data from this experiment",
-								QString("id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%1')").arg(expId),
+								sectionWhereClause(QString("id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%1')").arg(expId)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -445,7 +467,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								typeDescription,
 								"Showing all " + typeDescription,
-								QString("AMDbObjectType = '%1'").arg(className),
+								sectionWhereClause(QString("AMDbObjectType = '%1'").arg(className)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -485,7 +507,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								name,
 								"Sample created " + AMDateTimeUtils::prettyDateTime(dt),
-								QString("sampleId = '%1'").arg(sampleId),
+								sectionWhereClause(QString("sampleId = '%1'").arg(sampleId)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -525,7 +547,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								symbol + ": " + name,
 								QString("Showing all data from samples containing %1").arg(name),
-								QString("sampleId IN (SELECT sampleId FROM SampleElementEntries WHERE elementId = '%1')").arg(elementId),
+								sectionWhereClause(QString("sampleId IN (SELECT sampleId FROM SampleElementEntries WHERE elementId = '%1')").arg(elementId)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -573,7 +595,7 @@ void AMDataView::refreshView() {
 				AMDataViewSection* section = new AMDataViewSection(
 							fullRunName,
 							"Showing all data from this run",
-							QString("runId = '%1'").arg(runId_),
+							sectionWhereClause(QString("runId = '%1'").arg(runId_)),
 							viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 				connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -604,7 +626,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								expName,
 								QString("Showing all data from this experiment in the <i>%1</i> run").arg(fullRunName),
-								QString("runId = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(runId_).arg(expId),
+								sectionWhereClause(QString("runId = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(runId_).arg(expId)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -642,7 +664,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								typeDescription,
 								QString("Showing all data of this type in the <i>%1</i> run").arg(fullRunName),
-								QString("AMDbObjectType = '%1' AND runId = '%2'").arg(className).arg(runId_),
+								sectionWhereClause(QString("AMDbObjectType = '%1' AND runId = '%2'").arg(className).arg(runId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -683,7 +705,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								name,
 								QString("Sample created %1.  Showing all data from this sample in the <i>%2</i> run").arg(AMDateTimeUtils::prettyDateTime(dt)).arg(fullRunName),
-								QString("sampleId = '%1' AND runId = '%2'").arg(sampleId).arg(runId_),
+								sectionWhereClause(QString("sampleId = '%1' AND runId = '%2'").arg(sampleId).arg(runId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -724,7 +746,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								symbol + ": " + name,
 								QString("Showing all data from samples containing %1 in the <i>%2</i> run").arg(name).arg(fullRunName),
-								QString("sampleId IN (SELECT sampleId FROM SampleElementEntries WHERE elementId = '%1') AND runId = '%2'").arg(elementId).arg(runId_),
+								sectionWhereClause(QString("sampleId IN (SELECT sampleId FROM SampleElementEntries WHERE elementId = '%1') AND runId = '%2'").arg(elementId).arg(runId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -771,7 +793,7 @@ void AMDataView::refreshView() {
 			AMDataViewSection* section = new AMDataViewSection(
 						expName,
 						"Showing all data from this experiment",
-						QString("id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%1')").arg(experimentId_),
+						sectionWhereClause(QString("id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%1')").arg(experimentId_)),
 						viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 			connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -805,7 +827,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								fullRunName,
 								QString("Showing all data from this run in the <i>%1</i> experiment").arg(expName),
-								QString("runId = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(runId).arg(experimentId_),
+								sectionWhereClause(QString("runId = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(runId).arg(experimentId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -846,7 +868,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								typeDescription,
 								QString("Showing all data of this type in the <i>%1</i> experiment").arg(expName),
-								QString("AMDbObjectType = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(className).arg(experimentId_),
+								sectionWhereClause(QString("AMDbObjectType = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(className).arg(experimentId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -888,7 +910,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								name,
 								QString("Sample created %1.  Showing all data from this sample in the <i>%2</i> experiment").arg(AMDateTimeUtils::prettyDateTime(dt)).arg(expName),
-								QString("sampleId = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(sampleId).arg(experimentId_),
+								sectionWhereClause(QString("sampleId = '%1' AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(sampleId).arg(experimentId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -929,7 +951,7 @@ void AMDataView::refreshView() {
 					AMDataViewSection* section = new AMDataViewSection(
 								symbol + ": " + name,
 								QString("Showing all data from samples containing %1 in the <i>%2</i> experiment").arg(name).arg(expName),
-								QString("sampleId IN (SELECT sampleId FROM SampleElementEntries WHERE elementId = '%1') AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(elementId).arg(experimentId_),
+								sectionWhereClause(QString("sampleId IN (SELECT sampleId FROM SampleElementEntries WHERE elementId = '%1') AND id IN (SELECT objectId FROM ObjectExperimentEntries WHERE experimentId = '%2')").arg(elementId).arg(experimentId_)),
 								viewMode_, db_, true, gwidget_, effectiveWidth(), itemSize_);
 					connect(gview_->verticalScrollBar(), SIGNAL(valueChanged(int)), section, SLOT(layoutHeaderItem()));
 
@@ -1026,6 +1048,41 @@ void AMDataView::setItemSize(int newItemSize)
 	}
 }
 
+void AMDataView::setSearchText(const QString &searchText)
+{
+	QString trimmedText = searchText.trimmed();
+
+	if(!searchIndex_ || trimmedText == searchText_)
+		return;
+
+	searchText_ = trimmedText;
+	refreshView();
+}
+
+void AMDataView::onSearchEditTextChanged()
+{
+	searchFnCall_.runLater(300);
+}
+
+void AMDataView::applySearchEditText()
+{
+	searchFnCall_.cancelRunLater();
+
+	if(searchEdit_)
+		setSearchText(searchEdit_->text());
+}
+
+QString AMDataView::sectionWhereClause(const QString &whereClause) const
+{
+	if(searchWhereClause_.isEmpty())
+		return whereClause;
+
+	if(whereClause.isEmpty())
+		return searchWhereClause_;
+
+	return "(" % whereClause % ") AND " % searchWhereClause_;
+}
+
 void AMDataView::expandAll()
 {
 	foreach(AMAbstractDataViewSection* s, sections_) {
@@ -36,6 +36,9 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QUrl>
 #include "ui/dataman/AMFlowGraphicsLayout.h"
 
+class QLineEdit;
+class AMDbSearchIndex;
+
 
 
 /// This subclass of QGraphicsWidget is designed to resize itself to the preferred sizeHint() of its layout.  (This is the opposite of what usually happens: layouts resize themselves to match the size of their widget.)
@@ -169,6 +172,9 @@ public slots:
 	/// Called when the item size slider is moved. It's up to each data view section to decide what item sizes mean, but they should all adjust their item sizes based on the new user value (from 1 to 100).
 	void setItemSize(int newItemSize);
 
+	/// Only show scans whose name, notes, or sample name contain all the words in \c searchText (as whole words or prefixes), within the current run/experiment and organization.  An empty \c searchText shows everything again.  Does nothing if the database has no search index (see AMDbSearchIndex).
+	void setSearchText(const QString& searchText);
+
 
 
 
@@ -201,6 +207,11 @@ protected slots:
 	/// Builds a popup menu for switching view modes.
 	void onCustomContextMenuRequested(QPoint pos);
 
+	/// Called when the user types in the search box. Waits for a pause in typing before searching.
+	void onSearchEditTextChanged();
+	/// Searches for the text in the search box, using setSearchText().
+	void applySearchEditText();
+
 
 
 	/// Connected to the database's created() and removed() signals, to catch when scans are added or removed.
@@ -224,6 +235,12 @@ protected:
 
 	/// The database explored with this view
 	AMDatabase* db_;
+	/// The full-text search index on the scans table, or 0 if searching isn't available.
+	AMDbSearchIndex* searchIndex_;
+	/// The current search text (empty when not searching)
+	QString searchText_;
+	/// The SQL condition for the current search text, prepared at the start of refreshView().
+	QString searchWhereClause_;
 	/// the user's name, with appropriate possesive ending to be tacked onto "Data".  (ie: John Doe's )
 	QString userName_;
 	/// Caches the name of the scans table in the database
@@ -254,6 +271,8 @@ protected:
 	// UI components:
 	///////////////////
 	QButtonGroup* viewModeButtonGroup_;
+	/// The search box (only created if searchIndex_ is valid)
+	QLineEdit* searchEdit_;
 
 	// QGraphicsView UI components:
 	///////////////////
@@ -269,6 +288,8 @@ protected:
 	/////////////////////////
 	AMDeferredFunctionCall afterDbChangedFnCall_;
 	bool viewRequiresRefresh_;
+	/// Used to wait until the user pauses typing before searching.
+	AMDeferredFunctionCall searchFnCall_;
 
 
 	// Helper Functions
@@ -280,6 +301,8 @@ protected:
 	void refreshOrganizeModeBox();
 	/// This helper function retrieves the user's name from the database and forms the possesive form of it, storing in userName_;
 	void retrieveUserName();
+	/// Combines a section's \c whereClause with searchWhereClause_, if a search is active.
+	QString sectionWhereClause(const QString& whereClause) const;
 
 	/// The amount of room that views should assume to have available
 	double effectiveWidth() const { return this->width() - 20; }
@@ -27,6 +27,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QHashIterator>
 #include <QFormLayout>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QGroupBox>
 #include <QLabel>
 #include <QPushButton>
@@ -95,6 +96,9 @@ AMExportWizardChooseExporterPage::AMExportWizardChooseExporterPage(QWidget *pare
 	exporterComboBox_ = new QComboBox();
 	destinationFolder_ = new AMFolderPathLineEdit();
 	browseButton_ = new QPushButton("Browse...");
+	parallelExportCheckBox_ = new QCheckBox("Export several scans at once");
+	parallelExportCheckBox_->setChecked(true);
+	parallelExportCheckBox_->setToolTip("Writes the files for several scans at the same time, on separate threads.  The files written are the same either way.");
 
 	populateExporterComboBox();
 	connect(exporterComboBox_, SIGNAL(currentIndexChanged(int)), this, SLOT(onExporterComboBoxIndexChanged(int)));
@@ -111,6 +115,7 @@ AMExportWizardChooseExporterPage::AMExportWizardChooseExporterPage(QWidget *pare
 
 	fl->addRow("Export location", hl);
 	fl->addRow("Export as", exporterComboBox_);
+	fl->addRow("", parallelExportCheckBox_);
 
 	groupBox_ = new QGroupBox();
 	descriptionLabel_ = new QLabel();
@@ -149,6 +154,7 @@ bool AMExportWizardChooseExporterPage::validatePage()
 	AMExportController* c = qobject_cast<AMExportWizard*>(wizard())->controller();
 
 	c->setDestinationFolderPath(destinationFolder_->text());
+	c->setParallelExportEnabled(parallelExportCheckBox_->isChecked());
 	QString exporterClassName = exporterComboBox_->itemData(exporterComboBox_->currentIndex(), AM::UserRole).toString();
 	return c->chooseExporter(exporterClassName);
 }
@@ -170,10 +176,13 @@ void AMExportWizardChooseExporterPage::populateExporterComboBox()
 
 void AMExportWizardChooseExporterPage::initializePage()
 {
-	if(destinationFolder_->text().isEmpty()) {
-		AMExportController* c = qobject_cast<AMExportWizard*>(wizard())->controller();
+	AMExportController* c = qobject_cast<AMExportWizard*>(wizard())->controller();
+
+	if(destinationFolder_->text().isEmpty())
 		destinationFolder_->setText(c->destinationFolderPath());
-	}
+
+	// There's nothing to do in parallel with a single scan.
+	parallelExportCheckBox_->setVisible(c->scanCount() > 1);
 }
 
 void AMExportWizardChooseExporterPage::onBrowseButtonClicked()
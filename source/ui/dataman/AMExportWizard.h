@@ -25,6 +25,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QWizardPage>
 
 class QComboBox;
+class QCheckBox;
 class QGroupBox;
 class QLabel;
 class QProgressBar;
@@ -120,6 +121,8 @@ protected:
 	/// Destination folder entry box
 	AMFolderPathLineEdit* destinationFolder_;
 	QPushButton* browseButton_;
+	/// Check box to write several scans at once (see AMExportController::setParallelExportEnabled())
+	QCheckBox* parallelExportCheckBox_;
 
 	/// Text (long description) of the exporter and its capabilities
 	QGroupBox* groupBox_;
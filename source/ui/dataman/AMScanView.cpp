@@ -21,6 +21,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "AMScanView.h"
 #include <QGraphicsWidget>
 #include "dataman/AMScan.h"
+#include "dataman/AMAnalysisBlock.h"
 #include "dataman/datasource/AMDataSourceSeriesData.h"
 #include "dataman/datasource/AMDataSourceImageData.h"
 #include "MPlot/MPlotImage.h"
@@ -29,6 +30,7 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QScrollBar>
 #include "ui/dataman/AMColoredTextToolButton.h"
 #include "util/AMErrorMonitor.h"
+#include "analysis/AMThreadedAnalysisBlock.h"
 
 #include <QAction>
 #include <QGroupBox>
@@ -243,6 +245,52 @@ AMScanView::AMScanView(AMScanSetModel* model, QWidget *parent) :
 AMScanView::~AMScanView() {
 	for(int i=0; i<views_.count(); i++)
 		delete views_.at(i);
+
+	// The plot items using their outputs are gone now.
+	qDeleteAll(threadedBlocks_);
+}
+
+const AMDataSource* AMScanView::plottedDataSource(const AMDataSource *dataSource)
+{
+	AMThreadedAnalysisBlock* threadedBlock = threadedBlocks_.value(dataSource);
+	if(threadedBlock)
+		return threadedBlock->output();
+
+	const AMAnalysisBlock* block = dynamic_cast<const AMAnalysisBlock*>(dataSource);
+	if(!block)
+		return dataSource;
+
+	threadedBlock = AMThreadedAnalysisBlock::createForCopyOf(const_cast<AMAnalysisBlock*>(block));
+	if(!threadedBlock)
+		return dataSource;
+
+	threadedBlocks_.insert(dataSource, threadedBlock);
+	connect(block->signalSource(), SIGNAL(deleted(void*)), this, SLOT(onThreadedBlockOriginalDeleted(void*)));
+
+	return threadedBlock->output();
+}
+
+void AMScanView::onThreadedBlockOriginalDeleted(void *deletedSource)
+{
+	AMThreadedAnalysisBlock* threadedBlock = threadedBlocks_.take((const AMDataSource*)deletedSource);
+	if(threadedBlock)
+		threadedBlock->deleteLater();
+}
+
+void AMScanView::onRowAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+	// Data sources removed from a scan are handled in onThreadedBlockOriginalDeleted().
+	if(parent.isValid())
+		return;
+
+	for(int si = start; si <= end; si++) {
+
+		AMScan* scan = scansModel_->scanAt(si);
+
+		foreach(const AMDataSource* original, threadedBlocks_.keys())
+			if(scan->indexOfDataSource(original) != -1)
+				threadedBlocks_.take(original)->deleteLater();
+	}
 }
 
 void AMScanView::setupUI() {
@@ -366,6 +414,7 @@ void AMScanView::makeConnections() {
 
 	connect(scansModel_, SIGNAL(scanAdded(AMScan*)), this, SLOT(onScanAdded(AMScan*)));
 	connect(scansModel_, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(onRowInserted(QModelIndex,int,int)));
+	connect(scansModel_, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(onRowAboutToBeRemoved(QModelIndex,int,int)));
 
 	// connect enabling/disabling normalization and waterfall to each view
 	for(int i=0; i<views_.count(); i++) {
@@ -591,6 +640,8 @@ MPlotItem* AMScanViewInternal::createPlotItemForDataSource(const AMDataSource* d
 		return 0;
 	}
 
+	dataSource = masterView_->plottedDataSource(dataSource);
+
 	switch(dataSource->rank()) {	// depending on the rank, we'll need an XY-series or an image to display it. 3D and 4D, etc. we don't handle for now.
 
 	case 1: {
@@ -899,7 +950,7 @@ void AMScanViewExclusiveView::reviewScan(int scanIndex) {
 			case 1: {
 				MPlotAbstractSeries* series = static_cast<MPlotAbstractSeries*>(plotItems_.at(scanIndex));
 				if(plotItemDataSources_.at(scanIndex) != dataSource) {
-					series->setModel(new AMDataSourceSeriesData(dataSource), true);
+					series->setModel(new AMDataSourceSeriesData(masterView_->plottedDataSource(dataSource)), true);
 					plotItemDataSources_[scanIndex] = dataSource;
 				}
 				QPen pen = model()->plotPen(scanIndex, dataSourceIndex);
@@ -908,7 +959,7 @@ void AMScanViewExclusiveView::reviewScan(int scanIndex) {
 			case 2: {
 				MPlotAbstractImage* image = static_cast<MPlotAbstractImage*>(plotItems_.at(scanIndex));
 				if(plotItemDataSources_.at(scanIndex) != dataSource) {
-					AMDataSourceImageData* newData = new AMDataSourceImageData(dataSource);
+					AMDataSourceImageData* newData = new AMDataSourceImageData(masterView_->plottedDataSource(dataSource));
 					image->setModel(newData, true);
 					plotItemDataSources_[scanIndex] = dataSource;
 				}
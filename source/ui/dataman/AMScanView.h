@@ -72,6 +72,7 @@ signals:
 };
 
 class AMScanView;
+class AMThreadedAnalysisBlock;
 
 /// This class is the interface for different view options inside an AMScanView.  They must be able to handle changes from the AMScanSet model (scans or data sources added or removed).
 class AMScanViewInternal : public QGraphicsWidget {
@@ -154,6 +155,9 @@ public:
 	/// Sets the single spectrum view data source using the name given by \param name.
 	void setSingleSpectrumDataSource(const QString &name);
 
+	/// Returns the source that plots should show for \c dataSource.  For analysis blocks that are expensive to calculate (see AMAnalysisBlock::createThreadedCopy()), this is the output of a copy running on the analysis thread, which is shared by all of the internal views.  For everything else, it's \c dataSource.
+	const AMDataSource* plottedDataSource(const AMDataSource* dataSource);
+
 signals:
 	/// Notifier that the data position tool has changed locations.  Passes the location of the mouse.
 	void dataPositionChanged(const QPoint &);
@@ -185,6 +189,10 @@ protected slots:
 	void onDataPositionChanged(const QPointF &point);
 	/// Slots that handles the visibility of the spectrum view based on the information from the scan bar.
 	void setSpectrumViewVisibility(bool visible);
+	/// Stops the threaded copies of analysis blocks that belong to scans being removed from the view.
+	void onRowAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+	/// Stops the threaded copy of an analysis block that is being deleted.
+	void onThreadedBlockOriginalDeleted(void* deletedSource);
 
 protected:
 	/// Reimplements the show event to hide the multi view.
@@ -218,6 +226,9 @@ protected:
 	/// Flag used to determine whether the single spectrum view should be visible.
 	bool spectrumViewIsVisible_;
 
+	/// The threaded copies of expensive analysis blocks being plotted, keyed by the original block.  See plottedDataSource().
+	QHash<const AMDataSource*, AMThreadedAnalysisBlock*> threadedBlocks_;
+
 	/// internal helper function to build the UI
 	void setupUI();
 	/// internal helper function to setup all UI event-handling connections
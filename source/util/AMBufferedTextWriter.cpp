@@ -0,0 +1,180 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMBufferedTextWriter.h"
+
+#include <QIODevice>
+#include <qnumeric.h>
+
+#include <stdio.h>
+#include <string.h>
+
+AMBufferedTextWriter::AMBufferedTextWriter(QIODevice *device, int bufferSize)
+{
+	device_ = device;
+	buffer_.resize(qMax(bufferSize, 64));
+	used_ = 0;
+	hasError_ = false;
+}
+
+AMBufferedTextWriter::~AMBufferedTextWriter()
+{
+	flush();
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(const QString &text)
+{
+	QByteArray encoded = text.toLocal8Bit();
+	write(encoded.constData(), encoded.size());
+	return *this;
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(const QByteArray &text)
+{
+	write(text.constData(), text.size());
+	return *this;
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(const char *text)
+{
+	write(text, int(strlen(text)));
+	return *this;
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(char character)
+{
+	if(used_ == buffer_.size())
+		flush();
+
+	buffer_.data()[used_++] = character;
+	return *this;
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(int value)
+{
+	if(used_ + 12 > buffer_.size())
+		flush();
+
+	used_ += formatInteger(value, buffer_.data() + used_);
+	return *this;
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(double value)
+{
+	if(used_ + 32 > buffer_.size())
+		flush();
+
+	used_ += formatDouble(value, buffer_.data() + used_);
+	return *this;
+}
+
+AMBufferedTextWriter& AMBufferedTextWriter::operator<<(const AMNumber &value)
+{
+	if(!value.isValid())
+		return *this << "[X]";
+
+	if(value.type() == AMNumber::Integer)
+		return *this << int(value);
+
+	return *this << double(value);
+}
+
+void AMBufferedTextWriter::write(const char *data, int length)
+{
+	if(used_ + length > buffer_.size()){
+
+		flush();
+
+		// Too big to ever fit: skip the buffer.
+		if(length > buffer_.size()){
+
+			if(device_->write(data, length) != length)
+				hasError_ = true;
+
+			return;
+		}
+	}
+
+	memcpy(buffer_.data() + used_, data, length);
+	used_ += length;
+}
+
+bool AMBufferedTextWriter::flush()
+{
+	if(used_ > 0){
+
+		if(device_->write(buffer_.constData(), used_) != used_)
+			hasError_ = true;
+
+		used_ = 0;
+	}
+
+	return !hasError_;
+}
+
+int AMBufferedTextWriter::formatDouble(double value, char *output)
+{
+	// Qt never prints a sign on NaN; glibc can.
+	if(qIsNaN(value)){
+
+		memcpy(output, "nan", 4);
+		return 3;
+	}
+
+	// QString::number(double) is 'g' format with 6 significant digits, which is what printf's %g gives us. The only difference is that printf follows the C locale's decimal point, and Qt always uses '.'.
+	int length = qsnprintf(output, 32, "%g", value);
+
+	if(length < 0 || length >= 32){
+
+		output[0] = '0';
+		output[1] = '\0';
+		return 1;
+	}
+
+	for(int i = 0; i < length; i++)
+		if(output[i] == ',')
+			output[i] = '.';
+
+	return length;
+}
+
+int AMBufferedTextWriter::formatInteger(int value, char *output)
+{
+	char reversed[12];
+	int count = 0;
+	// Work with negative numbers so that the most negative int doesn't overflow.
+	bool negative = value < 0;
+	int remaining = negative ? value : -value;
+
+	do {
+		reversed[count++] = char('0' - (remaining % 10));
+		remaining /= 10;
+	} while(remaining != 0);
+
+	int length = 0;
+
+	if(negative)
+		output[length++] = '-';
+
+	while(count > 0)
+		output[length++] = reversed[--count];
+
+	return length;
+}
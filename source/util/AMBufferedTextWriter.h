@@ -0,0 +1,95 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMBUFFEREDTEXTWRITER_H
+#define AMBUFFEREDTEXTWRITER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "dataman/AMNumber.h"
+
+class QIODevice;
+
+/// This class is a fast replacement for QTextStream when writing large text files made mostly of numbers (ex: exporting scans).
+/*! QTextStream converts everything through QString and a text codec, and QString::number() / AMNumber::toString() allocate a new string for every value.  For a 2D map with a spectrum at every pixel, that adds up to hundreds of millions of allocations.
+
+AMBufferedTextWriter formats numbers directly into a large reusable buffer, and only writes to the device when the buffer is full (or when flush() is called, or the writer is destroyed).  Numbers are formatted exactly the way QString::number() and QTextStream do by default (6 significant digits, 'g' notation, '.' as the decimal point), so the output is the same as before.
+
+Only one writer (or QTextStream) should write to a device at a time: make sure the previous one has been destroyed or flushed before creating the next.
+
+\code
+AMBufferedTextWriter out(&file);
+QByteArray delimiter = option->columnDelimiter().toLocal8Bit();
+for(int i = 0; i < count; i++)
+	out << values[i] << delimiter;
+\endcode
+*/
+class AMBufferedTextWriter
+{
+public:
+	/// Constructor. Text will be written to \c device, which must already be open, in blocks of up to \c bufferSize bytes.
+	AMBufferedTextWriter(QIODevice *device, int bufferSize = 4*1024*1024);
+	/// Destructor. Flushes anything still in the buffer.
+	~AMBufferedTextWriter();
+
+	/// Writes a string, converted to the local 8-bit encoding (the same encoding QTextStream uses by default).
+	AMBufferedTextWriter& operator<<(const QString &text);
+	/// Writes already-encoded text.  Use this for delimiters that are written many times.
+	AMBufferedTextWriter& operator<<(const QByteArray &text);
+	/// Writes a null-terminated string.
+	AMBufferedTextWriter& operator<<(const char *text);
+	/// Writes a single character.
+	AMBufferedTextWriter& operator<<(char character);
+	/// Writes an integer.
+	AMBufferedTextWriter& operator<<(int value);
+	/// Writes a double, formatted like QString::number(value).
+	AMBufferedTextWriter& operator<<(double value);
+	/// Writes an AMNumber, formatted like AMNumber::toString() ("[X]" for invalid numbers).
+	AMBufferedTextWriter& operator<<(const AMNumber &value);
+
+	/// Writes \c length bytes from \c data.
+	void write(const char *data, int length);
+
+	/// Writes everything in the buffer to the device.  Returns false if the device reported an error (at any point so far).
+	bool flush();
+	/// Returns true if the device reported an error while writing.
+	bool hasError() const { return hasError_; }
+
+	/// Formats \c value like QString::number(value) into \c output, which must hold at least 32 characters.  Returns the number of characters written (not including a terminating null).
+	static int formatDouble(double value, char *output);
+	/// Formats \c value into \c output, which must hold at least 12 characters. Returns the number of characters written.
+	static int formatInteger(int value, char *output);
+
+protected:
+	/// The device we write to.
+	QIODevice *device_;
+	/// The buffer.  It is allocated once, at its full size.
+	QByteArray buffer_;
+	/// The number of bytes of buffer_ in use.
+	int used_;
+	/// Whether a write has failed.
+	bool hasError_;
+
+private:
+	Q_DISABLE_COPY(AMBufferedTextWriter)
+};
+
+#endif // AMBUFFEREDTEXTWRITER_H
@@ -67,8 +67,13 @@ public:
 	/// Globally-accessible function to get the "next" data source color to use.
 	static QColor nextColor() {
 		static int i = 0;
+		return colorAt(i++);
+	}
+
+	/// Returns the data source color number \c index from the same sequence as nextColor().  Unlike nextColor(), this has no shared state, so it can be used from any thread.
+	static QColor colorAt(int index) {
 
-		switch(i++ % 11) {
+		switch(qAbs(index) % 11) {
 		case 0: return QColor(255, 0, 128);
 		case 1: return QColor(0, 128, 255);
 		case 2: return QColor(128, 255, 0);
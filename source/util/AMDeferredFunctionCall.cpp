@@ -30,6 +30,8 @@ AMDeferredFunctionCall::AMDeferredFunctionCall(QObject *parent) :
 	if(eventType_ == 0)
 		eventType_ = (QEvent::Type)QEvent::registerEventType();
 
+	// Parented so that the timer follows us if we're moved to another thread.
+	delayTimer_.setParent(this);
 	connect(&delayTimer_, SIGNAL(timeout()), this, SLOT(onDelayTimerTimeout()));
 }
 
@@ -21,24 +21,40 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include "AMErrorMonitor.h"
 
 #include <QMutableMapIterator>
+#include <QMutableHashIterator>
 #include <QDebug>
 #include <QMutexLocker>
 #include <QReadLocker>
 #include <QWriteLocker>
 #include <QThread>
 #include <QApplication>
+#include <QDateTime>
+#include <QTimer>
 
 AMErrorMon* AMErrorMon::instance_ = 0;
 QMutex AMErrorMon::instanceMutex_(QMutex::Recursive);
 
-AMErrorMon::AMErrorMon() : QObject(), subsMutex_(QReadWriteLock::Recursive) {
+AMErrorMon::AMErrorMon() : QObject(), queuedReports_(4096), subsMutex_(QReadWriteLock::Recursive) {
 	qRegisterMetaType<AMErrorReport>("AMErrorReport");
 
 	// don't display debug notifications by default:
 	debugEnabled_ = false;
+	lastErrorCode_ = 0;
 
-	// Set up our signal-based forwarding system to be thread-safe:
-	connect(this, SIGNAL(reportFF(AMErrorReport)), this, SLOT(reportI(AMErrorReport)));
+	processingScheduled_ = 0;
+	droppedReportCount_ = 0;
+
+	maximumRepeats_ = 10;
+	repeatWindow_ = 1000;
+
+	deliveredReportCount_ = 0;
+	suppressedReportCount_ = 0;
+	totalDroppedReportCount_ = 0;
+
+	// A child, so that it moves to the main thread along with us.
+	repeatWindowTimer_ = new QTimer(this);
+	repeatWindowTimer_->setSingleShot(true);
+	connect(repeatWindowTimer_, SIGNAL(timeout()), this, SLOT(onRepeatWindowTimeout()));
 }
 
 
@@ -95,22 +111,155 @@ void AMErrorMon::unsubscribeI(QObject* notifyMe, const char* errorSlot) {
 }
 
 
-void AMErrorMon::reportF(AMErrorReport e) {
-	QString className;
-	if(e.source && e.source->metaObject()) {
-		className = e.source->metaObject()->className();
+void AMErrorMon::reportF(const AMErrorReport &e) {
+	// Only copy what we were given here: formatting waits until the report is delivered, in the main thread.
+	AMErrorReportRecord record;
+	record.source = e.source;
+	record.className = (e.source && e.source->metaObject()) ? e.source->metaObject()->className() : 0;
+	record.level = e.level;
+	record.errorCode = e.errorCode;
+	record.description = e.description;
 
-		e.description.prepend(QString("in [%1]: ").arg(className));
-	}
+	bool inMainThread = (QThread::currentThread() == this->thread());
 
 	// If this is being called from out-of-thread, we need to unset the source object so it isn't looked at in another thread. This means subscriptions (currently unused) only work within the main thread.
-	if(QThread::currentThread() != this->thread()) {
-		e.description.append(" [Message received from out of main thread.]");
-		e.source = 0;
+	if(!inMainThread) {
+		record.fromOtherThread = true;
+		record.source = 0;
 	}
 
 	lastErrorCode_ = e.errorCode;
-	emit reportFF(e);
+
+	if(!queuedReports_.push(record))
+		droppedReportCount_.fetchAndAddRelaxed(1);
+
+	if(inMainThread)
+		processQueuedReports();
+
+	// One queued call handles everything that arrives before it runs.
+	else if(processingScheduled_.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, "processQueuedReports", Qt::QueuedConnection);
+}
+
+void AMErrorMon::processQueuedReports() {
+	// Clear this first: anything queued from now on needs another call, unless we get to it in the loop below.
+	processingScheduled_.fetchAndStoreOrdered(0);
+
+	AMErrorReportRecord record;
+	while(queuedReports_.pop(record))
+		processRecord(record);
+
+	int dropped = droppedReportCount_.fetchAndStoreOrdered(0);
+
+	if(dropped > 0) {
+		totalDroppedReportCount_ += dropped;
+		deliver(QList<AMErrorReport>() << AMErrorReport(0, AMErrorReport::Alert, AMERRORMON_REPORTS_DROPPED, QString("%1 reports were dropped, because they were reported faster than they could be handled.").arg(dropped)));
+	}
+}
+
+AMErrorReport AMErrorMon::reportFromRecord(const AMErrorReportRecord &record) const {
+	AMErrorReport e(record.source, record.level, record.errorCode, record.description);
+
+	if(record.className)
+		e.description.prepend(QString("in [%1]: ").arg(record.className));
+
+	if(record.fromOtherThread)
+		e.description.append(" [Message received from out of main thread.]");
+
+	return e;
+}
+
+void AMErrorMon::processRecord(const AMErrorReportRecord &record) {
+	if(maximumRepeats_ <= 0 || record.level == AMErrorReport::Information) {
+		deliver(QList<AMErrorReport>() << reportFromRecord(record));
+		return;
+	}
+
+	QList<AMErrorReport> reports;
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	QPair<quintptr, int> key(record.className ? quintptr(record.className) : quintptr(record.source), record.errorCode);
+	RepeatCount &repeatCount = repeatCounts_[key];
+
+	if(now - repeatCount.windowStart >= repeatWindow_) {
+
+		if(repeatCount.suppressed > 0)
+			reports << takeSuppressedSummary(repeatCount);
+
+		repeatCount.windowStart = now;
+		repeatCount.count = 0;
+	}
+
+	if(++repeatCount.count > maximumRepeats_) {
+
+		repeatCount.suppressed++;
+		repeatCount.lastSuppressed = record;
+		suppressedReportCount_++;
+
+		if(!repeatWindowTimer_->isActive())
+			repeatWindowTimer_->start(repeatWindow_);
+	}
+
+	else
+		reports << reportFromRecord(record);
+
+	deliver(reports);
+}
+
+AMErrorReport AMErrorMon::takeSuppressedSummary(RepeatCount &repeatCount) {
+	AMErrorReportRecord summary = repeatCount.lastSuppressed;
+	summary.description = QString("%1 more like this in the last %2 ms. The last one was: %3").arg(repeatCount.suppressed).arg(repeatWindow_).arg(summary.description);
+	AMErrorReport e = reportFromRecord(summary);
+
+	repeatCount.suppressed = 0;
+	repeatCount.lastSuppressed = AMErrorReportRecord();
+
+	return e;
+}
+
+void AMErrorMon::deliver(const QList<AMErrorReport> &reports) {
+	foreach(const AMErrorReport &e, reports) {
+		deliveredReportCount_++;
+		reportI(e);
+	}
+}
+
+void AMErrorMon::onRepeatWindowTimeout() {
+	QList<AMErrorReport> reports;
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	bool stillSuppressing = false;
+
+	QMutableHashIterator<QPair<quintptr, int>, RepeatCount> i(repeatCounts_);
+	while(i.hasNext()) {
+		i.next();
+
+		if(now - i.value().windowStart < repeatWindow_) {
+			stillSuppressing |= (i.value().suppressed > 0);
+			continue;
+		}
+
+		if(i.value().suppressed > 0)
+			reports << takeSuppressedSummary(i.value());
+
+		// Nothing recent: no need to remember it.
+		i.remove();
+	}
+
+	if(stillSuppressing)
+		repeatWindowTimer_->start(repeatWindow_);
+
+	deliver(reports);
+}
+
+void AMErrorMon::setRepeatLimit(int maximumRepeats, int windowMs) {
+	AMErrorMon *monitor = mon();
+	monitor->maximumRepeats_ = qMax(0, maximumRepeats);
+	monitor->repeatWindow_ = qMax(1, windowMs);
+}
+
+void AMErrorMon::resetReportCounts() {
+	deliveredReportCount_ = 0;
+	suppressedReportCount_ = 0;
+	totalDroppedReportCount_ = 0;
 }
 
 // Handle error reports.
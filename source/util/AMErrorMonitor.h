@@ -27,6 +27,14 @@ along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMetaType>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QHash>
+#include <QAtomicInt>
+
+#include "util/AMLockFreeRing.h"
+
+class QTimer;
+
+#define AMERRORMON_REPORTS_DROPPED 290801
 
 /// This class encapsulates an error message (who it's from, the level or "severity", an error code defined by the originator, and a description)
 /*! Error levels are defined as:
@@ -52,6 +60,23 @@ public:
 
 Q_DECLARE_METATYPE(AMErrorReport)
 
+/// This class holds a report exactly as it was passed to AMErrorMon, before any formatting.  AMErrorMon queues these, and only turns them into AMErrorReports when they are delivered.
+class AMErrorReportRecord {
+
+public:
+	AMErrorReportRecord() : source(0), className(0), level(AMErrorReport::Alert), errorCode(0), fromOtherThread(false) {}
+
+	/// The originating object.  This is 0 for reports from outside the main thread.
+	const QObject* source;
+	/// The class name of the originating object, straight from its meta-object (which is never deleted), or 0 if there was no source.
+	const char* className;
+	AMErrorReport::Level level;
+	int errorCode;
+	QString description;
+	/// True if the report came from a thread other than the main thread.
+	bool fromOtherThread;
+};
+
 
 /// This class provides a system-wide error and notification manager.  Other classes can report errors from anywhere using AMErrorMon::report(AMErrorReport()).
 /*! By centralizing all error reporting in one place, it makes it possible for any object to subscribe to receive notification of errors created anywhere in the program.  You can request to receive errors from a specific object instance, class, or error code.
@@ -103,6 +128,12 @@ will remove any subscriptions that would have called the \c handleError42sSlot(A
 AMErrorMon::unsubscribe(myObject);
 \endcode
 
+<b>Queueing and repeat limiting</b>
+
+Reports are not formatted or delivered by the thread that reports them.  Instead, report() puts a raw AMErrorReportRecord into a fixed-size lock-free ring (AMLockFreeRing) and returns.  The main thread takes them out in batches, adds the class name and thread information to the description, prints them and emits the signals.  Reports made from the main thread are delivered right away, as before; reports from other threads cost one queued event per batch instead of one per report.  If the ring is full, reports are dropped, and a single AMERRORMON_REPORTS_DROPPED alert says how many.
+
+To keep a storm of identical reports (ex: a PV disconnecting and reconnecting, or a failing detector) from swamping the GUI, delivery is limited per source class and error code: after maximumRepeats() reports within repeatWindow() ms, the rest are counted but not delivered, and when the window ends a single "N more" report with the same level and code sums them up.  Information reports are never limited, since they're used for progress messages.  Use setRepeatLimit() to change the limits, or set \c maximumRepeats to 0 to turn limiting off.
+
 \todo What happens if an object is deleted after subscribing?
 \note All of the functions in this class are thread-safe, and can be called from any thread.  Notifications will also be delivered to any thread, using Qt's queued slot-calling mechanism when the subscribing object is in a different thread than the ErrorMon. (This is why slots must be used, instead of callback functions.)
 
@@ -200,6 +231,26 @@ public:
 
 	static int lastErrorCode() { return mon()->lastErrorCode_;}
 
+	/// Sets the repeat limit: only \c maximumRepeats reports with the same source class and error code are delivered in every \c windowMs ms; the rest are summed up in one report when the window ends.  A \c maximumRepeats of 0 turns the limit off.
+	static void setRepeatLimit(int maximumRepeats, int windowMs);
+	/// The number of reports delivered for each source class and error code within repeatWindow().
+	static int maximumRepeats() { return mon()->maximumRepeats_; }
+	/// The length of the window for maximumRepeats(), in ms.
+	static int repeatWindow() { return mon()->repeatWindow_; }
+
+	/// The number of reports delivered so far (including summaries).
+	int deliveredReportCount() const { return deliveredReportCount_; }
+	/// The number of reports held back by the repeat limit so far.
+	int suppressedReportCount() const { return suppressedReportCount_; }
+	/// The number of reports dropped so far because the queue was full.
+	int droppedReportCount() const { return totalDroppedReportCount_; }
+	/// Resets the delivered, suppressed and dropped counts.
+	void resetReportCounts();
+
+public slots:
+	/// Delivers all the reports that are waiting in the queue.  This is called automatically (in the main thread) whenever reports arrive from other threads.  Must be called from the main thread.
+	void processQueuedReports();
+
 signals:
 	/// emitted for all errors
 	void error(const AMErrorReport& e);
@@ -213,17 +264,9 @@ signals:
 	void debug(const AMErrorReport& e);
 
 
-	// internal signals:
-	/////////////////////////
-	/// Internally forwards an error report to make sure we handle it in the main thread.
-	void reportFF(AMErrorReport e);
-
-public slots:
-
-
 protected:
-	/// Forward any out-of-thread requests to the main thread, via signals.
-	void reportF(AMErrorReport e);
+	/// Queues the report, and delivers it right away if this is the main thread.  Otherwise makes sure the main thread will process the queue.
+	void reportF(const AMErrorReport &e);
 
 	/// Subscribe to all errors from object 'originator'
 	void subscribeToObjectI(const QObject* originator, QObject* notifyMe, const char* errorSlot);
@@ -245,9 +288,33 @@ protected:
 	QMap<int, QPair<QObject*, QString> > codeSubs_;
 
 
+	/// Builds the AMErrorReport for a queued \c record, formatting its description.
+	AMErrorReport reportFromRecord(const AMErrorReportRecord &record) const;
+	/// Applies the repeat limit to \c record, and delivers it if it is within the limit.
+	void processRecord(const AMErrorReportRecord &record);
+
+	/// The count of reports from one source class with one error code, within the current window.
+	class RepeatCount {
+	public:
+		RepeatCount() : windowStart(0), count(0), suppressed(0) {}
+		qint64 windowStart;
+		int count;
+		int suppressed;
+		/// The last report that was held back
+		AMErrorReportRecord lastSuppressed;
+	};
+	/// Repeat counts by (class name or source, error code)
+	QHash<QPair<quintptr, int>, RepeatCount> repeatCounts_;
+	/// Builds the "N more" summary of the reports held back by \c repeatCount, and resets it.
+	AMErrorReport takeSuppressedSummary(RepeatCount &repeatCount);
+	/// Delivers \c reports.  Used to deliver only after we're done with repeatCounts_, since delivering can report more errors.
+	void deliver(const QList<AMErrorReport> &reports);
+
 protected slots:
 	/// Handle an error report in the main thread:
 	void reportI(AMErrorReport e);
+	/// Called when the repeat window ends, to report the summaries and forget old counts.
+	void onRepeatWindowTimeout();
 
 private:
 	/// Singleton class.  Private Constructor:
@@ -261,6 +328,22 @@ private:
 
 	int lastErrorCode_;
 
+	/// Reports waiting for the main thread
+	AMLockFreeRing<AMErrorReportRecord> queuedReports_;
+	/// Set while a call to processQueuedReports() is queued, so that only one is queued at a time.
+	QAtomicInt processingScheduled_;
+	/// The number of reports dropped since the last processQueuedReports()
+	QAtomicInt droppedReportCount_;
+
+	int maximumRepeats_;
+	int repeatWindow_;
+	/// Runs while there are reports being held back, to deliver the summaries.
+	QTimer *repeatWindowTimer_;
+
+	int deliveredReportCount_;
+	int suppressedReportCount_;
+	int totalDroppedReportCount_;
+
 	/// This mutex is used to ensure thread-safe access to the instance_ variable.
 	static QMutex instanceMutex_;
 	/// This mutex is used to ensure thread-safe access to the subscription registry.
@@ -0,0 +1,128 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMLOCKFREERING_H
+#define AMLOCKFREERING_H
+
+#include <QAtomicInt>
+
+/// This container class is a fixed-size queue that any number of threads can push() into at the same time, without locking, while one thread pop()s items off the other end.
+/*! It's meant for hand-offs from busy threads that must never block, such as error reports from PV callbacks (see AMErrorMon).  The capacity is fixed when it's created; when the ring is full, push() fails right away instead of waiting, and it's up to the caller to count what was dropped.
+
+<b>How it works</b>
+
+This is the bounded queue described by Dmitry Vyukov.  Every slot has a sequence number that says whose turn it is: a slot is free for the producer claiming position \c pos when its sequence is \c pos, and ready for the consumer at position \c pos when its sequence is \c pos+1.  Producers claim positions by compare-and-swap on the shared write position, so they never wait on each other except to retry a failed swap, and the consumer hands each slot back by setting its sequence one lap ahead.
+
+<b>Restrictions</b>
+
+- Only one thread may call pop() at a time.
+- \c T must be default-constructible and assignable.  Implicitly shared Qt types (ex: QString) are fine: their reference counts are atomic.
+- The capacity is rounded up to a power of two.
+*/
+template <class T>
+class AMLockFreeRing
+{
+public:
+	/// Creates a ring that can hold at least \c minimumCapacity items.
+	explicit AMLockFreeRing(int minimumCapacity = 1024) {
+		int capacity = 2;
+		while(capacity < minimumCapacity)
+			capacity *= 2;
+
+		mask_ = capacity-1;
+		slots_ = new Slot[capacity];
+		for(int i = 0; i < capacity; i++)
+			slots_[i].sequence = i;
+
+		enqueuePosition_ = 0;
+		dequeuePosition_ = 0;
+	}
+
+	/// Destructor.  Any items still in the ring are deleted with it.
+	~AMLockFreeRing() {
+		delete [] slots_;
+	}
+
+	/// The number of items the ring can hold
+	int capacity() const { return mask_+1; }
+
+	/// Adds a copy of \c item to the ring. Returns false (and does nothing) if the ring is full.  Can be called from any thread.
+	bool push(const T& item) {
+		Slot *slot;
+		int position = enqueuePosition_;
+
+		forever {
+			slot = &slots_[position & mask_];
+			int difference = int(unsigned(slot->sequence.fetchAndAddAcquire(0)) - unsigned(position));
+
+			// The slot is free for this position: try to claim it.
+			if(difference == 0) {
+				if(enqueuePosition_.testAndSetRelaxed(position, position+1))
+					break;
+			}
+			// The consumer hasn't freed this slot since the last lap: we're full.
+			else if(difference < 0)
+				return false;
+
+			// Someone else claimed it first; try again at the new position.
+			position = enqueuePosition_;
+		}
+
+		slot->item = item;
+		slot->sequence.fetchAndStoreRelease(position+1);
+		return true;
+	}
+
+	/// Takes the oldest item out of the ring and copies it into \c item.  Returns false if the ring is empty.  Only one thread may pop() at a time.
+	bool pop(T& item) {
+		Slot *slot = &slots_[dequeuePosition_ & mask_];
+		int difference = int(unsigned(slot->sequence.fetchAndAddAcquire(0)) - unsigned(dequeuePosition_+1));
+
+		// Not written yet (or still being written).
+		if(difference < 0)
+			return false;
+
+		item = slot->item;
+		// Don't keep a reference to the item's data until the slot is re-used.
+		slot->item = T();
+		slot->sequence.fetchAndStoreRelease(dequeuePosition_+mask_+1);
+		dequeuePosition_++;
+		return true;
+	}
+
+private:
+	Q_DISABLE_COPY(AMLockFreeRing)
+
+	/// One entry in the ring, and the sequence number saying whose turn it is.
+	struct Slot {
+		QAtomicInt sequence;
+		T item;
+	};
+
+	/// The slots, in a power-of-two sized array
+	Slot *slots_;
+	/// capacity()-1, used to turn positions into slot indexes
+	int mask_;
+	/// The next position producers will claim
+	QAtomicInt enqueuePosition_;
+	/// The next position to pop.  Only touched by the consumer.
+	int dequeuePosition_;
+};
+
+#endif // AMLOCKFREERING_H
@@ -0,0 +1,202 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AMSlidingWindow.h"
+
+#include <math.h>
+
+namespace AMSlidingWindow
+{
+
+void runningMean(const double *input, int count, int halfWidth, double *output)
+{
+	if(count <= 0)
+		return;
+
+	halfWidth = qMax(0, halfWidth);
+
+	// prefixSums[i] is the sum of the first i values.
+	QVector<double> prefixSums(count+1);
+	prefixSums[0] = 0;
+
+	for(int i = 0; i < count; i++)
+		prefixSums[i+1] = prefixSums.at(i) + input[i];
+
+	for(int i = 0; i < count; i++){
+
+		int first = qMax(0, i-halfWidth);
+		int last = qMin(count-1, i+halfWidth);
+
+		output[i] = (prefixSums.at(last+1) - prefixSums.at(first))/double(last-first+1);
+	}
+}
+
+/// Shared implementation of runningMinimum() and runningMaximum().  \c keepsFront(a, b) is true if \c a should stay in front of \c b in the deque.
+template <class Compare>
+static void runningExtreme(const double *input, int count, int halfWidth, double *output, Compare keepsFront)
+{
+	if(count <= 0)
+		return;
+
+	halfWidth = qMax(0, halfWidth);
+
+	// Indexes of candidate extremes, in increasing order.  Their values are in strictly "better" order from front to back, so the front is always the extreme of the window.
+	QVector<int> deque(count);
+	int front = 0;
+	int back = 0;
+	int nextIn = 0;
+
+	for(int i = 0; i < count; i++){
+
+		int last = qMin(count-1, i+halfWidth);
+
+		for(; nextIn <= last; nextIn++){
+
+			while(back > front && !keepsFront(input[deque.at(back-1)], input[nextIn]))
+				back--;
+
+			deque[back++] = nextIn;
+		}
+
+		while(deque.at(front) < i-halfWidth)
+			front++;
+
+		output[i] = input[deque.at(front)];
+	}
+}
+
+static bool isLess(double a, double b) { return a < b; }
+static bool isGreater(double a, double b) { return a > b; }
+
+void runningMinimum(const double *input, int count, int halfWidth, double *output)
+{
+	runningExtreme(input, count, halfWidth, output, isLess);
+}
+
+void runningMaximum(const double *input, int count, int halfWidth, double *output)
+{
+	runningExtreme(input, count, halfWidth, output, isGreater);
+}
+
+QVector<double> savitzkyGolayCoefficients(int halfWidth, int polynomialOrder)
+{
+	int windowSize = 2*halfWidth+1;
+
+	if(halfWidth < 0 || polynomialOrder < 0 || polynomialOrder >= windowSize)
+		return QVector<double>();
+
+	int terms = polynomialOrder+1;
+
+	// Normal equations of the least-squares fit: (J^T J) a = J^T y, where J(i,k) = (i-halfWidth)^k.  The smoothed value is a(0), so the coefficients are the first row of (J^T J)^-1 J^T.  Solve (J^T J) x = e0 for that row (J^T J is symmetric).
+	QVector<double> matrix(terms*terms, 0);
+
+	for(int i = -halfWidth; i <= halfWidth; i++)
+		for(int row = 0; row < terms; row++)
+			for(int column = 0; column < terms; column++)
+				matrix[row*terms+column] += pow(double(i), row+column);
+
+	QVector<double> solution(terms, 0);
+	solution[0] = 1;
+
+	// Gaussian elimination with partial pivoting.  The matrix is tiny.
+	for(int pivot = 0; pivot < terms; pivot++){
+
+		int best = pivot;
+
+		for(int row = pivot+1; row < terms; row++)
+			if(fabs(matrix.at(row*terms+pivot)) > fabs(matrix.at(best*terms+pivot)))
+				best = row;
+
+		if(matrix.at(best*terms+pivot) == 0)
+			return QVector<double>();
+
+		if(best != pivot){
+
+			for(int column = 0; column < terms; column++)
+				qSwap(matrix[pivot*terms+column], matrix[best*terms+column]);
+
+			qSwap(solution[pivot], solution[best]);
+		}
+
+		for(int row = pivot+1; row < terms; row++){
+
+			double factor = matrix.at(row*terms+pivot)/matrix.at(pivot*terms+pivot);
+
+			for(int column = pivot; column < terms; column++)
+				matrix[row*terms+column] -= factor*matrix.at(pivot*terms+column);
+
+			solution[row] -= factor*solution.at(pivot);
+		}
+	}
+
+	for(int row = terms-1; row >= 0; row--){
+
+		double sum = solution.at(row);
+
+		for(int column = row+1; column < terms; column++)
+			sum -= matrix.at(row*terms+column)*solution.at(column);
+
+		solution[row] = sum/matrix.at(row*terms+row);
+	}
+
+	QVector<double> coefficients(windowSize, 0);
+
+	for(int i = -halfWidth; i <= halfWidth; i++)
+		for(int k = 0; k < terms; k++)
+			coefficients[i+halfWidth] += solution.at(k)*pow(double(i), k);
+
+	return coefficients;
+}
+
+void savitzkyGolay(const double *input, int count, const QVector<double> &coefficients, double *output)
+{
+	int halfWidth = (coefficients.size()-1)/2;
+
+	if(count <= 0)
+		return;
+
+	if(coefficients.isEmpty()){
+
+		for(int i = 0; i < count; i++)
+			output[i] = input[i];
+
+		return;
+	}
+
+	const double *weights = coefficients.constData();
+
+	for(int i = 0; i < count; i++){
+
+		if(i < halfWidth || i >= count-halfWidth){
+
+			output[i] = input[i];
+			continue;
+		}
+
+		const double *window = input + i - halfWidth;
+		double sum = 0;
+
+		for(int j = 0, size = coefficients.size(); j < size; j++)
+			sum += weights[j]*window[j];
+
+		output[i] = sum;
+	}
+}
+
+}
@@ -0,0 +1,46 @@
+/*
+Copyright 2010-2012 Mark Boots, David Chevrier, and Darren Hunter.
+
+This file is part of the Acquaman Data Acquisition and Management framework ("Acquaman").
+Acquaman is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Acquaman is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Acquaman.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef AMSLIDINGWINDOW_H
+#define AMSLIDINGWINDOW_H
+
+#include <QVector>
+
+/// Sliding-window kernels for 1D data, used by the filtering analysis blocks (ex: AM1DRunningAverageFilterAB, SGM1DFastScanFilterAB).
+/*! All of the kernels work on a centered window of \c halfWidth points on either side of each output point (so the window is 2*halfWidth+1 points wide).  Near the ends of the input, the window is truncated to the points that exist.  Each kernel takes O(count) time no matter how wide the window is, except savitzkyGolay(), which is a convolution with precomputed coefficients.
+
+To compute part of a longer array, pass the input from (first - halfWidth) to (last + halfWidth), clipped to the real ends of the data, and keep the outputs you need: the truncation then happens at the same places it would for the whole array.
+*/
+namespace AMSlidingWindow
+{
+	/// Writes the mean of the window around each of the \c count values in \c input to \c output.  Uses prefix sums.  \c input and \c output must not overlap.
+	void runningMean(const double *input, int count, int halfWidth, double *output);
+
+	/// Writes the minimum of the window around each of the \c count values in \c input to \c output.  Uses a monotonic deque.  \c input and \c output must not overlap.
+	void runningMinimum(const double *input, int count, int halfWidth, double *output);
+	/// Writes the maximum of the window around each of the \c count values in \c input to \c output.  Uses a monotonic deque.  \c input and \c output must not overlap.
+	void runningMaximum(const double *input, int count, int halfWidth, double *output);
+
+	/// Returns the 2*halfWidth+1 Savitzky-Golay smoothing coefficients for a least-squares polynomial of order \c polynomialOrder.  Returns an empty vector if the polynomial order is negative or too high for the window (polynomialOrder must be less than 2*halfWidth+1).
+	QVector<double> savitzkyGolayCoefficients(int halfWidth, int polynomialOrder);
+	/// Convolves the \c count values in \c input with \c coefficients (from savitzkyGolayCoefficients()) and writes the result to \c output.  Points within halfWidth of either end, where the full window doesn't fit, are copied from the input unchanged.  \c input and \c output must not overlap.
+	void savitzkyGolay(const double *input, int count, const QVector<double> &coefficients, double *output);
+}
+
+#endif // AMSLIDINGWINDOW_H